@@ -48,10 +48,13 @@ HEADERS += \
     ./src/engine/script/script_write.h \
     ./src/engine/script/script_read.h \
     ./src/engine/script/script.h \
+    ./src/engine/script/script_profiler.h \
+    ./src/modes/map/map_data.h \
     ./src/editor/tileset_editor.h \
     ./src/utils/utils_pch.h \
     ./src/utils/utils_random.h \
     ./src/utils/utils_files.h \
+    ./src/utils/utils_grid.h \
     ./src/utils/utils_numeric.h \
     ./src/utils/utils_strings.h \
 
@@ -64,6 +67,7 @@ SOURCES += \
     ./src/engine/script/script_write.cpp \
     ./src/engine/script/script_read.cpp \
     ./src/engine/script/script.cpp \
+    ./src/modes/map/map_data.cpp \
     ./src/luabind/src/wrapper_base.cpp \
     ./src/luabind/src/weak_ref.cpp \
     ./src/luabind/src/stack_content_by_name.cpp \
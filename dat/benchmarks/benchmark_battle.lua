@@ -0,0 +1,51 @@
+-- Runs a battle against several enemies in active mode, without any display.
+-- Usage: valyriatear --benchmark dat/benchmarks/benchmark_battle.lua [results.json]
+
+-- The number of fixed steps (1/60th of a second) to run.
+frames = 3600;
+
+-- The random number generator seed, so that the same scenario is played on every run.
+seed = 1;
+
+-- The keys pressed and released, at the given step: the first command is confirmed regularly.
+inputs = {
+    { frame = 300, key = "confirm", pressed = true },
+    { frame = 305, key = "confirm", pressed = false },
+    { frame = 320, key = "confirm", pressed = true },
+    { frame = 325, key = "confirm", pressed = false },
+    { frame = 340, key = "confirm", pressed = true },
+    { frame = 345, key = "confirm", pressed = false },
+    { frame = 1200, key = "confirm", pressed = true },
+    { frame = 1205, key = "confirm", pressed = false },
+    { frame = 1220, key = "confirm", pressed = true },
+    { frame = 1225, key = "confirm", pressed = false },
+    { frame = 1240, key = "confirm", pressed = true },
+    { frame = 1245, key = "confirm", pressed = false },
+    { frame = 2100, key = "confirm", pressed = true },
+    { frame = 2105, key = "confirm", pressed = false },
+    { frame = 2120, key = "confirm", pressed = true },
+    { frame = 2125, key = "confirm", pressed = false },
+    { frame = 2140, key = "confirm", pressed = true },
+    { frame = 2145, key = "confirm", pressed = false },
+}
+
+function Setup()
+    GlobalManager:AddCharacter(BRONANN);
+    GlobalManager:AddCharacter(KALYA);
+    GlobalManager:AddCharacter(SYLVE);
+    GlobalManager:AddCharacter(THANIS);
+
+    local bronann = GlobalManager:GetCharacter(BRONANN);
+    bronann:SetMaxHitPoints(9999);
+    bronann:SetHitPoints(9999);
+
+    local battle = vt_battle.BattleMode();
+    battle:AddEnemy(1, 0, 0);
+    battle:AddEnemy(2, 0, 0);
+    battle:AddEnemy(4, 0, 0);
+    battle:AddEnemy(5, 0, 0);
+    battle:GetScriptSupervisor():AddScript("dat/battles/desert_cave_battle_anim.lua");
+    battle:SetBattleType(vt_battle.BattleMode.BATTLE_TYPE_ACTIVE);
+
+    ModeManager:Push(battle, false, false);
+end
@@ -0,0 +1,33 @@
+-- Runs the village center map with the hero walking around, without any display.
+-- Usage: valyriatear --benchmark dat/benchmarks/benchmark_map.lua [results.json]
+
+-- The number of fixed steps (1/60th of a second) to run.
+frames = 1800;
+
+-- The random number generator seed, so that the same scenario is played on every run.
+seed = 1;
+
+-- Uncomment to sample the Lua functions meanwhile, and write their profile to the given file.
+-- script_profile = "benchmark_map_scripts.txt";
+
+-- The keys pressed and released, at the given step.
+inputs = {
+    { frame = 60, key = "right", pressed = true },
+    { frame = 300, key = "right", pressed = false },
+    { frame = 300, key = "down", pressed = true },
+    { frame = 540, key = "down", pressed = false },
+    { frame = 540, key = "left", pressed = true },
+    { frame = 900, key = "left", pressed = false },
+    { frame = 900, key = "up", pressed = true },
+    { frame = 1140, key = "up", pressed = false },
+    { frame = 1200, key = "confirm", pressed = true },
+    { frame = 1205, key = "confirm", pressed = false },
+}
+
+function Setup()
+    GlobalManager:AddCharacter(BRONANN);
+
+    local map = vt_map.MapMode("dat/maps/layna_village/layna_village_center_map.lua",
+                               "dat/maps/layna_village/layna_village_center_script.lua");
+    ModeManager:Push(map, false, false);
+end
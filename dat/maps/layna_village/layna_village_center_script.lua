@@ -13,6 +13,14 @@ map_subname = "Village center"
 -- Other musics will have to handled through scripting.
 music_filename = "mus/Caketown_1-OGA-mat-pablo.ogg"
 
+-- The sounds decoded in the background while the map is loading.
+preload_sounds = {
+    "snd/door_open2.wav",
+    "snd/door_close.wav",
+    "snd/meow.wav",
+    "snd/rumble.wav"
+}
+
 -- c++ objects instances
 local Map = {};
 local ObjectManager = {};
@@ -18,6 +18,9 @@ local Map = {};
 local Script = {};
 local Effects = {};
 
+-- The key of the event checked every frame
+local to_be_continued_event = 0;
+
 function Initialize(map_instance)
     Map = map_instance;
 
@@ -29,16 +32,14 @@ function Initialize(map_instance)
 
     display_time = 0;
 
+    to_be_continued_event = GlobalManager:GetEventKey("game", "to_be_continued");
+
     to_be_continued_text = Script:CreateText(vt_system.Translate("To be continued..."), vt_video.TextStyle("text26"));
 end
 
 function Update()
     -- Only show the image if requested by the events
-    if (GlobalManager:DoesEventExist("game", "to_be_continued") == false) then
-        return;
-    end
-
-    if (GlobalManager:GetEventValue("game", "to_be_continued") == 0) then
+    if (GlobalManager:GetEventValue(to_be_continued_event) == 0) then
         return;
     end
 
@@ -54,11 +55,7 @@ local text_color = vt_video.Color(1.0, 1.0, 1.0, 1.0);
 
 function DrawPostEffects()
     -- Only show the image if requested by the events
-    if (GlobalManager:DoesEventExist("game", "to_be_continued") == false) then
-        return;
-    end
-
-    if (GlobalManager:GetEventValue("game", "to_be_continued") == 0) then
+    if (GlobalManager:GetEventValue(to_be_continued_event) == 0) then
         return;
     end
 
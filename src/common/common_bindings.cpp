@@ -108,11 +108,15 @@ void BindCommonCode()
                     .def("IncrementObjectCount", &GameGlobal::IncrementObjectCount)
                     .def("DecrementObjectCount", &GameGlobal::DecrementObjectCount)
                     .def("DoesEventGroupExist", &GameGlobal::DoesEventGroupExist)
-                    .def("DoesEventExist", &GameGlobal::DoesEventExist)
+                    .def("DoesEventExist", (bool(GameGlobal:: *)(const std::string &, const std::string &) const) &GameGlobal::DoesEventExist)
+                    .def("DoesEventExist", (bool(GameGlobal:: *)(uint32) const) &GameGlobal::DoesEventExist)
                     .def("AddNewEventGroup", &GameGlobal::AddNewEventGroup)
                     .def("GetEventGroup", &GameGlobal::GetEventGroup)
-                    .def("GetEventValue", &GameGlobal::GetEventValue)
-                    .def("SetEventValue", &GameGlobal::SetEventValue)
+                    .def("GetEventValue", (int32(GameGlobal:: *)(const std::string &, const std::string &) const) &GameGlobal::GetEventValue)
+                    .def("GetEventValue", (int32(GameGlobal:: *)(uint32) const) &GameGlobal::GetEventValue)
+                    .def("SetEventValue", (void(GameGlobal:: *)(const std::string &, const std::string &, int32)) &GameGlobal::SetEventValue)
+                    .def("SetEventValue", (void(GameGlobal:: *)(uint32, int32)) &GameGlobal::SetEventValue)
+                    .def("GetEventKey", &GameGlobal::GetEventKey)
                     .def("GetNumberEventGroups", &GameGlobal::GetNumberEventGroups)
                     .def("GetNumberEvents", &GameGlobal::GetNumberEvents)
                     .def("SetMapDataFilename", (void(GameGlobal:: *)(const std::string &)) &GameGlobal::SetMapDataFilename)
@@ -21,6 +21,8 @@
 #include "engine/system.h"
 #include "modes/map/map_mode.h"
 
+#include "utils/utils_files.h"
+
 using namespace vt_utils;
 
 using namespace vt_video;
@@ -37,10 +39,70 @@ using namespace private_global;
 GameGlobal *GlobalManager = NULL;
 bool GLOBAL_DEBUG = false;
 
+////////////////////////////////////////////////////////////////////////////////
+// GlobalEventTable class
+////////////////////////////////////////////////////////////////////////////////
+
+GlobalEventTable::GlobalEventTable()
+{
+    _events.push_back(Event(std::string(), std::string()));
+}
+
+uint32 GlobalEventTable::GetKey(const std::string &group_name, const std::string &event_name)
+{
+    std::map<std::string, uint32> &group_keys = _keys[group_name];
+    std::map<std::string, uint32>::iterator key_iter = group_keys.find(event_name);
+    if(key_iter != group_keys.end())
+        return key_iter->second;
+
+    uint32 key = _events.size();
+    _events.push_back(Event(group_name, event_name));
+    group_keys.insert(std::make_pair(event_name, key));
+    return key;
+}
+
+void GlobalEventTable::SetValue(uint32 key, int32 value)
+{
+    if(key == 0 || key >= _events.size()) {
+        IF_PRINT_WARNING(GLOBAL_DEBUG) << "invalid event key: " << key << std::endl;
+        return;
+    }
+    _events[key].value = value;
+    _events[key].is_set = true;
+}
+
+void GlobalEventTable::Unset(uint32 key)
+{
+    if(key == 0 || key >= _events.size())
+        return;
+    _events[key].value = 0;
+    _events[key].is_set = false;
+}
+
+const std::string &GlobalEventTable::GetGroupName(uint32 key) const
+{
+    if(key >= _events.size())
+        return _events[0].group_name;
+    return _events[key].group_name;
+}
+
+const std::string &GlobalEventTable::GetEventName(uint32 key) const
+{
+    if(key >= _events.size())
+        return _events[0].event_name;
+    return _events[key].event_name;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // GlobalEventGroup class
 ////////////////////////////////////////////////////////////////////////////////
 
+GlobalEventGroup::~GlobalEventGroup()
+{
+    for(std::map<std::string, uint32>::const_iterator it = _events.begin(); it != _events.end(); ++it)
+        _event_table->Unset(it->second);
+}
+
 void GlobalEventGroup::AddNewEvent(const std::string &event_name, int32 event_value)
 {
     if(DoesEventExist(event_name)) {
@@ -48,28 +110,30 @@ void GlobalEventGroup::AddNewEvent(const std::string &event_name, int32 event_va
                                        << _group_name << std::endl;
         return;
     }
-    _events.insert(std::make_pair(event_name, event_value));
+    uint32 key = _event_table->GetKey(_group_name, event_name);
+    _events.insert(std::make_pair(event_name, key));
+    _event_table->SetValue(key, event_value);
 }
 
 int32 GlobalEventGroup::GetEvent(const std::string &event_name)
 {
-    std::map<std::string, int32>::iterator event_iter = _events.find(event_name);
+    std::map<std::string, uint32>::iterator event_iter = _events.find(event_name);
     if(event_iter == _events.end()) {
         IF_PRINT_WARNING(GLOBAL_DEBUG) << "an event with the specified name \"" << event_name << "\" did not exist in this group: "
                                        << _group_name << std::endl;
         return 0;
     }
-    return event_iter->second;
+    return _event_table->GetValue(event_iter->second);
 }
 
 void GlobalEventGroup::SetEvent(const std::string &event_name, int32 event_value)
 {
-    std::map<std::string, int32>::iterator event_iter = _events.find(event_name);
+    std::map<std::string, uint32>::iterator event_iter = _events.find(event_name);
     if(event_iter == _events.end()) {
         AddNewEvent(event_name, event_value);
         return;
     }
-    event_iter->second = event_value;
+    _event_table->SetValue(event_iter->second, event_value);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -107,6 +171,17 @@ bool GameGlobal::SingletonInitialize()
     return _LoadGlobalScripts();
 }
 
+bool GameGlobal::ReloadGlobalScripts()
+{
+    _CloseGlobalScripts();
+    if(!_LoadGlobalScripts())
+        return false;
+
+    // Update the translated texts of the objects and skills already read.
+    _definitions.ReloadDefinitions();
+    return true;
+}
+
 void GameGlobal::_CloseGlobalScripts() {
     // Close all persistent script files
     _global_script.CloseFile();
@@ -160,6 +235,32 @@ void GameGlobal::_CloseGlobalScripts() {
 
 bool GameGlobal::_LoadGlobalScripts()
 {
+    // The files are parsed by the worker threads while the first ones are run.
+    static const char *const script_filenames[] = {
+        "dat/global.lua",
+        "dat/objects/items.lua",
+        "dat/objects/weapons.lua",
+        "dat/objects/head_armor.lua",
+        "dat/objects/torso_armor.lua",
+        "dat/objects/arm_armor.lua",
+        "dat/objects/leg_armor.lua",
+        "dat/objects/spirits.lua",
+        "dat/skills/weapon.lua",
+        "dat/skills/magic.lua",
+        "dat/skills/special.lua",
+        "dat/skills/barehands.lua",
+        "dat/effects/status.lua",
+        "dat/actors/characters.lua",
+        "dat/actors/enemies.lua",
+        "dat/actors/map_sprites.lua",
+        "dat/actors/map_objects.lua",
+        "dat/actors/map_treasures.lua",
+        "dat/config/quests.lua",
+        "dat/config/world_locations.lua"
+    };
+    for(uint32 i = 0; i < sizeof(script_filenames) / sizeof(script_filenames[0]); ++i)
+        ScriptManager->PrecompileFile(script_filenames[i]);
+
     // Open up the persistent script files
     if(!_global_script.OpenFile("dat/global.lua"))
         return false;
@@ -724,7 +825,7 @@ bool GameGlobal::DoesEventExist(const std::string &group_name, const std::string
     if(group_iter == _event_groups.end())
         return false;
 
-    std::map<std::string, int32>::const_iterator event_iter = group_iter->second->GetEvents().find(event_name);
+    std::map<std::string, uint32>::const_iterator event_iter = group_iter->second->GetEvents().find(event_name);
     if(event_iter == group_iter->second->GetEvents().end())
         return false;
 
@@ -741,7 +842,7 @@ void GameGlobal::AddNewEventGroup(const std::string &group_name)
         return;
     }
 
-    GlobalEventGroup *geg = new GlobalEventGroup(group_name);
+    GlobalEventGroup *geg = new GlobalEventGroup(group_name, &_event_table);
     _event_groups.insert(std::make_pair(group_name, geg));
 }
 
@@ -765,11 +866,11 @@ int32 GameGlobal::GetEventValue(const std::string &group_name, const std::string
     if(group_iter == _event_groups.end())
         return 0;
 
-    std::map<std::string, int32>::const_iterator event_iter = group_iter->second->GetEvents().find(event_name);
+    std::map<std::string, uint32>::const_iterator event_iter = group_iter->second->GetEvents().find(event_name);
     if(event_iter == group_iter->second->GetEvents().end())
         return 0;
 
-    return event_iter->second;
+    return _event_table.GetValue(event_iter->second);
 }
 
 void GameGlobal::SetEventValue(const std::string &group_name, const std::string &event_name, int32 event_value)
@@ -777,7 +878,7 @@ void GameGlobal::SetEventValue(const std::string &group_name, const std::string
     GlobalEventGroup *geg = 0;
     std::map<std::string, GlobalEventGroup *>::const_iterator group_iter = _event_groups.find(group_name);
     if(group_iter == _event_groups.end()) {
-        geg = new GlobalEventGroup(group_name);
+        geg = new GlobalEventGroup(group_name, &_event_table);
         _event_groups.insert(std::make_pair(group_name, geg));
     } else {
         geg = group_iter->second;
@@ -786,6 +887,22 @@ void GameGlobal::SetEventValue(const std::string &group_name, const std::string
     geg->SetEvent(event_name, event_value);
 }
 
+void GameGlobal::SetEventValue(uint32 event_key, int32 event_value)
+{
+    if(_event_table.IsSet(event_key)) {
+        _event_table.SetValue(event_key, event_value);
+        return;
+    }
+
+    if(event_key == 0 || event_key > _event_table.GetNumberKeys()) {
+        IF_PRINT_WARNING(GLOBAL_DEBUG) << "invalid event key: " << event_key << std::endl;
+        return;
+    }
+
+    // The event doesn't exist yet, so it is added to its group.
+    SetEventValue(_event_table.GetGroupName(event_key), _event_table.GetEventName(event_key), event_value);
+}
+
 uint32 GameGlobal::GetNumberEvents(const std::string &group_name) const
 {
     std::map<std::string, GlobalEventGroup *>::const_iterator group_iter = _event_groups.find(group_name);
@@ -840,91 +957,17 @@ void GameGlobal::NewGame()
 
 bool GameGlobal::SaveGame(const std::string &filename, uint32 slot_id, uint32 x_position, uint32 y_position)
 {
-    WriteScriptDescriptor file;
-    if(file.OpenFile(filename) == false) {
-        return false;
-    }
-
-    // Open the save_game1 table
-    file.WriteLine("save_game1 = {");
-
-    // Save simple play data
-    file.InsertNewLine();
-    file.WriteLine("map_data_filename = \"" + _map_data_filename + "\",");
-    file.WriteLine("map_script_filename = \"" + _map_script_filename + "\",");
-    //! \note Coords are in map tiles
-    file.WriteLine("location_x = " + NumberToString(x_position) + ",");
-    file.WriteLine("location_y = " + NumberToString(y_position) + ",");
-    file.WriteLine("play_hours = " + NumberToString(SystemManager->GetPlayHours()) + ",");
-    file.WriteLine("play_minutes = " + NumberToString(SystemManager->GetPlayMinutes()) + ",");
-    file.WriteLine("play_seconds = " + NumberToString(SystemManager->GetPlaySeconds()) + ",");
-    file.WriteLine("drunes = " + NumberToString(_drunes) + ",");
-
-    // Save the inventory (object id + object count pairs)
-    // NOTE: This does not save any weapons/armor that are equipped on the characters. That data
-    // is stored alongside the character data when it is saved
-    _SaveInventory(file, "items", _inventory_items);
-    _SaveInventory(file, "weapons", _inventory_weapons);
-    _SaveInventory(file, "head_armor", _inventory_head_armor);
-    _SaveInventory(file, "torso_armor", _inventory_torso_armor);
-    _SaveInventory(file, "arm_armor", _inventory_arm_armor);
-    _SaveInventory(file, "leg_armor", _inventory_leg_armor);
-    _SaveInventory(file, "spirits", _inventory_spirits);
-
-    // ----- (5) Save character data
-    file.InsertNewLine();
-    file.WriteLine("characters = {");
-    // First save the order of the characters in the party
-    file.WriteLine("\t[\"order\"] = {");
-    for(uint32 i = 0; i < _ordered_characters.size(); ++i) {
-        if(i == 0)
-            file.WriteLine("\t\t" + NumberToString(_ordered_characters[i]->GetID()), false);
-        else
-            file.WriteLine(", " + NumberToString(_ordered_characters[i]->GetID()), false);
-    }
-    file.WriteLine("\n\t},"); // order
+    SaveGameData data;
+    _CreateSaveGameData(data, x_position, y_position);
 
-    // Now save each individual character's data
-    for(uint32 i = 0; i < _ordered_characters.size(); i++) {
-        if((i + 1) == _ordered_characters.size())
-            _SaveCharacter(file, _ordered_characters[i], true);
-        else
-            _SaveCharacter(file, _ordered_characters[i], false);
-    }
-    file.WriteLine("},"); // characters
+    SavePreviewData preview;
+    _CreateSavePreviewData(data, _map_hud_name, _map_image.GetFilename(), preview);
 
-    // ----- (6) Save event data
-    file.InsertNewLine();
-    file.WriteLine("event_groups = {");
-    for(std::map<std::string, GlobalEventGroup *>::iterator it = _event_groups.begin(); it != _event_groups.end(); ++it) {
-        _SaveEvents(file, it->second);
-    }
-    file.WriteLine("},");
-    file.InsertNewLine();
-
-    // ------ (7) Save quest log
-    file.WriteLine("quest_log = {");
-    for(std::map<std::string, QuestLogEntry *>::const_iterator itr = _quest_log_entries.begin(); itr != _quest_log_entries.end(); ++itr)
-        _SaveQuests(file, itr->second);
-    file.WriteLine("},");
-    file.InsertNewLine();
-
-    // ------ (8) Save World Map
-    _SaveWorldMap(file);
-
-    // ----- (8) Report any errors detected from the previous write operations
-    if(file.IsErrorDetected()) {
-        if(GLOBAL_DEBUG) {
-            PRINT_WARNING << "one or more errors occurred while writing the save game file - they are listed below" << std::endl;
-            std::cerr << file.GetErrorMessages() << std::endl;
-            file.ClearErrors();
-        }
-    }
-
-    file.InsertNewLine();
-    file.WriteLine("} -- save_game1"); //save_game1
+    _save_writer.Start(data, filename, preview, GetSavePreviewFilename(slot_id));
 
-    file.CloseFile();
+    // The file is already written when it couldn't be done in the background.
+    if(!_save_writer.IsWriting() && !_save_writer.Wait())
+        return false;
 
     // Store the game slot the game is coming from.
     _game_slot_id = slot_id;
@@ -936,132 +979,104 @@ bool GameGlobal::SaveGame(const std::string &filename, uint32 slot_id, uint32 x_
 
 bool GameGlobal::LoadGame(const std::string &filename, uint32 slot_id)
 {
-    ReadScriptDescriptor file;
-    if(!file.OpenFile(filename))
+    // The file may still be being written.
+    _save_writer.Wait();
+
+    SaveGameData data;
+    if(!ReadSaveGame(filename, data))
         return false;
 
     ClearAllData();
 
-    // open the namespace that the save game is encapsulated in.
-    if (!file.OpenTable("save_game1")) {
-        PRINT_ERROR << "Couldn't open the savegame " << filename << std::endl;
+    if(!_ApplySaveGameData(data)) {
+        PRINT_ERROR << "No characters were added by save game file: " << filename << std::endl;
         return false;
     }
 
-    // Load play data
-    // DEPRECATED: Old way to load, will be removed in a release
-    if (file.DoesStringExist("map_filename")) {
-        _map_data_filename = file.ReadString("map_filename");
-        _map_script_filename = file.ReadString("map_filename");
-    }
-    else {
-        // New way: data and script are separated.
-        _map_data_filename = file.ReadString("map_data_filename");
-        _map_script_filename = file.ReadString("map_script_filename");
-    }
+    // Store the game slot the game is coming from.
+    _game_slot_id = slot_id;
 
-    // DEPRECATED: Remove in one release
-    // Hack to permit the split of last map data and scripts.
-    if (!_map_data_filename.empty() && _map_data_filename == _map_script_filename) {
-        std::string map_common_name = _map_data_filename.substr(0, _map_data_filename.length() - 4);
-        _map_data_filename = map_common_name + "_map.lua";
-        _map_script_filename = map_common_name + "_script.lua";
-    }
+    return true;
+} // bool GameGlobal::LoadGame(string& filename)
 
-    // Load a potential saved position
-    _x_save_map_position = file.ReadUInt("location_x");
-    _y_save_map_position = file.ReadUInt("location_y");
-    uint8 hours, minutes, seconds;
-    hours = file.ReadUInt("play_hours");
-    minutes = file.ReadUInt("play_minutes");
-    seconds = file.ReadUInt("play_seconds");
-    SystemManager->SetPlayTime(hours, minutes, seconds);
-    _drunes = file.ReadUInt("drunes");
-
-    // Load inventory
-    _LoadInventory(file, "items");
-    _LoadInventory(file, "weapons");
-    _LoadInventory(file, "head_armor");
-    _LoadInventory(file, "torso_armor");
-    _LoadInventory(file, "arm_armor");
-    _LoadInventory(file, "leg_armor");
-    _LoadInventory(file, "spirits");
-    _LoadInventory(file, "key_items"); // DEPRECATED: Remove in one release
+std::string GameGlobal::GetSaveSlotFilename(uint32 slot_id)
+{
+    std::ostringstream f;
+    f << GetUserDataPath() << "saved_game_" << slot_id << ".sav";
+    return f.str();
+}
 
-    // Load characters into the party in the correct order
-    if (!file.OpenTable("characters")) {
-        PRINT_ERROR << "Couldn't open the savegame characters data in " << filename << std::endl;
-        file.CloseAllTables();
-        file.CloseFile();
-        return false;
-    }
+std::string GameGlobal::FindSaveSlotFilename(uint32 slot_id)
+{
+    const std::string filename = GetSaveSlotFilename(slot_id);
+    if(DoesFileExist(filename))
+        return filename;
 
-    if (!file.DoesTableExist("order")) {
-        PRINT_ERROR << "Couldn't open the savegame characters order data in " << filename << std::endl;
-        file.CloseAllTables();
-        file.CloseFile();
-        return false;
-    }
+    // The slots saved by the former versions of the game are still loaded.
+    std::ostringstream f;
+    f << GetUserDataPath() << "saved_game_" << slot_id << ".lua";
+    if(DoesFileExist(f.str()))
+        return f.str();
 
-    std::vector<uint32> char_ids;
-    file.ReadUIntVector("order", char_ids);
+    return std::string();
+}
 
-    if (char_ids.empty()) {
-        PRINT_ERROR << "No valid characters id in " << filename << std::endl;
-        file.CloseAllTables();
-        file.CloseFile();
+std::string GameGlobal::GetSavePreviewFilename(uint32 slot_id)
+{
+    std::ostringstream f;
+    f << GetUserDataPath() << "saved_game_" << slot_id << ".preview";
+    return f.str();
+}
+
+bool GameGlobal::ReadSaveSlotPreview(uint32 slot_id, SavePreviewData &preview)
+{
+    const std::string filename = FindSaveSlotFilename(slot_id);
+    if(filename.empty())
         return false;
-    }
 
-    for(uint32 i = 0; i < char_ids.size(); i++) {
-        _LoadCharacter(file, char_ids[i]);
+    const std::string preview_filename = GetSavePreviewFilename(slot_id);
+    if(ReadSavePreview(preview_filename, preview)
+            && preview.save_filename == filename
+            && preview.save_time == GetFileModificationTime(filename)
+            && preview.language == SystemManager->GetLanguage()) {
+        return DoesFileExist(preview.map_data_filename) && DoesFileExist(preview.map_script_filename);
     }
-    file.CloseTable(); // characters
 
-    if (_characters.empty()) {
-        PRINT_ERROR << "No characters were added by save game file: " << filename << std::endl;
-        file.CloseAllTables();
-        file.CloseFile();
+    // The preview is missing or outdated, so it is rebuilt from the whole saved game.
+    SaveGameData data;
+    if(!ReadSaveGame(filename, data))
         return false;
-    }
 
-    // Load event data
-    std::vector<std::string> group_names;
-    if (file.OpenTable("event_groups")) {
-        file.ReadTableKeys(group_names);
-        for(uint32 i = 0; i < group_names.size(); i++)
-            _LoadEvents(file, group_names[i]);
-        file.CloseTable();
-    }
+    if(data.map_data_filename.empty() || !DoesFileExist(data.map_data_filename))
+        return false;
+
+    // Gets the untranslated map hud name and image from the map script.
+    vt_script::ReadScriptDescriptor map_file;
+    if(!map_file.OpenFile(data.map_script_filename))
+        return false;
 
-    // Load the quest log data
-    std::vector<std::string> quest_keys;
-    if (file.OpenTable("quest_log")) {
-        file.ReadTableKeys(quest_keys);
-        for(uint32 i = 0; i < quest_keys.size(); ++i)
-            _LoadQuests(file, quest_keys[i]);
-        file.CloseTable();
+    if(map_file.OpenTablespace().empty()) {
+        map_file.CloseFile();
+        return false;
     }
 
-    // Load the world map data
-    _LoadWorldMap(file);
+    std::string map_hud_name = map_file.ReadString("map_name");
+    std::string map_image_filename = map_file.ReadString("map_image_filename");
 
-    // Report any errors detected from the previous read operations
-    if(file.IsErrorDetected()) {
-        if(GLOBAL_DEBUG) {
-            PRINT_WARNING << "one or more errors occurred while reading the save game file - they are listed below" << std::endl;
-            std::cerr << file.GetErrorMessages() << std::endl;
-            file.ClearErrors();
-        }
-    }
+    map_file.CloseTable(); // Tablespace
+    map_file.CloseFile();
 
-    file.CloseFile();
+    _CreateSavePreviewData(data, map_hud_name.empty() ? ustring() : UTranslate(map_hud_name),
+                           map_image_filename, preview);
+    preview.save_filename = filename;
+    preview.save_time = GetFileModificationTime(filename);
 
-    // Store the game slot the game is coming from.
-    _game_slot_id = slot_id;
+    // The saved game writer may be writing the same preview file.
+    if(!_save_writer.IsWriting() && !WriteSavePreview(preview, preview_filename))
+        PRINT_WARNING << "Couldn't write the saved game preview: " << preview_filename << std::endl;
 
     return true;
-} // bool GameGlobal::LoadGame(string& filename)
+}
 
 void GameGlobal::LoadEmotes(const std::string &emotes_filename)
 {
@@ -1147,446 +1162,235 @@ void GameGlobal::GetEmoteOffset(float &x, float &y, const std::string &emote_id,
 // GameGlobal class - Private Methods
 ////////////////////////////////////////////////////////////////////////////////
 
-void GameGlobal::_SaveCharacter(WriteScriptDescriptor &file, GlobalCharacter *character, bool last)
+//! \brief Copies the ids and counts of the objects of an inventory category, skipping the ones with 0 count.
+template <class T> static void CopyInventory(const std::vector<T *> &inventory, std::vector<std::pair<uint32, uint32> > &data)
 {
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
-    if(character == NULL) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "function received a NULL character pointer argument" << std::endl;
-        return;
-    }
-
-    file.WriteLine("\t[" + NumberToString(character->GetID()) + "] = {");
-
-    // Store whether the character is available
-    file.WriteLine("\t\tenabled = " + std::string(character->IsEnabled() ? "true" : "false") + ",");
-
-    // ----- (1): Write out the character's stats
-    file.WriteLine("\t\texperience_level = " + NumberToString(character->GetExperienceLevel()) + ",");
-    file.WriteLine("\t\texperience_points = " + NumberToString(character->GetExperiencePoints()) + ",");
-    file.WriteLine("\t\texperience_points_next = " + NumberToString(character->GetExperienceForNextLevel()) + ", ");
-
-    // The values stored are the unmodified ones.
-    file.WriteLine("\t\tmax_hit_points = " + NumberToString(character->GetMaxHitPoints()) + ",");
-    file.WriteLine("\t\thit_points = " + NumberToString(character->GetHitPoints()) + ",");
-    file.WriteLine("\t\tmax_skill_points = " + NumberToString(character->GetMaxSkillPoints()) + ",");
-    file.WriteLine("\t\tskill_points = " + NumberToString(character->GetSkillPoints()) + ",");
-
-    file.WriteLine("\t\tstrength = " + NumberToString(character->GetStrengthBase()) + ",");
-    file.WriteLine("\t\tvigor = " + NumberToString(character->GetVigorBase()) + ",");
-    file.WriteLine("\t\tfortitude = " + NumberToString(character->GetFortitudeBase()) + ",");
-    file.WriteLine("\t\tprotection = " + NumberToString(character->GetProtectionBase()) + ",");
-    file.WriteLine("\t\tagility = " + NumberToString(character->GetAgilityBase()) + ",");
-    file.WriteLine("\t\tevade = " + NumberToString(character->GetEvadeBase()) + ",");
-
-    // ----- (2): Write out the character's equipment
-    uint32 weapon_id = 0;
-    uint32 head_id = 0;
-    uint32 torso_id = 0;
-    uint32 arm_id = 0;
-    uint32 leg_id = 0;
-    GlobalObject *obj_tmp = NULL;
-
-    obj_tmp = character->GetWeaponEquipped();
-    if(obj_tmp != NULL)
-        weapon_id = obj_tmp->GetID();
-
-    obj_tmp = character->GetHeadArmorEquipped();
-    if(obj_tmp != NULL)
-        head_id = obj_tmp->GetID();
-
-    obj_tmp = character->GetTorsoArmorEquipped();
-    if(obj_tmp != NULL)
-        torso_id = obj_tmp->GetID();
-
-    obj_tmp = character->GetArmArmorEquipped();
-    if(obj_tmp != NULL)
-        arm_id = obj_tmp->GetID();
-
-    obj_tmp = character->GetLegArmorEquipped();
-    if(obj_tmp != NULL)
-        leg_id = obj_tmp->GetID();
-
-    file.InsertNewLine();
-    file.WriteLine("\t\tequipment = {");
-    file.WriteLine("\t\t\tweapon = " + NumberToString(weapon_id) + ",");
-    file.WriteLine("\t\t\thead_armor = " + NumberToString(head_id) + ",");
-    file.WriteLine("\t\t\ttorso_armor = " + NumberToString(torso_id) + ",");
-    file.WriteLine("\t\t\tarm_armor = " + NumberToString(arm_id) + ",");
-    file.WriteLine("\t\t\tleg_armor = " + NumberToString(leg_id));
-    file.WriteLine("\t\t},");
-
-    // Write out the character's permanent skills.
-    // The equipment skills will be reloaded through equipment.
-    file.InsertNewLine();
-    file.WriteLine("\t\tskills = {");
-    const std::vector<uint32>& skill_vector = character->GetPermanentSkills();
-    for(uint32 i = 0; i < skill_vector.size(); i++) {
-        uint32 skill_id = skill_vector.at(i);
-
-        if(i == 0)
-            file.WriteLine("\t\t\t", false);
-        else
-            file.WriteLine(", ", false);
-        file.WriteLine(NumberToString(skill_id), false);
-    }
-    file.WriteLine("\n\t\t}");
-
-    if(last)
-        file.WriteLine("\t}");
-    else
-        file.WriteLine("\t},");
-} // void GameGlobal::_SaveCharacter(WriteScriptDescriptor& file, GlobalCharacter* character, bool last)
-
-
-
-void GameGlobal::_SaveEvents(WriteScriptDescriptor &file, GlobalEventGroup *event_group)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
-    if(event_group == NULL) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "function received a NULL event group pointer argument" << std::endl;
-        return;
-    }
-
-    file.WriteLine("\t" + event_group->GetGroupName() + " = {");
-
-    uint32 i = 0;
-    for(std::map<std::string, int32>::const_iterator it = event_group->GetEvents().begin(); it != event_group->GetEvents().end(); ++it) {
-        if(it == event_group->GetEvents().begin())
-            file.WriteLine("\t\t", false);
-        else
-            file.WriteLine(", ", false);
-
-        // Add a new line every 4 entries for better readability and debugging
-        if ((i > 0) && !(i % 4)) {
-            file.InsertNewLine();
-            file.WriteLine("\t\t", false);
-        }
-
-        file.WriteLine("[\"" + it->first + "\"] = " + NumberToString(it->second), false);
-
-        ++i;
-    }
-    file.WriteLine("\n\t},");
-
-}
-
-void GameGlobal::_SaveQuests(WriteScriptDescriptor &file, const QuestLogEntry *quest_log_entry)
-{
-    if(file.IsFileOpen() == false)
-    {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
-
-    if(quest_log_entry == NULL)
-    {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "_SaveQuests function received a NULL quest log entry pointer argument" << std::endl;
-        return;
+    for(typename std::vector<T *>::const_iterator it = inventory.begin(); it != inventory.end(); ++it) {
+        if((*it)->GetCount() == 0)
+            continue;
+        data.push_back(std::make_pair((*it)->GetID(), (*it)->GetCount()));
     }
-
-    // Start writting
-    file.WriteLine("\t" + quest_log_entry->GetQuestId() + " = {", false);
-    // Write the quest log number. this is written as a string because loading needs a uniform type of data in the array
-    file.WriteLine("\"" + NumberToString(quest_log_entry->GetQuestLogNumber()) + "\", ", false);
-    // Write the "false" or "true" string if this entry has been read or not
-    const std::string is_read(quest_log_entry->IsRead() ? "true" : "false");
-    file.WriteLine("\"" + is_read + "\"", false);
-    // End writing
-    file.WriteLine("},");
-
 }
 
-void GameGlobal::_SaveWorldMap(vt_script::WriteScriptDescriptor &file)
+void GameGlobal::_CreateSaveGameData(SaveGameData &data, uint32 x_position, uint32 y_position)
 {
-    if(!file.IsFileOpen()) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
+    data.map_data_filename = _map_data_filename;
+    data.map_script_filename = _map_script_filename;
+    data.location_x = x_position;
+    data.location_y = y_position;
+    data.play_hours = SystemManager->GetPlayHours();
+    data.play_minutes = SystemManager->GetPlayMinutes();
+    data.play_seconds = SystemManager->GetPlaySeconds();
+    data.drunes = _drunes;
 
-    // Write the 'worldmap' table
-    file.WriteLine("worldmap = {");
+    // NOTE: This does not save any weapons/armor that are equipped on the characters. That data
+    // is stored alongside the character data when it is saved
+    CopyInventory(_inventory_items, data.inventory[0]);
+    CopyInventory(_inventory_weapons, data.inventory[1]);
+    CopyInventory(_inventory_head_armor, data.inventory[2]);
+    CopyInventory(_inventory_torso_armor, data.inventory[3]);
+    CopyInventory(_inventory_arm_armor, data.inventory[4]);
+    CopyInventory(_inventory_leg_armor, data.inventory[5]);
+    CopyInventory(_inventory_spirits, data.inventory[6]);
+
+    data.characters.resize(_ordered_characters.size());
+    for(uint32 i = 0; i < _ordered_characters.size(); ++i) {
+        GlobalCharacter *character = _ordered_characters[i];
+        SaveCharacterData &character_data = data.characters[i];
 
-    //write the world map filename
-    file.WriteLine("\tworld_map_file = \"" + GetWorldMapFilename() + "\",");
-    file.InsertNewLine();
+        character_data.id = character->GetID();
+        character_data.enabled = character->IsEnabled();
 
-    //write the viewable locations
-    file.WriteLine("\tviewable_locations = {");
-    for(uint32 i = 0; i < _viewable_world_locations.size(); ++i)
-        file.WriteLine("\t\t\"" + _viewable_world_locations[i]+"\",");
-    file.WriteLine("\t},");
-    file.InsertNewLine();
+        character_data.experience_level = character->GetExperienceLevel();
+        character_data.experience_points = character->GetExperiencePoints();
+        character_data.experience_points_next = character->GetExperienceForNextLevel();
 
-    file.WriteLine("\tcurrent_location = \"" + GetCurrentLocationId() + "\"");
+        // The values stored are the unmodified ones.
+        character_data.max_hit_points = character->GetMaxHitPoints();
+        character_data.hit_points = character->GetHitPoints();
+        character_data.max_skill_points = character->GetMaxSkillPoints();
+        character_data.skill_points = character->GetSkillPoints();
 
-    file.WriteLine("}"); // close the main table
-    file.InsertNewLine();
-}
+        character_data.strength = character->GetStrengthBase();
+        character_data.vigor = character->GetVigorBase();
+        character_data.fortitude = character->GetFortitudeBase();
+        character_data.protection = character->GetProtectionBase();
+        character_data.agility = character->GetAgilityBase();
+        character_data.evade = character->GetEvadeBase();
 
-void GameGlobal::_LoadInventory(ReadScriptDescriptor &file, const std::string &category_name)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
+        if(character->GetWeaponEquipped() != NULL)
+            character_data.weapon = character->GetWeaponEquipped()->GetID();
+        if(character->GetHeadArmorEquipped() != NULL)
+            character_data.head_armor = character->GetHeadArmorEquipped()->GetID();
+        if(character->GetTorsoArmorEquipped() != NULL)
+            character_data.torso_armor = character->GetTorsoArmorEquipped()->GetID();
+        if(character->GetArmArmorEquipped() != NULL)
+            character_data.arm_armor = character->GetArmArmorEquipped()->GetID();
+        if(character->GetLegArmorEquipped() != NULL)
+            character_data.leg_armor = character->GetLegArmorEquipped()->GetID();
 
-    // The table keys are the inventory object ID numbers. The value of each key is the count of that object
-    if (file.OpenTable(category_name)) {
-        std::vector<uint32> object_ids;
-        file.ReadTableKeys(object_ids);
-        for(uint32 i = 0; i < object_ids.size(); i++) {
-            AddToInventory(object_ids[i], file.ReadUInt(object_ids[i]));
-        }
-        file.CloseTable();
+        // The equipment skills will be reloaded through equipment.
+        character_data.skills = character->GetPermanentSkills();
     }
-}
 
+    data.event_groups.resize(_event_groups.size());
+    uint32 group_index = 0;
+    for(std::map<std::string, GlobalEventGroup *>::const_iterator it = _event_groups.begin(); it != _event_groups.end(); ++it) {
+        SaveEventGroupData &group_data = data.event_groups[group_index++];
+        group_data.name = it->first;
 
-
-void GameGlobal::_LoadCharacter(ReadScriptDescriptor &file, uint32 id)
-{
-    if(!file.IsFileOpen()) {
-        PRINT_WARNING << "Can't load character, the file " << file.GetFilename()
-            << " is not open." << std::endl;
-        return;
+        const std::map<std::string, uint32> &events = it->second->GetEvents();
+        group_data.events.reserve(events.size());
+        for(std::map<std::string, uint32>::const_iterator it_event = events.begin(); it_event != events.end(); ++it_event)
+            group_data.events.push_back(std::make_pair(it_event->first, _event_table.GetValue(it_event->second)));
     }
 
-    // This function assumes that the characters table in the saved game file is already open.
-    // So all we need to open is the character's table
-    if (!file.OpenTable(id)) {
-        PRINT_WARNING << "Can't load unexisting character id: " << id << std::endl;
-        return;
+    for(std::map<std::string, QuestLogEntry *>::const_iterator it = _quest_log_entries.begin(); it != _quest_log_entries.end(); ++it) {
+        SaveQuestData quest_data;
+        quest_data.id = it->second->GetQuestId();
+        quest_data.log_number = it->second->GetQuestLogNumber();
+        quest_data.is_read = it->second->IsRead();
+        data.quests.push_back(quest_data);
     }
 
-    // Create a new GlobalCharacter object using the provided id
-    // This loads all of the character's "static" data, such as their name, etc.
-    GlobalCharacter *character = new GlobalCharacter(id, false);
-
-    // Gets whether the character is currently enabled
-    if(file.DoesBoolExist("enabled"))
-        character->Enable(file.ReadBool("enabled"));
-    else // old format DEPRECATED: Removed in one release
-        character->Enable(true);
-
-    // Read in all of the character's stats data
-    character->SetExperienceLevel(file.ReadUInt("experience_level"));
-    character->SetExperiencePoints(file.ReadUInt("experience_points"));
-    character->_experience_for_next_level = file.ReadInt("experience_points_next");
-
-    character->SetMaxHitPoints(file.ReadUInt("max_hit_points"));
-    character->SetHitPoints(file.ReadUInt("hit_points"));
-    character->SetMaxSkillPoints(file.ReadUInt("max_skill_points"));
-    character->SetSkillPoints(file.ReadUInt("skill_points"));
-
-    character->SetStrength(file.ReadUInt("strength"));
-    character->SetVigor(file.ReadUInt("vigor"));
-    character->SetFortitude(file.ReadUInt("fortitude"));
-    character->SetProtection(file.ReadUInt("protection"));
-    character->SetAgility(file.ReadUInt("agility"));
-    character->SetEvade(file.ReadFloat("evade"));
-
-    // Read the character's equipment and load it onto the character
-    if (file.OpenTable("equipment")) {
-        uint32 equip_id;
+    data.world_map_filename = GetWorldMapFilename();
+    data.viewable_locations = _viewable_world_locations;
+    data.current_location = GetCurrentLocationId();
+} // void GameGlobal::_CreateSaveGameData(SaveGameData &data, uint32 x_position, uint32 y_position)
 
-        // Equip the objects on the character as long as valid equipment IDs were read
-        equip_id = file.ReadUInt("weapon");
-        if(equip_id != 0) {
-            character->EquipWeapon(new GlobalWeapon(equip_id));
-        }
 
-        equip_id = file.ReadUInt("head_armor");
-        if(equip_id != 0) {
-            character->EquipHeadArmor(new GlobalArmor(equip_id));
-        }
 
-        equip_id = file.ReadUInt("torso_armor");
-        if(equip_id != 0) {
-            character->EquipTorsoArmor(new GlobalArmor(equip_id));
+void GameGlobal::_CreateSavePreviewData(const SaveGameData &data, const ustring &map_hud_name,
+                                        const std::string &map_image_filename, SavePreviewData &preview)
+{
+    preview = SavePreviewData();
+    preview.language = SystemManager->GetLanguage();
+    preview.map_data_filename = data.map_data_filename;
+    preview.map_script_filename = data.map_script_filename;
+    preview.map_hud_name = map_hud_name;
+    preview.map_image_filename = map_image_filename;
+    preview.play_hours = data.play_hours;
+    preview.play_minutes = data.play_minutes;
+    preview.play_seconds = data.play_seconds;
+    preview.drunes = data.drunes;
+
+    // Only the visible battle characters are previewed.
+    for(uint32 i = 0; i < 4 && i < data.characters.size(); ++i) {
+        const SaveCharacterData &character_data = data.characters[i];
+
+        // Loads the character "static" data, such as their name, when not in the party.
+        GlobalCharacter *character = GetCharacter(character_data.id);
+        GlobalCharacter *loaded_character = NULL;
+        if(character == NULL) {
+            loaded_character = new GlobalCharacter(character_data.id, false);
+            character = loaded_character;
         }
 
-        equip_id = file.ReadUInt("arm_armor");
-        if(equip_id != 0) {
-            character->EquipArmArmor(new GlobalArmor(equip_id));
-        }
+        SavePreviewCharacterData character_preview;
+        character_preview.id = character_data.id;
+        character_preview.name = character->GetName();
+        character_preview.portrait_filename = character->GetPortrait().GetFilename();
+        character_preview.experience_level = character_data.experience_level;
+        character_preview.max_hit_points = character_data.max_hit_points;
+        character_preview.hit_points = character_data.hit_points;
+        character_preview.max_skill_points = character_data.max_skill_points;
+        character_preview.skill_points = character_data.skill_points;
+        preview.characters.push_back(character_preview);
 
-        equip_id = file.ReadUInt("leg_armor");
-        if(equip_id != 0) {
-            character->EquipLegArmor(new GlobalArmor(equip_id));
-        }
-
-        file.CloseTable(); // equipment
+        delete loaded_character;
     }
+} // void GameGlobal::_CreateSavePreviewData(...)
 
-    // Read the character's skills and pass those onto the character object
-    std::vector<uint32> skill_ids;
 
-    skill_ids.clear();
-    file.ReadUIntVector("skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); i++) {
-        // DEPRECATED HACK: Remove that in one release.
-        // Turn old bare hands skills id into new ones at load time.
-        if (skill_ids[i] == 999)
-            skill_ids[i] = 30002;
-        else if (skill_ids[i] == 1000)
-            skill_ids[i] = 30001;
 
-        character->AddSkill(skill_ids[i]);
-    }
+bool GameGlobal::_ApplySaveGameData(const SaveGameData &data)
+{
+    _map_data_filename = data.map_data_filename;
+    _map_script_filename = data.map_script_filename;
 
-    //DEPRECATED: Will be removed in one release!
-    skill_ids.clear();
-    file.ReadUIntVector("weapon_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); i++) {
-        // DEPRECATED HACK: Remove that in one release.
-        // Turn old bare hands skills id into new ones at load time.
-        if (skill_ids[i] == 999)
-            skill_ids[i] = 30002;
-        else if (skill_ids[i] == 1000)
-            skill_ids[i] = 30001;
-
-        character->AddSkill(skill_ids[i]);
-    }
-    //DEPRECATED: Will be removed in one release!
-    skill_ids.clear();
-    file.ReadUIntVector("magic_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); ++i) {
-        character->AddSkill(skill_ids[i]);
-    }
-    //DEPRECATED: Will be removed in one release!
-    skill_ids.clear();
-    file.ReadUIntVector("special_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); ++i) {
-        character->AddSkill(skill_ids[i]);
-    }
-    //DEPRECATED: Will be removed in one release!
-    skill_ids.clear();
-    file.ReadUIntVector("bare_hands_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); ++i) {
-        character->AddSkill(skill_ids[i]);
-    }
+    // Load a potential saved position
+    _x_save_map_position = data.location_x;
+    _y_save_map_position = data.location_y;
+    SystemManager->SetPlayTime(data.play_hours, data.play_minutes, data.play_seconds);
+    _drunes = data.drunes;
 
-    // DEPRECATED: Remove in one release
-    skill_ids.clear();
-    file.ReadUIntVector("defense_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); ++i) {
-        character->AddSkill(skill_ids[i]);
-    }
-    // DEPRECATED: Remove in one release
-    file.ReadUIntVector("attack_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); i++) {
-        character->AddSkill(skill_ids[i]);
+    for(uint32 i = 0; i < SAVE_INVENTORY_CATEGORIES; ++i) {
+        for(uint32 j = 0; j < data.inventory[i].size(); ++j)
+            AddToInventory(data.inventory[i][j].first, data.inventory[i][j].second);
     }
-    // DEPRECATED: Remove in one release
-    skill_ids.clear();
-    file.ReadUIntVector("support_skills", skill_ids);
-    for(uint32 i = 0; i < skill_ids.size(); ++i) {
-        character->AddSkill(skill_ids[i]);
-    }
-
-    file.CloseTable(); // character id
-
-    AddCharacter(character);
-} // void GameGlobal::_LoadCharacter(ReadScriptDescriptor& file, uint32 id);
 
+    // Load characters into the party in the correct order
+    for(uint32 i = 0; i < data.characters.size(); ++i) {
+        const SaveCharacterData &character_data = data.characters[i];
 
+        // This loads all of the character's "static" data, such as their name, etc.
+        GlobalCharacter *character = new GlobalCharacter(character_data.id, false);
+        character->Enable(character_data.enabled);
 
-void GameGlobal::_LoadEvents(ReadScriptDescriptor &file, const std::string &group_name)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
+        character->SetExperienceLevel(character_data.experience_level);
+        character->SetExperiencePoints(character_data.experience_points);
+        character->_experience_for_next_level = character_data.experience_points_next;
 
-    AddNewEventGroup(group_name);
-    GlobalEventGroup *new_group = GetEventGroup(group_name); // new_group is guaranteed not to be NULL
+        character->SetMaxHitPoints(character_data.max_hit_points);
+        character->SetHitPoints(character_data.hit_points);
+        character->SetMaxSkillPoints(character_data.max_skill_points);
+        character->SetSkillPoints(character_data.skill_points);
 
-    std::vector<std::string> event_names;
+        character->SetStrength(character_data.strength);
+        character->SetVigor(character_data.vigor);
+        character->SetFortitude(character_data.fortitude);
+        character->SetProtection(character_data.protection);
+        character->SetAgility(character_data.agility);
+        character->SetEvade(character_data.evade);
 
-    if (file.OpenTable(group_name)) {
-        file.ReadTableKeys(event_names);
-        for(uint32 i = 0; i < event_names.size(); i++) {
-            new_group->AddNewEvent(event_names[i], file.ReadInt(event_names[i]));
-        }
-        file.CloseTable();
-    }
-    else {
-        PRINT_ERROR << "Invalid event group name '" << group_name << " in save file "
-                << file.GetFilename() << std::endl;
-    }
-}
-
-void GameGlobal::_LoadQuests(ReadScriptDescriptor &file, const std::string &quest_id)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
-    }
-    std::vector<std::string> quest_info;
-    //read the 4 entries into a new quest entry
-    file.ReadStringVector(quest_id, quest_info);
-    if(quest_info.size() != 2)
-    {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "save file has malformed quest log entries" << std::endl;
-        return;
-    }
+        // Equip the objects on the character as long as valid equipment IDs were read
+        if(character_data.weapon != 0)
+            character->EquipWeapon(new GlobalWeapon(character_data.weapon));
+        if(character_data.head_armor != 0)
+            character->EquipHeadArmor(new GlobalArmor(character_data.head_armor));
+        if(character_data.torso_armor != 0)
+            character->EquipTorsoArmor(new GlobalArmor(character_data.torso_armor));
+        if(character_data.arm_armor != 0)
+            character->EquipArmArmor(new GlobalArmor(character_data.arm_armor));
+        if(character_data.leg_armor != 0)
+            character->EquipLegArmor(new GlobalArmor(character_data.leg_armor));
 
-    //conversion of the log number from string int. We need to do thing because ReadStringVector assumes that
-    //all items are the same type.
-    uint32 quest_log_number = ::atoi(quest_info[0].c_str());
-    //conversion from string to bool for is_read flag
-    bool is_read = quest_info[1].compare("true") == 0;
+        for(uint32 j = 0; j < character_data.skills.size(); ++j)
+            character->AddSkill(character_data.skills[j]);
 
-    if(!_AddQuestLog(quest_id, quest_log_number, is_read))
-    {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "save file has duplicate quest log id entries" << std::endl;
-        return;
+        AddCharacter(character);
     }
-    //update the quest log count value if the current number is greater
-    if(_quest_log_count < quest_log_number)
-        _quest_log_count = quest_log_number;
 
-}
+    if(_characters.empty())
+        return false;
 
-void GameGlobal::_LoadWorldMap(vt_script::ReadScriptDescriptor &file)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "the file provided in the function argument was not open" << std::endl;
-        return;
+    for(uint32 i = 0; i < data.event_groups.size(); ++i) {
+        const SaveEventGroupData &group_data = data.event_groups[i];
+        AddNewEventGroup(group_data.name);
+        GlobalEventGroup *group = GetEventGroup(group_data.name); // group is guaranteed not to be NULL
+        for(uint32 j = 0; j < group_data.events.size(); ++j)
+            group->AddNewEvent(group_data.events[j].first, group_data.events[j].second);
     }
 
-    if (!file.OpenTable("worldmap")) {
-        // DEPRECATED! Old World map format. Removed in one release...
-        std::string world_map = file.ReadString("world_map");
-        SetWorldMap(world_map);
-
-        std::vector<std::string> location_ids;
-        file.ReadStringVector("viewable_locations", location_ids);
-        for(uint32 i = 0; i < location_ids.size(); ++i)
-            ShowWorldLocation(location_ids[i]);
-        return;
+    for(uint32 i = 0; i < data.quests.size(); ++i) {
+        const SaveQuestData &quest_data = data.quests[i];
+        if(!_AddQuestLog(quest_data.id, quest_data.log_number, quest_data.is_read)) {
+            IF_PRINT_WARNING(GLOBAL_DEBUG) << "save file has duplicate quest log id entries" << std::endl;
+            continue;
+        }
+        //update the quest log count value if the current number is greater
+        if(_quest_log_count < quest_data.log_number)
+            _quest_log_count = quest_data.log_number;
     }
 
-    std::string world_map = file.ReadString("world_map_file");
-    SetWorldMap(world_map);
-
-    std::vector<std::string> location_ids;
-    file.ReadStringVector("viewable_locations", location_ids);
-    for(uint32 i = 0; i < location_ids.size(); ++i)
-        ShowWorldLocation(location_ids[i]);
+    SetWorldMap(data.world_map_filename);
+    for(uint32 i = 0; i < data.viewable_locations.size(); ++i)
+        ShowWorldLocation(data.viewable_locations[i]);
+    if(!data.current_location.empty())
+        SetCurrentLocationId(data.current_location);
 
-    std::string current_location = file.ReadString("current_location");
-    if (!current_location.empty())
-        SetCurrentLocationId(current_location);
-
-    file.CloseTable(); // worldmap
-}
+    return true;
+} // bool GameGlobal::_ApplySaveGameData(const SaveGameData &data)
 
 bool GameGlobal::_LoadWorldLocationsScript(const std::string &world_locations_filename)
 {
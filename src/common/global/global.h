@@ -33,6 +33,7 @@
 #include "global_actors.h"
 #include "global_effects.h"
 #include "global_objects.h"
+#include "global_save.h"
 #include "global_skills.h"
 #include "global_utils.h"
 
@@ -50,6 +51,77 @@ extern GameGlobal *GlobalManager;
 //! \brief Determines whether the code in the vt_global namespace should print debug statements or not.
 extern bool GLOBAL_DEBUG;
 
+/** ****************************************************************************
+*** \brief The interned keys of the game events, and the values of those set
+***
+*** Each group and event name pair is given an integer key the first time it is
+*** requested. The key never changes afterwards, even when a new game is started
+*** or a saved game is loaded, so the scripts can request the keys of the events
+*** they check every frame once, and then query them without any string lookup.
+***
+*** The values of the events are stored here, indexed by their key, while the
+*** event groups only keep the names of their events.
+***
+*** \note The key 0 is never given to any event.
+*** ***************************************************************************/
+class GlobalEventTable
+{
+public:
+    GlobalEventTable();
+
+    /** \brief Returns the key of an event, creating it if it was never requested before
+    *** \note Requesting a key doesn't add the event to its group.
+    **/
+    uint32 GetKey(const std::string &group_name, const std::string &event_name);
+
+    //! \brief Tells whether the event of a given key is currently set.
+    bool IsSet(uint32 key) const {
+        return (key < _events.size() && _events[key].is_set);
+    }
+
+    //! \brief Returns the value of the event of a given key, or 0 if it isn't set.
+    int32 GetValue(uint32 key) const {
+        return IsSet(key) ? _events[key].value : 0;
+    }
+
+    //! \brief Sets the value of the event of a given key. Only the event groups should call this.
+    void SetValue(uint32 key, int32 value);
+
+    //! \brief Unsets the event of a given key, which keeps its key. Only the event groups should call this.
+    void Unset(uint32 key);
+
+    //! \brief Returns the group name of the event of a given key, or an empty string for invalid keys.
+    const std::string &GetGroupName(uint32 key) const;
+
+    //! \brief Returns the name of the event of a given key, or an empty string for invalid keys.
+    const std::string &GetEventName(uint32 key) const;
+
+    //! \brief Returns the number of keys given so far.
+    uint32 GetNumberKeys() const {
+        return _events.size() - 1;
+    }
+
+private:
+    //! \brief The names of an event, and its value.
+    class Event
+    {
+    public:
+        Event(const std::string &group, const std::string &name) :
+            group_name(group), event_name(name), value(0), is_set(false) {}
+
+        std::string group_name;
+        std::string event_name;
+        int32 value;
+        bool is_set;
+    };
+
+    //! \brief The events, indexed by their key. The first one is a placeholder for the invalid key.
+    std::vector<Event> _events;
+
+    //! \brief The keys given so far, by group name and event name.
+    std::map<std::string, std::map<std::string, uint32> > _keys;
+}; // class GlobalEventTable
+
 /** ****************************************************************************
 *** \brief A container that manages the occurences of several related game events
 ***
@@ -77,11 +149,15 @@ extern bool GLOBAL_DEBUG;
 class GlobalEventGroup
 {
 public:
-    //! \param group_name The name of the group to create (this can not be changed)
-    GlobalEventGroup(const std::string &group_name) :
-        _group_name(group_name) {}
+    /** \param group_name The name of the group to create (this can not be changed)
+    *** \param event_table The table storing the event values
+    **/
+    GlobalEventGroup(const std::string &group_name, GlobalEventTable *event_table) :
+        _group_name(group_name),
+        _event_table(event_table) {}
 
-    ~GlobalEventGroup() {}
+    //! \brief Unsets the events of the group, whose keys stay valid.
+    ~GlobalEventGroup();
 
     /** \brief Queries whether or not an event of a given name exists in the group
     *** \param event_name The name of the event to check for
@@ -124,8 +200,10 @@ public:
         return _group_name;
     }
 
-    //! \brief Returns an immutable reference to the private _events container
-    const std::map<std::string, int32>& GetEvents() const {
+    /** \brief Returns an immutable reference to the private _events container
+    *** The values of the events are given by GlobalEventTable::GetValue() from their keys.
+    **/
+    const std::map<std::string, uint32>& GetEvents() const {
         return _events;
     }
 
@@ -133,12 +211,14 @@ private:
     //! \brief The name given to this group of events
     std::string _group_name;
 
+    //! \brief The table storing the event values, owned by GameGlobal
+    GlobalEventTable *_event_table;
+
     /** \brief The map container for all the events in the group
     *** The string is the name of the event, which is unique within the group. The integer value
-    *** represents the event's state and can take on multiple meanings depending on the context
-    *** of this specific event.
+    *** is the key of the event in the event table, where its value is stored.
     **/
-    std::map<std::string, int32> _events;
+    std::map<std::string, uint32> _events;
 }; // class GlobalEventGroup
 
 /** ****************************************************************************
@@ -300,9 +380,9 @@ public:
 
     bool SingletonInitialize();
 
-    //! Reloads the persistent scripts. Used when changing the language for instance.
-    bool ReloadGlobalScripts()
-    { _CloseGlobalScripts(); return _LoadGlobalScripts(); }
+    //! Reloads the persistent scripts, and the object and skill definitions read from them.
+    //! Used when changing the language for instance.
+    bool ReloadGlobalScripts();
 
     /** \brief Deletes all data stored within the GameGlobal class object
     *** This function is meant to be called when the user quits the current game instance
@@ -518,6 +598,39 @@ public:
     *** \return The number of events in the group, or zero if no such group name existed
     **/
     uint32 GetNumberEvents(const std::string &group_name) const;
+
+    /** \brief Returns the key of an event, to query it afterwards without any string lookup
+    *** \param group_name The name of the event group where the event is contained
+    *** \param event_name The name of the event
+    *** \return The event key, which stays valid until the game exits, even when the event doesn't exist yet
+    ***
+    *** Scripts checking the same events often should request their keys once, when loading:
+    *** local key = GlobalManager:GetEventKey("story", "kalya_has_joined");
+    *** and then call GlobalManager:GetEventValue(key) when needed.
+    **/
+    uint32 GetEventKey(const std::string &group_name, const std::string &event_name) {
+        return _event_table.GetKey(group_name, event_name);
+    }
+
+    //! \brief Determines if the event of a given key exists.
+    bool DoesEventExist(uint32 event_key) const {
+        return _event_table.IsSet(event_key);
+    }
+
+    //! \brief Returns the value of the event of a given key, or 0 if the event was not found.
+    int32 GetEventValue(uint32 event_key) const {
+        return _event_table.GetValue(event_key);
+    }
+
+    /** \brief Set the value of the event of a given key
+    *** \note Events and event groups will be created when necessary.
+    **/
+    void SetEventValue(uint32 event_key, int32 event_value);
+
+    //! \brief Returns the number of event keys requested so far.
+    uint32 GetNumberEventKeys() const {
+        return _event_table.GetNumberKeys();
+    }
     //@}
 
     //! \name Quest Log Entry methods
@@ -739,17 +852,55 @@ public:
     *** \param slot_id The game slot id used for the save menu.
     *** \param positions When used in a save point, the save map tile positions are given there.
     *** \return True if the game was successfully saved, false if it was not
+    ***
+    *** The game data is copied right away, and the binary file is written in the background:
+    *** IsSavingGame() and WaitForSaveGame() tell when it is done and whether it succeeded.
+    *** A filename ending with ".lua" is written at once, in the Lua format.
     **/
     bool SaveGame(const std::string &filename, uint32 slot_id, uint32 x_position = 0, uint32 y_position = 0);
 
+    //! \brief Tells whether the last saved game file is still being written.
+    bool IsSavingGame() const {
+        return _save_writer.IsWriting();
+    }
+
+    /** \brief Waits until the last saved game file is written
+    *** \return True if the last saved game file was successfully written
+    **/
+    bool WaitForSaveGame() {
+        return _save_writer.Wait();
+    }
+
     /** \brief Loads all global data from a saved game file
-    *** \param filename The filename of the saved game file where to read the data from
+    *** \param filename The filename of the saved game file where to read the data from,
+    *** either in the binary or in the Lua format
     *** \param slot_id The save slot the file correspond to. Used to set the correct cursor position
     *** when further saving.
     *** \return True if the game was successfully loaded, false if it was not
     **/
     bool LoadGame(const std::string &filename, uint32 slot_id);
 
+    //! \brief Returns the filename where a save slot is written, in the binary format.
+    static std::string GetSaveSlotFilename(uint32 slot_id);
+
+    /** \brief Returns the saved game file of a save slot, or an empty string when the slot is empty
+    *** The slots only saved by the former versions of the game are found in the Lua format.
+    **/
+    static std::string FindSaveSlotFilename(uint32 slot_id);
+
+    //! \brief Returns the filename of the preview written next to a save slot.
+    static std::string GetSavePreviewFilename(uint32 slot_id);
+
+    /** \brief Reads the data shown by the save menu for a save slot
+    *** \param slot_id The save slot to preview.
+    *** \param preview Filled with the preview data.
+    *** \return false if the slot is empty, or if its saved game or map is invalid.
+    ***
+    *** The preview file is read when it is up to date with the saved game.
+    *** Otherwise, the whole saved game is read and the preview file rewritten.
+    **/
+    bool ReadSaveSlotPreview(uint32 slot_id, private_global::SavePreviewData &preview);
+
     uint32 GetGameSlotId() const {
         return _game_slot_id;
     }
@@ -870,6 +1021,11 @@ public:
         return &_inventory_spirits;
     }
 
+    //! \brief Returns the object and skill definitions read from the scripts below.
+    private_global::DefinitionRegistry &GetDefinitions() {
+        return _definitions;
+    }
+
     vt_script::ReadScriptDescriptor &GetItemsScript() {
         return _items_script;
     }
@@ -1097,11 +1253,20 @@ private:
     vt_script::ReadScriptDescriptor _map_treasures_script;
     //@}
 
+    //! \brief The object and skill data, read once from the scripts above.
+    private_global::DefinitionRegistry _definitions;
+
     /** \brief The container which stores all of the groups of events that have occured in the game
     *** The name of each GlobalEventGroup object serves as its key in this map data structure.
     **/
     std::map<std::string, GlobalEventGroup *> _event_groups;
 
+    //! \brief The event keys and values of the groups above.
+    GlobalEventTable _event_table;
+
+    //! \brief Writes the saved games in the background.
+    private_global::SaveGameWriter _save_writer;
+
     /** \brief The container which stores the quest log entries in the game. the quest log key
     *** acts as the key for this quest
     *** \note due to a limitation with OptionBoxes, we can only currently only support 255
@@ -1154,29 +1319,6 @@ private:
     **/
     template <class T> T *_RetrieveFromInventory(uint32 obj_id, std::vector<T *>& inv, bool all_counts);
 
-    /** \brief A helper function to GameGlobal::SaveGame() that stores the contents of a type of inventory to the saved game file
-    *** \param file A reference to the open and valid file where to write the inventory list
-    *** \param name The name under which this set of inventory data should be categorized (ie "items", "weapons", etc)
-    *** \param inv A reference to the inventory vector to store
-    *** \note The class type T must be a derived class of GlobalObject
-    **/
-    template <class T> void _SaveInventory(vt_script::WriteScriptDescriptor &file, const std::string &name, std::vector<T *>& inv);
-
-    /** \brief A helper function to GameGlobal::SaveGame() that writes character data to the saved game file
-    *** \param file A reference to the open and valid file where to write the character data
-    *** \param objects A ponter to the character whose data should be saved
-    *** \param last Set to true if this is the final character that needs to be saved
-    *** This method will need to be called once for each character in the player's party
-    **/
-    void _SaveCharacter(vt_script::WriteScriptDescriptor &file, GlobalCharacter *character, bool last);
-
-    /** \brief A helper function to GameGlobal::SaveGame() that writes a group of event data to the saved game file
-    *** \param file A reference to the open and valid file where to write the event data
-    *** \param event_group A pointer to the group of events to store
-    *** This method will need to be called once for each GlobalEventGroup contained by this class.
-    **/
-    void _SaveEvents(vt_script::WriteScriptDescriptor &file, GlobalEventGroup *event_group);
-
     /** \brief adds a new quest log entry into the quest log entries table. also updates the quest log number
     *** \param quest_id for the quest
     *** \param the quest entry's log number
@@ -1195,46 +1337,22 @@ private:
         return true;
     }
 
-    /** \brief Helper function that saves the Quest Log entries. this is called from SaveGame()
-    *** \param file Reference to open and valid file set for writting the data
-    *** \param the quest log entry we wish to write
-    **/
-    void _SaveQuests(vt_script::WriteScriptDescriptor &file, const QuestLogEntry *quest_log_entry);
-
-    /** \brief saves the world map information. this is called from SaveGame()
-    *** \param file Reference to open and valid file for writting the data
-    **/
-    void _SaveWorldMap(vt_script::WriteScriptDescriptor &file);
-
-    /** \brief A helper function to GameGlobal::LoadGame() that restores the contents of the inventory from a saved game file
-    *** \param file A reference to the open and valid file from where to read the inventory list
-    *** \param category_name The name of the table in the file that should contain the inventory for a specific category
-    **/
-    void _LoadInventory(vt_script::ReadScriptDescriptor &file, const std::string &category_name);
+    //! \brief Copies the data stored in a saved game. The save position is given in map tiles.
+    void _CreateSaveGameData(private_global::SaveGameData &data, uint32 x_position, uint32 y_position);
 
-    /** \brief A helper function to GameGlobal::LoadGame() that loads a saved game character and adds it to the party
-    *** \param file A reference to the open and valid file from where to read the character from
-    *** \param id The character's integer ID, used to find and restore the character data
+    /** \brief Replaces the game data with the one of a saved game
+    *** \return false if no characters could be added.
     **/
-    void _LoadCharacter(vt_script::ReadScriptDescriptor &file, uint32 id);
+    bool _ApplySaveGameData(const private_global::SaveGameData &data);
 
-    /** \brief A helper function to GameGlobal::LoadGame() that loads a group of game events from a saved game file
-    *** \param file A reference to the open and valid file from where to read the event data from
-    *** \param group_name The name of the event group to load
+    /** \brief Copies the data shown by the save menu for a saved game
+    *** The names and portraits are taken from the party characters, or from
+    *** the character definitions when they aren't in the party.
     **/
-    void _LoadEvents(vt_script::ReadScriptDescriptor &file, const std::string &group_name);
-
-    /** \brief Helper function called by LoadGame() that loads each quest into the quest entry table based on the quest_entry_keys
-    *** in the save game file
-    *** \param file Reference to open and valid file set for reading the data
-    *** \param reference to the quest entry key
-    **/
-    void _LoadQuests(vt_script::ReadScriptDescriptor &file, const std::string &quest_key);
-
-    /** \brief Load world map and viewable information from the save game
-    *** \param file Reference to an open file for reading save game data
-    **/
-    void _LoadWorldMap(vt_script::ReadScriptDescriptor &file);
+    void _CreateSavePreviewData(const private_global::SaveGameData &data,
+                                const vt_utils::ustring &map_hud_name,
+                                const std::string &map_image_filename,
+                                private_global::SavePreviewData &preview);
 
     /** \brief Helper function called by LoadGlobalScripts() that (re)loads each world location from the script into the world location entry map
     *** \param file Path to the file to world locations script
@@ -1295,40 +1413,6 @@ template <class T> T *GameGlobal::_RetrieveFromInventory(uint32 obj_id, std::vec
     return NULL;
 } // template <class T> T* GameGlobal::_RetrieveFromInventory(uint32 obj_id, std::vector<T*>& inv, bool all_counts)
 
-
-
-template <class T> void GameGlobal::_SaveInventory(vt_script::WriteScriptDescriptor &file, const std::string &name, std::vector<T *>& inv)
-{
-    if(file.IsFileOpen() == false) {
-        IF_PRINT_WARNING(GLOBAL_DEBUG) << "failed because the argument file was not open" << std::endl;
-        return;
-    }
-
-    file.InsertNewLine();
-    file.WriteLine(name + " = {");
-    for(uint32 i = 0; i < inv.size(); i++) {
-        // Don't save inventory items with 0 count
-        if(inv[i]->GetCount() == 0)
-            continue;
-
-        if(i == 0)
-            file.WriteLine("\t", false);
-        else
-            file.WriteLine(", ", false);
-
-        // Add a new line every 10 entries for better readability and debugging
-        if ((i > 0) && !(i % 10)) {
-            file.InsertNewLine();
-            file.WriteLine("\t", false);
-        }
-
-        file.WriteLine("[" + vt_utils::NumberToString(inv[i]->GetID()) + "] = "
-                       + vt_utils::NumberToString(inv[i]->GetCount()), false);
-    }
-    file.InsertNewLine();
-    file.WriteLine("},");
-} // template <class T> void GameGlobal::_SaveInventory(vt_script::WriteScriptDescriptor& file, std::string name, std::vector<T*>& inv)
-
 } // namespace vt_global
 
 #endif // __GLOBAL_HEADER__
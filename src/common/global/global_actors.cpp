@@ -25,6 +25,7 @@
 
 #include "common/global/global.h"
 
+
 #include "utils/utils_files.h"
 #include "utils/utils_random.h"
 
@@ -1086,6 +1087,7 @@ void GlobalCharacter::_UpdateEquipmentStatusEffects()
             }
 
             try {
+                ScriptCallScope call(remove_passive_function);
                 ScriptCallFunction<void>(remove_passive_function, this);
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while loading status effect RemovePassive() function" << std::endl;
@@ -1112,6 +1114,7 @@ void GlobalCharacter::_UpdateEquipmentStatusEffects()
             }
 
             try {
+                ScriptCallScope call(apply_passive_function);
                 ScriptCallFunction<void>(apply_passive_function, this, intensity);
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while loading status effect ApplyPassive() function" << std::endl;
@@ -1280,6 +1283,7 @@ void GlobalCharacter::AcknowledgeGrowth() {
 
     try {
         // Update Growth data and set XP for next level
+        ScriptCallScope call(character_script.GetLuaState(), "DetermineLevelGrowth");
         ScriptCallFunction<void>(character_script.GetLuaState(), "DetermineLevelGrowth", this);
     } catch(const luabind::error& e) {
         ScriptManager->HandleLuaError(e);
@@ -1290,6 +1294,7 @@ void GlobalCharacter::AcknowledgeGrowth() {
     // Reset the skills learned container and add any skills learned at this level
     _new_skills_learned.clear();
     try {
+        ScriptCallScope call(character_script.GetLuaState(), "DetermineNewSkillsLearned");
         ScriptCallFunction<void>(character_script.GetLuaState(), "DetermineNewSkillsLearned", this);
     } catch(const luabind::error& e) {
         ScriptManager->HandleLuaError(e);
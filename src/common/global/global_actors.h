@@ -734,10 +734,10 @@ class GlobalCharacter : public GlobalActor
 {
     friend void vt_defs::BindCommonCode();
     // TODO: investigate whether we can replace declaring the entire GameGlobal class as a friend with declaring
-    // the GameGlobal::_SaveCharacter and GameGlobal::_LoadCharacter methods instead.
+    // the GameGlobal::_CreateSaveGameData and GameGlobal::_ApplySaveGameData methods instead.
     friend class GameGlobal;
-//     friend void GameGlobal::_SaveCharacter(vt_script::WriteScriptDescriptor &file, GlobalCharacter *character, bool last);
-//     friend void GameGlobal::_LoadCharacter(vt_script::ReadScriptDescriptor &file, uint32 id);
+//     friend void GameGlobal::_CreateSaveGameData(private_global::SaveGameData &data, uint32 x_position, uint32 y_position);
+//     friend bool GameGlobal::_ApplySaveGameData(const private_global::SaveGameData &data);
 public:
     /** \brief Constructs a new character from its definition in a script file
     *** \param id The integer ID of the character to create
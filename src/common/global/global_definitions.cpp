@@ -0,0 +1,384 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    global_definitions.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the shared definitions of the objects and skills
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "global_definitions.h"
+
+#include "global.h"
+
+#include "engine/script/script.h"
+
+using namespace vt_utils;
+using namespace vt_script;
+
+namespace vt_global
+{
+
+namespace private_global
+{
+
+//! \brief Returns the definition file of an object type.
+static ReadScriptDescriptor &GetObjectScript(GLOBAL_OBJECT type)
+{
+    switch(type) {
+    default:
+    case GLOBAL_OBJECT_ITEM:
+        return GlobalManager->GetItemsScript();
+    case GLOBAL_OBJECT_WEAPON:
+        return GlobalManager->GetWeaponsScript();
+    case GLOBAL_OBJECT_HEAD_ARMOR:
+        return GlobalManager->GetHeadArmorScript();
+    case GLOBAL_OBJECT_TORSO_ARMOR:
+        return GlobalManager->GetTorsoArmorScript();
+    case GLOBAL_OBJECT_ARM_ARMOR:
+        return GlobalManager->GetArmArmorScript();
+    case GLOBAL_OBJECT_LEG_ARMOR:
+        return GlobalManager->GetLegArmorScript();
+    case GLOBAL_OBJECT_SPIRIT:
+        return GlobalManager->GetSpiritsScript();
+    }
+}
+
+//! \brief Compares the status effect id, used to sort them.
+static bool CompareStatusEffects(std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY> one, std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY> other)
+{
+    uint32 status1 = one.first;
+    uint32 status2 = other.first;
+    return (status1 < status2);
+}
+
+//! \brief Reads the status effects of an equipment.
+static void ReadStatusEffects(ReadScriptDescriptor &script, ObjectDefinition &definition)
+{
+    if(!script.DoesTableExist("status_effects"))
+        return;
+
+    std::vector<int32> status_effects;
+    script.ReadTableKeys("status_effects", status_effects);
+
+    if(status_effects.empty())
+        return;
+
+    script.OpenTable("status_effects");
+
+    for(uint32 i = 0; i < status_effects.size(); ++i) {
+
+        int32 key = status_effects[i];
+        if(key <= GLOBAL_STATUS_INVALID || key >= GLOBAL_STATUS_TOTAL)
+            continue;
+
+        int32 intensity = script.ReadInt(key);
+        // Note: The intensity of a status effect can only be positive
+        if(intensity <= GLOBAL_INTENSITY_INVALID || intensity >= GLOBAL_INTENSITY_TOTAL)
+            continue;
+
+        definition.status_effects.push_back(std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY>((GLOBAL_STATUS)key, (GLOBAL_INTENSITY)intensity));
+    }
+    // Make the effects be always presented in the same order.
+    std::sort(definition.status_effects.begin(), definition.status_effects.end(), CompareStatusEffects);
+
+    script.CloseTable(); // status_effects
+}
+
+//! \brief Reads the trade price and conditions of an object.
+static void ReadTradeConditions(ReadScriptDescriptor &script, ObjectDefinition &definition)
+{
+    if(!script.DoesTableExist("trade_conditions"))
+        return;
+
+    std::vector<uint32> temp;
+    script.ReadTableKeys("trade_conditions", temp);
+
+    if(temp.empty())
+        return;
+
+    script.OpenTable("trade_conditions");
+
+    for(uint32 i = 0; i < temp.size(); ++i) {
+        uint32 key = temp[i];
+        uint32 quantity = script.ReadInt(key);
+
+        // Set the trade price
+        if (key == 0)
+            definition.trade_price = quantity;
+        else // Or the conditions.
+            definition.trade_conditions.push_back(std::pair<uint32, uint32>(key, quantity));
+    }
+
+    script.CloseTable(); // trade_conditions
+}
+
+//! \brief Reads the battle animations of a weapon for each character that can use it.
+static void ReadWeaponBattleAnimations(ReadScriptDescriptor &script, ObjectDefinition &definition)
+{
+    // The character id keys
+    std::vector<uint32> char_ids;
+
+    script.ReadTableKeys("battle_animations", char_ids);
+    if (char_ids.empty())
+        return;
+
+    if (!script.OpenTable("battle_animations"))
+        return;
+
+    for (uint32 i = 0; i < char_ids.size(); ++i) {
+        uint32 char_id = char_ids[i];
+
+        // Read all the animation aliases
+        std::vector<std::string> anim_aliases;
+        script.ReadTableKeys(char_id, anim_aliases);
+
+        if (anim_aliases.empty())
+            continue;
+
+        if (!script.OpenTable(char_id))
+            continue;
+
+        for (uint32 j = 0; j < anim_aliases.size(); ++j) {
+            std::string anim_alias = anim_aliases[j];
+            std::string anim_file = script.ReadString(anim_alias);
+            definition.weapon_animations[char_id].insert(std::make_pair(anim_alias, anim_file));
+        }
+
+        script.CloseTable(); // char_id
+    }
+
+    script.CloseTable(); // battle_animations
+}
+
+//! \brief Reads the spirit slots number of an equipment.
+static uint32 ReadSpiritSlots(ReadScriptDescriptor &script, uint32 id)
+{
+    uint32 spirits_number = script.ReadUInt("slots");
+    // Only permit a max of 5 spirits for equipment
+    if (spirits_number > 5) {
+        spirits_number = 5;
+        PRINT_WARNING << "More than 5 spirit slots declared in item " << id << std::endl;
+    }
+    return spirits_number;
+}
+
+DefinitionRegistry::~DefinitionRegistry()
+{
+    for(uint32 i = 0; i < GLOBAL_OBJECT_TOTAL; ++i) {
+        for(std::map<uint32, ObjectDefinition *>::iterator it = _objects[i].begin(); it != _objects[i].end(); ++it)
+            delete it->second;
+        _objects[i].clear();
+    }
+
+    for(std::map<uint32, SkillDefinition *>::iterator it = _skills.begin(); it != _skills.end(); ++it)
+        delete it->second;
+    _skills.clear();
+}
+
+const ObjectDefinition *DefinitionRegistry::GetObjectDefinition(GLOBAL_OBJECT type, uint32 id)
+{
+    ++_number_lookups;
+
+    if(type <= GLOBAL_OBJECT_INVALID || type >= GLOBAL_OBJECT_TOTAL)
+        type = GLOBAL_OBJECT_ITEM;
+
+    std::map<uint32, ObjectDefinition *>::const_iterator it = _objects[type].find(id);
+    if(it != _objects[type].end())
+        return it->second;
+
+    ObjectDefinition *definition = new ObjectDefinition(id);
+    _ReadObjectDefinition(type, *definition);
+    _objects[type].insert(std::make_pair(id, definition));
+    return definition;
+}
+
+const SkillDefinition *DefinitionRegistry::GetSkillDefinition(uint32 id)
+{
+    ++_number_lookups;
+
+    std::map<uint32, SkillDefinition *>::const_iterator it = _skills.find(id);
+    if(it != _skills.end())
+        return it->second;
+
+    SkillDefinition *definition = new SkillDefinition(id);
+    _ReadSkillDefinition(*definition);
+    _skills.insert(std::make_pair(id, definition));
+    return definition;
+}
+
+void DefinitionRegistry::ReloadDefinitions()
+{
+    for(uint32 i = 0; i < GLOBAL_OBJECT_TOTAL; ++i) {
+        for(std::map<uint32, ObjectDefinition *>::iterator it = _objects[i].begin(); it != _objects[i].end(); ++it) {
+            *(it->second) = ObjectDefinition(it->first);
+            _ReadObjectDefinition(static_cast<GLOBAL_OBJECT>(i), *(it->second));
+        }
+    }
+
+    for(std::map<uint32, SkillDefinition *>::iterator it = _skills.begin(); it != _skills.end(); ++it) {
+        *(it->second) = SkillDefinition(it->first);
+        _ReadSkillDefinition(*(it->second));
+    }
+}
+
+void DefinitionRegistry::_ReadObjectDefinition(GLOBAL_OBJECT type, ObjectDefinition &definition)
+{
+    ++_number_reads;
+
+    // Only the missing items are always reported.
+    bool print_warnings = (type == GLOBAL_OBJECT_ITEM) || GLOBAL_DEBUG;
+
+    ReadScriptDescriptor &script = GetObjectScript(type);
+    if(!script.DoesTableExist(definition.id)) {
+        IF_PRINT_WARNING(print_warnings) << "no valid data for object in definition file: " << definition.id << std::endl;
+        definition.id = 0;
+        return;
+    }
+
+    script.OpenTable(definition.id);
+
+    definition.name = MakeUnicodeString(script.ReadString("name"));
+    definition.description = MakeUnicodeString(script.ReadString("description"));
+    definition.price = script.ReadUInt("standard_price");
+    ReadTradeConditions(script, definition);
+    std::string icon_file = script.ReadString("icon");
+    if(script.DoesBoolExist("key_item"))
+        definition.is_key_item = script.ReadBool("key_item");
+    if(!definition.icon_image.Load(icon_file)) {
+        PRINT_WARNING << "failed to load icon image for item: " << definition.id << std::endl;
+
+        // try a default icon in that case
+        definition.icon_image.Load("img/icons/battle/default_special.png");
+    }
+
+    switch(type) {
+    case GLOBAL_OBJECT_ITEM:
+        definition.target_type = static_cast<GLOBAL_TARGET>(script.ReadInt("target_type"));
+        definition.warmup_time = script.ReadUInt("warmup_time");
+        definition.cooldown_time = script.ReadUInt("cooldown_time");
+
+        definition.battle_use_function = script.ReadFunctionPointer("BattleUse");
+        definition.field_use_function = script.ReadFunctionPointer("FieldUse");
+        break;
+    case GLOBAL_OBJECT_WEAPON:
+        ReadStatusEffects(script, definition);
+        if(script.DoesTableExist("equipment_skills"))
+            script.ReadUIntVector("equipment_skills", definition.equipment_skills);
+
+        definition.physical_value = script.ReadUInt("physical_attack");
+        definition.magical_value = script.ReadUInt("magical_attack");
+        definition.usable_by = script.ReadUInt("usable_by");
+        definition.spirit_slots = ReadSpiritSlots(script, definition.id);
+
+        // Load the possible battle ammo animated image filename.
+        definition.ammo_image_file = script.ReadString("battle_ammo_animation_file");
+
+        // Load the weapon battle animation info
+        if(script.DoesTableExist("battle_animations"))
+            ReadWeaponBattleAnimations(script, definition);
+        break;
+    case GLOBAL_OBJECT_HEAD_ARMOR:
+    case GLOBAL_OBJECT_TORSO_ARMOR:
+    case GLOBAL_OBJECT_ARM_ARMOR:
+    case GLOBAL_OBJECT_LEG_ARMOR:
+        ReadStatusEffects(script, definition);
+        if(script.DoesTableExist("equipment_skills"))
+            script.ReadUIntVector("equipment_skills", definition.equipment_skills);
+
+        definition.physical_value = script.ReadUInt("physical_defense");
+        definition.magical_value = script.ReadUInt("magical_defense");
+        definition.usable_by = script.ReadUInt("usable_by");
+        definition.spirit_slots = ReadSpiritSlots(script, definition.id);
+        break;
+    default:
+        break;
+    }
+
+    script.CloseTable(); // id
+    if(script.IsErrorDetected()) {
+        IF_PRINT_WARNING(print_warnings) << "one or more errors occurred while reading object data - they are listed below"
+                      << std::endl << script.GetErrorMessages() << std::endl;
+        definition.id = 0;
+    }
+}
+
+void DefinitionRegistry::_ReadSkillDefinition(SkillDefinition &definition)
+{
+    ++_number_reads;
+
+    // A pointer to the skill script which will be used to load this skill
+    ReadScriptDescriptor *skill_script = NULL;
+
+    uint32 id = definition.id;
+    if((id > 0) && (id <= MAX_WEAPON_SKILL_ID)) {
+        definition.type = GLOBAL_SKILL_WEAPON;
+        skill_script = &(GlobalManager->GetWeaponSkillsScript());
+    } else if((id > MAX_WEAPON_SKILL_ID) && (id <= MAX_MAGIC_SKILL_ID)) {
+        definition.type = GLOBAL_SKILL_MAGIC;
+        skill_script = &(GlobalManager->GetMagicSkillsScript());
+    } else if((id > MAX_MAGIC_SKILL_ID) && (id <= MAX_SPECIAL_SKILL_ID)) {
+        definition.type = GLOBAL_SKILL_SPECIAL;
+        skill_script = &(GlobalManager->GetSpecialSkillsScript());
+    } else if((id > MAX_SPECIAL_SKILL_ID) && (id <= MAX_BARE_HANDS_SKILL_ID)) {
+        definition.type = GLOBAL_SKILL_BARE_HANDS;
+        skill_script = &(GlobalManager->GetBareHandsSkillsScript());
+    } else {
+        IF_PRINT_WARNING(GLOBAL_DEBUG) << "constructor received an invalid id argument: " << id << std::endl;
+        definition.id = 0; // Indicate that this skill is invalid
+        return;
+    }
+
+    // Load the skill properties from the script
+    if(!skill_script->DoesTableExist(id)) {
+        PRINT_WARNING << "No valid data for skill in definition file: " << id << std::endl;
+        definition.id = 0; // Indicate that this skill is invalid
+        return;
+    }
+
+    skill_script->OpenTable(id);
+    definition.name = MakeUnicodeString(skill_script->ReadString("name"));
+    if(skill_script->DoesStringExist("description"))
+        definition.description = MakeUnicodeString(skill_script->ReadString("description"));
+    if(skill_script->DoesStringExist("icon"))
+        definition.icon_filename = skill_script->ReadString("icon");
+    definition.sp_required = skill_script->ReadUInt("sp_required");
+    definition.warmup_time = skill_script->ReadUInt("warmup_time");
+    definition.cooldown_time = skill_script->ReadUInt("cooldown_time");
+    definition.warmup_action_name = skill_script->ReadString("warmup_action_name");
+    definition.action_name = skill_script->ReadString("action_name");
+    definition.target_type = static_cast<GLOBAL_TARGET>(skill_script->ReadInt("target_type"));
+
+    definition.battle_execute_function = skill_script->ReadFunctionPointer("BattleExecute");
+    definition.field_execute_function = skill_script->ReadFunctionPointer("FieldExecute");
+
+    // Read all the battle animation scripts linked to this skill, if any
+    if(skill_script->DoesTableExist("animation_scripts")) {
+        std::vector<uint32> characters_ids;
+        skill_script->ReadTableKeys("animation_scripts", characters_ids);
+        skill_script->OpenTable("animation_scripts");
+        for(uint32 i = 0; i < characters_ids.size(); ++i) {
+            definition.animation_scripts[characters_ids[i]] = skill_script->ReadString(characters_ids[i]);
+        }
+        skill_script->CloseTable(); // animation_scripts table
+    }
+
+    skill_script->CloseTable(); // id.
+
+    if(skill_script->IsErrorDetected()) {
+        PRINT_WARNING << "One or more errors occurred while reading skill data - they are listed below:	"
+                      << std::endl << skill_script->GetErrorMessages() << std::endl;
+        definition.id = 0; // Indicate that this skill is invalid
+    }
+}
+
+} // namespace private_global
+
+} // namespace vt_global
@@ -0,0 +1,215 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    global_definitions.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the shared definitions of the objects and skills
+***
+*** The data of an object or a skill never changes once read from its script
+*** table, while the shops, treasures, battles and inventory create many
+*** instances of them. Each table is thus read once into a definition shared
+*** by every instance, which only keeps its own count and state.
+*** ***************************************************************************/
+
+#ifndef __GLOBAL_DEFINITIONS_HEADER__
+#define __GLOBAL_DEFINITIONS_HEADER__
+
+#include "global_utils.h"
+
+#include "engine/video/image.h"
+#include "engine/script/script.h"
+
+#include "utils/ustring.h"
+
+namespace vt_script {
+class ReadScriptDescriptor;
+}
+
+namespace vt_global
+{
+
+namespace private_global
+{
+
+/** ****************************************************************************
+*** \brief The data of an object, as read from its definition table
+***
+*** The same class is used for every object type, the members not relevant to
+*** a type being left to their default value.
+*** ***************************************************************************/
+class ObjectDefinition
+{
+public:
+    ObjectDefinition(uint32 object_id) :
+        id(object_id),
+        is_key_item(false),
+        price(0),
+        trade_price(0),
+        target_type(GLOBAL_TARGET_INVALID),
+        warmup_time(0),
+        cooldown_time(0),
+        physical_value(0),
+        magical_value(0),
+        usable_by(0),
+        spirit_slots(0)
+    {}
+
+    //! \brief The object id, 0 when the definition couldn't be read.
+    uint32 id;
+
+    //! \name Common object data
+    //@{
+    vt_utils::ustring name;
+    vt_utils::ustring description;
+    bool is_key_item;
+    uint32 price;
+    uint32 trade_price;
+    std::vector<std::pair<uint32, uint32> > trade_conditions;
+    vt_video::StillImage icon_image;
+    //@}
+
+    //! \name Item data
+    //@{
+    GLOBAL_TARGET target_type;
+    uint32 warmup_time;
+    uint32 cooldown_time;
+    ScriptObject battle_use_function;
+    ScriptObject field_use_function;
+    //@}
+
+    //! \name Equipment data
+    //@{
+    //! \brief The physical and magical attack of weapons, or defense of armor.
+    uint32 physical_value;
+    uint32 magical_value;
+    uint32 usable_by;
+    uint32 spirit_slots;
+    std::vector<std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY> > status_effects;
+    std::vector<uint32> equipment_skills;
+    //@}
+
+    //! \name Weapon data
+    //@{
+    std::string ammo_image_file;
+    //! \brief map < character_id, map < animation alias, animation filename > >
+    std::map<uint32, std::map<std::string, std::string> > weapon_animations;
+    //@}
+}; // class ObjectDefinition
+
+//! \brief The data of a skill, as read from its definition table.
+class SkillDefinition
+{
+public:
+    SkillDefinition(uint32 skill_id) :
+        id(skill_id),
+        type(GLOBAL_SKILL_INVALID),
+        sp_required(0),
+        warmup_time(0),
+        cooldown_time(0),
+        target_type(GLOBAL_TARGET_INVALID)
+    {}
+
+    //! \brief The skill id, 0 when the definition couldn't be read.
+    uint32 id;
+
+    GLOBAL_SKILL type;
+    vt_utils::ustring name;
+    vt_utils::ustring description;
+    std::string icon_filename;
+    uint32 sp_required;
+    uint32 warmup_time;
+    uint32 cooldown_time;
+    std::string warmup_action_name;
+    std::string action_name;
+    GLOBAL_TARGET target_type;
+    ScriptObject battle_execute_function;
+    ScriptObject field_execute_function;
+    std::map<uint32, std::string> animation_scripts;
+}; // class SkillDefinition
+
+/** ****************************************************************************
+*** \brief Reads and keeps the definitions of the objects and skills
+***
+*** A definition is read from its script table the first time an instance of
+*** it is created, and kept until the game exits. The definitions are never
+*** deleted nor moved meanwhile, so that the instances can keep a pointer to
+*** them: when the global scripts are reloaded, the definitions are read again
+*** in place instead.
+***
+*** \note The definitions are read through the global Lua state, which must
+*** only be used by the main thread, so they aren't read in parallel.
+*** ***************************************************************************/
+class DefinitionRegistry
+{
+public:
+    DefinitionRegistry() :
+        _invalid_object(0),
+        _number_reads(0),
+        _number_lookups(0)
+    {}
+
+    ~DefinitionRegistry();
+
+    /** \brief Returns the definition of an object, reading it if needed
+    *** \param type The object type, telling which definition file to read from.
+    *** The armor types all share the same file per type.
+    *** \param id The object id, which must be valid for the type
+    *** \return The definition, whose id is 0 when it couldn't be read. Never NULL.
+    **/
+    const ObjectDefinition *GetObjectDefinition(GLOBAL_OBJECT type, uint32 id);
+
+    /** \brief Returns the definition of a skill, reading it if needed
+    *** \return The definition, whose id is 0 when it couldn't be read. Never NULL.
+    **/
+    const SkillDefinition *GetSkillDefinition(uint32 id);
+
+    //! \brief Returns an empty definition, used by the objects before reading theirs.
+    const ObjectDefinition *GetInvalidObjectDefinition() const {
+        return &_invalid_object;
+    }
+
+    //! \brief Reads every definition already read again, to update their translated texts.
+    void ReloadDefinitions();
+
+    //! \brief Returns the number of script tables read, and of definitions requested.
+    uint32 GetNumberReads() const {
+        return _number_reads;
+    }
+
+    uint32 GetNumberLookups() const {
+        return _number_lookups;
+    }
+
+private:
+    //! \brief The definitions read so far per object type and id, including the invalid ones.
+    std::map<uint32, ObjectDefinition *> _objects[GLOBAL_OBJECT_TOTAL];
+
+    //! \brief The skill definitions read so far per id, including the invalid ones.
+    std::map<uint32, SkillDefinition *> _skills;
+
+    //! \brief The empty object definition.
+    ObjectDefinition _invalid_object;
+
+    //! \brief Statistics about the registry use.
+    uint32 _number_reads;
+    uint32 _number_lookups;
+
+    //! \brief Reads an object definition from its script table, invalidating it on errors.
+    void _ReadObjectDefinition(GLOBAL_OBJECT type, ObjectDefinition &definition);
+
+    //! \brief Reads a skill definition from its script table, invalidating it on errors.
+    void _ReadSkillDefinition(SkillDefinition &definition);
+}; // class DefinitionRegistry
+
+} // namespace private_global
+
+} // namespace vt_global
+
+#endif // __GLOBAL_DEFINITIONS_HEADER__
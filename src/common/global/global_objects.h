@@ -21,16 +21,7 @@
 #ifndef __GLOBAL_OBJECTS_HEADER__
 #define __GLOBAL_OBJECTS_HEADER__
 
-#include "global_utils.h"
-
-#include "engine/video/image.h"
-#include "engine/script/script.h"
-
-#include "utils/ustring.h"
-
-namespace vt_script {
-class ReadScriptDescriptor;
-}
+#include "global_definitions.h"
 
 namespace vt_global
 {
@@ -48,6 +39,9 @@ class GlobalSpirit;
 *** class object rather than having to create and managed 50 class objects, one for
 *** each potion. The _count member achieves this convenient function.
 ***
+*** The object data is read once per object id, and shared by every instance
+*** through its definition: an instance only keeps its own count and state.
+***
 *** A GlobalObject with an ID value of zero is considered invalid. Most of the
 *** protected members of this class can only be set by the constructors or methods
 *** of deriving classes.
@@ -63,21 +57,9 @@ class GlobalSpirit;
 class GlobalObject
 {
 public:
-    GlobalObject() :
-        _id(0),
-        _is_key_item(false),
-        _count(0),
-        _price(0),
-        _trade_price(0)
-    {}
+    GlobalObject();
 
-    GlobalObject(uint32 id, uint32 count = 1) :
-        _id(id),
-        _is_key_item(false),
-        _count(count),
-        _price(0),
-        _trade_price(0)
-    {}
+    GlobalObject(uint32 id, uint32 count = 1);
 
     virtual ~GlobalObject()
     {}
@@ -89,7 +71,7 @@ public:
 
     //! \brief Returns true if the object is properly initialized and ready to be used
     bool IsKeyItem() const {
-        return _is_key_item;
+        return _definition->is_key_item;
     }
 
     /** \brief Purely virtual function used to distinguish between object types
@@ -121,11 +103,11 @@ public:
     }
 
     const vt_utils::ustring &GetName() const {
-        return _name;
+        return _definition->name;
     }
 
     const vt_utils::ustring &GetDescription() const {
-        return _description;
+        return _definition->description;
     }
 
     void SetCount(uint32 count) {
@@ -137,23 +119,23 @@ public:
     }
 
     uint32 GetPrice() const {
-        return _price;
+        return _definition->price;
     }
 
     uint32 GetTradingPrice() const {
-        return _trade_price;
+        return _definition->trade_price;
     }
 
     const std::vector<std::pair<uint32, uint32> >& GetTradeConditions() const {
-        return _trade_conditions;
+        return _definition->trade_conditions;
     }
 
     const vt_video::StillImage &GetIconImage() const {
-        return _icon_image;
+        return _definition->icon_image;
     }
 
     const std::vector<std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY> >& GetStatusEffects() const {
-        return _status_effects;
+        return _definition->status_effects;
     }
     //@}
 
@@ -163,62 +145,24 @@ protected:
     **/
     uint32 _id;
 
-    //! \brief The name of the object as it would be displayed on a screen
-    vt_utils::ustring _name;
-
-    //! \brief A short description of the item to display on the screen
-    vt_utils::ustring _description;
-
-    //! \brief Tells whether an item is a key item, preventing from being consumed or sold.
-    bool _is_key_item;
-
     //! \brief Retains how many occurences of the object are represented by this class object instance
     uint32 _count;
 
-    //! \brief The base price of the object for purchase/sale in the game
-    uint32 _price;
-
-    //! \brief The additional price of the object requested when trading it.
-    uint32 _trade_price;
-
-    //! \brief The trade conditions of the item <item_id, number>
-    //! There is an exception: If the item_id is zero, the second value is the trade price.
-    std::vector<std::pair<uint32, uint32> > _trade_conditions;
-
-    //! \brief A loaded icon image of the object at its original size of 60x60 pixels
-    vt_video::StillImage _icon_image;
-
-    /** \brief Container that holds the intensity of each type of status effect of the object
-    *** Effects with an intensity of GLOBAL_INTENSITY_NEUTRAL indicate no status effect bonus
+    /** \brief The object data shared by all its instances, never NULL
+    *** The trade conditions are stored as <item_id, number> pairs, and the status effects
+    *** with an intensity of GLOBAL_INTENSITY_NEUTRAL indicate no status effect bonus.
     **/
-    std::vector<std::pair<GLOBAL_STATUS, GLOBAL_INTENSITY> > _status_effects;
-
-    //! \brief The skills that can be learned when equipping that piece of equipment.
-    std::vector<uint32> _equipment_skills;
+    const private_global::ObjectDefinition *_definition;
 
     //! \brief Causes the object to become invalid due to a loading error or other significant issue
     void _InvalidateObject() {
         _id = 0;
     }
 
-    /** \brief Reads object data from an open script file
-    *** \param script A reference to a script file that has been opened and prepared
-    ***
-    *** This method does not do any of its own error case checking. Only derived classes may call this
-    *** protected function and they are expected to have the script file successfully opened and the correct
-    *** table context prepared. This function will do nothing more but read the expected key/values of
-    *** the open table in the script file and return.
+    /** \brief Gets the shared object data of the given type, read from its script on first use
+    *** The object is invalidated when its data couldn't be read.
     **/
-    void _LoadObjectData(vt_script::ReadScriptDescriptor &script);
-
-    //! \brief Loads status effects data
-    void _LoadStatusEffects(vt_script::ReadScriptDescriptor &script);
-
-    //! \brief Loads trading conditions data
-    void _LoadTradeConditions(vt_script::ReadScriptDescriptor &script);
-
-    //! \brief Loads the object linked skills (used by equipment only)
-    void _LoadEquipmentSkills(vt_script::ReadScriptDescriptor &script);
+    void _LoadDefinition(GLOBAL_OBJECT type);
 }; // class GlobalObject
 
 
@@ -242,72 +186,52 @@ public:
     ~GlobalItem()
     {}
 
-    GlobalItem(const GlobalItem &copy);
-
-    GlobalItem &operator=(const GlobalItem &copy);
-
     GLOBAL_OBJECT GetObjectType() const {
         return GLOBAL_OBJECT_ITEM;
     }
 
     //! \brief Returns true if the item can be used in battle
     bool IsUsableInBattle() {
-        return _battle_use_function.is_valid();
+        return _definition->battle_use_function.is_valid();
     }
 
     //! \brief Returns true if the item can be used in the field
     bool IsUsableInField() {
-        return _field_use_function.is_valid();
+        return _definition->field_use_function.is_valid();
     }
 
     //! \name Class Member Access Functions
     //@{
     GLOBAL_TARGET GetTargetType() const {
-        return _target_type;
+        return _definition->target_type;
     }
 
     /** \brief Returns a pointer to the ScriptObject of the battle use function
     *** \note This function will return NULL if the skill is not usable in battle
     **/
     const ScriptObject &GetBattleUseFunction() const {
-        return _battle_use_function;
+        return _definition->battle_use_function;
     }
 
     /** \brief Returns a pointer to the ScriptObject of the field use function
     *** \note This function will return NULL if the skill is not usable in the field
     **/
     const ScriptObject &GetFieldUseFunction() const {
-        return _field_use_function;
+        return _definition->field_use_function;
     }
 
     /** \brief Returns Warmup time needed before using this item in battles.
     **/
     uint32 GetWarmUpTime() const {
-        return _warmup_time;
+        return _definition->warmup_time;
     }
 
     /** \brief Returns Warmup time needed before using this item in battles.
     **/
     uint32 GetCoolDownTime() const {
-        return _cooldown_time;
+        return _definition->cooldown_time;
     }
     //@}
-
-private:
-    //! \brief The type of target for the item
-    GLOBAL_TARGET _target_type;
-
-    //! \brief A reference to the script function that performs the item's effect while in battle
-    ScriptObject _battle_use_function;
-
-    //! \brief A reference to the script function that performs the item's effect while in a menu
-    ScriptObject _field_use_function;
-
-    //! \brief The warmup time in milliseconds needed before using this item in battles.
-    uint32 _warmup_time;
-
-    //! \brief The cooldown time in milliseconds needed after using this item in battles.
-    uint32 _cooldown_time;
 }; // class GlobalItem : public GlobalObject
 
 
@@ -342,15 +266,15 @@ public:
     //! \name Class Member Access Functions
     //@{
     uint32 GetPhysicalAttack() const {
-        return _physical_attack;
+        return _definition->physical_value;
     }
 
     uint32 GetMagicalAttack() const {
-        return _magical_attack;
+        return _definition->magical_value;
     }
 
     uint32 GetUsableBy() const {
-        return _usable_by;
+        return _definition->usable_by;
     }
 
     const std::vector<GlobalSpirit *>& GetSpiritSlots() const {
@@ -358,7 +282,7 @@ public:
     }
 
     const std::string &GetAmmoImageFile() const {
-        return _ammo_image_file;
+        return _definition->ammo_image_file;
     }
 
     //! \brief Get the animation filename corresponding to the character weapon animation
@@ -367,38 +291,17 @@ public:
 
     //! \brief Gives the list of learned skill thanks to this piece of equipment.
     const std::vector<uint32>& GetEquipmentSkills() const {
-        return _equipment_skills;
+        return _definition->equipment_skills;
     }
     //@}
 
 private:
-    //! \brief The battle image animation file used to display the weapon ammo.
-    std::string _ammo_image_file;
-
-    //! \brief The amount of physical damage that the weapon causes
-    uint32 _physical_attack;
-
-    //! \brief The amount of magical damage that the weapon causes for each elements.
-    uint32 _magical_attack;
-
-    /** \brief A bit-mask that determines which characters can use or equip the object
-    *** See the game character ID constants in global_actors.h for more information
-    **/
-    uint32 _usable_by;
-
-    //! \brief The info about weapon animations for each global character.
-    //! map < character_id, map < animation alias, animation filename > >
-    std::map <uint32, std::map<std::string, std::string> > _weapon_animations;
-
     /** \brief Spirit slots which may be used to place spirits on the weapon
     *** Weapons may have no slots, so it is not uncommon for the size of this vector to be zero.
     *** When spirit slots are available but empty (has no attached spirit), the pointer at that index
     *** will be NULL.
     **/
     std::vector<GlobalSpirit *> _spirit_slots;
-
-    //! \brief Loads the battle animations data for each character that can use the weapon.
-    void _LoadWeaponBattleAnimations(vt_script::ReadScriptDescriptor& script);
 }; // class GlobalWeapon : public GlobalObject
 
 
@@ -430,15 +333,15 @@ public:
     GLOBAL_OBJECT GetObjectType() const;
 
     uint32 GetPhysicalDefense() const {
-        return _physical_defense;
+        return _definition->physical_value;
     }
 
     uint32 GetMagicalDefense() const {
-        return _magical_defense;
+        return _definition->magical_value;
     }
 
     uint32 GetUsableBy() const {
-        return _usable_by;
+        return _definition->usable_by;
     }
 
     const std::vector<GlobalSpirit *>& GetSpiritSlots() const {
@@ -447,21 +350,10 @@ public:
 
     //! \brief Gives the list of learned skill thanks to this piece of equipment.
     const std::vector<uint32>& GetEquipmentSkills() const {
-        return _equipment_skills;
+        return _definition->equipment_skills;
     }
 
 private:
-    //! \brief The amount of physical defense that the armor provides
-    uint32 _physical_defense;
-
-    //! \brief The amount of magical defense that the armor provides against each elements
-    uint32 _magical_defense;
-
-    /** \brief A bit-mask that determines which characters can use or equip the object
-    *** See the game character ID constants in global_actors.h for more information
-    **/
-    uint32 _usable_by;
-
     /** \brief Sockets which may be used to place spirits on the armor
     *** Armor may have no sockets, so it is not uncommon for the size of this vector to be zero.
     *** When a socket is available but empty (has no attached spirit), the pointer at that index
@@ -0,0 +1,1197 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    global_save.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the saved game files
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "global_save.h"
+
+#include "global.h"
+
+#include "engine/script/script_read.h"
+#include "engine/script/script_write.h"
+#include "engine/system.h"
+
+#include "utils/utils_files.h"
+#include "utils/utils_strings.h"
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+using namespace vt_utils;
+using namespace vt_script;
+using namespace vt_system;
+
+namespace vt_global
+{
+
+namespace private_global
+{
+
+//! \brief The first bytes of every binary saved game.
+const char SAVE_GAME_MAGIC[8] = { 'V', 'T', 'S', 'A', 'V', 'B', 'I', 'N' };
+
+//! \brief The binary format version, to increase whenever the meaning of an existing section changes.
+const uint32 SAVE_GAME_VERSION = 1;
+
+//! \brief Written as is, so that a saved game from a machine with another byte order is rejected.
+const uint32 SAVE_GAME_BYTE_ORDER = 0x01020304;
+
+//! \brief The first bytes of every saved game preview file.
+const char SAVE_PREVIEW_MAGIC[8] = { 'V', 'T', 'S', 'A', 'V', 'P', 'R', 'V' };
+
+//! \brief The preview format version. The preview is rebuilt from the saved game when it differs.
+const uint32 SAVE_PREVIEW_VERSION = 1;
+
+//! \brief The extension of the saved games written in the Lua format.
+const std::string SAVE_GAME_LUA_EXTENSION = ".lua";
+
+//! \brief The names of the inventory categories, in the Lua format.
+const char *const SAVE_INVENTORY_NAMES[SAVE_INVENTORY_CATEGORIES] = {
+    "items", "weapons", "head_armor", "torso_armor", "arm_armor", "leg_armor", "spirits"
+};
+
+/** \brief The sections of a binary saved game
+*** Each section is written as its type, its size in bytes, and its content.
+*** The readers skip the sections they don't know, so new data can be added
+*** in new sections without breaking the older saves.
+**/
+enum SAVE_SECTION {
+    //! Ends the file, telling it was entirely written
+    SAVE_SECTION_END        = 0,
+    //! The map, location, play time and drunes
+    SAVE_SECTION_PLAY       = 1,
+    SAVE_SECTION_INVENTORY  = 2,
+    SAVE_SECTION_CHARACTERS = 3,
+    SAVE_SECTION_EVENTS     = 4,
+    SAVE_SECTION_QUESTS     = 5,
+    SAVE_SECTION_WORLD_MAP  = 6
+};
+
+SaveCharacterData::SaveCharacterData() :
+    id(0),
+    enabled(true),
+    experience_level(0),
+    experience_points(0),
+    experience_points_next(0),
+    max_hit_points(0),
+    hit_points(0),
+    max_skill_points(0),
+    skill_points(0),
+    strength(0),
+    vigor(0),
+    fortitude(0),
+    protection(0),
+    agility(0),
+    evade(0.0f),
+    weapon(0),
+    head_armor(0),
+    torso_armor(0),
+    arm_armor(0),
+    leg_armor(0)
+{}
+
+SaveGameData::SaveGameData() :
+    location_x(0),
+    location_y(0),
+    play_hours(0),
+    play_minutes(0),
+    play_seconds(0),
+    drunes(0)
+{}
+
+SavePreviewCharacterData::SavePreviewCharacterData() :
+    id(0),
+    experience_level(0),
+    max_hit_points(0),
+    hit_points(0),
+    max_skill_points(0),
+    skill_points(0)
+{}
+
+SavePreviewData::SavePreviewData() :
+    save_time(0),
+    play_hours(0),
+    play_minutes(0),
+    play_seconds(0),
+    drunes(0)
+{}
+
+////////////////////////////////////////////////////////////////////////////////
+// Binary format
+////////////////////////////////////////////////////////////////////////////////
+
+//! \brief Appends the values of a binary saved game to a buffer.
+class SaveGameBuffer
+{
+public:
+    SaveGameBuffer() :
+        _section_start(0) {}
+
+    void WriteData(const void *data, size_t size) {
+        const uint8 *bytes = static_cast<const uint8 *>(data);
+        _buffer.insert(_buffer.end(), bytes, bytes + size);
+    }
+
+    void WriteUInt(uint32 value) {
+        WriteData(&value, sizeof(uint32));
+    }
+
+    void WriteInt(int32 value) {
+        WriteData(&value, sizeof(int32));
+    }
+
+    void WriteFloat(float value) {
+        WriteData(&value, sizeof(float));
+    }
+
+    void WriteBool(bool value) {
+        WriteUInt(value ? 1 : 0);
+    }
+
+    void WriteString(const std::string &value) {
+        WriteUInt(value.size());
+        WriteData(value.data(), value.size());
+    }
+
+    void WriteUString(const ustring &value) {
+        WriteUInt(value.length());
+        WriteData(value.c_str(), value.length() * sizeof(uint16));
+    }
+
+    //! \brief Starts a section, whose size is written once it is ended.
+    void BeginSection(SAVE_SECTION type) {
+        WriteUInt(type);
+        WriteUInt(0);
+        _section_start = _buffer.size();
+    }
+
+    void EndSection() {
+        uint32 size = _buffer.size() - _section_start;
+        memcpy(&_buffer[_section_start - sizeof(uint32)], &size, sizeof(uint32));
+    }
+
+    const std::vector<uint8> &GetBuffer() const {
+        return _buffer;
+    }
+
+private:
+    std::vector<uint8> _buffer;
+
+    //! \brief The offset of the current section content.
+    size_t _section_start;
+};
+
+//! \brief Reads the values of a binary saved game in order, checking the bounds.
+class SaveGameReader
+{
+public:
+    SaveGameReader(const uint8 *data, size_t size) :
+        _data(data), _size(size), _position(0) {}
+
+    //! \brief Returns a pointer to the next bytes, or NULL if there aren't enough left.
+    const uint8 *ReadData(size_t size) {
+        if(size > _size - _position)
+            return NULL;
+        const uint8 *data = _data + _position;
+        _position += size;
+        return data;
+    }
+
+    bool ReadUInt(uint32 &value) {
+        const uint8 *data = ReadData(sizeof(uint32));
+        if(data == NULL)
+            return false;
+        memcpy(&value, data, sizeof(uint32));
+        return true;
+    }
+
+    bool ReadInt(int32 &value) {
+        const uint8 *data = ReadData(sizeof(int32));
+        if(data == NULL)
+            return false;
+        memcpy(&value, data, sizeof(int32));
+        return true;
+    }
+
+    bool ReadFloat(float &value) {
+        const uint8 *data = ReadData(sizeof(float));
+        if(data == NULL)
+            return false;
+        memcpy(&value, data, sizeof(float));
+        return true;
+    }
+
+    bool ReadBool(bool &value) {
+        uint32 number;
+        if(!ReadUInt(number))
+            return false;
+        value = (number != 0);
+        return true;
+    }
+
+    bool ReadString(std::string &value) {
+        uint32 length;
+        if(!ReadUInt(length))
+            return false;
+        const uint8 *data = ReadData(length);
+        if(data == NULL)
+            return false;
+        value.assign(reinterpret_cast<const char *>(data), length);
+        return true;
+    }
+
+    bool ReadUString(ustring &value) {
+        uint32 length;
+        if(!ReadSize(length, sizeof(uint16)))
+            return false;
+        std::vector<uint16> characters(length + 1, 0);
+        if(length > 0)
+            memcpy(&characters[0], ReadData(length * sizeof(uint16)), length * sizeof(uint16));
+        value = ustring(&characters[0]);
+        return true;
+    }
+
+    /** \brief Reads a vector size, checking there is room left for at least that many values.
+    *** This prevents a corrupted size from allocating a huge vector.
+    **/
+    bool ReadSize(uint32 &size, size_t min_value_size) {
+        return ReadUInt(size) && static_cast<size_t>(size) * min_value_size <= _size - _position;
+    }
+
+private:
+    const uint8 *_data;
+    size_t _size;
+    size_t _position;
+};
+
+static void WriteBinaryCharacter(SaveGameBuffer &buffer, const SaveCharacterData &character)
+{
+    buffer.WriteUInt(character.id);
+    buffer.WriteBool(character.enabled);
+
+    buffer.WriteUInt(character.experience_level);
+    buffer.WriteUInt(character.experience_points);
+    buffer.WriteInt(character.experience_points_next);
+
+    buffer.WriteUInt(character.max_hit_points);
+    buffer.WriteUInt(character.hit_points);
+    buffer.WriteUInt(character.max_skill_points);
+    buffer.WriteUInt(character.skill_points);
+
+    buffer.WriteUInt(character.strength);
+    buffer.WriteUInt(character.vigor);
+    buffer.WriteUInt(character.fortitude);
+    buffer.WriteUInt(character.protection);
+    buffer.WriteUInt(character.agility);
+    buffer.WriteFloat(character.evade);
+
+    buffer.WriteUInt(character.weapon);
+    buffer.WriteUInt(character.head_armor);
+    buffer.WriteUInt(character.torso_armor);
+    buffer.WriteUInt(character.arm_armor);
+    buffer.WriteUInt(character.leg_armor);
+
+    buffer.WriteUInt(character.skills.size());
+    for(uint32 i = 0; i < character.skills.size(); ++i)
+        buffer.WriteUInt(character.skills[i]);
+}
+
+static bool ReadBinaryCharacter(SaveGameReader &reader, SaveCharacterData &character)
+{
+    uint32 num_skills = 0;
+    if(!reader.ReadUInt(character.id) || !reader.ReadBool(character.enabled)
+            || !reader.ReadUInt(character.experience_level) || !reader.ReadUInt(character.experience_points)
+            || !reader.ReadInt(character.experience_points_next)
+            || !reader.ReadUInt(character.max_hit_points) || !reader.ReadUInt(character.hit_points)
+            || !reader.ReadUInt(character.max_skill_points) || !reader.ReadUInt(character.skill_points)
+            || !reader.ReadUInt(character.strength) || !reader.ReadUInt(character.vigor)
+            || !reader.ReadUInt(character.fortitude) || !reader.ReadUInt(character.protection)
+            || !reader.ReadUInt(character.agility) || !reader.ReadFloat(character.evade)
+            || !reader.ReadUInt(character.weapon) || !reader.ReadUInt(character.head_armor)
+            || !reader.ReadUInt(character.torso_armor) || !reader.ReadUInt(character.arm_armor)
+            || !reader.ReadUInt(character.leg_armor)
+            || !reader.ReadSize(num_skills, sizeof(uint32)))
+        return false;
+
+    character.skills.resize(num_skills);
+    for(uint32 i = 0; i < num_skills; ++i) {
+        if(!reader.ReadUInt(character.skills[i]))
+            return false;
+    }
+    return true;
+}
+
+static void WriteBinarySaveGame(const SaveGameData &data, std::vector<uint8> &output)
+{
+    SaveGameBuffer buffer;
+    buffer.WriteData(SAVE_GAME_MAGIC, sizeof(SAVE_GAME_MAGIC));
+    buffer.WriteUInt(SAVE_GAME_VERSION);
+    buffer.WriteUInt(SAVE_GAME_BYTE_ORDER);
+
+    buffer.BeginSection(SAVE_SECTION_PLAY);
+    buffer.WriteString(data.map_data_filename);
+    buffer.WriteString(data.map_script_filename);
+    buffer.WriteUInt(data.location_x);
+    buffer.WriteUInt(data.location_y);
+    buffer.WriteUInt(data.play_hours);
+    buffer.WriteUInt(data.play_minutes);
+    buffer.WriteUInt(data.play_seconds);
+    buffer.WriteUInt(data.drunes);
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_INVENTORY);
+    for(uint32 i = 0; i < SAVE_INVENTORY_CATEGORIES; ++i) {
+        buffer.WriteUInt(data.inventory[i].size());
+        for(uint32 j = 0; j < data.inventory[i].size(); ++j) {
+            buffer.WriteUInt(data.inventory[i][j].first);
+            buffer.WriteUInt(data.inventory[i][j].second);
+        }
+    }
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_CHARACTERS);
+    buffer.WriteUInt(data.characters.size());
+    for(uint32 i = 0; i < data.characters.size(); ++i)
+        WriteBinaryCharacter(buffer, data.characters[i]);
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_EVENTS);
+    buffer.WriteUInt(data.event_groups.size());
+    for(uint32 i = 0; i < data.event_groups.size(); ++i) {
+        const SaveEventGroupData &group = data.event_groups[i];
+        buffer.WriteString(group.name);
+        buffer.WriteUInt(group.events.size());
+        for(uint32 j = 0; j < group.events.size(); ++j) {
+            buffer.WriteString(group.events[j].first);
+            buffer.WriteInt(group.events[j].second);
+        }
+    }
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_QUESTS);
+    buffer.WriteUInt(data.quests.size());
+    for(uint32 i = 0; i < data.quests.size(); ++i) {
+        buffer.WriteString(data.quests[i].id);
+        buffer.WriteUInt(data.quests[i].log_number);
+        buffer.WriteBool(data.quests[i].is_read);
+    }
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_WORLD_MAP);
+    buffer.WriteString(data.world_map_filename);
+    buffer.WriteUInt(data.viewable_locations.size());
+    for(uint32 i = 0; i < data.viewable_locations.size(); ++i)
+        buffer.WriteString(data.viewable_locations[i]);
+    buffer.WriteString(data.current_location);
+    buffer.EndSection();
+
+    buffer.BeginSection(SAVE_SECTION_END);
+    buffer.EndSection();
+
+    output = buffer.GetBuffer();
+}
+
+//! \brief Reads the content of a section. Returns false if it is malformed.
+static bool ReadBinarySection(SAVE_SECTION type, SaveGameReader &reader, SaveGameData &data)
+{
+    uint32 number = 0;
+
+    switch(type) {
+    case SAVE_SECTION_PLAY:
+        return reader.ReadString(data.map_data_filename) && reader.ReadString(data.map_script_filename)
+               && reader.ReadUInt(data.location_x) && reader.ReadUInt(data.location_y)
+               && reader.ReadUInt(data.play_hours) && reader.ReadUInt(data.play_minutes)
+               && reader.ReadUInt(data.play_seconds) && reader.ReadUInt(data.drunes);
+
+    case SAVE_SECTION_INVENTORY:
+        for(uint32 i = 0; i < SAVE_INVENTORY_CATEGORIES; ++i) {
+            if(!reader.ReadSize(number, 2 * sizeof(uint32)))
+                return false;
+            data.inventory[i].resize(number);
+            for(uint32 j = 0; j < number; ++j) {
+                if(!reader.ReadUInt(data.inventory[i][j].first) || !reader.ReadUInt(data.inventory[i][j].second))
+                    return false;
+            }
+        }
+        return true;
+
+    case SAVE_SECTION_CHARACTERS:
+        if(!reader.ReadSize(number, sizeof(uint32)))
+            return false;
+        data.characters.resize(number);
+        for(uint32 i = 0; i < number; ++i) {
+            if(!ReadBinaryCharacter(reader, data.characters[i]))
+                return false;
+        }
+        return true;
+
+    case SAVE_SECTION_EVENTS:
+        if(!reader.ReadSize(number, sizeof(uint32)))
+            return false;
+        data.event_groups.resize(number);
+        for(uint32 i = 0; i < number; ++i) {
+            SaveEventGroupData &group = data.event_groups[i];
+            uint32 num_events = 0;
+            if(!reader.ReadString(group.name) || !reader.ReadSize(num_events, 2 * sizeof(uint32)))
+                return false;
+            group.events.resize(num_events);
+            for(uint32 j = 0; j < num_events; ++j) {
+                if(!reader.ReadString(group.events[j].first) || !reader.ReadInt(group.events[j].second))
+                    return false;
+            }
+        }
+        return true;
+
+    case SAVE_SECTION_QUESTS:
+        if(!reader.ReadSize(number, sizeof(uint32)))
+            return false;
+        data.quests.resize(number);
+        for(uint32 i = 0; i < number; ++i) {
+            if(!reader.ReadString(data.quests[i].id) || !reader.ReadUInt(data.quests[i].log_number)
+                    || !reader.ReadBool(data.quests[i].is_read))
+                return false;
+        }
+        return true;
+
+    case SAVE_SECTION_WORLD_MAP:
+        if(!reader.ReadString(data.world_map_filename) || !reader.ReadSize(number, sizeof(uint32)))
+            return false;
+        data.viewable_locations.resize(number);
+        for(uint32 i = 0; i < number; ++i) {
+            if(!reader.ReadString(data.viewable_locations[i]))
+                return false;
+        }
+        return reader.ReadString(data.current_location);
+
+    default:
+        // Written by a newer version, and not needed by this one.
+        return true;
+    }
+}
+
+static bool ReadBinarySaveGame(const std::string &filename, const std::vector<uint8> &buffer, SaveGameData &data)
+{
+    SaveGameReader reader(buffer.empty() ? NULL : &buffer[0], buffer.size());
+
+    const uint8 *magic = reader.ReadData(sizeof(SAVE_GAME_MAGIC));
+    uint32 version = 0;
+    uint32 byte_order = 0;
+    if(magic == NULL || memcmp(magic, SAVE_GAME_MAGIC, sizeof(SAVE_GAME_MAGIC)) != 0
+            || !reader.ReadUInt(version) || !reader.ReadUInt(byte_order)
+            || byte_order != SAVE_GAME_BYTE_ORDER) {
+        PRINT_ERROR << "Invalid saved game header in: " << filename << std::endl;
+        return false;
+    }
+    if(version > SAVE_GAME_VERSION) {
+        PRINT_ERROR << "The saved game " << filename << " was written by a newer version of the game (format "
+                    << version << ")." << std::endl;
+        return false;
+    }
+
+    while(true) {
+        uint32 type = 0;
+        uint32 size = 0;
+        if(!reader.ReadUInt(type) || !reader.ReadUInt(size)) {
+            PRINT_ERROR << "The saved game " << filename << " is truncated." << std::endl;
+            return false;
+        }
+        if(type == SAVE_SECTION_END)
+            break;
+
+        const uint8 *section = reader.ReadData(size);
+        if(section == NULL) {
+            PRINT_ERROR << "The saved game " << filename << " is truncated." << std::endl;
+            return false;
+        }
+
+        SaveGameReader section_reader(section, size);
+        if(!ReadBinarySection(static_cast<SAVE_SECTION>(type), section_reader, data)) {
+            PRINT_ERROR << "Invalid section " << type << " in the saved game: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    if(data.characters.empty()) {
+        PRINT_ERROR << "No characters in the saved game: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/** \brief Writes a buffer to a file and flushes it to the disk.
+*** The buffer is written under a temporary name first, which then replaces the file.
+**/
+static bool WriteFileToDisk(const std::string &filename, const std::vector<uint8> &buffer)
+{
+    const std::string temp_filename = filename + ".tmp";
+    FILE *file = fopen(temp_filename.c_str(), "wb");
+    if(file == NULL) {
+        PRINT_ERROR << "Couldn't open the saved game file for writing: " << temp_filename << std::endl;
+        return false;
+    }
+
+    bool written = (fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size()) && (fflush(file) == 0);
+#ifdef _WIN32
+    written = written && (_commit(_fileno(file)) == 0);
+#else
+    written = written && (fsync(fileno(file)) == 0);
+#endif
+    if(fclose(file) != 0)
+        written = false;
+
+    if(!written) {
+        PRINT_ERROR << "Couldn't write the saved game file: " << temp_filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+
+#ifdef _WIN32
+    // Windows can't rename over an existing file.
+    bool renamed = MoveFile(temp_filename, filename);
+#else
+    // Renaming replaces the former file at once.
+    bool renamed = (rename(temp_filename.c_str(), filename.c_str()) == 0);
+#endif
+    if(!renamed) {
+        PRINT_ERROR << "Couldn't replace the saved game file: " << filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Lua format
+////////////////////////////////////////////////////////////////////////////////
+
+//! \brief Turns the old bare hands skill ids into the new ones.
+static uint32 UpdateSkillId(uint32 skill_id)
+{
+    // DEPRECATED HACK: Remove that in one release.
+    if(skill_id == 999)
+        return 30002;
+    else if(skill_id == 1000)
+        return 30001;
+    return skill_id;
+}
+
+static void WriteLuaInventory(WriteScriptDescriptor &file, const std::string &name,
+                              const std::vector<std::pair<uint32, uint32> > &inventory)
+{
+    file.InsertNewLine();
+    file.WriteLine(name + " = {");
+    for(uint32 i = 0; i < inventory.size(); ++i) {
+        if(i == 0)
+            file.WriteLine("\t", false);
+        else
+            file.WriteLine(", ", false);
+
+        // Add a new line every 10 entries for better readability and debugging
+        if((i > 0) && !(i % 10)) {
+            file.InsertNewLine();
+            file.WriteLine("\t", false);
+        }
+
+        file.WriteLine("[" + NumberToString(inventory[i].first) + "] = " + NumberToString(inventory[i].second), false);
+    }
+    file.InsertNewLine();
+    file.WriteLine("},");
+}
+
+static void WriteLuaCharacter(WriteScriptDescriptor &file, const SaveCharacterData &character, bool last)
+{
+    file.WriteLine("\t[" + NumberToString(character.id) + "] = {");
+
+    // Store whether the character is available
+    file.WriteLine("\t\tenabled = " + std::string(character.enabled ? "true" : "false") + ",");
+
+    file.WriteLine("\t\texperience_level = " + NumberToString(character.experience_level) + ",");
+    file.WriteLine("\t\texperience_points = " + NumberToString(character.experience_points) + ",");
+    file.WriteLine("\t\texperience_points_next = " + NumberToString(character.experience_points_next) + ", ");
+
+    // The values stored are the unmodified ones.
+    file.WriteLine("\t\tmax_hit_points = " + NumberToString(character.max_hit_points) + ",");
+    file.WriteLine("\t\thit_points = " + NumberToString(character.hit_points) + ",");
+    file.WriteLine("\t\tmax_skill_points = " + NumberToString(character.max_skill_points) + ",");
+    file.WriteLine("\t\tskill_points = " + NumberToString(character.skill_points) + ",");
+
+    file.WriteLine("\t\tstrength = " + NumberToString(character.strength) + ",");
+    file.WriteLine("\t\tvigor = " + NumberToString(character.vigor) + ",");
+    file.WriteLine("\t\tfortitude = " + NumberToString(character.fortitude) + ",");
+    file.WriteLine("\t\tprotection = " + NumberToString(character.protection) + ",");
+    file.WriteLine("\t\tagility = " + NumberToString(character.agility) + ",");
+    file.WriteLine("\t\tevade = " + NumberToString(character.evade) + ",");
+
+    file.InsertNewLine();
+    file.WriteLine("\t\tequipment = {");
+    file.WriteLine("\t\t\tweapon = " + NumberToString(character.weapon) + ",");
+    file.WriteLine("\t\t\thead_armor = " + NumberToString(character.head_armor) + ",");
+    file.WriteLine("\t\t\ttorso_armor = " + NumberToString(character.torso_armor) + ",");
+    file.WriteLine("\t\t\tarm_armor = " + NumberToString(character.arm_armor) + ",");
+    file.WriteLine("\t\t\tleg_armor = " + NumberToString(character.leg_armor));
+    file.WriteLine("\t\t},");
+
+    file.InsertNewLine();
+    file.WriteLine("\t\tskills = {");
+    for(uint32 i = 0; i < character.skills.size(); ++i) {
+        if(i == 0)
+            file.WriteLine("\t\t\t", false);
+        else
+            file.WriteLine(", ", false);
+        file.WriteLine(NumberToString(character.skills[i]), false);
+    }
+    file.WriteLine("\n\t\t}");
+
+    if(last)
+        file.WriteLine("\t}");
+    else
+        file.WriteLine("\t},");
+}
+
+static void WriteLuaEvents(WriteScriptDescriptor &file, const SaveEventGroupData &group)
+{
+    file.WriteLine("\t" + group.name + " = {");
+
+    for(uint32 i = 0; i < group.events.size(); ++i) {
+        if(i == 0)
+            file.WriteLine("\t\t", false);
+        else
+            file.WriteLine(", ", false);
+
+        // Add a new line every 4 entries for better readability and debugging
+        if((i > 0) && !(i % 4)) {
+            file.InsertNewLine();
+            file.WriteLine("\t\t", false);
+        }
+
+        file.WriteLine("[\"" + group.events[i].first + "\"] = " + NumberToString(group.events[i].second), false);
+    }
+    file.WriteLine("\n\t},");
+}
+
+static bool WriteLuaSaveGame(const SaveGameData &data, const std::string &filename)
+{
+    WriteScriptDescriptor file;
+    if(!file.OpenFile(filename))
+        return false;
+
+    // Open the save_game1 table
+    file.WriteLine("save_game1 = {");
+
+    // Save simple play data
+    file.InsertNewLine();
+    file.WriteLine("map_data_filename = \"" + data.map_data_filename + "\",");
+    file.WriteLine("map_script_filename = \"" + data.map_script_filename + "\",");
+    //! \note Coords are in map tiles
+    file.WriteLine("location_x = " + NumberToString(data.location_x) + ",");
+    file.WriteLine("location_y = " + NumberToString(data.location_y) + ",");
+    file.WriteLine("play_hours = " + NumberToString(data.play_hours) + ",");
+    file.WriteLine("play_minutes = " + NumberToString(data.play_minutes) + ",");
+    file.WriteLine("play_seconds = " + NumberToString(data.play_seconds) + ",");
+    file.WriteLine("drunes = " + NumberToString(data.drunes) + ",");
+
+    for(uint32 i = 0; i < SAVE_INVENTORY_CATEGORIES; ++i)
+        WriteLuaInventory(file, SAVE_INVENTORY_NAMES[i], data.inventory[i]);
+
+    // Save character data, starting with the order of the characters in the party
+    file.InsertNewLine();
+    file.WriteLine("characters = {");
+    file.WriteLine("\t[\"order\"] = {");
+    for(uint32 i = 0; i < data.characters.size(); ++i) {
+        if(i == 0)
+            file.WriteLine("\t\t" + NumberToString(data.characters[i].id), false);
+        else
+            file.WriteLine(", " + NumberToString(data.characters[i].id), false);
+    }
+    file.WriteLine("\n\t},"); // order
+
+    for(uint32 i = 0; i < data.characters.size(); ++i)
+        WriteLuaCharacter(file, data.characters[i], (i + 1) == data.characters.size());
+    file.WriteLine("},"); // characters
+
+    // Save event data
+    file.InsertNewLine();
+    file.WriteLine("event_groups = {");
+    for(uint32 i = 0; i < data.event_groups.size(); ++i)
+        WriteLuaEvents(file, data.event_groups[i]);
+    file.WriteLine("},");
+    file.InsertNewLine();
+
+    // Save quest log
+    file.WriteLine("quest_log = {");
+    for(uint32 i = 0; i < data.quests.size(); ++i) {
+        const SaveQuestData &quest = data.quests[i];
+        file.WriteLine("\t" + quest.id + " = {", false);
+        // The quest log number is written as a string because loading needs a uniform type of data in the array
+        file.WriteLine("\"" + NumberToString(quest.log_number) + "\", ", false);
+        file.WriteLine("\"" + std::string(quest.is_read ? "true" : "false") + "\"", false);
+        file.WriteLine("},");
+    }
+    file.WriteLine("},");
+    file.InsertNewLine();
+
+    // Save World Map
+    file.WriteLine("worldmap = {");
+    file.WriteLine("\tworld_map_file = \"" + data.world_map_filename + "\",");
+    file.InsertNewLine();
+    file.WriteLine("\tviewable_locations = {");
+    for(uint32 i = 0; i < data.viewable_locations.size(); ++i)
+        file.WriteLine("\t\t\"" + data.viewable_locations[i] + "\",");
+    file.WriteLine("\t},");
+    file.InsertNewLine();
+    file.WriteLine("\tcurrent_location = \"" + data.current_location + "\"");
+    file.WriteLine("}");
+    file.InsertNewLine();
+
+    bool written = !file.IsErrorDetected();
+    if(!written) {
+        PRINT_WARNING << "one or more errors occurred while writing the save game file - they are listed below" << std::endl;
+        std::cerr << file.GetErrorMessages() << std::endl;
+        file.ClearErrors();
+    }
+
+    file.InsertNewLine();
+    file.WriteLine("} -- save_game1");
+
+    file.CloseFile();
+    return written;
+}
+
+static void ReadLuaInventory(ReadScriptDescriptor &file, const std::string &category_name,
+                             std::vector<std::pair<uint32, uint32> > &inventory)
+{
+    // The table keys are the inventory object ID numbers. The value of each key is the count of that object
+    if(!file.OpenTable(category_name))
+        return;
+
+    std::vector<uint32> object_ids;
+    file.ReadTableKeys(object_ids);
+    for(uint32 i = 0; i < object_ids.size(); ++i)
+        inventory.push_back(std::make_pair(object_ids[i], file.ReadUInt(object_ids[i])));
+    file.CloseTable();
+}
+
+//! \brief Reads a character. The characters table must be open.
+static bool ReadLuaCharacter(ReadScriptDescriptor &file, uint32 id, SaveCharacterData &character)
+{
+    if(!file.OpenTable(id)) {
+        PRINT_WARNING << "Can't load unexisting character id: " << id << std::endl;
+        return false;
+    }
+
+    character.id = id;
+
+    // DEPRECATED: Old format, removed in one release
+    if(file.DoesBoolExist("enabled"))
+        character.enabled = file.ReadBool("enabled");
+
+    character.experience_level = file.ReadUInt("experience_level");
+    character.experience_points = file.ReadUInt("experience_points");
+    character.experience_points_next = file.ReadInt("experience_points_next");
+
+    character.max_hit_points = file.ReadUInt("max_hit_points");
+    character.hit_points = file.ReadUInt("hit_points");
+    character.max_skill_points = file.ReadUInt("max_skill_points");
+    character.skill_points = file.ReadUInt("skill_points");
+
+    character.strength = file.ReadUInt("strength");
+    character.vigor = file.ReadUInt("vigor");
+    character.fortitude = file.ReadUInt("fortitude");
+    character.protection = file.ReadUInt("protection");
+    character.agility = file.ReadUInt("agility");
+    character.evade = file.ReadFloat("evade");
+
+    if(file.OpenTable("equipment")) {
+        character.weapon = file.ReadUInt("weapon");
+        character.head_armor = file.ReadUInt("head_armor");
+        character.torso_armor = file.ReadUInt("torso_armor");
+        character.arm_armor = file.ReadUInt("arm_armor");
+        character.leg_armor = file.ReadUInt("leg_armor");
+        file.CloseTable(); // equipment
+    }
+
+    // DEPRECATED: The skills used to be split by type, which are merged here. Remove in one release.
+    const char *const skill_tables[] = {
+        "skills", "weapon_skills", "magic_skills", "special_skills", "bare_hands_skills",
+        "defense_skills", "attack_skills", "support_skills"
+    };
+    for(uint32 i = 0; i < sizeof(skill_tables) / sizeof(skill_tables[0]); ++i) {
+        std::vector<uint32> skill_ids;
+        file.ReadUIntVector(skill_tables[i], skill_ids);
+        for(uint32 j = 0; j < skill_ids.size(); ++j)
+            character.skills.push_back(UpdateSkillId(skill_ids[j]));
+    }
+
+    file.CloseTable(); // character id
+    return true;
+}
+
+static bool ReadLuaSaveGame(const std::string &filename, SaveGameData &data)
+{
+    // Clear out the save data namespace to avoid reading the data of the previous
+    // save game when dealing with a save game that has an invalid namespace
+    ScriptManager->DropGlobalTable("save_game1");
+
+    ReadScriptDescriptor file;
+    if(!file.OpenFile(filename))
+        return false;
+
+    // open the namespace that the save game is encapsulated in.
+    if(!file.OpenTable("save_game1")) {
+        PRINT_ERROR << "Couldn't open the savegame " << filename << std::endl;
+        file.CloseFile();
+        return false;
+    }
+
+    // DEPRECATED: Old way to load, will be removed in a release
+    if(file.DoesStringExist("map_filename")) {
+        data.map_data_filename = file.ReadString("map_filename");
+        data.map_script_filename = file.ReadString("map_filename");
+    } else {
+        // New way: data and script are separated.
+        data.map_data_filename = file.ReadString("map_data_filename");
+        data.map_script_filename = file.ReadString("map_script_filename");
+    }
+
+    // DEPRECATED: Remove in one release
+    // Hack to permit the split of last map data and scripts.
+    if(!data.map_data_filename.empty() && data.map_data_filename == data.map_script_filename) {
+        std::string map_common_name = data.map_data_filename.substr(0, data.map_data_filename.length() - 4);
+        data.map_data_filename = map_common_name + "_map.lua";
+        data.map_script_filename = map_common_name + "_script.lua";
+    }
+
+    data.location_x = file.ReadUInt("location_x");
+    data.location_y = file.ReadUInt("location_y");
+    data.play_hours = file.ReadUInt("play_hours");
+    data.play_minutes = file.ReadUInt("play_minutes");
+    data.play_seconds = file.ReadUInt("play_seconds");
+    data.drunes = file.ReadUInt("drunes");
+
+    for(uint32 i = 0; i < SAVE_INVENTORY_CATEGORIES; ++i)
+        ReadLuaInventory(file, SAVE_INVENTORY_NAMES[i], data.inventory[i]);
+    // DEPRECATED: Remove in one release. The key items are stored with the other objects.
+    ReadLuaInventory(file, "key_items", data.inventory[0]);
+
+    if(!file.OpenTable("characters")) {
+        PRINT_ERROR << "Couldn't open the savegame characters data in " << filename << std::endl;
+        file.CloseAllTables();
+        file.CloseFile();
+        return false;
+    }
+
+    std::vector<uint32> char_ids;
+    if(file.DoesTableExist("order"))
+        file.ReadUIntVector("order", char_ids);
+    if(char_ids.empty()) {
+        PRINT_ERROR << "No valid characters id in " << filename << std::endl;
+        file.CloseAllTables();
+        file.CloseFile();
+        return false;
+    }
+
+    for(uint32 i = 0; i < char_ids.size(); ++i) {
+        SaveCharacterData character;
+        if(ReadLuaCharacter(file, char_ids[i], character))
+            data.characters.push_back(character);
+    }
+    file.CloseTable(); // characters
+
+    if(data.characters.empty()) {
+        PRINT_ERROR << "No characters were added by save game file: " << filename << std::endl;
+        file.CloseAllTables();
+        file.CloseFile();
+        return false;
+    }
+
+    std::vector<std::string> group_names;
+    if(file.OpenTable("event_groups")) {
+        file.ReadTableKeys(group_names);
+        for(uint32 i = 0; i < group_names.size(); ++i) {
+            SaveEventGroupData group;
+            group.name = group_names[i];
+
+            if(!file.OpenTable(group_names[i])) {
+                PRINT_ERROR << "Invalid event group name '" << group_names[i] << " in save file "
+                            << filename << std::endl;
+                continue;
+            }
+            std::vector<std::string> event_names;
+            file.ReadTableKeys(event_names);
+            for(uint32 j = 0; j < event_names.size(); ++j)
+                group.events.push_back(std::make_pair(event_names[j], file.ReadInt(event_names[j])));
+            file.CloseTable();
+
+            data.event_groups.push_back(group);
+        }
+        file.CloseTable();
+    }
+
+    std::vector<std::string> quest_keys;
+    if(file.OpenTable("quest_log")) {
+        file.ReadTableKeys(quest_keys);
+        for(uint32 i = 0; i < quest_keys.size(); ++i) {
+            std::vector<std::string> quest_info;
+            file.ReadStringVector(quest_keys[i], quest_info);
+            if(quest_info.size() != 2) {
+                IF_PRINT_WARNING(GLOBAL_DEBUG) << "save file has malformed quest log entries" << std::endl;
+                continue;
+            }
+
+            SaveQuestData quest;
+            quest.id = quest_keys[i];
+            // The log number is stored as a string, as all the values of the table must have the same type.
+            quest.log_number = ::atoi(quest_info[0].c_str());
+            quest.is_read = (quest_info[1].compare("true") == 0);
+            data.quests.push_back(quest);
+        }
+        file.CloseTable();
+    }
+
+    if(file.OpenTable("worldmap")) {
+        data.world_map_filename = file.ReadString("world_map_file");
+        file.ReadStringVector("viewable_locations", data.viewable_locations);
+        data.current_location = file.ReadString("current_location");
+        file.CloseTable(); // worldmap
+    } else {
+        // DEPRECATED! Old World map format. Removed in one release...
+        data.world_map_filename = file.ReadString("world_map");
+        file.ReadStringVector("viewable_locations", data.viewable_locations);
+    }
+
+    if(file.IsErrorDetected()) {
+        if(GLOBAL_DEBUG) {
+            PRINT_WARNING << "one or more errors occurred while reading the save game file - they are listed below" << std::endl;
+            std::cerr << file.GetErrorMessages() << std::endl;
+        }
+        file.ClearErrors();
+    }
+
+    file.CloseTable(); // save_game1
+    file.CloseFile();
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Saved game functions
+////////////////////////////////////////////////////////////////////////////////
+
+//! \brief Tells whether the filename has the Lua saved game extension.
+static bool IsLuaSaveFilename(const std::string &filename)
+{
+    return filename.size() >= SAVE_GAME_LUA_EXTENSION.size()
+           && filename.compare(filename.size() - SAVE_GAME_LUA_EXTENSION.size(),
+                               SAVE_GAME_LUA_EXTENSION.size(), SAVE_GAME_LUA_EXTENSION) == 0;
+}
+
+bool ReadSaveGame(const std::string &filename, SaveGameData &data)
+{
+    data = SaveGameData();
+
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the saved game: " << filename << std::endl;
+        return false;
+    }
+
+    // The format is told by the content, so that a renamed file is still read.
+    char magic[sizeof(SAVE_GAME_MAGIC)];
+    file.read(magic, sizeof(magic));
+    if(!file || memcmp(magic, SAVE_GAME_MAGIC, sizeof(SAVE_GAME_MAGIC)) != 0) {
+        file.close();
+        return ReadLuaSaveGame(filename, data);
+    }
+
+    file.seekg(0, std::ios::end);
+    std::vector<uint8> buffer(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char *>(&buffer[0]), buffer.size());
+    if(!file) {
+        PRINT_ERROR << "Couldn't read the saved game: " << filename << std::endl;
+        return false;
+    }
+    file.close();
+
+    if(!ReadBinarySaveGame(filename, buffer, data)) {
+        data = SaveGameData();
+        return false;
+    }
+    return true;
+}
+
+bool WriteSaveGame(const SaveGameData &data, const std::string &filename)
+{
+    if(IsLuaSaveFilename(filename))
+        return WriteLuaSaveGame(data, filename);
+
+    std::vector<uint8> buffer;
+    WriteBinarySaveGame(data, buffer);
+    return WriteFileToDisk(filename, buffer);
+}
+
+bool ReadSavePreview(const std::string &filename, SavePreviewData &preview)
+{
+    preview = SavePreviewData();
+
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    file.seekg(0, std::ios::end);
+    std::vector<uint8> buffer(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if(buffer.empty() || !file.read(reinterpret_cast<char *>(&buffer[0]), buffer.size()))
+        return false;
+    file.close();
+
+    SaveGameReader reader(&buffer[0], buffer.size());
+    const uint8 *magic = reader.ReadData(sizeof(SAVE_PREVIEW_MAGIC));
+    uint32 version = 0;
+    uint32 byte_order = 0;
+    uint32 save_time = 0;
+    uint32 num_characters = 0;
+    // An outdated preview isn't an error, it is only rebuilt.
+    if(magic == NULL || memcmp(magic, SAVE_PREVIEW_MAGIC, sizeof(SAVE_PREVIEW_MAGIC)) != 0
+            || !reader.ReadUInt(version) || version != SAVE_PREVIEW_VERSION
+            || !reader.ReadUInt(byte_order) || byte_order != SAVE_GAME_BYTE_ORDER
+            || !reader.ReadString(preview.save_filename) || !reader.ReadUInt(save_time)
+            || !reader.ReadString(preview.language)
+            || !reader.ReadString(preview.map_data_filename) || !reader.ReadString(preview.map_script_filename)
+            || !reader.ReadUString(preview.map_hud_name) || !reader.ReadString(preview.map_image_filename)
+            || !reader.ReadUInt(preview.play_hours) || !reader.ReadUInt(preview.play_minutes)
+            || !reader.ReadUInt(preview.play_seconds) || !reader.ReadUInt(preview.drunes)
+            || !reader.ReadSize(num_characters, 6 * sizeof(uint32))) {
+        preview = SavePreviewData();
+        return false;
+    }
+    preview.save_time = static_cast<time_t>(save_time);
+
+    preview.characters.resize(num_characters);
+    for(uint32 i = 0; i < num_characters; ++i) {
+        SavePreviewCharacterData &character = preview.characters[i];
+        if(!reader.ReadUInt(character.id) || !reader.ReadUString(character.name)
+                || !reader.ReadString(character.portrait_filename)
+                || !reader.ReadUInt(character.experience_level)
+                || !reader.ReadUInt(character.max_hit_points) || !reader.ReadUInt(character.hit_points)
+                || !reader.ReadUInt(character.max_skill_points) || !reader.ReadUInt(character.skill_points)) {
+            preview = SavePreviewData();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool WriteSavePreview(const SavePreviewData &preview, const std::string &filename)
+{
+    SaveGameBuffer buffer;
+    buffer.WriteData(SAVE_PREVIEW_MAGIC, sizeof(SAVE_PREVIEW_MAGIC));
+    buffer.WriteUInt(SAVE_PREVIEW_VERSION);
+    buffer.WriteUInt(SAVE_GAME_BYTE_ORDER);
+
+    buffer.WriteString(preview.save_filename);
+    buffer.WriteUInt(static_cast<uint32>(preview.save_time));
+    buffer.WriteString(preview.language);
+    buffer.WriteString(preview.map_data_filename);
+    buffer.WriteString(preview.map_script_filename);
+    buffer.WriteUString(preview.map_hud_name);
+    buffer.WriteString(preview.map_image_filename);
+    buffer.WriteUInt(preview.play_hours);
+    buffer.WriteUInt(preview.play_minutes);
+    buffer.WriteUInt(preview.play_seconds);
+    buffer.WriteUInt(preview.drunes);
+
+    buffer.WriteUInt(preview.characters.size());
+    for(uint32 i = 0; i < preview.characters.size(); ++i) {
+        const SavePreviewCharacterData &character = preview.characters[i];
+        buffer.WriteUInt(character.id);
+        buffer.WriteUString(character.name);
+        buffer.WriteString(character.portrait_filename);
+        buffer.WriteUInt(character.experience_level);
+        buffer.WriteUInt(character.max_hit_points);
+        buffer.WriteUInt(character.hit_points);
+        buffer.WriteUInt(character.max_skill_points);
+        buffer.WriteUInt(character.skill_points);
+    }
+
+    return WriteFileToDisk(filename, buffer.GetBuffer());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SaveGameWriter class
+////////////////////////////////////////////////////////////////////////////////
+
+SaveGameWriter::SaveGameWriter() :
+    _thread(NULL),
+    _done(true),
+    _result(true)
+{}
+
+SaveGameWriter::~SaveGameWriter()
+{
+    Wait();
+}
+
+void SaveGameWriter::Start(const SaveGameData &data, const std::string &filename,
+                           const SavePreviewData &preview, const std::string &preview_filename)
+{
+    Wait();
+
+    _data = data;
+    _filename = filename;
+    _preview = preview;
+    _preview_filename = preview_filename;
+    _done = false;
+
+#if (THREAD_TYPE == SDL_THREADS)
+    // The Lua format is written through the script engine, which isn't thread safe.
+    if(!IsLuaSaveFilename(filename)) {
+        _thread = SystemManager->SpawnThread(&SaveGameWriter::_WriteThread, this);
+        if(_thread != NULL)
+            return;
+        PRINT_WARNING << "Couldn't create the saved game writing thread, the game will be saved by the main thread." << std::endl;
+    }
+#endif
+
+    _WriteThread();
+}
+
+bool SaveGameWriter::Wait()
+{
+    if(_thread != NULL) {
+        SystemManager->WaitForThread(_thread);
+        _thread = NULL;
+    }
+    return _result;
+}
+
+void SaveGameWriter::_WriteThread()
+{
+    _result = WriteSaveGame(_data, _filename);
+
+    // The preview tells which saved game it was made for, so that an outdated one is never shown.
+    if(_result && !_preview_filename.empty()) {
+        _preview.save_filename = _filename;
+        _preview.save_time = GetFileModificationTime(_filename);
+        if(!WriteSavePreview(_preview, _preview_filename))
+            PRINT_WARNING << "Couldn't write the saved game preview: " << _preview_filename << std::endl;
+    }
+
+    _data = SaveGameData();
+    _done = true;
+}
+
+} // namespace private_global
+
+} // namespace vt_global
@@ -0,0 +1,279 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    global_save.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the saved game files
+***
+*** A saved game is first copied into a plain SaveGameData structure, which
+*** doesn't refer to any live game object. That copy is cheap, so it is done
+*** on the main thread, while the file is written by a background thread.
+***
+*** Saved games are written in a versioned binary format, made of sections
+*** which older readers skip when they don't know them. The former Lua format
+*** is still read, and can be written as well to inspect or edit a save.
+***
+*** A small preview file is written next to each saved game, holding only what
+*** the save menu displays, so that browsing the slots doesn't read the saves.
+*** ***************************************************************************/
+
+#ifndef __GLOBAL_SAVE_HEADER__
+#define __GLOBAL_SAVE_HEADER__
+
+#include "utils/ustring.h"
+
+namespace vt_global
+{
+
+namespace private_global
+{
+
+//! \brief The number of inventory categories stored in a saved game.
+const uint32 SAVE_INVENTORY_CATEGORIES = 7;
+
+//! \brief The saved data of a character.
+class SaveCharacterData
+{
+public:
+    SaveCharacterData();
+
+    uint32 id;
+    bool enabled;
+
+    uint32 experience_level;
+    uint32 experience_points;
+    int32 experience_points_next;
+
+    uint32 max_hit_points;
+    uint32 hit_points;
+    uint32 max_skill_points;
+    uint32 skill_points;
+
+    uint32 strength;
+    uint32 vigor;
+    uint32 fortitude;
+    uint32 protection;
+    uint32 agility;
+    float evade;
+
+    //! \brief The equipped weapon, head, torso, arm and leg armor ids, 0 when none.
+    uint32 weapon;
+    uint32 head_armor;
+    uint32 torso_armor;
+    uint32 arm_armor;
+    uint32 leg_armor;
+
+    //! \brief The permanent skills. The equipment skills come back with the equipment.
+    std::vector<uint32> skills;
+};
+
+//! \brief The saved data of an event group.
+class SaveEventGroupData
+{
+public:
+    std::string name;
+
+    //! \brief The event names and values.
+    std::vector<std::pair<std::string, int32> > events;
+};
+
+//! \brief The saved data of a quest log entry.
+class SaveQuestData
+{
+public:
+    SaveQuestData() :
+        log_number(0), is_read(false) {}
+
+    std::string id;
+    uint32 log_number;
+    bool is_read;
+};
+
+/** ****************************************************************************
+*** \brief A copy of everything stored in a saved game
+***
+*** \note The play time is kept as hours, minutes and seconds, as given by the
+*** system engine.
+*** ***************************************************************************/
+class SaveGameData
+{
+public:
+    SaveGameData();
+
+    std::string map_data_filename;
+    std::string map_script_filename;
+
+    //! \brief The save position, in map tiles.
+    uint32 location_x;
+    uint32 location_y;
+
+    uint32 play_hours;
+    uint32 play_minutes;
+    uint32 play_seconds;
+
+    uint32 drunes;
+
+    /** \brief The object ids and counts of each inventory category
+    *** The equipped objects are stored with the characters instead.
+    **/
+    std::vector<std::pair<uint32, uint32> > inventory[SAVE_INVENTORY_CATEGORIES];
+
+    //! \brief The characters, in the party order.
+    std::vector<SaveCharacterData> characters;
+
+    std::vector<SaveEventGroupData> event_groups;
+
+    std::vector<SaveQuestData> quests;
+
+    std::string world_map_filename;
+    std::vector<std::string> viewable_locations;
+    std::string current_location;
+};
+
+//! \brief The preview data of a character.
+class SavePreviewCharacterData
+{
+public:
+    SavePreviewCharacterData();
+
+    uint32 id;
+
+    //! \brief The translated character name.
+    vt_utils::ustring name;
+    std::string portrait_filename;
+
+    uint32 experience_level;
+    uint32 max_hit_points;
+    uint32 hit_points;
+    uint32 max_skill_points;
+    uint32 skill_points;
+};
+
+/** ****************************************************************************
+*** \brief The data shown by the save menu for a saved game
+***
+*** \note The texts are stored translated, so the preview is only valid for
+*** the language it was written in.
+*** ***************************************************************************/
+class SavePreviewData
+{
+public:
+    SavePreviewData();
+
+    //! \brief The saved game file, and its modification time once written.
+    std::string save_filename;
+    time_t save_time;
+
+    //! \brief The language the texts were translated in.
+    std::string language;
+
+    std::string map_data_filename;
+    std::string map_script_filename;
+
+    //! \brief The translated map name, and the map image.
+    vt_utils::ustring map_hud_name;
+    std::string map_image_filename;
+
+    uint32 play_hours;
+    uint32 play_minutes;
+    uint32 play_seconds;
+
+    uint32 drunes;
+
+    //! \brief The first characters of the party, up to four.
+    std::vector<SavePreviewCharacterData> characters;
+};
+
+/** \brief Reads a saved game file, in the binary or in the Lua format.
+*** \return false if the file couldn't be read or isn't a valid saved game.
+**/
+bool ReadSaveGame(const std::string &filename, SaveGameData &data);
+
+/** \brief Writes a saved game file, in the Lua format if the filename ends with ".lua",
+*** or in the binary format otherwise.
+*** \return false if the file couldn't be entirely written.
+***
+*** The binary file is first written under a temporary name, flushed to the
+*** disk, and then renamed, so a former save is never left half overwritten.
+**/
+bool WriteSaveGame(const SaveGameData &data, const std::string &filename);
+
+/** \brief Reads a saved game preview file.
+*** \return false if the file is missing or invalid.
+**/
+bool ReadSavePreview(const std::string &filename, SavePreviewData &preview);
+
+//! \brief Writes a saved game preview file. \return false if it couldn't be entirely written.
+bool WriteSavePreview(const SavePreviewData &preview, const std::string &filename);
+
+/** ****************************************************************************
+*** \brief Writes the saved games on a background thread
+***
+*** The main thread hands over a copy of the game data, and the file is then
+*** serialized and flushed to the disk without blocking the frames. A single
+*** saved game is written at a time.
+***
+*** \note All the methods must be called from the main thread.
+*** ***************************************************************************/
+class SaveGameWriter
+{
+public:
+    SaveGameWriter();
+
+    //! \brief Waits for the file being written, if any.
+    ~SaveGameWriter();
+
+    /** \brief Starts writing a saved game file, and its preview file
+    *** The previous saved game is waited for first. The file is written by the
+    *** calling thread when no thread can be created.
+    *** The preview is written once the saved game is, unless its filename is empty.
+    **/
+    void Start(const SaveGameData &data, const std::string &filename,
+               const SavePreviewData &preview, const std::string &preview_filename);
+
+    //! \brief Tells whether a saved game file is still being written.
+    bool IsWriting() const {
+        return (_thread != NULL && !_done);
+    }
+
+    /** \brief Waits until the current saved game file, if any, is written.
+    *** \return Whether the last saved game file was entirely written.
+    **/
+    bool Wait();
+
+private:
+    //! \brief The data being written.
+    SaveGameData _data;
+
+    //! \brief The file being written.
+    std::string _filename;
+
+    //! \brief The preview of the data being written, and its file.
+    SavePreviewData _preview;
+    std::string _preview_filename;
+
+    //! \brief The writing thread, or NULL when none was waited for yet.
+    Thread *_thread;
+
+    //! \brief Set by the writing thread once done.
+    volatile bool _done;
+
+    //! \brief Whether the last file was entirely written.
+    bool _result;
+
+    //! \brief The writing thread function.
+    void _WriteThread();
+}; // class SaveGameWriter
+
+} // namespace private_global
+
+} // namespace vt_global
+
+#endif // __GLOBAL_SAVE_HEADER__
@@ -652,15 +652,15 @@ void Editor::_TileLayerFill()
         multiplier = _grid->tileset_def_names.indexOf(_ed_tabs->tabText(_ed_tabs->currentIndex()));
     } // calculate index of current tileset
 
-    std::vector<std::vector<int32> >& current_layer = _grid->GetCurrentLayer();
+    vt_utils::FlatGrid<int32>& current_layer = _grid->GetCurrentLayer();
 
     // Record the information for undo/redo operations.
     std::vector<int32> previous;
     std::vector<int32> modified;
     std::vector<QPoint> indeces;;
 
-    for(uint32 y = 0; y < current_layer.size(); ++y) {
-        for(uint32 x = 0; x < current_layer[y].size(); ++x) {
+    for(uint32 y = 0; y < current_layer.GetHeight(); ++y) {
+        for(uint32 x = 0; x < current_layer.GetWidth(); ++x) {
             // Stores the indeces
             indeces.push_back(QPoint(x, y));
             previous.push_back(current_layer[y][x]);
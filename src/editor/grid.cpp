@@ -23,6 +23,8 @@
 #include "engine/script/script_write.h"
 #include "engine/script/script_read.h"
 
+#include "modes/map/map_data.h"
+
 #include "utils/utils_random.h"
 
 #include <QScrollBar>
@@ -94,13 +96,8 @@ Grid::Grid(QWidget *parent, const QString &name, uint32 width, uint32 height) :
 
     // Initialize layers with -1 to indicate that no tile/object/etc. is
     // present at this location
-    _select_layer.resize(_height);
-    for(uint32 y = 0; y < _height; ++y) {
-        _select_layer[y].resize(_width);
-        for(uint32 x = 0; x < _width; ++x) {
-            _select_layer[y][x] = -1;
-        }
-    }
+    _select_layer.Resize(_width, _height);
+    _select_layer.Fill(-1);
 
     // Create default base layers
     _tile_layers.resize(4);
@@ -115,21 +112,9 @@ Grid::Grid(QWidget *parent, const QString &name, uint32 width, uint32 height) :
     _tile_layers[3].name = tr("Sky").toStdString();
 
     // Set up its size, and fill it with empty values
-    _tile_layers[0].tiles.resize(_height);
-    _tile_layers[1].tiles.resize(_height);
-    _tile_layers[2].tiles.resize(_height);
-    _tile_layers[3].tiles.resize(_height);
-    for(uint32 y = 0; y < _height; ++y) {
-        _tile_layers[0].tiles[y].resize(_width);
-        _tile_layers[1].tiles[y].resize(_width);
-        _tile_layers[2].tiles[y].resize(_width);
-        _tile_layers[3].tiles[y].resize(_width);
-        for(uint32 x = 0; x < _width; ++x) {
-            _tile_layers[0].tiles[y][x] = -1;
-            _tile_layers[1].tiles[y][x] = -1;
-            _tile_layers[2].tiles[y][x] = -1;
-            _tile_layers[3].tiles[y][x] = -1;
-        }
+    for(uint32 i = 0; i < _tile_layers.size(); ++i) {
+        _tile_layers[i].Resize(_width, _height);
+        _tile_layers[i].Fill(-1);
     }
 
     // Creates the graphic view
@@ -208,11 +193,7 @@ Grid::~Grid()
 
 void Grid::ClearSelectionLayer()
 {
-    for(uint32 y = 0; y < _height; ++y) {
-        for(uint32 x = 0; x < _width; ++x) {
-            _select_layer[y][x] = -1;
-        }
-    }
+    _select_layer.Fill(-1);
 }
 
 bool Grid::LoadMap()
@@ -262,13 +243,8 @@ bool Grid::LoadMap()
     setSceneRect(0, 0, _width * TILE_WIDTH, _height * TILE_HEIGHT);
 
     // Create selection layer
-    _select_layer.resize(_height);
-    for(uint32 y = 0; y < _height; ++y) {
-        _select_layer[y].resize(_width);
-        for(uint32 x = 0; x < _width; ++x) {
-            _select_layer[y][x] = -1;
-        }
-    }
+    _select_layer.Resize(_width, _height);
+    _select_layer.Fill(-1);
 
     // Loads the tileset definition filenames
     tileset_def_names.clear();
@@ -320,6 +296,9 @@ bool Grid::LoadMap()
         // the layer visible name
         _tile_layers[layer_id].name = read_data.ReadString("name");
 
+        // Prepare the layer rows
+        _tile_layers[layer_id].Resize(_width, _height);
+
         // Parse layers[layer_id].tiles[y]
         for(uint32 y = 0; y < _height; ++y) {
             if(!read_data.DoesTableExist(y)) {
@@ -332,9 +311,6 @@ bool Grid::LoadMap()
 
             read_data.ReadIntVector(y, vect);
 
-            // Prepare the the row
-            _tile_layers[layer_id].tiles.resize(y + 1);
-
             if(vect.size() != _width) {
                 read_data.CloseFile();
                 QMessageBox::warning(_graphics_view, message_box_title,
@@ -343,8 +319,7 @@ bool Grid::LoadMap()
                 return false;
             }
 
-            for(std::vector<int32>::iterator it = vect.begin(); it != vect.end(); ++it)
-                _tile_layers[layer_id].tiles[y].push_back(*it);
+            std::copy(vect.begin(), vect.end(), _tile_layers[layer_id].tiles[y]);
             vect.clear();
         } // iterate through the rows of the layer
 
@@ -515,10 +490,19 @@ void Grid::SaveMap()
 
     write_data.CloseFile();
 
+    // Write the binary map cache along, so that the game doesn't have to parse the map data file.
+    vt_map::private_map::MapData map_data;
+    std::string map_filename = _file_name.toStdString();
+    if(!map_data.LoadScript(map_filename)
+            || !map_data.SaveCache(vt_map::private_map::MapData::GetCacheFilename(map_filename))) {
+        QMessageBox::warning(_graphics_view, "Saving File...",
+                             QString("ERROR: could not write the map cache of %1!").arg(_file_name));
+    }
+
     _changed = false;
 } // Grid::SaveMap()
 
-std::vector<std::vector<int32> >& Grid::GetCurrentLayer()
+vt_utils::FlatGrid<int32>& Grid::GetCurrentLayer()
 {
     return GetLayers()[_layer_id].tiles;
 }
@@ -603,27 +587,10 @@ void Grid::InsertRow(uint32 tile_index_y)
     if (tile_index_y >= _height)
         return;
 
-    // Prepare an empty row (filled with -1.)
-    std::vector<int32> row;
-    row.resize(_width, -1);
-
     std::vector<Layer>::iterator it = _tile_layers.begin();
     std::vector<Layer>::iterator it_end = _tile_layers.end();
-    for(; it != it_end; ++it) {
-        Layer& layer = (*it);
-
-        // We do it naively so it's more portable...
-        std::vector< std::vector<int32> >::iterator tile_y_it = layer.tiles.begin();
-        uint32 y = 0; // the row index
-        for (; tile_y_it != layer.tiles.end(); ++tile_y_it) {
-            // If the wanted index is found we can delete and break.
-            if (y == tile_index_y) {
-                layer.tiles.insert(tile_y_it, row);
-                break;
-            }
-            ++y;
-        }
-    }
+    for(; it != it_end; ++it)
+        it->tiles.InsertRow(tile_index_y, -1); // Insert an empty row.
 
     // Updates every related map members.
     Resize(_width, _height + 1);
@@ -636,26 +603,10 @@ void Grid::InsertCol(uint32 tile_index_x)
     if (tile_index_x >= _width)
         return;
 
-
     std::vector<Layer>::iterator it = _tile_layers.begin();
     std::vector<Layer>::iterator it_end = _tile_layers.end();
-    for(; it != it_end; ++it) {
-        Layer& layer = (*it);
-
-        // We do it naively so it's more portable...
-        for (uint32 y = 0; y < layer.tiles.size(); ++y) {
-            std::vector<int32>::iterator tile_x_it = layer.tiles[y].begin();
-            uint32 x = 0; // the column index
-            for (; tile_x_it != layer.tiles[y].end(); ++tile_x_it) {
-                // If the wanted index is found we can delete and break.
-                if (x == tile_index_x) {
-                    layer.tiles[y].insert(tile_x_it, -1); // Insert an empty tile.
-                    break;
-                }
-                ++x;
-            }
-        } // for each rows
-    }
+    for(; it != it_end; ++it)
+        it->tiles.InsertColumn(tile_index_x, -1); // Insert an empty column.
 
     // Updates every related map members.
     Resize(_width + 1, _height);
@@ -675,21 +626,8 @@ void Grid::DeleteRow(uint32 tile_index_y)
 
     std::vector<Layer>::iterator it = _tile_layers.begin();
     std::vector<Layer>::iterator it_end = _tile_layers.end();
-    for(; it != it_end; ++it) {
-        Layer& layer = (*it);
-
-        // We do it naively so it's more portable...
-        std::vector< std::vector<int32> >::iterator tile_y_it = layer.tiles.begin();
-        uint32 y = 0; // the row index
-        for (; tile_y_it != layer.tiles.end(); ++tile_y_it) {
-            // If the wanted index is found we can delete and break.
-            if (y == tile_index_y) {
-                layer.tiles.erase(tile_y_it);
-                break;
-            }
-            ++y;
-        }
-    }
+    for(; it != it_end; ++it)
+        it->tiles.EraseRow(tile_index_y);
 
     // Updates every related map members.
     Resize(_width, _height - 1);
@@ -710,23 +648,8 @@ void Grid::DeleteCol(uint32 tile_index_x)
 
     std::vector<Layer>::iterator it = _tile_layers.begin();
     std::vector<Layer>::iterator it_end = _tile_layers.end();
-    for(; it != it_end; ++it) {
-        Layer& layer = (*it);
-
-        // We do it naively so it's more portable...
-        for (uint32 y = 0; y < layer.tiles.size(); ++y) {
-            std::vector<int32>::iterator tile_x_it = layer.tiles[y].begin();
-            uint32 x = 0; // the column index
-            for (; tile_x_it != layer.tiles[y].end(); ++tile_x_it) {
-                // If the wanted index is found we can delete and break.
-                if (x == tile_index_x) {
-                    layer.tiles[y].erase(tile_x_it);
-                    break;
-                }
-                ++x;
-            }
-        } // for each rows
-    }
+    for(; it != it_end; ++it)
+        it->tiles.EraseColumn(tile_index_x);
 
     // Updates every related map members.
     Resize(_width - 1, _height);
@@ -770,9 +693,9 @@ void Grid::UpdateScene()
     setSceneRect(0, 0, _width * TILE_WIDTH, _height * TILE_HEIGHT);
     setBackgroundBrush(QBrush(Qt::gray));
 
-    // Start drawing from the top left
-    for (uint32 x = 0; x < _width; ++x) {
-        for (uint32 y = 0; y < _height; ++y) {
+    // Start drawing from the top left, row by row
+    for (uint32 y = 0; y < _height; ++y) {
+        for (uint32 x = 0; x < _width; ++x) {
             for(uint32 layer_id = 0; layer_id < _tile_layers.size(); ++layer_id) {
                 // Don't draw the layer if it's not visible
                 if(!_tile_layers[layer_id].visible)
@@ -833,6 +756,8 @@ void Grid::Resize(int w, int h)
     setSceneRect(0, 0, w, h);
     _width = w;
     _height = h;
+    // Keep the selection layer the same size as the tile layers.
+    _select_layer.Resize(_width, _height, -1);
     _changed = true;
     UpdateScene();
 } // Grid::Resize(...)
@@ -1008,9 +933,9 @@ void Grid::mouseReleaseEvent(QGraphicsSceneMouseEvent *evt)
     switch(_tile_mode) {
     case PAINT_TILE: { // wrap up painting tiles
         if(editor->_select_on == true) {
-            std::vector<std::vector<int32> > select_layer = GetSelectionLayer();
-            for(int32 y = 0; y < static_cast<int32>(select_layer.size()); ++y) {
-                for(int32 x = 0; x < static_cast<int32>(select_layer[y].size()); ++x) {
+            const vt_utils::FlatGrid<int32>& select_layer = GetSelectionLayer();
+            for(int32 y = 0; y < static_cast<int32>(select_layer.GetHeight()); ++y) {
+                for(int32 x = 0; x < static_cast<int32>(select_layer.GetWidth()); ++x) {
                     // Works because the selection layer and the current layer
                     // have the same size.
                     if(select_layer[y][x] != -1)
@@ -1035,7 +960,7 @@ void Grid::mouseReleaseEvent(QGraphicsSceneMouseEvent *evt)
             // record location of released tile
             _tile_index_x = mouse_x / TILE_WIDTH;
             _tile_index_y = mouse_y / TILE_HEIGHT;
-            std::vector<std::vector<int32> >& layer = GetCurrentLayer();
+            vt_utils::FlatGrid<int32>& layer = GetCurrentLayer();
 
             if(editor->_select_on == false) {
                 // Record information for undo/redo action.
@@ -1051,9 +976,9 @@ void Grid::mouseReleaseEvent(QGraphicsSceneMouseEvent *evt)
                 layer[_move_source_index_y][_move_source_index_x] = -1;
             } // only moving one tile at a time
             else {
-                std::vector<std::vector<int32> > select_layer = GetSelectionLayer();
-                for(int32 y = 0; y < static_cast<int32>(select_layer.size()); ++y) {
-                    for(int32 x = 0; x < static_cast<int32>(select_layer[y].size()); ++x) {
+                const vt_utils::FlatGrid<int32>& select_layer = GetSelectionLayer();
+                for(int32 y = 0; y < static_cast<int32>(select_layer.GetHeight()); ++y) {
+                    for(int32 x = 0; x < static_cast<int32>(select_layer.GetWidth()); ++x) {
                         // Works because the selection layer and the current layer
                         // have the same size.
                         if(select_layer[y][x] != -1) {
@@ -1089,9 +1014,9 @@ void Grid::mouseReleaseEvent(QGraphicsSceneMouseEvent *evt)
 
     case DELETE_TILE: { // wrap up deleting tiles
         if(editor->_select_on == true) {
-            std::vector<std::vector<int32> > select_layer = GetSelectionLayer();
-            for(int32 y = 0; y < static_cast<int32>(select_layer.size()); ++y) {
-                for(int32 x = 0; x < static_cast<int32>(select_layer[y].size()); ++x) {
+            const vt_utils::FlatGrid<int32>& select_layer = GetSelectionLayer();
+            for(int32 y = 0; y < static_cast<int32>(select_layer.GetHeight()); ++y) {
+                for(int32 x = 0; x < static_cast<int32>(select_layer.GetWidth()); ++x) {
                     // Works because the selection layer and the current layer
                     // are the same size.
                     if(select_layer[y][x] != -1)
@@ -25,6 +25,8 @@
 
 #include "tileset.h"
 
+#include "utils/utils_grid.h"
+
 namespace vt_editor
 {
 
@@ -88,7 +90,7 @@ public:
     std::string name;
     LAYER_TYPE layer_type;
     // Represents the tile indeces: i.e: tiles[y][x] = tile_id at (x,y)
-    std::vector< std::vector<int32> > tiles;
+    vt_utils::FlatGrid<int32> tiles;
     // Tells whether the layer is currently visible.
     bool visible;
 
@@ -99,17 +101,12 @@ public:
 
     // Resize a layer to the given map size
     void Resize(uint32 width, uint height) {
-        tiles.resize(height);
-        for(uint32 y = 0; y < height; ++y)
-            tiles[y].resize(width);
+        tiles.Resize(width, height);
     }
 
     // Fill a layer with the given tile index value.
     void Fill(int32 tile_id = -1) {
-        for(uint32 y = 0; y < tiles.size(); ++y) {
-            for(uint32 x = 0; x < tiles[y].size(); ++x)
-                tiles[y][x] = tile_id;
-        }
+        tiles.Fill(tile_id);
     }
 };
 
@@ -165,7 +162,7 @@ public:
         return _tile_layers;
     }
 
-    std::vector<std::vector<int32> >& GetSelectionLayer() {
+    vt_utils::FlatGrid<int32>& GetSelectionLayer() {
         return _select_layer;
     }
 
@@ -306,13 +303,13 @@ private:
     *** nor the game. It acts similar to an actual tile layer as far as drawing
     *** is concerned.
     **/
-    std::vector<std::vector<int32> > _select_layer;
+    vt_utils::FlatGrid<int32> _select_layer;
 
     // Draw the tile grid (actually adds the line to the graphics scene)
     void _DrawGrid();
 
     //! Gets currently edited layer
-    std::vector<std::vector<int32> >& GetCurrentLayer();
+    vt_utils::FlatGrid<int32>& GetCurrentLayer();
 
 protected:
     //! \name Mouse Processing Functions
@@ -149,6 +149,10 @@ bool AudioEngine::SingletonInitialize()
         return false;
     }
 
+    // Without the system engine, the streams are updated by the main thread.
+    if(SystemManager != NULL)
+        _streamer.Start();
+
     return true;
 } // bool AudioEngine::SingletonInitialize()
 
@@ -157,6 +161,11 @@ AudioEngine::~AudioEngine()
     if(!AUDIO_ENABLE)
         return;
 
+    // The sources are deleted before some of the descriptors using them,
+    // so the streaming thread is stopped first and the descriptors given back.
+    _streamer.Stop();
+    _pcm_cache.Stop();
+
     // Delete all entries in the sound cache
     for(std::map<std::string, private_audio::AudioCacheElement>::iterator i = _audio_cache.begin(); i != _audio_cache.end(); ++i) {
         delete i->second.audio;
@@ -213,9 +222,14 @@ AudioEngine::~AudioEngine()
 
 void AudioEngine::Update()
 {
+    ProfilerScope marker("AudioEngine::Update");
+
     if(!AUDIO_ENABLE)
         return;
 
+    _streamer.DispatchEvents();
+    _pcm_cache.Update();
+
     for(std::vector<AudioSource *>::iterator i = _audio_sources.begin(); i != _audio_sources.end(); ++i) {
         if((*i)->owner) {
             (*i)->owner->_Update();
@@ -235,11 +249,8 @@ void AudioEngine::SetSoundVolume(float volume)
         _sound_volume = volume;
     }
 
-    for(std::vector<SoundDescriptor *>::iterator i = _registered_sounds.begin(); i != _registered_sounds.end(); ++i) {
-        if((*i)->_source != NULL) {
-            alSourcef((*i)->_source->source, AL_GAIN, _sound_volume * (*i)->GetVolume());
-        }
-    }
+    for(std::vector<SoundDescriptor *>::iterator i = _registered_sounds.begin(); i != _registered_sounds.end(); ++i)
+        (*i)->_ApplyGain();
 }
 
 void AudioEngine::SetMusicVolume(float volume)
@@ -254,11 +265,8 @@ void AudioEngine::SetMusicVolume(float volume)
         _music_volume = volume;
     }
 
-    for(std::vector<MusicDescriptor *>::iterator i = _registered_music.begin(); i != _registered_music.end(); ++i) {
-        if((*i)->_source != NULL) {
-            alSourcef((*i)->_source->source, AL_GAIN, _music_volume * (*i)->GetVolume());
-        }
-    }
+    for(std::vector<MusicDescriptor *>::iterator i = _registered_music.begin(); i != _registered_music.end(); ++i)
+        (*i)->_ApplyGain();
 }
 
 void AudioEngine::PauseAllSounds()
@@ -380,6 +388,23 @@ bool AudioEngine::LoadMusic(const std::string &filename, vt_mode_manager::GameMo
     return _LoadAudio(filename, true, gm);
 }
 
+void AudioEngine::PreloadSound(const std::string &filename)
+{
+    if(!AUDIO_ENABLE)
+        return;
+
+    _pcm_cache.Preload(filename);
+}
+
+void AudioEngine::PreloadSounds(const std::vector<std::string> &filenames)
+{
+    if(!AUDIO_ENABLE)
+        return;
+
+    for(uint32 i = 0; i < filenames.size(); ++i)
+        _pcm_cache.Preload(filenames[i]);
+}
+
 void AudioEngine::PlaySound(const std::string &filename)
 {
     std::map<std::string, AudioCacheElement>::iterator element = _audio_cache.find(filename);
@@ -561,6 +586,14 @@ void AudioEngine::DEBUG_PrintInfo()
 
     PRINT_WARNING << "Maximum number of sources:   " << _max_sources << std::endl;
     PRINT_WARNING << "Maximum audio cache size:    " << _max_cache_size << std::endl;
+    PRINT_WARNING << "Streaming thread:            " << (_streamer.IsRunning() ? "yes" : "no") << std::endl;
+    PRINT_WARNING << "Streaming underruns:         " << _streamer.GetNumberUnderruns() << std::endl;
+    PRINT_WARNING << "PCM cache budget:            " << _pcm_cache.GetBudget() << " bytes" << std::endl;
+    PRINT_WARNING << "PCM cache resident size:     " << _pcm_cache.GetResidentSize() << " bytes in "
+                  << _pcm_cache.GetNumberEntries() << " sounds" << std::endl;
+    PRINT_WARNING << "PCM cache hits/misses:       " << _pcm_cache.GetNumberHits() << "/"
+                  << _pcm_cache.GetNumberMisses() << std::endl;
+    PRINT_WARNING << "PCM cache evictions:         " << _pcm_cache.GetNumberEvictions() << std::endl;
     PRINT_WARNING << "Default audio device:        " << alcGetString(_device, ALC_DEFAULT_DEVICE_SPECIFIER) << std::endl;
     PRINT_WARNING << "OpenAL Version:              " << alGetString(AL_VERSION) << std::endl;
     PRINT_WARNING << "OpenAL Renderer:             " << alGetString(AL_RENDERER) << std::endl;
@@ -597,8 +630,12 @@ private_audio::AudioSource *AudioEngine::_AcquireAudioSource()
         }
     }
 
-    // (2) If all sources are owned, find one that is in the initial or stopped state and change its ownership
+    // (2) If all sources are owned, find one that is in the initial or stopped state and change its ownership.
+    // The sources used by the streaming thread are never taken.
     for(std::vector<AudioSource *>::iterator i = _audio_sources.begin(); i != _audio_sources.end(); ++i) {
+        if((*i)->owner->_stream_attached)
+            continue;
+
         ALint state;
         alGetSourcei((*i)->source, AL_SOURCE_STATE, &state);
         if(state == AL_INITIAL || state == AL_STOPPED) {
@@ -29,6 +29,7 @@
 
 #include "audio_descriptor.h"
 #include "audio_effects.h"
+#include "audio_pcm_cache.h"
 
 //! \brief All related audio engine code is wrapped within this namespace
 namespace vt_audio
@@ -89,6 +90,7 @@ class AudioEngine : public vt_utils::Singleton<AudioEngine>
     friend class SoundDescriptor;
     friend class MusicDescriptor;
     friend class Effects;
+    friend class private_audio::AudioStreamer;
 
 public:
     ~AudioEngine();
@@ -330,6 +332,36 @@ public:
     const std::string CreateALCErrorString();
     //@}
 
+    /** \name PCM Cache Functions
+    *** \brief Used to manage the cache of the decoded static sounds
+    ***
+    *** The game modes declare the sounds they will use through the preload functions,
+    *** so that they are decoded in the background before the sound descriptors load them.
+    **/
+    //@{
+    //! \brief Requests a sound file to be decoded ahead of its loading.
+    void PreloadSound(const std::string &filename);
+
+    //! \brief Requests several sound files to be decoded ahead of their loading.
+    void PreloadSounds(const std::vector<std::string> &filenames);
+
+    /** \brief Sets the memory budget of the decoded sounds no descriptor uses anymore
+    *** \param budget The budget in bytes
+    **/
+    void SetPCMCacheBudget(uint32 budget) {
+        _pcm_cache.SetBudget(budget);
+    }
+
+    const private_audio::PCMCache &GetPCMCache() const {
+        return _pcm_cache;
+    }
+    //@}
+
+    //! \brief Returns the number of times the streaming buffers ran out while playing, over all the streams.
+    uint32 GetNumberStreamUnderruns() const {
+        return _streamer.GetNumberUnderruns();
+    }
+
     //! \brief Prints information about the audio properties and settings of the user's machine
     void DEBUG_PrintInfo();
 
@@ -402,6 +434,12 @@ private:
     **/
     uint16 _max_cache_size;
 
+    //! \brief The thread decoding and queueing the streamed audio buffers.
+    private_audio::AudioStreamer _streamer;
+
+    //! \brief The decoded data of the static sounds.
+    private_audio::PCMCache _pcm_cache;
+
     /** \brief Acquires an available audio source that may be used
     *** \return A pointer to the available source, or NULL if no available source could be found
     *** \todo Add an algoihtm to give priority to some sounds/music over others.
@@ -117,7 +117,10 @@ AudioDescriptor::AudioDescriptor() :
     _volume(1.0f),
     _fade_effect_time(0.0f),
     _original_volume(0.0f),
-    _stream_buffer_size(0)
+    _stream_buffer_size(0),
+    _stream_attached(false),
+    _stream_sequence(0),
+    _number_underruns(0)
 {
     _position[0] = 0.0f;
     _position[1] = 0.0f;
@@ -142,7 +145,10 @@ AudioDescriptor::AudioDescriptor(const AudioDescriptor &copy) :
     _volume(copy._volume),
     _fade_effect_time(copy._fade_effect_time),
     _original_volume(copy._original_volume),
-    _stream_buffer_size(0)
+    _stream_buffer_size(0),
+    _stream_attached(false),
+    _stream_sequence(0),
+    _number_underruns(0)
 {
     _position[0] = 0.0f;
     _position[1] = 0.0f;
@@ -168,28 +174,23 @@ bool AudioDescriptor::LoadAudio(const std::string &filename, AUDIO_LOAD load_typ
     // Clean out any audio resources being used before trying to set new ones
     FreeAudio();
 
-    // Load the input file for the audio
-    if(filename.size() <= 3) {  // Name of file is at least 3 letters (so the extension is in there)
-        IF_PRINT_WARNING(AUDIO_DEBUG) << "file name argument is too short: " << filename << std::endl;
-        return false;
-    }
-    // Convert the file extension to uppercase and use it to create the proper input type
-    std::string file_extension = filename.substr(filename.size() - 3, 3);
-    file_extension = vt_utils::Upcase(file_extension);
-
-    // Based on the extension of the file, load properly one
-    if(file_extension.compare("WAV") == 0) {
-        _input = new WavFile(filename);
-    } else if(file_extension.compare("OGG") == 0) {
-        _input = new OggFile(filename);
+    // Load the input file for the audio.
+    // The static audio data is decoded once, and shared through the PCM cache.
+    if(load_type == AUDIO_LOAD_STATIC) {
+        _input = AudioManager->_pcm_cache.CreateInput(filename);
+        if(_input == NULL) {
+            IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to decode audio file: " << filename << std::endl;
+            return false;
+        }
     } else {
-        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed due to unsupported input file extension: " << file_extension << std::endl;
-        return false;
-    }
+        _input = CreateFileInput(filename);
+        if(_input == NULL)
+            return false;
 
-    if(_input->Initialize() == false) {
-        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to load and initialize audio file: " << filename << std::endl;
-        return false;
+        if(_input->Initialize() == false) {
+            IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to load and initialize audio file: " << filename << std::endl;
+            return false;
+        }
     }
 
     // Retreive audio data properties from the newly initialized input
@@ -213,18 +214,10 @@ bool AudioDescriptor::LoadAudio(const std::string &filename, AUDIO_LOAD load_typ
         // later we can delete it with a call of delete[], similar to the streaming cases
         _buffer = new AudioBuffer[1];
 
-        // Create space in memory for the audio data to be read and passed to the OpenAL buffer
-        _data = new uint8[_input->GetDataSize()];
-        bool all_data_read = false;
-        if(_input->Read(_data, _input->GetTotalNumberSamples(), all_data_read) != _input->GetTotalNumberSamples()) {
-            IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to read entire audio data stream for file: " << filename << std::endl;
-            return false;
-        }
-
-        // Pass the buffer data to the OpenAL buffer
-        _buffer->FillBuffer(_data, _format, _input->GetDataSize(), _input->GetSamplesPerSecond());
-        delete[] _data;
-        _data = NULL;
+        // Pass the decoded data to the OpenAL buffer
+        PCMInput *pcm_input = static_cast<PCMInput *>(_input);
+        _buffer->FillBuffer(const_cast<uint8 *>(pcm_input->GetData()), _format,
+                            _input->GetDataSize(), _input->GetSamplesPerSecond());
 
         // Attempt to acquire a source for the new audio to use
         _AcquireSource();
@@ -288,6 +281,9 @@ void AudioDescriptor::FreeAudio()
     if(_source != NULL)
         Stop();
 
+    // The stream can't be freed while the streaming thread uses it.
+    _DetachStream();
+
     _state = AUDIO_STATE_UNLOADED;
     _offset = 0;
 
@@ -335,6 +331,13 @@ bool AudioDescriptor::Play()
         _SetSourceProperties();
     }
 
+    // The streaming thread rewinds the stream itself when it has ended.
+    if(_UseStreamingThread()) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_PLAY, _offset);
+        _state = AUDIO_STATE_PLAYING;
+        return true;
+    }
+
     if(_stream && _stream->GetEndOfStream()) {
         _stream->Seek(_offset);
         _PrepareStreamingBuffers();
@@ -363,6 +366,12 @@ void AudioDescriptor::Stop()
         return;
     }
 
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_STOP);
+        _state = AUDIO_STATE_STOPPED;
+        return;
+    }
+
     // Temp: Checks if there is already an AL error in the buffer. If it is, print error and clear buffer.
     if(AudioManager->CheckALError()) {
         IF_PRINT_WARNING(AUDIO_DEBUG) << "audio error occured some time before stopping source: " << AudioManager->CreateALErrorString() << std::endl;
@@ -387,6 +396,12 @@ void AudioDescriptor::Pause()
         return;
     }
 
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_PAUSE);
+        _state = AUDIO_STATE_PAUSED;
+        return;
+    }
+
     alSourcePause(_source->source);
     if(AudioManager->CheckALError()) {
         IF_PRINT_WARNING(AUDIO_DEBUG) << "pausing the source failed: " << AudioManager->CreateALErrorString() << std::endl;
@@ -413,6 +428,11 @@ void AudioDescriptor::Rewind()
         return;
     }
 
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_REWIND);
+        return;
+    }
+
     alSourceRewind(_source->source);
     if(AudioManager->CheckALError()) {
         IF_PRINT_WARNING(AUDIO_DEBUG) << "rewinding the source failed: " << AudioManager->CreateALErrorString() << std::endl;
@@ -427,7 +447,9 @@ void AudioDescriptor::SetLooping(bool loop)
         return;
 
     _looping = loop;
-    if(_stream != NULL) {
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_LOOPING, _looping ? 1 : 0);
+    } else if(_stream != NULL) {
         _stream->SetLooping(_looping);
     } else if(_source != NULL) {
         if(_looping)
@@ -445,7 +467,11 @@ void AudioDescriptor::SetLoopStart(uint32 loop_start)
         IF_PRINT_WARNING(AUDIO_DEBUG) << "the audio data was not loaded with streaming properties, this operation is not permitted" << std::endl;
         return;
     }
-    _stream->SetLoopStart(loop_start);
+
+    if(_stream_attached)
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_LOOP_START, loop_start);
+    else
+        _stream->SetLoopStart(loop_start);
 }
 
 
@@ -456,7 +482,11 @@ void AudioDescriptor::SetLoopEnd(uint32 loop_end)
         IF_PRINT_WARNING(AUDIO_DEBUG) << "the audio data was not loaded with streaming properties, this operation is not permitted" << std::endl;
         return;
     }
-    _stream->SetLoopEnd(loop_end);
+
+    if(_stream_attached)
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_LOOP_END, loop_end);
+    else
+        _stream->SetLoopEnd(loop_end);
 }
 
 
@@ -470,7 +500,9 @@ void AudioDescriptor::SeekSample(uint32 sample)
 
     _offset = sample;
 
-    if(_stream) {
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_SEEK, _offset);
+    } else if(_stream) {
         _stream->Seek(_offset);
         _PrepareStreamingBuffers();
     } else if(_source != NULL) {
@@ -497,7 +529,9 @@ void AudioDescriptor::SeekSecond(float second)
     }
 
     _offset = pos;
-    if(_stream) {
+    if(_stream_attached) {
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_SEEK, _offset);
+    } else if(_stream) {
         _stream->Seek(_offset);
         _PrepareStreamingBuffers();
     } else if(_source != NULL) {
@@ -627,6 +661,10 @@ void AudioDescriptor::FadeIn(float time)
 
     _state = AUDIO_STATE_FADE_IN;
     _fade_effect_time = time;
+
+    // Let the streaming thread fade the volume between two updates.
+    if(_stream_attached)
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_FADE);
 }
 
 void AudioDescriptor::FadeOut(float time)
@@ -640,6 +678,9 @@ void AudioDescriptor::FadeOut(float time)
 
     _fade_effect_time = time;
     _state = AUDIO_STATE_FADE_OUT;
+
+    if(_stream_attached)
+        _SendStreamCommand(AUDIO_STREAM_COMMAND_FADE);
 }
 
 void AudioDescriptor::RemoveEffects()
@@ -726,8 +767,11 @@ void AudioDescriptor::_Update()
 
     // If the last set state was the playing state, we have to double check
     // with the OpenAL source to make sure that the audio is still playing.
-    // If the descriptor no longer has a source, we can stop
-    if(!_source) {
+    // If the descriptor no longer has a source, we can stop.
+    // The streaming thread tells itself when the stream has ended.
+    if(_stream_attached) {
+        // Nothing to check
+    } else if(!_source) {
         _state = AUDIO_STATE_STOPPED;
     } else {
         ALint source_state;
@@ -756,8 +800,9 @@ void AudioDescriptor::_Update()
         }
     }
 
-    // Only streaming audio that is being played requires periodic updates
-    if(!_stream)
+    // Only streaming audio that is being played requires periodic updates,
+    // unless the streaming thread does it.
+    if(!_stream || _stream_attached)
         return;
 
     ALint queued = 0;
@@ -898,13 +943,7 @@ void AudioDescriptor::_SetSourceProperties()
     }
 
     // Set volume (gain)
-    float volume_multiplier = 0.0f;
-    if(IsSound())
-        volume_multiplier = AudioManager->GetSoundVolume();
-    else
-        volume_multiplier = AudioManager->GetMusicVolume();
-
-    alSourcef(_source->source, AL_GAIN, _volume * volume_multiplier);
+    alSourcef(_source->source, AL_GAIN, _volume * _GetVolumeMultiplier());
     if(AudioManager->CheckALError()) {
         IF_PRINT_WARNING(AUDIO_DEBUG) << "changing volume on a source failed: " << AudioManager->CreateALErrorString() << std::endl;
     }
@@ -969,6 +1008,91 @@ void AudioDescriptor::_PrepareStreamingBuffers()
     }
 }
 
+float AudioDescriptor::_GetVolumeMultiplier() const
+{
+    if(IsSound())
+        return AudioManager->GetSoundVolume();
+    else
+        return AudioManager->GetMusicVolume();
+}
+
+void AudioDescriptor::_ApplyGain()
+{
+    if(_stream_attached) {
+        // Fading goes on in the streaming thread from the new volume.
+        if(_state == AUDIO_STATE_FADE_IN || _state == AUDIO_STATE_FADE_OUT)
+            _SendStreamCommand(AUDIO_STREAM_COMMAND_FADE);
+        else
+            _SendStreamCommand(AUDIO_STREAM_COMMAND_VOLUME);
+    } else if(_source) {
+        alSourcef(_source->source, AL_GAIN, _volume * _GetVolumeMultiplier());
+    }
+}
+
+bool AudioDescriptor::_UseStreamingThread() const
+{
+    return _stream != NULL && _source != NULL && AudioManager->_streamer.IsRunning();
+}
+
+void AudioDescriptor::_SendStreamCommand(AUDIO_STREAM_COMMAND type, uint32 value)
+{
+    AudioStreamCommand command;
+    command.type = type;
+    command.descriptor = this;
+    command.sequence = ++_stream_sequence;
+    command.gain = 0.0f;
+    command.target_gain = 0.0f;
+    command.fade_time = 0.0f;
+    command.value = value;
+
+    // The gain isn't computed otherwise, since the descriptor may be being destroyed.
+    if(type == AUDIO_STREAM_COMMAND_PLAY || type == AUDIO_STREAM_COMMAND_VOLUME || type == AUDIO_STREAM_COMMAND_FADE) {
+        float multiplier = _GetVolumeMultiplier();
+        command.gain = _volume * multiplier;
+        command.target_gain = command.gain;
+
+        // The same rates as in _HandleFadeStates(), the volume changing by 1.0f every _fade_effect_time milliseconds.
+        if(type == AUDIO_STREAM_COMMAND_FADE && _state == AUDIO_STATE_FADE_IN) {
+            command.target_gain = multiplier;
+            command.fade_time = (1.0f - _volume) * _fade_effect_time;
+        } else if(type == AUDIO_STREAM_COMMAND_FADE) {
+            command.target_gain = 0.0f;
+            command.fade_time = _volume * _fade_effect_time;
+        }
+    }
+
+    _stream_attached = true;
+    AudioManager->_streamer.SendCommand(command);
+}
+
+void AudioDescriptor::_DetachStream()
+{
+    if(!_stream_attached)
+        return;
+
+    _SendStreamCommand(AUDIO_STREAM_COMMAND_DETACH);
+    AudioManager->_streamer.WaitForDetach(this);
+}
+
+void AudioDescriptor::_HandleStreamEvent(const AudioStreamEvent &event)
+{
+    switch(event.type) {
+    case AUDIO_STREAM_EVENT_ENDED:
+        // Ignore the end of the stream when it was played again since.
+        if(event.sequence == _stream_sequence && _state != AUDIO_STATE_PAUSED)
+            _state = AUDIO_STATE_STOPPED;
+        break;
+    case AUDIO_STREAM_EVENT_UNDERRUN:
+        ++_number_underruns;
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "the streaming buffers ran out while playing: " << GetFilename() << std::endl;
+        break;
+    case AUDIO_STREAM_EVENT_DETACHED:
+        if(event.sequence == _stream_sequence)
+            _stream_attached = false;
+        break;
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // SoundDescriptor class methods
 ////////////////////////////////////////////////////////////////////////////////
@@ -1003,12 +1127,7 @@ SoundDescriptor::SoundDescriptor(const SoundDescriptor &copy) :
 void SoundDescriptor::SetVolume(float volume)
 {
     AudioDescriptor::_SetVolumeControl(volume);
-
-    float sound_volume = _volume * AudioManager->GetSoundVolume();
-
-    if(_source) {
-        alSourcef(_source->source, AL_GAIN, sound_volume);
-    }
+    _ApplyGain();
 }
 
 bool SoundDescriptor::Play()
@@ -1086,12 +1205,7 @@ bool MusicDescriptor::Play()
 void MusicDescriptor::SetVolume(float volume)
 {
     AudioDescriptor::_SetVolumeControl(volume);
-
-    float music_volume = _volume * AudioManager->GetMusicVolume();
-
-    if(_source) {
-        alSourcef(_source->source, AL_GAIN, (ALfloat)music_volume);
-    }
+    _ApplyGain();
 }
 
 } // namespace vt_audio
@@ -27,6 +27,7 @@
 #include "audio_input.h"
 #include "audio_stream.h"
 #include "audio_effects.h"
+#include "audio_streamer.h"
 
 namespace vt_mode_manager {
 class GameMode;
@@ -194,6 +195,7 @@ public:
 class AudioDescriptor
 {
     friend class AudioEngine;
+    friend class private_audio::AudioStreamer;
 
 public:
     AudioDescriptor();
@@ -363,6 +365,11 @@ public:
     //! \brief Remove effects.
     void RemoveEffects();
 
+    //! \brief Returns the number of times the streaming buffers ran out while playing.
+    uint32 GetNumberUnderruns() const {
+        return _number_underruns;
+    }
+
     //! \brief Prints various properties about the audio data managed by this class
     void DEBUG_PrintInfo();
 
@@ -431,6 +438,19 @@ protected:
     //! \brief Holds all active audio effects for this descriptor
     std::vector<private_audio::AudioEffect *> _audio_effects;
 
+    /** \brief Whether the stream is handled by the streaming thread
+    *** Set when a command is sent, and unset once the streaming thread
+    *** has given the descriptor back after the last command sent.
+    *** Meanwhile, only the streaming thread may use _stream and _buffer.
+    **/
+    bool _stream_attached;
+
+    //! \brief The number of commands sent to the streaming thread.
+    uint32 _stream_sequence;
+
+    //! \brief The number of times the streaming buffers ran out while playing.
+    uint32 _number_underruns;
+
     /** \brief Sets the local volume control for this particular audio piece
     *** \param volume The volume level to set, ranging from [0.0f, 1.0f]
     *** This should be thought of as a helper function to the SetVolume methods
@@ -439,6 +459,9 @@ protected:
     **/
     void _SetVolumeControl(float volume);
 
+    //! \brief Applies the volume, modulated by the global sound or music volume, to the source.
+    void _ApplyGain();
+
 private:
     /** \brief Updates the audio during playback
     *** This function is only useful for streaming audio that is currently in the play state. If either of these two
@@ -468,6 +491,24 @@ private:
     *** ones must be refilled. This function should only be called for streaming audio.
     **/
     void _PrepareStreamingBuffers();
+
+    //! \brief Returns the global sound or music volume, depending on the audio type.
+    float _GetVolumeMultiplier() const;
+
+    //! \brief Tells whether the stream should be handled by the streaming thread.
+    bool _UseStreamingThread() const;
+
+    /** \brief Sends a command about this descriptor to the streaming thread
+    *** \param type The command type
+    *** \param value The sample to seek to, the loop point, or the looping flag
+    **/
+    void _SendStreamCommand(private_audio::AUDIO_STREAM_COMMAND type, uint32 value = 0);
+
+    //! \brief Takes the stream back from the streaming thread, waiting for it if needed.
+    void _DetachStream();
+
+    //! \brief Handles an event sent by the streaming thread about this descriptor.
+    void _HandleStreamEvent(const private_audio::AudioStreamEvent &event);
 }; // class AudioDescriptor
 
 
@@ -25,6 +25,8 @@
 #include "utils/utils_pch.h"
 #include "audio_input.h"
 
+#include "utils/utils_strings.h"
+
 namespace vt_audio
 {
 
@@ -466,6 +468,76 @@ uint32 AudioMemory::Read(uint8 *buffer, uint32 size, bool &end)
     return read;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// PCMInput class methods
+////////////////////////////////////////////////////////////////////////////////
+
+PCMInput::PCMInput(PCMData *pcm) :
+    AudioInput(),
+    _pcm(pcm),
+    _data_position(0)
+{
+    _pcm->Reference();
+
+    _filename = pcm->filename;
+    _samples_per_second = pcm->samples_per_second;
+    _bits_per_sample = pcm->bits_per_sample;
+    _number_channels = pcm->number_channels;
+    _total_number_samples = pcm->total_number_samples;
+    _sample_size = pcm->sample_size;
+    _play_time = pcm->play_time;
+    _data_size = pcm->data.size();
+}
+
+PCMInput::~PCMInput()
+{
+    _pcm->Release();
+}
+
+void PCMInput::Seek(uint32 sample_position)
+{
+    if(sample_position >= _total_number_samples) {
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "attempted to seek postion beyond the maximum number of samples: "
+                                      << sample_position << std::endl;
+        return;
+    }
+
+    _data_position = sample_position;
+}
+
+uint32 PCMInput::Read(uint8 *buffer, uint32 size, bool &end)
+{
+    // Clamp the number of samples to read in case there are not enough because of end of stream
+    uint32 read = (_total_number_samples - _data_position >= size) ? size : (_total_number_samples - _data_position);
+
+    if(read > 0)
+        memcpy(buffer, &_pcm->data[_data_position * _sample_size], read * _sample_size);
+    _data_position += read;
+    end = (_data_position == _total_number_samples);
+
+    return read;
+}
+
+AudioInput *CreateFileInput(const std::string &filename)
+{
+    // Name of file is at least 3 letters (so the extension is in there)
+    if(filename.size() <= 3) {
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "file name argument is too short: " << filename << std::endl;
+        return NULL;
+    }
+
+    // Convert the file extension to uppercase and use it to create the proper input type
+    std::string file_extension = vt_utils::Upcase(filename.substr(filename.size() - 3, 3));
+
+    if(file_extension.compare("WAV") == 0)
+        return new WavFile(filename);
+    else if(file_extension.compare("OGG") == 0)
+        return new OggFile(filename);
+
+    IF_PRINT_WARNING(AUDIO_DEBUG) << "failed due to unsupported input file extension: " << file_extension << std::endl;
+    return NULL;
+}
+
 } // namespace private_audio
 
 } // namespace vt_audio
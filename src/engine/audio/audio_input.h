@@ -283,6 +283,113 @@ private:
     uint32 _data_position;
 }; // class AudioMemory : public AudioInput
 
+/** ****************************************************************************
+*** \brief Audio data decoded once and shared by every input reading it
+***
+*** The data is owned by the PCM cache and by each PCMInput referencing it,
+*** and deletes itself once the last of them has released it.
+*** \note The references must only be taken and released by the main thread.
+*** ***************************************************************************/
+class PCMData
+{
+public:
+    PCMData() :
+        samples_per_second(0),
+        bits_per_sample(0),
+        number_channels(0),
+        total_number_samples(0),
+        sample_size(0),
+        play_time(0.0f),
+        last_use_time(0),
+        _references(0)
+    {}
+
+    //! \brief Takes a reference on the data.
+    void Reference() {
+        ++_references;
+    }
+
+    //! \brief Releases a reference on the data, and deletes it when it was the last one.
+    void Release() {
+        if(--_references == 0)
+            delete this;
+    }
+
+    //! \brief Returns the number of references on the data.
+    uint32 GetReferences() const {
+        return _references;
+    }
+
+    //! \brief The properties of the decoded audio, as given by the input it was decoded from
+    //@{
+    std::string filename;
+    uint32 samples_per_second;
+    uint16 bits_per_sample;
+    uint16 number_channels;
+    uint32 total_number_samples;
+    uint16 sample_size;
+    float play_time;
+    //@}
+
+    //! \brief The decoded audio samples.
+    std::vector<uint8> data;
+
+    //! \brief The last time the data was used, in milliseconds.
+    uint32 last_use_time;
+
+private:
+    //! \brief The number of owners of the data.
+    uint32 _references;
+}; // class PCMData
+
+/** ****************************************************************************
+*** \brief Manages audio input data decoded beforehand and shared through the PCM cache
+***
+*** Unlike AudioMemory, the data isn't copied: the input keeps a reference on
+*** the shared data instead, released when the input is deleted.
+*** ***************************************************************************/
+class PCMInput : public AudioInput
+{
+public:
+    //! \param pcm The decoded data, which the input takes a reference on
+    PCMInput(PCMData *pcm);
+
+    ~PCMInput();
+
+    //! \brief Inherited functions from AudioInput class
+    //@{
+    //! \note The data was already decoded, so there is nothing left to initialize
+    bool Initialize() {
+        return true;
+    }
+
+    void Seek(uint32 sample_position);
+
+    uint32 Read(uint8 *buffer, uint32 size, bool &end);
+    //@}
+
+    //! \brief Returns the whole decoded audio data, or NULL if there is none.
+    const uint8 *GetData() const {
+        return _pcm->data.empty() ? NULL : &_pcm->data[0];
+    }
+
+private:
+    //! \brief The shared decoded data.
+    PCMData *_pcm;
+
+    //! \brief Position in the data where the next read operation will be performed
+    uint32 _data_position;
+
+    PCMInput(const PCMInput &other);
+    PCMInput &operator=(const PCMInput &other);
+}; // class PCMInput : public AudioInput
+
+/** \brief Creates the input matching the extension of an audio file
+*** \param filename The WAV or OGG file to read
+*** \return The input, which still needs to be initialized, or NULL if the extension isn't supported.
+**/
+AudioInput *CreateFileInput(const std::string &filename);
+
 } // namespace private_audio
 
 } // namespace vt_audio
@@ -0,0 +1,233 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    audio_pcm_cache.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the cache of decoded static sounds.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/audio/audio_pcm_cache.h"
+
+#include "engine/audio/audio_input.h"
+#include "engine/system.h"
+
+using namespace vt_system;
+
+namespace vt_audio
+{
+
+extern bool AUDIO_DEBUG;
+
+namespace private_audio
+{
+
+//! \brief Decodes a preloaded file, and hands the data over to the cache once finished.
+class PCMDecodeJob : public Job
+{
+public:
+    PCMDecodeJob(PCMCache *cache, const std::string &filename) :
+        Job(JOB_TYPE_AUDIO_DECODING),
+        _cache(cache),
+        _filename(filename),
+        _pcm(NULL)
+    {}
+
+    //! \brief Deletes the data not handed over.
+    ~PCMDecodeJob() {
+        delete _pcm;
+    }
+
+    void Run() {
+        _pcm = PCMCache::_Decode(_filename);
+    }
+
+    void Finish() {
+        if(_cache != NULL && _cache->_AddPreload(_filename, _pcm))
+            _pcm = NULL;
+    }
+
+    //! \brief Drops the data once decoded, as the cache is stopped.
+    void Detach() {
+        _cache = NULL;
+    }
+
+private:
+    //! \brief The cache the data goes to, or NULL when dropped.
+    PCMCache *_cache;
+
+    std::string _filename;
+
+    //! \brief The decoded data, or NULL when the decoding failed.
+    PCMData *_pcm;
+};
+
+PCMCache::PCMCache() :
+    _budget(DEFAULT_PCM_CACHE_BUDGET),
+    _resident_size(0),
+    _number_hits(0),
+    _number_misses(0),
+    _number_evictions(0)
+{}
+
+PCMCache::~PCMCache()
+{
+    Stop();
+
+    // The data still used by some inputs is deleted along with them.
+    for(std::map<std::string, PCMData *>::iterator it = _entries.begin(); it != _entries.end(); ++it)
+        it->second->Release();
+    _entries.clear();
+    _resident_size = 0;
+}
+
+void PCMCache::Stop()
+{
+    // The jobs are left to the job system, which deletes their data once done.
+    for(std::map<std::string, PCMDecodeJob *>::iterator it = _pending_preloads.begin(); it != _pending_preloads.end(); ++it)
+        it->second->Detach();
+    _pending_preloads.clear();
+}
+
+PCMInput *PCMCache::CreateInput(const std::string &filename)
+{
+    PCMData *pcm = NULL;
+    std::map<std::string, PCMData *>::iterator it = _entries.find(filename);
+    if(it != _entries.end()) {
+        ++_number_hits;
+        pcm = it->second;
+    } else {
+        // The file is decoded right away, even if its preload is still pending:
+        // the job result will then be dropped.
+        ++_number_misses;
+        pcm = _Decode(filename);
+        if(pcm == NULL)
+            return NULL;
+        _AddEntry(pcm);
+    }
+
+    pcm->last_use_time = SDL_GetTicks();
+    PCMInput *input = new PCMInput(pcm);
+    _Evict();
+    return input;
+}
+
+void PCMCache::Preload(const std::string &filename)
+{
+    if(_entries.find(filename) != _entries.end() || _pending_preloads.find(filename) != _pending_preloads.end())
+        return;
+
+    if(SystemManager != NULL) {
+        PCMDecodeJob *job = new PCMDecodeJob(this, filename);
+        _pending_preloads.insert(std::make_pair(filename, job));
+        SystemManager->GetJobSystem().Submit(job);
+        return;
+    }
+
+    // Without the job system, such as when converting files.
+    PCMData *pcm = _Decode(filename);
+    if(pcm == NULL)
+        return;
+
+    pcm->last_use_time = SDL_GetTicks();
+    _AddEntry(pcm);
+    _Evict();
+}
+
+void PCMCache::Update()
+{
+    _Evict();
+}
+
+void PCMCache::SetBudget(uint32 budget)
+{
+    _budget = budget;
+    _Evict();
+}
+
+void PCMCache::_AddEntry(PCMData *pcm)
+{
+    pcm->Reference();
+    _entries.insert(std::make_pair(pcm->filename, pcm));
+    _resident_size += pcm->data.size();
+}
+
+bool PCMCache::_AddPreload(const std::string &filename, PCMData *pcm)
+{
+    _pending_preloads.erase(filename);
+
+    // Failed, or decoded meanwhile by the main thread.
+    if(pcm == NULL || _entries.find(filename) != _entries.end())
+        return false;
+
+    pcm->last_use_time = SDL_GetTicks();
+    _AddEntry(pcm);
+    return true;
+}
+
+void PCMCache::_Evict()
+{
+    while(_resident_size > _budget) {
+        // Only the data referenced by the cache alone can be evicted.
+        std::map<std::string, PCMData *>::iterator oldest = _entries.end();
+        for(std::map<std::string, PCMData *>::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+            if(it->second->GetReferences() > 1)
+                continue;
+            if(oldest == _entries.end() || it->second->last_use_time < oldest->second->last_use_time)
+                oldest = it;
+        }
+
+        if(oldest == _entries.end())
+            return;
+
+        _resident_size -= oldest->second->data.size();
+        oldest->second->Release();
+        _entries.erase(oldest);
+        ++_number_evictions;
+    }
+}
+
+PCMData *PCMCache::_Decode(const std::string &filename)
+{
+    AudioInput *input = CreateFileInput(filename);
+    if(input == NULL)
+        return NULL;
+
+    if(!input->Initialize()) {
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to load and initialize audio file: " << filename << std::endl;
+        delete input;
+        return NULL;
+    }
+
+    PCMData *pcm = new PCMData();
+    pcm->filename = filename;
+    pcm->samples_per_second = input->GetSamplesPerSecond();
+    pcm->bits_per_sample = input->GetBitsPerSample();
+    pcm->number_channels = input->GetNumberChannels();
+    pcm->total_number_samples = input->GetTotalNumberSamples();
+    pcm->sample_size = input->GetSampleSize();
+    pcm->play_time = input->GetPlayTime();
+    pcm->data.resize(input->GetDataSize());
+
+    bool all_data_read = false;
+    if(pcm->data.empty() || input->Read(&pcm->data[0], pcm->total_number_samples, all_data_read) != pcm->total_number_samples) {
+        IF_PRINT_WARNING(AUDIO_DEBUG) << "failed to read entire audio data stream for file: " << filename << std::endl;
+        delete pcm;
+        delete input;
+        return NULL;
+    }
+
+    delete input;
+    return pcm;
+}
+
+} // namespace private_audio
+
+} // namespace vt_audio
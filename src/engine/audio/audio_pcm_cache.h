@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    audio_pcm_cache.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the cache of decoded static sounds.
+***
+*** Decoding an ogg file takes far more time than uploading its samples to
+*** OpenAL, and the same sounds are loaded again by every map and battle using
+*** them. The decoded samples are thus kept in a cache shared by every static
+*** sound descriptor, within a memory budget. The game modes can also declare
+*** the sounds they will need, so that they are decoded beforehand by the
+*** worker threads of the job system.
+*** ***************************************************************************/
+
+#ifndef __AUDIO_PCM_CACHE_HEADER__
+#define __AUDIO_PCM_CACHE_HEADER__
+
+namespace vt_audio
+{
+
+namespace private_audio
+{
+
+class PCMData;
+class PCMDecodeJob;
+class PCMInput;
+
+//! \brief The default memory budget of the PCM cache, in bytes.
+const uint32 DEFAULT_PCM_CACHE_BUDGET = 16 * 1024 * 1024;
+
+/** ****************************************************************************
+*** \brief Keeps the decoded data of the static sounds, and decodes the preloaded ones
+***
+*** Only the data no descriptor uses anymore counts against the memory budget:
+*** once the budget is exceeded, the least recently used of it is evicted.
+***
+*** \note All the public methods must be called from the main thread. The
+*** jobs only decode the requested files, and hand the data back once
+*** finished by the main thread.
+*** ***************************************************************************/
+class PCMCache
+{
+    friend class PCMDecodeJob;
+
+public:
+    PCMCache();
+
+    //! \brief Drops the pending preloads and releases the cached data.
+    ~PCMCache();
+
+    /** \brief Creates an input reading the decoded data of an audio file
+    *** The file is decoded right away when not in the cache yet.
+    *** \return The input, or NULL if the file couldn't be decoded.
+    **/
+    PCMInput *CreateInput(const std::string &filename);
+
+    /** \brief Requests a file to be decoded and added to the cache ahead of its use
+    *** The file is decoded by a job, and added to the cache once the job is finished.
+    **/
+    void Preload(const std::string &filename);
+
+    //! \brief Evicts data over the budget.
+    void Update();
+
+    //! \brief Drops the pending preloads: their data won't be added to the cache.
+    void Stop();
+
+    //! \brief Sets the memory budget in bytes, evicting data over it right away.
+    void SetBudget(uint32 budget);
+
+    //! \name Class member access functions
+    //@{
+    uint32 GetBudget() const {
+        return _budget;
+    }
+
+    //! \brief Returns the number of bytes of decoded data in the cache, whether in use or not.
+    uint32 GetResidentSize() const {
+        return _resident_size;
+    }
+
+    uint32 GetNumberEntries() const {
+        return _entries.size();
+    }
+
+    uint32 GetNumberHits() const {
+        return _number_hits;
+    }
+
+    uint32 GetNumberMisses() const {
+        return _number_misses;
+    }
+
+    uint32 GetNumberEvictions() const {
+        return _number_evictions;
+    }
+
+    uint32 GetNumberPendingPreloads() const {
+        return _pending_preloads.size();
+    }
+    //@}
+
+private:
+    //! \brief The cached data, referenced once by the cache itself, and keyed by filename.
+    std::map<std::string, PCMData *> _entries;
+
+    //! \brief The jobs decoding the requested files, keyed by filename, and not finished yet.
+    std::map<std::string, PCMDecodeJob *> _pending_preloads;
+
+    //! \brief The memory budget of the unused data, in bytes.
+    uint32 _budget;
+
+    //! \brief The number of bytes of all the cached data.
+    uint32 _resident_size;
+
+    //! \brief The cache statistics, since the engine was started.
+    //@{
+    uint32 _number_hits;
+    uint32 _number_misses;
+    uint32 _number_evictions;
+    //@}
+
+    //! \brief Adds decoded data to the cache.
+    void _AddEntry(PCMData *pcm);
+
+    /** \brief Adds the data decoded by a preload job to the cache
+    *** \param pcm The decoded data, or NULL when the decoding failed
+    *** \return false if the data wasn't added, because it failed or was decoded meanwhile by the main thread.
+    **/
+    bool _AddPreload(const std::string &filename, PCMData *pcm);
+
+    //! \brief Evicts the least recently used unused data until the budget is met.
+    void _Evict();
+
+    /** \brief Decodes a whole audio file. Safe to call from any thread.
+    *** \return The decoded data, or NULL if the file couldn't be decoded.
+    **/
+    static PCMData *_Decode(const std::string &filename);
+}; // class PCMCache
+
+} // namespace private_audio
+
+} // namespace vt_audio
+
+#endif // __AUDIO_PCM_CACHE_HEADER__
@@ -0,0 +1,348 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    audio_streamer.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the audio streaming thread.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/audio/audio_streamer.h"
+
+#include "engine/audio/audio.h"
+#include "engine/system.h"
+
+using namespace vt_system;
+
+namespace vt_audio
+{
+
+namespace private_audio
+{
+
+//! \brief The time the streaming thread sleeps between two updates, in milliseconds.
+const uint32 AUDIO_STREAMER_PERIOD = 10;
+
+//! \brief Reports the last OpenAL error, if any. AudioEngine::CheckALError() is kept for the main thread.
+static void CheckStreamError(const char *operation)
+{
+    ALenum error = alGetError();
+    if(error != AL_NO_ERROR)
+        IF_PRINT_WARNING(AUDIO_DEBUG) << operation << " failed with OpenAL error: " << error << std::endl;
+}
+
+AudioStreamer::AudioStreamer() :
+    _thread(NULL),
+    _quit(false),
+    _number_underruns(0)
+{}
+
+AudioStreamer::~AudioStreamer()
+{
+    Stop();
+}
+
+bool AudioStreamer::Start()
+{
+#if (THREAD_TYPE == SDL_THREADS)
+    if(_thread != NULL)
+        return true;
+
+    _quit = false;
+    _thread = SystemManager->SpawnThread(&AudioStreamer::_StreamingLoop, this);
+    if(_thread == NULL) {
+        PRINT_WARNING << "Couldn't create the audio streaming thread, the streams will be updated by the main thread." << std::endl;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AudioStreamer::Stop()
+{
+    if(_thread == NULL)
+        return;
+
+    _quit = true;
+    SystemManager->WaitForThread(_thread);
+    _thread = NULL;
+
+    // Give every descriptor back to the main thread.
+    DispatchEvents();
+
+    AudioStreamCommand command;
+    while(_commands.Pop(command))
+        command.descriptor->_stream_attached = false;
+
+    for(uint32 i = 0; i < _streams.size(); ++i)
+        _streams[i].descriptor->_stream_attached = false;
+    _streams.clear();
+}
+
+void AudioStreamer::SendCommand(const AudioStreamCommand &command)
+{
+    // The streaming thread may be waiting for room in the events queue.
+    while(!_commands.Push(command)) {
+        DispatchEvents();
+        SDL_Delay(1);
+    }
+}
+
+void AudioStreamer::DispatchEvents()
+{
+    AudioStreamEvent event;
+    while(_events.Pop(event)) {
+        if(event.type == AUDIO_STREAM_EVENT_UNDERRUN)
+            ++_number_underruns;
+        event.descriptor->_HandleStreamEvent(event);
+    }
+}
+
+void AudioStreamer::WaitForDetach(AudioDescriptor *descriptor)
+{
+    while(descriptor->_stream_attached) {
+        if(_thread == NULL) {
+            descriptor->_stream_attached = false;
+            return;
+        }
+
+        DispatchEvents();
+        if(descriptor->_stream_attached)
+            SDL_Delay(1);
+    }
+}
+
+void AudioStreamer::_StreamingLoop()
+{
+    uint32 last_time = SDL_GetTicks();
+
+    while(!_quit) {
+        AudioStreamCommand command;
+        while(_commands.Pop(command))
+            _HandleCommand(command);
+
+        uint32 time = SDL_GetTicks();
+        uint32 elapsed_time = time - last_time;
+        last_time = time;
+
+        for(std::vector<Stream>::iterator it = _streams.begin(); it != _streams.end();) {
+            if(_UpdateStream(*it, elapsed_time)) {
+                ++it;
+                continue;
+            }
+
+            _SendEvent(AUDIO_STREAM_EVENT_ENDED, it->descriptor, it->sequence);
+            _SendEvent(AUDIO_STREAM_EVENT_DETACHED, it->descriptor, it->sequence);
+            it = _streams.erase(it);
+        }
+
+        SDL_Delay(AUDIO_STREAMER_PERIOD);
+    }
+}
+
+void AudioStreamer::_HandleCommand(const AudioStreamCommand &command)
+{
+    AudioDescriptor *descriptor = command.descriptor;
+    ALuint source = descriptor->_source->source;
+
+    if(command.type == AUDIO_STREAM_COMMAND_STOP || command.type == AUDIO_STREAM_COMMAND_DETACH) {
+        if(command.type == AUDIO_STREAM_COMMAND_STOP)
+            alSourceStop(source);
+        _RemoveStream(descriptor);
+        _SendEvent(AUDIO_STREAM_EVENT_DETACHED, descriptor, command.sequence);
+        return;
+    }
+
+    // Only the play command makes the thread keep the buffers filled.
+    // The other ones are handled as well for the descriptors it doesn't stream,
+    // which are then given back right away.
+    Stream *found_stream = _FindStream(descriptor);
+    if(found_stream == NULL && command.type == AUDIO_STREAM_COMMAND_PLAY) {
+        _streams.push_back(Stream());
+        found_stream = &_streams.back();
+    }
+
+    Stream unstreamed;
+    Stream &stream = (found_stream != NULL) ? *found_stream : unstreamed;
+    stream.descriptor = descriptor;
+    stream.sequence = command.sequence;
+
+    if(command.type == AUDIO_STREAM_COMMAND_PLAY || command.type == AUDIO_STREAM_COMMAND_VOLUME
+            || command.type == AUDIO_STREAM_COMMAND_FADE) {
+        stream.gain = command.gain;
+        stream.fade_step = 0.0f;
+        alSourcef(source, AL_GAIN, stream.gain);
+    }
+
+    switch(command.type) {
+    case AUDIO_STREAM_COMMAND_PLAY:
+        if(descriptor->_stream->GetEndOfStream()) {
+            descriptor->_stream->Seek(command.value);
+            _PrepareBuffers(stream);
+        }
+        alSourcePlay(source);
+        stream.playing = true;
+        break;
+    case AUDIO_STREAM_COMMAND_PAUSE:
+        alSourcePause(source);
+        stream.playing = false;
+        break;
+    case AUDIO_STREAM_COMMAND_REWIND:
+        descriptor->_stream->Seek(0);
+        _PrepareBuffers(stream);
+        break;
+    case AUDIO_STREAM_COMMAND_SEEK:
+        descriptor->_stream->Seek(command.value);
+        _PrepareBuffers(stream);
+        break;
+    case AUDIO_STREAM_COMMAND_LOOPING:
+        descriptor->_stream->SetLooping(command.value != 0);
+        break;
+    case AUDIO_STREAM_COMMAND_LOOP_START:
+        descriptor->_stream->SetLoopStart(command.value);
+        break;
+    case AUDIO_STREAM_COMMAND_LOOP_END:
+        descriptor->_stream->SetLoopEnd(command.value);
+        break;
+    case AUDIO_STREAM_COMMAND_FADE:
+        if(command.fade_time > 0.0f) {
+            stream.target_gain = command.target_gain;
+            stream.fade_step = (command.target_gain - command.gain) / command.fade_time;
+        } else {
+            stream.gain = command.target_gain;
+            alSourcef(source, AL_GAIN, stream.gain);
+        }
+        break;
+    default:
+        break;
+    }
+    CheckStreamError("handling a streaming command");
+
+    if(found_stream == NULL)
+        _SendEvent(AUDIO_STREAM_EVENT_DETACHED, descriptor, command.sequence);
+}
+
+bool AudioStreamer::_UpdateStream(Stream &stream, uint32 elapsed_time)
+{
+    AudioDescriptor *descriptor = stream.descriptor;
+    ALuint source = descriptor->_source->source;
+
+    if(stream.fade_step != 0.0f) {
+        stream.gain += stream.fade_step * elapsed_time;
+        if((stream.fade_step > 0.0f && stream.gain >= stream.target_gain)
+                || (stream.fade_step < 0.0f && stream.gain <= stream.target_gain)) {
+            stream.gain = stream.target_gain;
+            stream.fade_step = 0.0f;
+        }
+        alSourcef(source, AL_GAIN, stream.gain);
+    }
+
+    if(!stream.playing)
+        return true;
+
+    // Refill every buffer the source is done with.
+    ALint buffers_processed = 0;
+    alGetSourcei(source, AL_BUFFERS_PROCESSED, &buffers_processed);
+    for(ALint i = 0; i < buffers_processed; ++i) {
+        ALuint buffer_finished;
+        alSourceUnqueueBuffers(source, 1, &buffer_finished);
+
+        uint32 size = descriptor->_stream->FillBuffer(descriptor->_data, descriptor->_stream_buffer_size);
+        if(size == 0)
+            continue;
+
+        alBufferData(buffer_finished, descriptor->_format, descriptor->_data,
+                     size * descriptor->_input->GetSampleSize(), descriptor->_input->GetSamplesPerSecond());
+        alSourceQueueBuffers(source, 1, &buffer_finished);
+    }
+    CheckStreamError("refilling the streaming buffers");
+
+    ALint state;
+    alGetSourcei(source, AL_SOURCE_STATE, &state);
+    if(state == AL_PLAYING)
+        return true;
+
+    // Nothing is left to play once the stream has ended.
+    ALint queued = 0;
+    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+    if(queued == 0)
+        return false;
+
+    // Otherwise, the source ran out of buffers before they could be refilled.
+    _SendEvent(AUDIO_STREAM_EVENT_UNDERRUN, descriptor, stream.sequence);
+    alSourcePlay(source);
+    CheckStreamError("restarting a streaming source");
+    return true;
+}
+
+void AudioStreamer::_PrepareBuffers(Stream &stream)
+{
+    AudioDescriptor *descriptor = stream.descriptor;
+    ALuint source = descriptor->_source->source;
+
+    alSourceStop(source);
+    alSourcei(source, AL_BUFFER, 0);
+
+    for(uint32 i = 0; i < NUMBER_STREAMING_BUFFERS; ++i) {
+        uint32 read = descriptor->_stream->FillBuffer(descriptor->_data, descriptor->_stream_buffer_size);
+        if(read == 0)
+            continue;
+
+        descriptor->_buffer[i].FillBuffer(descriptor->_data, descriptor->_format,
+                                          read * descriptor->_input->GetSampleSize(),
+                                          descriptor->_input->GetSamplesPerSecond());
+        alSourceQueueBuffers(source, 1, &descriptor->_buffer[i].buffer);
+    }
+    CheckStreamError("filling the streaming buffers");
+
+    if(stream.playing)
+        alSourcePlay(source);
+}
+
+AudioStreamer::Stream *AudioStreamer::_FindStream(AudioDescriptor *descriptor)
+{
+    for(uint32 i = 0; i < _streams.size(); ++i) {
+        if(_streams[i].descriptor == descriptor)
+            return &_streams[i];
+    }
+    return NULL;
+}
+
+void AudioStreamer::_RemoveStream(AudioDescriptor *descriptor)
+{
+    for(std::vector<Stream>::iterator it = _streams.begin(); it != _streams.end(); ++it) {
+        if(it->descriptor == descriptor) {
+            _streams.erase(it);
+            return;
+        }
+    }
+}
+
+void AudioStreamer::_SendEvent(AUDIO_STREAM_EVENT type, AudioDescriptor *descriptor, uint32 sequence)
+{
+    AudioStreamEvent event;
+    event.type = type;
+    event.descriptor = descriptor;
+    event.sequence = sequence;
+
+    // The main thread may be waiting for room in the commands queue. When it is stopping the
+    // thread instead, the event is dropped: Stop() detaches every descriptor on its own.
+    while(!_events.Push(event)) {
+        if(_quit)
+            return;
+        SDL_Delay(1);
+    }
+}
+
+} // namespace private_audio
+
+} // namespace vt_audio
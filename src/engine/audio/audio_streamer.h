@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    audio_streamer.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the audio streaming thread.
+***
+*** The streamed audio buffers are decoded and queued by a dedicated thread,
+*** so that a long frame on the main thread doesn't starve the OpenAL sources.
+*** The main thread never touches the stream of an audio descriptor handed to
+*** the streaming thread: it sends commands through a lock-free queue instead,
+*** and gets the streaming events back through another one.
+*** ***************************************************************************/
+
+#ifndef __AUDIO_STREAMER_HEADER__
+#define __AUDIO_STREAMER_HEADER__
+
+#include "utils/utils_ring.h"
+
+namespace vt_audio
+{
+
+class AudioDescriptor;
+
+namespace private_audio
+{
+
+//! \brief The commands sent by the main thread to the streaming thread.
+enum AUDIO_STREAM_COMMAND {
+    //! Starts or resumes playing, rewinding to the given sample if the stream had ended
+    AUDIO_STREAM_COMMAND_PLAY       = 0,
+    //! Stops playing and gives the descriptor back to the main thread
+    AUDIO_STREAM_COMMAND_STOP       = 1,
+    AUDIO_STREAM_COMMAND_PAUSE      = 2,
+    AUDIO_STREAM_COMMAND_REWIND     = 3,
+    //! Seeks the stream to the given sample
+    AUDIO_STREAM_COMMAND_SEEK       = 4,
+    AUDIO_STREAM_COMMAND_LOOPING    = 5,
+    AUDIO_STREAM_COMMAND_LOOP_START = 6,
+    AUDIO_STREAM_COMMAND_LOOP_END   = 7,
+    //! Sets the source gain
+    AUDIO_STREAM_COMMAND_VOLUME     = 8,
+    //! Sets the source gain, and moves it linearly toward the target gain
+    AUDIO_STREAM_COMMAND_FADE       = 9,
+    //! Gives the descriptor back to the main thread, without changing its source state
+    AUDIO_STREAM_COMMAND_DETACH     = 10
+};
+
+//! \brief The events sent back by the streaming thread to the main thread.
+enum AUDIO_STREAM_EVENT {
+    //! The stream was entirely played
+    AUDIO_STREAM_EVENT_ENDED        = 0,
+    //! The source ran out of buffers while playing, and was restarted
+    AUDIO_STREAM_EVENT_UNDERRUN     = 1,
+    //! The streaming thread won't touch the descriptor anymore
+    AUDIO_STREAM_EVENT_DETACHED     = 2
+};
+
+//! \brief A command sent to the streaming thread.
+class AudioStreamCommand
+{
+public:
+    AUDIO_STREAM_COMMAND type;
+
+    AudioDescriptor *descriptor;
+
+    //! \brief The descriptor command count, echoed back by the events.
+    uint32 sequence;
+
+    //! \brief The source gain to set.
+    float gain;
+
+    //! \brief The fade target gain, and the time to reach it in milliseconds.
+    float target_gain;
+    float fade_time;
+
+    //! \brief The sample to seek to, the loop point, or the looping flag.
+    uint32 value;
+};
+
+//! \brief An event sent back to the main thread.
+class AudioStreamEvent
+{
+public:
+    AUDIO_STREAM_EVENT type;
+
+    AudioDescriptor *descriptor;
+
+    //! \brief The sequence of the last command handled for the descriptor.
+    uint32 sequence;
+};
+
+/** ****************************************************************************
+*** \brief Decodes and queues the streamed audio buffers in a dedicated thread
+***
+*** A streamed audio descriptor is handed to the streaming thread by the first
+*** command sent for it, and is given back once the thread has reported it as
+*** detached with the sequence of the last command sent. In between, only the
+*** streaming thread may use its stream and its buffers.
+***
+*** \note All the public methods must be called from the main thread.
+*** ***************************************************************************/
+class AudioStreamer
+{
+public:
+    AudioStreamer();
+
+    //! \brief Stops the streaming thread.
+    ~AudioStreamer();
+
+    /** \brief Spawns the streaming thread.
+    *** \return false if the thread couldn't be created, the streams are then updated by the main thread.
+    **/
+    bool Start();
+
+    //! \brief Stops the streaming thread and waits for it.
+    void Stop();
+
+    //! \brief Tells whether the streaming thread is running.
+    bool IsRunning() const {
+        return _thread != NULL;
+    }
+
+    /** \brief Sends a command to the streaming thread
+    *** Waits for room in the queue when it is full, dispatching the pending events meanwhile.
+    **/
+    void SendCommand(const AudioStreamCommand &command);
+
+    //! \brief Forwards the pending events to their audio descriptors.
+    void DispatchEvents();
+
+    /** \brief Waits until the streaming thread has given the descriptor back
+    *** The pending events are dispatched meanwhile.
+    **/
+    void WaitForDetach(AudioDescriptor *descriptor);
+
+    //! \brief Returns the number of underruns reported since the engine was started.
+    uint32 GetNumberUnderruns() const {
+        return _number_underruns;
+    }
+
+private:
+    //! \brief A descriptor the streaming thread keeps the source buffers filled for.
+    class Stream
+    {
+    public:
+        Stream() :
+            descriptor(NULL), sequence(0), playing(false), gain(0.0f), target_gain(0.0f), fade_step(0.0f) {}
+
+        AudioDescriptor *descriptor;
+
+        //! \brief The sequence of the last command handled for the descriptor.
+        uint32 sequence;
+
+        //! \brief Whether the source is supposed to be playing.
+        bool playing;
+
+        //! \brief The current source gain.
+        float gain;
+
+        //! \brief The fade target gain, and the gain change per millisecond. No fade is done when 0.
+        float target_gain;
+        float fade_step;
+    };
+
+    //! \brief The number of commands and events each queue can hold.
+    static const uint32 QUEUE_SIZE = 256;
+
+    //! \brief The commands sent by the main thread.
+    vt_utils::RingQueue<AudioStreamCommand, QUEUE_SIZE> _commands;
+
+    //! \brief The events sent by the streaming thread.
+    vt_utils::RingQueue<AudioStreamEvent, QUEUE_SIZE> _events;
+
+    //! \brief The streaming thread, or NULL when not running.
+    Thread *_thread;
+
+    //! \brief Tells the streaming thread to exit.
+    volatile bool _quit;
+
+    //! \brief The number of underruns dispatched so far.
+    uint32 _number_underruns;
+
+    //! \brief The descriptors streamed by the thread. Only used by the streaming thread.
+    std::vector<Stream> _streams;
+
+    //! \brief The streaming thread function.
+    void _StreamingLoop();
+
+    //! \brief Handles a command. Streaming thread only.
+    void _HandleCommand(const AudioStreamCommand &command);
+
+    /** \brief Refills the processed buffers of a stream, and restarts its source on underruns. Streaming thread only.
+    *** \return false once the stream has ended.
+    **/
+    bool _UpdateStream(Stream &stream, uint32 elapsed_time);
+
+    //! \brief Refills and queues every buffer of a descriptor, after a seek. Streaming thread only.
+    void _PrepareBuffers(Stream &stream);
+
+    //! \brief Returns the stream of a descriptor, or NULL if it isn't streamed. Streaming thread only.
+    Stream *_FindStream(AudioDescriptor *descriptor);
+
+    //! \brief Removes the stream of a descriptor, if any. Streaming thread only.
+    void _RemoveStream(AudioDescriptor *descriptor);
+
+    //! \brief Sends an event, waiting for room in the queue when it is full. Streaming thread only.
+    void _SendEvent(AUDIO_STREAM_EVENT type, AudioDescriptor *descriptor, uint32 sequence);
+}; // class AudioStreamer
+
+} // namespace private_audio
+
+} // namespace vt_audio
+
+#endif // __AUDIO_STREAMER_HEADER__
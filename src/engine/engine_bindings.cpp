@@ -48,6 +48,7 @@ void BindEngineCode()
         [
             luabind::class_<AudioEngine>("GameAudio")
             .def("LoadSound", &AudioEngine::LoadSound)
+            .def("PreloadSound", &AudioEngine::PreloadSound)
             .def("PlaySound", &AudioEngine::PlaySound)
             .def("PlayMusic", &AudioEngine::PlayMusic)
             .def("LoadMusic", &AudioEngine::LoadMusic)
@@ -42,6 +42,26 @@ namespace vt_input
 InputEngine *InputManager = NULL;
 bool INPUT_DEBUG = false;
 
+//! \brief The input record file header, and its version.
+const char INPUT_RECORD_MAGIC[8] = { 'V', 'T', 'I', 'N', 'P', 'R', 'E', 'C' };
+const uint32 INPUT_RECORD_VERSION = 1;
+
+//! \brief Written as is, to tell the records written on a machine of another byte order.
+const uint32 INPUT_RECORD_BYTE_ORDER = 0x01020304;
+
+//! \brief The number of input flags packed in a recorded input state.
+const uint32 INPUT_RECORD_FLAGS = 27;
+
+//! \brief The recorded input state ending the record, once every step is replayed.
+const uint32 INPUT_RECORD_END = 0x80000000;
+
+//! \brief Writes a step number and its input state to an input record. \return false on failure.
+static bool WriteInputRecord(FILE *file, uint32 step, uint32 state)
+{
+    uint32 record[2] = { step, state };
+    return (fwrite(record, sizeof(uint32), 2, file) == 2);
+}
+
 // Initializes class members
 InputEngine::InputEngine()
 {
@@ -76,6 +96,12 @@ InputEngine::InputEngine()
     _quit_press           = false;
     _help_press           = false;
 
+    _record_file          = NULL;
+    _replay_index         = 0;
+    _replaying            = false;
+    _record_step          = 0;
+    _recorded_state       = 0;
+
     _joysticks_enabled    = true;
     _joystick.js          = NULL;
     _joystick.x_axis      = 0;
@@ -97,6 +123,7 @@ InputEngine::~InputEngine()
     IF_PRINT_WARNING(INPUT_DEBUG) << "INPUT: InputEngine destructor invoked"
                                   << std::endl;
 
+    StopRecording();
     DeinitializeJoysticks();
 }
 
@@ -260,6 +287,12 @@ void InputEngine::EventHandler()
 
     // NOTE: We don't reinit the D-Pad/hat values on purpose here.
 
+    // The replayed input replaces the keyboard and joystick events.
+    if(_replaying) {
+        _ReplayStep();
+        return;
+    }
+
     // Loops until there are no remaining events to process
     while(SDL_PollEvent(&event)) {
         _event = event;
@@ -305,9 +338,203 @@ void InputEngine::EventHandler()
             _JoystickEventHandler(event);
         }
     } // while (SDL_PollEvent(&event)
+
+    if(_record_file)
+        _RecordStep();
 } // void InputEngine::EventHandler()
 
 
+bool InputEngine::StartRecording(const std::string &filename)
+{
+    StopRecording();
+    if(_replaying) {
+        PRINT_WARNING << "The input can't be recorded while being replayed." << std::endl;
+        return false;
+    }
+
+    _record_file = fopen(filename.c_str(), "wb");
+    if(!_record_file) {
+        PRINT_ERROR << "Couldn't open the input record file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    // The gameplay random numbers are drawn from the seed stored in the record.
+    uint32 seed = static_cast<uint32>(time(NULL));
+    srand(static_cast<unsigned int>(seed));
+
+    uint32 header[3] = { INPUT_RECORD_VERSION, INPUT_RECORD_BYTE_ORDER, seed };
+    if(fwrite(INPUT_RECORD_MAGIC, 1, sizeof(INPUT_RECORD_MAGIC), _record_file) != sizeof(INPUT_RECORD_MAGIC)
+            || fwrite(header, sizeof(uint32), 3, _record_file) != 3) {
+        PRINT_ERROR << "Couldn't write the input record file: " << filename << std::endl;
+        fclose(_record_file);
+        _record_file = NULL;
+        return false;
+    }
+
+    _record_step = 0;
+    _recorded_state = 0;
+    return true;
+}
+
+
+void InputEngine::StopRecording()
+{
+    if(!_record_file)
+        return;
+
+    if(!WriteInputRecord(_record_file, _record_step, INPUT_RECORD_END) || fclose(_record_file) != 0)
+        PRINT_WARNING << "Couldn't write the end of the input record file." << std::endl;
+    _record_file = NULL;
+}
+
+
+bool InputEngine::StartReplay(const std::string &filename)
+{
+    StopRecording();
+
+    FILE *file = fopen(filename.c_str(), "rb");
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the input record file: " << filename << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(INPUT_RECORD_MAGIC)];
+    uint32 header[3];
+    if(fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+            || memcmp(magic, INPUT_RECORD_MAGIC, sizeof(magic)) != 0
+            || fread(header, sizeof(uint32), 3, file) != 3
+            || header[0] > INPUT_RECORD_VERSION || header[1] != INPUT_RECORD_BYTE_ORDER) {
+        PRINT_ERROR << "Invalid input record file: " << filename << std::endl;
+        fclose(file);
+        return false;
+    }
+
+    _replay_records.clear();
+    uint32 record[2];
+    while(fread(record, sizeof(uint32), 2, file) == 2) {
+        // The steps only go forward, and nothing follows the end of the record.
+        if(!_replay_records.empty() && record[0] <= _replay_records.back().first) {
+            PRINT_ERROR << "Invalid step order in the input record file: " << filename << std::endl;
+            fclose(file);
+            _replay_records.clear();
+            return false;
+        }
+        _replay_records.push_back(std::make_pair(record[0], record[1]));
+        if(record[1] & INPUT_RECORD_END)
+            break;
+    }
+    fclose(file);
+
+    // The game may have ended before the record was closed.
+    if(_replay_records.empty() || !(_replay_records.back().second & INPUT_RECORD_END)) {
+        PRINT_WARNING << "The input record file was cut off, it is replayed up to its last step: "
+                      << filename << std::endl;
+        uint32 end_step = _replay_records.empty() ? 0 : _replay_records.back().first + 1;
+        _replay_records.push_back(std::make_pair(end_step, INPUT_RECORD_END));
+    }
+
+    srand(static_cast<unsigned int>(header[2]));
+
+    _replay_index = 0;
+    _replaying = true;
+    _record_step = 0;
+    _recorded_state = 0;
+    _SetRecordState(0);
+    return true;
+}
+
+
+uint32 InputEngine::_GetRecordState() const
+{
+    // The order of the flags is the one of the input records, and must be kept.
+    const bool flags[INPUT_RECORD_FLAGS] = {
+        UpState(), DownState(), LeftState(), RightState(), _confirm_state, _cancel_state,
+        _up_press, _down_press, _left_press, _right_press, _confirm_press, _cancel_press,
+        _menu_press, _minimap_press, _pause_press, _quit_press, _help_press,
+        _up_release, _down_release, _left_release, _right_release, _confirm_release, _cancel_release,
+        _menu_release, _minimap_release,
+        _any_key_press, _any_key_release
+    };
+
+    uint32 state = 0;
+    for(uint32 i = 0; i < INPUT_RECORD_FLAGS; ++i) {
+        if(flags[i])
+            state |= (1 << i);
+    }
+    return state;
+}
+
+
+void InputEngine::_SetRecordState(uint32 state)
+{
+    bool *flags[INPUT_RECORD_FLAGS] = {
+        &_up_state, &_down_state, &_left_state, &_right_state, &_confirm_state, &_cancel_state,
+        &_up_press, &_down_press, &_left_press, &_right_press, &_confirm_press, &_cancel_press,
+        &_menu_press, &_minimap_press, &_pause_press, &_quit_press, &_help_press,
+        &_up_release, &_down_release, &_left_release, &_right_release, &_confirm_release, &_cancel_release,
+        &_menu_release, &_minimap_release,
+        &_any_key_press, &_any_key_release
+    };
+
+    for(uint32 i = 0; i < INPUT_RECORD_FLAGS; ++i)
+        *flags[i] = ((state & (1 << i)) != 0);
+
+    // The recorded directions already include the D-Pad/hat ones.
+    _hat_up_state = false;
+    _hat_down_state = false;
+    _hat_left_state = false;
+    _hat_right_state = false;
+}
+
+
+void InputEngine::_RecordStep()
+{
+    uint32 state = _GetRecordState();
+    if(_record_step == 0 || state != _recorded_state) {
+        if(!WriteInputRecord(_record_file, _record_step, state)) {
+            PRINT_ERROR << "Couldn't write the input record file, the recording is stopped." << std::endl;
+            fclose(_record_file);
+            _record_file = NULL;
+            return;
+        }
+        _recorded_state = state;
+    }
+    ++_record_step;
+}
+
+
+void InputEngine::_ReplayStep()
+{
+    // Closing the window still ends the replay, but every other event is dropped.
+    SDL_Event event;
+    while(SDL_PollEvent(&event)) {
+        if(event.type == SDL_QUIT) {
+            _replaying = false;
+            SystemManager->ExitGame();
+            return;
+        }
+    }
+
+    if(_replay_index < _replay_records.size() && _replay_records[_replay_index].first == _record_step) {
+        uint32 state = _replay_records[_replay_index].second;
+        ++_replay_index;
+
+        if(state & INPUT_RECORD_END) {
+            IF_PRINT_WARNING(INPUT_DEBUG) << "The input replay ended after " << _record_step << " steps." << std::endl;
+            _replaying = false;
+            _SetRecordState(0);
+            SystemManager->ExitGame();
+            return;
+        }
+        _recorded_state = state;
+    }
+
+    // The steps without any record keep the state of the previous one.
+    _SetRecordState(_recorded_state);
+    ++_record_step;
+}
+
+
 
 // Handles all keyboard events for the game
 void InputEngine::_KeyEventHandler(SDL_KeyboardEvent &key_event)
@@ -353,6 +580,47 @@ void InputEngine::_KeyEventHandler(SDL_KeyboardEvent &key_event)
                 // Display and cycle through the texture sheets
                 TextureManager->DEBUG_NextTexSheet();
                 return;
+            } else if(key_event.keysym.sym == SDLK_p) {
+                // Toggle the frame profiler overlay
+                VideoManager->ToggleProfiler();
+                return;
+            } else if(key_event.keysym.sym == SDLK_e) {
+                // Export the frame profiler markers as a Chrome trace
+                if(!SystemManager->GetProfiler().IsEnabled()) {
+                    PRINT_WARNING << "The frame profiler must be enabled first, with Ctrl+P." << std::endl;
+                    return;
+                }
+                static uint32 i = 1;
+                std::string path = "";
+                while(true) {
+                    path = vt_utils::GetUserDataPath() + "profile_" + NumberToString<uint32>(i) + ".json";
+                    if(!DoesFileExist(path))
+                        break;
+                    i++;
+                }
+                if(SystemManager->GetProfiler().ExportTrace(path))
+                    std::cout << "Frame profiler trace written to: " << path << std::endl;
+                return;
+            } else if(key_event.keysym.sym == SDLK_l) {
+                // Start sampling the Lua functions, or dump the results and stop
+                ScriptProfiler &profiler = ScriptManager->GetProfiler();
+                if(!profiler.IsRunning()) {
+                    ScriptManager->StartProfiling(true);
+                    std::cout << "Script profiler started." << std::endl;
+                    return;
+                }
+                static uint32 i = 1;
+                std::string path = "";
+                while(true) {
+                    path = vt_utils::GetUserDataPath() + "script_profile_" + NumberToString<uint32>(i) + ".txt";
+                    if(!DoesFileExist(path))
+                        break;
+                    i++;
+                }
+                ScriptManager->StopProfiling();
+                if(profiler.Dump(path))
+                    std::cout << "Script profile written to: " << path << std::endl;
+                return;
             }
 #endif
 
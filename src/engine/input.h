@@ -139,6 +139,10 @@ public:
 *** - Ctrl+S     :: saves a screenshot of the current screen
 *** - Quit Event :: same as Ctrl+Q, this happens when the user tries to close the game window
 ***
+*** The input state of every update step can be recorded to a file, and replayed
+*** later on in place of the keyboard and joystick events. The Ctrl combinations,
+*** the help window display and the key remapping aren't recorded.
+***
 *** \note This class is a singleton.
 ***
 *** \note Unlike other inputs, pause and quit events are only monitored by presses and have no
@@ -183,6 +187,24 @@ private:
     //! Any joystick axis moved
     int8 _last_axis_moved;
 
+    //! \brief The input record file being written, or NULL when not recording.
+    FILE *_record_file;
+
+    //! \brief The recorded step numbers and input states, while replaying.
+    std::vector<std::pair<uint32, uint32> > _replay_records;
+
+    //! \brief The next record to apply, while replaying.
+    uint32 _replay_index;
+
+    //! \brief Whether the input is replayed from a record instead of being read.
+    bool _replaying;
+
+    //! \brief The number of update steps since the record or the replay started.
+    uint32 _record_step;
+
+    //! \brief The last input state written to the record, or read from it while replaying.
+    uint32 _recorded_state;
+
     /** \name  Input State Members
     *** \brief Retain whether an input key/button is currently being held down
     **/
@@ -261,6 +283,18 @@ private:
     *** \param new_button button to replace the old value
     **/
     void _SetNewJoyButton(uint8 &old_button, uint8 new_button);
+
+    //! \brief Returns the input state of the current step, packed as stored in the input records.
+    uint32 _GetRecordState() const;
+
+    //! \brief Sets the input state of the current step from a packed one.
+    void _SetRecordState(uint32 state);
+
+    //! \brief Writes the input state of the current step to the record, when it has changed.
+    void _RecordStep();
+
+    //! \brief Applies the recorded input state of the current step, and ends the replay with the record.
+    void _ReplayStep();
 public:
     ~InputEngine();
 
@@ -315,6 +349,38 @@ public:
     **/
     void EventHandler();
 
+    /** \brief Starts recording the input state of every update step to a file
+    *** \param filename The input record file to write
+    *** \return False if the file couldn't be opened for writing.
+    ***
+    *** The random number generator is seeded anew, and the seed is stored in the
+    *** record, so that the replay draws the same random numbers. Only the state
+    *** changes are written, along with the step they happen at.
+    **/
+    bool StartRecording(const std::string &filename);
+
+    //! \brief Ends the input record, if any, and closes its file.
+    void StopRecording();
+
+    /** \brief Starts replaying an input record instead of reading the keyboard and joysticks
+    *** \param filename The input record file to read
+    *** \return False if the file couldn't be read or isn't a valid input record.
+    ***
+    *** The random number generator is seeded as it was when recording, and the
+    *** game exits once every recorded step is replayed. The main loop then runs
+    *** a single update step per frame, so that the replay doesn't depend on the
+    *** frame rate.
+    **/
+    bool StartReplay(const std::string &filename);
+
+    bool IsRecording() const {
+        return (_record_file != NULL);
+    }
+
+    bool IsReplaying() const {
+        return _replaying;
+    }
+
     /** \name   Input state member access functions
     *** \return True if the input event key/button is being held down
     **/
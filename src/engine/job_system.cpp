@@ -0,0 +1,487 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    job_system.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the jobs run by the worker threads.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/job_system.h"
+
+#include "engine/system.h"
+
+namespace vt_system
+{
+
+extern bool SYSTEM_DEBUG;
+
+//! \brief Returns the number of processors available, or 1 when unknown.
+static uint32 GetNumberProcessors()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? static_cast<uint32>(info.dwNumberOfProcessors) : 1;
+#else
+    long number = sysconf(_SC_NPROCESSORS_ONLN);
+    return number > 0 ? static_cast<uint32>(number) : 1;
+#endif
+}
+
+//! \brief Locks a semaphore, unless there is none because threads aren't available.
+static void LockIfAny(Semaphore *semaphore)
+{
+    if(semaphore != NULL)
+        SystemManager->LockThread(semaphore);
+}
+
+//! \brief Unlocks a semaphore, unless there is none because threads aren't available.
+static void UnlockIfAny(Semaphore *semaphore)
+{
+    if(semaphore != NULL)
+        SystemManager->UnlockThread(semaphore);
+}
+
+//! \brief Returns the profiler marker name of a job type.
+static const char *GetJobTypeName(JOB_TYPE type)
+{
+    switch(type) {
+    case JOB_TYPE_IMAGE_DECODING:
+        return "Job: image decoding";
+    case JOB_TYPE_AUDIO_DECODING:
+        return "Job: audio decoding";
+    case JOB_TYPE_SCRIPT_PARSING:
+        return "Job: script parsing";
+    case JOB_TYPE_PARTICLES:
+        return "Job: particles";
+    default:
+        return "Job";
+    }
+}
+
+float JobWorkerStatistics::GetUtilisation() const
+{
+    uint32 elapsed_time = SDL_GetTicks() - start_time;
+    if(elapsed_time == 0)
+        return 0.0f;
+
+    return std::min(1.0f, static_cast<float>(busy_time) / static_cast<float>(elapsed_time));
+}
+
+namespace private_system
+{
+
+void JobWorker::_Loop()
+{
+    while(true) {
+        SystemManager->LockThread(_system->_work_semaphore);
+        if(_system->_quit)
+            return;
+
+        // Another thread may have taken the job this wake up was for.
+        bool stolen = false;
+        Job *job = _system->_TakeJob(_index, stolen);
+        if(job != NULL)
+            _system->_RunJob(this, job, stolen);
+    }
+}
+
+} // namespace private_system
+
+using namespace private_system;
+
+JobSystem::JobSystem() :
+    _lock(NULL),
+    _work_semaphore(NULL),
+    _done_semaphore(NULL),
+    _main_waiting(false),
+    _next_handle(JOB_HANDLE_NONE + 1),
+    _next_queue(0),
+    _number_threads(0),
+    _quit(false),
+    _started(false)
+{}
+
+JobSystem::~JobSystem()
+{
+    Stop();
+}
+
+void JobSystem::_StartWorkers()
+{
+    _started = true;
+    _quit = false;
+
+    uint32 number_workers = 0;
+#if (THREAD_TYPE == SDL_THREADS)
+    // The main thread runs jobs as well, while waiting for them.
+    number_workers = std::min(GetNumberProcessors() - 1, MAX_JOB_WORKERS);
+
+    _lock = SystemManager->CreateSemaphore(1);
+    _work_semaphore = SystemManager->CreateSemaphore(0);
+    _done_semaphore = SystemManager->CreateSemaphore(0);
+#endif
+
+    // Every queue is created before the threads start stealing from them.
+    for(uint32 i = 0; i <= number_workers; ++i) {
+        JobWorker *worker = new JobWorker(this, i);
+        worker->_statistics.start_time = SDL_GetTicks();
+#if (THREAD_TYPE == SDL_THREADS)
+        worker->_queue_lock = SystemManager->CreateSemaphore(1);
+#endif
+        _workers.push_back(worker);
+    }
+
+    // A worker queue left without its thread is emptied by the other threads.
+    for(uint32 i = 1; i < _workers.size(); ++i) {
+        _workers[i]->_thread = SystemManager->SpawnThread(&JobWorker::_Loop, _workers[i]);
+        if(_workers[i]->_thread == NULL)
+            break;
+        ++_number_threads;
+    }
+
+    if(_number_threads == 0)
+        PRINT_WARNING << "No job worker threads could be created, the jobs will be run by the main thread only." << std::endl;
+    else
+        IF_PRINT_DEBUG(SYSTEM_DEBUG) << "started " << _number_threads << " job worker threads" << std::endl;
+}
+
+void JobSystem::Stop()
+{
+    if(!_started)
+        return;
+
+    _quit = true;
+    for(uint32 i = 0; i < _number_threads; ++i)
+        SystemManager->UnlockThread(_work_semaphore);
+    for(uint32 i = 1; i < _workers.size(); ++i) {
+        if(_workers[i]->_thread != NULL)
+            SystemManager->WaitForThread(_workers[i]->_thread);
+    }
+    _number_threads = 0;
+
+    // Every job not finished yet, whether queued or done, is still known by its handle.
+    for(std::map<JobHandle, Job *>::iterator it = _jobs.begin(); it != _jobs.end(); ++it)
+        delete it->second;
+    _jobs.clear();
+    _done_jobs.clear();
+
+    for(uint32 i = 0; i < _workers.size(); ++i) {
+        if(_workers[i]->_queue_lock != NULL)
+            SystemManager->DestroySemaphore(_workers[i]->_queue_lock);
+        delete _workers[i];
+    }
+    _workers.clear();
+
+    if(_lock != NULL)
+        SystemManager->DestroySemaphore(_lock);
+    if(_work_semaphore != NULL)
+        SystemManager->DestroySemaphore(_work_semaphore);
+    if(_done_semaphore != NULL)
+        SystemManager->DestroySemaphore(_done_semaphore);
+    _lock = NULL;
+    _work_semaphore = NULL;
+    _done_semaphore = NULL;
+
+    _main_waiting = false;
+    _started = false;
+}
+
+JobHandle JobSystem::Submit(Job *job)
+{
+    return Submit(job, std::vector<JobHandle>());
+}
+
+JobHandle JobSystem::Submit(Job *job, JobHandle dependency)
+{
+    return Submit(job, std::vector<JobHandle>(1, dependency));
+}
+
+JobHandle JobSystem::Submit(Job *job, const std::vector<JobHandle> &dependencies)
+{
+    if(job == NULL) {
+        PRINT_WARNING << "function received NULL argument" << std::endl;
+        return JOB_HANDLE_NONE;
+    }
+
+    if(!_started)
+        _StartWorkers();
+
+    LockIfAny(_lock);
+
+    JobHandle handle = _next_handle++;
+    if(_next_handle == JOB_HANDLE_NONE)
+        ++_next_handle;
+
+    job->_handle = handle;
+    job->_state = Job::JOB_STATE_WAITING;
+    job->_remaining_dependencies = 0;
+
+    for(uint32 i = 0; i < dependencies.size(); ++i) {
+        std::map<JobHandle, Job *>::iterator it = _jobs.find(dependencies[i]);
+        if(it == _jobs.end() || it->second->_state == Job::JOB_STATE_DONE)
+            continue;
+
+        it->second->_dependents.push_back(job);
+        ++job->_remaining_dependencies;
+    }
+
+    _jobs.insert(std::make_pair(handle, job));
+
+    bool ready = (job->_remaining_dependencies == 0);
+    if(ready)
+        job->_state = Job::JOB_STATE_QUEUED;
+
+    UnlockIfAny(_lock);
+
+    if(ready) {
+        // The submitted jobs are spread over the worker queues, the main thread queue
+        // being only used when there are no worker threads.
+        uint32 queue_index = 0;
+        if(_number_threads > 0) {
+            queue_index = 1 + _next_queue;
+            _next_queue = (_next_queue + 1) % (_workers.size() - 1);
+        }
+        _QueueJob(queue_index, job);
+    }
+
+    return handle;
+}
+
+bool JobSystem::IsDone(JobHandle handle)
+{
+    LockIfAny(_lock);
+    std::map<JobHandle, Job *>::const_iterator it = _jobs.find(handle);
+    bool done = (it == _jobs.end() || it->second->_state == Job::JOB_STATE_DONE);
+    UnlockIfAny(_lock);
+
+    return done;
+}
+
+void JobSystem::Wait(JobHandle handle)
+{
+    if(handle == JOB_HANDLE_NONE)
+        return;
+
+    while(true) {
+        LockIfAny(_lock);
+        std::map<JobHandle, Job *>::iterator it = _jobs.find(handle);
+        if(it == _jobs.end()) {
+            // Already finished.
+            UnlockIfAny(_lock);
+            return;
+        }
+
+        Job *job = it->second;
+        if(job->_state == Job::JOB_STATE_DONE) {
+            // The job may already be in the batch being finished by Update(), which then skips it.
+            std::vector<Job *>::iterator done_it = std::find(_done_jobs.begin(), _done_jobs.end(), job);
+            if(done_it != _done_jobs.end())
+                _done_jobs.erase(done_it);
+            UnlockIfAny(_lock);
+            _FinishJob(job);
+            return;
+        }
+        UnlockIfAny(_lock);
+
+        // Help the worker threads rather than sleeping.
+        bool stolen = false;
+        Job *ready_job = _TakeJob(0, stolen);
+        if(ready_job != NULL) {
+            _RunJob(_workers[0], ready_job, stolen);
+            continue;
+        }
+
+        if(_number_threads == 0) {
+            PRINT_ERROR << "the job waited for can never run, as no other job is ready" << std::endl;
+            return;
+        }
+
+        // The job is being run, or waits for jobs being run: sleep until one is done.
+        LockIfAny(_lock);
+        bool sleep = (job->_state != Job::JOB_STATE_DONE);
+        if(sleep)
+            _main_waiting = true;
+        UnlockIfAny(_lock);
+
+        if(sleep)
+            SystemManager->LockThread(_done_semaphore);
+    }
+}
+
+void JobSystem::Update()
+{
+    if(!_started)
+        return;
+
+    // Without worker threads, the jobs are run once per frame at least.
+    if(_number_threads == 0) {
+        bool stolen = false;
+        Job *job = NULL;
+        while((job = _TakeJob(0, stolen)) != NULL)
+            _RunJob(_workers[0], job, stolen);
+    }
+
+    // The jobs are kept by handle, as a job finished may wait for another one of them,
+    // which is then finished and deleted by Wait() first.
+    std::vector<JobHandle> done_jobs;
+    LockIfAny(_lock);
+    for(uint32 i = 0; i < _done_jobs.size(); ++i)
+        done_jobs.push_back(_done_jobs[i]->_handle);
+    _done_jobs.clear();
+    UnlockIfAny(_lock);
+
+    // The jobs may submit new ones when finished.
+    for(uint32 i = 0; i < done_jobs.size(); ++i) {
+        LockIfAny(_lock);
+        std::map<JobHandle, Job *>::iterator it = _jobs.find(done_jobs[i]);
+        Job *job = (it != _jobs.end()) ? it->second : NULL;
+        UnlockIfAny(_lock);
+
+        if(job != NULL)
+            _FinishJob(job);
+    }
+}
+
+const JobWorkerStatistics &JobSystem::GetWorkerStatistics(uint32 index) const
+{
+    static const JobWorkerStatistics no_statistics;
+    if(index >= _workers.size())
+        return no_statistics;
+
+    return _workers[index]->_statistics;
+}
+
+void JobSystem::ResetStatistics()
+{
+    for(uint32 i = 0; i < _workers.size(); ++i) {
+        _workers[i]->_statistics = JobWorkerStatistics();
+        _workers[i]->_statistics.start_time = SDL_GetTicks();
+    }
+}
+
+void JobSystem::_QueueJob(uint32 queue_index, Job *job)
+{
+    JobWorker *worker = _workers[queue_index];
+
+    LockIfAny(worker->_queue_lock);
+    worker->_queue.push_back(job);
+    UnlockIfAny(worker->_queue_lock);
+
+    if(_number_threads > 0)
+        SystemManager->UnlockThread(_work_semaphore);
+}
+
+Job *JobSystem::_TakeJob(uint32 worker_index, bool &stolen)
+{
+    Job *job = NULL;
+    stolen = false;
+
+    // The last job pushed in its own queue is the most likely to be in the cache.
+    JobWorker *worker = _workers[worker_index];
+    LockIfAny(worker->_queue_lock);
+    if(!worker->_queue.empty()) {
+        job = worker->_queue.back();
+        worker->_queue.pop_back();
+    }
+    UnlockIfAny(worker->_queue_lock);
+
+    if(job != NULL)
+        return job;
+
+    // Steal the oldest job of the next queue which has one.
+    for(uint32 i = 1; i < _workers.size(); ++i) {
+        JobWorker *victim = _workers[(worker_index + i) % _workers.size()];
+
+        LockIfAny(victim->_queue_lock);
+        if(!victim->_queue.empty()) {
+            job = victim->_queue.front();
+            victim->_queue.pop_front();
+        }
+        UnlockIfAny(victim->_queue_lock);
+
+        if(job != NULL) {
+            stolen = true;
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+void JobSystem::_RunJob(JobWorker *worker, Job *job, bool stolen)
+{
+    JOB_TYPE type = job->_type;
+
+    uint32 start_time = SDL_GetTicks();
+    {
+        ProfilerScope marker(GetJobTypeName(type));
+        job->Run();
+    }
+
+    JobWorkerStatistics &statistics = worker->_statistics;
+    statistics.busy_time += SDL_GetTicks() - start_time;
+    ++statistics.jobs_run;
+    ++statistics.jobs_run_by_type[type];
+    if(stolen)
+        ++statistics.jobs_stolen;
+
+    // The job may be finished by the main thread as soon as the lock is released.
+    std::vector<Job *> ready_jobs;
+    LockIfAny(_lock);
+    job->_state = Job::JOB_STATE_DONE;
+    _done_jobs.push_back(job);
+
+    for(uint32 i = 0; i < job->_dependents.size(); ++i) {
+        Job *dependent = job->_dependents[i];
+        if(--dependent->_remaining_dependencies > 0)
+            continue;
+
+        dependent->_state = Job::JOB_STATE_QUEUED;
+        ready_jobs.push_back(dependent);
+    }
+    job->_dependents.clear();
+
+    // Wake the main thread up only once the jobs made ready can be taken.
+    bool wake_main = _main_waiting && ready_jobs.empty();
+    if(wake_main)
+        _main_waiting = false;
+    UnlockIfAny(_lock);
+
+    if(ready_jobs.empty()) {
+        if(wake_main)
+            SystemManager->UnlockThread(_done_semaphore);
+        return;
+    }
+
+    for(uint32 i = 0; i < ready_jobs.size(); ++i)
+        _QueueJob(worker->_index, ready_jobs[i]);
+
+    LockIfAny(_lock);
+    wake_main = _main_waiting;
+    _main_waiting = false;
+    UnlockIfAny(_lock);
+
+    if(wake_main)
+        SystemManager->UnlockThread(_done_semaphore);
+}
+
+void JobSystem::_FinishJob(Job *job)
+{
+    LockIfAny(_lock);
+    _jobs.erase(job->_handle);
+    UnlockIfAny(_lock);
+
+    job->Finish();
+    delete job;
+}
+
+} // namespace vt_system
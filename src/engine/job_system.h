@@ -0,0 +1,342 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    job_system.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the jobs run by the worker threads.
+***
+*** The engines hand their heavy and independent work, such as decoding images
+*** or sounds, to a pool of worker threads as jobs. Each worker thread has its
+*** own queue of jobs, and takes jobs from the other queues once its own is
+*** empty, so that the work is spread over the threads without any scheduling.
+***
+*** A job may depend on other jobs, and is only queued once all of them have
+*** run. Once run, a job is handed back to the main thread, which finishes it:
+*** that's where its results are given to the engine which submitted it.
+*** ***************************************************************************/
+
+#ifndef __JOB_SYSTEM_HEADER__
+#define __JOB_SYSTEM_HEADER__
+
+namespace vt_system
+{
+
+class JobSystem;
+
+//! \brief The kinds of jobs, used to sort the statistics.
+enum JOB_TYPE {
+    JOB_TYPE_GENERIC        = 0,
+    JOB_TYPE_IMAGE_DECODING = 1,
+    JOB_TYPE_AUDIO_DECODING = 2,
+    JOB_TYPE_SCRIPT_PARSING = 3,
+    JOB_TYPE_PARTICLES      = 4,
+    JOB_TYPE_TOTAL          = 5
+};
+
+//! \brief Identifies a submitted job, until it is finished.
+typedef uint32 JobHandle;
+
+//! \brief The handle never given to a job.
+const JobHandle JOB_HANDLE_NONE = 0;
+
+//! \brief The maximum number of worker threads.
+const uint32 MAX_JOB_WORKERS = 7;
+
+/** ****************************************************************************
+*** \brief A piece of work run by any of the worker threads
+***
+*** A job is owned by the job system once submitted, and deleted once finished.
+***
+*** \note Run() is called from any thread, including the main thread while it
+*** waits for jobs. It must therefore not touch anything but the job data and
+*** thread-safe functions: no script, video or audio engine calls.
+*** ***************************************************************************/
+class Job
+{
+    friend class JobSystem;
+
+public:
+    explicit Job(JOB_TYPE type) :
+        _type(type),
+        _handle(JOB_HANDLE_NONE),
+        _state(JOB_STATE_WAITING),
+        _remaining_dependencies(0)
+    {}
+
+    virtual ~Job()
+    {}
+
+    //! \brief Does the work of the job. Called once, from any thread.
+    virtual void Run() = 0;
+
+    //! \brief Hands the results over, once the job has run. Called once, from the main thread.
+    virtual void Finish()
+    {}
+
+    JOB_TYPE GetType() const {
+        return _type;
+    }
+
+private:
+    //! \brief The job states, protected by the job system lock.
+    enum JOB_STATE {
+        //! Waiting for some of its dependencies to run
+        JOB_STATE_WAITING = 0,
+        //! In a worker queue, or being run
+        JOB_STATE_QUEUED  = 1,
+        //! Run, and waiting for the main thread to finish it
+        JOB_STATE_DONE    = 2
+    };
+
+    JOB_TYPE _type;
+
+    JobHandle _handle;
+
+    JOB_STATE _state;
+
+    //! \brief The number of dependencies which haven't run yet.
+    uint32 _remaining_dependencies;
+
+    //! \brief The jobs waiting for this one to run.
+    std::vector<Job *> _dependents;
+}; // class Job
+
+/** ****************************************************************************
+*** \brief Runs a method of an object as a job
+***
+*** \note The object must outlive the job, which the owner usually makes sure
+*** of by waiting for the job before being deleted.
+*** ***************************************************************************/
+template <class T>
+class MethodJob : public Job
+{
+public:
+    MethodJob(JOB_TYPE type, T *object, void (T::*run)(), void (T::*finish)() = NULL) :
+        Job(type),
+        _object(object),
+        _run(run),
+        _finish(finish)
+    {}
+
+    void Run() {
+        (_object->*_run)();
+    }
+
+    void Finish() {
+        if(_finish != NULL)
+            (_object->*_finish)();
+    }
+
+private:
+    T *_object;
+
+    //! \brief The method run by any thread, and the one run by the main thread once done, if any.
+    void (T::*_run)();
+    void (T::*_finish)();
+}; // class MethodJob
+
+//! \brief The utilisation counters of a worker thread, since the last statistics reset.
+class JobWorkerStatistics
+{
+public:
+    JobWorkerStatistics() :
+        jobs_run(0), jobs_stolen(0), busy_time(0), start_time(0)
+    {
+        for(uint32 i = 0; i < JOB_TYPE_TOTAL; ++i)
+            jobs_run_by_type[i] = 0;
+    }
+
+    //! \brief The number of jobs run, and how many of them were taken from another queue.
+    uint32 jobs_run;
+    uint32 jobs_stolen;
+
+    //! \brief The number of jobs run of each type.
+    uint32 jobs_run_by_type[JOB_TYPE_TOTAL];
+
+    //! \brief The time spent running jobs, in milliseconds.
+    uint32 busy_time;
+
+    //! \brief The time the counters were reset at, in milliseconds.
+    uint32 start_time;
+
+    //! \brief Returns the part of the time spent running jobs since the reset, from 0.0f to 1.0f.
+    float GetUtilisation() const;
+};
+
+namespace private_system
+{
+
+/** ****************************************************************************
+*** \brief A job queue, and the thread running its jobs
+***
+*** The thread takes its jobs from the back of its queue, where the jobs it
+*** makes ready are pushed, and steals the oldest jobs from the front of the
+*** other queues.
+*** ***************************************************************************/
+class JobWorker
+{
+    friend class vt_system::JobSystem;
+
+public:
+    JobWorker(JobSystem *system, uint32 index) :
+        _system(system),
+        _index(index),
+        _thread(NULL),
+        _queue_lock(NULL)
+    {}
+
+private:
+    JobSystem *_system;
+
+    //! \brief The worker index in the job system, 0 being the main thread.
+    uint32 _index;
+
+    //! \brief The worker thread, or NULL for the main thread.
+    Thread *_thread;
+
+    //! \brief The jobs ready to run, protected by _queue_lock.
+    std::deque<Job *> _queue;
+
+    Semaphore *_queue_lock;
+
+    //! \brief The utilisation counters, only written by the worker thread.
+    JobWorkerStatistics _statistics;
+
+    //! \brief The worker thread function.
+    void _Loop();
+}; // class JobWorker
+
+} // namespace private_system
+
+/** ****************************************************************************
+*** \brief Runs the submitted jobs on a pool of worker threads
+***
+*** The worker threads are spawned on the first job submitted, one less than
+*** the number of processors, and sleep while there are no jobs to run. When
+*** no thread could be spawned, the jobs are run by the main thread, either
+*** when waited for or on the next update.
+***
+*** \note All the public methods must be called from the main thread, which
+*** is also the only one finishing the jobs.
+*** ***************************************************************************/
+class JobSystem
+{
+    friend class private_system::JobWorker;
+
+public:
+    JobSystem();
+
+    ~JobSystem();
+
+    /** \brief Submits a job, to be run once all of its dependencies have
+    *** \param job The job, deleted by the job system once finished
+    *** \param dependencies The jobs to run first. The handles of jobs already finished are ignored.
+    *** \return The job handle.
+    **/
+    JobHandle Submit(Job *job);
+    JobHandle Submit(Job *job, JobHandle dependency);
+    JobHandle Submit(Job *job, const std::vector<JobHandle> &dependencies);
+
+    //! \brief Tells whether a job has run. The job may still have to be finished.
+    bool IsDone(JobHandle handle);
+
+    /** \brief Runs jobs until the given one has run, and finishes it
+    *** The main thread runs the jobs ready meanwhile, its own and the ones
+    *** of the worker threads, and sleeps when there are none left.
+    *** The other jobs done are left for the next update.
+    **/
+    void Wait(JobHandle handle);
+
+    /** \brief Finishes the jobs done
+    *** This function should only be called <b>once</b> per frame, in main.cpp.
+    **/
+    void Update();
+
+    //! \brief Stops and waits for the worker threads. The jobs not finished yet are dropped.
+    void Stop();
+
+    //! \brief Returns the number of worker threads, the main thread excluded.
+    uint32 GetNumberWorkers() const {
+        return _number_threads;
+    }
+
+    /** \brief Returns the utilisation counters of a thread
+    *** \param index 0 for the main thread, or from 1 to the number of worker threads.
+    *** \note The counters of the worker threads are updated by them while being read.
+    **/
+    const JobWorkerStatistics &GetWorkerStatistics(uint32 index) const;
+
+    //! \brief Resets the utilisation counters of every thread.
+    void ResetStatistics();
+
+    //! \brief Returns the number of jobs submitted and not finished yet.
+    uint32 GetNumberPendingJobs() const {
+        return _jobs.size();
+    }
+
+private:
+    //! \brief The job queues, the one of the main thread first.
+    std::vector<private_system::JobWorker *> _workers;
+
+    //! \brief The jobs submitted and not finished yet, protected by _lock.
+    std::map<JobHandle, Job *> _jobs;
+
+    //! \brief The jobs done, waiting for the main thread to finish them, protected by _lock.
+    std::vector<Job *> _done_jobs;
+
+    //! \brief Protects the job states, dependencies and containers, but not the queues.
+    Semaphore *_lock;
+
+    //! \brief Posted once per job queued, and to make the worker threads exit.
+    Semaphore *_work_semaphore;
+
+    //! \brief Posted when a job is done while the main thread sleeps in Wait().
+    Semaphore *_done_semaphore;
+
+    //! \brief Whether the main thread sleeps until a job is done, protected by _lock.
+    bool _main_waiting;
+
+    //! \brief The handle of the next submitted job.
+    JobHandle _next_handle;
+
+    //! \brief The worker queue the next submitted job goes to.
+    uint32 _next_queue;
+
+    //! \brief The number of worker threads running.
+    uint32 _number_threads;
+
+    //! \brief Tells the worker threads to exit once woken.
+    volatile bool _quit;
+
+    //! \brief Whether the worker threads were already spawned.
+    bool _started;
+
+    //! \brief Creates the queues and spawns the worker threads according to the number of processors.
+    void _StartWorkers();
+
+    //! \brief Pushes a job ready to run at the back of a queue, and wakes a worker thread up.
+    void _QueueJob(uint32 queue_index, Job *job);
+
+    /** \brief Takes a job from the back of a worker queue, or from the front of another one
+    *** \param stolen Set to whether the job was taken from another queue
+    *** \return The job, or NULL when all the queues are empty.
+    **/
+    Job *_TakeJob(uint32 worker_index, bool &stolen);
+
+    //! \brief Runs a job on the given worker, and queues the dependents it made ready there.
+    void _RunJob(private_system::JobWorker *worker, Job *job, bool stolen);
+
+    //! \brief Finishes and deletes a done job, which must have been removed from the done jobs.
+    void _FinishJob(Job *job);
+}; // class JobSystem
+
+} // namespace vt_system
+
+#endif // __JOB_SYSTEM_HEADER__
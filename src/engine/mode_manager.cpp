@@ -22,6 +22,7 @@
 
 #include "engine/video/video.h"
 #include "engine/audio/audio.h"
+#include "engine/script/script.h"
 
 #include "modes/mode_help_window.h"
 
@@ -274,6 +275,8 @@ GameMode *ModeEngine::Get(uint32 index)
 // Checks if any game modes need to be pushed or popped off the stack, then updates the top stack mode.
 void ModeEngine::Update()
 {
+    ProfilerScope marker("ModeManager::Update");
+
     // Check whether the fade out is done.
     if(_fade_out && VideoManager->IsLastFadeTransitional() && !VideoManager->IsFading()) {
         _fade_out = false;
@@ -313,6 +316,13 @@ void ModeEngine::Update()
         // Call the newly active game mode's Reset() function to re-initialize the game mode
         _game_stack.back()->Reset();
 
+        // The screen is faded out, so it's a good time to repack the texture sheets
+        // left fragmented by the images of the previous game modes.
+        TextureManager->DefragmentTexSheets();
+
+        // It's also the time to drop the script data of the previous game modes at once.
+        vt_script::ScriptManager->CollectGarbage();
+
         // Reset the state change variable
         _state_change = false;
 
@@ -337,6 +347,8 @@ void ModeEngine::Update()
 
 void ModeEngine::Draw()
 {
+    ProfilerScope marker("ModeManager::Draw");
+
     if(_game_stack.empty())
         return;
 
@@ -20,6 +20,7 @@
 
 #include "effect_supervisor.h"
 #include "engine/video/particle_manager.h"
+#include "engine/video/particle_workers.h"
 #include "engine/script_supervisor.h"
 #include "engine/indicator_supervisor.h"
 
@@ -196,6 +197,9 @@ private:
     //! \brief A window showing help according to the current game mode.
     HelpWindow *_help_window;
 
+    //! \brief The worker threads updating the particle effects of every game mode.
+    ParticleWorkers _particle_workers;
+
 public:
     ~ModeEngine();
 
@@ -261,6 +265,11 @@ public:
         return _help_window;
     }
 
+    //! \brief Gives the worker threads the game modes update their particle effects with.
+    ParticleWorkers &GetParticleWorkers() {
+        return _particle_workers;
+    }
+
     //! \brief Prints the contents of the game_stack member to standard output.
     void DEBUG_PrintStack();
 }; // class ModeEngine : public vt_utils::Singleton<ModeEngine>
@@ -0,0 +1,264 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    profiler.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the frame profiler.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/profiler.h"
+
+#include "engine/system.h"
+
+namespace vt_system
+{
+
+using namespace private_system;
+
+//! \brief A summary line being built, along with the line it is nested in.
+struct ProfilerSummaryNode {
+    ProfilerSummaryLine line;
+    int32 parent;
+};
+
+//! \brief Tells whether a marker was entered before another one, or encloses it.
+static bool CompareProfilerMarkers(const ProfilerMarker &first, const ProfilerMarker &second)
+{
+    if(first.start_time != second.start_time)
+        return first.start_time < second.start_time;
+    return first.depth < second.depth;
+}
+
+//! \brief Appends the lines nested in the given one, each followed by its own nested lines.
+static void AppendSummaryLines(const std::vector<ProfilerSummaryNode> &nodes, int32 parent,
+                               std::vector<ProfilerSummaryLine> &lines)
+{
+    for(uint32 i = 0; i < nodes.size(); ++i) {
+        if(nodes[i].parent != parent)
+            continue;
+        lines.push_back(nodes[i].line);
+        AppendSummaryLines(nodes, static_cast<int32>(i), lines);
+    }
+}
+
+Profiler::Profiler() :
+    _enabled(false),
+    _frame(0),
+    _enable_time(0),
+    _frame_start_time(0),
+    _last_frame_time(0),
+    _number_buffers(1),
+    _lock(NULL)
+{
+    // The profiler is created along with the system engine, by the main thread.
+    _buffers[0].thread_id = SDL_ThreadID();
+}
+
+Profiler::~Profiler()
+{
+    // The system engine is being destroyed, so the semaphore is destroyed directly.
+#if (THREAD_TYPE == SDL_THREADS)
+    if(_lock != NULL)
+        SDL_DestroySemaphore(_lock);
+#endif
+}
+
+void Profiler::Enable(bool enable)
+{
+    if(enable == _enabled)
+        return;
+
+    if(enable) {
+#if (THREAD_TYPE == SDL_THREADS)
+        if(_lock == NULL)
+            _lock = SystemManager->CreateSemaphore(1);
+#endif
+        if(_buffers[0].markers.empty())
+            _buffers[0].markers.resize(PROFILER_BUFFER_SIZE);
+
+        for(uint32 i = 0; i < _number_buffers; ++i)
+            _buffers[i].number_written = 0;
+
+        _enable_time = GetPreciseTime();
+        _frame_start_time = _enable_time;
+        _last_frame_time = 0;
+    }
+    _enabled = enable;
+}
+
+void Profiler::StartFrame()
+{
+    ++_frame;
+    if(!_enabled)
+        return;
+
+    uint32 time = GetPreciseTime();
+    _last_frame_time = time - _frame_start_time;
+    _frame_start_time = time;
+}
+
+ProfilerThreadBuffer *Profiler::BeginMarker()
+{
+    ProfilerThreadBuffer *buffer = _GetThreadBuffer();
+    if(buffer != NULL)
+        ++buffer->depth;
+    return buffer;
+}
+
+void Profiler::EndMarker(ProfilerThreadBuffer *buffer, const char *name, uint32 start_time)
+{
+    uint32 end_time = GetPreciseTime();
+    --buffer->depth;
+
+    // The profiler may have been disabled meanwhile.
+    if(!_enabled)
+        return;
+
+    ProfilerMarker &marker = buffer->markers[buffer->number_written % PROFILER_BUFFER_SIZE];
+    marker.name = name;
+    marker.start_time = start_time;
+    marker.duration = end_time - start_time;
+    marker.frame = _frame;
+    marker.depth = buffer->depth;
+    ++buffer->number_written;
+}
+
+uint32 Profiler::GetLastFrameSummary(std::vector<ProfilerSummaryLine> &lines) const
+{
+    lines.clear();
+    if(!_enabled || _frame == 0)
+        return 0;
+
+    // The markers are written once left, so the last frame ones are the last ones written,
+    // along with the markers of the current frame left so far.
+    const ProfilerThreadBuffer &buffer = _buffers[0];
+    uint32 last_frame = _frame - 1;
+    uint32 number_written = buffer.number_written;
+    uint32 number_kept = std::min(number_written, PROFILER_BUFFER_SIZE);
+
+    std::vector<ProfilerMarker> markers;
+    for(uint32 i = 0; i < number_kept; ++i) {
+        const ProfilerMarker &marker = buffer.markers[(number_written - 1 - i) % PROFILER_BUFFER_SIZE];
+        if(marker.frame < last_frame)
+            break;
+        if(marker.frame == last_frame)
+            markers.push_back(marker);
+    }
+    std::sort(markers.begin(), markers.end(), CompareProfilerMarkers);
+
+    // Sum the markers entered several times in the same enclosing part up.
+    std::vector<ProfilerSummaryNode> nodes;
+    std::vector<int32> enclosing;
+    for(uint32 i = 0; i < markers.size(); ++i) {
+        const ProfilerMarker &marker = markers[i];
+        if(enclosing.size() < marker.depth)
+            continue; // The enclosing marker was left before the frame started.
+        enclosing.resize(marker.depth);
+        int32 parent = enclosing.empty() ? -1 : enclosing.back();
+
+        int32 index = -1;
+        for(uint32 j = 0; j < nodes.size(); ++j) {
+            if(nodes[j].parent == parent && strcmp(nodes[j].line.name, marker.name) == 0) {
+                index = static_cast<int32>(j);
+                break;
+            }
+        }
+        if(index < 0) {
+            ProfilerSummaryNode node;
+            node.line.name = marker.name;
+            node.line.depth = marker.depth;
+            node.parent = parent;
+            nodes.push_back(node);
+            index = static_cast<int32>(nodes.size() - 1);
+        }
+        nodes[index].line.time += marker.duration;
+        ++nodes[index].line.calls;
+        enclosing.push_back(index);
+    }
+
+    AppendSummaryLines(nodes, -1, lines);
+    return _last_frame_time;
+}
+
+bool Profiler::ExportTrace(const std::string &filename)
+{
+    std::ofstream file(filename.c_str());
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the profiler trace file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+
+    // The thread names come first.
+    uint32 number_buffers = _number_buffers;
+    for(uint32 i = 0; i < number_buffers; ++i) {
+        file << (i == 0 ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+             << ", \"args\": {\"name\": \"";
+        if(i == 0)
+            file << "Main thread";
+        else
+            file << "Thread " << i;
+        file << "\"}}";
+    }
+
+    for(uint32 i = 0; i < number_buffers; ++i) {
+        const ProfilerThreadBuffer &buffer = _buffers[i];
+        uint32 number_written = buffer.number_written;
+        uint32 number_kept = std::min(number_written, PROFILER_BUFFER_SIZE);
+
+        for(uint32 j = number_written - number_kept; j < number_written; ++j) {
+            const ProfilerMarker &marker = buffer.markers[j % PROFILER_BUFFER_SIZE];
+            if(marker.name == NULL)
+                continue;
+            // The times are relative to the profiler start, as the precise time wraps around.
+            file << ",\n{\"name\": \"" << marker.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << i
+                 << ", \"ts\": " << (marker.start_time - _enable_time) << ", \"dur\": " << marker.duration
+                 << ", \"args\": {\"frame\": " << marker.frame << "}}";
+        }
+    }
+    file << std::endl << "]}" << std::endl;
+
+    if(!file) {
+        PRINT_ERROR << "Couldn't write the profiler trace file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+ProfilerThreadBuffer *Profiler::_GetThreadBuffer()
+{
+    uint32 thread_id = SDL_ThreadID();
+    uint32 number_buffers = _number_buffers;
+    for(uint32 i = 0; i < number_buffers; ++i) {
+        if(_buffers[i].thread_id == thread_id)
+            return &_buffers[i];
+    }
+
+    // A new thread is registered, while the other threads may be registering too.
+    ProfilerThreadBuffer *buffer = NULL;
+    if(_lock != NULL)
+        SystemManager->LockThread(_lock);
+
+    if(_number_buffers < PROFILER_MAX_THREADS) {
+        buffer = &_buffers[_number_buffers];
+        buffer->thread_id = thread_id;
+        buffer->markers.resize(PROFILER_BUFFER_SIZE);
+        buffer->number_written = 0;
+        buffer->depth = 0;
+        ++_number_buffers;
+    }
+    if(_lock != NULL)
+        SystemManager->UnlockThread(_lock);
+    return buffer;
+}
+
+} // namespace vt_system
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    profiler.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the frame profiler.
+***
+*** The profiler records the time spent in the marked parts of the code, as
+*** nested markers. Each thread writes its markers to its own ring buffer, so
+*** that no lock is taken while measuring, and only the last markers are kept.
+***
+*** The markers of the last frame drawn are summed up by the profiler overlay,
+*** and every marker kept can be exported in the Chrome trace format, to be
+*** opened with chrome://tracing.
+*** ***************************************************************************/
+
+#ifndef __PROFILER_HEADER__
+#define __PROFILER_HEADER__
+
+namespace vt_system
+{
+
+class Profiler;
+
+//! \brief The maximum number of threads whose markers are recorded.
+const uint32 PROFILER_MAX_THREADS = 16;
+
+//! \brief The number of markers kept per thread.
+const uint32 PROFILER_BUFFER_SIZE = 16384;
+
+//! \brief A marked part of the code, as recorded once left.
+class ProfilerMarker
+{
+public:
+    ProfilerMarker() :
+        name(NULL), start_time(0), duration(0), frame(0), depth(0) {}
+
+    //! \brief The marker name, which must be a string literal.
+    const char *name;
+
+    //! \brief The time the part was entered at, and the time spent in it, in microseconds.
+    uint32 start_time;
+    uint32 duration;
+
+    //! \brief The frame the part was left in.
+    uint32 frame;
+
+    //! \brief The number of markers the part is nested in.
+    uint32 depth;
+};
+
+//! \brief The time spent in a marked part of the last frame, as shown by the overlay.
+class ProfilerSummaryLine
+{
+public:
+    ProfilerSummaryLine() :
+        name(NULL), depth(0), time(0), calls(0) {}
+
+    const char *name;
+    uint32 depth;
+
+    //! \brief The total time spent in the part, in microseconds, and the number of times it was entered.
+    uint32 time;
+    uint32 calls;
+};
+
+namespace private_system
+{
+
+//! \brief The markers recorded by a thread. Only that thread writes to it.
+class ProfilerThreadBuffer
+{
+public:
+    ProfilerThreadBuffer() :
+        thread_id(0), number_written(0), depth(0) {}
+
+    //! \brief The SDL identifier of the thread.
+    uint32 thread_id;
+
+    //! \brief The markers, written in a ring.
+    std::vector<ProfilerMarker> markers;
+
+    //! \brief The number of markers written since the profiler was enabled.
+    volatile uint32 number_written;
+
+    //! \brief The number of markers currently entered.
+    uint32 depth;
+};
+
+} // namespace private_system
+
+/** ****************************************************************************
+*** \brief Records the time spent in the marked parts of the code, on every thread
+***
+*** Use the ProfilerScope class to mark a part of the code. Nothing is recorded
+*** while the profiler is disabled, which it is by default: a marker only costs
+*** a flag check then.
+***
+*** \note The markers are read without stopping the worker threads, so a marker
+*** being written by one of them may be exported half written. The overlay
+*** only reads the main thread markers of the former frame.
+*** ***************************************************************************/
+class Profiler
+{
+public:
+    Profiler();
+
+    ~Profiler();
+
+    /** \brief Enables or disables the recording of the markers.
+    *** The markers recorded are dropped when enabling the profiler.
+    *** \note Must be called from the main thread.
+    **/
+    void Enable(bool enable);
+
+    bool IsEnabled() const {
+        return _enabled;
+    }
+
+    //! \brief Starts a new frame. Called by the system engine, from the main thread.
+    void StartFrame();
+
+    /** \brief Enters a marked part of the code, on the calling thread.
+    *** \return The thread buffer to give back to EndMarker(), or NULL when
+    *** the thread can't be recorded because there are too many of them.
+    **/
+    private_system::ProfilerThreadBuffer *BeginMarker();
+
+    /** \brief Leaves a marked part of the code, on the calling thread.
+    *** \param buffer The thread buffer returned by BeginMarker().
+    *** \param name The marker name, which must be a string literal.
+    *** \param start_time The time the part was entered at, in microseconds.
+    **/
+    void EndMarker(private_system::ProfilerThreadBuffer *buffer, const char *name, uint32 start_time);
+
+    /** \brief Sums up the markers of the main thread in the last frame drawn, nested part after part.
+    *** \param lines The summary lines, in the order the parts were first entered in.
+    *** \return The duration of the last frame, in microseconds.
+    **/
+    uint32 GetLastFrameSummary(std::vector<ProfilerSummaryLine> &lines) const;
+
+    /** \brief Writes every marker kept, of every thread, in the Chrome trace JSON format.
+    *** \return False if the file couldn't be written.
+    **/
+    bool ExportTrace(const std::string &filename);
+
+private:
+    //! \brief Whether the markers are recorded.
+    volatile bool _enabled;
+
+    //! \brief The current frame number.
+    volatile uint32 _frame;
+
+    //! \brief The time the profiler was enabled at, in microseconds, where the exported trace starts.
+    uint32 _enable_time;
+
+    //! \brief The time the current frame started at, and the duration of the last one, in microseconds.
+    uint32 _frame_start_time;
+    uint32 _last_frame_time;
+
+    //! \brief The buffer of each thread recorded. The main thread one is the first.
+    private_system::ProfilerThreadBuffer _buffers[PROFILER_MAX_THREADS];
+
+    //! \brief The number of threads recorded.
+    volatile uint32 _number_buffers;
+
+    //! \brief Protects the registration of the threads.
+    Semaphore *_lock;
+
+    //! \brief Returns the buffer of the calling thread, registering the thread when it has none yet.
+    private_system::ProfilerThreadBuffer *_GetThreadBuffer();
+}; // class Profiler
+
+} // namespace vt_system
+
+#endif // __PROFILER_HEADER__
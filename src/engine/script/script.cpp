@@ -22,6 +22,10 @@
 
 #include "script_read.h"
 
+#ifndef EDITOR_BUILD
+#include "engine/system.h"
+#endif
+
 using namespace luabind;
 
 using namespace vt_utils;
@@ -35,6 +39,56 @@ namespace vt_script
 ScriptEngine *ScriptManager = NULL;
 bool SCRIPT_DEBUG = false;
 
+#ifndef EDITOR_BUILD
+//! \brief Appends the bytecode written by lua_dump() to a string.
+static int WriteChunk(lua_State * /*state*/, const void *data, size_t size, void *chunk)
+{
+    static_cast<std::string *>(chunk)->append(static_cast<const char *>(data), size);
+    return 0;
+}
+
+/** ****************************************************************************
+*** \brief Compiles a script file to Lua bytecode
+***
+*** The file is parsed in a Lua state of its own, since the global one can only
+*** be used by the main thread.
+*** ***************************************************************************/
+class ScriptCompileJob : public vt_system::Job
+{
+public:
+    explicit ScriptCompileJob(const std::string &filename) :
+        Job(vt_system::JOB_TYPE_SCRIPT_PARSING),
+        _filename(filename),
+        _compiled(false)
+    {}
+
+    void Run() {
+        lua_State *state = luaL_newstate();
+        if(state == NULL)
+            return;
+
+        // The chunk keeps the file name, so that the errors still refer to it.
+        if(luaL_loadfile(state, _filename.c_str()) == 0)
+            _compiled = (lua_dump(state, WriteChunk, &_chunk) == 0);
+        lua_close(state);
+    }
+
+    void Finish() {
+        // A file which can't be compiled is parsed again on opening, which reports the error.
+        ScriptManager->_compile_jobs.erase(_filename);
+        if(_compiled)
+            ScriptManager->_compiled_chunks[_filename].swap(_chunk);
+    }
+
+private:
+    std::string _filename;
+
+    //! \brief The file bytecode, valid when compiled.
+    std::string _chunk;
+    bool _compiled;
+};
+#endif // EDITOR_BUILD
+
 //-----------------------------------------------------------------------------
 // ScriptEngine Class Functions
 //-----------------------------------------------------------------------------
@@ -55,6 +109,9 @@ ScriptEngine::~ScriptEngine()
 {
     IF_PRINT_DEBUG(SCRIPT_DEBUG) << "ScriptEngine destructor invoked." << std::endl;
 
+#ifndef EDITOR_BUILD
+    _profiler.Stop();
+#endif
     _open_files.clear();
     lua_close(_global_state);
     _global_state = NULL;
@@ -98,6 +155,19 @@ void ScriptEngine::HandleCastError(const luabind::cast_failed &err)
 
 
 
+#ifndef EDITOR_BUILD
+void ScriptEngine::StartProfiling(bool sampling)
+{
+    _profiler.Start(_global_state, sampling);
+
+    // The threads opened from now on inherit the sampling hook of the global state.
+    for(std::map<std::string, lua_State *>::iterator it = _open_threads.begin(); it != _open_threads.end(); ++it)
+        _profiler.SampleState(it->second);
+}
+#endif
+
+
+
 void ScriptEngine::_AddOpenFile(ScriptDescriptor *sd)
 {
     // NOTE: This function assumes that the file is not already open
@@ -123,6 +193,55 @@ void ScriptEngine::_RemoveOpenFile(ScriptDescriptor *sd)
 
 
 
+#ifndef EDITOR_BUILD
+void ScriptEngine::PrecompileFile(const std::string &filename)
+{
+    // Without the system engine, such as when converting files, the files are parsed on opening.
+    if(vt_system::SystemManager == NULL)
+        return;
+
+    if(_compile_jobs.find(filename) != _compile_jobs.end()
+            || _compiled_chunks.find(filename) != _compiled_chunks.end())
+        return;
+
+    vt_system::JobHandle handle = vt_system::SystemManager->GetJobSystem().Submit(new ScriptCompileJob(filename));
+    _compile_jobs.insert(std::make_pair(filename, handle));
+}
+
+
+
+bool ScriptEngine::_TakeCompiledChunk(const std::string &filename, std::string &chunk)
+{
+    std::map<std::string, vt_system::JobHandle>::iterator job = _compile_jobs.find(filename);
+    if(job != _compile_jobs.end())
+        vt_system::SystemManager->GetJobSystem().Wait(job->second);
+
+    std::map<std::string, std::string>::iterator it = _compiled_chunks.find(filename);
+    if(it == _compiled_chunks.end())
+        return false;
+
+    // The chunk is only run once, as the file may change afterwards.
+    chunk.swap(it->second);
+    _compiled_chunks.erase(it);
+    return true;
+}
+
+#else // EDITOR_BUILD
+
+void ScriptEngine::PrecompileFile(const std::string &/*filename*/)
+{
+}
+
+
+
+bool ScriptEngine::_TakeCompiledChunk(const std::string &/*filename*/, std::string &/*chunk*/)
+{
+    return false;
+}
+#endif // EDITOR_BUILD
+
+
+
 lua_State *ScriptEngine::_CheckForPreviousLuaState(const std::string &filename)
 {
     if(_open_threads.find(filename) != _open_threads.end())
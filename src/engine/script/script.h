@@ -29,6 +29,12 @@
 #include "utils/utils_pch.h"
 #include "utils/singleton.h"
 
+#ifndef EDITOR_BUILD
+#include "engine/job_system.h"
+#include "engine/script/script_gc.h"
+#endif
+#include "engine/script/script_profiler.h"
+
 //! \brief All calls to the scripting engine are wrapped in this namespace.
 namespace vt_script
 {
@@ -205,6 +211,7 @@ class ScriptEngine : public vt_utils::Singleton<ScriptEngine>
     friend class ReadScriptDescriptor;
     friend class WriteScriptDescriptor;
     friend class ModifyScriptDescriptor;
+    friend class ScriptCompileJob;
 public:
     ~ScriptEngine();
 
@@ -221,6 +228,16 @@ public:
     **/
     bool IsFileOpen(const std::string &filename);
 
+    /** \brief Compiles a script file to Lua bytecode in the background
+    *** \param filename The name of the file to compile.
+    ***
+    *** The file is parsed by a job, which doesn't need the global Lua state. The next
+    *** opening of the file then runs the bytecode, waiting for the job if needed,
+    *** instead of parsing the file again. The file is still run by the main thread.
+    *** \note The editor has no job system, and always parses the files on opening.
+    **/
+    void PrecompileFile(const std::string &filename);
+
     /** \brief Handles run-time errors generated in Lua
     *** \param err A reference to the luabind::error instance that was thrown
     ***
@@ -241,6 +258,47 @@ public:
     **/
     void HandleCastError(const luabind::cast_failed &err);
 
+#ifndef EDITOR_BUILD
+    /** \brief Starts profiling the Lua functions, dropping the former results
+    *** \param sampling Whether the global state and the script threads are sampled,
+    *** on top of timing the calls made from C++.
+    **/
+    void StartProfiling(bool sampling);
+
+    //! \brief Stops profiling the Lua functions. The results are kept to be dumped.
+    void StopProfiling() {
+        _profiler.Stop();
+    }
+
+    ScriptProfiler &GetProfiler() {
+        return _profiler;
+    }
+
+    /** \brief Runs the Lua garbage collection steps of the frame, within their time budget
+    *** \param time_left The time left before the next frame is due, in milliseconds, or a negative value when unknown.
+    *** This function should only be called <b>once</b> per frame, in main.cpp, once the frame is drawn and updated.
+    **/
+    void StepGarbageCollector(int32 time_left) {
+        _garbage_collector.Step(_global_state, time_left);
+    }
+
+    /** \brief Runs a full Lua garbage collection, dropping all the orphaned Lua references at once.
+    *** Only call it when the pause can't be noticed, while the screen is faded out for instance.
+    **/
+    void CollectGarbage() {
+        _garbage_collector.Collect(_global_state);
+    }
+
+    const ScriptGarbageCollector &GetGarbageCollector() const {
+        return _garbage_collector;
+    }
+
+    //! \brief Returns the Lua heap size, in bytes.
+    uint32 GetHeapSize() const {
+        return ScriptGarbageCollector::GetHeapSize(_global_state);
+    }
+#endif
+
     /** \brief Empties a global table or namespace by applying a new pointer to it.
     *** It is used to get rid of old data when reloading a file for instance.
     *** You should then call this *before* opening the script file when needed.
@@ -282,6 +340,25 @@ private:
     //! \brief The lua state shared globally by all files
     lua_State *_global_state;
 
+#ifndef EDITOR_BUILD
+    //! \brief The jobs compiling script files, keyed by filename.
+    std::map<std::string, vt_system::JobHandle> _compile_jobs;
+
+    //! \brief The compiled script files not opened yet, keyed by filename.
+    std::map<std::string, std::string> _compiled_chunks;
+
+    //! \brief Measures the time spent in the Lua functions.
+    ScriptProfiler _profiler;
+
+    //! \brief Runs the Lua garbage collector by steps, within a time budget per frame.
+    ScriptGarbageCollector _garbage_collector;
+#endif
+
+    /** \brief Takes the compiled bytecode of a file, waiting for its compilation if needed
+    *** \return false if the file wasn't compiled, it must then be parsed.
+    **/
+    bool _TakeCompiledChunk(const std::string &filename, std::string &chunk);
+
     //! \brief Adds an open file to the list of open files
     void _AddOpenFile(ScriptDescriptor *sd);
 
@@ -297,15 +374,6 @@ private:
     **/
     lua_State *_CheckForPreviousLuaState(const std::string &filename);
 
-    /** \brief Triggers the Lua garbage collector, dropping all orphaned lua references
-    *** from the stack. This is automatically done by lua to free memory on the long-term.
-    *** But manually triggered when some old lua namespace data need to be dropped.
-    **/
-    void _TriggerLuaGarbageCollector()
-    {
-        lua_gc(_global_state, LUA_GCCOLLECT, 0);
-    }
-
 }; // class ScriptEngine : public vt_utils::Singleton<ScriptEngine>
 
 } // namespace vt_script
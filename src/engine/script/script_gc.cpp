@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_gc.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the Lua garbage collection scheduler.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/script/script_gc.h"
+
+#include "engine/script/script.h"
+
+using namespace vt_system;
+
+namespace vt_script
+{
+
+//! \brief The amount of work done by a Lua collection step per percent of step multiplier, in bytes.
+const float SCRIPT_GC_STEP_WORK = 1024.0f / 100.0f;
+
+ScriptGarbageCollector::ScriptGarbageCollector() :
+    _driving(false),
+    _collecting(false),
+    _pause(200),
+    _step_multiplier(SCRIPT_GC_MIN_STEP_MULTIPLIER),
+    _heap_after_cycle(0),
+    _last_heap(0),
+    _allocated_per_frame(0.0f),
+    _frame_time(0),
+    _last_frame_time(0),
+    _total_time(0),
+    _number_cycles(0),
+    _number_full_collections(0)
+{
+}
+
+void ScriptGarbageCollector::Step(lua_State *global_state, int32 time_left)
+{
+    ScopedTiming timing(SYSTEM_TIMING_SCRIPT_GC);
+    uint32 start_time = GetPreciseTime();
+
+    uint32 heap = GetHeapSize(global_state);
+    if(!_driving) {
+        lua_gc(global_state, LUA_GCSTOP, 0);
+        lua_gc(global_state, LUA_GCSETPAUSE, _pause);
+        lua_gc(global_state, LUA_GCSETSTEPMUL, _step_multiplier);
+        _driving = true;
+        _heap_after_cycle = heap;
+        _last_heap = heap;
+    }
+
+    // Nothing is collected between two frames, so the heap growth is what the scripts allocated.
+    uint32 allocated = (heap > _last_heap) ? heap - _last_heap : 0;
+    _allocated_per_frame += (static_cast<float>(allocated) - _allocated_per_frame) / 8.0f;
+
+    // The next cycle starts once the heap outgrows the pause.
+    if(!_collecting && static_cast<float>(heap) >= static_cast<float>(_heap_after_cycle) * _pause / 100.0f)
+        _collecting = true;
+
+    if(_collecting) {
+        uint32 budget = SCRIPT_GC_FRAME_BUDGET;
+        if(time_left >= 0 && static_cast<uint32>(time_left) * 1000 < budget)
+            budget = static_cast<uint32>(time_left) * 1000;
+
+        // When the collector fell too far behind the scripts, the cycle is finished at once.
+        bool catch_up = static_cast<float>(heap) > static_cast<float>(_heap_after_cycle) * SCRIPT_GC_MAX_HEAP_GROWTH / 100.0f;
+        IF_PRINT_WARNING(SCRIPT_DEBUG && catch_up) << "The Lua collector fell behind, finishing the cycle at once. Heap: "
+                << heap / 1024 << " KiB" << std::endl;
+
+        do {
+            if(lua_gc(global_state, LUA_GCSTEP, 0) == 1) {
+                _collecting = false;
+                break;
+            }
+        } while(catch_up || GetPreciseTime() - start_time < budget);
+
+        // A step sets the automatic collector threshold again.
+        lua_gc(global_state, LUA_GCSTOP, 0);
+
+        if(!_collecting) {
+            _heap_after_cycle = GetHeapSize(global_state);
+            ++_number_cycles;
+            _Tune(global_state);
+        }
+    }
+    _last_heap = GetHeapSize(global_state);
+
+    uint32 time = GetPreciseTime() - start_time;
+    _total_time += time;
+    _last_frame_time = _frame_time + time;
+    _frame_time = 0;
+}
+
+void ScriptGarbageCollector::Collect(lua_State *global_state)
+{
+    ScopedTiming timing(SYSTEM_TIMING_SCRIPT_GC);
+    uint32 start_time = GetPreciseTime();
+
+    lua_gc(global_state, LUA_GCCOLLECT, 0);
+    if(_driving)
+        lua_gc(global_state, LUA_GCSTOP, 0);
+
+    _collecting = false;
+    _heap_after_cycle = GetHeapSize(global_state);
+    _last_heap = _heap_after_cycle;
+    ++_number_full_collections;
+
+    uint32 time = GetPreciseTime() - start_time;
+    _total_time += time;
+    _frame_time += time;
+}
+
+uint32 ScriptGarbageCollector::GetHeapSize(lua_State *global_state)
+{
+    return static_cast<uint32>(lua_gc(global_state, LUA_GCCOUNT, 0)) * 1024
+           + static_cast<uint32>(lua_gc(global_state, LUA_GCCOUNTB, 0));
+}
+
+void ScriptGarbageCollector::_Tune(lua_State *global_state)
+{
+    float heap = static_cast<float>(std::max(_heap_after_cycle, static_cast<uint32>(1024)));
+    float allocated_per_frame = std::max(_allocated_per_frame, 1.0f);
+
+    // Start a cycle about every SCRIPT_GC_CYCLE_FRAMES frames at the current allocation rate.
+    float pause = 100.0f + allocated_per_frame * SCRIPT_GC_CYCLE_FRAMES * 100.0f / heap;
+    _pause = static_cast<uint32>(std::min(std::max(pause, static_cast<float>(SCRIPT_GC_MIN_PAUSE)),
+                                          static_cast<float>(SCRIPT_GC_MAX_PAUSE)));
+
+    // A cycle marks and sweeps about twice the heap, which one step per frame must get
+    // through before the scripts allocate the heap margin given by the pause.
+    float frames = std::max(heap * (_pause - 100) / 100.0f / allocated_per_frame, 1.0f);
+    float step_multiplier = 2.0f * heap / frames / SCRIPT_GC_STEP_WORK;
+    _step_multiplier = static_cast<uint32>(std::min(std::max(step_multiplier, static_cast<float>(SCRIPT_GC_MIN_STEP_MULTIPLIER)),
+                                                    static_cast<float>(SCRIPT_GC_MAX_STEP_MULTIPLIER)));
+
+    lua_gc(global_state, LUA_GCSETPAUSE, _pause);
+    lua_gc(global_state, LUA_GCSETSTEPMUL, _step_multiplier);
+}
+
+} // namespace vt_script
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_gc.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the Lua garbage collection scheduler.
+***
+*** Left alone, the Lua garbage collector runs whenever the scripts allocate
+*** memory, in the middle of any script call, which makes the frames take
+*** longer at random. The scheduler stops the automatic collector instead,
+*** and runs its incremental steps once the frame is drawn and updated,
+*** within a time budget. The full collections are kept for the moments the
+*** screen is faded out, where they can't be noticed.
+***
+*** \note The editor is built without the system engine clock, and keeps the
+*** automatic collector.
+*** ***************************************************************************/
+
+#ifndef __SCRIPT_GC_HEADER__
+#define __SCRIPT_GC_HEADER__
+
+namespace vt_script
+{
+
+//! \brief The time given to the collector per frame, in microseconds.
+const uint32 SCRIPT_GC_FRAME_BUDGET = 1000;
+
+//! \brief The bounds of the collector pause, in percents of the heap left by the last cycle.
+const uint32 SCRIPT_GC_MIN_PAUSE = 120;
+const uint32 SCRIPT_GC_MAX_PAUSE = 300;
+
+//! \brief The bounds of the collector step multiplier, in percents.
+const uint32 SCRIPT_GC_MIN_STEP_MULTIPLIER = 200;
+const uint32 SCRIPT_GC_MAX_STEP_MULTIPLIER = 1000;
+
+//! \brief The number of frames the scheduler aims to run between the starts of two cycles.
+const uint32 SCRIPT_GC_CYCLE_FRAMES = 300;
+
+/** \brief The heap growth since the last cycle, in percents, above which a cycle is
+*** finished at once, whatever the time budget, so that the memory use stays bounded.
+**/
+const uint32 SCRIPT_GC_MAX_HEAP_GROWTH = 400;
+
+/** ****************************************************************************
+*** \brief Runs the Lua garbage collector by budgeted steps
+***
+*** Each frame, the heap growth since the former frame gives the allocation
+*** rate, as nothing is collected meanwhile. Once a cycle ends, the pause
+*** is set so that the next cycle starts after about SCRIPT_GC_CYCLE_FRAMES
+*** frames at that rate, and the step multiplier so that a single step per
+*** frame finishes the cycle before the heap outgrows the pause.
+***
+*** The automatic collector is only stopped on the first step, so that the
+*** tools not stepping the scheduler keep it.
+***
+*** \note Like the Lua states, the scheduler is only used by the main thread.
+*** ***************************************************************************/
+class ScriptGarbageCollector
+{
+public:
+    ScriptGarbageCollector();
+
+    /** \brief Runs collection steps, within the frame budget
+    *** \param global_state The global Lua state, whose collector is driven from now on.
+    *** \param time_left The time left before the next frame is due, in milliseconds,
+    *** or a negative value when the frames aren't paced by the engine.
+    ***
+    *** This function should only be called <b>once</b> per frame, once it is drawn and
+    *** updated. At least one step is run while a cycle is in progress, whatever the time left.
+    **/
+    void Step(lua_State *global_state, int32 time_left);
+
+    /** \brief Runs a full collection at once
+    *** Only call it when the pause can't be noticed, while the screen is faded out for instance.
+    **/
+    void Collect(lua_State *global_state);
+
+    //! \brief Returns the Lua heap size, in bytes.
+    static uint32 GetHeapSize(lua_State *global_state);
+
+    //! \brief Returns the time spent collecting in the last frame, full collections included, in microseconds.
+    uint32 GetLastFrameTime() const {
+        return _last_frame_time;
+    }
+
+    //! \brief Returns the time spent collecting since the start, in microseconds.
+    uint32 GetTotalTime() const {
+        return _total_time;
+    }
+
+    //! \brief Returns the number of cycles finished by steps, and the number of full collections.
+    uint32 GetNumberCycles() const {
+        return _number_cycles;
+    }
+
+    uint32 GetNumberFullCollections() const {
+        return _number_full_collections;
+    }
+
+    //! \brief Returns the current pause and step multiplier, in percents.
+    uint32 GetPause() const {
+        return _pause;
+    }
+
+    uint32 GetStepMultiplier() const {
+        return _step_multiplier;
+    }
+
+private:
+    //! \brief Whether the automatic collector was stopped, and the scheduler drives it.
+    bool _driving;
+
+    //! \brief Whether a collection cycle is in progress.
+    bool _collecting;
+
+    //! \brief The current pause and step multiplier, in percents.
+    uint32 _pause;
+    uint32 _step_multiplier;
+
+    //! \brief The heap size left by the last cycle, and the one at the end of the last frame steps, in bytes.
+    uint32 _heap_after_cycle;
+    uint32 _last_heap;
+
+    //! \brief The average number of bytes allocated per frame.
+    float _allocated_per_frame;
+
+    //! \brief The time spent collecting in the current frame so far, the last frame, and since the start, in microseconds.
+    uint32 _frame_time;
+    uint32 _last_frame_time;
+    uint32 _total_time;
+
+    uint32 _number_cycles;
+    uint32 _number_full_collections;
+
+    //! \brief Sets the pause and step multiplier from the allocation rate, once a cycle is finished.
+    void _Tune(lua_State *global_state);
+}; // class ScriptGarbageCollector
+
+} // namespace vt_script
+
+#endif // __SCRIPT_GC_HEADER__
@@ -0,0 +1,345 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_profiler.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the script profiler.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/script/script_profiler.h"
+
+#include "engine/script/script.h"
+
+#include "utils/utils_strings.h"
+
+#include <iomanip>
+
+using namespace vt_utils;
+using namespace vt_system;
+
+namespace vt_script
+{
+
+//! \brief The maximum number of Lua stack levels walked per sample.
+const int32 SCRIPT_PROFILER_MAX_STACK_LEVELS = 64;
+
+//! \brief Tells whether the measured time of a function is larger than the one of another.
+static bool CompareProfileTimes(const std::pair<uint32, uint32> &first, const std::pair<uint32, uint32> &second)
+{
+    return first.first > second.first;
+}
+
+//! \brief Writes a time given in microseconds, in milliseconds.
+static void WriteProfileTime(std::ofstream &file, uint32 time)
+{
+    file << std::setw(14) << (static_cast<float>(time) / 1000.0f);
+}
+
+ScriptProfiler::ScriptProfiler() :
+    _global_state(NULL),
+    _sampling(false),
+    _original_alloc(NULL),
+    _original_alloc_data(NULL),
+    _start_time(0),
+    _stop_time(0),
+    _last_sample_time(0)
+{
+}
+
+ScriptProfiler::~ScriptProfiler()
+{
+    Stop();
+}
+
+void ScriptProfiler::Start(lua_State *global_state, bool sampling)
+{
+    if(IsRunning())
+        Stop();
+
+    _functions.clear();
+    _function_indices.clear();
+    _calls.clear();
+
+    ScriptFunctionProfile outside;
+    outside.source = "(outside of the calls from C++)";
+    _functions.push_back(outside);
+
+    _global_state = global_state;
+    _sampling = sampling;
+    _original_alloc = lua_getallocf(_global_state, &_original_alloc_data);
+    lua_setallocf(_global_state, _CountingAlloc, this);
+
+    _start_time = GetPreciseTime();
+    _last_sample_time = _start_time;
+    SampleState(_global_state);
+}
+
+void ScriptProfiler::Stop()
+{
+    if(!IsRunning())
+        return;
+
+    lua_setallocf(_global_state, _original_alloc, _original_alloc_data);
+    if(_sampling)
+        lua_sethook(_global_state, NULL, 0, 0);
+
+    _global_state = NULL;
+    _calls.clear();
+    _stop_time = GetPreciseTime();
+}
+
+void ScriptProfiler::SampleState(lua_State *state)
+{
+    if(IsRunning() && _sampling)
+        lua_sethook(state, _SampleHook, LUA_MASKCOUNT, SCRIPT_PROFILER_SAMPLE_INSTRUCTIONS);
+}
+
+void ScriptProfiler::EnterCall(lua_State *state, const char *name)
+{
+    uint32 index = 0;
+    if(lua_type(state, -1) == LUA_TFUNCTION) {
+        lua_Debug debug;
+        lua_getinfo(state, ">S", &debug); // Pops the function
+        index = _GetFunction(debug.source, debug.linedefined, name);
+    } else {
+        // The call will fail, but is counted anyway.
+        lua_pop(state, 1);
+        index = _GetFunction("=?", 0, name);
+    }
+    ++_functions[index].calls;
+
+    Call call;
+    call.function = index;
+    call.start_time = GetPreciseTime();
+    call.children_time = 0;
+
+    // The time spent in C++ since the last sample isn't sampled.
+    if(_calls.empty())
+        _last_sample_time = call.start_time;
+    _calls.push_back(call);
+}
+
+void ScriptProfiler::ExitCall()
+{
+    if(_calls.empty())
+        return;
+
+    Call call = _calls.back();
+    _calls.pop_back();
+
+    uint32 time = GetPreciseTime();
+    uint32 duration = time - call.start_time;
+    ScriptFunctionProfile &function = _functions[call.function];
+    function.total_time += duration;
+    function.self_time += duration - call.children_time;
+
+    if(!_calls.empty())
+        _calls.back().children_time += duration;
+    else
+        _last_sample_time = time;
+}
+
+bool ScriptProfiler::Dump(const std::string &filename) const
+{
+    std::ofstream file(filename.c_str());
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the script profile file for writing: " << filename << std::endl;
+        return false;
+    }
+
+    uint32 duration = (IsRunning() ? GetPreciseTime() : _stop_time) - _start_time;
+    file << "Script profile of " << (static_cast<float>(duration) / 1000000.0f) << " seconds" << std::endl
+         << "The Lua function calls made from C++ are timed exactly";
+    if(_sampling)
+        file << ", and the Lua states are sampled every " << SCRIPT_PROFILER_SAMPLE_INSTRUCTIONS << " instructions";
+    file << "." << std::endl
+         << "Times are in milliseconds. The total times include the functions called, the self times don't." << std::endl
+         << "Allocations are the memory blocks allocated or grown during the calls made from C++." << std::endl;
+    file << std::fixed << std::setprecision(3);
+
+    // The functions are summed up per file first.
+    std::map<std::string, ScriptFunctionProfile> files;
+    for(uint32 i = 0; i < _functions.size(); ++i) {
+        const ScriptFunctionProfile &function = _functions[i];
+        ScriptFunctionProfile &script_file = files[function.source];
+        script_file.source = function.source;
+        script_file.calls += function.calls;
+        script_file.self_time += function.self_time;
+        script_file.sampled_self_time += function.sampled_self_time;
+        script_file.allocations += function.allocations;
+        script_file.allocated_bytes += function.allocated_bytes;
+    }
+
+    std::vector<std::pair<uint32, uint32> > order;
+    std::vector<ScriptFunctionProfile> file_list;
+    for(std::map<std::string, ScriptFunctionProfile>::const_iterator it = files.begin(); it != files.end(); ++it) {
+        order.push_back(std::make_pair(std::max(it->second.self_time, it->second.sampled_self_time),
+                                       static_cast<uint32>(file_list.size())));
+        file_list.push_back(it->second);
+    }
+    std::stable_sort(order.begin(), order.end(), CompareProfileTimes);
+
+    file << std::endl << "Per file:" << std::endl
+         << "       calls          self  sampled self  allocations   allocated KiB  file" << std::endl;
+    for(uint32 i = 0; i < order.size(); ++i) {
+        const ScriptFunctionProfile &script_file = file_list[order[i].second];
+        file << std::setw(12) << script_file.calls;
+        WriteProfileTime(file, script_file.self_time);
+        WriteProfileTime(file, script_file.sampled_self_time);
+        file << std::setw(13) << script_file.allocations
+             << std::setw(16) << (static_cast<float>(script_file.allocated_bytes) / 1024.0f)
+             << "  " << script_file.source << std::endl;
+    }
+
+    order.clear();
+    for(uint32 i = 0; i < _functions.size(); ++i) {
+        const ScriptFunctionProfile &function = _functions[i];
+        order.push_back(std::make_pair(std::max(function.total_time, function.sampled_total_time), i));
+    }
+    std::stable_sort(order.begin(), order.end(), CompareProfileTimes);
+
+    file << std::endl << "Per function:" << std::endl
+         << "       calls         total          self sampled total  sampled self  allocations   allocated KiB  function" << std::endl;
+    for(uint32 i = 0; i < order.size(); ++i) {
+        const ScriptFunctionProfile &function = _functions[order[i].second];
+        file << std::setw(12) << function.calls;
+        WriteProfileTime(file, function.total_time);
+        WriteProfileTime(file, function.self_time);
+        WriteProfileTime(file, function.sampled_total_time);
+        WriteProfileTime(file, function.sampled_self_time);
+        file << std::setw(13) << function.allocations
+             << std::setw(16) << (static_cast<float>(function.allocated_bytes) / 1024.0f)
+             << "  " << (function.name.empty() ? "?" : function.name);
+        if(order[i].second != 0)
+            file << " (" << function.source << ":" << function.line << ")";
+        file << std::endl;
+    }
+
+    if(!file) {
+        PRINT_ERROR << "Couldn't write the script profile file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+uint32 ScriptProfiler::_GetFunction(const char *source, int32 line, const char *name)
+{
+    // The file names are given by Lua with a leading '@'.
+    std::string function_source = (source != NULL) ? source : "?";
+    if(!function_source.empty() && function_source[0] == '@')
+        function_source.erase(0, 1);
+
+    std::string key = function_source + ":" + NumberToString(line);
+    std::map<std::string, uint32>::iterator it = _function_indices.find(key);
+    if(it != _function_indices.end()) {
+        // The name may be unknown when first met.
+        ScriptFunctionProfile &function = _functions[it->second];
+        if(function.name.empty() && name != NULL)
+            function.name = name;
+        return it->second;
+    }
+
+    ScriptFunctionProfile function;
+    function.source = function_source;
+    function.line = line;
+    if(name != NULL)
+        function.name = name;
+    _functions.push_back(function);
+
+    uint32 index = _functions.size() - 1;
+    _function_indices[key] = index;
+    return index;
+}
+
+void ScriptProfiler::_SampleHook(lua_State *state, lua_Debug * /*debug*/)
+{
+    ScriptProfiler &profiler = ScriptManager->GetProfiler();
+    if(!profiler.IsRunning() || !profiler._sampling) {
+        // The profiler was stopped since the state started to be sampled.
+        lua_sethook(state, NULL, 0, 0);
+        return;
+    }
+
+    uint32 time = GetPreciseTime();
+    uint32 elapsed = time - profiler._last_sample_time;
+    profiler._last_sample_time = time;
+
+    // The running function gets the self time, and each function on the stack the total time once,
+    // even when called recursively. The C functions are counted in their Lua caller.
+    std::vector<uint32> &counted = profiler._sampled_functions;
+    counted.clear();
+    lua_Debug frame;
+    for(int32 level = 0; level < SCRIPT_PROFILER_MAX_STACK_LEVELS && lua_getstack(state, level, &frame) == 1; ++level) {
+        if(lua_getinfo(state, "Sn", &frame) == 0 || strcmp(frame.what, "C") == 0 || strcmp(frame.what, "tail") == 0)
+            continue;
+
+        uint32 index = profiler._GetFunction(frame.source, frame.linedefined, frame.name);
+        if(counted.empty())
+            profiler._functions[index].sampled_self_time += elapsed;
+        if(std::find(counted.begin(), counted.end(), index) == counted.end()) {
+            profiler._functions[index].sampled_total_time += elapsed;
+            counted.push_back(index);
+        }
+    }
+}
+
+void *ScriptProfiler::_CountingAlloc(void *data, void *block, size_t old_size, size_t new_size)
+{
+    ScriptProfiler *profiler = static_cast<ScriptProfiler *>(data);
+
+    // The blocks freed and shrunk aren't counted.
+    if(new_size > 0 && (block == NULL || new_size > old_size)) {
+        uint32 index = profiler->_calls.empty() ? 0 : profiler->_calls.back().function;
+        ScriptFunctionProfile &function = profiler->_functions[index];
+        ++function.allocations;
+        function.allocated_bytes += (block == NULL) ? new_size : new_size - old_size;
+    }
+    return profiler->_original_alloc(profiler->_original_alloc_data, block, old_size, new_size);
+}
+
+//-----------------------------------------------------------------------------
+// ScriptCallScope Class Functions
+//-----------------------------------------------------------------------------
+
+ScriptCallScope::ScriptCallScope(const luabind::object &function) :
+    _timing(SYSTEM_TIMING_SCRIPT),
+    _profiled(false)
+{
+    ScriptProfiler &profiler = ScriptManager->GetProfiler();
+    if(!profiler.IsRunning() || !function.is_valid())
+        return;
+
+    lua_State *state = function.interpreter();
+    function.push(state);
+    profiler.EnterCall(state, NULL);
+    _profiled = true;
+}
+
+ScriptCallScope::ScriptCallScope(lua_State *state, const std::string &function_name) :
+    _timing(SYSTEM_TIMING_SCRIPT),
+    _profiled(false)
+{
+    ScriptProfiler &profiler = ScriptManager->GetProfiler();
+    if(!profiler.IsRunning())
+        return;
+
+    lua_getglobal(state, function_name.c_str());
+    profiler.EnterCall(state, function_name.c_str());
+    _profiled = true;
+}
+
+ScriptCallScope::~ScriptCallScope()
+{
+    if(_profiled)
+        ScriptManager->GetProfiler().ExitCall();
+}
+
+} // namespace vt_script
@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    script_profiler.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the script profiler.
+***
+*** The script profiler measures the time spent in the Lua functions, and the
+*** memory they allocate, in two ways:
+***
+*** - Every Lua function call made from C++ through a ScriptCallScope is timed
+*** exactly, along with the allocations made until it returns.
+*** - When sampling, a Lua hook run every few instructions adds the time elapsed
+*** since the former sample to the function running, and to the functions
+*** calling it, which also tells the time spent in the Lua functions called
+*** from Lua.
+***
+*** The results are written per script file and per function on demand.
+***
+*** \note The editor is built without the system engine, and doesn't profile
+*** the scripts: only a ScriptCallScope doing nothing is declared there.
+*** ***************************************************************************/
+
+#ifndef __SCRIPT_PROFILER_HEADER__
+#define __SCRIPT_PROFILER_HEADER__
+
+#ifndef EDITOR_BUILD
+#include "engine/system.h"
+#endif
+
+namespace vt_script
+{
+
+#ifndef EDITOR_BUILD
+
+//! \brief The number of Lua instructions run between two samples.
+const int32 SCRIPT_PROFILER_SAMPLE_INSTRUCTIONS = 1000;
+
+//! \brief The time spent in a Lua function and the memory it allocated, while profiling.
+class ScriptFunctionProfile
+{
+public:
+    ScriptFunctionProfile() :
+        line(0), calls(0), total_time(0), self_time(0),
+        sampled_total_time(0), sampled_self_time(0),
+        allocations(0), allocated_bytes(0) {}
+
+    //! \brief The script file and the line where the function is defined.
+    std::string source;
+    int32 line;
+
+    //! \brief The function name, when known.
+    std::string name;
+
+    //! \brief The number of calls made from C++.
+    uint32 calls;
+
+    /** \brief The exact time spent in the calls made from C++, in microseconds.
+    *** The self time excludes the Lua functions called from C++ meanwhile.
+    **/
+    uint32 total_time;
+    uint32 self_time;
+
+    /** \brief The time sampled in the function, in microseconds.
+    *** The total time includes the time sampled in the functions it called.
+    **/
+    uint32 sampled_total_time;
+    uint32 sampled_self_time;
+
+    //! \brief The number of blocks allocated and grown by Lua during the calls made from C++, and their size.
+    uint32 allocations;
+    uint32 allocated_bytes;
+};
+
+/** ****************************************************************************
+*** \brief Measures the time spent in the Lua functions and the memory they allocate
+***
+*** The profiler is driven by the script engine, which starts and stops it
+*** on the global Lua state and the script threads.
+***
+*** \note The profiler is only used by the main thread, as the Lua states are.
+*** ***************************************************************************/
+class ScriptProfiler
+{
+public:
+    ScriptProfiler();
+
+    ~ScriptProfiler();
+
+    /** \brief Starts profiling, dropping the former results
+    *** \param global_state The global Lua state, whose memory allocations are counted.
+    *** \param sampling Whether the Lua states are sampled as well. The script
+    *** threads created from the global state afterwards are sampled too, but
+    *** the ones existing beforehand must be given to SampleState().
+    **/
+    void Start(lua_State *global_state, bool sampling);
+
+    /** \brief Stops profiling. The results are kept.
+    *** The allocation function of the global state is restored, and the Lua
+    *** states sampled drop the sampling hook on their next sample.
+    **/
+    void Stop();
+
+    bool IsRunning() const {
+        return (_global_state != NULL);
+    }
+
+    bool IsSampling() const {
+        return _sampling;
+    }
+
+    //! \brief Samples a Lua state, a script thread for instance, until the profiler stops.
+    void SampleState(lua_State *state);
+
+    /** \brief Starts timing a Lua function call made from C++
+    *** \param state The Lua state the function is on top of, which is popped.
+    *** \param name The function name, when known.
+    **/
+    void EnterCall(lua_State *state, const char *name);
+
+    //! \brief Ends timing the last Lua function call entered.
+    void ExitCall();
+
+    /** \brief Writes the results per script file and per function, sorted by time.
+    *** \return False if the file couldn't be written.
+    **/
+    bool Dump(const std::string &filename) const;
+
+private:
+    //! \brief The global Lua state while profiling, or NULL when stopped.
+    lua_State *_global_state;
+
+    //! \brief Whether the Lua states are sampled.
+    bool _sampling;
+
+    //! \brief The Lua allocation function replaced while profiling, and its data.
+    lua_Alloc _original_alloc;
+    void *_original_alloc_data;
+
+    //! \brief The functions measured, the first one standing for the code outside of any call made from C++.
+    std::vector<ScriptFunctionProfile> _functions;
+
+    //! \brief The index in the measured functions of each one, keyed by source and line.
+    std::map<std::string, uint32> _function_indices;
+
+    //! \brief A Lua function call made from C++, being timed.
+    struct Call {
+        uint32 function;
+        uint32 start_time;
+
+        //! \brief The time spent in the calls made from C++ meanwhile, in microseconds.
+        uint32 children_time;
+    };
+
+    //! \brief The calls being timed, the innermost last.
+    std::vector<Call> _calls;
+
+    //! \brief The times the profiler started and stopped at, and the time of the last sample, in microseconds.
+    uint32 _start_time;
+    uint32 _stop_time;
+    uint32 _last_sample_time;
+
+    //! \brief The functions already given the time of the current sample.
+    std::vector<uint32> _sampled_functions;
+
+    //! \brief Returns the index of a function in the measured functions, adding it when new.
+    uint32 _GetFunction(const char *source, int32 line, const char *name);
+
+    //! \brief The Lua hook run every few instructions while sampling.
+    static void _SampleHook(lua_State *state, lua_Debug *debug);
+
+    //! \brief The Lua allocation function counting the allocations while profiling.
+    static void *_CountingAlloc(void *data, void *block, size_t old_size, size_t new_size);
+}; // class ScriptProfiler
+
+/** ****************************************************************************
+*** \brief Measures a Lua function call made from C++
+***
+*** Declare one right before calling a Lua function with ScriptCallFunction.
+*** The time spent is added to the script timing of the system engine, and
+*** to the function in the script profiler when it is running.
+*** ***************************************************************************/
+class ScriptCallScope
+{
+public:
+    //! \param function The Lua function about to be called.
+    explicit ScriptCallScope(const luabind::object &function);
+
+    //! \param state The Lua state where the global function is looked up, and its name.
+    ScriptCallScope(lua_State *state, const std::string &function_name);
+
+    ~ScriptCallScope();
+
+private:
+    vt_system::ScopedTiming _timing;
+
+    //! \brief Whether the call is timed by the script profiler.
+    bool _profiled;
+}; // class ScriptCallScope
+
+#else // EDITOR_BUILD
+
+class ScriptCallScope
+{
+public:
+    explicit ScriptCallScope(const luabind::object &/*function*/) {}
+
+    ScriptCallScope(lua_State * /*state*/, const std::string &/*function_name*/) {}
+}; // class ScriptCallScope
+
+#endif // EDITOR_BUILD
+
+} // namespace vt_script
+
+#endif // __SCRIPT_PROFILER_HEADER__
@@ -67,8 +67,15 @@ bool ReadScriptDescriptor::OpenFile(const std::string &filename)
     lua_checkstack(ScriptManager->GetGlobalState(), 1);
     _lstack = lua_newthread(ScriptManager->GetGlobalState());
 
-    // Attempt to load and execute the Lua file
-    if(luaL_loadfile(_lstack, filename.c_str()) != 0 || lua_pcall(_lstack, 0, 0, 0)) {
+    // Attempt to load and execute the Lua file, using its precompiled bytecode when available
+    std::string chunk;
+    int32 load_result = 0;
+    if(ScriptManager->_TakeCompiledChunk(filename, chunk))
+        load_result = luaL_loadbuffer(_lstack, chunk.data(), chunk.size(), ("@" + filename).c_str());
+    else
+        load_result = luaL_loadfile(_lstack, filename.c_str());
+
+    if(load_result != 0 || lua_pcall(_lstack, 0, 0, 0)) {
         PRINT_ERROR << "could not open script file: " << filename << ", error message:" << std::endl
                     << lua_tostring(_lstack, private_script::STACK_TOP) << std::endl;
         _access_mode = SCRIPT_CLOSED;
@@ -485,6 +492,7 @@ bool ReadScriptDescriptor::RunScriptFunction(const std::string &function_name)
     }
 
     try {
+        ScriptCallScope call(GetLuaState(), function_name);
         ScriptCallFunction<void>(GetLuaState(), function_name.c_str());
     } catch(const luabind::error &e) {
         PRINT_ERROR << "Error while loading :" << function_name << std::endl;
@@ -508,6 +516,7 @@ bool ReadScriptDescriptor::RunScriptObject(const luabind::object &object)
         return true;
 
     try {
+        ScriptCallScope call(object);
         ScriptCallFunction<void>(object);
     } catch(const luabind::error &e) {
         PRINT_ERROR << "Error while loading script object." << std::endl;
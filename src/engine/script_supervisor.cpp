@@ -17,6 +17,7 @@
 #include "engine/script_supervisor.h"
 
 #include "engine/mode_manager.h"
+#include "engine/audio/audio.h"
 
 using namespace vt_video;
 using namespace vt_script;
@@ -52,6 +53,13 @@ void ScriptSupervisor::Initialize(vt_mode_manager::GameMode *gm)
             continue;
         }
 
+        // Start decoding the sounds the scene will need
+        if(scene_script.DoesTableExist("preload_sounds")) {
+            std::vector<std::string> preload_sounds;
+            scene_script.ReadStringVector("preload_sounds", preload_sounds);
+            vt_audio::AudioManager->PreloadSounds(preload_sounds);
+        }
+
         _reset_functions.push_back(scene_script.ReadFunctionPointer("Reset"));
         _restart_functions.push_back(scene_script.ReadFunctionPointer("Restart"));
         _update_functions.push_back(scene_script.ReadFunctionPointer("Update"));
@@ -61,9 +69,10 @@ void ScriptSupervisor::Initialize(vt_mode_manager::GameMode *gm)
 
         // Trigger the Initialize functions in the loading order.
         ScriptObject init_function = scene_script.ReadFunctionPointer("Initialize");
-        if(init_function.is_valid() && gm)
+        if(init_function.is_valid() && gm) {
+            ScriptCallScope call(init_function);
             ScriptCallFunction<void>(init_function, gm);
-        else
+        } else
             PRINT_ERROR << "Couldn't initialize the scene component" << std::endl; // Should never happen
 
         scene_script.CloseTable(); // The tablespace
@@ -26,6 +26,10 @@
 
 #include "mode_manager.h"
 
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
 using namespace vt_utils;
 using namespace vt_script;
 using namespace vt_mode_manager;
@@ -107,6 +111,46 @@ std::string VTranslate(const std::string &text, uint32 arg1, uint32 arg2)
 std::string VTranslate(const std::string &text, const std::string &arg1, const std::string &arg2)
 { return _VTranslate(text, arg1.c_str(), arg2.c_str()); }
 
+uint32 GetPreciseTime()
+{
+    // The computations are left to wrap around, which keeps the differences right.
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    if(frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // Split the conversion, so that it can't overflow.
+    return static_cast<uint32>(counter.QuadPart / frequency.QuadPart) * 1000000
+           + static_cast<uint32>((counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart);
+#else
+    struct timeval time;
+    gettimeofday(&time, NULL);
+    return static_cast<uint32>(time.tv_sec) * 1000000 + static_cast<uint32>(time.tv_usec);
+#endif
+}
+
+const char *GetTimingName(SYSTEM_TIMING timing)
+{
+    switch(timing) {
+    case SYSTEM_TIMING_UPDATE:
+        return "Update";
+    case SYSTEM_TIMING_DRAW:
+        return "Draw";
+    case SYSTEM_TIMING_SCRIPT:
+        return "ScriptCallFunction";
+    case SYSTEM_TIMING_COLLISION:
+        return "Collision";
+    case SYSTEM_TIMING_PATH_FINDING:
+        return "Path finding";
+    case SYSTEM_TIMING_SCRIPT_GC:
+        return "ScriptGarbageCollection";
+    default:
+        return "Unknown";
+    }
+}
+
 
 // -----------------------------------------------------------------------------
 // SystemTimer Class
@@ -290,6 +334,8 @@ SystemEngine::SystemEngine()
     IF_PRINT_DEBUG(SYSTEM_DEBUG) << "constructor invoked" << std::endl;
 
     _not_done = true;
+    _timings_enabled = false;
+    SetTargetFrameRate(SYSTEM_DEFAULT_FRAME_RATE);
     SetLanguage("en@quot"); // Default language is English
     _language = "en@quot"; // In case no files were found.
 }
@@ -299,6 +345,9 @@ SystemEngine::SystemEngine()
 SystemEngine::~SystemEngine()
 {
     IF_PRINT_DEBUG(SYSTEM_DEBUG) << "destructor invoked" << std::endl;
+
+    // The worker threads use the system engine.
+    _job_system.Stop();
 }
 
 
@@ -392,8 +441,12 @@ bool SystemEngine::SingletonInitialize()
 
 void SystemEngine::InitializeTimers()
 {
-    _last_update = SDL_GetTicks();
-    _update_time = 1; // Set to non-zero, otherwise bad things may happen...
+    _frame_start = SDL_GetTicks();
+    _draw_end = _frame_start;
+    _accumulated_time = 0;
+    _step_index = 0;
+    _update_time = _GetNextStepTime(); // Set to non-zero, otherwise bad things may happen...
+    _frame_timings = FrameTimings();
     _hours_played = 0;
     _minutes_played = 0;
     _seconds_played = 0;
@@ -439,12 +492,94 @@ void SystemEngine::RemoveAutoTimer(SystemTimer *timer)
 
 
 
-void SystemEngine::UpdateTimers()
+void SystemEngine::StartFrame()
+{
+    _profiler.StartFrame();
+
+    uint32 sleep_start = SDL_GetTicks();
+    uint32 elapsed_time = sleep_start - _frame_start;
+    uint32 frame_duration = _GetFrameDuration();
+    if(elapsed_time < frame_duration)
+        SDL_Delay(frame_duration - elapsed_time);
+
+    uint32 frame_start = SDL_GetTicks();
+    _frame_timings.sleep_time = frame_start - sleep_start;
+    _frame_timings.frame_time = frame_start - _frame_start;
+    _frame_timings.update_steps = 0;
+    _frame_start = frame_start;
+
+    // Only keep the time the steps run in a frame can catch up with.
+    _accumulated_time += _frame_timings.frame_time;
+    uint32 max_time = SYSTEM_MAX_UPDATE_STEPS * ((1000 + SYSTEM_UPDATE_RATE - 1) / SYSTEM_UPDATE_RATE);
+    if(_accumulated_time > max_time)
+        _accumulated_time = max_time;
+}
+
+
+
+void SystemEngine::EndFrameDraw()
+{
+    _draw_end = SDL_GetTicks();
+    _frame_timings.draw_time = _draw_end - _frame_start;
+}
+
+
+
+int32 SystemEngine::GetFrameTimeLeft() const
+{
+    if(_target_frame_time == 0)
+        return -1;
+
+    uint32 frame_time = _GetFrameDuration();
+    uint32 elapsed_time = SDL_GetTicks() - _frame_start;
+    return (elapsed_time < frame_time) ? static_cast<int32>(frame_time - elapsed_time) : 0;
+}
+
+
+
+uint32 SystemEngine::_GetFrameDuration() const
+{
+    if(_target_frame_time == 0)
+        return 0;
+
+    // The steps last 1000 / SYSTEM_UPDATE_RATE milliseconds on average, which the frames can't
+    // match to the millisecond: waiting for the next step keeps one step per frame at that rate.
+    uint32 step_time = _GetNextStepTime();
+    uint32 step_wait_time = (_accumulated_time < step_time) ? step_time - _accumulated_time : 0;
+    return std::max(_target_frame_time, step_wait_time);
+}
+
+
+
+bool SystemEngine::UpdateTimers()
+{
+    uint32 step_time = _GetNextStepTime();
+    if(_accumulated_time < step_time || _frame_timings.update_steps >= SYSTEM_MAX_UPDATE_STEPS) {
+        _frame_timings.update_time = SDL_GetTicks() - _draw_end;
+        return false;
+    }
+
+    _accumulated_time -= step_time;
+    ++_frame_timings.update_steps;
+    _RunStep();
+
+    return true;
+}
+
+
+
+void SystemEngine::UpdateTimersByStep()
+{
+    _RunStep();
+}
+
+
+
+void SystemEngine::_RunStep()
 {
     // Update the update game timer
-    uint32 tmp = _last_update;
-    _last_update = SDL_GetTicks();
-    _update_time = _last_update - tmp;
+    _update_time = _GetNextStepTime();
+    _step_index = (_step_index + 1) % SYSTEM_UPDATE_RATE;
 
     // Update the game play timer
     _milliseconds_played += _update_time;
@@ -483,6 +618,12 @@ void SystemEngine::ExamineSystemTimers()
     }
 }
 
+void SystemEngine::ResetTimings()
+{
+    for(uint32 i = 0; i < SYSTEM_TIMING_TOTAL; ++i)
+        _timings[i] = SystemTiming();
+}
+
 void SystemEngine::WaitForThread(Thread *thread)
 {
 #if (THREAD_TYPE == SDL_THREADS)
@@ -525,43 +666,4 @@ void SystemEngine::UnlockThread(Semaphore *s)
 #endif
 }
 
-template <class T> struct generic_class_func_info {
-    static int SpawnThread_Intermediate(void *vptr) {
-        ((((generic_class_func_info <T> *) vptr)->myclass)->*(((generic_class_func_info <T> *) vptr)->func))();
-        return 0;
-    }
-
-    T *myclass;
-    void (T::*func)();
-};
-
-
-
-template <class T> Thread *SystemEngine::SpawnThread(void (T::*func)(), T *myclass)
-{
-#if (THREAD_TYPE == SDL_THREADS)
-    Thread *thread;
-    static generic_class_func_info <T> gen;
-    gen.func = func;
-    gen.myclass = myclass;
-
-    // Winter Knight: There is a potential, but unlikely race condition here.
-    // gen may be overwritten prematurely if this function, SpawnThread, gets
-    // called a second time before SpawnThread_Intermediate calls myclass->*func
-    // This will result in a segfault.
-    thread = SDL_CreateThread(gen.SpawnThread_Intermediate, &gen);
-    if(thread == NULL) {
-        PRINT_ERROR << "Unable to create thread: " << SDL_GetError() << std::endl;
-        return NULL;
-    }
-    return thread;
-#elif (THREAD_TYPE == NO_THREADS)
-    (myclass->*func)();
-    return 1;
-#else
-    PRINT_ERROR << "Invalid THREAD_TYPE." << std::endl;
-    return 0;
-#endif
-}
-
 } // namespace vt_system
@@ -28,6 +28,9 @@
 #include "utils/ustring.h"
 #include "utils/singleton.h"
 
+#include "engine/job_system.h"
+#include "engine/profiler.h"
+
 namespace vt_mode_manager {
 class GameMode;
 }
@@ -63,6 +66,36 @@ const int32 SYSTEM_TIMER_NO_LOOPS = 0;
 **/
 const int32 SYSTEM_TIMER_INFINITE_LOOP = -1;
 
+/** \brief The number of fixed simulation steps run per second of game time
+*** The steps last 16 or 17 milliseconds, so that they add up to exactly one second.
+**/
+const uint32 SYSTEM_UPDATE_RATE = 60;
+
+/** \brief The maximum number of simulation steps run to catch up after a long frame
+*** The time beyond is dropped, so the game slows down instead of never catching up.
+**/
+const uint32 SYSTEM_MAX_UPDATE_STEPS = 5;
+
+//! \brief The default number of frames drawn per second, when the screen refresh doesn't pace them.
+const uint32 SYSTEM_DEFAULT_FRAME_RATE = 60;
+
+/** \brief The parts of the game whose time spent can be measured
+*** The timings are only measured when enabled, and the times of the parts
+*** called from each other add up: the script calls are part of the update.
+**/
+enum SYSTEM_TIMING {
+    SYSTEM_TIMING_UPDATE       = 0,
+    SYSTEM_TIMING_DRAW         = 1,
+    SYSTEM_TIMING_SCRIPT       = 2,
+    SYSTEM_TIMING_COLLISION    = 3,
+    SYSTEM_TIMING_PATH_FINDING = 4,
+    SYSTEM_TIMING_SCRIPT_GC    = 5,
+    SYSTEM_TIMING_TOTAL        = 6
+};
+
+//! \brief Returns the name of a part of the game whose time is measured, as shown by the profiler.
+const char *GetTimingName(SYSTEM_TIMING timing);
+
 //! \brief All of the possible states which a SystemTimer classs object may be in
 enum SYSTEM_TIMER_STATE {
     SYSTEM_TIMER_INVALID  = -1,
@@ -116,6 +149,12 @@ std::string VTranslate(const std::string &text, float arg1);
 std::string VTranslate(const std::string &text, uint32 arg1, uint32 arg2);
 std::string VTranslate(const std::string &text, const std::string &arg1, const std::string &arg2);
 
+/** \brief Returns a precise time, in microseconds.
+*** \note The value wraps around every ~71.6 minutes, so it is only meant
+*** to measure the duration of short operations.
+**/
+uint32 GetPreciseTime();
+
 
 /** ****************************************************************************
 *** \brief A timer assistant useful for monitoring progress and processing event sequences
@@ -334,6 +373,43 @@ protected:
 }; // class SystemTimer
 
 
+//! \brief The time spent in each part of the last frame, in milliseconds.
+class FrameTimings
+{
+public:
+    FrameTimings() :
+        frame_time(0), sleep_time(0), draw_time(0), update_time(0), update_steps(0) {}
+
+    //! \brief The time between the start of the last two frames.
+    uint32 frame_time;
+
+    //! \brief The time slept waiting for the frame to start.
+    uint32 sleep_time;
+
+    //! \brief The time spent drawing the frame, including the buffer swap.
+    uint32 draw_time;
+
+    //! \brief The time spent running the simulation steps of the frame.
+    uint32 update_time;
+
+    //! \brief The number of simulation steps run in the frame.
+    uint32 update_steps;
+};
+
+//! \brief The time spent in a part of the game, since the last timings reset.
+class SystemTiming
+{
+public:
+    SystemTiming() :
+        time(0), calls(0) {}
+
+    //! \brief The total time spent, in microseconds.
+    uint32 time;
+
+    //! \brief The number of times the part was measured.
+    uint32 calls;
+};
+
 /** ****************************************************************************
 *** \brief Engine class that manages system information and functions
 ***
@@ -358,12 +434,12 @@ public:
     void InitializeTimers();
 
     /** \brief Initializes the game update timer
-    *** This function should typically only be called when the active game mode is changed. This ensures that
-    *** the active game mode's execution begins with only 1 millisecond of time expired instead of several.
+    *** This function should typically only be called when the active game mode is changed. This drops the
+    *** time not simulated yet, so that the active game mode doesn't catch up with the time spent loading it.
     **/
     void InitializeUpdateTimer() {
-        _last_update = SDL_GetTicks();
-        _update_time = 1;
+        _frame_start = SDL_GetTicks();
+        _accumulated_time = 0;
     }
 
     /** \brief Adds a timer to the set system timers for auto updating
@@ -382,12 +458,61 @@ public:
     **/
     void RemoveAutoTimer(SystemTimer *timer);
 
-    /** \brief Updates the game timer variables.
-    *** This function should only be called <b>once</b> for each cycle through the main game loop. Since
-    *** it is called inside the loop in main.cpp, you should have no reason to call this function anywhere
-    *** else.
+    /** \brief Sleeps until the next frame is due, and starts it.
+    *** The time elapsed since the previous frame start is added to the time to simulate.
+    *** This function should only be called <b>once</b> for each cycle through the main game loop,
+    *** before drawing the frame.
+    ***
+    *** No sleep is done when the frame already lasted long enough, which is the case
+    *** when the buffer swap waited for the screen refresh. Otherwise, the frame lasts
+    *** until the next simulation step is due, so that no frame is drawn without an
+    *** update step in between, which would show the same image twice.
+    **/
+    void StartFrame();
+
+    //! \brief Tells the frame is drawn, so that the draw time is known. Called after the buffer swap.
+    void EndFrameDraw();
+
+    /** \brief Advances the game timers by one fixed simulation step, if one is due.
+    *** \return false when the time left to simulate is shorter than a step.
+    ***
+    *** This function is called in a loop in main.cpp, which updates the game once
+    *** for every step it runs. You should have no reason to call this function
+    *** anywhere else.
+    **/
+    bool UpdateTimers();
+
+    /** \brief Advances the game timers by one fixed simulation step, whatever the time elapsed.
+    *** This lets the benchmark runner simulate an exact number of steps. The main loop
+    *** uses UpdateTimers() instead.
+    **/
+    void UpdateTimersByStep();
+
+    //! \brief Returns the time spent in each part of the last frame.
+    const FrameTimings &GetFrameTimings() const {
+        return _frame_timings;
+    }
+
+    /** \brief Sets the number of frames drawn per second, when the screen refresh doesn't pace them.
+    *** \param frame_rate The frame rate to keep, or 0 to draw the frames as fast as possible.
+    **/
+    void SetTargetFrameRate(uint32 frame_rate) {
+        _target_frame_time = (frame_rate > 0) ? 1000 / frame_rate : 0;
+    }
+
+    /** \brief Returns the time left before the next frame is due, in milliseconds.
+    *** \return The time left, or -1 when the frames are drawn as fast as possible,
+    *** or paced by the screen refresh.
+    **/
+    int32 GetFrameTimeLeft() const;
+
+    /** \brief Tells how far the game is between the last simulation step and the next one.
+    *** \return A value from 0.0f to 1.0f, which can be used to interpolate the drawn positions.
     **/
-    void UpdateTimers();
+    float GetUpdateInterpolation() const {
+        // The time left to simulate may exceed a step once capped.
+        return std::min(static_cast<float>(_accumulated_time) / static_cast<float>(_GetNextStepTime()), 1.0f);
+    }
 
     /** \brief Checks all system timers for whether they should be paused or resumed
     *** This function is typically called whenever the ModeEngine class has changed the active game mode.
@@ -397,12 +522,7 @@ public:
     void ExamineSystemTimers();
 
     /** \brief Retrieves the amount of time that the game should be updated by for time-based movement.
-    *** \return The number of milliseconds that have transpired since the last update.
-    ***
-    *** \note There's a chance we could get errors in other parts of the program code if the
-    *** value returned by this function is zero. We can prevent this if we always make sure the
-    *** function returns at least one, but I'm not sure there exists a computer fast enough
-    *** that we have to worry about it.
+    *** \return The number of milliseconds of the current simulation step, never zero.
     **/
     uint32 GetUpdateTime() const {
         return _update_time;
@@ -478,16 +598,66 @@ public:
     Semaphore *CreateSemaphore(int max);
     void DestroySemaphore(Semaphore *);
 
+    //! \brief Returns the jobs run by the worker threads.
+    JobSystem &GetJobSystem() {
+        return _job_system;
+    }
+
+    //! \brief Returns the frame profiler, recording the time spent in the marked parts of the code.
+    Profiler &GetProfiler() {
+        return _profiler;
+    }
+
+    /** \brief Enables or disables the measure of the time spent in the parts of the game.
+    *** The timings are disabled by default, and only cost a flag check then.
+    *** \see ScopedTiming.
+    **/
+    void EnableTimings(bool enable) {
+        _timings_enabled = enable;
+    }
+
+    bool AreTimingsEnabled() const {
+        return _timings_enabled;
+    }
+
+    //! \brief Adds a time measured, in microseconds, to the given part of the game.
+    void AddTiming(SYSTEM_TIMING timing, uint32 time) {
+        _timings[timing].time += time;
+        ++_timings[timing].calls;
+    }
+
+    //! \brief Returns the time spent in the given part of the game since the last reset.
+    const SystemTiming &GetTiming(SYSTEM_TIMING timing) const {
+        return _timings[timing];
+    }
+
+    //! \brief Resets the time spent in every part of the game.
+    void ResetTimings();
 
 private:
     SystemEngine();
 
-    //! \brief The last time that the UpdateTimers function was called, in milliseconds.
-    uint32 _last_update;
+    //! \brief The time the current frame started at, in milliseconds.
+    uint32 _frame_start;
+
+    //! \brief The time the last frame draw ended at, in milliseconds.
+    uint32 _draw_end;
+
+    //! \brief The time elapsed and not simulated yet, in milliseconds.
+    uint32 _accumulated_time;
 
-    //! \brief The number of milliseconds that have transpired on the last timer update.
+    //! \brief The number of milliseconds of the current simulation step.
     uint32 _update_time;
 
+    //! \brief The index of the next simulation step within the current second of game time.
+    uint32 _step_index;
+
+    //! \brief The minimum duration of a frame, in milliseconds, or 0 when not limited.
+    uint32 _target_frame_time;
+
+    //! \brief The time spent in each part of the last frame.
+    FrameTimings _frame_timings;
+
     /** \name Play time members
     *** \brief Timers that retain the total amount of time that the user has been playing
     *** When the player starts a new game or loads an existing game, these timers are reset.
@@ -502,6 +672,31 @@ private:
     //! \brief When this member is set to false, the program will exit.
     bool _not_done;
 
+    //! \brief The frame profiler, declared first as the worker threads use it until they are stopped.
+    Profiler _profiler;
+
+    //! \brief The jobs run by the worker threads.
+    JobSystem _job_system;
+
+    //! \brief Whether the time spent in the parts of the game is measured.
+    bool _timings_enabled;
+
+    //! \brief The time spent in each part of the game.
+    SystemTiming _timings[SYSTEM_TIMING_TOTAL];
+
+    //! \brief Runs the next simulation step: advances the play time and the automatic timers.
+    void _RunStep();
+
+    //! \brief Returns the duration of the next simulation step, in milliseconds.
+    uint32 _GetNextStepTime() const {
+        return ((_step_index + 1) * 1000) / SYSTEM_UPDATE_RATE - (_step_index * 1000) / SYSTEM_UPDATE_RATE;
+    }
+
+    /** \brief Returns how long the current frame lasts, from its start, in milliseconds.
+    *** A frame lasts at least the target frame time, and until the next simulation step is due.
+    **/
+    uint32 _GetFrameDuration() const;
+
     //! \brief The identification string that determines what language the game is running in
     std::string _language;
 
@@ -511,6 +706,124 @@ private:
     std::set<SystemTimer *> _auto_system_timers;
 }; // class SystemEngine : public vt_utils::Singleton<SystemEngine>
 
+/** ****************************************************************************
+*** \brief Records the time spent in its scope as a frame profiler marker
+***
+*** Declare one at the start of the code to mark, with a string literal name.
+*** The markers declared while in the scope are nested in it. Nothing is
+*** recorded when the profiler is disabled.
+*** ***************************************************************************/
+class ProfilerScope
+{
+public:
+    explicit ProfilerScope(const char *name) :
+        _name(name),
+        _buffer(NULL),
+        _start_time(0)
+    {
+        if(SystemManager != NULL && SystemManager->GetProfiler().IsEnabled()) {
+            _buffer = SystemManager->GetProfiler().BeginMarker();
+            _start_time = GetPreciseTime();
+        }
+    }
+
+    ~ProfilerScope() {
+        if(_buffer != NULL)
+            SystemManager->GetProfiler().EndMarker(_buffer, _name, _start_time);
+    }
+
+private:
+    const char *_name;
+
+    //! \brief The buffer of the thread, or NULL when the scope isn't recorded.
+    private_system::ProfilerThreadBuffer *_buffer;
+
+    //! \brief The time the scope was entered at, in microseconds.
+    uint32 _start_time;
+}; // class ProfilerScope
+
+/** ****************************************************************************
+*** \brief Adds the time spent in its scope to a part of the game
+***
+*** Declare one at the start of the code to measure. Nothing is measured
+*** when the system engine timings are disabled. The scope is recorded as a
+*** profiler marker as well, named after the part of the game.
+*** ***************************************************************************/
+class ScopedTiming
+{
+public:
+    explicit ScopedTiming(SYSTEM_TIMING timing) :
+        _marker(GetTimingName(timing)),
+        _timing(timing),
+        _start_time(0),
+        _enabled(SystemManager != NULL && SystemManager->AreTimingsEnabled())
+    {
+        if(_enabled)
+            _start_time = GetPreciseTime();
+    }
+
+    ~ScopedTiming() {
+        if(_enabled)
+            SystemManager->AddTiming(_timing, GetPreciseTime() - _start_time);
+    }
+
+private:
+    //! \brief The profiler marker, entered first and left last.
+    ProfilerScope _marker;
+
+    SYSTEM_TIMING _timing;
+
+    //! \brief The time the scope was entered at, in microseconds.
+    uint32 _start_time;
+
+    //! \brief Whether the timings were enabled when the scope was entered.
+    bool _enabled;
+}; // class ScopedTiming
+
+namespace private_system
+{
+
+//! \brief The object and member function a spawned thread runs.
+template <class T> struct generic_class_func_info {
+    static int SpawnThread_Intermediate(void *vptr) {
+        generic_class_func_info<T> *info = static_cast<generic_class_func_info<T> *>(vptr);
+        T *myclass = info->myclass;
+        void (T::*func)() = info->func;
+        // Each spawned thread owns its own info, so that spawning several threads at once is safe.
+        delete info;
+        (myclass->*func)();
+        return 0;
+    }
+
+    T *myclass;
+    void (T::*func)();
+};
+
+} // namespace private_system
+
+template <class T> Thread *SystemEngine::SpawnThread(void (T::*func)(), T *myclass)
+{
+#if (THREAD_TYPE == SDL_THREADS)
+    private_system::generic_class_func_info<T> *info = new private_system::generic_class_func_info<T>();
+    info->func = func;
+    info->myclass = myclass;
+
+    Thread *thread = SDL_CreateThread(private_system::generic_class_func_info<T>::SpawnThread_Intermediate, info);
+    if(thread == NULL) {
+        PRINT_ERROR << "Unable to create thread: " << SDL_GetError() << std::endl;
+        delete info;
+        return NULL;
+    }
+    return thread;
+#elif (THREAD_TYPE == NO_THREADS)
+    (myclass->*func)();
+    return NULL;
+#else
+    PRINT_ERROR << "Invalid THREAD_TYPE." << std::endl;
+    return NULL;
+#endif
+}
+
 } // namepsace vt_system
 
 #endif // __SYSTEM_HEADER__
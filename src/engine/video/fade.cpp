@@ -21,6 +21,7 @@
 #include "video.h"
 
 #include "engine/mode_manager.h"
+#include "engine/script/script.h"
 
 using namespace vt_utils;
 using namespace vt_mode_manager;
@@ -95,6 +96,11 @@ void ScreenFader::Update(uint32 time)
         _current_color = _final_color;
         _fade_overlay_img.SetColor(_current_color);
         _is_fading = false;
+
+        // The screen is hidden, so a full script garbage collection can't be noticed.
+        // The game modes transitions collect on their own.
+        if(!_transitional_fading && IsFloatEqual(_final_color[3], 1.0f))
+            vt_script::ScriptManager->CollectGarbage();
         return;
     }
 
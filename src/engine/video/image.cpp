@@ -301,6 +301,37 @@ bool ImageDescriptor::LoadMultiImageFromElementGrid(std::vector<StillImage>& ima
 } // bool ImageDescriptor::LoadMultiImageFromElementGrid(...)
 
 
+bool ImageDescriptor::LoadMultiImageFromElementGrid(std::vector<StillImage>& images, const std::string &filename,
+        const ImageMemory &multi_image, const uint32 grid_rows, const uint32 grid_cols)
+{
+    if(multi_image.pixels == NULL || multi_image.rgb_format) {
+        PRINT_WARNING << "Invalid decoded multi image data for: " << filename << std::endl;
+        return false;
+    }
+
+    // Make sure that the number of grid rows and columns divide evenly into the image size
+    if((multi_image.height % grid_rows) != 0 || (multi_image.width % grid_cols) != 0) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "multi image size not evenly divisible by grid rows or columns for multi image file: " << filename << std::endl;
+        return false;
+    }
+
+    if(images.size() != grid_rows * grid_cols) {
+        images.resize(grid_rows * grid_cols);
+    }
+
+    float elem_width = static_cast<float>(multi_image.width) / static_cast<float>(grid_cols);
+    float elem_height = static_cast<float>(multi_image.height) / static_cast<float>(grid_rows);
+    for(std::vector<StillImage>::iterator i = images.begin(); i < images.end(); ++i) {
+        if(IsFloatEqual(i->_height, 0.0f))
+            i->_height = elem_height;
+        if(IsFloatEqual(i->_width, 0.0f))
+            i->_width = elem_width;
+    }
+
+    return _LoadMultiImage(images, filename, grid_rows, grid_cols, &multi_image);
+} // bool ImageDescriptor::LoadMultiImageFromElementGrid(..., const ImageMemory &multi_image, ...)
+
+
 
 bool ImageDescriptor::SaveMultiImage(const std::vector<StillImage *>& images, const std::string &filename,
                                      const uint32 grid_rows, const uint32 grid_columns)
@@ -467,6 +498,10 @@ void ImageDescriptor::_RemoveTextureReference()
         if(_texture->width > 512 || _texture->height > 512) {
             TextureManager->_RemoveSheet(_texture->texture_sheet);
         }
+        // The space of baked atlases isn't reused, so they are deleted once empty
+        else if(_texture->texture_sheet->type == VIDEO_TEXSHEET_ATLAS && _texture->texture_sheet->GetNumberTextures() == 0) {
+            TextureManager->_RemoveSheet(_texture->texture_sheet);
+        }
 // 		else {
 //
 // 			// TODO: Otherise simply mark the image as free in the texture sheet
@@ -526,7 +561,7 @@ void ImageDescriptor::_DrawOrientation() const
 
 void ImageDescriptor::_DrawTexture(const Color *draw_color) const
 {
-    // Array of the four vertexes defined on the 2D plane for glDrawArrays()
+    // Array of the four vertexes defined on the 2D plane
     // This is no longer const, because when tiling the background for the menu's
     // sometimes you need to draw part of a texture
     float vert_coords[] = {
@@ -541,23 +576,21 @@ void ImageDescriptor::_DrawTexture(const Color *draw_color) const
         draw_color = _color;
 
     // Set blending parameters
+    int32 blend = SPRITE_BLEND_NONE;
     if(VideoManager->_current_context.blend) {
-        VideoManager->EnableBlending();
         if(VideoManager->_current_context.blend == 1)
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+            blend = SPRITE_BLEND_NORMAL;
         else
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+            blend = SPRITE_BLEND_ADDITIVE;
     } else if(_blend) {
-        VideoManager->EnableBlending();
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
-    } else {
-        VideoManager->DisableBlending();
+        blend = SPRITE_BLEND_NORMAL;
     }
 
-    VideoManager->EnableVertexArray();
-    glVertexPointer(2, GL_FLOAT, 0, vert_coords);
+    // Use the first color on every vertex for unichrome images
+    const Color unichrome_colors[4] = { draw_color[0], draw_color[0], draw_color[0], draw_color[0] };
+    const Color *vertex_colors = _unichrome_vertices ? unichrome_colors : draw_color;
 
-    // If we have a valid image texture poiner, setup texture coordinates and the texture coordinate array for glDrawArrays()
+    // If we have a valid image texture poiner, setup texture coordinates
     if(_texture) {
         // Set the texture coordinates
         float s0, s1, t0, t1;
@@ -581,7 +614,7 @@ void ImageDescriptor::_DrawTexture(const Color *draw_color) const
             t1 = temp;
         }
 
-        // Place the texture coordinates in a 4x2 array mirroring the structure of the vertex array for use in glDrawArrays().
+        // Place the texture coordinates in a 4x2 array mirroring the structure of the vertex array.
         float tex_coords[] = {
             s0, t1,
             s1, t1,
@@ -589,45 +622,19 @@ void ImageDescriptor::_DrawTexture(const Color *draw_color) const
             s0, t0,
         };
 
-        // Enable texturing and bind texture
-        VideoManager->EnableTexture2D();
-        TextureManager->_BindTexture(_texture->texture_sheet->tex_id);
-        _texture->texture_sheet->Smooth(_smooth);
-
-        // Enable and setup the texture coordinate array
-        VideoManager->EnableTextureCoordArray();
-        glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
-
-        if(_unichrome_vertices) {
-            glColor4fv((GLfloat *)draw_color[0].GetColors());
-            VideoManager->DisableColorArray();
-        } else {
-            VideoManager->EnableColorArray();
-            glColorPointer(4, GL_FLOAT, 0, (GLfloat *)draw_color);
-        }
+        VideoManager->_sprite_batch.AddQuad(_texture->texture_sheet, _smooth, blend, VideoManager->_transform,
+                                            vert_coords, tex_coords, vertex_colors);
     } // if (_texture)
     else {
         // Otherwise there is no image texture, so we're drawing pure color on the vertices
-
-        // Use a single call to glColor for unichrome images, or a setup a gl color array for multiple colors
-        if(_unichrome_vertices) {
-            glColor4fv((GLfloat *)draw_color[0].GetColors());
-            VideoManager->DisableColorArray();
-        } else {
-            VideoManager->EnableColorArray();
-            glColorPointer(4, GL_FLOAT, 0, (GLfloat *)draw_color);
-        }
-
-        // Disable texturing as we're using pure colour
-        VideoManager->DisableTexture2D();
+        VideoManager->_sprite_batch.AddQuad(NULL, false, blend, VideoManager->_transform,
+                                            vert_coords, NULL, vertex_colors);
     }
-
-    // Use a vertex array to draw all of the vertices
-    glDrawArrays(GL_QUADS, 0, 4);
 } // void ImageDescriptor::_DrawTexture(const Color* color_array) const
 
 bool ImageDescriptor::_LoadMultiImage(std::vector<StillImage>& images, const std::string &filename,
-                                      const uint32 grid_rows, const uint32 grid_cols)
+                                      const uint32 grid_rows, const uint32 grid_cols,
+                                      const ImageMemory *decoded_image)
 {
     uint32 current_image;
     uint32 x, y;
@@ -656,16 +663,18 @@ bool ImageDescriptor::_LoadMultiImage(std::vector<StillImage>& images, const std
 
     // If the image elements are not all loaded, then load the multi image file
     // from disk and create enough memory to copy over individual sub-image elements from it
+    // The image is only read from the disk when it wasn't already decoded.
     ImageMemory multi_image;
     ImageMemory sub_image;
+    const ImageMemory *source_image = decoded_image ? decoded_image : &multi_image;
     if(need_load) {
-        if(multi_image.LoadImage(filename) == false) {
+        if(decoded_image == NULL && multi_image.LoadImage(filename) == false) {
             IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to load multi image file: " << filename << std::endl;
             return false;
         }
 
-        sub_image.width = multi_image.width / grid_cols;
-        sub_image.height = multi_image.height / grid_rows;
+        sub_image.width = source_image->width / grid_cols;
+        sub_image.height = source_image->height / grid_rows;
         sub_image.pixels = malloc(sub_image.width * sub_image.height * 4);
         if(sub_image.pixels == NULL) {
             PRINT_ERROR << "failed to malloc memory for multi image file: " << filename << std::endl;
@@ -708,8 +717,8 @@ bool ImageDescriptor::_LoadMultiImage(std::vector<StillImage>& images, const std
                 images.at(current_image)._filename = filename;
 
                 for(uint32 i = 0; i < sub_image.height; ++i) {
-                    memcpy((uint8 *)sub_image.pixels + 4 * sub_image.width * i, (uint8 *)multi_image.pixels + (((x * multi_image.height / grid_rows) + i) *
-                            multi_image.width + y * multi_image.width / grid_cols) * 4, 4 * sub_image.width);
+                    memcpy((uint8 *)sub_image.pixels + 4 * sub_image.width * i, (uint8 *)source_image->pixels + (((x * source_image->height / grid_rows) + i) *
+                            source_image->width + y * source_image->width / grid_cols) * 4, 4 * sub_image.width);
                 }
 
                 img = new ImageTexture(filename, tags[current_image], sub_image.width, sub_image.height);
@@ -1539,7 +1548,7 @@ void CompositeImage::Draw(const Color &draw_color) const
         if(coord_sys.GetVerticalDirection() < 0.0f)
             y_scale = -y_scale;
 
-        glScalef(x_scale, y_scale, 1.0f);
+        VideoManager->Scale(x_scale, y_scale);
 
         if(draw_color == Color::white)
             _elements[i].image._DrawTexture(_color);
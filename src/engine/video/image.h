@@ -236,6 +236,21 @@ public:
     static bool LoadMultiImageFromElementGrid(std::vector<StillImage>& images, const std::string &filename,
             const uint32 grid_rows, const uint32 grid_cols);
 
+    /** \brief Loads a multi image already decoded in memory into a vector of StillImage objects
+    *** \param images Reference to the vector of StillImages to be loaded with elements from the multi image
+    *** \param filename The name of the multi image file the image data was decoded from
+    *** \param multi_image The decoded RGBA multi image data, which is left untouched
+    *** \param grid_rows The number of rows of image elements contained in the multi image
+    *** \param grid_cols The number of columns of image elements contained in the multi image
+    *** \return True upon successful loading, false if there was an error
+    ***
+    *** The image elements are registered under the filename, as if they were loaded
+    *** from it. This permits to decode the image in another thread, and only
+    *** upload it to texture memory from the rendering thread.
+    **/
+    static bool LoadMultiImageFromElementGrid(std::vector<StillImage>& images, const std::string &filename,
+            const private_video::ImageMemory &multi_image, const uint32 grid_rows, const uint32 grid_cols);
+
     /** \brief Saves a vector of images into a single image file (a multi image)
     *** \param images A reference to the vector of StillImage pointers to save into a multi image
     *** \param filename The name of the multi image file to write (.png of .jpg extension required)
@@ -319,10 +334,12 @@ private:
     *** \param filename The name of the multi image file to read
     *** \param grid_rows The number of rows of image elements in the multi image
     *** \param grid_cols The number of columns of image elements in the multi image
+    *** \param decoded_image The already decoded multi image data, or NULL to read it from the file.
     *** \return True if the image file was loaded and parsed successfully, false if there was an error.
     **/
     static bool _LoadMultiImage(std::vector<StillImage>& images, const std::string &filename,
-                                const uint32 grid_rows, const uint32 grid_cols);
+                                const uint32 grid_rows, const uint32 grid_cols,
+                                const private_video::ImageMemory *decoded_image = NULL);
 }; // class ImageDescriptor
 
 
@@ -348,6 +365,11 @@ public:
 
     ~StillImage();
 
+    //! \brief Returns the texture image referenced by the image, or NULL when it isn't loaded
+    const private_video::ImageTexture *GetImageTexture() const {
+        return _image_texture;
+    }
+
     //! \brief Resets the image's properties and removes any references to image data that it maintains
     void Clear();
 
@@ -308,6 +308,13 @@ void ImageMemory::CopyFromTexture(TexSheet *texture)
         PRINT_ERROR << "failed to malloc enough memory to copy the texture" << std::endl;
     }
 
+    // Without a display, the textures are never filled, so they are read as transparent.
+    if(VIDEO_HEADLESS) {
+        if(pixels != NULL)
+            memset(pixels, 0, height * width * (rgb_format ? 3 : 4));
+        return;
+    }
+
     TextureManager->_BindTexture(texture->tex_id);
     glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
 }
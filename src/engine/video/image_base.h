@@ -33,8 +33,8 @@
 *** properties of that image data.
 ***
 *** \note There are more derived classes from this set in other areas of the
-*** code. In particular, there is a TextTexture and TextElement class
-*** defined in the text.h header file.
+*** code. In particular, there is a TextElement class defined in the
+*** text.h header file.
 *** ***************************************************************************/
 
 #ifndef __IMAGE_BASE_HEADER__
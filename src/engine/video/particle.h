@@ -14,11 +14,13 @@
 *** \author  Yohann Ferreira, yohann ferreira orange fr
 *** \brief   Header file for particle data
 ***
-*** This file contains structure(s) for representing a single particle. In theory,
-*** we should be able to just have one structure which holds all properties for
-*** a particle, but in fact we have two: one for the position, and one for everything
-*** else. The reason is that having the positions separated is more efficient
-*** for rendering.
+*** This file contains the structures used to represent the particles of a
+*** system. The particles are stored as a structure of arrays: each property
+*** has its own stream, holding that property for every particle of the system.
+*** This way, the update and vertex generation loops only read the streams
+*** they need, and can process several particles at once with SIMD
+*** instructions. The vertices are kept in separate arrays, since they are
+*** fed as is to OpenGL for rendering.
 *** **************************************************************************/
 
 #ifndef __PARTICLE_HEADER__
@@ -70,134 +72,159 @@ public:
 };
 
 
-/*!***************************************************************************
- *  \brief this is the structure we use to represent a particle
- *****************************************************************************/
-
-
-class Particle
-{
-public:
-    Particle():
-        x(0.0f),
-        y(0.0f),
-        size_x(0.0f),
-        size_y(0.0f),
-        velocity_x(0.0f),
-        velocity_y(0.0f),
-        combined_velocity_x(0.0f),
-        combined_velocity_y(0.0f),
-        rotation_angle(0.0f),
-        rotation_speed(0.0f),
-        time(0.0f),
-        lifetime(0.0f),
-        wave_length_coefficient(0.0f),
-        wave_half_amplitude(0.0f),
-        acceleration_x(0.0f),
-        acceleration_y(0.0f),
-        tangential_acceleration(0.0f),
-        radial_acceleration(0.0f),
-        wind_velocity_x(0.0f),
-        wind_velocity_y(0.0f),
-        damping(0.0f),
-        rotation_direction(0.0f),
-        current_size_variation_x(0.0f),
-        current_size_variation_y(0.0f),
-        next_size_variation_x(0.0f),
-        next_size_variation_y(0.0f),
-        current_rotation_speed_variation(0.0f),
-        next_rotation_speed_variation(0.0f),
-        current_keyframe(NULL),
-        next_keyframe(NULL)
-    {}
+//! \brief The number of particles processed at once by the update kernels.
+//! The streams are padded to a multiple of it, so that the kernels never need a scalar tail loop.
+const uint32 PARTICLE_STREAM_WIDTH = 4;
+
+//! \brief The particle properties which are interpolated between keyframes.
+enum PARTICLE_PROPERTY {
+    PARTICLE_PROPERTY_ROTATION_SPEED = 0,
+    PARTICLE_PROPERTY_SIZE_X = 1,
+    PARTICLE_PROPERTY_SIZE_Y = 2,
+    PARTICLE_PROPERTY_COLOR_R = 3,
+    PARTICLE_PROPERTY_COLOR_G = 4,
+    PARTICLE_PROPERTY_COLOR_B = 5,
+    PARTICLE_PROPERTY_COLOR_A = 6,
+    PARTICLE_PROPERTY_TOTAL = 7
+};
 
+//! \brief The float streams of the particles.
+enum PARTICLE_STREAM {
     //! position
-    float x;
-    float y;
-
-    //! size
-    float size_x;
-    float size_y;
+    PARTICLE_STREAM_X = 0,
+    PARTICLE_STREAM_Y = 1,
 
     //! velocity
-    float velocity_x;
-    float velocity_y;
-
-    //! store the combined velocity (particle + wind + wave) so we only have
-    //! to calculate it once
-    float combined_velocity_x;
-    float combined_velocity_y;
+    PARTICLE_STREAM_VELOCITY_X = 2,
+    PARTICLE_STREAM_VELOCITY_Y = 3,
 
-    //! color
-    vt_video::Color color;
+    //! the combined velocity (particle + wind + wave), computed once per update
+    PARTICLE_STREAM_COMBINED_VELOCITY_X = 4,
+    PARTICLE_STREAM_COMBINED_VELOCITY_Y = 5,
 
     //! current rotation angle
-    float rotation_angle;
+    PARTICLE_STREAM_ROTATION_ANGLE = 6,
 
-    //! rotation speed
-    float rotation_speed;
+    //! either 1 (clockwise) or -1 (counterclockwise), chosen when the particle is spawned
+    PARTICLE_STREAM_ROTATION_DIRECTION = 7,
 
-    //! seconds since particle was spawned
-    float time;
+    //! seconds since the particle was spawned
+    PARTICLE_STREAM_TIME = 8,
 
     //! lifetime (when the particle is supposed to die)
-    float lifetime;
-
-    //! this is 2 * pi / wavelength. The reason we store this weird
-    //! number instead of the wavelength is because that's what we
-    //! will ultimately plug into the sin function
-    float wave_length_coefficient;
-
-    //! half the amplitude of the wave. We store half the amplitude
-    //! instead of the whole amplitude because that's what gets multiplied
-    //! with the sin function
-    float wave_half_amplitude;
-
-    //! acceleration, i.e. change in velocity per second. The most common use
-    //! for this is for simulating gravity. If you have multiple constant
-    //! forces acting on particles, then this vector should be the sum of
-    //! those forces.
-    float acceleration_x;
-    float acceleration_y;
-
-    //! tangential acceleration- just like normal acceleration, except it
-    //! is applied in the tangent direction. positive = clockwise.
-    float tangential_acceleration;
-
-    //! radial acceleration- acceleration towards (negative) or away (positive)
-    //! from an attractor. Note that the default attractor is the emitter position.
-    //! The client can set an attractor for the entire effect by calling
-    //! ParticleEffect::SetAttractor(x,y)
-    float radial_acceleration;
-
-    //! wind velocity. this gets added to the particle's velocity each frame.
-    //! note that different particles might also have a slightly different wind
-    //! velocity, if the system has some wind velocity variation
-    float wind_velocity_x;
-    float wind_velocity_y;
-
-    //! damping- the particle's velocity gets multiplied by this value each second.
-    //! So for example, a damping of .6 means that a particle slows down by 40% each
-    //! second.
-    float damping;
-
-    //! when a particle is created, it is given a rotation direction: either
-    //! 1 (clockwise) or -1 (counterclockwise)
-    float rotation_direction;
-
-    //! property variations
-    float current_size_variation_x;
-    float current_size_variation_y;
-    float next_size_variation_x;
-    float next_size_variation_y;
-    float current_rotation_speed_variation;
-    float next_rotation_speed_variation;
-    vt_video::Color current_color_variation;
-    vt_video::Color next_color_variation;
-
-    //! keep track of current and next keyframes
-    ParticleKeyframe *current_keyframe;
-    ParticleKeyframe *next_keyframe;
+    PARTICLE_STREAM_LIFETIME = 9,
+
+    //! this is 2 * pi / wavelength, which is what ultimately gets plugged into the sin function
+    PARTICLE_STREAM_WAVE_LENGTH_COEFFICIENT = 10,
+
+    //! half the amplitude of the wave, which is what gets multiplied with the sin function
+    PARTICLE_STREAM_WAVE_HALF_AMPLITUDE = 11,
+
+    //! acceleration, i.e. change in velocity per second
+    PARTICLE_STREAM_ACCELERATION_X = 12,
+    PARTICLE_STREAM_ACCELERATION_Y = 13,
+
+    //! acceleration applied in the tangent direction. positive = clockwise.
+    PARTICLE_STREAM_TANGENTIAL_ACCELERATION = 14,
+
+    //! acceleration towards (negative) or away (positive) from the attractor
+    PARTICLE_STREAM_RADIAL_ACCELERATION = 15,
+
+    //! wind velocity, added to the particle's velocity each frame
+    PARTICLE_STREAM_WIND_VELOCITY_X = 16,
+    PARTICLE_STREAM_WIND_VELOCITY_Y = 17,
+
+    //! the particle's velocity gets multiplied by this value each second
+    PARTICLE_STREAM_DAMPING = 18,
+
+    //! the particle time of the current and next keyframes, in seconds, and the inverse
+    //! of the time between them. The end time is FLT_MAX once on the last keyframe.
+    PARTICLE_STREAM_KEYFRAME_START_TIME = 19,
+    PARTICLE_STREAM_KEYFRAME_END_TIME = 20,
+    PARTICLE_STREAM_KEYFRAME_INV_DURATION = 21,
+
+    //! the current value of each keyframed property, in PARTICLE_PROPERTY order
+    PARTICLE_STREAM_PROPERTY = 22,
+
+    //! the value of each keyframed property at the current keyframe, variation included
+    PARTICLE_STREAM_PROPERTY_START = PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_TOTAL,
+
+    //! the value of each keyframed property at the next keyframe, variation included
+    PARTICLE_STREAM_PROPERTY_END = PARTICLE_STREAM_PROPERTY_START + PARTICLE_PROPERTY_TOTAL,
+
+    PARTICLE_STREAM_TOTAL = PARTICLE_STREAM_PROPERTY_END + PARTICLE_PROPERTY_TOTAL
+};
+
+
+/*!***************************************************************************
+ *  \brief this is the structure we use to represent the particles of a system
+ *
+ *  Each stream holds one property for every particle, and is padded to a
+ *  multiple of PARTICLE_STREAM_WIDTH. The padding particles hold meaningless
+ *  values, which are computed along with the other ones but never drawn.
+ *****************************************************************************/
+
+class ParticleStreams
+{
+public:
+    ParticleStreams():
+        _capacity(0)
+    {}
+
+    //! \brief Resizes the streams so that they can hold the given number of particles.
+    void Resize(uint32 num_particles) {
+        _capacity = (num_particles + PARTICLE_STREAM_WIDTH - 1) / PARTICLE_STREAM_WIDTH * PARTICLE_STREAM_WIDTH;
+        for(uint32 i = 0; i < PARTICLE_STREAM_TOTAL; ++i)
+            _streams[i].assign(_capacity, 0.0f);
+        _keyframes.assign(_capacity, 0);
+    }
+
+    //! \brief Frees the streams.
+    void Clear() {
+        _capacity = 0;
+        for(uint32 i = 0; i < PARTICLE_STREAM_TOTAL; ++i)
+            _streams[i].clear();
+        _keyframes.clear();
+    }
+
+    //! \brief Copies the particle at index src over the one at index dest.
+    void Move(uint32 src, uint32 dest) {
+        for(uint32 i = 0; i < PARTICLE_STREAM_TOTAL; ++i)
+            _streams[i][dest] = _streams[i][src];
+        _keyframes[dest] = _keyframes[src];
+    }
+
+    //! \brief Returns the number of particles the streams can hold, padding included.
+    uint32 GetCapacity() const {
+        return _capacity;
+    }
+
+    /** \brief Returns the given stream
+    *** \param stream One of the PARTICLE_STREAM values
+    *** \note The streams must have been resized to a non-null size first.
+    **/
+    float *Get(uint32 stream) {
+        return &_streams[stream][0];
+    }
+
+    const float *Get(uint32 stream) const {
+        return &_streams[stream][0];
+    }
+
+    //! \brief Returns the index of the current keyframe of each particle.
+    int32 *GetKeyframes() {
+        return &_keyframes[0];
+    }
+
+private:
+    //! \brief The number of particles the streams can hold.
+    uint32 _capacity;
+
+    //! \brief The float streams, indexed by the PARTICLE_STREAM values.
+    std::vector<float> _streams[PARTICLE_STREAM_TOTAL];
+
+    //! \brief The index of the current keyframe of each particle in the system definition.
+    std::vector<int32> _keyframes;
 };
 
 } // vt_mode_manager
@@ -364,7 +364,7 @@ bool ParticleEffect::_CreateEffect()
     std::vector<ParticleSystemDef>::iterator it = _effect_def._systems.begin();
     for(; it != _effect_def._systems.end(); ++it) {
         if((*it).enabled) {
-            ParticleSystem sys(&(*it));
+            ParticleSystem sys(&(*it), _load_images);
             if(!sys.IsAlive()) {
                 // If a system could not be created then we bail out
                 _systems.clear();
@@ -384,6 +384,18 @@ bool ParticleEffect::_CreateEffect()
 }
 
 bool ParticleEffect::LoadEffect(const std::string &filename)
+{
+    _load_images = true;
+    return _LoadEffect(filename);
+}
+
+bool ParticleEffect::LoadEffectWithoutImages(const std::string &filename)
+{
+    _load_images = false;
+    return _LoadEffect(filename);
+}
+
+bool ParticleEffect::_LoadEffect(const std::string &filename)
 {
     if(!_LoadEffectDef(filename)) {
         PRINT_WARNING << "Failed to load particle definition file: "
@@ -414,7 +426,18 @@ void ParticleEffect::Draw()
 
     VideoManager->DisableAlphaTest();
     VideoManager->DisableStencilTest();
-    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    if(!VIDEO_HEADLESS)
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void ParticleEffect::GenerateVertices()
+{
+    std::vector<ParticleSystem>::iterator iSystem = _systems.begin();
+
+    while(iSystem != _systems.end()) {
+        (*iSystem).GenerateVertices();
+        ++iSystem;
+    }
 }
 
 void ParticleEffect::Update()
@@ -423,14 +446,29 @@ void ParticleEffect::Update()
 }
 
 void ParticleEffect::Update(float frame_time)
+{
+    vt_mode_manager::EffectParameters effect_parameters;
+    if(!_PrepareUpdate(frame_time, effect_parameters))
+        return;
+
+    std::vector<ParticleSystem>::iterator iSystem = _systems.begin();
+
+    while(iSystem != _systems.end()) {
+        (*iSystem).Update(frame_time, effect_parameters);
+        ++iSystem;
+    }
+
+    _FinishUpdate();
+}
+
+bool ParticleEffect::_PrepareUpdate(float frame_time, EffectParameters &effect_parameters)
 {
     _age += frame_time;
     _num_particles = 0;
 
     if(!_alive)
-        return;
+        return false;
 
-    vt_mode_manager::EffectParameters effect_parameters;
     effect_parameters.orientation = _orientation;
 
     // note we subtract the effect position to put the attractor point in effect
@@ -447,12 +485,21 @@ void ParticleEffect::Update(float frame_time)
             if(_systems.empty())
                 _alive = false;
         } else {
-            (*iSystem).Update(frame_time, effect_parameters);
-
-            _num_particles += (*iSystem).GetNumParticles();
             ++iSystem;
         }
     }
+
+    return _alive;
+}
+
+void ParticleEffect::_FinishUpdate()
+{
+    std::vector<ParticleSystem>::const_iterator iSystem = _systems.begin();
+
+    while(iSystem != _systems.end()) {
+        _num_particles += (*iSystem).GetNumParticles();
+        ++iSystem;
+    }
 }
 
 
@@ -469,6 +516,7 @@ void ParticleEffect::_Destroy()
     _systems.clear();
 
     _loaded = false;
+    _load_images = true;
 }
 
 
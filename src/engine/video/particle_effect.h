@@ -93,6 +93,8 @@ public:
 
 class ParticleEffect
 {
+    friend class ParticleWorkers;
+
 public:
     /*!
      *  \brief Constructor
@@ -114,6 +116,12 @@ public:
     **/
     bool LoadEffect(const std::string &effect_filename);
 
+    /** Same as LoadEffect(), but without loading the particle images. The effect
+    *** can be updated and its vertices generated, but it isn't drawn.
+    *** This is useful to run the effect without any video context, e.g. for benchmarks.
+    **/
+    bool LoadEffectWithoutImages(const std::string &effect_filename);
+
     /*!
      *  \brief moves the effect to the specified position on the screen,
      *         This can be used if you want to move a particle system around
@@ -223,6 +231,9 @@ public:
     //! \brief draws the effect.
     void Draw();
 
+    //! \brief fills the vertex arrays of the effect systems, as done when drawing, without using OpenGL.
+    void GenerateVertices();
+
     /*!
      * \brief updates the effect.
      * \param the new frame time
@@ -243,6 +254,19 @@ private:
      */
     bool _LoadEffectDef(const std::string &filename);
 
+    //! \brief Loads the effect definition and creates the effect.
+    bool _LoadEffect(const std::string &filename);
+
+    /** \brief Ages the effect and removes its dead systems, before its systems are updated
+    *** \param frame_time The elapsed time since last call
+    *** \param effect_parameters Filled with the parameters to update the systems with
+    *** \return false if the effect is dead, and there is nothing to update
+    **/
+    bool _PrepareUpdate(float frame_time, EffectParameters &effect_parameters);
+
+    //! \brief Counts the effect particles, once its systems are updated.
+    void _FinishUpdate();
+
     /** Creates the effect based on the particle effect definition.
     *** _LoadEffectDef() must be called before this one.
     **/
@@ -262,6 +286,9 @@ private:
     //! Tells whether the effect definition and systems arewere successfully loaded
     bool _loaded;
 
+    //! Tells whether the particle images are loaded when the systems are created
+    bool _load_images;
+
     //! position of the effect
     float _x, _y;
 
@@ -22,6 +22,8 @@
 
 #include "engine/video/particle_effect.h"
 
+#include "engine/mode_manager.h"
+
 using namespace vt_script;
 using namespace vt_video;
 
@@ -63,8 +65,10 @@ void ParticleManager::Draw() const
 
     std::vector<ParticleEffect *>::const_iterator it = _active_effects.begin();
 
-    glClearStencil(0);
-    glClear(GL_STENCIL_BUFFER_BIT);
+    if(!VIDEO_HEADLESS) {
+        glClearStencil(0);
+        glClear(GL_STENCIL_BUFFER_BIT);
+    }
 
     while(it != _active_effects.end()) {
         (*it)->Draw();
@@ -80,17 +84,19 @@ void ParticleManager::Update(int32 frame_time)
 
     std::vector<ParticleEffect *>::iterator it = _active_effects.begin();
 
-    _num_particles = 0;
-
     while(it != _active_effects.end()) {
-        if(!(*it)->IsAlive()) {
+        if(!(*it)->IsAlive())
             it = _active_effects.erase(it);
-        } else {
-            (*it)->Update(frame_time_seconds);
-            _num_particles += (*it)->GetNumParticles();
+        else
             ++it;
-        }
     }
+
+    // The effects systems are updated in parallel.
+    ModeManager->GetParticleWorkers().UpdateEffects(_active_effects, frame_time_seconds);
+
+    _num_particles = 0;
+    for(it = _active_effects.begin(); it != _active_effects.end(); ++it)
+        _num_particles += (*it)->GetNumParticles();
 }
 
 void ParticleManager::StopAll(bool kill_immediate)
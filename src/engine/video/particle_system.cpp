@@ -21,7 +21,11 @@
 #include "particle_keyframe.h"
 #include "engine/video/video.h"
 
-#include "utils/utils_random.h"
+#include <cfloat>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace vt_utils;
 using namespace vt_video;
@@ -29,7 +33,409 @@ using namespace vt_video;
 namespace vt_mode_manager
 {
 
-bool ParticleSystem::_Create(ParticleSystemDef *sys_def)
+//! The size of the particle image used by systems without loaded images
+const float HEADLESS_PARTICLE_IMAGE_SIZE = 32.0f;
+
+//-----------------------------------------------------------------------------
+// Particle kernels: each of them processes the particle streams
+// PARTICLE_STREAM_WIDTH particles at a time using SSE2 when it is available,
+// and one particle at a time otherwise. The streams are padded so that the
+// SSE2 loops never need to handle a remainder.
+//-----------------------------------------------------------------------------
+
+//! \brief Interpolates the keyframed properties between their current and next keyframe values.
+static void InterpolateProperties(ParticleStreams &particles, int32 count)
+{
+    const float *time = particles.Get(PARTICLE_STREAM_TIME);
+    const float *start_time = particles.Get(PARTICLE_STREAM_KEYFRAME_START_TIME);
+    const float *inv_duration = particles.Get(PARTICLE_STREAM_KEYFRAME_INV_DURATION);
+
+    float *value[PARTICLE_PROPERTY_TOTAL];
+    const float *start[PARTICLE_PROPERTY_TOTAL];
+    const float *end[PARTICLE_PROPERTY_TOTAL];
+    for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k) {
+        value[k] = particles.Get(PARTICLE_STREAM_PROPERTY + k);
+        start[k] = particles.Get(PARTICLE_STREAM_PROPERTY_START + k);
+        end[k] = particles.Get(PARTICLE_STREAM_PROPERTY_END + k);
+    }
+
+#ifdef __SSE2__
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        // how far we are from the current to the next keyframe (0.0 to 1.0). This is
+        // always zero on the last keyframe, since its inverse duration is zero.
+        __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(time + j), _mm_loadu_ps(start_time + j)),
+                              _mm_loadu_ps(inv_duration + j));
+
+        for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k) {
+            __m128 s = _mm_loadu_ps(start[k] + j);
+            __m128 e = _mm_loadu_ps(end[k] + j);
+            _mm_storeu_ps(value[k] + j, _mm_add_ps(s, _mm_mul_ps(a, _mm_sub_ps(e, s))));
+        }
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        float a = (time[j] - start_time[j]) * inv_duration[j];
+
+        for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k)
+            value[k][j] = start[k][j] + a * (end[k][j] - start[k][j]);
+    }
+#endif
+}
+
+//! \brief Updates the rotation angles, and sets the combined velocities to the particle plus wind velocities.
+static void IntegrateRotationAndWind(ParticleStreams &particles, int32 count, float t)
+{
+    float *angle = particles.Get(PARTICLE_STREAM_ROTATION_ANGLE);
+    const float *speed = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_ROTATION_SPEED);
+    const float *direction = particles.Get(PARTICLE_STREAM_ROTATION_DIRECTION);
+    const float *velocity_x = particles.Get(PARTICLE_STREAM_VELOCITY_X);
+    const float *velocity_y = particles.Get(PARTICLE_STREAM_VELOCITY_Y);
+    const float *wind_x = particles.Get(PARTICLE_STREAM_WIND_VELOCITY_X);
+    const float *wind_y = particles.Get(PARTICLE_STREAM_WIND_VELOCITY_Y);
+    float *combined_x = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_X);
+    float *combined_y = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_Y);
+
+#ifdef __SSE2__
+    const __m128 vt = _mm_set1_ps(t);
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        __m128 rotation = _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(speed + j), _mm_loadu_ps(direction + j)), vt);
+        _mm_storeu_ps(angle + j, _mm_add_ps(_mm_loadu_ps(angle + j), rotation));
+        _mm_storeu_ps(combined_x + j, _mm_add_ps(_mm_loadu_ps(velocity_x + j), _mm_loadu_ps(wind_x + j)));
+        _mm_storeu_ps(combined_y + j, _mm_add_ps(_mm_loadu_ps(velocity_y + j), _mm_loadu_ps(wind_y + j)));
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        angle[j] += speed[j] * direction[j] * t;
+        combined_x[j] = velocity_x[j] + wind_x[j];
+        combined_y[j] = velocity_y[j] + wind_y[j];
+    }
+#endif
+}
+
+//! \brief Adds the wave velocity, tangent to the combined velocity, to the combined velocities.
+static void ApplyWaveMotion(ParticleStreams &particles, int32 count)
+{
+    const float *time = particles.Get(PARTICLE_STREAM_TIME);
+    const float *coefficient = particles.Get(PARTICLE_STREAM_WAVE_LENGTH_COEFFICIENT);
+    const float *half_amplitude = particles.Get(PARTICLE_STREAM_WAVE_HALF_AMPLITUDE);
+    float *combined_x = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_X);
+    float *combined_y = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_Y);
+
+    // There is no SSE2 sine, so this one stays scalar.
+    for(int32 j = 0; j < count; ++j) {
+        if(half_amplitude[j] <= 0.0f)
+            continue;
+
+        // find the magnitude of the wave velocity
+        float wave_speed = half_amplitude[j] * sinf(coefficient[j] * time[j]);
+
+        // now the wave velocity is just that wave speed times the particle's tangential vector
+        float tangent_x = -combined_y[j];
+        float tangent_y = combined_x[j];
+        float speed = sqrtf(tangent_x * tangent_x + tangent_y * tangent_y);
+
+        combined_x[j] += tangent_x / speed * wave_speed;
+        combined_y[j] += tangent_y / speed * wave_speed;
+    }
+}
+
+//! \brief Moves the particles along their combined velocity, applies their acceleration and ages them.
+static void IntegratePositions(ParticleStreams &particles, int32 count, float t)
+{
+    float *x = particles.Get(PARTICLE_STREAM_X);
+    float *y = particles.Get(PARTICLE_STREAM_Y);
+    const float *combined_x = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_X);
+    const float *combined_y = particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_Y);
+    float *velocity_x = particles.Get(PARTICLE_STREAM_VELOCITY_X);
+    float *velocity_y = particles.Get(PARTICLE_STREAM_VELOCITY_Y);
+    const float *acceleration_x = particles.Get(PARTICLE_STREAM_ACCELERATION_X);
+    const float *acceleration_y = particles.Get(PARTICLE_STREAM_ACCELERATION_Y);
+    float *time = particles.Get(PARTICLE_STREAM_TIME);
+
+#ifdef __SSE2__
+    const __m128 vt = _mm_set1_ps(t);
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        _mm_storeu_ps(x + j, _mm_add_ps(_mm_loadu_ps(x + j), _mm_mul_ps(_mm_loadu_ps(combined_x + j), vt)));
+        _mm_storeu_ps(y + j, _mm_add_ps(_mm_loadu_ps(y + j), _mm_mul_ps(_mm_loadu_ps(combined_y + j), vt)));
+        _mm_storeu_ps(velocity_x + j, _mm_add_ps(_mm_loadu_ps(velocity_x + j), _mm_mul_ps(_mm_loadu_ps(acceleration_x + j), vt)));
+        _mm_storeu_ps(velocity_y + j, _mm_add_ps(_mm_loadu_ps(velocity_y + j), _mm_mul_ps(_mm_loadu_ps(acceleration_y + j), vt)));
+        _mm_storeu_ps(time + j, _mm_add_ps(_mm_loadu_ps(time + j), vt));
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        x[j] += combined_x[j] * t;
+        y[j] += combined_y[j] * t;
+        velocity_x[j] += acceleration_x[j] * t;
+        velocity_y[j] += acceleration_y[j] * t;
+        time[j] += t;
+    }
+#endif
+}
+
+/** \brief Applies the radial and tangential accelerations relative to the attractor point
+*** \param attractor_x, attractor_y The attractor position
+*** \param falloff How quickly the radial acceleration falls off with the distance, or zero
+**/
+static void ApplyAttractor(ParticleStreams &particles, int32 count, float t,
+                           float attractor_x, float attractor_y, float falloff)
+{
+    const float *x = particles.Get(PARTICLE_STREAM_X);
+    const float *y = particles.Get(PARTICLE_STREAM_Y);
+    const float *radial = particles.Get(PARTICLE_STREAM_RADIAL_ACCELERATION);
+    const float *tangential = particles.Get(PARTICLE_STREAM_TANGENTIAL_ACCELERATION);
+    float *velocity_x = particles.Get(PARTICLE_STREAM_VELOCITY_X);
+    float *velocity_y = particles.Get(PARTICLE_STREAM_VELOCITY_Y);
+
+#ifdef __SSE2__
+    const __m128 vt = _mm_set1_ps(t);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 vfalloff = _mm_set1_ps(falloff);
+    const __m128 vattractor_x = _mm_set1_ps(attractor_x);
+    const __m128 vattractor_y = _mm_set1_ps(attractor_y);
+
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        // unit vector from attractor to particle, left null when they are at the same place
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + j), vattractor_x);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + j), vattractor_y);
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 inv_distance = _mm_and_ps(_mm_cmpneq_ps(distance, zero), _mm_div_ps(one, distance));
+        dx = _mm_mul_ps(dx, inv_distance);
+        dy = _mm_mul_ps(dy, inv_distance);
+
+        // the attraction lessens with the distance, down to nothing
+        __m128 radial_t = _mm_mul_ps(_mm_loadu_ps(radial + j), vt);
+        if(falloff != 0.0f)
+            radial_t = _mm_mul_ps(radial_t, _mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(vfalloff, distance)), zero));
+        __m128 tangential_t = _mm_mul_ps(_mm_loadu_ps(tangential + j), vt);
+
+        // the tangent vector is simply the perpendicular vector (-dy, dx)
+        __m128 vx = _mm_sub_ps(_mm_mul_ps(dx, radial_t), _mm_mul_ps(dy, tangential_t));
+        __m128 vy = _mm_add_ps(_mm_mul_ps(dy, radial_t), _mm_mul_ps(dx, tangential_t));
+        _mm_storeu_ps(velocity_x + j, _mm_add_ps(_mm_loadu_ps(velocity_x + j), vx));
+        _mm_storeu_ps(velocity_y + j, _mm_add_ps(_mm_loadu_ps(velocity_y + j), vy));
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        float dx = x[j] - attractor_x;
+        float dy = y[j] - attractor_y;
+        float distance = sqrtf(dx * dx + dy * dy);
+        if(distance != 0.0f) {
+            dx /= distance;
+            dy /= distance;
+        }
+
+        float radial_t = radial[j] * t;
+        if(falloff != 0.0f) {
+            float attraction = 1.0f - falloff * distance;
+            radial_t *= (attraction > 0.0f) ? attraction : 0.0f;
+        }
+        float tangential_t = tangential[j] * t;
+
+        velocity_x[j] += dx * radial_t - dy * tangential_t;
+        velocity_y[j] += dy * radial_t + dx * tangential_t;
+    }
+#endif
+}
+
+//! \brief Multiplies the particle velocities by the given factor.
+static void DampVelocities(ParticleStreams &particles, int32 count, float factor)
+{
+    float *velocity_x = particles.Get(PARTICLE_STREAM_VELOCITY_X);
+    float *velocity_y = particles.Get(PARTICLE_STREAM_VELOCITY_Y);
+
+#ifdef __SSE2__
+    const __m128 vfactor = _mm_set1_ps(factor);
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        _mm_storeu_ps(velocity_x + j, _mm_mul_ps(_mm_loadu_ps(velocity_x + j), vfactor));
+        _mm_storeu_ps(velocity_y + j, _mm_mul_ps(_mm_loadu_ps(velocity_y + j), vfactor));
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        velocity_x[j] *= factor;
+        velocity_y[j] *= factor;
+    }
+#endif
+}
+
+#ifdef __SSE2__
+//! \brief Writes the upper-left, upper-right, lower-right and lower-left vertices of 4 particle quads.
+static inline void StoreQuads(float *vertices, __m128 x0, __m128 y0, __m128 x1, __m128 y1,
+                              __m128 x2, __m128 y2, __m128 x3, __m128 y3)
+{
+    // Interleave the x and y coordinates of the first two particles, then of the last two.
+    __m128 c0 = _mm_unpacklo_ps(x0, y0);
+    __m128 c1 = _mm_unpacklo_ps(x1, y1);
+    __m128 c2 = _mm_unpacklo_ps(x2, y2);
+    __m128 c3 = _mm_unpacklo_ps(x3, y3);
+    _mm_storeu_ps(vertices, _mm_movelh_ps(c0, c1));
+    _mm_storeu_ps(vertices + 4, _mm_movelh_ps(c2, c3));
+    _mm_storeu_ps(vertices + 8, _mm_movehl_ps(c1, c0));
+    _mm_storeu_ps(vertices + 12, _mm_movehl_ps(c3, c2));
+
+    c0 = _mm_unpackhi_ps(x0, y0);
+    c1 = _mm_unpackhi_ps(x1, y1);
+    c2 = _mm_unpackhi_ps(x2, y2);
+    c3 = _mm_unpackhi_ps(x3, y3);
+    _mm_storeu_ps(vertices + 16, _mm_movelh_ps(c0, c1));
+    _mm_storeu_ps(vertices + 20, _mm_movelh_ps(c2, c3));
+    _mm_storeu_ps(vertices + 24, _mm_movehl_ps(c1, c0));
+    _mm_storeu_ps(vertices + 28, _mm_movehl_ps(c3, c2));
+}
+#endif
+
+/** \brief Generates the 4 vertices of each particle quad, the quads being axis aligned
+*** \param vertices The vertex array, 8 floats per particle
+*** \param half_width, half_height The half size of the particle image
+**/
+static void GenerateQuads(float *vertices, const ParticleStreams &particles, int32 count,
+                          float half_width, float half_height)
+{
+    const float *x = particles.Get(PARTICLE_STREAM_X);
+    const float *y = particles.Get(PARTICLE_STREAM_Y);
+    const float *size_x = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_SIZE_X);
+    const float *size_y = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_SIZE_Y);
+
+#ifdef __SSE2__
+    const __m128 vhalf_width = _mm_set1_ps(half_width);
+    const __m128 vhalf_height = _mm_set1_ps(half_height);
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        __m128 px = _mm_loadu_ps(x + j);
+        __m128 py = _mm_loadu_ps(y + j);
+        __m128 w = _mm_mul_ps(_mm_loadu_ps(size_x + j), vhalf_width);
+        __m128 h = _mm_mul_ps(_mm_loadu_ps(size_y + j), vhalf_height);
+        __m128 left = _mm_sub_ps(px, w);
+        __m128 right = _mm_add_ps(px, w);
+        __m128 top = _mm_sub_ps(py, h);
+        __m128 bottom = _mm_add_ps(py, h);
+        StoreQuads(vertices + j * 8, left, top, right, top, right, bottom, left, bottom);
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        float w = size_x[j] * half_width;
+        float h = size_y[j] * half_height;
+        float *v = vertices + j * 8;
+        v[0] = x[j] - w;
+        v[1] = y[j] - h;
+        v[2] = x[j] + w;
+        v[3] = y[j] - h;
+        v[4] = x[j] + w;
+        v[5] = y[j] + h;
+        v[6] = x[j] - w;
+        v[7] = y[j] + h;
+    }
+#endif
+}
+
+/** \brief Generates the 4 vertices of each particle quad from the rotated quad axes
+*** \param vertices The vertex array, 8 floats per particle
+*** \param width_x, width_y The rotated half width vector of each quad
+*** \param height_x, height_y The rotated half height vector of each quad
+**/
+static void GenerateRotatedQuads(float *vertices, const ParticleStreams &particles, int32 count,
+                                 const float *width_x, const float *width_y,
+                                 const float *height_x, const float *height_y)
+{
+    const float *x = particles.Get(PARTICLE_STREAM_X);
+    const float *y = particles.Get(PARTICLE_STREAM_Y);
+
+#ifdef __SSE2__
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        __m128 px = _mm_loadu_ps(x + j);
+        __m128 py = _mm_loadu_ps(y + j);
+        __m128 wx = _mm_loadu_ps(width_x + j);
+        __m128 wy = _mm_loadu_ps(width_y + j);
+        __m128 hx = _mm_loadu_ps(height_x + j);
+        __m128 hy = _mm_loadu_ps(height_y + j);
+
+        // the quad center, moved half a height up and down
+        __m128 top_x = _mm_sub_ps(px, hx);
+        __m128 top_y = _mm_sub_ps(py, hy);
+        __m128 bottom_x = _mm_add_ps(px, hx);
+        __m128 bottom_y = _mm_add_ps(py, hy);
+
+        StoreQuads(vertices + j * 8,
+                   _mm_sub_ps(top_x, wx), _mm_sub_ps(top_y, wy),
+                   _mm_add_ps(top_x, wx), _mm_add_ps(top_y, wy),
+                   _mm_add_ps(bottom_x, wx), _mm_add_ps(bottom_y, wy),
+                   _mm_sub_ps(bottom_x, wx), _mm_sub_ps(bottom_y, wy));
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        float *v = vertices + j * 8;
+        v[0] = x[j] - height_x[j] - width_x[j];
+        v[1] = y[j] - height_y[j] - width_y[j];
+        v[2] = x[j] - height_x[j] + width_x[j];
+        v[3] = y[j] - height_y[j] + width_y[j];
+        v[4] = x[j] + height_x[j] + width_x[j];
+        v[5] = y[j] + height_y[j] + width_y[j];
+        v[6] = x[j] + height_x[j] - width_x[j];
+        v[7] = y[j] + height_y[j] - width_y[j];
+    }
+#endif
+}
+
+/** \brief Writes the color of each particle to its 4 vertices
+*** \param colors The color array, 16 floats per particle
+*** \param factor The factor applied to the red, green and blue components, like Color::operator*(float) does
+**/
+static void GenerateColors(float *colors, const ParticleStreams &particles, int32 count, float factor)
+{
+    const float *red = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_COLOR_R);
+    const float *green = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_COLOR_G);
+    const float *blue = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_COLOR_B);
+    const float *alpha = particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_COLOR_A);
+
+#ifdef __SSE2__
+    const __m128 vfactor = _mm_set1_ps(factor);
+    for(int32 j = 0; j < count; j += PARTICLE_STREAM_WIDTH) {
+        __m128 c0 = _mm_mul_ps(_mm_loadu_ps(red + j), vfactor);
+        __m128 c1 = _mm_mul_ps(_mm_loadu_ps(green + j), vfactor);
+        __m128 c2 = _mm_mul_ps(_mm_loadu_ps(blue + j), vfactor);
+        __m128 c3 = _mm_loadu_ps(alpha + j);
+
+        // Turn the 4 channels of 4 particles into the 4 colors of 4 particles.
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+        float *c = colors + j * 16;
+        for(uint32 v = 0; v < 4; ++v) {
+            _mm_storeu_ps(c + v * 4, c0);
+            _mm_storeu_ps(c + 16 + v * 4, c1);
+            _mm_storeu_ps(c + 32 + v * 4, c2);
+            _mm_storeu_ps(c + 48 + v * 4, c3);
+        }
+    }
+#else
+    for(int32 j = 0; j < count; ++j) {
+        float *c = colors + j * 16;
+        for(uint32 v = 0; v < 4; ++v) {
+            c[v * 4] = red[j] * factor;
+            c[v * 4 + 1] = green[j] * factor;
+            c[v * 4 + 2] = blue[j] * factor;
+            c[v * 4 + 3] = alpha[j];
+        }
+    }
+#endif
+}
+
+//! \brief Reads the keyframed properties of a keyframe, and their variations, in PARTICLE_PROPERTY order.
+static void GetKeyframeProperties(const ParticleKeyframe &keyframe, float values[PARTICLE_PROPERTY_TOTAL],
+                                  float variations[PARTICLE_PROPERTY_TOTAL])
+{
+    values[PARTICLE_PROPERTY_ROTATION_SPEED] = keyframe.rotation_speed;
+    values[PARTICLE_PROPERTY_SIZE_X] = keyframe.size_x;
+    values[PARTICLE_PROPERTY_SIZE_Y] = keyframe.size_y;
+    variations[PARTICLE_PROPERTY_ROTATION_SPEED] = keyframe.rotation_speed_variation;
+    variations[PARTICLE_PROPERTY_SIZE_X] = keyframe.size_variation_x;
+    variations[PARTICLE_PROPERTY_SIZE_Y] = keyframe.size_variation_y;
+
+    for(int32 c = 0; c < 4; ++c) {
+        values[PARTICLE_PROPERTY_COLOR_R + c] = keyframe.color[c];
+        variations[PARTICLE_PROPERTY_COLOR_R + c] = keyframe.color_variation[c];
+    }
+}
+
+bool ParticleSystem::_Create(ParticleSystemDef *sys_def, bool load_images)
 {
     // Make sure the system def is valid before initializing.
     if(!sys_def) {
@@ -41,15 +447,32 @@ bool ParticleSystem::_Create(ParticleSystemDef *sys_def)
     _system_def = sys_def;
     _num_particles = 0;
 
-    _particles.resize(_system_def->max_particles);
-    _particle_vertices.resize(_system_def->max_particles * 4);
-    _particle_texcoords.resize(_system_def->max_particles * 4);
-    _particle_colors.resize(_system_def->max_particles * 4);
+    // The seed comes from the shared generator, so that the systems are
+    // deterministic as long as it is seeded with a fixed value.
+    _random.Seed(static_cast<uint32>(rand()));
+
+    // The vertex arrays are padded like the streams, since the kernels fill them
+    // PARTICLE_STREAM_WIDTH particles at a time.
+    _particles.Resize(_system_def->max_particles);
+    uint32 capacity = _particles.GetCapacity();
+    _particle_vertices.resize(capacity * 4);
+    _particle_texcoords.resize(capacity * 4);
+    _particle_colors.resize(capacity * 4);
+
+    if(_system_def->rotation_used) {
+        _quad_width_x.resize(capacity);
+        _quad_width_y.resize(capacity);
+        _quad_height_x.resize(capacity);
+        _quad_height_y.resize(capacity);
+    }
 
     _alive = true;
     _stopped = false;
     _age = 0.0f;
 
+    if(!load_images)
+        return true;
+
     size_t num_frames = _system_def->animation_frame_filenames.size();
 
     for(size_t j = 0; j < num_frames; ++j) {
@@ -67,94 +490,61 @@ bool ParticleSystem::_Create(ParticleSystemDef *sys_def)
     return true;
 }
 
-void ParticleSystem::Draw()
+void ParticleSystem::GenerateVertices()
 {
-    if(!_alive || !_system_def->enabled || _age < _system_def->emitter._start_time)
+    if(_num_particles == 0)
         return;
 
-    // set blending parameters
-    if(_system_def->blend_mode == VIDEO_NO_BLEND) {
-        VideoManager->DisableBlending();
-    } else {
-        VideoManager->EnableBlending();
-
-        if(_system_def->blend_mode == VIDEO_BLEND)
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        else
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // additive
+    // Systems created without their images use a nominal one
+    float img_width = HEADLESS_PARTICLE_IMAGE_SIZE;
+    float img_height = HEADLESS_PARTICLE_IMAGE_SIZE;
+    float u1 = 0.0f;
+    float u2 = 1.0f;
+    float v1 = 0.0f;
+    float v2 = 1.0f;
+    float frame_progress = 0.0f;
+
+    if(_animation.GetNumFrames() > 0) {
+        StillImage *id = _animation.GetFrame(_animation.GetCurrentFrameIndex());
+        private_video::ImageTexture *img = id->_image_texture;
+        img_width = static_cast<float>(img->width);
+        img_height = static_cast<float>(img->height);
+        u1 = img->u1;
+        u2 = img->u2;
+        v1 = img->v1;
+        v2 = img->v2;
+        frame_progress = _animation.GetPercentProgress();
     }
 
-
-    if(_system_def->use_stencil) {
-        VideoManager->EnableStencilTest();
-        glStencilFunc(GL_EQUAL, 1, 0xFFFFFFFF);
-        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    } else if(_system_def->modify_stencil) {
-        VideoManager->EnableStencilTest();
-
-        if(_system_def->stencil_op == VIDEO_STENCIL_OP_INCREASE)
-            glStencilOp(GL_INCR, GL_KEEP, GL_KEEP);
-        else if(_system_def->stencil_op == VIDEO_STENCIL_OP_DECREASE)
-            glStencilOp(GL_DECR, GL_KEEP, GL_KEEP);
-        else if(_system_def->stencil_op == VIDEO_STENCIL_OP_ZERO)
-            glStencilOp(GL_ZERO, GL_KEEP, GL_KEEP);
-        else
-            glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
-
-        glStencilFunc(GL_NEVER, 1, 0xFFFFFFFF);
-        VideoManager->EnableAlphaTest();
-        glAlphaFunc(GL_GREATER, 0.00f);
-        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-
-    } else {
-        VideoManager->DisableStencilTest();
-        VideoManager->DisableAlphaTest();
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    }
-
-    VideoManager->EnableTexture2D();
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    StillImage *id = _animation.GetFrame(_animation.GetCurrentFrameIndex());
-    private_video::ImageTexture *img = id->_image_texture;
-    TextureManager->_BindTexture(img->texture_sheet->tex_id);
-
-
-    float frame_progress = _animation.GetPercentProgress();
-
-    float u1 = img->u1;
-    float u2 = img->u2;
-    float v1 = img->v1;
-    float v2 = img->v2;
-
-    float img_width  = static_cast<float>(img->width);
-    float img_height = static_cast<float>(img->height);
-
     float img_width_half = img_width * 0.5f;
     float img_height_half = img_height * 0.5f;
 
+    float *vertices = &_particle_vertices[0]._x;
+
     // fill the vertex array
     if(_system_def->rotation_used) {
-        int32 v = 0;
-
+        const float *size_x = _particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_SIZE_X);
+        const float *size_y = _particles.Get(PARTICLE_STREAM_PROPERTY + PARTICLE_PROPERTY_SIZE_Y);
+        const float *angle = _particles.Get(PARTICLE_STREAM_ROTATION_ANGLE);
+        const float *combined_x = _particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_X);
+        const float *combined_y = _particles.Get(PARTICLE_STREAM_COMBINED_VELOCITY_Y);
+
+        // The angles need the scalar trigonometric functions, so only the rotated
+        // quad axes are computed here, and the vertices are generated from them.
         for(int32 j = 0; j < _num_particles; ++j) {
-            float scaled_width_half  = img_width_half * _particles[j].size_x;
-            float scaled_height_half = img_height_half * _particles[j].size_y;
+            float scaled_width_half  = img_width_half * size_x[j];
+            float scaled_height_half = img_height_half * size_y[j];
 
-            float rotation_angle = _particles[j].rotation_angle;
+            float rotation_angle = angle[j];
 
             if(_system_def->rotate_to_velocity) {
                 // calculate the angle based on the velocity
-                rotation_angle += UTILS_HALF_PI + atan2f(_particles[j].combined_velocity_y, _particles[j].combined_velocity_x);
+                rotation_angle += UTILS_HALF_PI + atan2f(combined_y[j], combined_x[j]);
 
                 // calculate the scaling due to speed
                 if(_system_def->speed_scale_used) {
                     // speed is magnitude of velocity
-                    float speed = sqrtf(_particles[j].combined_velocity_x * _particles[j].combined_velocity_x
-                                        + _particles[j].combined_velocity_y * _particles[j].combined_velocity_y);
+                    float speed = sqrtf(combined_x[j] * combined_x[j] + combined_y[j] * combined_y[j]);
                     float scale_factor = _system_def->speed_scale * speed;
 
                     if(scale_factor < _system_def->min_speed_scale)
@@ -166,90 +556,35 @@ void ParticleSystem::Draw()
                 }
             }
 
-            // upper-left vertex
-            _particle_vertices[v]._x = -scaled_width_half;
-            _particle_vertices[v]._y = -scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
-
-            // upper-right vertex
-            _particle_vertices[v]._x = scaled_width_half;
-            _particle_vertices[v]._y = -scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
-
-            // lower-right vertex
-            _particle_vertices[v]._x = scaled_width_half;
-            _particle_vertices[v]._y = scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
-
-            // lower-left vertex
-            _particle_vertices[v]._x = -scaled_width_half;
-            _particle_vertices[v]._y = scaled_height_half;
-            RotatePoint(_particle_vertices[v]._x, _particle_vertices[v]._y, rotation_angle);
-            _particle_vertices[v]._x += _particles[j].x;
-            _particle_vertices[v]._y += _particles[j].y;
-            ++v;
-
-
+            // same rotation as RotatePoint() applied to the (1, 0) and (0, 1) axes
+            float cos_angle = cosf(rotation_angle);
+            float sin_angle = sinf(rotation_angle);
+            _quad_width_x[j] = scaled_width_half * cos_angle;
+            _quad_width_y[j] = scaled_width_half * sin_angle;
+            _quad_height_x[j] = -scaled_height_half * sin_angle;
+            _quad_height_y[j] = scaled_height_half * cos_angle;
         }
-    } else {
-        int32 v = 0;
 
-        for(int32 j = 0; j < _num_particles; ++j) {
-            float scaled_width_half  = img_width_half * _particles[j].size_x;
-            float scaled_height_half = img_height_half * _particles[j].size_y;
-
-            // upper-left vertex
-            _particle_vertices[v]._x = _particles[j].x - scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y - scaled_height_half;
-            ++v;
-
-            // upper-right vertex
-            _particle_vertices[v]._x = _particles[j].x + scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y - scaled_height_half;
-            ++v;
-
-            // lower-right vertex
-            _particle_vertices[v]._x = _particles[j].x + scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y + scaled_height_half;
-            ++v;
-
-            // lower-left vertex
-            _particle_vertices[v]._x = _particles[j].x - scaled_width_half;
-            _particle_vertices[v]._y = _particles[j].y + scaled_height_half;
-            ++v;
-        }
+        GenerateRotatedQuads(vertices, _particles, _num_particles, &_quad_width_x[0], &_quad_width_y[0],
+                             &_quad_height_x[0], &_quad_height_y[0]);
+    } else {
+        GenerateQuads(vertices, _particles, _num_particles, img_width_half, img_height_half);
     }
 
     // fill the color array
-
-    int32 c = 0;
-    for(int32 j = 0; j < _num_particles; ++j) {
-        Color color = _particles[j].color;
-
-        if(_system_def->smooth_animation)
-            color = color * (1.0f - frame_progress);
-
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-        _particle_colors[c] = color;
-        ++c;
-    }
+    _GenerateColors(_system_def->smooth_animation ? 1.0f - frame_progress : 1.0f);
 
     // fill the texcoord array
+    _GenerateTexCoords(u1, v1, u2, v2);
+}
+
+void ParticleSystem::_GenerateColors(float factor)
+{
+    GenerateColors(&_particle_colors[0][0], _particles, _num_particles, factor);
+}
 
+void ParticleSystem::_GenerateTexCoords(float u1, float v1, float u2, float v2)
+{
     int32 t = 0;
     for(int32 j = 0; j < _num_particles; ++j) {
         // upper-left
@@ -272,6 +607,77 @@ void ParticleSystem::Draw()
         _particle_texcoords[t]._t1 = v2;
         ++t;
     }
+}
+
+void ParticleSystem::Draw()
+{
+    if(!_alive || !_system_def->enabled || _age < _system_def->emitter._start_time)
+        return;
+
+    // Systems created without their images can't be drawn
+    if(_animation.GetNumFrames() == 0)
+        return;
+
+    // The particles are drawn directly, so draw the pending images first
+    VideoManager->FlushSpriteBatch();
+
+    // Without a display, only the vertices are generated.
+    if(VIDEO_HEADLESS) {
+        GenerateVertices();
+        return;
+    }
+
+    // set blending parameters
+    if(_system_def->blend_mode == VIDEO_NO_BLEND) {
+        VideoManager->DisableBlending();
+    } else {
+        VideoManager->EnableBlending();
+
+        if(_system_def->blend_mode == VIDEO_BLEND)
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        else
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE); // additive
+    }
+
+
+    if(_system_def->use_stencil) {
+        VideoManager->EnableStencilTest();
+        glStencilFunc(GL_EQUAL, 1, 0xFFFFFFFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    } else if(_system_def->modify_stencil) {
+        VideoManager->EnableStencilTest();
+
+        if(_system_def->stencil_op == VIDEO_STENCIL_OP_INCREASE)
+            glStencilOp(GL_INCR, GL_KEEP, GL_KEEP);
+        else if(_system_def->stencil_op == VIDEO_STENCIL_OP_DECREASE)
+            glStencilOp(GL_DECR, GL_KEEP, GL_KEEP);
+        else if(_system_def->stencil_op == VIDEO_STENCIL_OP_ZERO)
+            glStencilOp(GL_ZERO, GL_KEEP, GL_KEEP);
+        else
+            glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
+
+        glStencilFunc(GL_NEVER, 1, 0xFFFFFFFF);
+        VideoManager->EnableAlphaTest();
+        glAlphaFunc(GL_GREATER, 0.00f);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    } else {
+        VideoManager->DisableStencilTest();
+        VideoManager->DisableAlphaTest();
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    VideoManager->EnableTexture2D();
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    StillImage *id = _animation.GetFrame(_animation.GetCurrentFrameIndex());
+    private_video::ImageTexture *img = id->_image_texture;
+    TextureManager->_BindTexture(img->texture_sheet->tex_id);
+
+    GenerateVertices();
 
     VideoManager->EnableVertexArray();
     VideoManager->EnableColorArray();
@@ -290,48 +696,8 @@ void ParticleSystem::Draw()
         private_video::ImageTexture *img2 = id2->_image_texture;
         TextureManager->_BindTexture(img2->texture_sheet->tex_id);
 
-        u1 = img2->u1;
-        u2 = img2->u2;
-        v1 = img2->v1;
-        v2 = img2->v2;
-
-        t = 0;
-        for(int32 j = 0; j < _num_particles; ++j) {
-            // upper-left
-            _particle_texcoords[t]._t0 = u1;
-            _particle_texcoords[t]._t1 = v1;
-            ++t;
-
-            // upper-right
-            _particle_texcoords[t]._t0 = u2;
-            _particle_texcoords[t]._t1 = v1;
-            ++t;
-
-            // lower-right
-            _particle_texcoords[t]._t0 = u2;
-            _particle_texcoords[t]._t1 = v2;
-            ++t;
-
-            // lower-left
-            _particle_texcoords[t]._t0 = u1;
-            _particle_texcoords[t]._t1 = v2;
-            ++t;
-        }
-
-        c = 0;
-        for(int32 j = 0; j < _num_particles; ++j) {
-            Color color = _particles[j].color;
-            color = color * frame_progress;
-
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-            _particle_colors[c] = color;
-            ++c;
-        }
+        _GenerateTexCoords(img2->u1, img2->v1, img2->u2, img2->v2);
+        _GenerateColors(_animation.GetPercentProgress());
 
         glVertexPointer(2, GL_FLOAT, 0, &_particle_vertices[0]);
         glColorPointer(4, GL_FLOAT, 0, &_particle_colors[0]);
@@ -417,187 +783,126 @@ void ParticleSystem::_Destroy()
     _alive = false;
     _stopped = false;
 
-    _particles.clear();
+    _particles.Clear();
     _particle_vertices.clear();
     // Don't delete it, since it's handled by the ParticleEffectDef
     _system_def = 0;
 }
 
+
 void ParticleSystem::_UpdateParticles(float t, const EffectParameters &params)
 {
-    for(int j = 0; j < _num_particles; ++j) {
-        // calculate a time for the particle from 0 to 1 since this is what
-        // the keyframes are based on
-        float scaled_time = _particles[j].time / _particles[j].lifetime;
-
-        // figure out which keyframe we're on
-        if(_particles[j].next_keyframe) {
-            ParticleKeyframe *old_next = _particles[j].next_keyframe;
-
-            // check if we need to advance the keyframe
-            if(scaled_time >= _particles[j].next_keyframe->time) {
-                // figure out what keyframe we're on
-                size_t num_keyframes = _system_def->keyframes.size();
-
-                size_t k;
-                for(k = 0; k < num_keyframes; ++k) {
-                    if(_system_def->keyframes[k].time > scaled_time) {
-                        _particles[j].current_keyframe = &_system_def->keyframes[k - 1];
-                        _particles[j].next_keyframe    = &_system_def->keyframes[k];
-                        break;
-                    }
-                }
-
-                // if we didn't find any keyframe whose time is larger than this
-                // particle's time, then we are on the last one
-                if(k == num_keyframes) {
-                    _particles[j].current_keyframe = &_system_def->keyframes[k - 1];
-                    _particles[j].next_keyframe = NULL;
-
-                    // set all of the keyframed properties to the value stored in the last
-                    // keyframe
-                    _particles[j].color          = _particles[j].current_keyframe->color;
-                    _particles[j].rotation_speed = _particles[j].current_keyframe->rotation_speed;
-                    _particles[j].size_x         = _particles[j].current_keyframe->size_x;
-                    _particles[j].size_y         = _particles[j].current_keyframe->size_y;
-                }
-
-                // if we skipped ahead only 1 keyframe, then inherit the current variations
-                // from the next ones
-                if(_particles[j].current_keyframe == old_next) {
-                    _particles[j].current_color_variation = _particles[j].next_color_variation;
-                    _particles[j].current_rotation_speed_variation = _particles[j].current_rotation_speed_variation;
-                    _particles[j].current_size_variation_x = _particles[j].next_size_variation_x;
-                    _particles[j].current_size_variation_y = _particles[j].next_size_variation_y;
-                } else {
-                    _particles[j].current_rotation_speed_variation = RandomFloat(-_particles[j].current_keyframe->rotation_speed_variation, _particles[j].current_keyframe->rotation_speed_variation);
-                    for(int32 c = 0; c < 4; ++c)
-                        _particles[j].current_color_variation[c] = RandomFloat(-_particles[j].current_keyframe->color_variation[c], _particles[j].current_keyframe->color_variation[c]);
-                    _particles[j].current_size_variation_x = RandomFloat(-_particles[j].current_keyframe->size_variation_x, _particles[j].current_keyframe->size_variation_x);
-                    _particles[j].current_size_variation_y = RandomFloat(-_particles[j].current_keyframe->size_variation_y, _particles[j].current_keyframe->size_variation_y);
-                }
-
-                // if there is a next keyframe, generate variations for it
-                if(_particles[j].next_keyframe) {
-                    _particles[j].next_rotation_speed_variation = RandomFloat(-_particles[j].next_keyframe->rotation_speed_variation, _particles[j].next_keyframe->rotation_speed_variation);
-                    for(int32 c = 0; c < 4; ++c)
-                        _particles[j].next_color_variation[c] = RandomFloat(-_particles[j].next_keyframe->color_variation[c], _particles[j].next_keyframe->color_variation[c]);
-                    _particles[j].next_size_variation_x = RandomFloat(-_particles[j].next_keyframe->size_variation_x, _particles[j].next_keyframe->size_variation_x);
-                    _particles[j].next_size_variation_y = RandomFloat(-_particles[j].next_keyframe->size_variation_y, _particles[j].next_keyframe->size_variation_y);
-                }
-            }
-        }
-
-        // if we aren't already at the last keyframe, interpolate to figure out the
-        // current keyframed properties
-        if(_particles[j].next_keyframe) {
-            // figure out how far we are from the current to the next (0.0 to 1.0)
-            float a = (scaled_time - _particles[j].current_keyframe->time) / (_particles[j].next_keyframe->time - _particles[j].current_keyframe->time);
-
-            _particles[j].rotation_speed = Lerp(a, _particles[j].current_keyframe->rotation_speed + _particles[j].current_rotation_speed_variation, _particles[j].next_keyframe->rotation_speed + _particles[j].next_rotation_speed_variation);
-            _particles[j].size_x         = Lerp(a, _particles[j].current_keyframe->size_x + _particles[j].current_size_variation_x, _particles[j].next_keyframe->size_x + _particles[j].next_size_variation_x);
-            _particles[j].size_y         = Lerp(a, _particles[j].current_keyframe->size_y + _particles[j].current_size_variation_y, _particles[j].next_keyframe->size_y + _particles[j].next_size_variation_y);
-            _particles[j].color[0]       = Lerp(a, _particles[j].current_keyframe->color[0] + _particles[j].current_color_variation[0], _particles[j].next_keyframe->color[0] + _particles[j].next_color_variation[0]);
-            _particles[j].color[1]       = Lerp(a, _particles[j].current_keyframe->color[1] + _particles[j].current_color_variation[1], _particles[j].next_keyframe->color[1] + _particles[j].next_color_variation[1]);
-            _particles[j].color[2]       = Lerp(a, _particles[j].current_keyframe->color[2] + _particles[j].current_color_variation[2], _particles[j].next_keyframe->color[2] + _particles[j].next_color_variation[2]);
-            _particles[j].color[3]       = Lerp(a, _particles[j].current_keyframe->color[3] + _particles[j].current_color_variation[3], _particles[j].next_keyframe->color[3] + _particles[j].next_color_variation[3]);
-        }
-
-        _particles[j].rotation_angle += _particles[j].rotation_speed * _particles[j].rotation_direction * t;
-
-        float wind_velocity_x = _particles[j].wind_velocity_x;
-        float wind_velocity_y = _particles[j].wind_velocity_y;
-
-        _particles[j].combined_velocity_x = _particles[j].velocity_x + wind_velocity_x;
-        _particles[j].combined_velocity_y = _particles[j].velocity_y + wind_velocity_y;
-
-        if(_system_def->wave_motion_used && _particles[j].wave_half_amplitude > 0.0f) {
-            // find the magnitude of the wave velocity
-            float wave_speed = _particles[j].wave_half_amplitude * sinf(_particles[j].wave_length_coefficient * _particles[j].time);
-
-            // now the wave velocity is just that wave speed times the particle's tangential vector
-            float tangent_x = -_particles[j].combined_velocity_y;
-            float tangent_y = _particles[j].combined_velocity_x;
-            float speed = sqrtf(tangent_x * tangent_x + tangent_y * tangent_y);
-            tangent_x /= speed;
-            tangent_y /= speed;
-
-            float wave_velocity_x = tangent_x * wave_speed;
-            float wave_velocity_y = tangent_y * wave_speed;
-
-            _particles[j].combined_velocity_x += wave_velocity_x;
-            _particles[j].combined_velocity_y += wave_velocity_y;
-        }
+    if(_num_particles == 0)
+        return;
 
-        _particles[j].x += (_particles[j].combined_velocity_x) * t;
-        _particles[j].y += (_particles[j].combined_velocity_y) * t;
+    // advance the particles which reached their next keyframe
+    const float *time = _particles.Get(PARTICLE_STREAM_TIME);
+    const float *keyframe_end_time = _particles.Get(PARTICLE_STREAM_KEYFRAME_END_TIME);
+    for(int32 j = 0; j < _num_particles; ++j) {
+        if(time[j] >= keyframe_end_time[j])
+            _AdvanceKeyframe(j);
+    }
 
+    // interpolate to figure out the current keyframed properties
+    InterpolateProperties(_particles, _num_particles);
 
-        // client-specified acceleration (dv = a * t)
-        _particles[j].velocity_x += _particles[j].acceleration_x * t;
-        _particles[j].velocity_y += _particles[j].acceleration_y * t;
+    IntegrateRotationAndWind(_particles, _num_particles, t);
 
-        // radial acceleration: calculate unit vector from emitter center to this particle,
-        // and scale by the radial acceleration, if there is any
+    if(_system_def->wave_motion_used)
+        ApplyWaveMotion(_particles, _num_particles);
 
-        bool use_radial     = (_particles[j].radial_acceleration != 0.0f);
-        bool use_tangential = (_particles[j].tangential_acceleration != 0.0f);
+    IntegratePositions(_particles, _num_particles, t);
 
-        if(use_radial || use_tangential) {
-            // unit vector from attractor to particle
-            float attractor_to_particle_x;
-            float attractor_to_particle_y;
+    // radial and tangential accelerations, relative to the attractor which is the emitter
+    // center unless the system uses the user defined one
+    if(_system_def->radial_acceleration != 0.0f || _system_def->radial_acceleration_variation != 0.0f
+            || _system_def->tangential_acceleration != 0.0f || _system_def->tangential_acceleration_variation != 0.0f) {
+        if(_system_def->user_defined_attractor)
+            ApplyAttractor(_particles, _num_particles, t, params.attractor_x, params.attractor_y,
+                           _system_def->attractor_falloff);
+        else
+            ApplyAttractor(_particles, _num_particles, t, _system_def->emitter._center_x,
+                           _system_def->emitter._center_y, _system_def->attractor_falloff);
+    }
 
-            if(_system_def->user_defined_attractor) {
-                attractor_to_particle_x = _particles[j].x - params.attractor_x;
-                attractor_to_particle_y = _particles[j].y - params.attractor_y;
-            } else {
-                attractor_to_particle_x = _particles[j].x - _system_def->emitter._center_x;
-                attractor_to_particle_y = _particles[j].y - _system_def->emitter._center_y;
+    // damp the velocity. Without damping variation, every particle shares the same factor.
+    if(_system_def->damping_variation == 0.0f) {
+        if(_system_def->damping != 1.0f)
+            DampVelocities(_particles, _num_particles, powf(_system_def->damping, t));
+    } else {
+        const float *damping = _particles.Get(PARTICLE_STREAM_DAMPING);
+        float *velocity_x = _particles.Get(PARTICLE_STREAM_VELOCITY_X);
+        float *velocity_y = _particles.Get(PARTICLE_STREAM_VELOCITY_Y);
+        for(int32 j = 0; j < _num_particles; ++j) {
+            if(damping[j] != 1.0f) {
+                float factor = powf(damping[j], t);
+                velocity_x[j] *= factor;
+                velocity_y[j] *= factor;
             }
+        }
+    }
+}
 
-            float distance = sqrtf(attractor_to_particle_x * attractor_to_particle_x
-                                   + attractor_to_particle_y * attractor_to_particle_y);
+void ParticleSystem::_AdvanceKeyframe(int32 i)
+{
+    const std::vector<ParticleKeyframe> &keyframes = _system_def->keyframes;
+    float time = _particles.Get(PARTICLE_STREAM_TIME)[i];
+    float lifetime = _particles.Get(PARTICLE_STREAM_LIFETIME)[i];
+
+    // the particle reached its next keyframe, and possibly some of the following ones
+    int32 next = _particles.GetKeyframes()[i] + 1;
+    int32 keyframe = next;
+    while(keyframe + 1 < static_cast<int32>(keyframes.size()) && keyframes[keyframe + 1].time * lifetime <= time)
+        ++keyframe;
+
+    // if we skipped ahead only 1 keyframe, then inherit the current variations
+    // from the next ones
+    _SetKeyframe(i, keyframe, keyframe == next);
+}
 
-            if(distance != 0.0f) {
-                attractor_to_particle_x /= distance;
-                attractor_to_particle_y /= distance;
-            }
+void ParticleSystem::_SetKeyframe(int32 i, int32 keyframe, bool inherit_start)
+{
+    const std::vector<ParticleKeyframe> &keyframes = _system_def->keyframes;
+    float lifetime = _particles.Get(PARTICLE_STREAM_LIFETIME)[i];
 
-            // radial acceleration
-            if(use_radial) {
-                if(_system_def->attractor_falloff != 0.0f) {
-                    float attraction = 1.0f - _system_def->attractor_falloff * distance;
-                    if(attraction > 0.0f) {
-                        _particles[j].velocity_x += attractor_to_particle_x * _particles[j].radial_acceleration * t * attraction;
-                        _particles[j].velocity_y += attractor_to_particle_y * _particles[j].radial_acceleration * t * attraction;
-                    }
-                } else {
-                    _particles[j].velocity_x += attractor_to_particle_x * _particles[j].radial_acceleration * t;
-                    _particles[j].velocity_y += attractor_to_particle_y * _particles[j].radial_acceleration * t;
-                }
-            }
+    _particles.GetKeyframes()[i] = keyframe;
 
-            // tangential acceleration
-            if(use_tangential) {
-                // tangent vector is simply perpendicular vector
-                float tangent_x = -attractor_to_particle_y;
-                float tangent_y = attractor_to_particle_x;
+    float values[PARTICLE_PROPERTY_TOTAL];
+    float variations[PARTICLE_PROPERTY_TOTAL];
+    GetKeyframeProperties(keyframes[keyframe], values, variations);
 
-                _particles[j].velocity_x += tangent_x * _particles[j].tangential_acceleration * t;
-                _particles[j].velocity_y += tangent_y * _particles[j].tangential_acceleration * t;
-            }
-        }
-
-        // damp the velocity
-
-        if(_particles[j].damping != 1.0f) {
-            _particles[j].velocity_x *= pow(_particles[j].damping, t);
-            _particles[j].velocity_y *= pow(_particles[j].damping, t);
+    // on the last keyframe, all of the keyframed properties hold the value stored in it
+    if(keyframe + 1 >= static_cast<int32>(keyframes.size())) {
+        for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k) {
+            _particles.Get(PARTICLE_STREAM_PROPERTY + k)[i] = values[k];
+            _particles.Get(PARTICLE_STREAM_PROPERTY_START + k)[i] = values[k];
+            _particles.Get(PARTICLE_STREAM_PROPERTY_END + k)[i] = values[k];
         }
+        _particles.Get(PARTICLE_STREAM_KEYFRAME_START_TIME)[i] = 0.0f;
+        _particles.Get(PARTICLE_STREAM_KEYFRAME_END_TIME)[i] = FLT_MAX;
+        _particles.Get(PARTICLE_STREAM_KEYFRAME_INV_DURATION)[i] = 0.0f;
+        return;
+    }
 
-        _particles[j].time += t;
+    for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k) {
+        float *start = _particles.Get(PARTICLE_STREAM_PROPERTY_START + k);
+        if(inherit_start)
+            start[i] = _particles.Get(PARTICLE_STREAM_PROPERTY_END + k)[i];
+        else
+            start[i] = values[k] + _random.Float(-variations[k], variations[k]);
     }
+
+    // generate the variations of the next keyframe
+    const ParticleKeyframe &current = keyframes[keyframe];
+    const ParticleKeyframe &next = keyframes[keyframe + 1];
+    GetKeyframeProperties(next, values, variations);
+    for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k)
+        _particles.Get(PARTICLE_STREAM_PROPERTY_END + k)[i] = values[k] + _random.Float(-variations[k], variations[k]);
+
+    float duration = (next.time - current.time) * lifetime;
+    _particles.Get(PARTICLE_STREAM_KEYFRAME_START_TIME)[i] = current.time * lifetime;
+    _particles.Get(PARTICLE_STREAM_KEYFRAME_END_TIME)[i] = next.time * lifetime;
+    _particles.Get(PARTICLE_STREAM_KEYFRAME_INV_DURATION)[i] = (duration > 0.0f) ? 1.0f / duration : 0.0f;
 }
 
 
@@ -610,9 +915,12 @@ void ParticleSystem::_UpdateParticles(float t, const EffectParameters &params)
 
 void ParticleSystem::_KillParticles(int32 &num, const EffectParameters &params)
 {
+    const float *time = _particles.Get(PARTICLE_STREAM_TIME);
+    const float *lifetime = _particles.Get(PARTICLE_STREAM_LIFETIME);
+
     // check each active particle to see if it is expired
     for(int j = 0; j < _num_particles; ++j) {
-        if(_particles[j].time > _particles[j].lifetime) {
+        if(time[j] > lifetime[j]) {
             if(num > 0) {
                 // if we still have particles to emit, then instead of killing the particle,
                 // respawn it as a new one
@@ -651,7 +959,7 @@ void ParticleSystem::_EmitParticles(int32 num, const EffectParameters &params)
 
 void ParticleSystem::_MoveParticle(int32 src, int32 dest)
 {
-    _particles[dest] = _particles[src];
+    _particles.Move(src, dest);
 }
 
 
@@ -664,33 +972,36 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
 {
     const ParticleEmitter &emitter = _system_def->emitter;
 
+    float x = 0.0f;
+    float y = 0.0f;
+
     switch(emitter._shape) {
     case EMITTER_SHAPE_POINT: {
-        _particles[i].x = emitter._x;
-        _particles[i].y = emitter._y;
+        x = emitter._x;
+        y = emitter._y;
         break;
     }
     case EMITTER_SHAPE_LINE: {
-        _particles[i].x = RandomFloat(emitter._x, emitter._x2);
-        _particles[i].y = RandomFloat(emitter._y, emitter._y2);
+        x = _random.Float(emitter._x, emitter._x2);
+        y = _random.Float(emitter._y, emitter._y2);
         break;
     }
     case EMITTER_SHAPE_CIRCLE: {
-        float angle = RandomFloat(0.0f, UTILS_2PI);
-        _particles[i].x = emitter._radius * cosf(angle);
-        _particles[i].y = emitter._radius * sinf(angle);
+        float angle = _random.Float(0.0f, UTILS_2PI);
+        x = emitter._radius * cosf(angle);
+        y = emitter._radius * sinf(angle);
         // Apply offset
-        _particles[i].x += emitter._x;
-        _particles[i].y += emitter._y;
+        x += emitter._x;
+        y += emitter._y;
         break;
     }
     case EMITTER_SHAPE_ELLIPSE: {
-        float angle = RandomFloat(0.0f, UTILS_2PI);
-        _particles[i].x = emitter._x * cosf(angle);
-        _particles[i].y = emitter._y * sinf(angle);
+        float angle = _random.Float(0.0f, UTILS_2PI);
+        x = emitter._x * cosf(angle);
+        y = emitter._y * sinf(angle);
         // Apply offset
-        _particles[i].x += emitter._x2;
-        _particles[i].y += emitter._y2;
+        x += emitter._x2;
+        y += emitter._y2;
         break;
     }
     case EMITTER_SHAPE_FILLED_CIRCLE: {
@@ -701,18 +1012,17 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
         // this may need to be replaced by a speedier algorithm later on
         do {
             float half_radius = emitter._radius * 0.5f;
-            _particles[i].x = RandomFloat(-half_radius, half_radius);
-            _particles[i].y = RandomFloat(-half_radius, half_radius);
-        } while(_particles[i].x * _particles[i].x +
-                _particles[i].y * _particles[i].y > radius_squared);
+            x = _random.Float(-half_radius, half_radius);
+            y = _random.Float(-half_radius, half_radius);
+        } while(x * x + y * y > radius_squared);
         // Apply offset
-        _particles[i].x += emitter._x;
-        _particles[i].y += emitter._y;
+        x += emitter._x;
+        y += emitter._y;
         break;
     }
     case EMITTER_SHAPE_FILLED_RECTANGLE: {
-        _particles[i].x = RandomFloat(emitter._x, emitter._x2);
-        _particles[i].y = RandomFloat(emitter._y, emitter._y2);
+        x = _random.Float(emitter._x, emitter._x2);
+        y = _random.Float(emitter._y, emitter._y2);
         break;
     }
     default:
@@ -720,156 +1030,132 @@ void ParticleSystem::_RespawnParticle(int32 i, const EffectParameters &params)
     };
 
 
-    _particles[i].x += RandomFloat(-emitter._x_variation, emitter._x_variation);
-    _particles[i].y += RandomFloat(-emitter._y_variation, emitter._y_variation);
+    x += _random.Float(-emitter._x_variation, emitter._x_variation);
+    y += _random.Float(-emitter._y_variation, emitter._y_variation);
 
     if(params.orientation != 0.0f)
-        RotatePoint(_particles[i].x, _particles[i].y, params.orientation);
-
-    _particles[i].color = _system_def->keyframes[0].color;
+        RotatePoint(x, y, params.orientation);
 
-    _particles[i].rotation_speed  = _system_def->keyframes[0].rotation_speed;
-    _particles[i].time            = 0.0f;
-    _particles[i].size_x          = _system_def->keyframes[0].size_x;
-    _particles[i].size_y          = _system_def->keyframes[0].size_y;
+    _particles.Get(PARTICLE_STREAM_X)[i] = x;
+    _particles.Get(PARTICLE_STREAM_Y)[i] = y;
+    _particles.Get(PARTICLE_STREAM_TIME)[i] = 0.0f;
 
     if(_system_def->random_initial_angle)
-        _particles[i].rotation_angle = RandomFloat(0.0f, UTILS_2PI);
+        _particles.Get(PARTICLE_STREAM_ROTATION_ANGLE)[i] = _random.Float(0.0f, UTILS_2PI);
     else
-        _particles[i].rotation_angle = 0.0f;
-
-    _particles[i].current_keyframe = &_system_def->keyframes[0];
-
-    if(_system_def->keyframes.size() > 1)
-        _particles[i].next_keyframe = &_system_def->keyframes[1];
-    else
-        _particles[i].next_keyframe = NULL;
+        _particles.Get(PARTICLE_STREAM_ROTATION_ANGLE)[i] = 0.0f;
 
     float speed = _system_def->emitter._initial_speed;
-    speed += RandomFloat(-emitter._initial_speed_variation, emitter._initial_speed_variation);
+    speed += _random.Float(-emitter._initial_speed_variation, emitter._initial_speed_variation);
 
+    float rotation_direction;
     if(_system_def->emitter._spin == EMITTER_SPIN_CLOCKWISE) {
-        _particles[i].rotation_direction = 1.0f;
+        rotation_direction = 1.0f;
     } else if(_system_def->emitter._spin == EMITTER_SPIN_COUNTERCLOCKWISE) {
-        _particles[i].rotation_direction = -1.0f;
+        rotation_direction = -1.0f;
     } else {
-        _particles[i].rotation_direction = static_cast<float>(2 * (rand() % 2)) - 1.0f;
+        rotation_direction = static_cast<float>(2 * (_random.Next() % 2)) - 1.0f;
     }
+    _particles.Get(PARTICLE_STREAM_ROTATION_DIRECTION)[i] = rotation_direction;
 
     // figure out the orientation
     float angle = 0.0f;
 
     if(emitter._omnidirectional) {
-        angle = RandomFloat(0.0f, UTILS_2PI);
+        angle = _random.Float(0.0f, UTILS_2PI);
     }
     else {
         angle = emitter._orientation + params.orientation;
 
         if(!IsFloatEqual(emitter._angle_variation, 0.0f))
-            angle += RandomFloat(-emitter._angle_variation, emitter._angle_variation);
+            angle += _random.Float(-emitter._angle_variation, emitter._angle_variation);
     }
 
-    _particles[i].velocity_x = speed * cosf(angle);
-    _particles[i].velocity_y = speed * sinf(angle);
-
-    // figure out property variations
-
-    _particles[i].current_size_variation_x  = RandomFloat(-_system_def->keyframes[0].size_variation_x,
-            _system_def->keyframes[0].size_variation_x);
-    _particles[i].current_size_variation_y  = RandomFloat(-_system_def->keyframes[0].size_variation_y,
-            _system_def->keyframes[0].size_variation_y);
+    _particles.Get(PARTICLE_STREAM_VELOCITY_X)[i] = speed * cosf(angle);
+    _particles.Get(PARTICLE_STREAM_VELOCITY_Y)[i] = speed * sinf(angle);
 
-    for(int32 j = 0; j < 4; ++j) {
-        _particles[i].current_color_variation[j] = RandomFloat(-_system_def->keyframes[0].color_variation[j],
-                _system_def->keyframes[0].color_variation[j]);
-    }
-
-    _particles[i].current_rotation_speed_variation = RandomFloat(-_system_def->keyframes[0].rotation_speed_variation,
-            _system_def->keyframes[0].rotation_speed_variation);
-
-    if(_system_def->keyframes.size() > 1) {
-        // figure out the next keyframe's variations
-        _particles[i].next_size_variation_x  = RandomFloat(-_system_def->keyframes[1].size_variation_x,
-                                               _system_def->keyframes[1].size_variation_x);
-        _particles[i].next_size_variation_y  = RandomFloat(-_system_def->keyframes[1].size_variation_y,
-                                               _system_def->keyframes[1].size_variation_y);
-
-        for(int32 j = 0; j < 4; ++j) {
-            _particles[i].next_color_variation[j] = RandomFloat(-_system_def->keyframes[1].color_variation[j],
-                                                    _system_def->keyframes[1].color_variation[j]);
-        }
-
-        _particles[i].next_rotation_speed_variation = RandomFloat(-_system_def->keyframes[1].rotation_speed_variation,
-                _system_def->keyframes[1].rotation_speed_variation);
-    } else {
-        // if there's only 1 keyframe, then apply the variations now
-        for(int32 j = 0; j < 4; ++j) {
-            _particles[i].color[j] += RandomFloat(-_particles[i].current_color_variation[j],
-                                                  _particles[i].current_color_variation[j]);
-        }
-
-        _particles[i].size_x += RandomFloat(-_particles[i].current_size_variation_x,
-                                            _particles[i].current_size_variation_x);
-        _particles[i].size_y += RandomFloat(-_particles[i].current_size_variation_y,
-                                            _particles[i].current_size_variation_y);
-
-        _particles[i].rotation_speed += RandomFloat(-_particles[i].current_rotation_speed_variation,
-                                        _particles[i].current_rotation_speed_variation);
-    }
-
-    _particles[i].tangential_acceleration = _system_def->tangential_acceleration;
+    float tangential_acceleration = _system_def->tangential_acceleration;
     if(_system_def->tangential_acceleration_variation != 0.0f)
-        _particles[i].tangential_acceleration += RandomFloat(-_system_def->tangential_acceleration_variation,
-                _system_def->tangential_acceleration_variation);
+        tangential_acceleration += _random.Float(-_system_def->tangential_acceleration_variation,
+                                                 _system_def->tangential_acceleration_variation);
+    _particles.Get(PARTICLE_STREAM_TANGENTIAL_ACCELERATION)[i] = tangential_acceleration;
 
-    _particles[i].radial_acceleration = _system_def->radial_acceleration;
+    float radial_acceleration = _system_def->radial_acceleration;
     if(_system_def->radial_acceleration_variation != 0.0f)
-        _particles[i].radial_acceleration += RandomFloat(-_system_def->radial_acceleration_variation,
+        radial_acceleration += _random.Float(-_system_def->radial_acceleration_variation,
                                              _system_def->radial_acceleration_variation);
+    _particles.Get(PARTICLE_STREAM_RADIAL_ACCELERATION)[i] = radial_acceleration;
 
-    _particles[i].acceleration_x = _system_def->acceleration_x;
+    float acceleration_x = _system_def->acceleration_x;
     if(_system_def->acceleration_variation_x != 0.0f)
-        _particles[i].acceleration_x += RandomFloat(-_system_def->acceleration_variation_x,
+        acceleration_x += _random.Float(-_system_def->acceleration_variation_x,
                                         _system_def->acceleration_variation_x);
+    _particles.Get(PARTICLE_STREAM_ACCELERATION_X)[i] = acceleration_x;
 
-    _particles[i].acceleration_y = _system_def->acceleration_y;
+    float acceleration_y = _system_def->acceleration_y;
     if(_system_def->acceleration_variation_y != 0.0f)
-        _particles[i].acceleration_y += RandomFloat(-_system_def->acceleration_variation_y,
+        acceleration_y += _random.Float(-_system_def->acceleration_variation_y,
                                         _system_def->acceleration_variation_y);
+    _particles.Get(PARTICLE_STREAM_ACCELERATION_Y)[i] = acceleration_y;
 
-    _particles[i].wind_velocity_x = _system_def->wind_velocity_x;
+    float wind_velocity_x = _system_def->wind_velocity_x;
     if(_system_def->wind_velocity_variation_x != 0.0f)
-        _particles[i].wind_velocity_x += RandomFloat(-_system_def->wind_velocity_variation_x,
+        wind_velocity_x += _random.Float(-_system_def->wind_velocity_variation_x,
                                          _system_def->wind_velocity_variation_x);
+    _particles.Get(PARTICLE_STREAM_WIND_VELOCITY_X)[i] = wind_velocity_x;
 
-    _particles[i].wind_velocity_y = _system_def->wind_velocity_y;
+    float wind_velocity_y = _system_def->wind_velocity_y;
     if(_system_def->wind_velocity_variation_y != 0.0f)
-        _particles[i].wind_velocity_y += RandomFloat(-_system_def->wind_velocity_variation_y,
+        wind_velocity_y += _random.Float(-_system_def->wind_velocity_variation_y,
                                          _system_def->wind_velocity_variation_y);
+    _particles.Get(PARTICLE_STREAM_WIND_VELOCITY_Y)[i] = wind_velocity_y;
 
-    _particles[i].damping = _system_def->damping;
+    float damping = _system_def->damping;
     if(_system_def->damping_variation != 0.0f)
-        _particles[i].damping += RandomFloat(-_system_def->damping_variation,
-                                             _system_def->damping_variation);
+        damping += _random.Float(-_system_def->damping_variation,
+                                 _system_def->damping_variation);
+    _particles.Get(PARTICLE_STREAM_DAMPING)[i] = damping;
 
     if(_system_def->wave_motion_used) {
-        _particles[i].wave_length_coefficient = _system_def->wave_length;
+        float wave_length = _system_def->wave_length;
         if(_system_def->wave_length_variation != 0.0f)
-            _particles[i].wave_length_coefficient += RandomFloat(-_system_def->wave_length_variation,
-                    _system_def->wave_length_variation);
+            wave_length += _random.Float(-_system_def->wave_length_variation,
+                                         _system_def->wave_length_variation);
+        _particles.Get(PARTICLE_STREAM_WAVE_LENGTH_COEFFICIENT)[i] = UTILS_2PI / wave_length;
 
-        _particles[i].wave_length_coefficient = UTILS_2PI / _particles[i].wave_length_coefficient;
-
-        _particles[i].wave_half_amplitude = _system_def->wave_amplitude;
+        float wave_amplitude = _system_def->wave_amplitude;
         if(_system_def->wave_amplitude != 0.0f)
-            _particles[i].wave_half_amplitude += RandomFloat(-_system_def->wave_amplitude_variation,
-                                                 _system_def->wave_amplitude_variation);
-        _particles[i].wave_half_amplitude *= 0.5f;
+            wave_amplitude += _random.Float(-_system_def->wave_amplitude_variation,
+                                            _system_def->wave_amplitude_variation);
+        _particles.Get(PARTICLE_STREAM_WAVE_HALF_AMPLITUDE)[i] = wave_amplitude * 0.5f;
     }
 
-    _particles[i].lifetime = _system_def->particle_lifetime
-                             + RandomFloat(-_system_def->particle_lifetime_variation,
-                                           _system_def->particle_lifetime_variation);
+    _particles.Get(PARTICLE_STREAM_LIFETIME)[i] = _system_def->particle_lifetime
+                                                  + _random.Float(-_system_def->particle_lifetime_variation,
+                                                                  _system_def->particle_lifetime_variation);
+
+    // figure out the keyframed properties, once the lifetime is known since the
+    // keyframe times are relative to it
+    _SetKeyframe(i, 0, false);
+
+    if(_system_def->keyframes.size() > 1) {
+        // until the next update, the particle is shown with its first keyframe values
+        for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k)
+            _particles.Get(PARTICLE_STREAM_PROPERTY + k)[i] = _particles.Get(PARTICLE_STREAM_PROPERTY_START + k)[i];
+    } else {
+        // if there's only 1 keyframe, then apply the variations now
+        float values[PARTICLE_PROPERTY_TOTAL];
+        float variations[PARTICLE_PROPERTY_TOTAL];
+        GetKeyframeProperties(_system_def->keyframes[0], values, variations);
+
+        for(uint32 k = 0; k < PARTICLE_PROPERTY_TOTAL; ++k) {
+            float variation = _random.Float(-variations[k], variations[k]);
+            float value = values[k] + _random.Float(-variation, variation);
+            _particles.Get(PARTICLE_STREAM_PROPERTY + k)[i] = value;
+            _particles.Get(PARTICLE_STREAM_PROPERTY_START + k)[i] = value;
+            _particles.Get(PARTICLE_STREAM_PROPERTY_END + k)[i] = value;
+        }
+    }
 }
 
 }  // namespace vt_mode_manager
@@ -35,6 +35,8 @@
 
 #include "engine/video/image.h"
 
+#include "utils/utils_random.h"
+
 namespace vt_mode_manager
 {
 
@@ -285,10 +287,13 @@ class ParticleSystem
 public:
     /*!
      * \brief Constructor
+     * \param sys_def particle definition to base the system off of
+     * \param load_images whether the animation frames should be loaded. Without them,
+     *        the system can be updated and its vertices generated, but it can't be drawn.
      */
-    ParticleSystem(ParticleSystemDef *sys_def) {
+    ParticleSystem(ParticleSystemDef *sys_def, bool load_images = true) {
         _Destroy();
-        _Create(sys_def);
+        _Create(sys_def, load_images);
     }
 
     ~ParticleSystem() {
@@ -298,6 +303,12 @@ public:
     //! \brief draws the system
     void Draw();
 
+    /*!
+     * \brief fills the vertex, color and texture coordinate arrays from the particles
+     *        of the current frame. This is called by Draw(), and doesn't use OpenGL.
+     */
+    void GenerateVertices();
+
     /*!
      * \brief updates the system
      * \param frame_time the current frame time
@@ -349,9 +360,10 @@ private:
      *  \brief initializes this particle system as an instance of the
      *         type of particle system specified by the ParticleSystemDef
      * \param sys_def particle definition to base the system off of
+     * \param load_images whether the animation frames should be loaded
      * \return success/failure
      */
-    bool _Create(ParticleSystemDef *sys_def);
+    bool _Create(ParticleSystemDef *sys_def, bool load_images);
 
     /*!
      *  \brief destroys the system
@@ -403,6 +415,34 @@ private:
      */
     void _RespawnParticle(int32 i, const EffectParameters &params);
 
+    /*!
+     *  \brief moves the particle to the last keyframe its time has reached,
+     *         once it has reached the end time of its current keyframe
+     * \param i index of the particle
+     */
+    void _AdvanceKeyframe(int32 i);
+
+    /*!
+     *  \brief sets the current keyframe of a particle, and the values its keyframed
+     *         properties are interpolated from and to until the next keyframe
+     * \param i index of the particle
+     * \param keyframe index of the keyframe in the system definition
+     * \param inherit_start if true, the values at the current keyframe are the ones the
+     *        particle had for its previous next keyframe, variations included
+     */
+    void _SetKeyframe(int32 i, int32 keyframe, bool inherit_start);
+
+    /*!
+     *  \brief fills the color array from the particle colors
+     * \param factor the factor applied to the red, green and blue components
+     */
+    void _GenerateColors(float factor);
+
+    /*!
+     *  \brief fills the texture coordinate array with the same coordinates for every particle
+     */
+    void _GenerateTexCoords(float u1, float v1, float u2, float v2);
+
     //! The system definition, contains information like the emitter properties, lifetime of
     //! particles, particle keyframes, etc. Basically everything which isn't instance-specific
     //! Note that this pointer shouldn't be deleted by the particle system, since it's handled by
@@ -422,9 +462,20 @@ private:
     std::vector<vt_video::Color> _particle_colors;
     std::vector<ParticleTexCoord> _particle_texcoords;
 
-    //! This array holds everything except positions and colors. The reason we keep positions and
-    //! colors separate is so that they can be efficiently fed to OpenGL for rendering.
-    std::vector<Particle> _particles;
+    //! The particle properties, one stream per property. The vertex arrays are kept separate
+    //! so that they can be efficiently fed to OpenGL for rendering.
+    ParticleStreams _particles;
+
+    //! Scratch streams holding the rotated half width and half height vectors of each particle
+    //! quad, used when generating the vertices of rotated particles
+    std::vector<float> _quad_width_x;
+    std::vector<float> _quad_width_y;
+    std::vector<float> _quad_height_x;
+    std::vector<float> _quad_height_y;
+
+    //! The random number generator of this system. Each system having its own, the systems
+    //! can be updated by different threads, and still draw the same numbers from a given seed.
+    vt_utils::RandomGenerator _random;
 
     //! if stopped is true, no new particles should be emitted
     bool _stopped;
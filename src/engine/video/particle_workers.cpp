@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    particle_workers.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the jobs updating the particle systems.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "engine/video/particle_workers.h"
+
+#include "engine/video/particle_effect.h"
+
+#include "engine/system.h"
+
+using namespace vt_system;
+
+namespace vt_mode_manager
+{
+
+//! \brief Updates a particle system, along with the parameters of its effect.
+class ParticleSystemJob : public Job
+{
+public:
+    ParticleSystemJob(ParticleSystem *system, const EffectParameters &parameters, float frame_time) :
+        Job(JOB_TYPE_PARTICLES),
+        _system(system),
+        _parameters(parameters),
+        _frame_time(frame_time)
+    {}
+
+    void Run() {
+        _system->Update(_frame_time, _parameters);
+    }
+
+private:
+    ParticleSystem *_system;
+
+    EffectParameters _parameters;
+
+    //! \brief The time elapsed since the last update, in seconds.
+    float _frame_time;
+};
+
+void ParticleWorkers::UpdateEffects(const std::vector<ParticleEffect *> &effects, float frame_time)
+{
+    JobSystem &job_system = SystemManager->GetJobSystem();
+
+    std::vector<ParticleEffect *> updated_effects;
+    for(std::vector<ParticleEffect *>::const_iterator it = effects.begin(); it != effects.end(); ++it) {
+        ParticleEffect *effect = *it;
+
+        EffectParameters parameters;
+        if(!effect->_PrepareUpdate(frame_time, parameters))
+            continue;
+        updated_effects.push_back(effect);
+
+        for(std::vector<ParticleSystem>::iterator it_system = effect->_systems.begin();
+                it_system != effect->_systems.end(); ++it_system) {
+            _jobs.push_back(job_system.Submit(new ParticleSystemJob(&(*it_system), parameters, frame_time)));
+        }
+    }
+
+    // The main thread runs the jobs left meanwhile.
+    for(uint32 i = 0; i < _jobs.size(); ++i)
+        job_system.Wait(_jobs[i]);
+    _jobs.clear();
+
+    for(uint32 i = 0; i < updated_effects.size(); ++i)
+        updated_effects[i]->_FinishUpdate();
+}
+
+uint32 ParticleWorkers::GetNumberWorkers() const
+{
+    return SystemManager->GetJobSystem().GetNumberWorkers();
+}
+
+} // namespace vt_mode_manager
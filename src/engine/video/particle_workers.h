@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    particle_workers.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the jobs updating the particle systems.
+***
+*** The particle systems of the effects don't share any state while they are
+*** updated, so each of them is a job that any worker thread can run. The
+*** main thread runs jobs as well, and waits for all of them to be done
+*** before returning, so that the particles can be drawn right away.
+*** ***************************************************************************/
+
+#ifndef __PARTICLE_WORKERS_HEADER__
+#define __PARTICLE_WORKERS_HEADER__
+
+#include "engine/video/particle_system.h"
+#include "engine/job_system.h"
+
+namespace vt_mode_manager
+{
+
+class ParticleEffect;
+
+/** ****************************************************************************
+*** \brief Updates the particle systems of several effects on the worker threads
+***
+*** Each particle system is submitted as a job to the job system of the system
+*** engine, which spawns its worker threads on the first update.
+***
+*** \note Each particle system draws its random numbers from its own
+*** generator, so the simulation doesn't depend on which thread updates
+*** which system.
+*** ***************************************************************************/
+class ParticleWorkers
+{
+public:
+    /** \brief Updates the given effects, and returns once all of their systems are updated
+    *** \param effects The effects to update
+    *** \param frame_time The time elapsed since the last update, in seconds
+    *** \note Must be called from the main thread only.
+    **/
+    void UpdateEffects(const std::vector<ParticleEffect *> &effects, float frame_time);
+
+    //! \brief Returns the number of worker threads, the main thread excluded.
+    uint32 GetNumberWorkers() const;
+
+private:
+    //! \brief The jobs of the current update.
+    std::vector<vt_system::JobHandle> _jobs;
+}; // class ParticleWorkers
+
+} // namespace vt_mode_manager
+
+#endif // __PARTICLE_WORKERS_HEADER__
@@ -49,6 +49,9 @@ public:
     void Set(int32 l, int32 t, int32 w, int32 h)
     { left = l; top = t; width = w; height = h; }
 
+    bool operator==(const ScreenRect &rect) const
+    { return left == rect.left && top == rect.top && width == rect.width && height == rect.height; }
+
 
     /** \brief Modifies the rectangle coordinates to be an intersection of itself with another rectangle
     *** \param rect The rectangle to intersect this rectangle with
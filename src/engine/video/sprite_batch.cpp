@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    sprite_batch.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the sprite batch used to draw images.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "sprite_batch.h"
+
+#include "video.h"
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+// -----------------------------------------------------------------------------
+// Transform2D class
+// -----------------------------------------------------------------------------
+
+void Transform2D::Rotate(float angle)
+{
+    float radians = angle * vt_utils::UTILS_PI / 180.0f;
+    float cos_angle = cosf(radians);
+    float sin_angle = sinf(radians);
+
+    float new_a = a * cos_angle + c * sin_angle;
+    float new_b = b * cos_angle + d * sin_angle;
+    c = c * cos_angle - a * sin_angle;
+    d = d * cos_angle - b * sin_angle;
+    a = new_a;
+    b = new_b;
+}
+
+// -----------------------------------------------------------------------------
+// SpriteBatch class
+// -----------------------------------------------------------------------------
+
+SpriteBatch::SpriteBatch() :
+    _sheet(NULL),
+    _smooth(false),
+    _blend(SPRITE_BLEND_NONE),
+    _num_pending_quads(0),
+    _flush_count(0),
+    _quad_count(0),
+    _last_frame_flush_count(0),
+    _last_frame_quad_count(0)
+{}
+
+
+
+void SpriteBatch::AddQuad(TexSheet *sheet, bool smooth, int32 blend, const Transform2D &transform,
+                          const float vertices[8], const float tex_coords[8], const Color colors[4])
+{
+    // The smoothing flag only matters for textured quads.
+    if(sheet == NULL)
+        smooth = false;
+
+    if(_num_pending_quads > 0 && (sheet != _sheet || smooth != _smooth || blend != _blend))
+        Flush();
+
+    _sheet = sheet;
+    _smooth = smooth;
+    _blend = blend;
+
+    for(uint32 i = 0; i < 4; ++i) {
+        float x = vertices[i * 2];
+        float y = vertices[i * 2 + 1];
+        _vertices.push_back(transform.a * x + transform.c * y + transform.tx);
+        _vertices.push_back(transform.b * x + transform.d * y + transform.ty);
+
+        if(sheet != NULL) {
+            _tex_coords.push_back(tex_coords[i * 2]);
+            _tex_coords.push_back(tex_coords[i * 2 + 1]);
+        }
+
+        const float *color = colors[i].GetColors();
+        _colors.insert(_colors.end(), color, color + 4);
+    }
+
+    ++_num_pending_quads;
+}
+
+
+
+void SpriteBatch::Flush()
+{
+    if(_num_pending_quads == 0)
+        return;
+
+    // Without a display, the quads are only counted.
+    if(!VIDEO_HEADLESS)
+        _DrawQuads();
+
+    ++_flush_count;
+    _quad_count += _num_pending_quads;
+
+    _num_pending_quads = 0;
+    _vertices.clear();
+    _tex_coords.clear();
+    _colors.clear();
+}
+
+
+
+void SpriteBatch::_DrawQuads()
+{
+    switch(_blend) {
+    case SPRITE_BLEND_NORMAL:
+        VideoManager->EnableBlending();
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case SPRITE_BLEND_ADDITIVE:
+        VideoManager->EnableBlending();
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+        break;
+    default:
+        VideoManager->DisableBlending();
+        break;
+    }
+
+    if(_sheet != NULL) {
+        VideoManager->EnableTexture2D();
+        TextureManager->_BindTexture(_sheet->tex_id);
+        _sheet->Smooth(_smooth);
+
+        VideoManager->EnableTextureCoordArray();
+        glTexCoordPointer(2, GL_FLOAT, 0, &_tex_coords[0]);
+    } else {
+        VideoManager->DisableTexture2D();
+    }
+
+    VideoManager->EnableVertexArray();
+    glVertexPointer(2, GL_FLOAT, 0, &_vertices[0]);
+    VideoManager->EnableColorArray();
+    glColorPointer(4, GL_FLOAT, 0, &_colors[0]);
+
+    // The vertices are already transformed.
+    glPushMatrix();
+    glLoadIdentity();
+    glDrawArrays(GL_QUADS, 0, _num_pending_quads * 4);
+    glPopMatrix();
+
+    // The arrays aren't valid anymore once cleared.
+    VideoManager->DisableColorArray();
+}
+
+
+
+void SpriteBatch::EndFrame()
+{
+    _last_frame_flush_count = _flush_count;
+    _last_frame_quad_count = _quad_count;
+    _flush_count = 0;
+    _quad_count = 0;
+}
+
+} // namespace private_video
+
+} // namespace vt_video
@@ -0,0 +1,172 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    sprite_batch.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the sprite batch used to draw images.
+***
+*** Instead of issuing a draw call per image, the image quads are transformed
+*** on the CPU side and gathered as long as they share the same texture sheet
+*** and blending state. They are sent to OpenGL in a single call when that
+*** state changes, or when something else needs to draw.
+*** ***************************************************************************/
+
+#ifndef __SPRITE_BATCH_HEADER__
+#define __SPRITE_BATCH_HEADER__
+
+#include "engine/video/color.h"
+
+namespace vt_video
+{
+
+namespace private_video
+{
+
+class TexSheet;
+
+/** ****************************************************************************
+*** \brief The 2D part of the modelview transformation, mirrored on the CPU side
+***
+*** The video engine only ever translates, scales and rotates around the z axis,
+*** so the transformation is kept as a 2x3 affine matrix. Each method applies
+*** the transformation the same way as its OpenGL counterpart does.
+*** ***************************************************************************/
+class Transform2D
+{
+public:
+    Transform2D()
+    {
+        SetIdentity();
+    }
+
+    void SetIdentity() {
+        a = 1.0f;
+        b = 0.0f;
+        c = 0.0f;
+        d = 1.0f;
+        tx = 0.0f;
+        ty = 0.0f;
+    }
+
+    //! \brief Same as glTranslatef(x, y, 0).
+    void Translate(float x, float y) {
+        tx += a * x + c * y;
+        ty += b * x + d * y;
+    }
+
+    //! \brief Same as glScalef(x, y, 1).
+    void Scale(float x, float y) {
+        a *= x;
+        b *= x;
+        c *= y;
+        d *= y;
+    }
+
+    //! \brief Same as glRotatef(angle, 0, 0, 1), the angle being in degrees.
+    void Rotate(float angle);
+
+    //! \brief Sets the transformation from the 2D part of a column-major 4x4 OpenGL matrix.
+    void SetMatrix(const float matrix[16]) {
+        a = matrix[0];
+        b = matrix[1];
+        c = matrix[4];
+        d = matrix[5];
+        tx = matrix[12];
+        ty = matrix[13];
+    }
+
+    //! \brief The transformation coefficients, so that x' = a * x + c * y + tx and y' = b * x + d * y + ty.
+    float a, b, c, d, tx, ty;
+}; // class Transform2D
+
+//! \brief The blending modes of the batched quads.
+enum SPRITE_BLEND_MODE {
+    SPRITE_BLEND_NONE = 0,
+    SPRITE_BLEND_NORMAL = 1,
+    SPRITE_BLEND_ADDITIVE = 2
+};
+
+/** ****************************************************************************
+*** \brief Gathers image quads sharing the same draw state into a single draw call
+***
+*** The quads vertices are transformed on the CPU side when they are added,
+*** so the batch can be drawn at once with an identity modelview matrix.
+***
+*** \note Anything else drawing through OpenGL must first call
+*** VideoEngine::FlushSpriteBatch(), so that the quads are drawn in order.
+*** ***************************************************************************/
+class SpriteBatch
+{
+public:
+    SpriteBatch();
+
+    /** \brief Adds a quad to the batch, flushing the previous quads if their draw state differs
+    *** \param sheet The texture sheet to use, or NULL for an untextured quad
+    *** \param smooth Whether the texture sheet should use linear filtering
+    *** \param blend The blending mode, one of the SPRITE_BLEND_MODE values
+    *** \param transform The modelview transformation to apply to the vertices
+    *** \param vertices The 4 vertices (x, y) of the quad
+    *** \param tex_coords The 4 texture coordinates (s, t) of the quad, ignored when there is no sheet
+    *** \param colors The 4 vertices colors
+    **/
+    void AddQuad(TexSheet *sheet, bool smooth, int32 blend, const Transform2D &transform,
+                 const float vertices[8], const float tex_coords[8], const Color colors[4]);
+
+    //! \brief Draws the pending quads, if any.
+    void Flush();
+
+    bool IsEmpty() const {
+        return _num_pending_quads == 0;
+    }
+
+    //! \brief Saves the current frame counters as the last frame ones, and resets them.
+    void EndFrame();
+
+    //! \brief Returns the number of draw calls done by the batch during the last frame.
+    uint32 GetLastFrameFlushCount() const {
+        return _last_frame_flush_count;
+    }
+
+    //! \brief Returns the number of quads drawn by the batch during the last frame.
+    uint32 GetLastFrameQuadCount() const {
+        return _last_frame_quad_count;
+    }
+
+private:
+    //! \brief The draw state shared by the pending quads.
+    TexSheet *_sheet;
+    bool _smooth;
+    int32 _blend;
+
+    //! \brief The number of quads waiting to be drawn.
+    uint32 _num_pending_quads;
+
+    //! \brief The pending quads vertices, texture coordinates and colors.
+    std::vector<float> _vertices;
+    std::vector<float> _tex_coords;
+    std::vector<float> _colors;
+
+    //! \brief The current frame counters.
+    uint32 _flush_count;
+    uint32 _quad_count;
+
+    //! \brief The last frame counters.
+    uint32 _last_frame_flush_count;
+    uint32 _last_frame_quad_count;
+
+    //! \brief Gives the pending quads to OpenGL.
+    void _DrawQuads();
+}; // class SpriteBatch
+
+} // namespace private_video
+
+} // namespace vt_video
+
+#endif // __SPRITE_BATCH_HEADER__
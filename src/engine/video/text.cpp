@@ -45,6 +45,42 @@ TextSupervisor *TextManager = NULL;
 const uint16 NEW_LINE = '\n';
 const uint16 SPACE_CHAR = 0x20;
 
+// The size of the glyph atlas textures, in pixels.
+static const int32 GLYPH_ATLAS_SIZE = 512;
+
+// -----------------------------------------------------------------------------
+// FontProperties class
+// -----------------------------------------------------------------------------
+
+void FontProperties::ClearFont()
+{
+    // Free the font.
+    if(ttf_font)
+        TTF_CloseFont(ttf_font);
+    ttf_font = NULL;
+
+    // Clears the glyph cache and delete it
+    if(glyph_cache) {
+        std::vector<vt_video::FontGlyph *>::const_iterator it_end = glyph_cache->end();
+        for(std::vector<FontGlyph *>::iterator j = glyph_cache->begin(); j != it_end; ++j) {
+            delete *j;
+        }
+        delete glyph_cache;
+    }
+    glyph_cache = NULL;
+
+    // Free the glyph atlas textures
+    for(uint32 i = 0; i < atlas_pages.size(); ++i) {
+        if(atlas_pages[i].texture != 0 && atlas_pages[i].texture != INVALID_TEXTURE_ID)
+            TextureManager->_DeleteTexture(atlas_pages[i].texture);
+    }
+    atlas_pages.clear();
+    kerning_cache.clear();
+
+    // The text laid out with this font must be laid out again.
+    ++generation;
+}
+
 // -----------------------------------------------------------------------------
 // TextStyle class
 // -----------------------------------------------------------------------------
@@ -210,79 +246,30 @@ static const uint32 AMASK = 0xFF000000;
 #endif
 
 // -----------------------------------------------------------------------------
-// TextTexture class
+// GlyphAtlasPage class
 // -----------------------------------------------------------------------------
 
-TextTexture::TextTexture(const vt_utils::ustring &string_, const TextStyle &style_) :
-    BaseTexture(),
-    string(string_),
-    style(style_)
+bool GlyphAtlasPage::Allocate(int32 width, int32 height, int32 &x, int32 &y)
 {
-    // Enable image smoothing for text
-    smooth = true;
-}
-
-
-
-TextTexture::~TextTexture()
-{
-    // Remove this instance from the texture manager
-    TextureManager->_UnregisterTextTexture(this);
-}
-
-
-
-bool TextTexture::Regenerate()
-{
-    if(texture_sheet) {
-        texture_sheet->RemoveTexture(this);
-        TextureManager->_RemoveSheet(texture_sheet);
-        texture_sheet = NULL;
+    // Keep a pixel of padding on the right and bottom of each glyph.
+    int32 padded_width = width + 1;
+    int32 padded_height = height + 1;
+
+    // Start a new shelf when the current one is full.
+    if(_shelf_x + padded_width > GLYPH_ATLAS_SIZE) {
+        _shelf_y += _shelf_height;
+        _shelf_x = 1;
+        _shelf_height = 0;
     }
 
-    ImageMemory buffer;
-    if(TextManager->_RenderText(string, style, buffer) == false)
-        return false;
-
-    width = buffer.width;
-    height = buffer.height;
-
-    TexSheet *sheet = TextureManager->_InsertImageInTexSheet(this, buffer, true);
-    if(sheet == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TextureManager::_InsertImageInTexSheet() returned NULL" << std::endl;
-        free(buffer.pixels);
-        buffer.pixels = NULL;
+    if(_shelf_x + padded_width > GLYPH_ATLAS_SIZE || _shelf_y + padded_height > GLYPH_ATLAS_SIZE)
         return false;
-    }
-
-    texture_sheet = sheet;
-    free(buffer.pixels);
-    buffer.pixels = NULL;
 
-    return true;
-}
-
-
-
-bool TextTexture::Reload()
-{
-    // Regenerate text image if it is not already loaded in a texture sheet
-    if(texture_sheet == NULL)
-        return Regenerate();
-
-    ImageMemory buffer;
-    if(TextManager->_RenderText(string, style, buffer) == false)
-        return false;
-
-    if(texture_sheet->CopyRect(x, y, buffer) == false) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TextureSheet::CopyRect() failed" << std::endl;
-        free(buffer.pixels);
-        buffer.pixels = NULL;
-        return false;
-    }
-
-    free(buffer.pixels);
-    buffer.pixels = NULL;
+    x = _shelf_x;
+    y = _shelf_y;
+    _shelf_x += padded_width;
+    if(padded_height > _shelf_height)
+        _shelf_height = padded_height;
     return true;
 }
 
@@ -292,20 +279,12 @@ bool TextTexture::Reload()
 
 TextElement::TextElement() :
     ImageDescriptor(),
-    text_texture(NULL)
+    _font_properties(NULL),
+    _font_generation(0)
 {}
 
 
 
-TextElement::TextElement(TextTexture *texture) :
-    ImageDescriptor(),
-    text_texture(texture)
-{
-    SetTexture(texture);
-}
-
-
-
 TextElement::~TextElement()
 {
     Clear();
@@ -315,8 +294,12 @@ TextElement::~TextElement()
 
 void TextElement::Clear()
 {
-    ImageDescriptor::Clear(); // This call will remove the texture reference for us
-    text_texture = NULL;
+    ImageDescriptor::Clear();
+    _text.clear();
+    _font_properties = NULL;
+    _vertices.clear();
+    _tex_coords.clear();
+    _quad_ranges.clear();
 }
 
 
@@ -329,22 +312,61 @@ void TextElement::Draw() const
 void TextElement::Draw(const Color &draw_color) const
 {
     // Don't draw anything if this image is completely transparent (invisible)
-    if(IsFloatEqual(draw_color[3], 0.0f))
+    if(IsFloatEqual(draw_color[3], 0.0f) || _font_properties == NULL)
+        return;
+
+    // Lay the text out again when its font was changed, along with its dimensions.
+    if(_font_generation != _font_properties->generation)
+        const_cast<TextElement *>(this)->_UpdateLayout();
+
+    if(_quad_ranges.empty() || IsFloatEqual(_width, 0.0f) || IsFloatEqual(_height, 0.0f))
         return;
 
     VideoManager->PushMatrix();
     _DrawOrientation();
 
-    if(draw_color == Color::white) {
-        _DrawTexture(_color);
-    } else {
-        Color modulated_colors[4];
-        modulated_colors[0] = _color[0] * draw_color;
-        modulated_colors[1] = _color[1] * draw_color;
-        modulated_colors[2] = _color[2] * draw_color;
-        modulated_colors[3] = _color[3] * draw_color;
+    // Go from the normalized image space, where y goes up from the line bottom,
+    // to the line pixels, where y goes down from the line top.
+    // The flip flags mirror the whole line, as ImageDescriptor::_DrawTexture() does with the texture coordinates.
+    const Context &current_context = VideoManager->_current_context;
+    float x_origin = current_context.x_flip ? 1.0f : 0.0f;
+    float y_origin = current_context.y_flip ? 0.0f : 1.0f;
+    float x_scale = current_context.x_flip ? -1.0f / _width : 1.0f / _width;
+    float y_scale = current_context.y_flip ? 1.0f / _height : -1.0f / _height;
+    if(!VIDEO_HEADLESS)
+        glTranslatef(x_origin, y_origin, 0.0f);
+    VideoManager->Scale(x_scale, y_scale);
+
+    // The glyphs are drawn directly, so draw the pending images first
+    VideoManager->FlushSpriteBatch();
+
+    if(VIDEO_HEADLESS) {
+        VideoManager->PopMatrix();
+        return;
+    }
+
+    // The glyphs always need blending
+    VideoManager->EnableBlending();
+    if(current_context.blend && current_context.blend != 1)
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE); // Additive blending
+    else
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
+
+    VideoManager->EnableTexture2D();
+    VideoManager->EnableVertexArray();
+    VideoManager->EnableTextureCoordArray();
+    VideoManager->DisableColorArray();
 
-        _DrawTexture(modulated_colors);
+    Color color = _color[0] * draw_color;
+    glColor4fv((GLfloat *)color.GetColors());
+
+    glVertexPointer(2, GL_FLOAT, 0, &_vertices[0]);
+    glTexCoordPointer(2, GL_FLOAT, 0, &_tex_coords[0]);
+
+    for(uint32 i = 0; i < _quad_ranges.size(); ++i) {
+        const QuadRange &range = _quad_ranges[i];
+        TextureManager->_BindTexture(_font_properties->atlas_pages[range.page].texture);
+        glDrawArrays(GL_QUADS, range.first_quad * 4, range.num_quads * 4);
     }
 
     VideoManager->PopMatrix();
@@ -352,36 +374,125 @@ void TextElement::Draw(const Color &draw_color) const
 
 
 
-void TextElement::SetTexture(TextTexture *texture)
+void TextElement::SetText(const ustring &text, FontProperties *font_properties)
+{
+    _text = text;
+    _font_properties = font_properties;
+    _UpdateLayout();
+}
+
+
+
+void TextElement::_UpdateLayout()
 {
-    // Do nothing if the texture pointer is not going to change
-    if(text_texture == texture) {
+    int32 width = 0;
+    int32 height = 0;
+    _LayoutText(width, height);
+    _width = static_cast<float>(width);
+    _height = static_cast<float>(height);
+}
+
+
+
+void TextElement::_LayoutText(int32 &width, int32 &height) const
+{
+    _vertices.clear();
+    _tex_coords.clear();
+    _quad_ranges.clear();
+    width = 0;
+    height = 0;
+
+    FontProperties *fp = _font_properties;
+    if(fp == NULL || fp->ttf_font == NULL || _text.empty())
         return;
+
+    _font_generation = fp->generation;
+    TextManager->_CacheGlyphs(_text.c_str(), fp);
+
+    // Compute the line extents first, as the glyphs may go above the line top,
+    // or left of the line start.
+    int32 min_y = 0;
+    int32 line_start_x = 0;
+    int32 line_end_x = 0;
+    int32 xpos = 0;
+    uint16 previous = 0;
+    for(const uint16 *char_ptr = _text.c_str(); *char_ptr != 0; ++char_ptr) {
+        // Skip the glyphs which couldn't be cached
+        if(*char_ptr >= fp->glyph_cache->size() || (*fp->glyph_cache)[*char_ptr] == NULL)
+            continue;
+        FontGlyph *glyph = (*fp->glyph_cache)[*char_ptr];
+
+        xpos += TextManager->_GetKerning(previous, *char_ptr, fp);
+        previous = *char_ptr;
+
+        if(glyph->top_y < min_y)
+            min_y = glyph->top_y;
+        if(xpos + glyph->min_x < line_start_x)
+            line_start_x = xpos + glyph->min_x;
+        if(xpos + glyph->min_x + glyph->width > line_end_x)
+            line_end_x = xpos + glyph->min_x + glyph->width;
+
+        xpos += glyph->advance;
     }
+    if(xpos > line_end_x)
+        line_end_x = xpos;
+
+    // Subtract one pixel from the minimum y value, as the rendered glyphs may overlap it.
+    min_y -= 1;
 
-    // Remove references and possibly delete the existing texture
-    if(text_texture != NULL) {
-        _RemoveTextureReference();
+    width = line_end_x - line_start_x;
+    height = fp->height - min_y;
 
-        text_texture = NULL;
-        _texture = NULL;
+    // Then place a quad for each visible glyph, grouped by atlas page.
+    std::vector<std::vector<float> > page_vertices(fp->atlas_pages.size());
+    std::vector<std::vector<float> > page_tex_coords(fp->atlas_pages.size());
+
+    xpos = -line_start_x;
+    int32 ypos = -min_y;
+    previous = 0;
+    for(const uint16 *char_ptr = _text.c_str(); *char_ptr != 0; ++char_ptr) {
+        // Skip the glyphs which couldn't be cached
+        if(*char_ptr >= fp->glyph_cache->size() || (*fp->glyph_cache)[*char_ptr] == NULL)
+            continue;
+        FontGlyph *glyph = (*fp->glyph_cache)[*char_ptr];
+
+        xpos += TextManager->_GetKerning(previous, *char_ptr, fp);
+        previous = *char_ptr;
+
+        if(glyph->width > 0 && glyph->height > 0) {
+            float left = static_cast<float>(xpos + glyph->min_x);
+            float top = static_cast<float>(ypos + glyph->top_y);
+            float right = left + static_cast<float>(glyph->width);
+            float bottom = top + static_cast<float>(glyph->height);
+
+            // Same vertex order as ImageDescriptor::_DrawTexture(), starting from the bottom-left corner.
+            const float vertices[] = { left, bottom, right, bottom, right, top, left, top };
+            const float tex_coords[] = { glyph->u1, glyph->v2, glyph->u2, glyph->v2,
+                                         glyph->u2, glyph->v1, glyph->u1, glyph->v1 };
+
+            std::vector<float> &quad_vertices = page_vertices[glyph->page];
+            std::vector<float> &quad_tex_coords = page_tex_coords[glyph->page];
+            quad_vertices.insert(quad_vertices.end(), vertices, vertices + 8);
+            quad_tex_coords.insert(quad_tex_coords.end(), tex_coords, tex_coords + 8);
+        }
+
+        xpos += glyph->advance;
     }
 
-    // Set the new texture
-    if(texture == NULL) {
-        text_texture = NULL;
-        _texture = NULL;
-        _width = 0.0f;
-        _height = 0.0f;
-    } else {
-        texture->AddReference();
-        text_texture = texture;
-        _texture = texture;
-
-        _width = static_cast<float>(texture->width);
-        _height = static_cast<float>(texture->height);
+    for(uint32 page = 0; page < page_vertices.size(); ++page) {
+        if(page_vertices[page].empty())
+            continue;
+
+        QuadRange range;
+        range.page = page;
+        range.first_quad = _vertices.size() / 8;
+        range.num_quads = page_vertices[page].size() / 8;
+        _quad_ranges.push_back(range);
+
+        _vertices.insert(_vertices.end(), page_vertices[page].begin(), page_vertices[page].end());
+        _tex_coords.insert(_tex_coords.end(), page_tex_coords[page].begin(), page_tex_coords[page].end());
     }
-}
+} // void TextElement::_LayoutText(int32 &width, int32 &height) const
 
 } // namespace private_video
 
@@ -513,7 +624,7 @@ void TextImage::_Regenerate()
 
     std::vector<ustring> lines_array = TextManager->WrapText(_text, fp->ttf_font, _max_width);
 
-    // Iterate through each line of text and render a TextTexture for each one
+    // Iterate through each line of text and lay out a TextElement for each one
     std::vector<ustring>::iterator line_iter;
     for(line_iter = lines_array.begin(); line_iter != lines_array.end(); ++line_iter) {
 
@@ -522,20 +633,13 @@ void TextImage::_Regenerate()
         if((*line_iter) == ustring(&NEW_LINE) || (*line_iter).empty()) {
             new_element->SetDimensions(0.0f, static_cast<float>(fp->line_skip));
         }
-        // Otherwise, create a new TextTexture to be managed by the new element
+        // Otherwise, lay out the line glyphs, which are drawn from the font atlas
         else {
-            // PRINT_DEBUG << **line_iter << std::endl;
-            TextTexture *texture = new TextTexture(*line_iter, _style);
-            if(texture->Regenerate() == false) {
-                IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TextTexture::_Regenerate() failed" << std::endl;
-            }
-            TextureManager->_RegisterTextTexture(texture);
+            new_element->SetText(*line_iter, fp);
 
             // Resize the TextImage width if this line is wider than the current width
-            if(texture->width > _width)
-                _width = static_cast<float>(texture->width);
-
-            new_element->SetTexture(texture); // Automatically adds a reference to texture
+            if(new_element->GetWidth() > _width)
+                _width = new_element->GetWidth();
         }
         _text_sections.push_back(new_element);
 
@@ -811,46 +915,42 @@ void TextSupervisor::Draw(const ustring &text, const TextStyle &style)
 
     VideoManager->PushState();
 
+    // The glyph quads of each line are laid out in this element, which keeps its buffers between the calls
+    static TextElement line_element;
+
     // Break the string into lines and render the shadow and text for each line
-    uint16 buffer[2048];
     size_t last_line = 0;
-    do {
-        // Find the next new line character in the string and save the line
-        size_t next_line;
-        for(next_line = last_line; next_line < text.length(); next_line++) {
-            if(text[next_line] == NEW_LINE)
-                break;
-
-            buffer[next_line - last_line] = text[next_line];
-        }
-        buffer[next_line - last_line] = 0;
+    while(last_line < text.length()) {
+        // Find the next new line character in the string and lay out the line
+        size_t next_line = text.find(NEW_LINE, last_line);
+        if(next_line == ustring::npos)
+            next_line = text.length();
+        line_element.SetText(text.substr(last_line, next_line - last_line), fp);
         last_line = next_line + 1;
 
-        // If this line is empty, skip on to the next one
-        if(buffer[0] == 0) {
-            VideoManager->MoveRelative(0, -fp->line_skip * VideoManager->_current_context.coordinate_system.GetVerticalDirection());
-            continue;
-        }
+        // Empty lines only move the draw cursor
+        if(line_element.GetWidth() > 0.0f) {
+            // Save the draw cursor position before drawing this text
+            VideoManager->PushMatrix();
 
-        // Save the draw cursor position before drawing this text
-        VideoManager->PushMatrix();
+            // If text shadows are enabled, draw the shadow first
+            if(style.GetShadowStyle() != VIDEO_TEXT_SHADOW_NONE) {
+                VideoManager->PushMatrix();
+                const float dx = VideoManager->_current_context.coordinate_system.GetHorizontalDirection() * style.GetShadowOffsetX();
+                const float dy = VideoManager->_current_context.coordinate_system.GetVerticalDirection() * style.GetShadowOffsetY();
+                VideoManager->MoveRelative(dx, dy);
+                line_element.Draw(style.GetShadowColor());
+                VideoManager->PopMatrix();
+            }
 
-        // If text shadows are enabled, draw the shadow first
-        if(style.GetShadowStyle() != VIDEO_TEXT_SHADOW_NONE) {
-            VideoManager->PushMatrix();
-            const float dx = VideoManager->_current_context.coordinate_system.GetHorizontalDirection() * style.GetShadowOffsetX();
-            const float dy = VideoManager->_current_context.coordinate_system.GetVerticalDirection() * style.GetShadowOffsetY();
-            VideoManager->MoveRelative(dx, dy);
-            _DrawTextHelper(buffer, fp, style.GetShadowColor());
+            // Now draw the text itself, and restore the position of the draw cursor
+            line_element.Draw(style.GetColor());
             VideoManager->PopMatrix();
         }
 
-        // Now draw the text itself, restore the position of the draw cursor, and move the draw cursor one line down
-        _DrawTextHelper(buffer, fp, style.GetColor());
-        VideoManager->PopMatrix();
+        // Move the draw cursor one line down
         VideoManager->MoveRelative(0, -fp->line_skip * VideoManager->_current_context.coordinate_system.GetVerticalDirection());
-
-    } while(last_line < text.length());
+    }
 
     VideoManager->PopState();
 } // void TextSupervisor::Draw(const ustring& text)
@@ -1015,12 +1115,7 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
     if(*text == 0)
         return;
 
-    // If we can't cache a particular glyph, we fall back to this one
-    static const uint16 fall_back_glyph = '?';
-
     TTF_Font *font = fp->ttf_font;
-    int32 w, h;
-    GLuint texture;
 
     // Go through each character in the string and cache those glyphs that have not already been cached
     for(const uint16 *character_ptr = text; *character_ptr != 0; ++character_ptr) {
@@ -1035,303 +1130,236 @@ void TextSupervisor::_CacheGlyphs(const uint16 *text, FontProperties *fp)
         if(fp->glyph_cache->at(character) != 0)
             continue;
 
-        // Attempt to create the initial SDL_Surface that contains the rendered glyph
-        // We render it white so that color effects are applied correctly on it.
-        static const SDL_Color white_color = { 0xFF, 0xFF, 0xFF, 0xFF };
-        SDL_Surface* initial = TTF_RenderGlyph_Blended(font, character, white_color);
-        if(initial == NULL) {
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed, resorting to fall back glyph: '?'" << std::endl;
-            initial = TTF_RenderGlyph_Blended(font, fall_back_glyph, white_color);
-            if(initial == NULL) {
-                IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed for fall back glyph, aborting glyph caching" << std::endl;
-                return;
-            }
-        }
-
-        // Before blitting on a alpha surface, we need to disable blending on the source surface,
-        // or the alpha property of the source image will be ignored on the dest image.
-        // Note: Will be replaced by SDL_SetSurfaceBlendMode(initial, SDL_BLENDMODE_NONE); in SDL 2.0
-        SDL_SetAlpha(initial, 0, 255);
-
-        w = RoundUpPow2(initial->w + 1);
-        h = RoundUpPow2(initial->h + 1);
-
-        SDL_Surface* intermediary = SDL_CreateRGBSurface(0, w, h, 32, RMASK, GMASK, BMASK, AMASK);
-        if(intermediary == NULL) {
-            SDL_FreeSurface(initial);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_CreateRGBSurface() failed" << std::endl;
+        SDL_Surface *surface = _RenderGlyph(character, fp);
+        if(surface == NULL)
             return;
-        }
-
-
-        if(SDL_BlitSurface(initial, 0, intermediary, 0) < 0) {
-            SDL_FreeSurface(initial);
-            SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_BlitSurface() failed" << std::endl;
-            return;
-        }
-
-        glGenTextures(1, &texture);
-        TextureManager->_BindTexture(texture);
-
-
-        SDL_LockSurface(intermediary);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, 4, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, intermediary->pixels);
-        SDL_UnlockSurface(intermediary);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        if(VideoManager->CheckGLError()) {
-            SDL_FreeSurface(initial);
-            SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "an OpenGL error was detected: " << VideoManager->CreateGLErrorString() << std::endl;
-            return;
-        }
 
         int minx, maxx;
         int miny, maxy;
         int advance;
         if(TTF_GlyphMetrics(font, character, &minx, &maxx, &miny, &maxy, &advance) != 0) {
-            SDL_FreeSurface(initial);
-            SDL_FreeSurface(intermediary);
+            SDL_FreeSurface(surface);
             IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_GlyphMetrics() failed" << std::endl;
             return;
         }
 
         FontGlyph *glyph = new FontGlyph;
-        glyph->texture = texture;
         glyph->min_x = minx;
-        glyph->min_y = miny;
         glyph->top_y = fp->ascent - maxy;
-        glyph->width = initial->w + 1;
-        glyph->height = initial->h + 1;
-        glyph->max_x = static_cast<float>(initial->w + 1) / static_cast<float>(w);
-        glyph->max_y = static_cast<float>(initial->h + 1) / static_cast<float>(h);
         glyph->advance = advance;
 
+        // Glyphs without any pixels, such as spaces, don't need any room in the atlas.
+        if(surface->w > 0 && surface->h > 0) {
+            // Try the last atlas page first, and start a new one when it is full.
+            if(fp->atlas_pages.empty() || !fp->atlas_pages.back().Allocate(surface->w, surface->h, glyph->x, glyph->y)) {
+                GlyphAtlasPage page;
+                page.texture = _CreateGlyphAtlasTexture();
+                if(page.texture == INVALID_TEXTURE_ID || !page.Allocate(surface->w, surface->h, glyph->x, glyph->y)) {
+                    if(page.texture != INVALID_TEXTURE_ID)
+                        TextureManager->_DeleteTexture(page.texture);
+                    delete glyph;
+                    SDL_FreeSurface(surface);
+                    IF_PRINT_WARNING(VIDEO_DEBUG) << "couldn't find any room for the glyph in the font atlas" << std::endl;
+                    return;
+                }
+                fp->atlas_pages.push_back(page);
+            }
+
+            glyph->page = fp->atlas_pages.size() - 1;
+            glyph->width = surface->w;
+            glyph->height = surface->h;
+            glyph->u1 = static_cast<float>(glyph->x) / static_cast<float>(GLYPH_ATLAS_SIZE);
+            glyph->v1 = static_cast<float>(glyph->y) / static_cast<float>(GLYPH_ATLAS_SIZE);
+            glyph->u2 = static_cast<float>(glyph->x + glyph->width) / static_cast<float>(GLYPH_ATLAS_SIZE);
+            glyph->v2 = static_cast<float>(glyph->y + glyph->height) / static_cast<float>(GLYPH_ATLAS_SIZE);
+
+            if(!_UploadGlyph(surface, *glyph, fp->atlas_pages[glyph->page].texture)) {
+                delete glyph;
+                SDL_FreeSurface(surface);
+                return;
+            }
+        }
+
         (*fp->glyph_cache)[character] = glyph;
 
-        SDL_FreeSurface(initial);
-        SDL_FreeSurface(intermediary);
+        SDL_FreeSurface(surface);
     }
 } // void TextSupervisor::_CacheGlyphs(const uint16* text, FontProperties* fp)
 
 
 
-void TextSupervisor::_DrawTextHelper(const uint16 *const text, FontProperties *fp, Color text_color)
+SDL_Surface *TextSupervisor::_RenderGlyph(uint16 character, FontProperties *fp)
 {
-    if(*text == 0) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "invalid argument, empty string" << std::endl;
-        return;
-    }
+    // If we can't render a particular glyph, we fall back to this one
+    static const uint16 fall_back_glyph = '?';
 
-    if(fp == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "invalid argument, NULL font properties" << std::endl;
-        return;
+    // Attempt to create the initial SDL_Surface that contains the rendered glyph
+    // We render it white so that color effects are applied correctly on it.
+    static const SDL_Color white_color = { 0xFF, 0xFF, 0xFF, 0xFF };
+    SDL_Surface *initial = TTF_RenderGlyph_Blended(fp->ttf_font, character, white_color);
+    if(initial == NULL) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed, resorting to fall back glyph: '?'" << std::endl;
+        initial = TTF_RenderGlyph_Blended(fp->ttf_font, fall_back_glyph, white_color);
+        if(initial == NULL) {
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed for fall back glyph, aborting glyph caching" << std::endl;
+            return NULL;
+        }
     }
 
-    glBlendFunc(GL_ONE, GL_ONE);
-    VideoManager->EnableBlending();
+    // Before blitting on a alpha surface, we need to disable blending on the source surface,
+    // or the alpha property of the source image will be ignored on the dest image.
+    // Note: Will be replaced by SDL_SetSurfaceBlendMode(initial, SDL_BLENDMODE_NONE); in SDL 2.0
+    SDL_SetAlpha(initial, 0, 255);
 
-    CoordSys &cs = VideoManager->_current_context.coordinate_system;
+    SDL_Surface *intermediary = SDL_CreateRGBSurface(0, initial->w, initial->h, 32, RMASK, GMASK, BMASK, AMASK);
+    if(intermediary == NULL) {
+        SDL_FreeSurface(initial);
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_CreateRGBSurface() failed" << std::endl;
+        return NULL;
+    }
 
-    _CacheGlyphs(text, fp);
+    if(SDL_BlitSurface(initial, 0, intermediary, 0) < 0) {
+        SDL_FreeSurface(initial);
+        SDL_FreeSurface(intermediary);
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_BlitSurface() failed" << std::endl;
+        return NULL;
+    }
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    VideoManager->EnableTexture2D();
+    SDL_FreeSurface(initial);
+    return intermediary;
+}
 
-    VideoManager->PushMatrix();
 
-    int font_width, font_height;
-    if(TTF_SizeUNICODE(fp->ttf_font, text, &font_width, &font_height) != 0) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed" << std::endl;
-        return;
-    }
 
-    float xoff = ((VideoManager->_current_context.x_align + 1) * font_width) * 0.5f * -cs.GetHorizontalDirection();
-    float yoff = ((VideoManager->_current_context.y_align + 1) * font_height) * 0.5f * -cs.GetVerticalDirection();
+bool TextSupervisor::_UploadGlyph(SDL_Surface *surface, const FontGlyph &glyph, GLuint texture)
+{
+    if(VIDEO_HEADLESS)
+        return true;
 
-    VideoManager->MoveRelative(xoff, yoff);
+    TextureManager->_BindTexture(texture);
 
-    VideoManager->EnableVertexArray();
-    VideoManager->EnableTextureCoordArray();
-
-    GLint vertices[8];
-    GLfloat tex_coords[8];
-    glVertexPointer(2, GL_INT, 0, vertices);
-    glTexCoordPointer(2, GL_FLOAT, 0, tex_coords);
-
-    // Iterate through each character in the string and render the character glyphs one at a time
-    int xpos = 0;
-    for(const uint16 *glyph = text; *glyph != 0; ++glyph) {
-        FontGlyph *glyph_info = (*fp->glyph_cache)[*glyph];
-
-        int x_hi = glyph_info->width;
-        int y_hi = glyph_info->height;
-        if(cs.GetHorizontalDirection() < 0.0f)
-            x_hi = -x_hi;
-        if(cs.GetVerticalDirection() < 0.0f)
-            y_hi = -y_hi;
-
-        int min_x, min_y;
-        min_x = glyph_info->min_x * static_cast<int>(cs.GetHorizontalDirection()) + xpos;
-        min_y = glyph_info->min_y * static_cast<int>(cs.GetVerticalDirection());
-
-        float tx, ty;
-        tx = glyph_info->max_x;
-        ty = glyph_info->max_y;
-
-        TextureManager->_BindTexture(glyph_info->texture);
-        if(VideoManager->CheckGLError()) {
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "OpenGL error detected: " << VideoManager->CreateGLErrorString() << std::endl;
-            return;
-        }
+    SDL_LockSurface(surface);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, glyph.x, glyph.y, glyph.width, glyph.height,
+                    GL_RGBA, GL_UNSIGNED_BYTE, surface->pixels);
+    SDL_UnlockSurface(surface);
 
-        vertices[0] = min_x;
-        vertices[1] = min_y;
-        vertices[2] = min_x + x_hi;
-        vertices[3] = min_y;
-        vertices[4] = min_x + x_hi;
-        vertices[5] = min_y + y_hi;
-        vertices[6] = min_x;
-        vertices[7] = min_y + y_hi;
-        tex_coords[0] = 0.0f;
-        tex_coords[1] = ty;
-        tex_coords[2] = tx;
-        tex_coords[3] = ty;
-        tex_coords[4] = tx;
-        tex_coords[5] = 0.0f;
-        tex_coords[6] = 0.0f;
-        tex_coords[7] = 0.0f;
-
-        glColor4fv((GLfloat *)&text_color);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        xpos += glyph_info->advance;
-    } // for (const uint16* glyph = text; *glyph != 0; glyph++)
+    if(VideoManager->CheckGLError()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "an OpenGL error was detected: " << VideoManager->CreateGLErrorString() << std::endl;
+        return false;
+    }
 
-    VideoManager->PopMatrix();
-} // void TextSupervisor::_DrawTextHelper(const uint16* const text, FontProperties* fp, Color color)
+    return true;
+}
 
 
 
-bool TextSupervisor::_RenderText(vt_utils::ustring &string, TextStyle &style, ImageMemory &buffer)
+GLuint TextSupervisor::_CreateGlyphAtlasTexture()
 {
-    FontProperties *fp = style.GetFontProperties();
-    TTF_Font *font = fp->ttf_font;
+    if(VIDEO_HEADLESS)
+        return TextureManager->_CreateBlankGLTexture(GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE);
 
-    if(fp == NULL || font == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "The TextStyle argument using font:'" << style.GetFontName() << "' was invalid" << std::endl;
-        return false;
+    GLuint texture;
+    glGenTextures(1, &texture);
+    TextureManager->_BindTexture(texture);
+
+    // Start from a fully transparent texture, so that the padding between the glyphs stays transparent.
+    void *pixels = calloc(GLYPH_ATLAS_SIZE * GLYPH_ATLAS_SIZE, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, GLYPH_ATLAS_SIZE, GLYPH_ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    free(pixels);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+    if(VideoManager->CheckGLError()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "an OpenGL error was detected: " << VideoManager->CreateGLErrorString() << std::endl;
+        TextureManager->_DeleteTexture(texture);
+        return INVALID_TEXTURE_ID;
     }
 
-    // Width and height of each line of text
-    int32 line_w, line_h;
-    // Minimum Y value of the line
-    int32 min_y = 0;
-    // Calculated line width
-    int32 calc_line_width = 0;
-    // Pixels left of '0' the first character extends, if any
-    int32 line_start_x = 0;
+    return texture;
+}
 
-    if(TTF_SizeUNICODE(font, string.c_str(), &line_w, &line_h) == -1) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_SizeUNICODE() failed" << std::endl;
-        return false;
-    }
 
-    _CacheGlyphs(string.c_str(), fp);
 
-    // Calculate the width of the width and minimum y value of the text
-    const uint16 *char_ptr;
-    for(char_ptr = string.c_str(); *char_ptr != '\0'; ++char_ptr) {
-        FontGlyph *glyphinfo = (*fp->glyph_cache)[*char_ptr];
-        if(glyphinfo->top_y < min_y)
-            min_y = glyphinfo->top_y;
-        calc_line_width += glyphinfo->advance;
+int32 TextSupervisor::_GetKerning(uint16 previous, uint16 character, FontProperties *fp)
+{
+    if(previous == 0)
+        return 0;
+
+    uint32 key = (static_cast<uint32>(previous) << 16) | character;
+    std::map<uint32, int32>::const_iterator it = fp->kerning_cache.find(key);
+    if(it != fp->kerning_cache.end())
+        return it->second;
+
+    int32 kerning = 0;
+    // The kerning pairs can only be queried since SDL_ttf 2.0.10, and TTF_SizeUNICODE() applies them since then too.
+#if SDL_TTF_MAJOR_VERSION > 2 || (SDL_TTF_MAJOR_VERSION == 2 && (SDL_TTF_MINOR_VERSION > 0 || SDL_TTF_PATCHLEVEL >= 10))
+    if(TTF_GetFontKerning(fp->ttf_font)) {
+        int previous_index = TTF_GlyphIsProvided(fp->ttf_font, previous);
+        int index = TTF_GlyphIsProvided(fp->ttf_font, character);
+        if(previous_index != 0 && index != 0)
+            kerning = TTF_GetFontKerningSize(fp->ttf_font, previous_index, index);
     }
+#endif
 
-    // Subtract one pixel from the minimum y value (TODO: explain why)
-    min_y -= 1;
-
-    // Check if the first character starts left of pixel 0, and set
-    // char_ptr = string.c_str();
-    if(*char_ptr) {
-        FontGlyph *first_glyphinfo = (*fp->glyph_cache)[*char_ptr];
-        if(first_glyphinfo->min_x < 0)
-            line_start_x = first_glyphinfo->min_x;
-    }
+    fp->kerning_cache[key] = kerning;
+    return kerning;
+}
 
-    // TTF_SizeUNICODE can underestimate line width as a result of its micro positioning.
-    // Check if this condition is true and if so, set the line width appropriately.
-    if(calc_line_width > line_w)
-        line_w = calc_line_width;
 
-    // Adjust line dimensions by negative starting offsets if present
-    line_w -= line_start_x;
-    line_h -= min_y;
 
-    // Creates an alpha surface for the given text
-    SDL_Surface* intermediary = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, line_w, line_h, 32, RMASK, GMASK, BMASK, AMASK);
-    if(intermediary == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_CreateRGBSurface() failed" << std::endl;
-        return false;
+void TextSupervisor::_UnloadGlyphTextures()
+{
+    for(std::map<std::string, FontProperties *>::iterator it = _font_map.begin(); it != _font_map.end(); ++it) {
+        std::vector<GlyphAtlasPage> &pages = it->second->atlas_pages;
+        for(uint32 i = 0; i < pages.size(); ++i) {
+            if(pages[i].texture != 0 && pages[i].texture != INVALID_TEXTURE_ID)
+                TextureManager->_DeleteTexture(pages[i].texture);
+            pages[i].texture = 0;
+        }
     }
+}
 
-    // Go through the string and render each glyph one by one
-    int32 xpos = -line_start_x;
-    int32 ypos = -min_y;
-    for(char_ptr = string.c_str(); *char_ptr != '\0'; ++char_ptr) {
-        FontGlyph *glyphinfo = (*fp->glyph_cache)[*char_ptr];
 
-        // Render the glyph in white, the text style color will be used at draw time only,
-        // to permit proper shadows colors.
-        static const SDL_Color white_color = { 0xFF, 0xFF, 0xFF, 0xFF };
-        SDL_Surface* initial = TTF_RenderGlyph_Blended(font, *char_ptr, white_color);
-        if(initial == NULL) {
-            SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to TTF_RenderGlyph_Blended() failed" << std::endl;
-            return false;
-        }
 
-        // Before blitting on a alpha surface, we need to disable blending on the source surface,
-        // or the alpha property of the source image will be ignored on the dest image.
-        // Note: Will be replaced by SDL_SetSurfaceBlendMode(initial, SDL_BLENDMODE_NONE); in SDL 2.0
-        SDL_SetAlpha(initial, 0, 255);
+bool TextSupervisor::_ReloadGlyphTextures()
+{
+    bool success = true;
 
-        SDL_Rect surf_target;
-        surf_target.x = xpos + glyphinfo->min_x;
-        surf_target.y = ypos + glyphinfo->top_y;
+    for(std::map<std::string, FontProperties *>::iterator it = _font_map.begin(); it != _font_map.end(); ++it) {
+        FontProperties *fp = it->second;
+        if(fp == NULL || fp->ttf_font == NULL || fp->glyph_cache == NULL)
+            continue;
 
-        // Add the glyph to the end of the rendered string
-        if(SDL_BlitSurface(initial, NULL, intermediary, &surf_target) < 0) {
-            SDL_FreeSurface(initial);
-            SDL_FreeSurface(intermediary);
-            IF_PRINT_WARNING(VIDEO_DEBUG) << "call to SDL_BlitSurface() failed, SDL error: " << SDL_GetError() << std::endl;
-            return false;
+        for(uint32 i = 0; i < fp->atlas_pages.size(); ++i) {
+            if(fp->atlas_pages[i].texture == 0)
+                fp->atlas_pages[i].texture = _CreateGlyphAtlasTexture();
         }
-        SDL_FreeSurface(initial);
-        xpos += glyphinfo->advance;
-    }
 
-    SDL_LockSurface(intermediary);
-
-    uint32 num_bytes = intermediary->w * intermediary->h * 4;
-    buffer.pixels = static_cast<uint8 *>(calloc(line_w * line_h, 4));
-    for(uint32 j = 0; j < num_bytes; j += 4) {
-        ((uint8 *)buffer.pixels)[j + 0] = ((uint8 *)intermediary->pixels)[j + 0]; // r
-        ((uint8 *)buffer.pixels)[j + 1] = ((uint8 *)intermediary->pixels)[j + 1]; // g
-        ((uint8 *)buffer.pixels)[j + 2] = ((uint8 *)intermediary->pixels)[j + 2]; // b
-        ((uint8 *)buffer.pixels)[j + 3] = ((uint8 *)intermediary->pixels)[j + 3]; // alpha
-    }
+        // Render the cached glyphs again, at the same places in the atlas
+        for(uint32 character = 0; character < fp->glyph_cache->size(); ++character) {
+            FontGlyph *glyph = (*fp->glyph_cache)[character];
+            if(glyph == NULL || glyph->width == 0 || glyph->height == 0)
+                continue;
 
-    buffer.width = line_w;
-    buffer.height = line_h;
+            GLuint texture = fp->atlas_pages[glyph->page].texture;
+            if(texture == INVALID_TEXTURE_ID) {
+                success = false;
+                continue;
+            }
 
-    SDL_UnlockSurface(intermediary);
-    SDL_FreeSurface(intermediary);
+            SDL_Surface *surface = _RenderGlyph(static_cast<uint16>(character), fp);
+            if(surface == NULL || !_UploadGlyph(surface, *glyph, texture))
+                success = false;
+            if(surface != NULL)
+                SDL_FreeSurface(surface);
+        }
+    }
 
-    return true;
-} // bool TextSupervisor::_RenderText(vt_utils::ustring& string, TextStyle& style, ImageMemory& buffer)
+    return success;
+}
 
 }  // namespace vt_video
@@ -61,42 +61,90 @@ enum TEXT_SHADOW_STYLE {
 
 /** ****************************************************************************
 *** \brief A structure to hold properties about a particular font glyph
+***
+*** The glyph image is stored in one of the glyph atlas pages of its font.
 *** ***************************************************************************/
 class FontGlyph
 {
 public:
     FontGlyph():
-        texture(0),
+        page(0),
+        x(0),
+        y(0),
         width(0),
         height(0),
+        u1(0.0f),
+        v1(0.0f),
+        u2(0.0f),
+        v2(0.0f),
         min_x(0),
-        min_y(0),
-        max_x(0.0f),
-        max_y(0.0f),
-        advance(0),
-        top_y(0)
+        top_y(0),
+        advance(0)
     {}
 
-    //! \brief The index of the GL texture for this glyph.
-    GLuint texture;
+    //! \brief The index of the glyph atlas page holding the glyph image.
+    uint32 page;
 
-    //! \brief The width and height of the glyph in pixels.
+    //! \brief The pixel coordinates of the glyph image in the atlas page.
+    int32 x, y;
+
+    //! \brief The width and height of the glyph image in pixels.
     int32 width, height;
 
-    //! \brief The mininum x and y pixel coordinates of the glyph in texture space (refer to TTF_GlyphMetrics).
-    int min_x, min_y;
+    //! \brief The texture coordinates of the glyph image in the atlas page.
+    float u1, v1, u2, v2;
+
+    //! \brief The mininum x pixel coordinate of the glyph (refer to TTF_GlyphMetrics).
+    int32 min_x;
 
-    //! \brief The maximum x and y pixel coordinates of the glyph in texture space (refer to TTF_GlyphMetrics).
-    float max_x, max_y;
+    //! \brief The top y value of the glyph, relative to the top of the line.
+    int32 top_y;
 
     //! \brief The amount of space between glyphs.
     int32 advance;
-
-    //! \brief The top y value of the glyph.
-    int top_y;
 }; // class FontGlyph
 
 
+namespace private_video
+{
+
+/** ****************************************************************************
+*** \brief A texture where the glyphs of a font are rendered
+***
+*** The glyphs are packed in rows (shelves) from the top of the texture, each
+*** glyph being separated by a pixel of padding so that the linear filtering
+*** doesn't bleed onto its neighbours.
+*** ***************************************************************************/
+class GlyphAtlasPage
+{
+public:
+    GlyphAtlasPage():
+        texture(0),
+        _shelf_x(1),
+        _shelf_y(1),
+        _shelf_height(0)
+    {}
+
+    /** \brief Reserves room for a glyph image.
+    *** \param width, height The glyph image size in pixels.
+    *** \param x, y Set to the pixel coordinates of the reserved room.
+    *** \return false if the page is full.
+    **/
+    bool Allocate(int32 width, int32 height, int32 &x, int32 &y);
+
+    //! \brief The GL texture of the page, or 0 when unloaded.
+    GLuint texture;
+
+private:
+    //! \brief The next free position on the current shelf, and its height.
+    int32 _shelf_x;
+    int32 _shelf_y;
+    int32 _shelf_height;
+}; // class GlyphAtlasPage
+
+} // namespace private_video
+
+
 /** ****************************************************************************
 *** \brief A structure which holds properties about fonts
 *** ***************************************************************************/
@@ -110,7 +158,8 @@ public:
         descent(0),
         ttf_font(NULL),
         font_size(0),
-        glyph_cache(NULL)
+        glyph_cache(NULL),
+        generation(0)
     {}
 
     ~FontProperties()
@@ -118,23 +167,10 @@ public:
         ClearFont();
     }
 
-    //! \brief Clears out a font object plus its glyph cache.
+    //! \brief Clears out a font object plus its glyph cache and atlas.
     //! Useful when changing a TextStyle font without deleting
     //! the font properties object.
-    void ClearFont() {
-        // Free the font.
-        if(ttf_font)
-            TTF_CloseFont(ttf_font);
-
-        // Clears the glyph cache and delete it
-        if(glyph_cache) {
-            std::vector<vt_video::FontGlyph *>::const_iterator it_end = glyph_cache->end();
-            for(std::vector<FontGlyph *>::iterator j = glyph_cache->begin(); j != it_end; ++j) {
-                delete *j;
-            }
-            delete glyph_cache;
-        }
-    }
+    void ClearFont();
 
     //! \brief The maximum height of all of the glyphs for this font.
     int32 height;
@@ -156,6 +192,17 @@ public:
 
     //! \brief A pointer to a cache which holds all of the glyphs used in this font.
     std::vector<FontGlyph *>* glyph_cache;
+
+    //! \brief The textures where the cached glyphs are rendered.
+    std::vector<private_video::GlyphAtlasPage> atlas_pages;
+
+    //! \brief The kerning offsets already queried, the key being (previous character << 16 | character).
+    std::map<uint32, int32> kerning_cache;
+
+    /** \brief Increased whenever the font is cleared, so that the text
+    *** laid out with the previous glyphs knows it must be laid out again.
+    **/
+    uint32 generation;
 }; // class FontProperties
 
 
@@ -281,66 +328,20 @@ namespace private_video
 {
 
 /** ****************************************************************************
-*** \brief Represents an image of rendered text stored in a texture sheet
+*** \brief A single line of text, drawn using the glyph atlas of its font.
 ***
-*** A text specific class derived from the BaseImage class, it contains a
-*** unicode string and text style needed to render a piece of text.
-*** ***************************************************************************/
-class TextTexture : public private_video::BaseTexture
-{
-public:
-    /** \brief Constructor defaults image as the first one in a texture sheet.
-    *** \note The actual sheet where the image is located will be determined later.
-    **/
-    TextTexture(const vt_utils::ustring &string_, const TextStyle &style_);
-
-    ~TextTexture();
-
-    // ---------- Public members
-
-    //! \brief The string represented
-    vt_utils::ustring string;
-
-    //! \brief The text style of the rendered string
-    TextStyle style;
-
-    // ---------- Public methods
-
-    //! \brief Generate a text texture and add to a texture sheet
-    bool Regenerate();
-
-    //! \brief Reload texture to an already assigned texture sheet
-    bool Reload();
-
-private:
-    TextTexture(const TextTexture &copy);
-    TextTexture &operator=(const TextTexture &copy);
-}; // class TextTexture : public private_video::BaseImage
-
-
-/** ****************************************************************************
-*** \brief An element used as a portion of a full rendered block of text.
-***
-*** This class represents a block (usually a single line) of rendered text that
-*** is stored by the TextImage class as a portion, or element, that makes up
-*** a rendered block of text. This class managed a pointer to a TextTexture
-*** object that refers to the rendered line of text as it is stored in texture
-*** memory.
+*** The line is laid out once into a quad per glyph, using the cached glyph
+*** metrics and kerning. The quads are sorted by atlas page, so that the line
+*** is drawn with a single call per page, and changing the text doesn't
+*** require any texture upload once its glyphs are cached.
 *** ***************************************************************************/
 class TextElement : public ImageDescriptor
 {
 public:
     TextElement();
 
-    TextElement(TextTexture *texture);
-
     ~TextElement();
 
-    // ---------- Public members
-
-    //! \brief The image that is being referenced by this object.
-    TextTexture *text_texture;
-
     // ---------- Public methods
 
     void Clear();
@@ -355,18 +356,13 @@ public:
     void DisableGrayScale()
     {}
 
-    /** \brief Sets the texture used by the class and modifies the width and height members
-    *** \param texture A pointer to the TextTexture object that this class object should manage
+    /** \brief Lays out the given line of text
+    *** \param text The line of text, which must not contain any new line character.
+    *** \param font_properties The font used to render the text.
     ***
-    *** Because it is rare that the user needs to define a custom width/height for the text (since
-    *** scaled text looks so poor), this function also automatically sets the _width and _height members
-    *** to the translated value of the width and height of the TextTexture in the current coordinate system
-    *** (current context) in which this function call is made. Passing a NULL argument will deallocate any
-    *** texture resources and set the width/height to zero.
-    ***
-    *** \note This function will invoke the AddReference() method for the argument object if it is not NULL.
+    *** The _width and _height members are set to the pixel size of the laid out line.
     **/
-    void SetTexture(TextTexture *texture);
+    void SetText(const vt_utils::ustring &text, FontProperties *font_properties);
 
     void SetStatic(bool is_static) {
         _is_static = is_static;
@@ -384,6 +380,40 @@ public:
         SetWidth(width);
         SetHeight(height);
     }
+
+private:
+    //! \brief A range of quads using the same atlas page.
+    struct QuadRange {
+        uint32 page;
+        uint32 first_quad;
+        uint32 num_quads;
+    };
+
+    //! \brief The line of text.
+    vt_utils::ustring _text;
+
+    //! \brief The font used, which is owned by the text supervisor.
+    FontProperties *_font_properties;
+
+    //! \brief The font generation the quads were laid out with.
+    mutable uint32 _font_generation;
+
+    //! \brief The glyph quads vertices in pixels, relative to the top-left corner of the line.
+    mutable std::vector<float> _vertices;
+
+    //! \brief The glyph quads texture coordinates.
+    mutable std::vector<float> _tex_coords;
+
+    //! \brief The quads ranges, one per atlas page used.
+    mutable std::vector<QuadRange> _quad_ranges;
+
+    /** \brief Lays out the glyph quads of the text, caching its glyphs when needed.
+    *** \param width, height Set to the pixel size of the laid out line.
+    **/
+    void _LayoutText(int32 &width, int32 &height) const;
+
+    //! \brief Lays out the text, and sets the _width and _height members to the line size.
+    void _UpdateLayout();
 }; // class TextElement : public ImageDescriptor
 
 } // namespace private_video
@@ -534,7 +564,7 @@ private:
     //! \brief The text max width, used for word wrapping
     uint32 _max_width;
 
-    //! \brief The TextTexture elements representing rendered text portions, usually lines.
+    //! \brief The elements representing the laid out text portions, usually lines.
     std::vector<private_video::TextElement *> _text_sections;
 
     // ---------- Private methods
@@ -562,7 +592,7 @@ class TextSupervisor : public vt_utils::Singleton<TextSupervisor>
     friend class vt_utils::Singleton<TextSupervisor>;
     friend class VideoEngine;
     friend class TextureController;
-    friend class private_video::TextTexture;
+    friend class private_video::TextElement;
     friend class TextImage;
     friend class TextStyle;
 
@@ -677,29 +707,46 @@ private:
     **/
     void _FreeFont(const std::string &font_name);
 
-    /** \brief Caches glyph information and textures for rendering
+    /** \brief Caches glyph information and renders the glyphs into the font glyph atlas
     *** \param text A pointer to the unicode string holding the characters (glyphs) to cache
     *** \param fp A pointer to the FontProperties representing the font being used in rendering the font
+    ***
+    *** Only the glyphs not already cached are rendered and uploaded to texture memory.
     **/
     void _CacheGlyphs(const uint16 *text, FontProperties *fp);
 
-    /** \brief Draws text to the screen using OpenGL commands
-    *** \param text A pointer to a unicode string holding the text to draw
-    *** \param fp A pointer to the properties of the font to use in drawing the text
-    *** \param text_color The color to render the text in
-    ***
-    *** This class assists the public Draw methods. This method is intended for drawing only
-    *** a single line of text in a single color (it does not account for shadows).
+    /** \brief Renders a glyph in white, in the pixel format of the glyph atlas
+    *** \param character The character to render, the fall back glyph '?' being used if it can't be rendered
+    *** \param fp The font to render the glyph with
+    *** \return The rendered glyph surface, to be freed by the caller, or NULL on failure
+    **/
+    SDL_Surface *_RenderGlyph(uint16 character, FontProperties *fp);
+
+    /** \brief Copies a rendered glyph into its place in a glyph atlas texture
+    *** \param surface The glyph surface returned by _RenderGlyph()
+    *** \param glyph The glyph properties, whose atlas position is already set
+    *** \param texture The atlas page texture
+    *** \return False if an OpenGL error occurred
     **/
-    void _DrawTextHelper(const uint16 *text, FontProperties *fp, Color text_color);
+    bool _UploadGlyph(SDL_Surface *surface, const FontGlyph &glyph, GLuint texture);
 
-    /** \brief Renders a unicode string with a given TextStyle to a pixel array
-    *** \param string The unicdoe string to render
-    *** \param style The text style to render the string in
-    *** \param buffer A reference to the pixel array where to place the rendered string to
-    *** \return True if the string was rendered successfully, or false if it was not
+    /** \brief Creates the texture of a glyph atlas page, cleared to transparent.
+    *** \return The texture id, or INVALID_TEXTURE_ID on failure.
     **/
-    bool _RenderText(vt_utils::ustring &string, TextStyle &style, private_video::ImageMemory &buffer);
+    GLuint _CreateGlyphAtlasTexture();
+
+    /** \brief Returns the kerning offset to apply between two characters
+    *** \param previous The previous character, or 0 at the start of a line
+    *** \param character The current character
+    *** \param fp The font used
+    **/
+    int32 _GetKerning(uint16 previous, uint16 character, FontProperties *fp);
+
+    //! \brief Deletes the glyph atlas textures, keeping the glyph metrics and positions.
+    void _UnloadGlyphTextures();
+
+    //! \brief Recreates the glyph atlas textures after _UnloadGlyphTextures(), at the same places.
+    bool _ReloadGlyphTextures();
 
     /** \brief Returns true if a font of a certain reference name exists
     *** \param font_name The reference name of the font to check
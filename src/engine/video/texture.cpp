@@ -106,6 +106,9 @@ bool TexSheet::Reload()
 
 bool TexSheet::CopyRect(int32 x, int32 y, ImageMemory &data)
 {
+    if(VIDEO_HEADLESS)
+        return true;
+
     TextureManager->_BindTexture(tex_id);
 
     glTexSubImage2D(
@@ -132,6 +135,9 @@ bool TexSheet::CopyRect(int32 x, int32 y, ImageMemory &data)
 
 bool TexSheet::CopyScreenRect(int32 x, int32 y, const ScreenRect &screen_rect)
 {
+    if(VIDEO_HEADLESS)
+        return true;
+
     TextureManager->_BindTexture(tex_id);
 
     glCopyTexSubImage2D(
@@ -162,6 +168,9 @@ void TexSheet::Smooth(bool flag)
         smoothed = flag;
         GLenum filtering_type = smoothed ? GL_LINEAR : GL_NEAREST;
 
+        if(VIDEO_HEADLESS)
+            return;
+
         TextureManager->_BindTexture(tex_id);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filtering_type);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filtering_type);
@@ -170,6 +179,13 @@ void TexSheet::Smooth(bool flag)
 
 
 
+void TexSheet::Bind()
+{
+    TextureManager->_BindTexture(tex_id);
+}
+
+
+
 void TexSheet::DEBUG_Draw() const
 {
     // The vertex coordinate array to use (assumes glScale() has been appropriately set)
@@ -188,6 +204,11 @@ void TexSheet::DEBUG_Draw() const
         0.0f, 0.0f, // Upper left
     };
 
+    // Draw the pending images first
+    VideoManager->FlushSpriteBatch();
+    if(VIDEO_HEADLESS)
+        return;
+
     // Enable texturing and bind the texture
     VideoManager->DisableBlending();
     VideoManager->EnableTexture2D();
@@ -442,9 +463,10 @@ FixedTexNode *FixedTexSheet::_RemoveOpenNode()
 VariableTexSheet::VariableTexSheet(int32 sheet_width, int32 sheet_height, GLuint sheet_id, TexSheetType sheet_type, bool sheet_static) :
     TexSheet(sheet_width, sheet_height, sheet_id, sheet_type, sheet_static)
 {
-    _block_width = width / 16;
-    _block_height = height / 16;
-    _blocks = new VariableTexNode[_block_width * _block_height];
+    // The textures are placed at the pixel level
+    _block_width = width;
+    _block_height = height;
+    _ResetFreeSpace();
 }
 
 
@@ -453,8 +475,6 @@ VariableTexSheet::~VariableTexSheet()
 {
     if(GetNumberTextures() != 0)
         IF_PRINT_WARNING(VIDEO_DEBUG) << "texture sheet being deleted when it has a non-zero allocated texture count: " << GetNumberTextures() << std::endl;
-
-    delete[] _blocks;
 }
 
 
@@ -484,66 +504,27 @@ bool VariableTexSheet::InsertTexture(BaseTexture *img)
 
     // Don't allow insertions into a texture sheet containing a texture larger than 512x512.
     // Texture sheets with this property may only be used by one texture at a time
-    if(_block_width > 32 || _block_height > 32) {  // 32 blocks == 512 pixels
-        if(_blocks[0].free_image == false)
+    if(width > 512 || height > 512) {
+        if(!_textures.empty() && !_RemoveFreedTextures())
             return false;
     }
 
-    // Attempt to find an open region in the texture sheet to fit this texture
-    int32 block_x = -1, block_y = -1;
-    int32 w = (img->width + 15) / 16;
-    int32 h = (img->height + 15) / 16;
-
-    // This is a brute force algorithm to try and find space to allocate the texture.
-    // If this becomes a bottleneck, we may wish to use a more intellegent algorithm here.
-    bool continue_search = true;
-    for(int32 y = 0; y < _block_height - h + 1 && continue_search; y++) {
-        for(int32 x = 0; x < _block_width - w + 1; x++) {
-            int32 furthest_blocker = -1;
-
-            bool continue_neighbor_search = true;
-            for(int32 dy = 0; dy < h && continue_neighbor_search; dy++) {
-                for(int32 dx = 0; dx < w; dx++) {
-                    if(_blocks[(x + dx) + ((y + dy) * _block_width)].free_image == false) {
-                        furthest_blocker = x + dx;
-                        continue_neighbor_search = false;
-                        break;
-                    }
-                }
-            }
-
-            if(furthest_blocker == -1) {
-                block_x = x;
-                block_y = y;
-                continue_search = false;
-                break;
-            }
-        }
-    }
-
-    // If either of these conditions is true, it means we were unable to allocate enough space to insert this texture
-    if(block_x == -1 || block_y == -1)
+    int32 w = static_cast<int32>(img->width);
+    int32 h = static_cast<int32>(img->height);
+    if(w > static_cast<int32>(width) || h > static_cast<int32>(height))
         return false;
 
-    // Go through each block that is to be occupied by the new texture and set its properties
-    for(int32 y = block_y; y < block_y + h; y++) {
-        for(int32 x = block_x; x < block_x + w; x++) {
-            int32 index = x + (y * _block_width);
-
-            // If the texture pointer for the block is not NULL, this means it contains a freed texture.
-            // Now we must remove that texture entirely since we are overwriting at least one of its blocks.
-            if(_blocks[index].image) {
-                RemoveTexture(_blocks[index].image);
-            }
-
-            _blocks[index].free_image = false;
-            _blocks[index].image = img;
-        }
+    // Attempt to find an open region in the texture sheet to fit this texture.
+    // If there is none, the space of the freed textures is reclaimed.
+    int32 x = 0, y = 0;
+    if(!_Allocate(w, h, x, y)) {
+        if(!_RemoveFreedTextures() || !_Allocate(w, h, x, y))
+            return false;
     }
 
     // Calculate the pixel and uv coordinates for the newly inserted texture
-    img->x = block_x * 16;
-    img->y = block_y * 16;
+    img->x = x;
+    img->y = y;
 
     float sheet_width = static_cast<float>(width);
     float sheet_height = static_cast<float>(height);
@@ -554,7 +535,7 @@ bool VariableTexSheet::InsertTexture(BaseTexture *img)
     img->v2 = static_cast<float>(img->y + img->height - 0.5f) / sheet_height;
 
     img->texture_sheet = this;
-    _textures.insert(img);
+    _textures[img] = false;
 
     return true;
 } // bool VariableTexSheet::InsertTexture(BaseTexture* img)
@@ -563,40 +544,375 @@ bool VariableTexSheet::InsertTexture(BaseTexture *img)
 
 void VariableTexSheet::RemoveTexture(BaseTexture *img)
 {
-    _SetBlockProperties(img, NULL, true);
-    _textures.erase(img);
+    std::map<BaseTexture *, bool>::iterator it = _textures.find(img);
+    if(it == _textures.end()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+        return;
+    }
+    _textures.erase(it);
+
+    if(_textures.empty()) {
+        _ResetFreeSpace();
+        return;
+    }
+
+    _free_rects.push_back(FreeTexRect(img->x, img->y, img->width, img->height));
+    _MergeFreeRects();
+}
+
+
+
+uint32 VariableTexSheet::GetUsedArea()
+{
+    uint32 area = 0;
+    for(std::map<BaseTexture *, bool>::const_iterator it = _textures.begin(); it != _textures.end(); ++it)
+        area += it->first->width * it->first->height;
+    return area;
+}
+
+
+
+float VariableTexSheet::GetFragmentation()
+{
+    uint32 sheet_area = width * height;
+    uint32 used_area = GetUsedArea();
+    if(used_area >= sheet_area)
+        return 0.0f;
+
+    // Find the largest free area, either a free rectangle or a rectangle above the skyline
+    uint32 largest_area = 0;
+    for(uint32 i = 0; i < _free_rects.size(); ++i)
+        largest_area = std::max(largest_area, _free_rects[i].GetArea());
+
+    for(uint32 i = 0; i < _skyline.size(); ++i) {
+        int32 top = _skyline[i].y;
+        int32 left = _skyline[i].x;
+        int32 right = _skyline[i].x + _skyline[i].width;
+
+        for(int32 j = static_cast<int32>(i) - 1; j >= 0 && _skyline[j].y <= top; --j)
+            left = _skyline[j].x;
+        for(uint32 j = i + 1; j < _skyline.size() && _skyline[j].y <= top; ++j)
+            right = _skyline[j].x + _skyline[j].width;
+
+        largest_area = std::max(largest_area, static_cast<uint32>((right - left) * (static_cast<int32>(height) - top)));
+    }
+
+    uint32 free_area = sheet_area - used_area;
+    if(largest_area >= free_area)
+        return 0.0f;
+
+    return 1.0f - static_cast<float>(largest_area) / static_cast<float>(free_area);
+}
+
+
+
+void VariableTexSheet::GetTextures(std::vector<BaseTexture *> &textures) const
+{
+    for(std::map<BaseTexture *, bool>::const_iterator it = _textures.begin(); it != _textures.end(); ++it) {
+        if(!it->second)
+            textures.push_back(it->first);
+    }
+}
+
+
+
+void VariableTexSheet::_ResetFreeSpace()
+{
+    _skyline.clear();
+    _skyline.push_back(SkylineNode(0, 0, width));
+    _free_rects.clear();
+}
+
+
+
+bool VariableTexSheet::_Allocate(int32 w, int32 h, int32 &x, int32 &y)
+{
+    // Reuse the smallest free rectangle the texture fits in, if any
+    int32 best_rect = -1;
+    uint32 best_area = 0;
+    for(uint32 i = 0; i < _free_rects.size(); ++i) {
+        const FreeTexRect &rect = _free_rects[i];
+        if(rect.width < w || rect.height < h)
+            continue;
+
+        if(best_rect == -1 || rect.GetArea() < best_area) {
+            best_rect = i;
+            best_area = rect.GetArea();
+        }
+    }
+
+    if(best_rect != -1) {
+        x = _free_rects[best_rect].x;
+        y = _free_rects[best_rect].y;
+        _SplitFreeRect(best_rect, w, h);
+        return true;
+    }
+
+    // Otherwise, place the texture on the skyline where its bottom is the highest,
+    // preferring the narrowest segments to keep the wide ones for the wide textures.
+    int32 best_index = -1;
+    int32 best_bottom = 0;
+    int32 best_width = 0;
+    for(uint32 i = 0; i < _skyline.size(); ++i) {
+        int32 top = 0;
+        if(!_FitsOnSkyline(i, w, h, top))
+            continue;
+
+        int32 bottom = top + h;
+        if(best_index == -1 || bottom < best_bottom || (bottom == best_bottom && _skyline[i].width < best_width)) {
+            best_index = i;
+            best_bottom = bottom;
+            best_width = _skyline[i].width;
+        }
+    }
+
+    if(best_index == -1)
+        return false;
+
+    x = _skyline[best_index].x;
+    y = best_bottom - h;
+    _AddSkylineLevel(best_index, x, y, w, h);
+    return true;
+} // bool VariableTexSheet::_Allocate(int32 w, int32 h, int32 &x, int32 &y)
+
+
+
+bool VariableTexSheet::_FitsOnSkyline(uint32 index, int32 w, int32 h, int32 &y) const
+{
+    int32 x = _skyline[index].x;
+    if(x + w > static_cast<int32>(width))
+        return false;
+
+    // The texture rests on the highest segment below it
+    y = 0;
+    int32 width_left = w;
+    for(uint32 i = index; width_left > 0; ++i) {
+        y = std::max(y, _skyline[i].y);
+        if(y + h > static_cast<int32>(height))
+            return false;
+        width_left -= _skyline[i].width;
+    }
+
+    return true;
+}
+
+
+
+void VariableTexSheet::_AddSkylineLevel(uint32 index, int32 x, int32 y, int32 w, int32 h)
+{
+    int32 right = x + w;
+
+    // The space between the texture and the segments below it can't be reached
+    // from the skyline anymore, so it is kept as free rectangles.
+    for(uint32 i = index; i < _skyline.size() && _skyline[i].x < right; ++i) {
+        if(_skyline[i].y >= y)
+            continue;
+
+        int32 segment_right = std::min(_skyline[i].x + _skyline[i].width, right);
+        _free_rects.push_back(FreeTexRect(_skyline[i].x, _skyline[i].y, segment_right - _skyline[i].x, y - _skyline[i].y));
+    }
+
+    _skyline.insert(_skyline.begin() + index, SkylineNode(x, y + h, w));
+
+    // Shrink or remove the segments now covered by the new one
+    for(uint32 i = index + 1; i < _skyline.size();) {
+        SkylineNode &node = _skyline[i];
+        if(node.x >= right)
+            break;
+
+        int32 covered = right - node.x;
+        if(node.width <= covered) {
+            _skyline.erase(_skyline.begin() + i);
+            continue;
+        }
+
+        node.x += covered;
+        node.width -= covered;
+        break;
+    }
+
+    // Merge the neighbour segments at the same level
+    for(uint32 i = 0; i + 1 < _skyline.size();) {
+        if(_skyline[i].y == _skyline[i + 1].y) {
+            _skyline[i].width += _skyline[i + 1].width;
+            _skyline.erase(_skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+
+    _MergeFreeRects();
+} // void VariableTexSheet::_AddSkylineLevel(uint32 index, int32 x, int32 y, int32 w, int32 h)
+
+
+
+void VariableTexSheet::_SplitFreeRect(uint32 index, int32 w, int32 h)
+{
+    FreeTexRect rect = _free_rects[index];
+    _free_rects.erase(_free_rects.begin() + index);
+
+    int32 right_width = rect.width - w;
+    int32 bottom_height = rect.height - h;
+
+    // Split along the shorter leftover axis, so that the larger remaining part stays whole
+    if(right_width <= bottom_height) {
+        if(right_width > 0)
+            _free_rects.push_back(FreeTexRect(rect.x + w, rect.y, right_width, h));
+        if(bottom_height > 0)
+            _free_rects.push_back(FreeTexRect(rect.x, rect.y + h, rect.width, bottom_height));
+    } else {
+        if(right_width > 0)
+            _free_rects.push_back(FreeTexRect(rect.x + w, rect.y, right_width, rect.height));
+        if(bottom_height > 0)
+            _free_rects.push_back(FreeTexRect(rect.x, rect.y + h, w, bottom_height));
+    }
 }
 
 
 
-void VariableTexSheet::_SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free)
+void VariableTexSheet::_MergeFreeRects()
+{
+    bool merged = true;
+    while(merged) {
+        merged = false;
+        for(uint32 i = 0; i < _free_rects.size() && !merged; ++i) {
+            for(uint32 j = i + 1; j < _free_rects.size(); ++j) {
+                FreeTexRect &a = _free_rects[i];
+                const FreeTexRect &b = _free_rects[j];
+
+                if(a.x == b.x && a.width == b.width && (a.y + a.height == b.y || b.y + b.height == a.y)) {
+                    a.y = std::min(a.y, b.y);
+                    a.height += b.height;
+                } else if(a.y == b.y && a.height == b.height && (a.x + a.width == b.x || b.x + b.width == a.x)) {
+                    a.x = std::min(a.x, b.x);
+                    a.width += b.width;
+                } else {
+                    continue;
+                }
+
+                _free_rects.erase(_free_rects.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+}
+
+
+
+bool VariableTexSheet::_RemoveFreedTextures()
+{
+    std::vector<BaseTexture *> freed_textures;
+    for(std::map<BaseTexture *, bool>::const_iterator it = _textures.begin(); it != _textures.end(); ++it) {
+        if(it->second)
+            freed_textures.push_back(it->first);
+    }
+
+    for(uint32 i = 0; i < freed_textures.size(); ++i)
+        RemoveTexture(freed_textures[i]);
+
+    return !freed_textures.empty();
+}
+
+
+
+void VariableTexSheet::_SetFreeFlag(BaseTexture *tex, bool free)
 {
     if(tex == NULL) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL pointer was given as function argument" << std::endl;
         return;
     }
 
-    if(_textures.find(tex) == _textures.end()) {
+    std::map<BaseTexture *, bool>::iterator it = _textures.find(tex);
+    if(it == _textures.end()) {
         IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+        return;
     }
 
-    // Calculate upper-left corner in blocks
-    int32 block_x = tex->x / 16;
-    int32 block_y = tex->y / 16;
+    it->second = free;
+}
 
-    // Calculate width and height in blocks
-    int32 w = (tex->width  + 15) / 16;
-    int32 h = (tex->height + 15) / 16;
+// -----------------------------------------------------------------------------
+// AtlasTexSheet class
+// -----------------------------------------------------------------------------
 
-    for(int32 y = block_y; y < block_y + h; y++) {
-        for(int32 x = block_x; x < block_x + w; x++) {
-            int32 index = x + y * _block_width;
-            if(_blocks[index].image == tex) {
-                _blocks[index].free_image = free;
-                _blocks[index].image = new_tex;
-            }
-        }
+AtlasTexSheet::AtlasTexSheet(int32 sheet_width, int32 sheet_height, GLuint sheet_id) :
+    TexSheet(sheet_width, sheet_height, sheet_id, VIDEO_TEXSHEET_ATLAS, true)
+{
+    // The textures are placed at the pixel level
+    _block_width = width;
+    _block_height = height;
+}
+
+
+
+AtlasTexSheet::~AtlasTexSheet()
+{
+    if(GetNumberTextures() != 0)
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture sheet being deleted when it has a non-zero allocated texture count: " << GetNumberTextures() << std::endl;
+}
+
+
+
+bool AtlasTexSheet::AddTexture(BaseTexture * /*img*/, ImageMemory & /*data*/)
+{
+    return false;
+}
+
+
+
+bool AtlasTexSheet::InsertTexture(BaseTexture * /*img*/)
+{
+    return false;
+}
+
+
+
+void AtlasTexSheet::RemoveTexture(BaseTexture *img)
+{
+    if(_textures.erase(img) == 0)
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "texture pointer argument was not contained within this texture sheet" << std::endl;
+}
+
+
+
+uint32 AtlasTexSheet::GetUsedArea()
+{
+    uint32 area = 0;
+    for(std::set<BaseTexture *>::const_iterator it = _textures.begin(); it != _textures.end(); ++it)
+        area += (*it)->width * (*it)->height;
+    return area;
+}
+
+
+
+bool AtlasTexSheet::PlaceTexture(BaseTexture *img, int32 x, int32 y)
+{
+    if(img == NULL) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL pointer was given as function argument" << std::endl;
+        return false;
     }
+
+    if(x < 0 || y < 0 || x + img->width > width || y + img->height > height) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "the texture doesn't fit in the texture sheet at: " << x << ", " << y << std::endl;
+        return false;
+    }
+
+    img->x = x;
+    img->y = y;
+
+    float sheet_width = static_cast<float>(width);
+    float sheet_height = static_cast<float>(height);
+
+    img->u1 = static_cast<float>(img->x + 0.5f) / sheet_width;
+    img->u2 = static_cast<float>(img->x + img->width - 0.5f) / sheet_width;
+    img->v1 = static_cast<float>(img->y + 0.5f) / sheet_height;
+    img->v2 = static_cast<float>(img->y + img->height - 0.5f) / sheet_height;
+
+    img->texture_sheet = this;
+    _textures.insert(img);
+
+    return true;
 }
 
 } // namespace private_video
@@ -36,8 +36,11 @@
 *** This sheet allows textures of any size to be inserted, but has slower
 *** performance than the FixedTexSheet.
 ***
-*** - <b>VariableTexNode</b>: represents a texture node entry for the
-*** VariableTexSheet class.
+*** - <b>SkylineNode</b> and <b>FreeTexRect</b>: represent the free space
+*** of the VariableTexSheet class.
+***
+*** - <b>AtlasTexSheet</b>: a texture sheet loaded from a baked texture atlas,
+*** whose textures are placed where the atlas manifest tells.
 *** ***************************************************************************/
 
 #ifndef __TEXTURE_HEADER__
@@ -65,8 +68,9 @@ enum TexSheetType {
     VIDEO_TEXSHEET_32x64 = 1,
     VIDEO_TEXSHEET_64x64 = 2,
     VIDEO_TEXSHEET_ANY = 3,
+    VIDEO_TEXSHEET_ATLAS = 4,
 
-    VIDEO_TEXSHEET_TOTAL = 4
+    VIDEO_TEXSHEET_TOTAL = 5
 };
 
 
@@ -143,6 +147,15 @@ public:
     //! \brief Returns the number of textures that are contained on this texture sheet
     virtual uint32 GetNumberTextures() = 0;
 
+    //! \brief Returns the number of pixels used by the textures contained on this texture sheet
+    virtual uint32 GetUsedArea() = 0;
+
+    /** \brief Returns how much the free space of the sheet is scattered
+    *** \return 0.0f when the free space is a single area, up to nearly 1.0f
+    *** when it is split into many small areas.
+    **/
+    virtual float GetFragmentation() = 0;
+
     /** \brief Unloads all texture memory used by OpenGL for this sheet
     *** \return Success/failure
     **/
@@ -186,6 +199,9 @@ public:
     **/
     void Smooth(bool flag = true);
 
+    //! \brief Binds the texture sheet, to draw from it directly
+    void Bind();
+
     /** \brief Draws the entire texture sheet to the screen
     *** This is used for debugging, as it draws all images contained within the texture to the screen.
     *** It ignores any blending or lighting properties that are enabled in the VideoManager
@@ -295,6 +311,15 @@ public:
     void RestoreTexture(BaseTexture *img);
 
     uint32 GetNumberTextures();
+
+    uint32 GetUsedArea() {
+        return GetNumberTextures() * _texture_width * _texture_height;
+    }
+
+    //! \note Any open block can hold any texture of this sheet, so there is no fragmentation.
+    float GetFragmentation() {
+        return 0.0f;
+    }
     //@}
 
 private:
@@ -332,30 +357,51 @@ private:
 
 
 /** ****************************************************************************
-*** \brief Keeps track of which images are used/freed in the variable texture mem manager
+*** \brief A horizontal segment of the skyline of a VariableTexSheet
+***
+*** The skyline is the lower limit of the space used at the top of the
+*** sheet: everything above the segment y coordinate is considered used,
+*** over the segment width.
 *** ***************************************************************************/
-class VariableTexNode
+class SkylineNode
 {
 public:
-    VariableTexNode() :
-        image(NULL), free_image(true) {}
+    SkylineNode(int32 x_, int32 y_, int32 width_) :
+        x(x_), y(y_), width(width_) {}
+
+    //! \brief The left coordinate, top coordinate and width of the segment, in pixels
+    int32 x, y, width;
+}; // class SkylineNode
 
-    //! \brief A pointer to the image
-    BaseTexture *image;
 
-    //! \brief Set to true if the image is freed
-    bool free_image;
-}; // class VariableTexNode
+/** ****************************************************************************
+*** \brief A free rectangle of a VariableTexSheet, which is not reachable from the skyline
+*** ***************************************************************************/
+class FreeTexRect
+{
+public:
+    FreeTexRect(int32 x_, int32 y_, int32 width_, int32 height_) :
+        x(x_), y(y_), width(width_), height(height_) {}
+
+    uint32 GetArea() const {
+        return width * height;
+    }
+
+    //! \brief The upper-left corner and size of the rectangle, in pixels
+    int32 x, y, width, height;
+}; // class FreeTexRect
 
 
 /** ****************************************************************************
 *** \brief Used to manage texture sheets of variable image sizes
 ***
-*** This class divides a texture sheet up into 16x16 pixel blocks, and keeps
-*** track of which images have allocated which blocks. This is done to reduce
-*** the time complexity for doing texture insertion and removal operations, but
-*** the downside is that it may leave some space in the texture sheet occupied
-*** but unused for images that are not divisible by 16 in width or height.
+*** This class packs the textures using a skyline: each new texture is placed
+*** right below the skyline where its bottom ends up being the highest. The space
+*** left between the texture and the skyline above it, as well as the space of
+*** removed textures, is kept in a list of free rectangles which are tried first.
+***
+*** When the sheet gets too fragmented over time, TextureController::DefragmentTexSheets()
+*** can repack its textures from scratch.
 *** ***************************************************************************/
 class VariableTexSheet : public TexSheet
 {
@@ -380,37 +426,142 @@ public:
     void RemoveTexture(BaseTexture *img);
 
     void FreeTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, true);
+        _SetFreeFlag(img, true);
     }
 
     void RestoreTexture(BaseTexture *img) {
-        _SetBlockProperties(img, img, false);
+        _SetFreeFlag(img, false);
     }
 
     uint32 GetNumberTextures() {
         return _textures.size();
     }
+
+    uint32 GetUsedArea();
+
+    float GetFragmentation();
     //@}
 
+    /** \brief Gets the textures in use contained in this sheet, the freed ones excepted
+    *** \param textures The vector the textures are appended to
+    **/
+    void GetTextures(std::vector<BaseTexture *> &textures) const;
+
 private:
-    /** \brief The list of 16x16 pixel blocks in the sheet.
-    *** The size of this structure is: (width / 16) * (height / 16)
+    //! \brief The skyline segments, sorted from left to right and covering the whole sheet width.
+    std::vector<SkylineNode> _skyline;
+
+    //! \brief The free rectangles below the skyline.
+    std::vector<FreeTexRect> _free_rects;
+
+    /** \brief A map containing each texture that has been inserted into this class
+    *** The value tells whether the texture was freed, in which case its space
+    *** may be reclaimed when a new texture doesn't fit anywhere else.
     **/
-    VariableTexNode *_blocks;
+    std::map<BaseTexture *, bool> _textures;
+
+    //! \brief Makes the whole sheet space free again.
+    void _ResetFreeSpace();
 
-    /** \brief A set containing each texture that has been inserted into this class
-    *** This container is used to be able to quickly determine if a texture is loaded by an object of this class
+    /** \brief Finds a place for a texture of the given size, and marks it as used
+    *** \param w The width of the texture
+    *** \param h The height of the texture
+    *** \param x Set to the left coordinate of the texture
+    *** \param y Set to the top coordinate of the texture
+    *** \return false when there is no room left for the texture
     **/
-    std::set<BaseTexture *> _textures;
+    bool _Allocate(int32 w, int32 h, int32 &x, int32 &y);
+
+    /** \brief Tells where a texture would be placed on the given skyline segment
+    *** \param index The index of the skyline segment where the texture left side would be
+    *** \param w The width of the texture
+    *** \param h The height of the texture
+    *** \param y Set to the top coordinate of the texture
+    *** \return false if the texture doesn't fit there
+    **/
+    bool _FitsOnSkyline(uint32 index, int32 w, int32 h, int32 &y) const;
+
+    //! \brief Lowers the skyline below a newly placed texture, starting from the given segment.
+    void _AddSkylineLevel(uint32 index, int32 x, int32 y, int32 w, int32 h);
+
+    //! \brief Uses the upper-left part of the given free rectangle, and keeps the remaining space.
+    void _SplitFreeRect(uint32 index, int32 w, int32 h);
 
-    /** \brief Updates the properties of all of the blocks associated with a given texture
+    //! \brief Merges the free rectangles sharing a whole edge together.
+    void _MergeFreeRects();
+
+    //! \brief Removes the freed textures to reclaim their space. Returns false if there were none.
+    bool _RemoveFreedTextures();
+
+    /** \brief Updates the free status flag of a texture
     *** \param tex The texture to update
-    *** \param new_tex The texture pointer to set the block to
-    *** \param new_image The boolean value to set the free status flag to
+    *** \param free The boolean value to set the free status flag to
     **/
-    void _SetBlockProperties(BaseTexture *tex, BaseTexture *new_tex, bool free);
+    void _SetFreeFlag(BaseTexture *tex, bool free);
 }; // class VariableTexSheet : public TexSheet
 
+
+/** ****************************************************************************
+*** \brief Used to manage the texture sheets of baked texture atlases
+***
+*** The textures positions are decided offline when baking the atlas, so
+*** textures can't be inserted in this sheet, only placed where the atlas
+*** manifest tells. The space of removed textures isn't reused either, the
+*** sheet is deleted once it holds no more textures.
+*** ***************************************************************************/
+class AtlasTexSheet : public TexSheet
+{
+public:
+    /** \brief Constructs a new texture sheet
+    *** \param sheet_width The width of the sheet
+    *** \param sheet_height The height of the sheet
+    *** \param sheet_id The OpenGL texture ID value for the sheet
+    **/
+    AtlasTexSheet(int32 sheet_width, int32 sheet_height, GLuint sheet_id);
+
+    ~AtlasTexSheet();
+
+    //! \name Methods inherited from TexSheet
+    //@{
+    //! \note Always fails, as the textures can only be placed.
+    bool AddTexture(BaseTexture *img, ImageMemory &data);
+
+    //! \note Always fails, as the textures can only be placed.
+    bool InsertTexture(BaseTexture *img);
+
+    void RemoveTexture(BaseTexture *img);
+
+    void FreeTexture(BaseTexture * /*img*/)
+    {}
+
+    void RestoreTexture(BaseTexture * /*img*/)
+    {}
+
+    uint32 GetNumberTextures() {
+        return _textures.size();
+    }
+
+    uint32 GetUsedArea();
+
+    //! \note The free space is never reused, so there is no fragmentation.
+    float GetFragmentation() {
+        return 0.0f;
+    }
+    //@}
+
+    /** \brief Adds a texture to the sheet at the given position
+    *** \param img A pointer to the texture to place
+    *** \param x The left coordinate of the texture in the sheet
+    *** \param y The top coordinate of the texture in the sheet
+    *** \return false if the texture doesn't fit in the sheet at this position
+    **/
+    bool PlaceTexture(BaseTexture *img, int32 x, int32 y);
+
+private:
+    //! \brief The textures placed in this sheet
+    std::set<BaseTexture *> _textures;
+}; // class AtlasTexSheet : public TexSheet
+
 }  // namespace private_video
 
 }  // namespace vt_video
@@ -0,0 +1,471 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    texture_atlas.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the texture atlases baked offline.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "texture_atlas.h"
+
+#include "video.h"
+
+#include "utils/utils_files.h"
+#include "utils/utils_numeric.h"
+#include "utils/utils_strings.h"
+
+using namespace vt_utils;
+using namespace vt_video::private_video;
+
+namespace vt_video
+{
+
+//! \brief The texture atlas manifest format version. Increase it whenever the format changes.
+const uint32 TEXTURE_ATLAS_VERSION = 1;
+
+//! \brief The maximum width and height of an atlas page, in pixels.
+const uint32 TEXTURE_ATLAS_PAGE_SIZE = 1024;
+
+//! \brief The number of border pixels copied around each element, to avoid sampling its neighbours.
+const uint32 TEXTURE_ATLAS_PADDING = 1;
+
+//! \brief An element to pack while baking an atlas.
+struct BakedElement {
+    uint32 source;
+    uint32 row, col;
+    uint32 width, height;
+    uint32 page;
+    uint32 x, y;
+};
+
+static bool CompareBakedElements(const BakedElement &one, const BakedElement &another)
+{
+    return one.height > another.height;
+}
+
+TextureAtlas::TextureAtlas()
+{}
+
+TextureAtlas::~TextureAtlas()
+{
+    Clear();
+}
+
+bool TextureAtlas::Load(const std::string &manifest_filename)
+{
+    if(!ReadManifest(manifest_filename))
+        return false;
+
+    if(!IsUpToDate()) {
+        PRINT_WARNING << "The texture atlas is older than its images, it should be baked again: " << manifest_filename << std::endl;
+        Clear();
+        return false;
+    }
+
+    bool success = true;
+    for(uint32 i = 0; i < _pages.size(); ++i) {
+        if(!UploadPage(i))
+            success = false;
+    }
+
+    if(!success)
+        PRINT_WARNING << "Failed to load the whole texture atlas: " << manifest_filename << std::endl;
+    return success;
+}
+
+bool TextureAtlas::ReadManifest(const std::string &manifest_filename)
+{
+    Clear();
+
+    std::ifstream file(manifest_filename.c_str());
+    if(!file)
+        return false;
+
+    std::string keyword;
+    uint32 version = 0;
+    if(!(file >> keyword >> version) || keyword != "version" || version != TEXTURE_ATLAS_VERSION) {
+        PRINT_WARNING << "Invalid texture atlas manifest version in: " << manifest_filename << std::endl;
+        return false;
+    }
+
+    // The number of elements announced for each page
+    std::vector<uint32> num_elements;
+
+    while(file >> keyword) {
+        if(keyword == "source") {
+            std::string filename;
+            file >> filename;
+            _sources.push_back(filename);
+        } else if(keyword == "page") {
+            _pages.push_back(Page());
+            num_elements.push_back(0);
+            Page &page = _pages.back();
+            file >> page.filename >> page.width >> page.height >> num_elements.back();
+            page.elements.reserve(num_elements.back());
+        } else if(keyword == "element" && !_pages.empty()) {
+            Element element;
+            file >> element.filename >> element.tags >> element.x >> element.y >> element.width >> element.height;
+            _pages.back().elements.push_back(element);
+        } else {
+            PRINT_WARNING << "Unexpected '" << keyword << "' in texture atlas manifest: " << manifest_filename << std::endl;
+            Clear();
+            return false;
+        }
+
+        if(file.fail()) {
+            PRINT_WARNING << "Invalid '" << keyword << "' line in texture atlas manifest: " << manifest_filename << std::endl;
+            Clear();
+            return false;
+        }
+    }
+
+    for(uint32 i = 0; i < _pages.size(); ++i) {
+        if(_pages[i].elements.size() != num_elements[i]) {
+            PRINT_WARNING << "Missing elements in texture atlas manifest: " << manifest_filename << std::endl;
+            Clear();
+            return false;
+        }
+    }
+
+    _manifest_filename = manifest_filename;
+    return true;
+} // bool TextureAtlas::ReadManifest(const std::string &manifest_filename)
+
+bool TextureAtlas::IsUpToDate() const
+{
+    time_t manifest_time = GetFileModificationTime(_manifest_filename);
+    if(manifest_time <= 0)
+        return false;
+
+    for(uint32 i = 0; i < _sources.size(); ++i) {
+        if(GetFileModificationTime(_sources[i]) > manifest_time)
+            return false;
+    }
+
+    for(uint32 i = 0; i < _pages.size(); ++i) {
+        if(GetFileModificationTime(_pages[i].filename) <= 0)
+            return false;
+    }
+    return true;
+}
+
+bool TextureAtlas::DecodePages()
+{
+    bool success = true;
+    for(uint32 i = 0; i < _pages.size(); ++i) {
+        Page &page = _pages[i];
+        if(page.uploaded || page.image.pixels != NULL)
+            continue;
+
+        if(!page.image.LoadImage(page.filename)) {
+            PRINT_WARNING << "Failed to decode the texture atlas page: " << page.filename << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool TextureAtlas::UploadPage(uint32 index)
+{
+    if(index >= _pages.size()) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "invalid page index: " << index << std::endl;
+        return false;
+    }
+
+    Page &page = _pages[index];
+    if(page.uploaded)
+        return true;
+
+    // The page is only needed when some of its elements aren't in texture memory yet
+    bool need_upload = false;
+    for(uint32 i = 0; i < page.elements.size() && !need_upload; ++i) {
+        const Element &element = page.elements[i];
+        need_upload = !TextureManager->_IsImageTextureRegistered(element.filename + element.tags);
+    }
+
+    AtlasTexSheet *sheet = NULL;
+    if(need_upload) {
+        if(page.image.pixels == NULL && !page.image.LoadImage(page.filename)) {
+            PRINT_ERROR << "Failed to load the texture atlas page: " << page.filename << std::endl;
+            return false;
+        }
+
+        if(page.image.width != page.width || page.image.height != page.height) {
+            PRINT_ERROR << "The texture atlas page size doesn't match its manifest: " << page.filename << std::endl;
+            free(page.image.pixels);
+            page.image.pixels = NULL;
+            return false;
+        }
+
+        sheet = static_cast<AtlasTexSheet *>(TextureManager->_CreateTexSheet(page.width, page.height, VIDEO_TEXSHEET_ATLAS, true));
+        if(sheet == NULL || !sheet->CopyRect(0, 0, page.image)) {
+            PRINT_ERROR << "Failed to upload the texture atlas page: " << page.filename << std::endl;
+            if(sheet != NULL)
+                TextureManager->_RemoveSheet(sheet);
+            free(page.image.pixels);
+            page.image.pixels = NULL;
+            return false;
+        }
+    }
+
+    if(page.image.pixels != NULL) {
+        free(page.image.pixels);
+        page.image.pixels = NULL;
+    }
+
+    for(uint32 i = 0; i < page.elements.size(); ++i) {
+        const Element &element = page.elements[i];
+
+        ImageTexture *img = TextureManager->_GetImageTexture(element.filename + element.tags);
+        if(img == NULL) {
+            img = new ImageTexture(element.filename, element.tags, element.width, element.height);
+            if(!sheet->PlaceTexture(img, element.x, element.y)) {
+                PRINT_WARNING << "Invalid element position in texture atlas page: " << page.filename << std::endl;
+                delete img;
+                continue;
+            }
+        }
+
+        img->AddReference();
+        _textures.push_back(img);
+    }
+
+    if(sheet != NULL && sheet->GetNumberTextures() == 0)
+        TextureManager->_RemoveSheet(sheet);
+
+    page.uploaded = true;
+    return true;
+} // bool TextureAtlas::UploadPage(uint32 index)
+
+bool TextureAtlas::HasSource(const std::string &filename) const
+{
+    return std::find(_sources.begin(), _sources.end(), filename) != _sources.end();
+}
+
+void TextureAtlas::Clear()
+{
+    for(uint32 i = 0; i < _textures.size(); ++i) {
+        ImageTexture *img = _textures[i];
+        if(!img->RemoveReference())
+            continue;
+
+        TexSheet *sheet = img->texture_sheet;
+        sheet->RemoveTexture(img);
+        delete img;
+
+        // The space of baked atlases isn't reused, so they are deleted once empty
+        if(sheet->type == VIDEO_TEXSHEET_ATLAS && sheet->GetNumberTextures() == 0)
+            TextureManager->_RemoveSheet(sheet);
+    }
+    _textures.clear();
+
+    _FreePagesImages();
+    _pages.clear();
+    _sources.clear();
+    _manifest_filename.clear();
+}
+
+void TextureAtlas::_FreePagesImages()
+{
+    for(uint32 i = 0; i < _pages.size(); ++i) {
+        if(_pages[i].image.pixels != NULL)
+            free(_pages[i].image.pixels);
+        _pages[i].image.pixels = NULL;
+    }
+}
+
+bool TextureAtlas::Bake(const std::vector<TextureAtlasSource> &sources, const std::string &manifest_filename)
+{
+    const uint32 padding = TEXTURE_ATLAS_PADDING;
+    bool success = true;
+
+    // Decode the multi images, and list their elements
+    std::vector<ImageMemory> images(sources.size());
+    std::vector<BakedElement> elements;
+    for(uint32 i = 0; i < sources.size() && success; ++i) {
+        const TextureAtlasSource &source = sources[i];
+        if(source.grid_rows == 0 || source.grid_cols == 0 || !images[i].LoadImage(source.filename)) {
+            PRINT_ERROR << "Couldn't load the texture atlas image: " << source.filename << std::endl;
+            success = false;
+            break;
+        }
+
+        BakedElement element;
+        element.source = i;
+        element.width = images[i].width / source.grid_cols;
+        element.height = images[i].height / source.grid_rows;
+        element.page = 0;
+        element.x = 0;
+        element.y = 0;
+
+        // Larger elements would also get their own texture sheet at runtime.
+        if(element.width + 2 * padding > TEXTURE_ATLAS_PAGE_SIZE || element.height + 2 * padding > TEXTURE_ATLAS_PAGE_SIZE
+                || element.width > 512 || element.height > 512) {
+            PRINT_ERROR << "The elements of this image are too large for a texture atlas: " << source.filename << std::endl;
+            success = false;
+            break;
+        }
+
+        for(element.row = 0; element.row < source.grid_rows; ++element.row) {
+            for(element.col = 0; element.col < source.grid_cols; ++element.col)
+                elements.push_back(element);
+        }
+    }
+
+    // Pack the elements on shelves, the tallest first
+    std::stable_sort(elements.begin(), elements.end(), CompareBakedElements);
+
+    std::vector<uint32> page_widths;
+    std::vector<uint32> page_heights;
+    uint32 shelf_x = 0;
+    uint32 shelf_y = 0;
+    uint32 shelf_height = 0;
+    for(uint32 i = 0; i < elements.size() && success; ++i) {
+        BakedElement &element = elements[i];
+        uint32 width = element.width + 2 * padding;
+        uint32 height = element.height + 2 * padding;
+
+        if(page_widths.empty()) {
+            page_widths.push_back(0);
+            page_heights.push_back(0);
+        }
+
+        // Start a new shelf, and a new page when the shelf doesn't fit
+        if(shelf_x + width > TEXTURE_ATLAS_PAGE_SIZE) {
+            shelf_x = 0;
+            shelf_y += shelf_height;
+            shelf_height = 0;
+        }
+        if(shelf_y + height > TEXTURE_ATLAS_PAGE_SIZE) {
+            page_widths.push_back(0);
+            page_heights.push_back(0);
+            shelf_x = 0;
+            shelf_y = 0;
+            shelf_height = 0;
+        }
+
+        element.page = page_widths.size() - 1;
+        element.x = shelf_x + padding;
+        element.y = shelf_y + padding;
+
+        shelf_x += width;
+        shelf_height = std::max(shelf_height, height);
+        page_widths.back() = std::max(page_widths.back(), shelf_x);
+        page_heights.back() = std::max(page_heights.back(), shelf_y + shelf_height);
+    }
+
+    // Build the pages images, each element surrounded by copies of its border pixels
+    std::string page_prefix = manifest_filename;
+    size_t extension = page_prefix.rfind('.');
+    if(extension != std::string::npos && page_prefix.find('/', extension) == std::string::npos)
+        page_prefix.erase(extension);
+
+    std::vector<std::string> page_filenames;
+    for(uint32 page = 0; page < page_widths.size() && success; ++page) {
+        ImageMemory page_image;
+        page_image.width = RoundUpPow2(page_widths[page]);
+        page_image.height = RoundUpPow2(page_heights[page]);
+        page_image.pixels = calloc(page_image.width * page_image.height, 4);
+        if(page_image.pixels == NULL) {
+            PRINT_ERROR << "failed to malloc memory for a texture atlas page" << std::endl;
+            success = false;
+            break;
+        }
+
+        for(uint32 i = 0; i < elements.size(); ++i) {
+            const BakedElement &element = elements[i];
+            if(element.page != page)
+                continue;
+
+            const ImageMemory &source = images[element.source];
+            for(int32 y = -static_cast<int32>(padding); y < static_cast<int32>(element.height + padding); ++y) {
+                int32 source_y = std::min(std::max(y, 0), static_cast<int32>(element.height) - 1) + element.row * element.height;
+                for(int32 x = -static_cast<int32>(padding); x < static_cast<int32>(element.width + padding); ++x) {
+                    int32 source_x = std::min(std::max(x, 0), static_cast<int32>(element.width) - 1) + element.col * element.width;
+                    memcpy((uint8 *)page_image.pixels + ((element.y + y) * page_image.width + element.x + x) * 4,
+                           (uint8 *)source.pixels + (source_y * source.width + source_x) * 4, 4);
+                }
+            }
+        }
+
+        page_filenames.push_back(page_prefix + "_" + NumberToString(page) + ".png");
+        if(!page_image.SaveImage(page_filenames.back())) {
+            PRINT_ERROR << "Couldn't write the texture atlas page: " << page_filenames.back() << std::endl;
+            success = false;
+        }
+
+        page_widths[page] = page_image.width;
+        page_heights[page] = page_image.height;
+        free(page_image.pixels);
+        page_image.pixels = NULL;
+    }
+
+    for(uint32 i = 0; i < images.size(); ++i) {
+        if(images[i].pixels != NULL)
+            free(images[i].pixels);
+        images[i].pixels = NULL;
+    }
+
+    if(!success)
+        return false;
+
+    // Write the manifest last, so that it is only more recent than the images when complete.
+    std::string temp_filename = manifest_filename + ".tmp";
+    std::ofstream file(temp_filename.c_str(), std::ios::out | std::ios::trunc);
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the texture atlas manifest for writing: " << temp_filename << std::endl;
+        return false;
+    }
+
+    file << "version " << TEXTURE_ATLAS_VERSION << std::endl;
+    for(uint32 i = 0; i < sources.size(); ++i)
+        file << "source " << sources[i].filename << std::endl;
+
+    for(uint32 page = 0; page < page_filenames.size(); ++page) {
+        uint32 num_elements = 0;
+        for(uint32 i = 0; i < elements.size(); ++i) {
+            if(elements[i].page == page)
+                ++num_elements;
+        }
+
+        file << "page " << page_filenames[page] << " " << page_widths[page] << " " << page_heights[page]
+             << " " << num_elements << std::endl;
+
+        for(uint32 i = 0; i < elements.size(); ++i) {
+            const BakedElement &element = elements[i];
+            if(element.page != page)
+                continue;
+
+            const TextureAtlasSource &source = sources[element.source];
+            // The same tags as the ones of ImageDescriptor::LoadMultiImageFromElementGrid()
+            file << "element " << source.filename
+                 << " <X" << element.row << "_" << source.grid_rows << ">"
+                 << "<Y" << element.col << "_" << source.grid_cols << ">"
+                 << " " << element.x << " " << element.y << " " << element.width << " " << element.height << std::endl;
+        }
+    }
+
+    file.close();
+    if(file.fail()) {
+        PRINT_ERROR << "Couldn't write the texture atlas manifest: " << temp_filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+
+    if(!MoveFile(temp_filename, manifest_filename)) {
+        PRINT_ERROR << "Couldn't create the texture atlas manifest: " << manifest_filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+    return true;
+} // bool TextureAtlas::Bake(const std::vector<TextureAtlasSource> &sources, const std::string &manifest_filename)
+
+} // namespace vt_video
@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    texture_atlas.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the texture atlases baked offline.
+***
+*** Multi images (tilesets, sprite sheets) are normally decoded and cut into
+*** their elements at runtime, each element being inserted in a texture sheet.
+*** The texture atlases pack the elements of several multi images into a few
+*** large pages, each element padded with a copy of its border pixels. Those
+*** pages are baked offline along with a manifest telling where each element
+*** is, so that the elements can be registered at once in the texture
+*** controller. The multi images loaded afterwards then find all of their
+*** elements already in texture memory.
+***
+*** The manifest is a plain text file:
+*** \code
+*** version 1
+*** source <multi image filename>
+*** page <page image filename> <width> <height> <number of elements>
+*** element <multi image filename> <element tags> <x> <y> <width> <height>
+*** \endcode
+*** Each page line is followed by the lines of the elements it contains.
+***
+*** \note Only the map tilesets are baked for now. The sprite sheets a map uses
+*** are only known once its script has run, so they are still decoded at
+*** runtime. The baker and the manifest accept any multi image grid though,
+*** so they can be added once the map data lists them.
+*** ***************************************************************************/
+
+#ifndef __TEXTURE_ATLAS_HEADER__
+#define __TEXTURE_ATLAS_HEADER__
+
+#include "image_base.h"
+
+namespace vt_video
+{
+
+//! \brief A multi image to pack in a texture atlas, split in a grid of elements.
+class TextureAtlasSource
+{
+public:
+    TextureAtlasSource(const std::string &filename_, uint32 grid_rows_, uint32 grid_cols_) :
+        filename(filename_), grid_rows(grid_rows_), grid_cols(grid_cols_) {}
+
+    //! \brief The multi image filename.
+    std::string filename;
+
+    //! \brief The number of rows and columns of elements in the multi image.
+    uint32 grid_rows, grid_cols;
+};
+
+/** ****************************************************************************
+*** \brief Loads a baked texture atlas into texture memory
+***
+*** The atlas elements are registered under the same filename and tags as
+*** the ones given by ImageDescriptor::LoadMultiImageFromElementGrid(), and
+*** are kept referenced by this object until it is cleared or destroyed.
+***
+*** \note The manifest reading and the pages decoding don't use OpenGL nor
+*** the script engine, so they can be done by a background thread. The
+*** pages upload must be done by the main thread.
+*** ***************************************************************************/
+class TextureAtlas
+{
+public:
+    TextureAtlas();
+
+    //! \brief Releases the atlas elements references.
+    ~TextureAtlas();
+
+    /** \brief Loads the atlas manifest and uploads all of its pages
+    *** \param manifest_filename The atlas manifest filename
+    *** \return false if the atlas doesn't exist, isn't up to date or couldn't be loaded
+    *** \note Nothing is reported when the manifest doesn't exist, as atlases are optional.
+    **/
+    bool Load(const std::string &manifest_filename);
+
+    /** \brief Reads the atlas manifest
+    *** \param manifest_filename The atlas manifest filename
+    *** \return false if the manifest doesn't exist or is invalid
+    **/
+    bool ReadManifest(const std::string &manifest_filename);
+
+    //! \brief Tells whether the manifest is more recent than every multi image packed in the atlas.
+    bool IsUpToDate() const;
+
+    //! \brief Decodes the page images that still have elements to upload.
+    bool DecodePages();
+
+    /** \brief Uploads a page to a new texture sheet, and registers its elements
+    *** \param index The page index
+    *** \return Success/failure
+    ***
+    *** The page image is decoded first if needed. The elements already in texture
+    *** memory, for instance when the atlas is loaded twice, are only referenced.
+    **/
+    bool UploadPage(uint32 index);
+
+    //! \brief Returns the number of pages of the atlas.
+    uint32 GetNumberPages() const {
+        return _pages.size();
+    }
+
+    //! \brief Tells whether the given multi image is packed in the atlas.
+    bool HasSource(const std::string &filename) const;
+
+    //! \brief Releases the atlas elements references and forgets the manifest.
+    void Clear();
+
+    /** \brief Packs the given multi images into atlas pages and writes them along with their manifest
+    *** \param sources The multi images to pack
+    *** \param manifest_filename The manifest filename. The pages are written next to it.
+    *** \return Success/failure
+    ***
+    *** \note The multi images are decoded with ImageMemory::LoadImage(), which
+    *** needs an SDL video surface to convert the images to the display format.
+    **/
+    static bool Bake(const std::vector<TextureAtlasSource> &sources, const std::string &manifest_filename);
+
+private:
+    //! \brief The position of an element in an atlas page.
+    class Element
+    {
+    public:
+        std::string filename;
+
+        std::string tags;
+
+        int32 x, y;
+
+        uint32 width, height;
+    };
+
+    //! \brief An atlas page, uploaded to its own texture sheet.
+    class Page
+    {
+    public:
+        Page() :
+            width(0), height(0), uploaded(false) {}
+
+        std::string filename;
+
+        uint32 width, height;
+
+        std::vector<Element> elements;
+
+        //! \brief The decoded page image, or NULL pixels when not decoded.
+        private_video::ImageMemory image;
+
+        //! \brief Set once the page elements are registered.
+        bool uploaded;
+    };
+
+    //! \brief The manifest filename.
+    std::string _manifest_filename;
+
+    //! \brief The multi images packed in the atlas.
+    std::vector<std::string> _sources;
+
+    //! \brief The atlas pages.
+    std::vector<Page> _pages;
+
+    //! \brief The elements referenced by this object.
+    std::vector<private_video::ImageTexture *> _textures;
+
+    //! \brief Frees the decoded pages images.
+    void _FreePagesImages();
+}; // class TextureAtlas
+
+} // namespace vt_video
+
+#endif // __TEXTURE_ATLAS_HEADER__
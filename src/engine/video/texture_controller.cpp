@@ -119,26 +119,8 @@ bool TextureController::UnloadTextures()
         ++i;
     }
 
-    // Clear all font caches
-    std::map<std::string, FontProperties *>::iterator j = TextManager->_font_map.begin();
-    std::map<std::string, FontProperties *>::const_iterator j_end = TextManager->_font_map.end();
-    while(j != j_end) {
-        std::vector<FontGlyph *>* glyph_cache = j->second->glyph_cache;
-
-        if(glyph_cache) {
-            std::vector<vt_video::FontGlyph *>::iterator it_end = glyph_cache->end();
-            for(std::vector<FontGlyph *>::iterator k = glyph_cache->begin();
-                    k != it_end; ++k) {
-                if(*k)
-                    _DeleteTexture((*k)->texture);
-                delete *k;
-            }
-
-            glyph_cache->clear();
-        }
-
-        ++j;
-    }
+    // Unload the font glyph atlases, the glyphs keep their places in them
+    TextManager->_UnloadGlyphTextures();
 
     return success;
 } // bool TextureController::UnloadTextures()
@@ -164,6 +146,12 @@ bool TextureController::ReloadTextures()
         ++i;
     }
 
+    // Render the cached font glyphs again in their atlases
+    if(TextManager->_ReloadGlyphTextures() == false) {
+        IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to reload the font glyph textures" << std::endl;
+        success = false;
+    }
+
     _DeleteTempTextures();
 
     return success;
@@ -171,6 +159,201 @@ bool TextureController::ReloadTextures()
 
 
 
+//! \brief The place of a texture in its texture sheet.
+struct TexPlacement {
+    TexSheet *sheet;
+    int32 x, y;
+    float u1, v1, u2, v2;
+};
+
+static void GetTexPlacement(const BaseTexture *texture, TexPlacement &placement)
+{
+    placement.sheet = texture->texture_sheet;
+    placement.x = texture->x;
+    placement.y = texture->y;
+    placement.u1 = texture->u1;
+    placement.v1 = texture->v1;
+    placement.u2 = texture->u2;
+    placement.v2 = texture->v2;
+}
+
+static void SetTexPlacement(BaseTexture *texture, const TexPlacement &placement)
+{
+    texture->texture_sheet = placement.sheet;
+    texture->x = placement.x;
+    texture->y = placement.y;
+    texture->u1 = placement.u1;
+    texture->v1 = placement.v1;
+    texture->u2 = placement.u2;
+    texture->v2 = placement.v2;
+}
+
+//! \brief An image read back from a texture sheet, waiting to be packed again.
+struct RepackedImage {
+    BaseTexture *texture;
+    void *pixels;
+
+    //! \brief The place of the image in its former texture sheet.
+    TexPlacement placement;
+};
+
+static bool CompareRepackedImages(const RepackedImage &one, const RepackedImage &another)
+{
+    if(one.texture->height != another.texture->height)
+        return one.texture->height > another.texture->height;
+    return one.texture->width > another.texture->width;
+}
+
+uint32 TextureController::DefragmentTexSheets(bool force)
+{
+    // Gather the shared static sheets holding images of various sizes, and the images still referenced
+    std::vector<VariableTexSheet *> sheets;
+    std::vector<std::vector<BaseTexture *> > sheet_textures;
+    uint32 used_area = 0;
+    for(uint32 i = 0; i < _tex_sheets.size(); ++i) {
+        TexSheet *sheet = _tex_sheets[i];
+        if(sheet == NULL || !sheet->loaded || !sheet->is_static || sheet->type != VIDEO_TEXSHEET_ANY)
+            continue;
+        if(sheet->width != 512 || sheet->height != 512)
+            continue;
+
+        // Sheets of this type are always created as variable texture sheets
+        sheets.push_back(static_cast<VariableTexSheet *>(sheet));
+
+        std::vector<BaseTexture *> textures;
+        sheets.back()->GetTextures(textures);
+        sheet_textures.push_back(std::vector<BaseTexture *>());
+        for(uint32 j = 0; j < textures.size(); ++j) {
+            if(textures[j]->ref_count <= 0)
+                continue;
+            sheet_textures.back().push_back(textures[j]);
+            used_area += textures[j]->width * textures[j]->height;
+        }
+    }
+
+    if(sheets.empty())
+        return 0;
+
+    // Only repack when the images could fit in fewer sheets
+    const uint32 sheet_area = 512 * 512;
+    if(!force && (used_area + sheet_area - 1) / sheet_area >= sheets.size())
+        return 0;
+
+    // The pending images must be drawn before their texture sheet content changes.
+    VideoManager->FlushSpriteBatch();
+
+    // Read back the pixels of every image, one sheet at a time
+    std::vector<RepackedImage> images;
+    bool read_back = true;
+    for(uint32 i = 0; i < sheets.size() && read_back; ++i) {
+        const std::vector<BaseTexture *> &textures = sheet_textures[i];
+        if(textures.empty())
+            continue;
+
+        ImageMemory sheet_memory;
+        sheet_memory.CopyFromTexture(sheets[i]);
+        if(sheet_memory.pixels == NULL) {
+            IF_PRINT_WARNING(VIDEO_DEBUG) << "could not read back a texture sheet, aborting the defragmentation" << std::endl;
+            read_back = false;
+            break;
+        }
+
+        for(uint32 j = 0; j < textures.size(); ++j) {
+            BaseTexture *texture = textures[j];
+            RepackedImage image;
+            image.texture = texture;
+            GetTexPlacement(texture, image.placement);
+            image.pixels = malloc(texture->width * texture->height * 4);
+            if(image.pixels == NULL) {
+                PRINT_ERROR << "failed to malloc enough memory to copy the image" << std::endl;
+                read_back = false;
+                break;
+            }
+
+            for(uint32 row = 0; row < texture->height; ++row) {
+                memcpy((uint8 *)image.pixels + row * texture->width * 4,
+                       (uint8 *)sheet_memory.pixels + ((texture->y + row) * sheet_memory.width + texture->x) * 4,
+                       texture->width * 4);
+            }
+            images.push_back(image);
+        }
+
+        free(sheet_memory.pixels);
+        sheet_memory.pixels = NULL;
+    }
+
+    // Packing the tallest images first keeps the skyline flat
+    std::sort(images.begin(), images.end(), CompareRepackedImages);
+
+    // The images are packed into new sheets, leaving the former ones untouched until all of them fit.
+    std::vector<TexSheet *> new_sheets;
+    bool packed = read_back;
+    for(uint32 i = 0; i < images.size() && packed; ++i) {
+        ImageMemory image_memory;
+        image_memory.width = images[i].texture->width;
+        image_memory.height = images[i].texture->height;
+        image_memory.pixels = images[i].pixels;
+
+        bool added = false;
+        for(uint32 j = 0; j < new_sheets.size() && !added; ++j)
+            added = new_sheets[j]->AddTexture(images[i].texture, image_memory);
+
+        if(!added) {
+            TexSheet *sheet = _CreateTexSheet(512, 512, VIDEO_TEXSHEET_ANY, true);
+            if(sheet != NULL) {
+                new_sheets.push_back(sheet);
+                added = sheet->AddTexture(images[i].texture, image_memory);
+            }
+        }
+
+        if(!added) {
+            PRINT_ERROR << "could not pack an image again while defragmenting the texture sheets, keeping the former ones" << std::endl;
+            packed = false;
+        }
+        image_memory.pixels = NULL;
+    }
+
+    for(uint32 i = 0; i < images.size(); ++i)
+        free(images[i].pixels);
+
+    if(!packed) {
+        // Put the images back in place, and drop the new sheets.
+        for(uint32 i = 0; i < images.size(); ++i) {
+            BaseTexture *texture = images[i].texture;
+            if(texture->texture_sheet != images[i].placement.sheet)
+                texture->texture_sheet->RemoveTexture(texture);
+            SetTexPlacement(texture, images[i].placement);
+        }
+        for(uint32 i = 0; i < new_sheets.size(); ++i)
+            _RemoveSheet(new_sheets[i]);
+        return 0;
+    }
+
+    // Every image has its new place: remove them from the former sheets, where they are known by their former place.
+    for(uint32 i = 0; i < images.size(); ++i) {
+        TexPlacement placement;
+        GetTexPlacement(images[i].texture, placement);
+        SetTexPlacement(images[i].texture, images[i].placement);
+        images[i].placement.sheet->RemoveTexture(images[i].texture);
+        SetTexPlacement(images[i].texture, placement);
+    }
+
+    // Delete the former sheets left empty. The ones still holding freed textures are kept.
+    uint32 num_removed = 0;
+    for(uint32 i = 0; i < sheets.size(); ++i) {
+        if(sheets[i]->GetNumberTextures() == 0) {
+            _RemoveSheet(sheets[i]);
+            ++num_removed;
+        }
+    }
+
+    uint32 num_released = (num_removed > new_sheets.size()) ? num_removed - new_sheets.size() : 0;
+    IF_PRINT_DEBUG(VIDEO_DEBUG) << "texture sheets defragmented, " << num_released << " sheet(s) released" << std::endl;
+    return num_released;
+} // uint32 TextureController::DefragmentTexSheets(bool force)
+
+
+
 void TextureController::DEBUG_NextTexSheet()
 {
     debug_current_sheet++;
@@ -251,6 +434,8 @@ void TextureController::DEBUG_ShowTexSheet()
         sprintf(buf, "  Type:    64x64");
     else if(sheet->type == VIDEO_TEXSHEET_ANY)
         sprintf(buf, "  Type:    Any size");
+    else if(sheet->type == VIDEO_TEXSHEET_ATLAS)
+        sprintf(buf, "  Type:    Atlas");
     else
         sprintf(buf, "  Type:    Unknown");
 
@@ -265,6 +450,37 @@ void TextureController::DEBUG_ShowTexSheet()
     VideoManager->MoveRelative(0, 20);
     TextManager->Draw(buf);
 
+    sprintf(buf, "  Images:  %u", sheet->GetNumberTextures());
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Used:    %.1f%%", 100.0f * sheet->GetUsedArea() / (sheet->width * sheet->height));
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    sprintf(buf, "  Frag:    %.1f%%", 100.0f * sheet->GetFragmentation());
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    // The occupancy over all the texture sheets
+    uint32 total_area = 0;
+    uint32 total_used_area = 0;
+    for(uint32 i = 0; i < _tex_sheets.size(); ++i) {
+        if(_tex_sheets[i] == NULL)
+            continue;
+        total_area += _tex_sheets[i]->width * _tex_sheets[i]->height;
+        total_used_area += _tex_sheets[i]->GetUsedArea();
+    }
+
+    sprintf(buf, "  Sheets:  %d (%.1f%% used)", num_sheets, total_area == 0 ? 0.0f : 100.0f * total_used_area / total_area);
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
+    // The sprite batch counters of the previous frame
+    sprintf(buf, "  Batches: %u (%u quads)", VideoManager->GetSpriteBatchFlushCount(), VideoManager->GetSpriteBatchQuadCount());
+    VideoManager->MoveRelative(0, 20);
+    TextManager->Draw(buf);
+
     VideoManager->PopState();
 } // void TextureController::DEBUG_ShowTexSheet()
 
@@ -272,6 +488,12 @@ void TextureController::DEBUG_ShowTexSheet()
 
 GLuint TextureController::_CreateBlankGLTexture(int32 width, int32 height)
 {
+    // Without a display, the sheets are given unique ids which are never given to OpenGL.
+    if(VIDEO_HEADLESS) {
+        static GLuint headless_tex_id = 0;
+        return ++headless_tex_id;
+    }
+
     GLuint tex_id;
     glGenTextures(1, &tex_id);
 
@@ -314,7 +536,8 @@ void TextureController::_BindTexture(GLuint tex_id)
         return;
 
     _last_tex_id = tex_id;
-    glBindTexture(GL_TEXTURE_2D, tex_id);
+    if(!VIDEO_HEADLESS)
+        glBindTexture(GL_TEXTURE_2D, tex_id);
     ++_debug_num_tex_switches;
 }
 
@@ -322,7 +545,11 @@ void TextureController::_BindTexture(GLuint tex_id)
 
 void TextureController::_DeleteTexture(GLuint tex_id)
 {
-    glDeleteTextures(1, &tex_id);
+    // The pending images may still use the texture.
+    VideoManager->FlushSpriteBatch();
+
+    if(!VIDEO_HEADLESS)
+        glDeleteTextures(1, &tex_id);
 
     if(_last_tex_id == tex_id)
         _last_tex_id = INVALID_TEXTURE_ID;
@@ -388,6 +615,8 @@ TexSheet *TextureController::_CreateTexSheet(int32 width, int32 height, TexSheet
         sheet = new FixedTexSheet(width, height, tex_id, type, is_static, 32, 64);
     else if(type == VIDEO_TEXSHEET_64x64)
         sheet = new FixedTexSheet(width, height, tex_id, type, is_static, 64, 64);
+    else if(type == VIDEO_TEXSHEET_ATLAS)
+        sheet = new AtlasTexSheet(width, height, tex_id);
     else
         sheet = new VariableTexSheet(width, height, tex_id, type, is_static);
 
@@ -427,6 +656,9 @@ void TextureController::_RemoveSheet(TexSheet *sheet)
 
 TexSheet *TextureController::_InsertImageInTexSheet(BaseTexture *image, ImageMemory &load_info, bool is_static)
 {
+    // The pending images must be drawn before their texture sheet content changes.
+    VideoManager->FlushSpriteBatch();
+
     // Image sizes larger than 512 in either dimension require their own texture sheet
     if(load_info.width > 512 || load_info.height > 512) {
         int32 round_width = RoundUpPow2(load_info.width);
@@ -608,16 +840,6 @@ bool TextureController::_ReloadImagesToSheet(TexSheet *sheet)
         i->second.second.pixels = NULL;
     }
 
-    // Regenerate all font textures
-    for(std::set<TextTexture *>::iterator i = _text_images.begin(); i != _text_images.end(); ++i) {
-        if((*i)->texture_sheet == sheet) {
-            if((*i)->Reload() == false) {
-                IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to reload a TextTexture" << std::endl;
-                success = false;
-            }
-        }
-    }
-
     return success;
 } // bool TextureController::_ReloadImagesToSheet(TexSheet* sheet)
 
@@ -657,39 +879,4 @@ void TextureController::_UnregisterImageTexture(ImageTexture *img)
     _images.erase(img_iter);
 }
 
-
-
-void TextureController::_RegisterTextTexture(TextTexture *tex)
-{
-    if(tex == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL argument passed to function" << std::endl;
-        return;
-    }
-
-    if(_IsTextTextureRegistered(tex) == true) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "attempted to register an already registered TextTexture" << std::endl;
-        return;
-    }
-
-    _text_images.insert(tex);
-}
-
-
-
-void TextureController::_UnregisterTextTexture(TextTexture *tex)
-{
-    if(tex == NULL) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "NULL argument passed to function" << std::endl;
-        return;
-    }
-
-    std::set<private_video::TextTexture *>::iterator tex_iter = _text_images.find(tex);
-    if(tex_iter == _text_images.end()) {
-        IF_PRINT_WARNING(VIDEO_DEBUG) << "TextTexture was not registered" << std::endl;
-        return;
-    }
-    _text_images.erase(tex_iter);
-}
-
-
 }  // namespace vt_video
@@ -34,8 +34,12 @@ class ParticleSystem;
 namespace vt_video
 {
 
+class FontProperties;
+class TextureAtlas;
+
 namespace private_video {
-class TextTexture;
+class TextElement;
+class SpriteBatch;
 }
 
 class TextureController : public vt_utils::Singleton<TextureController>
@@ -46,12 +50,16 @@ class TextureController : public vt_utils::Singleton<TextureController>
     friend class ImageDescriptor;
     friend class StillImage;
     friend class private_video::ImageTexture;
-    friend class private_video::TextTexture;
     friend class TextSupervisor;
     friend class TextImage;
+    friend class FontProperties;
+    friend class private_video::TextElement;
+    friend class private_video::SpriteBatch;
     friend class private_video::TexSheet;
     friend class private_video::FixedTexSheet;
     friend class private_video::VariableTexSheet;
+    friend class private_video::AtlasTexSheet;
+    friend class TextureAtlas;
     friend class vt_mode_manager::ParticleSystem;
 
 public:
@@ -76,6 +84,19 @@ public:
     **/
     bool ReloadTextures();
 
+    /** \brief Repacks the static texture sheets holding images of various sizes
+    *** \param force Whether to repack even when it wouldn't release any texture sheet
+    *** \return The number of texture sheets released
+    ***
+    *** The images still referenced are read back from their texture sheets, sorted
+    *** by height and packed into new sheets. Only once all of them are packed are
+    *** they removed from the former sheets, which are then deleted when left empty.
+    *** When any of them can't be packed, the former sheets are kept as they were.
+    *** As this stalls the rendering, it should only be called while the screen is
+    *** faded out, like during game mode transitions.
+    **/
+    uint32 DefragmentTexSheets(bool force = false);
+
     //! \brief Cycles forward to show the next texture sheet
     void DEBUG_NextTexSheet();
 
@@ -103,9 +124,6 @@ private:
     //! \brief A STL map containing all of the images currently being managed by this class
     std::map<std::string, private_video::ImageTexture *> _images;
 
-    //! \brief A STL set containing all of the text images currently being managed by this class
-    std::set<private_video::TextTexture *> _text_images;
-
     //! \brief Keeps track of the number of texture switches per frame
     uint32 _debug_num_tex_switches;
 
@@ -210,26 +228,6 @@ private:
     }
     //@}
 
-    //! \name Text Texture Operations
-    //@{
-    /** \brief Adds a TextTexture object to the map registery
-    *** \param text A pointer to the TextTexture to add
-    **/
-    void _RegisterTextTexture(private_video::TextTexture *tex);
-
-    /** \brief Removes a TextTexture object from the map registery
-    *** \param text A pointer to the TextTexture to remove
-    **/
-    void _UnregisterTextTexture(private_video::TextTexture *tex);
-
-    /** \brief Determines if a TextTexture is already registered and maintainted by the texture controller
-    *** \param tex A pointer to the TextTexture to check for
-    *** \return True if the TextTexture is already registered, false if it is not
-    **/
-    bool _IsTextTextureRegistered(private_video::TextTexture *tex) const {
-        return (_text_images.find(tex) != _text_images.end());
-    }
-    //@}
 }; // class TextureController : public vt_utils::Singleton<TextureController>
 
 //! \brief The singleton pointer for the instance of the texture controller
@@ -36,6 +36,7 @@ namespace vt_video
 
 VideoEngine *VideoManager = NULL;
 bool VIDEO_DEBUG = false;
+bool VIDEO_HEADLESS = false;
 
 //-----------------------------------------------------------------------------
 // Static variable for the Color class
@@ -75,6 +76,9 @@ VideoEngine::VideoEngine():
     _current_sample(0),
     _number_samples(0),
     _FPS_textimage(NULL),
+    _profiler_display(false),
+    _profiler_textimage(NULL),
+    _profiler_refresh_frames(0),
     _gl_error_code(GL_NO_ERROR),
     _gl_blend_is_active(false),
     _gl_texture_2d_is_active(false),
@@ -137,7 +141,8 @@ void VideoEngine::_UpdateFPS()
     //! \brief The number of samples to take if we need to play catchup with the current FPS
     const uint32 FPS_CATCHUP = 20;
 
-    uint32 frame_time = vt_system::SystemManager->GetUpdateTime();
+    // The real frame duration, as the game is updated by fixed steps
+    uint32 frame_time = vt_system::SystemManager->GetFrameTimings().frame_time;
 
     // Calculate the FPS for the current frame
     uint32 current_fps = 1000;
@@ -196,6 +201,64 @@ void VideoEngine::_DrawFPS()
     PopState();
 } // void GUISystem::_DrawFPS()
 
+void VideoEngine::ToggleProfiler()
+{
+    _profiler_display = !_profiler_display;
+    vt_system::SystemManager->GetProfiler().Enable(_profiler_display);
+    _profiler_refresh_frames = 0;
+}
+
+void VideoEngine::_UpdateProfiler()
+{
+    //! \brief The number of frames the profiler overlay text is kept, so that it can be read.
+    const uint32 PROFILER_REFRESH_FRAMES = 30;
+
+    //! \brief The maximum number of marked parts shown.
+    const uint32 PROFILER_MAX_LINES = 32;
+
+    if(_profiler_refresh_frames > 0) {
+        --_profiler_refresh_frames;
+        return;
+    }
+    _profiler_refresh_frames = PROFILER_REFRESH_FRAMES;
+
+    if(!_profiler_textimage)
+        _profiler_textimage = new TextImage("", TextStyle("text18", Color::white));
+
+    std::vector<vt_system::ProfilerSummaryLine> lines;
+    uint32 frame_time = vt_system::SystemManager->GetProfiler().GetLastFrameSummary(lines);
+
+    std::ostringstream text;
+    text.setf(std::ios::fixed);
+    text.precision(2);
+    text << "Frame: " << frame_time / 1000.0f << " ms";
+
+    const vt_script::ScriptGarbageCollector &collector = vt_script::ScriptManager->GetGarbageCollector();
+    text << std::endl << "Lua heap: " << vt_script::ScriptManager->GetHeapSize() / 1024 << " KiB, collection: "
+         << collector.GetLastFrameTime() / 1000.0f << " ms (pause " << collector.GetPause()
+         << "%, step " << collector.GetStepMultiplier() << "%)";
+    for(uint32 i = 0; i < lines.size() && i < PROFILER_MAX_LINES; ++i) {
+        text << std::endl << std::string(2 * (lines[i].depth + 1), ' ') << lines[i].name
+             << ": " << lines[i].time / 1000.0f << " ms";
+        if(lines[i].calls > 1)
+            text << " (" << lines[i].calls << ")";
+    }
+    _profiler_textimage->SetText(text.str());
+}
+
+void VideoEngine::_DrawProfiler()
+{
+    if(!_profiler_textimage)
+        return;
+
+    PushState();
+    SetStandardCoordSys();
+    SetDrawFlags(VIDEO_X_LEFT, VIDEO_Y_TOP, VIDEO_X_NOFLIP, VIDEO_Y_NOFLIP, VIDEO_BLEND, 0);
+    Move(10.0f, 10.0f); // Upper left hand corner of the screen
+    _profiler_textimage->Draw();
+    PopState();
+}
+
 VideoEngine::~VideoEngine()
 {
     TextManager->SingletonDestroy();
@@ -203,6 +266,7 @@ VideoEngine::~VideoEngine()
     _default_menu_cursor.Clear();
     _rectangle_image.Clear();
     delete _FPS_textimage;
+    delete _profiler_textimage;
 
     TextureManager->SingletonDestroy();
 }
@@ -213,6 +277,10 @@ bool VideoEngine::SingletonInitialize()
     if(_initialized)
         return true;
 
+    // The images are converted to the display format when decoded, which still needs a video surface.
+    if(VIDEO_HEADLESS)
+        SDL_putenv(const_cast<char *>("SDL_VIDEODRIVER=dummy"));
+
     if(SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) {
         PRINT_ERROR << "SDL video initialization failed" << std::endl;
         return false;
@@ -357,10 +425,14 @@ void VideoEngine::Clear()
 
 void VideoEngine::Clear(const Color& c)
 {
+    FlushSpriteBatch();
+
     _current_context.viewport = ScreenRect(_viewport_x_offset, _viewport_y_offset, _viewport_width, _viewport_height);
-    glViewport(_viewport_x_offset, _viewport_y_offset, _viewport_width, _viewport_height);
-    glClearColor(c[0], c[1], c[2], c[3]);
-    glClear(GL_COLOR_BUFFER_BIT);
+    _SetGLViewport(_viewport_x_offset, _viewport_y_offset, _viewport_width, _viewport_height);
+    if(!VIDEO_HEADLESS) {
+        glClearColor(c[0], c[1], c[2], c[3]);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 
     TextureManager->_debug_num_tex_switches = 0;
 }
@@ -371,9 +443,6 @@ void VideoEngine::Update()
     uint32 frame_time = vt_system::SystemManager->GetUpdateTime();
 
     _screen_fader.Update(frame_time);
-
-    if (_fps_display)
-        _UpdateFPS();
 }
 
 void VideoEngine::DrawDebugInfo()
@@ -383,10 +452,25 @@ void VideoEngine::DrawDebugInfo()
 
     if (_fps_display)
         _DrawFPS();
+
+    if(_profiler_display)
+        _DrawProfiler();
 } // void VideoEngine::Draw()
 
+void VideoEngine::EndFrame()
+{
+    if (_fps_display)
+        _UpdateFPS();
+
+    if(_profiler_display)
+        _UpdateProfiler();
+
+    FlushSpriteBatch();
+    _sprite_batch.EndFrame();
+}
+
 bool VideoEngine::CheckGLError() {
-    if(!VIDEO_DEBUG)
+    if(!VIDEO_DEBUG || VIDEO_HEADLESS)
         return false;
 
     _gl_error_code = glGetError();
@@ -421,6 +505,9 @@ bool VideoEngine::ApplySettings()
     if(!TextureManager || !TextureManager->UnloadTextures())
         IF_PRINT_WARNING(VIDEO_DEBUG) << "failed to delete OpenGL textures during a context change" << std::endl;
 
+    if(VIDEO_HEADLESS)
+        return _ApplyHeadlessSettings();
+
     int32 flags = SDL_OPENGL;
 
     if(_temp_fullscreen)
@@ -491,6 +578,27 @@ bool VideoEngine::ApplySettings()
     return true;
 } // bool VideoEngine::ApplySettings()
 
+bool VideoEngine::_ApplyHeadlessSettings()
+{
+    // A software surface of the dummy video driver, which is never displayed.
+    if(SDL_SetVideoMode(_temp_width, _temp_height, 32, SDL_SWSURFACE) == NULL) {
+        PRINT_ERROR << "SDL_SetVideoMode() failed with error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    _screen_width = _temp_width;
+    _screen_height = _temp_height;
+    _fullscreen = false;
+    _temp_fullscreen = false;
+
+    _UpdateViewportMetrics();
+
+    if(TextureManager)
+        TextureManager->ReloadTextures();
+
+    return true;
+}
+
 void VideoEngine::_UpdateViewportMetrics()
 {
     // Test the desired resolution and adds the necessary offsets if it's not a 4:3 one
@@ -529,27 +637,56 @@ void VideoEngine::_UpdateViewportMetrics()
 
 void VideoEngine::SetCoordSys(const CoordSys &coordinate_system)
 {
+    // The pending images must be drawn with the projection they were added with.
+    const CoordSys &current = _current_context.coordinate_system;
+    if(!IsFloatEqual(current.GetLeft(), coordinate_system.GetLeft()) || !IsFloatEqual(current.GetRight(), coordinate_system.GetRight())
+            || !IsFloatEqual(current.GetBottom(), coordinate_system.GetBottom()) || !IsFloatEqual(current.GetTop(), coordinate_system.GetTop()))
+        FlushSpriteBatch();
+
     _current_context.coordinate_system = coordinate_system;
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(_current_context.coordinate_system.GetLeft(), _current_context.coordinate_system.GetRight(),
-            _current_context.coordinate_system.GetBottom(), _current_context.coordinate_system.GetTop(), -1, 1);
+    if(!VIDEO_HEADLESS) {
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        glOrtho(_current_context.coordinate_system.GetLeft(), _current_context.coordinate_system.GetRight(),
+                _current_context.coordinate_system.GetBottom(), _current_context.coordinate_system.GetTop(), -1, 1);
 
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+    }
+    _transform.SetIdentity();
 }
 
 void VideoEngine::GetCurrentViewport(float &x, float &y, float &width, float &height)
 {
     static GLint viewport_dimensions[4] = {(GLint)0};
-    glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
+    _GetGLViewport(viewport_dimensions);
     x = (float) viewport_dimensions[0];
     y = (float) viewport_dimensions[1];
     width = (float) viewport_dimensions[2];
     height = (float) viewport_dimensions[3];
 }
 
+void VideoEngine::_GetGLViewport(GLint viewport_dimensions[4])
+{
+    if(!VIDEO_HEADLESS) {
+        glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
+        return;
+    }
+
+    viewport_dimensions[0] = _gl_viewport.left;
+    viewport_dimensions[1] = _gl_viewport.top;
+    viewport_dimensions[2] = _gl_viewport.width;
+    viewport_dimensions[3] = _gl_viewport.height;
+}
+
+void VideoEngine::_SetGLViewport(int32 x, int32 y, int32 width, int32 height)
+{
+    _gl_viewport = ScreenRect(x, y, width, height);
+    if(!VIDEO_HEADLESS)
+        glViewport(x, y, width, height);
+}
+
 void VideoEngine::SetViewport(float x, float y, float width, float height)
 {
     if(width <= 0 || height <= 0)
@@ -559,18 +696,22 @@ void VideoEngine::SetViewport(float x, float y, float width, float height)
         return;
     }
 
+    FlushSpriteBatch();
+
     _viewport_x_offset = x;
     _viewport_y_offset = y;
     _viewport_width = width;
     _viewport_height = height;
-    glViewport(_viewport_x_offset, _viewport_y_offset, _viewport_width, _viewport_height);
+    _SetGLViewport(_viewport_x_offset, _viewport_y_offset, _viewport_width, _viewport_height);
 }
 
 void VideoEngine::EnableScissoring()
 {
     _current_context.scissoring_enabled = true;
     if(!_gl_scissor_test_is_active) {
-        glEnable(GL_SCISSOR_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glEnable(GL_SCISSOR_TEST);
         _gl_scissor_test_is_active = true;
     }
 }
@@ -579,7 +720,9 @@ void VideoEngine::DisableScissoring()
 {
     _current_context.scissoring_enabled = false;
     if(_gl_scissor_test_is_active) {
-        glDisable(GL_SCISSOR_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glDisable(GL_SCISSOR_TEST);
         _gl_scissor_test_is_active = false;
     }
 }
@@ -587,7 +730,9 @@ void VideoEngine::DisableScissoring()
 void VideoEngine::EnableAlphaTest()
 {
     if(!_gl_alpha_test_is_active) {
-        glEnable(GL_ALPHA_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glEnable(GL_ALPHA_TEST);
         _gl_alpha_test_is_active = true;
     }
 }
@@ -595,7 +740,9 @@ void VideoEngine::EnableAlphaTest()
 void VideoEngine::DisableAlphaTest()
 {
     if(_gl_alpha_test_is_active) {
-        glDisable(GL_ALPHA_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glDisable(GL_ALPHA_TEST);
         _gl_alpha_test_is_active = false;
     }
 }
@@ -603,7 +750,8 @@ void VideoEngine::DisableAlphaTest()
 void VideoEngine::EnableBlending()
 {
     if(!_gl_blend_is_active) {
-        glEnable(GL_BLEND);
+        if(!VIDEO_HEADLESS)
+            glEnable(GL_BLEND);
         _gl_blend_is_active = true;
     }
 }
@@ -611,7 +759,8 @@ void VideoEngine::EnableBlending()
 void VideoEngine::DisableBlending()
 {
     if(_gl_blend_is_active) {
-        glDisable(GL_BLEND);
+        if(!VIDEO_HEADLESS)
+            glDisable(GL_BLEND);
         _gl_blend_is_active = false;
     }
 }
@@ -619,7 +768,9 @@ void VideoEngine::DisableBlending()
 void VideoEngine::EnableStencilTest()
 {
     if(!_gl_stencil_test_is_active) {
-        glEnable(GL_STENCIL_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glEnable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = true;
     }
 }
@@ -627,7 +778,9 @@ void VideoEngine::EnableStencilTest()
 void VideoEngine::DisableStencilTest()
 {
     if(_gl_stencil_test_is_active) {
-        glDisable(GL_STENCIL_TEST);
+        FlushSpriteBatch();
+        if(!VIDEO_HEADLESS)
+            glDisable(GL_STENCIL_TEST);
         _gl_stencil_test_is_active = false;
     }
 }
@@ -635,7 +788,8 @@ void VideoEngine::DisableStencilTest()
 void VideoEngine::EnableTexture2D()
 {
     if(!_gl_texture_2d_is_active) {
-        glEnable(GL_TEXTURE_2D);
+        if(!VIDEO_HEADLESS)
+            glEnable(GL_TEXTURE_2D);
         _gl_texture_2d_is_active = true;
     }
 }
@@ -643,7 +797,8 @@ void VideoEngine::EnableTexture2D()
 void VideoEngine::DisableTexture2D()
 {
     if(_gl_texture_2d_is_active) {
-        glDisable(GL_TEXTURE_2D);
+        if(!VIDEO_HEADLESS)
+            glDisable(GL_TEXTURE_2D);
         _gl_texture_2d_is_active = false;
     }
 }
@@ -651,7 +806,8 @@ void VideoEngine::DisableTexture2D()
 void VideoEngine::EnableColorArray()
 {
     if(!_gl_color_array_is_activated) {
-        glEnableClientState(GL_COLOR_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glEnableClientState(GL_COLOR_ARRAY);
         _gl_color_array_is_activated = true;
     }
 }
@@ -659,7 +815,8 @@ void VideoEngine::EnableColorArray()
 void VideoEngine::DisableColorArray()
 {
     if(_gl_color_array_is_activated) {
-        glDisableClientState(GL_COLOR_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glDisableClientState(GL_COLOR_ARRAY);
         _gl_color_array_is_activated = false;
     }
 }
@@ -667,7 +824,8 @@ void VideoEngine::DisableColorArray()
 void VideoEngine::EnableVertexArray()
 {
     if(!_gl_vertex_array_is_activated) {
-        glEnableClientState(GL_VERTEX_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glEnableClientState(GL_VERTEX_ARRAY);
         _gl_vertex_array_is_activated = true;
     }
 }
@@ -675,7 +833,8 @@ void VideoEngine::EnableVertexArray()
 void VideoEngine::DisableVertexArray()
 {
     if(_gl_vertex_array_is_activated) {
-        glDisableClientState(GL_VERTEX_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glDisableClientState(GL_VERTEX_ARRAY);
         _gl_vertex_array_is_activated = false;
     }
 }
@@ -683,7 +842,8 @@ void VideoEngine::DisableVertexArray()
 void VideoEngine::EnableTextureCoordArray()
 {
     if(!_gl_texture_coord_array_is_activated) {
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
         _gl_texture_coord_array_is_activated = true;
     }
 }
@@ -691,27 +851,32 @@ void VideoEngine::EnableTextureCoordArray()
 void VideoEngine::DisableTextureCoordArray()
 {
     if(_gl_texture_coord_array_is_activated) {
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        if(!VIDEO_HEADLESS)
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
         _gl_texture_coord_array_is_activated = false;
     }
 }
 
 void VideoEngine::SetScissorRect(float left, float right, float bottom, float top)
 {
+    FlushSpriteBatch();
     _current_context.scissor_rectangle = CalculateScreenRect(left, right, bottom, top);
-
-    glScissor(static_cast<GLint>((_current_context.scissor_rectangle.left / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
-              static_cast<GLint>((_current_context.scissor_rectangle.top / static_cast<float>(VIDEO_STANDARD_RES_HEIGHT)) * _current_context.viewport.height),
-              static_cast<GLsizei>((_current_context.scissor_rectangle.width / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
-              static_cast<GLsizei>((_current_context.scissor_rectangle.height / static_cast<float>(VIDEO_STANDARD_RES_HEIGHT)) * _current_context.viewport.height)
-             );
+    _ApplyScissorRect();
 }
 
 
 
 void VideoEngine::SetScissorRect(const ScreenRect &rect)
 {
+    FlushSpriteBatch();
     _current_context.scissor_rectangle = rect;
+    _ApplyScissorRect();
+}
+
+void VideoEngine::_ApplyScissorRect()
+{
+    if(VIDEO_HEADLESS)
+        return;
 
     glScissor(static_cast<GLint>((_current_context.scissor_rectangle.left / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
               static_cast<GLint>((_current_context.scissor_rectangle.top / static_cast<float>(VIDEO_STANDARD_RES_HEIGHT)) * _current_context.viewport.height),
@@ -758,8 +923,12 @@ ScreenRect VideoEngine::CalculateScreenRect(float left, float right, float botto
 
 void VideoEngine::Move(float x, float y)
 {
-    glLoadIdentity();
-    glTranslatef(x, y, 0);
+    if(!VIDEO_HEADLESS) {
+        glLoadIdentity();
+        glTranslatef(x, y, 0);
+    }
+    _transform.SetIdentity();
+    _transform.Translate(x, y);
     _x_cursor = x;
     _y_cursor = y;
 }
@@ -768,25 +937,35 @@ void VideoEngine::Move(float x, float y)
 
 void VideoEngine::MoveRelative(float x, float y)
 {
-    glTranslatef(x, y, 0);
+    if(!VIDEO_HEADLESS)
+        glTranslatef(x, y, 0);
+    _transform.Translate(x, y);
     _x_cursor += x;
     _y_cursor += y;
 }
 
 void VideoEngine::PushMatrix()
 {
-    glPushMatrix();
+    if(!VIDEO_HEADLESS)
+        glPushMatrix();
+    _transform_stack.push_back(_transform);
 }
 
 void VideoEngine::PopMatrix()
 {
-    glPopMatrix();
+    if(!VIDEO_HEADLESS)
+        glPopMatrix();
+    if(!_transform_stack.empty()) {
+        _transform = _transform_stack.back();
+        _transform_stack.pop_back();
+    }
 }
 
 void VideoEngine::PushState()
 {
     // Push current modelview transformation
-    glMatrixMode(GL_MODELVIEW);
+    if(!VIDEO_HEADLESS)
+        glMatrixMode(GL_MODELVIEW);
     PushMatrix();
 
     _context_stack.push(_current_context);
@@ -802,21 +981,25 @@ void VideoEngine::PopState()
         return;
     }
 
-    _current_context = _context_stack.top();
+    // The pending images must be drawn within the viewport and scissor rectangle they were added with.
+    const private_video::Context &restored_context = _context_stack.top();
+    if(restored_context.scissoring_enabled != _current_context.scissoring_enabled
+            || !(restored_context.viewport == _current_context.viewport)
+            || (restored_context.scissoring_enabled && !(restored_context.scissor_rectangle == _current_context.scissor_rectangle)))
+        FlushSpriteBatch();
+
+    _current_context = restored_context;
     _context_stack.pop();
 
     // Restore the modelview transformation
-    glMatrixMode(GL_MODELVIEW);
+    if(!VIDEO_HEADLESS)
+        glMatrixMode(GL_MODELVIEW);
     PopMatrix();
-    glViewport(_current_context.viewport.left, _current_context.viewport.top, _current_context.viewport.width, _current_context.viewport.height);
+    _SetGLViewport(_current_context.viewport.left, _current_context.viewport.top, _current_context.viewport.width, _current_context.viewport.height);
 
     if(_current_context.scissoring_enabled) {
         EnableScissoring();
-        glScissor(static_cast<GLint>((_current_context.scissor_rectangle.left / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
-                  static_cast<GLint>((_current_context.scissor_rectangle.top / static_cast<float>(VIDEO_STANDARD_RES_HEIGHT)) * _current_context.viewport.height),
-                  static_cast<GLsizei>((_current_context.scissor_rectangle.width / static_cast<float>(VIDEO_STANDARD_RES_WIDTH)) * _current_context.viewport.width),
-                  static_cast<GLsizei>((_current_context.scissor_rectangle.height / static_cast<float>(VIDEO_STANDARD_RES_HEIGHT)) * _current_context.viewport.height)
-                 );
+        _ApplyScissorRect();
     } else {
         DisableScissoring();
     }
@@ -824,19 +1007,26 @@ void VideoEngine::PopState()
 
 void VideoEngine::Rotate(float angle)
 {
-    glRotatef(angle, 0, 0, 1);
+    if(!VIDEO_HEADLESS)
+        glRotatef(angle, 0, 0, 1);
+    _transform.Rotate(angle);
 }
 
 void VideoEngine::Scale(float x, float y)
 {
-    glScalef(x, y, 1.0f);
+    if(!VIDEO_HEADLESS)
+        glScalef(x, y, 1.0f);
+    _transform.Scale(x, y);
 }
 
 void VideoEngine::SetTransform(float matrix[16])
 {
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    glLoadMatrixf(matrix);
+    if(!VIDEO_HEADLESS) {
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        glLoadMatrixf(matrix);
+    }
+    _transform.SetMatrix(matrix);
 }
 
 void VideoEngine::DrawFadeEffect()
@@ -862,9 +1052,12 @@ StillImage VideoEngine::CaptureScreen() throw(Exception)
 
     StillImage screen_image;
 
+    // Draw the pending images before reading the screen.
+    FlushSpriteBatch();
+
     // Retrieve width/height of the viewport. viewport_dimensions[2] is the width, [3] is the height
     GLint viewport_dimensions[4];
-    glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
+    _GetGLViewport(viewport_dimensions);
     screen_image.SetDimensions((float)viewport_dimensions[2], (float)viewport_dimensions[3]);
 
     // Set up the screen rectangle to copy
@@ -1006,8 +1199,16 @@ void VideoEngine::SetBrightness(float value)
 
 void VideoEngine::MakeScreenshot(const std::string &filename)
 {
+    if(VIDEO_HEADLESS) {
+        PRINT_WARNING << "No screenshot can be taken without a display: " << filename << std::endl;
+        return;
+    }
+
     private_video::ImageMemory buffer;
 
+    // Draw the pending images before reading the screen.
+    FlushSpriteBatch();
+
     // Retrieve the width and height of the viewport.
     GLint viewport_dimensions[4]; // viewport_dimensions[2] is the width, [3] is the height
     glGetIntegerv(GL_VIEWPORT, viewport_dimensions);
@@ -1130,6 +1331,10 @@ void VideoEngine::DrawLine(float x1, float y1, float x2, float y2, float width,
         x1, y1,
         x2, y2
     };
+    FlushSpriteBatch();
+    if(VIDEO_HEADLESS)
+        return;
+
     EnableBlending();
     DisableTexture2D();
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // Normal blending
@@ -1171,11 +1376,14 @@ void VideoEngine::DrawGrid(float x, float y, float x_step, float y_step, const C
         vertices.push_back(y);
         num_vertices += 2;
     }
-    glColor4fv(&c[0]);
-    DisableTexture2D();
-    EnableVertexArray();
-    glVertexPointer(2, GL_FLOAT, 0, &(vertices[0]));
-    glDrawArrays(GL_LINES, 0, num_vertices);
+    FlushSpriteBatch();
+    if(!VIDEO_HEADLESS) {
+        glColor4fv(&c[0]);
+        DisableTexture2D();
+        EnableVertexArray();
+        glVertexPointer(2, GL_FLOAT, 0, &(vertices[0]));
+        glDrawArrays(GL_LINES, 0, num_vertices);
+    }
 
     PopState();
 }
@@ -35,6 +35,7 @@
 #include "engine/video/fade.h"
 #include "engine/video/image.h"
 #include "engine/video/screen_rect.h"
+#include "engine/video/sprite_batch.h"
 #include "engine/video/texture_controller.h"
 #include "engine/video/text.h"
 
@@ -69,6 +70,12 @@ extern VideoEngine *VideoManager;
 //! \brief Determines whether the code in the vt_video namespace should print
 extern bool VIDEO_DEBUG;
 
+/** \brief When true, nothing is displayed: no window is opened and no OpenGL call is made
+*** The images are still loaded and the draw calls still submitted, so that the game
+*** can be run and measured without a display. Must be set before the engine is initialized.
+**/
+extern bool VIDEO_HEADLESS;
+
 //! \brief The number of FPS samples to retain across frames
 const uint32 FPS_SAMPLES = 250;
 
@@ -152,6 +159,7 @@ class VideoEngine : public vt_utils::Singleton<VideoEngine>
     friend class CompositeImage;
     friend class private_video::TextElement;
     friend class TextImage;
+    friend class private_video::SpriteBatch;
 
 public:
     ~VideoEngine();
@@ -194,6 +202,29 @@ public:
     //! \brief Displays potential debug information (FPS and textures).
     void DrawDebugInfo();
 
+    /** \brief Draws what is left in the sprite batch, and ends the frame counters
+    *** This method should be called at the end of every frame, before swapping the buffers.
+    **/
+    void EndFrame();
+
+    /** \brief Draws the image quads gathered in the sprite batch
+    *** This must be called before drawing through OpenGL directly, so that
+    *** the pending images are drawn first.
+    **/
+    void FlushSpriteBatch() {
+        _sprite_batch.Flush();
+    }
+
+    //! \brief Returns the number of sprite batch draw calls done during the last frame.
+    uint32 GetSpriteBatchFlushCount() const {
+        return _sprite_batch.GetLastFrameFlushCount();
+    }
+
+    //! \brief Returns the number of quads drawn by the sprite batch during the last frame.
+    uint32 GetSpriteBatchQuadCount() const {
+        return _sprite_batch.GetLastFrameQuadCount();
+    }
+
     /** \brief Retrieves the OpenGL error code and retains it in the _gl_error_code member
     *** \return True if an OpenGL error has been detected, false if no errors were detected
     *** \note This function only produces a meaningful result if the VIDEO_DEBUG variable is set to true. This is done
@@ -544,6 +575,16 @@ public:
     //! and check for active shaking
     bool IsScreenShaking();
 
+    //! \brief Returns the screen shaking offsets, in standard resolution pixels.
+    //! \note The offsets are only updated when IsScreenShaking() returns true.
+    float GetXShake() const {
+        return _x_shake;
+    }
+
+    float GetYShake() const {
+        return _y_shake;
+    }
+
     //-- Miscellaneous --------------------------------------------------------
 
     /** \brief Sets a new brightness value
@@ -643,6 +684,9 @@ public:
     void ToggleFPS() {
         _fps_display = !_fps_display;
     }
+
+    //! \brief Toggles the frame profiler overlay, and the profiler along with it.
+    void ToggleProfiler();
 private:
     VideoEngine();
 
@@ -684,6 +728,13 @@ private:
     //! The FPS text
     TextImage* _FPS_textimage;
 
+    //! \brief Whether the frame profiler overlay is displayed.
+    bool _profiler_display;
+
+    //! \brief The frame profiler overlay text, and the number of frames before it is refreshed.
+    TextImage* _profiler_textimage;
+    uint32 _profiler_refresh_frames;
+
     //! \brief Holds the most recently fetched OpenGL error code
     GLenum _gl_error_code;
 
@@ -705,6 +756,9 @@ private:
     //! \brief Holds whether the GL_VERTEX_ARRAY state is activated. Used to optimize the drawing logic
     bool _gl_texture_coord_array_is_activated;
 
+    //! \brief The viewport last given to OpenGL, kept to answer the viewport queries without a display.
+    ScreenRect _gl_viewport;
+
     //! \brief The x/y offsets, width and height of the current viewport (the drawn part), in pixels
     //! \note the viewport is different from the screen size when in non-4:3 modes.
     int32 _viewport_x_offset;
@@ -722,6 +776,15 @@ private:
     //! \brief The x and y coordinates of the current draw cursor position
     float _x_cursor, _y_cursor;
 
+    //! \brief The current modelview transformation, mirrored for the sprite batch.
+    private_video::Transform2D _transform;
+
+    //! \brief The transformations saved by PushMatrix().
+    std::vector<private_video::Transform2D> _transform_stack;
+
+    //! \brief Gathers the image quads to draw them with as few draw calls as possible.
+    private_video::SpriteBatch _sprite_batch;
+
     //! \brief Contains information about the current video engine's context, such as draw flags, the coordinate system, etc.
     private_video::Context _current_context;
 
@@ -800,11 +863,26 @@ private:
     //! \note it also centers the viewport when the resolution isn't a 4:3 one.
     void _UpdateViewportMetrics();
 
+    //! \brief Sets the screen size with a surface which is never displayed. \see VIDEO_HEADLESS.
+    bool _ApplyHeadlessSettings();
+
+    //! \brief Sets or retrieves the OpenGL viewport, as x, y, width and height.
+    void _SetGLViewport(int32 x, int32 y, int32 width, int32 height);
+    void _GetGLViewport(GLint viewport_dimensions[4]);
+
+    //! \brief Gives the current scissor rectangle to OpenGL.
+    void _ApplyScissorRect();
+
     // Debug info
     //! \brief Updates the FPS counter.
     void _UpdateFPS();
     //! \brief Draws the current average FPS to the screen.
     void _DrawFPS();
+
+    //! \brief Refreshes the frame profiler overlay text every few frames.
+    void _UpdateProfiler();
+    //! \brief Draws the frame profiler overlay to the screen.
+    void _DrawProfiler();
 }; // class VideoEngine : public vt_utils::Singleton<VideoEngine>
 
 }  // namespace vt_video
@@ -16,15 +16,16 @@
 ***
 *** The code in this file is the first to execute when the game is started and
 *** the last to execute before the game exits. The core engine
-*** uses time-based updating, which means that the state of the game is
-*** updated based on how much time has expired since the last update.
+*** uses fixed step updating, which means that the state of the game is
+*** updated by steps of constant duration, as many of them as the time
+*** elapsed since the last frame requires.
 ***
 *** The main game loop consists of the following steps.
 ***
+*** -# Wait until the next frame is due.
 *** -# Render the newly drawn frame to the screen.
-*** -# Collect information on new user input events.
-*** -# Update the main loop timer.
-*** -# Update the game status based on how much time expired from the last update.
+*** -# For every fixed time step elapsed since the last frame, collect information
+***    on new user input events and update the game status by that step.
 *** ***************************************************************************/
 
 #include "utils/utils_pch.h"
@@ -198,6 +199,10 @@ bool LoadSettings()
         AudioManager->SetMusicVolume(static_cast<float>(settings.ReadFloat("music_vol")));
         AudioManager->SetSoundVolume(static_cast<float>(settings.ReadFloat("sound_vol")));
 
+        // The memory budget of the decoded sounds, in megabytes
+        if(settings.DoesUIntExist("pcm_cache_size"))
+            AudioManager->SetPCMCacheBudget(settings.ReadUInt("pcm_cache_size") * 1024 * 1024);
+
         settings.CloseTable(); // audio_settings
     }
 
@@ -418,6 +423,23 @@ void InitializeEngine() throw(Exception)
 } // void InitializeEngine()
 
 
+//! \brief Runs a game update step: the input, video, audio and game mode updates.
+static void UpdateGameStep()
+{
+    // Process all new events
+    InputManager->EventHandler();
+
+    // Update video
+    VideoManager->Update();
+
+    // Update any streaming audio sources
+    AudioManager->Update();
+
+    // Update the game status
+    ModeManager->Update();
+}
+
+
 // Every great game begins with a single function :)
 int main(int argc, char *argv[])
 {
@@ -469,13 +491,21 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    // The benchmark runs its own game mode, by fixed steps.
+    if(vt_main::IsBenchmarkRequested())
+        return vt_main::RunBenchmark() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    // The input record starts with the random seed, before the boot mode draws any random number.
+    if(!vt_main::StartInputRecordOrReplay())
+        return EXIT_FAILURE;
+
     ModeManager->Push(new BootMode(), false, true);
 
     try {
         // This is the main loop for the game. The loop iterates once for every frame drawn to the screen.
         while(SystemManager->NotDone()) {
-            // Update only every 10 milliseconds.
-            SDL_Delay(10);
+            // Wait for the next frame, unless the last one already took long enough.
+            SystemManager->StartFrame();
 
             // 1) Render the scene
             VideoManager->Clear();
@@ -484,24 +514,29 @@ int main(int argc, char *argv[])
             ModeManager->DrawPostEffects();
             VideoManager->DrawFadeEffect();
             VideoManager->DrawDebugInfo();
+            VideoManager->EndFrame();
 
             // Swap the buffers once the draw operations are done.
             SDL_GL_SwapBuffers();
+            SystemManager->EndFrameDraw();
+
+            // Hand the results of the background jobs over to the engines which submitted them.
+            SystemManager->GetJobSystem().Update();
+
+            // 2) Update the game by fixed time steps, as many as the time elapsed since the last frame.
+            // The input events are only processed when a step runs, so that none of them is missed.
+            // A replay runs a single step per frame, so that it doesn't depend on the frame rate.
+            if(InputManager->IsReplaying()) {
+                SystemManager->UpdateTimersByStep();
+                UpdateGameStep();
+            } else {
+                while(SystemManager->UpdateTimers())
+                    UpdateGameStep();
+            }
 
-            // Update timers for correct time-based movement operation
-            SystemManager->UpdateTimers();
-
-            // Process all new events
-            InputManager->EventHandler();
-
-            // Update video
-            VideoManager->Update();
-
-            // Update any streaming audio sources
-            AudioManager->Update();
-
-            // Update the game status
-            ModeManager->Update();
+            // 3) Run the Lua garbage collector in the time left before the next frame,
+            // rather than whenever the scripts allocate memory.
+            ScriptManager->StepGarbageCollector(SystemManager->GetFrameTimeLeft());
 
         } // while (SystemManager->NotDone())
     } catch(const Exception &e) {
@@ -20,6 +20,9 @@
 
 #include "engine/audio/audio.h"
 #include "engine/video/video.h"
+#include "engine/video/texture_atlas.h"
+#include "engine/video/particle_effect.h"
+#include "engine/video/particle_workers.h"
 #include "engine/script/script.h"
 #include "engine/input.h"
 #include "engine/system.h"
@@ -27,6 +30,12 @@
 
 #include "common/global/global.h"
 
+#include "modes/map/map_objects.h"
+#include "modes/map/map_sprites.h"
+
+#include "utils/utils_files.h"
+#include "utils/utils_random.h"
+
 namespace vt_battle {
 extern bool BATTLE_DEBUG;
 }
@@ -51,6 +60,14 @@ using namespace vt_utils;
 namespace vt_main
 {
 
+//! \brief The benchmark description file given to --benchmark, and the results file, if any.
+static std::string benchmark_filename;
+static std::string benchmark_results_filename;
+
+//! \brief The input record file given to --record-input or to --replay-input, if any.
+static std::string record_input_filename;
+static std::string replay_input_filename;
+
 bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
 {
     // Convert the argument list to a vector of strings for convenience
@@ -58,13 +75,55 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
     return_code = 0;
 
     for(uint32 i = 1; i < options.size(); i++) {
-        if(options[i] == "-c" || options[i] == "--check") {
+        if(options[i] == "--bake-map-atlases") {
+            if(BakeMapAtlases() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
+        } else if(options[i] == "--benchmark") {
+            if((i + 1) >= options.size()) {
+                std::cerr << "Option " << options[i] << " requires an argument." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            benchmark_filename = options[++i];
+            // The results file is optional.
+            if((i + 1) < options.size() && options[i + 1][0] != '-')
+                benchmark_results_filename = options[++i];
+
+            // The benchmark is run once the engine is initialized, without any display or sound.
+            vt_video::VIDEO_HEADLESS = true;
+            vt_audio::AUDIO_ENABLE = false;
+        } else if(options[i] == "--build-map-cache") {
+            if(BuildMapCaches() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
+        } else if(options[i] == "-c" || options[i] == "--check") {
             if(CheckFiles() == true) {
                 return_code = 0;
             } else {
                 return_code = 1;
             }
             return false;
+        } else if(options[i] == "--convert-save") {
+            if((i + 2) >= options.size()) {
+                std::cerr << "Option " << options[i] << " requires two arguments." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            if(ConvertSavedGame(options[i + 1], options[i + 2]) == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
         } else if(options[i] == "-d" || options[i] == "--debug") {
             if((i + 1) >= options.size()) {
                 std::cerr << "Option " << options[i] << " requires an argument." << std::endl;
@@ -79,6 +138,13 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
             i++;
         } else if(options[i] == "--disable-audio") {
             vt_audio::AUDIO_ENABLE = false;
+        } else if(options[i] == "--event-benchmark") {
+            if(BenchmarkEvents() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
         } else if(options[i] == "-h" || options[i] == "--help") {
             PrintUsage();
             return_code = 0;
@@ -90,6 +156,38 @@ bool ParseProgramOptions(int32 &return_code, int32 argc, char **argv)
                 return_code = 1;
             }
             return false;
+        } else if(options[i] == "--particle-benchmark") {
+            if(BenchmarkParticles() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
+        } else if(options[i] == "--pathfinding-benchmark") {
+            if(BenchmarkPathFinding() == true) {
+                return_code = 0;
+            } else {
+                return_code = 1;
+            }
+            return false;
+        } else if(options[i] == "--record-input" || options[i] == "--replay-input") {
+            if((i + 1) >= options.size()) {
+                std::cerr << "Option " << options[i] << " requires an argument." << std::endl;
+                PrintUsage();
+                return_code = 1;
+                return false;
+            }
+            // The input is recorded or replayed once the engine is initialized.
+            if(options[i] == "--record-input")
+                record_input_filename = options[++i];
+            else
+                replay_input_filename = options[++i];
+
+            if(!record_input_filename.empty() && !replay_input_filename.empty()) {
+                std::cerr << "The input can't be recorded and replayed at once." << std::endl;
+                return_code = 1;
+                return false;
+            }
         } else if(options[i] == "-r" || options[i] == "--reset") {
             if(ResetSettings() == true) {
                 return_code = 0;
@@ -148,15 +246,29 @@ void PrintUsage()
 {
     std::cout
             << "usage: "APPSHORTNAME" [options]" << std::endl
+            << "  --bake-map-atlases :: packs the tilesets of every map into texture atlases" << std::endl
+            << "  --benchmark <file> [<results>] :: runs the map or battle set up by <file>" << std::endl
+            << "                       without a window, and writes the time spent per" << std::endl
+            << "                       subsystem as JSON to <results>, or to the output" << std::endl
+            << "  --build-map-cache :: writes the binary cache of every map data file" << std::endl
             << "  --check/-c        :: checks all files for integrity" << std::endl
+            << "  --convert-save <input> <output> :: converts a saved game, written in the Lua" << std::endl
+            << "                       format when <output> ends with .lua, in binary otherwise" << std::endl
             << "  --debug/-d <args> :: enables debug statements in specified sections of the" << std::endl
             << "                       program, where <args> can be:" << std::endl
             << "                       all, audio, battle, boot, data, global, input," << std::endl
             << "                       map, mode_manager, pause, quit, scene, system" << std::endl
             << "                       utils, video" << std::endl
             << "  --disable-audio   :: disables loading and playing audio" << std::endl
+            << "  --event-benchmark :: times the game event lookups by name and by key" << std::endl
             << "  --help/-h         :: prints this help menu" << std::endl
             << "  --info/-i         :: prints information about the user's system" << std::endl
+            << "  --particle-benchmark :: times the particle effects update and vertex generation" << std::endl
+            << "  --pathfinding-benchmark :: times path finding over every map collision grid" << std::endl
+            << "  --record-input <file> :: records the input of every game step to <file>," << std::endl
+            << "                       along with the random seed" << std::endl
+            << "  --replay-input <file> :: replays the input recorded to <file>, one game step" << std::endl
+            << "                       per frame, and exits once done" << std::endl
             << "  --reset/-r        :: resets game configuration to use default settings" << std::endl;
 }
 
@@ -302,6 +414,696 @@ bool CheckFiles()
 
 
 
+bool BuildMapCaches()
+{
+    using namespace vt_map::private_map;
+
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    uint32 num_errors = 0;
+    uint32 num_caches = 0;
+
+    std::vector<std::string> map_dirs = ListDirectory("dat/maps", "");
+    for(uint32 i = 0; i < map_dirs.size(); ++i) {
+        // Only consider the sub-directories
+        if(map_dirs[i].find('.') != std::string::npos)
+            continue;
+
+        std::string dir_name = "dat/maps/" + map_dirs[i] + "/";
+        std::vector<std::string> map_files = ListDirectory(dir_name, "_map.lua");
+        for(uint32 j = 0; j < map_files.size(); ++j) {
+            std::string map_filename = dir_name + map_files[j];
+            std::string cache_filename = MapData::GetCacheFilename(map_filename);
+
+            MapData map_data;
+            if(!map_data.LoadScript(map_filename) || !map_data.SaveCache(cache_filename)) {
+                std::cerr << "Couldn't build the map cache of: " << map_filename << std::endl;
+                ++num_errors;
+                continue;
+            }
+
+            std::cout << "Built: " << cache_filename << std::endl;
+            ++num_caches;
+        }
+    }
+
+    std::cout << num_caches << " map cache file(s) built, " << num_errors << " error(s)." << std::endl;
+    return num_errors == 0;
+} // bool BuildMapCaches()
+
+
+
+bool BakeMapAtlases()
+{
+    using namespace vt_map::private_map;
+
+    // The images are converted to the display format when decoded, which needs a video surface.
+    SDL_putenv(const_cast<char *>("SDL_VIDEODRIVER=dummy"));
+    if(SDL_Init(SDL_INIT_VIDEO) != 0 || SDL_SetVideoMode(1, 1, 32, SDL_SWSURFACE) == NULL) {
+        std::cerr << "ERROR: Unable to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    atexit(SDL_Quit);
+
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    uint32 num_errors = 0;
+    uint32 num_atlases = 0;
+
+    std::vector<std::string> map_dirs = ListDirectory("dat/maps", "");
+    for(uint32 i = 0; i < map_dirs.size(); ++i) {
+        // Only consider the sub-directories
+        if(map_dirs[i].find('.') != std::string::npos)
+            continue;
+
+        std::string dir_name = "dat/maps/" + map_dirs[i] + "/";
+        std::vector<std::string> map_files = ListDirectory(dir_name, "_map.lua");
+        for(uint32 j = 0; j < map_files.size(); ++j) {
+            std::string map_filename = dir_name + map_files[j];
+            std::string atlas_filename = MapData::GetAtlasFilename(map_filename);
+
+            MapData map_data;
+            if(!map_data.Load(map_filename)) {
+                std::cerr << "Couldn't load the map data of: " << map_filename << std::endl;
+                ++num_errors;
+                continue;
+            }
+
+            // Each tileset image is 512x512 pixels, yielding 16 * 16 (== 256) 32x32 pixel tiles each
+            std::vector<vt_video::TextureAtlasSource> sources;
+            for(uint32 k = 0; k < map_data.tilesets.size(); ++k)
+                sources.push_back(vt_video::TextureAtlasSource(map_data.tilesets[k].image_filename, 16, 16));
+
+            if(!vt_video::TextureAtlas::Bake(sources, atlas_filename)) {
+                std::cerr << "Couldn't bake the texture atlas of: " << map_filename << std::endl;
+                ++num_errors;
+                continue;
+            }
+
+            std::cout << "Baked: " << atlas_filename << std::endl;
+            ++num_atlases;
+        }
+    }
+
+    std::cout << num_atlases << " texture atlas(es) baked, " << num_errors << " error(s)." << std::endl;
+    return num_errors == 0;
+} // bool BakeMapAtlases()
+
+
+
+bool BenchmarkPathFinding()
+{
+    using namespace vt_map::private_map;
+
+    // The number of random paths to compute on each map
+    const uint32 NUM_PATHS_PER_MAP = 200;
+
+    if(SDL_Init(SDL_INIT_TIMER) != 0) {
+        std::cerr << "ERROR: Unable to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    printf("\n===== Path finding benchmark (%d paths per map)\n", NUM_PATHS_PER_MAP);
+
+    // A single search often takes less than a millisecond, so the times are measured in microseconds.
+    uint32 total_time = 0;
+    uint32 total_paths = 0;
+
+    std::vector<std::string> map_dirs = ListDirectory("dat/maps", "");
+    for(uint32 i = 0; i < map_dirs.size(); ++i) {
+        // Only consider the sub-directories
+        if(map_dirs[i].find('.') != std::string::npos)
+            continue;
+
+        std::string dir_name = "dat/maps/" + map_dirs[i] + "/";
+        std::vector<std::string> map_files = ListDirectory(dir_name, "_map.lua");
+        for(uint32 j = 0; j < map_files.size(); ++j) {
+            std::string map_filename = dir_name + map_files[j];
+
+            MapData map_data;
+            ObjectSupervisor object_supervisor;
+            if(!map_data.Load(map_filename) || !object_supervisor.Load(map_data)) {
+                std::cerr << "Couldn't load the collision grid of: " << map_filename << std::endl;
+                continue;
+            }
+
+            uint32 grid_x = 0;
+            uint32 grid_y = 0;
+            object_supervisor.GetGridAxis(grid_x, grid_y);
+
+            // Use the common map sprite collision size
+            VirtualSprite sprite;
+            sprite.SetCollHalfWidth(0.95f);
+            sprite.SetCollHeight(1.9f);
+            sprite.SetCollisionMask(WALL_COLLISION);
+
+            uint32 num_paths = 0;
+            uint32 num_nodes = 0;
+            uint32 map_time = 0;
+            // Limit the attempts in case the map has few walkable positions
+            for(uint32 attempt = 0; attempt < NUM_PATHS_PER_MAP * 10 && num_paths < NUM_PATHS_PER_MAP; ++attempt) {
+                float source_x = static_cast<float>(RandomBoundedInteger(1, grid_x - 2)) + 0.5f;
+                float source_y = static_cast<float>(RandomBoundedInteger(2, grid_y - 1)) + 0.5f;
+                MapPosition destination(static_cast<float>(RandomBoundedInteger(1, grid_x - 2)) + 0.5f,
+                                        static_cast<float>(RandomBoundedInteger(2, grid_y - 1)) + 0.5f);
+
+                if(object_supervisor.DetectCollision(&sprite, source_x, source_y) != NO_COLLISION
+                        || object_supervisor.DetectCollision(&sprite, destination.x, destination.y) != NO_COLLISION)
+                    continue;
+                if(static_cast<int32>(source_x) == static_cast<int32>(destination.x)
+                        && static_cast<int32>(source_y) == static_cast<int32>(destination.y))
+                    continue;
+
+                sprite.SetPosition(source_x, source_y);
+
+                uint32 start_time = vt_system::GetPreciseTime();
+                Path path = object_supervisor.FindPath(&sprite, destination);
+                map_time += vt_system::GetPreciseTime() - start_time;
+
+                num_nodes += path.size();
+                ++num_paths;
+            }
+
+            total_time += map_time;
+            total_paths += num_paths;
+
+            printf("%-60s %3dx%-3d %4d paths %6d nodes %10.3f ms\n", map_filename.c_str(),
+                   grid_x, grid_y, num_paths, num_nodes, map_time / 1000.0f);
+        }
+    }
+
+    printf("Total: %d paths in %.3f ms (%.3f ms per path)\n\n", total_paths, total_time / 1000.0f,
+           total_paths > 0 ? static_cast<float>(total_time) / 1000.0f / static_cast<float>(total_paths) : 0.0f);
+
+    return true;
+} // bool BenchmarkPathFinding()
+
+
+
+bool BenchmarkParticles()
+{
+    using namespace vt_mode_manager;
+
+    // The number of instances of each effect, so that the busiest ones reach tens of thousands of particles
+    const uint32 NUM_INSTANCES = 32;
+    // The effects are simulated at 60 frames per second, and only timed once they had a second to fill up
+    const uint32 NUM_WARMUP_FRAMES = 60;
+    const uint32 NUM_FRAMES = 600;
+    const float FRAME_TIME = 1.0f / 60.0f;
+
+    if(SDL_Init(SDL_INIT_TIMER) != 0) {
+        std::cerr << "ERROR: Unable to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    // Needed by the particle worker threads.
+    vt_system::SystemManager = vt_system::SystemEngine::SingletonCreate();
+
+    // The same particles are simulated on every run, whatever the number of threads.
+    srand(1);
+
+    ParticleWorkers workers;
+
+    printf("\n===== Particle benchmark (%d instances per effect, %d frames, update + vertex generation)\n",
+           NUM_INSTANCES, NUM_FRAMES);
+
+    uint32 total_time = 0;
+    // The particle counts can exceed 32 bits over all the effects
+    double total_particles = 0.0;
+
+    const std::string dir_name = "dat/effects/particles/";
+    std::vector<std::string> effect_files = ListDirectory(dir_name, ".lua");
+    for(uint32 i = 0; i < effect_files.size(); ++i) {
+        std::string effect_filename = dir_name + effect_files[i];
+
+        // The effects refer to their own definition, so they can't be copied.
+        std::vector<ParticleEffect *> effects;
+        for(uint32 j = 0; j < NUM_INSTANCES; ++j) {
+            ParticleEffect *effect = new ParticleEffect();
+            if(!effect->LoadEffectWithoutImages(effect_filename)) {
+                delete effect;
+                break;
+            }
+            effects.push_back(effect);
+        }
+
+        if(effects.size() != NUM_INSTANCES) {
+            std::cerr << "Couldn't load the particle effect: " << effect_filename << std::endl;
+            for(uint32 j = 0; j < effects.size(); ++j)
+                delete effects[j];
+            continue;
+        }
+
+        for(uint32 frame = 0; frame < NUM_WARMUP_FRAMES; ++frame)
+            workers.UpdateEffects(effects, FRAME_TIME);
+
+        double num_particles = 0.0;
+        uint32 start_time = SDL_GetTicks();
+        for(uint32 frame = 0; frame < NUM_FRAMES; ++frame) {
+            workers.UpdateEffects(effects, FRAME_TIME);
+            for(uint32 j = 0; j < NUM_INSTANCES; ++j) {
+                effects[j]->GenerateVertices();
+                num_particles += effects[j]->GetNumParticles();
+            }
+        }
+        uint32 effect_time = SDL_GetTicks() - start_time;
+
+        for(uint32 j = 0; j < NUM_INSTANCES; ++j)
+            delete effects[j];
+
+        total_time += effect_time;
+        total_particles += num_particles;
+
+        printf("%-50s %7d particles per frame %6d ms %8.1f ns per particle\n", effect_filename.c_str(),
+               static_cast<int32>(num_particles / NUM_FRAMES), effect_time,
+               num_particles > 0.0 ? effect_time * 1000000.0 / num_particles : 0.0);
+    }
+
+    printf("Total: %d ms for %.0f particle updates (%.1f ns per particle, %d worker threads)\n\n", total_time,
+           total_particles, total_particles > 0.0 ? total_time * 1000000.0 / total_particles : 0.0,
+           workers.GetNumberWorkers());
+
+    const vt_system::JobSystem &job_system = vt_system::SystemManager->GetJobSystem();
+    for(uint32 i = 0; i <= job_system.GetNumberWorkers(); ++i) {
+        const vt_system::JobWorkerStatistics &statistics = job_system.GetWorkerStatistics(i);
+        printf("%s %d: %d jobs run, %d stolen, %.1f%% busy\n", (i == 0) ? "Main thread" : "Worker thread", i,
+               statistics.jobs_run, statistics.jobs_stolen, statistics.GetUtilisation() * 100.0f);
+    }
+    printf("\n");
+
+    return true;
+} // bool BenchmarkParticles()
+
+
+
+bool BenchmarkEvents()
+{
+    using namespace vt_global;
+
+    // Matches a long game, where each map and script keeps its own events
+    const uint32 NUM_GROUPS = 100;
+    const uint32 NUM_EVENTS_PER_GROUP = 50;
+    // The number of times every event is looked up
+    const uint32 NUM_ROUNDS = 200;
+
+    if(SDL_Init(SDL_INIT_TIMER) != 0) {
+        std::cerr << "ERROR: Unable to initialize SDL: " << SDL_GetError() << std::endl;
+        return false;
+    }
+
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    // The global scripts aren't needed by the events.
+    GlobalManager = GameGlobal::SingletonCreate();
+
+    std::vector<std::string> group_names;
+    std::vector<std::string> event_names;
+    for(uint32 i = 0; i < NUM_GROUPS; ++i)
+        group_names.push_back("map_" + NumberToString(i));
+    for(uint32 i = 0; i < NUM_EVENTS_PER_GROUP; ++i)
+        event_names.push_back("event_" + NumberToString(i));
+
+    // Write the events the same way the Lua saved games store them.
+    const std::string filename = GetUserDataPath() + "event_benchmark.lua";
+    vt_script::WriteScriptDescriptor out_file;
+    if(!out_file.OpenFile(filename)) {
+        std::cerr << "Couldn't write the saved game: " << filename << std::endl;
+        return false;
+    }
+    out_file.WriteLine("event_groups = {");
+    for(uint32 i = 0; i < NUM_GROUPS; ++i) {
+        out_file.WriteLine("\t" + group_names[i] + " = {");
+        for(uint32 j = 0; j < NUM_EVENTS_PER_GROUP; ++j)
+            out_file.WriteLine("\t\t[\"" + event_names[j] + "\"] = " + NumberToString(i + j) + ",");
+        out_file.WriteLine("\t},");
+    }
+    out_file.WriteLine("}");
+    out_file.SaveFile();
+    out_file.CloseFile();
+
+    printf("\n===== Event benchmark (%d groups of %d events, %d lookups per event)\n",
+           NUM_GROUPS, NUM_EVENTS_PER_GROUP, NUM_ROUNDS);
+
+    // Load the events the same way the Lua saved games are read.
+    uint32 start_time = SDL_GetTicks();
+    vt_script::ReadScriptDescriptor in_file;
+    if(!in_file.OpenFile(filename) || !in_file.OpenTable("event_groups")) {
+        std::cerr << "Couldn't read the saved game: " << filename << std::endl;
+        DeleteFile(filename);
+        return false;
+    }
+    std::vector<std::string> loaded_groups;
+    in_file.ReadTableKeys(loaded_groups);
+    for(uint32 i = 0; i < loaded_groups.size(); ++i) {
+        if(!in_file.OpenTable(loaded_groups[i]))
+            continue;
+        std::vector<std::string> loaded_events;
+        in_file.ReadTableKeys(loaded_events);
+        for(uint32 j = 0; j < loaded_events.size(); ++j)
+            GlobalManager->SetEventValue(loaded_groups[i], loaded_events[j], in_file.ReadInt(loaded_events[j]));
+        in_file.CloseTable();
+    }
+    in_file.CloseTable();
+    in_file.CloseFile();
+    DeleteFile(filename);
+    uint32 load_time = SDL_GetTicks() - start_time;
+
+    // The checksums make sure both lookups are done, and give the same values.
+    int32 name_checksum = 0;
+    start_time = SDL_GetTicks();
+    for(uint32 round = 0; round < NUM_ROUNDS; ++round) {
+        for(uint32 i = 0; i < NUM_GROUPS; ++i) {
+            for(uint32 j = 0; j < NUM_EVENTS_PER_GROUP; ++j)
+                name_checksum += GlobalManager->GetEventValue(group_names[i], event_names[j]);
+        }
+    }
+    uint32 name_time = SDL_GetTicks() - start_time;
+
+    start_time = SDL_GetTicks();
+    std::vector<uint32> event_keys;
+    for(uint32 i = 0; i < NUM_GROUPS; ++i) {
+        for(uint32 j = 0; j < NUM_EVENTS_PER_GROUP; ++j)
+            event_keys.push_back(GlobalManager->GetEventKey(group_names[i], event_names[j]));
+    }
+    uint32 key_request_time = SDL_GetTicks() - start_time;
+
+    int32 key_checksum = 0;
+    start_time = SDL_GetTicks();
+    for(uint32 round = 0; round < NUM_ROUNDS; ++round) {
+        for(uint32 i = 0; i < event_keys.size(); ++i)
+            key_checksum += GlobalManager->GetEventValue(event_keys[i]);
+    }
+    uint32 key_time = SDL_GetTicks() - start_time;
+
+    double num_lookups = static_cast<double>(NUM_ROUNDS) * NUM_GROUPS * NUM_EVENTS_PER_GROUP;
+    printf("Loading:          %6d ms for %d events\n", load_time, NUM_GROUPS * NUM_EVENTS_PER_GROUP);
+    printf("Lookups by name:  %6d ms (%.1f ns per lookup)\n", name_time, name_time * 1000000.0 / num_lookups);
+    printf("Key requests:     %6d ms\n", key_request_time);
+    printf("Lookups by key:   %6d ms (%.1f ns per lookup)\n\n", key_time, key_time * 1000000.0 / num_lookups);
+
+    GameGlobal::SingletonDestroy();
+    GlobalManager = NULL;
+
+    if(name_checksum != key_checksum) {
+        std::cerr << "ERROR: the lookups by name and by key gave different values." << std::endl;
+        return false;
+    }
+    return true;
+} // bool BenchmarkEvents()
+
+
+//! \brief A key pressed or released by a benchmark, at the given step.
+struct BenchmarkInput {
+    uint32 frame;
+    int32 key;
+    bool pressed;
+};
+
+static bool CompareBenchmarkInputs(const BenchmarkInput &first, const BenchmarkInput &second)
+{
+    return first.frame < second.frame;
+}
+
+//! \brief Returns the key currently bound to a benchmark key name, or SDLK_UNKNOWN.
+static int32 GetBenchmarkKey(const std::string &name)
+{
+    using namespace vt_input;
+
+    if(name == "up")
+        return InputManager->GetUpKey();
+    else if(name == "down")
+        return InputManager->GetDownKey();
+    else if(name == "left")
+        return InputManager->GetLeftKey();
+    else if(name == "right")
+        return InputManager->GetRightKey();
+    else if(name == "confirm")
+        return InputManager->GetConfirmKey();
+    else if(name == "cancel")
+        return InputManager->GetCancelKey();
+    else if(name == "menu")
+        return InputManager->GetMenuKey();
+    else if(name == "minimap")
+        return InputManager->GetMinimapKey();
+    else if(name == "pause")
+        return InputManager->GetPauseKey();
+    return SDLK_UNKNOWN;
+}
+
+//! \brief The random number generator seed of the benchmarks not giving any.
+const uint32 BENCHMARK_DEFAULT_SEED = 1;
+
+//! \brief Returns the given string as a JSON string, quotes included.
+static std::string GetJSONString(const std::string &value)
+{
+    std::string json = "\"";
+    for(uint32 i = 0; i < value.size(); ++i) {
+        unsigned char character = static_cast<unsigned char>(value[i]);
+        if(character == '"' || character == '\\') {
+            json += '\\';
+            json += value[i];
+        } else if(character < 0x20) {
+            const char *hex_digits = "0123456789abcdef";
+            json += "\\u00";
+            json += hex_digits[character >> 4];
+            json += hex_digits[character & 0xf];
+        } else {
+            json += value[i];
+        }
+    }
+    return json + "\"";
+}
+
+//! \brief Writes a timing of the benchmark results, as a JSON object member.
+static void WriteBenchmarkTiming(std::ostream &out, const std::string &name,
+                                 vt_system::SYSTEM_TIMING timing, uint32 number_frames, bool last)
+{
+    const vt_system::SystemTiming &measured = vt_system::SystemManager->GetTiming(timing);
+    out << "    " << GetJSONString(name) << ": { \"total_ms\": " << measured.time / 1000.0
+        << ", \"calls\": " << measured.calls
+        << ", \"per_frame_ms\": " << measured.time / 1000.0 / number_frames << " }"
+        << (last ? "" : ",") << std::endl;
+}
+
+bool StartInputRecordOrReplay()
+{
+    if(!record_input_filename.empty())
+        return vt_input::InputManager->StartRecording(record_input_filename);
+    if(!replay_input_filename.empty())
+        return vt_input::InputManager->StartReplay(replay_input_filename);
+    return true;
+}
+
+bool IsBenchmarkRequested()
+{
+    return !benchmark_filename.empty();
+}
+
+bool RunBenchmark()
+{
+    using namespace vt_system;
+    using namespace vt_mode_manager;
+
+    vt_script::ReadScriptDescriptor script;
+    if(!script.OpenFile(benchmark_filename))
+        return false;
+
+    uint32 number_frames = script.ReadUInt("frames");
+    if(number_frames == 0) {
+        std::cerr << "ERROR: no frames to run in the benchmark: " << benchmark_filename << std::endl;
+        script.CloseFile();
+        return false;
+    }
+
+    std::vector<BenchmarkInput> inputs;
+    if(script.DoesTableExist("inputs")) {
+        script.OpenTable("inputs");
+        uint32 number_inputs = script.GetTableSize();
+        for(uint32 i = 1; i <= number_inputs; ++i) {
+            if(!script.OpenTable(i))
+                continue;
+
+            BenchmarkInput input;
+            input.frame = script.ReadUInt("frame");
+            input.key = GetBenchmarkKey(script.ReadString("key"));
+            input.pressed = script.ReadBool("pressed");
+            if(input.key != SDLK_UNKNOWN)
+                inputs.push_back(input);
+            else
+                std::cerr << "WARNING: unknown key in the benchmark input: " << i << std::endl;
+            script.CloseTable();
+        }
+        script.CloseTable();
+    }
+    std::stable_sort(inputs.begin(), inputs.end(), CompareBenchmarkInputs);
+
+    std::string script_profile_filename;
+    if(script.DoesStringExist("script_profile"))
+        script_profile_filename = script.ReadString("script_profile");
+
+    // The battle AI and damage variance draw random numbers, which must be the same on every run.
+    uint32 seed = BENCHMARK_DEFAULT_SEED;
+    if(script.DoesUIntExist("seed"))
+        seed = script.ReadUInt("seed");
+    srand(static_cast<unsigned int>(seed));
+
+    // The setup function pushes the map or battle to run.
+    if(!script.DoesFunctionExist("Setup") || !script.RunScriptFunction("Setup")) {
+        std::cerr << "ERROR: couldn't set the benchmark up: " << benchmark_filename << std::endl;
+        script.CloseFile();
+        return false;
+    }
+    script.CloseFile();
+
+    // The first step starts the pushed game mode, which isn't measured.
+    SystemManager->UpdateTimersByStep();
+    ModeManager->Update();
+    SystemManager->GetJobSystem().Update();
+    if(ModeManager->GetTop() == NULL) {
+        std::cerr << "ERROR: the benchmark setup didn't push any game mode: " << benchmark_filename << std::endl;
+        return false;
+    }
+
+    SystemManager->ResetTimings();
+    SystemManager->EnableTimings(true);
+    if(!script_profile_filename.empty())
+        vt_script::ScriptManager->StartProfiling(true);
+
+    uint32 next_input = 0;
+    uint32 frames_run = 0;
+    uint32 start_time = GetPreciseTime();
+    for(; frames_run < number_frames && SystemManager->NotDone(); ++frames_run) {
+        // The inputs go through the event queue, as the keyboard ones do.
+        for(; next_input < inputs.size() && inputs[next_input].frame <= frames_run; ++next_input) {
+            SDL_Event event;
+            memset(&event, 0, sizeof(event));
+            event.type = inputs[next_input].pressed ? SDL_KEYDOWN : SDL_KEYUP;
+            event.key.type = event.type;
+            event.key.state = inputs[next_input].pressed ? SDL_PRESSED : SDL_RELEASED;
+            event.key.keysym.sym = static_cast<SDLKey>(inputs[next_input].key);
+            SDL_PushEvent(&event);
+        }
+
+        SystemManager->UpdateTimersByStep();
+        {
+            ScopedTiming timing(SYSTEM_TIMING_UPDATE);
+            vt_input::InputManager->EventHandler();
+            vt_video::VideoManager->Update();
+            vt_audio::AudioManager->Update();
+            ModeManager->Update();
+        }
+        {
+            ScopedTiming timing(SYSTEM_TIMING_DRAW);
+            vt_video::VideoManager->Clear();
+            ModeManager->Draw();
+            ModeManager->DrawEffects();
+            ModeManager->DrawPostEffects();
+            vt_video::VideoManager->DrawFadeEffect();
+            vt_video::VideoManager->EndFrame();
+        }
+        SystemManager->GetJobSystem().Update();
+        vt_script::ScriptManager->StepGarbageCollector(-1);
+    }
+    uint32 total_time = GetPreciseTime() - start_time;
+    SystemManager->EnableTimings(false);
+    if(!script_profile_filename.empty()) {
+        vt_script::ScriptManager->StopProfiling();
+        if(!vt_script::ScriptManager->GetProfiler().Dump(script_profile_filename))
+            return false;
+    }
+
+    if(frames_run == 0) {
+        std::cerr << "ERROR: the game exited before the benchmark ran." << std::endl;
+        return false;
+    }
+
+    std::ofstream results_file;
+    if(!benchmark_results_filename.empty()) {
+        results_file.open(benchmark_results_filename.c_str());
+        if(!results_file) {
+            std::cerr << "ERROR: couldn't write the benchmark results: " << benchmark_results_filename << std::endl;
+            return false;
+        }
+    }
+    std::ostream &out = results_file.is_open() ? static_cast<std::ostream &>(results_file) : std::cout;
+
+    // The times of the parts called from others are included in theirs:
+    // the script calls, collisions and path finding are part of the update.
+    out << "{" << std::endl
+        << "  \"benchmark\": " << GetJSONString(benchmark_filename) << "," << std::endl
+        << "  \"seed\": " << seed << "," << std::endl
+        << "  \"frames\": " << frames_run << "," << std::endl
+        << "  \"total_ms\": " << total_time / 1000.0 << "," << std::endl
+        << "  \"timings\": {" << std::endl;
+    WriteBenchmarkTiming(out, "update", SYSTEM_TIMING_UPDATE, frames_run, false);
+    WriteBenchmarkTiming(out, "draw_submission", SYSTEM_TIMING_DRAW, frames_run, false);
+    WriteBenchmarkTiming(out, "script_calls", SYSTEM_TIMING_SCRIPT, frames_run, false);
+    WriteBenchmarkTiming(out, "collision", SYSTEM_TIMING_COLLISION, frames_run, false);
+    WriteBenchmarkTiming(out, "path_finding", SYSTEM_TIMING_PATH_FINDING, frames_run, false);
+    WriteBenchmarkTiming(out, "script_gc", SYSTEM_TIMING_SCRIPT_GC, frames_run, true);
+    out << "  }," << std::endl
+        << "  \"lua_heap_kib\": " << vt_script::ScriptManager->GetHeapSize() / 1024 << "," << std::endl
+        << "  \"lua_gc_cycles\": " << vt_script::ScriptManager->GetGarbageCollector().GetNumberCycles() << "," << std::endl
+        << "  \"lua_gc_full_collections\": " << vt_script::ScriptManager->GetGarbageCollector().GetNumberFullCollections() << std::endl
+        << "}" << std::endl;
+
+    return !out.fail();
+} // bool RunBenchmark()
+
+
+
+bool ConvertSavedGame(const std::string &input_filename, const std::string &output_filename)
+{
+    using namespace vt_global::private_global;
+
+    // The Lua saved games are read and written through the script engine.
+    vt_script::ScriptManager = vt_script::ScriptEngine::SingletonCreate();
+    if(vt_script::ScriptManager->SingletonInitialize() == false) {
+        std::cerr << "ERROR: unable to initialize the ScriptManager" << std::endl;
+        return false;
+    }
+
+    SaveGameData data;
+    if(!ReadSaveGame(input_filename, data)) {
+        std::cerr << "Couldn't read the saved game: " << input_filename << std::endl;
+        return false;
+    }
+
+    if(!WriteSaveGame(data, output_filename)) {
+        std::cerr << "Couldn't write the saved game: " << output_filename << std::endl;
+        return false;
+    }
+
+    std::cout << "Converted " << input_filename << " to " << output_filename << std::endl;
+    return true;
+} // bool ConvertSavedGame(...)
+
+
+
 bool EnableDebugging(const std::string &vars)
 {
     // A vector of all the debug arguments
@@ -52,6 +52,84 @@ bool PrintSystemInformation();
 **/
 bool CheckFiles();
 
+/** \brief Packs the tilesets of every map found in dat/maps into texture atlases.
+*** \return False if any atlas couldn't be baked.
+***
+*** The atlases are written next to the map data files, and are used by map mode
+*** instead of the tileset images as long as they are more recent than those.
+*** The sprite sheets aren't baked, see texture_atlas.h.
+**/
+bool BakeMapAtlases();
+
+/** \brief Writes the binary cache of every map data file found in dat/maps.
+*** \return False if any map cache couldn't be written.
+**/
+bool BuildMapCaches();
+
+/** \brief Times the map path finding over the collision grid of every map found in dat/maps.
+*** \return False if the benchmark couldn't be run.
+***
+*** Random walkable source and destination positions are picked on each map,
+*** and the time spent in ObjectSupervisor::FindPath() is reported per map.
+**/
+bool BenchmarkPathFinding();
+
+/** \brief Times the update and vertex generation of every particle effect found in dat/effects/particles.
+*** \return False if the benchmark couldn't be run.
+***
+*** The effects are loaded without their images, so no video context is needed.
+*** Several instances of each effect are simulated at a fixed frame rate,
+*** and the time spent is reported per effect and per particle. The effects
+*** are updated on the particle worker threads, with a fixed random seed.
+**/
+bool BenchmarkParticles();
+
+/** \brief Times the game event lookups over a saved game holding thousands of events.
+*** \return False if the benchmark couldn't be run.
+***
+*** A saved game event table is written in the user data folder and loaded
+*** back, then every event is looked up through the group and event names,
+*** and through the event keys.
+**/
+bool BenchmarkEvents();
+
+/** \brief Starts recording or replaying the input, as requested with --record-input or --replay-input.
+*** \return False if the input record couldn't be written or read.
+***
+*** It must be called once the engine is initialized, right before the main loop,
+*** so that the record starts with the first game step.
+**/
+bool StartInputRecordOrReplay();
+
+//! \brief Tells whether a benchmark was requested with --benchmark, to run instead of the game.
+bool IsBenchmarkRequested();
+
+/** \brief Runs the benchmark requested with --benchmark, once the engine is initialized.
+*** \return False if the benchmark couldn't be run, or its results written.
+***
+*** The benchmark file is a Lua script holding the number of fixed steps to run
+*** as "frames", the keys to press and release as "inputs", and a Setup()
+*** function pushing the map or battle to run. Each step is updated and drawn
+*** without any display, and the time spent in the update, the draw submission,
+*** the script calls, the collision detection, the path finding and the Lua garbage
+*** collection is written as JSON, along with the Lua heap size.
+*** When the file names a "script_profile" file, the Lua functions are sampled
+*** meanwhile, which slows the script calls down, and their profile is written there.
+*** The random number generator is seeded with the file "seed", or 1, before
+*** Setup() is run, so that the same scenario is played on every run.
+**/
+bool RunBenchmark();
+
+/** \brief Converts a saved game file between the binary and the Lua formats.
+*** \param input_filename The saved game to read, in either format.
+*** \param output_filename The saved game to write, in the Lua format if it ends with ".lua".
+*** \return False if the saved game couldn't be read or written.
+***
+*** The Lua format is kept so that saved games can be inspected, edited,
+*** and imported back.
+**/
+bool ConvertSavedGame(const std::string &input_filename, const std::string &output_filename);
+
 /** \brief Resets the game settings (audio volume, key mappings, etc.) to their default values.
 *** \return False if the settings could not be restored, or if another problem occured.
 **/
@@ -353,18 +353,27 @@ void BattleMode::Update()
     }
 
     // Add effects (particles and animations)
+    std::vector<ParticleEffect *> particle_effects;
     for(std::vector<BattleObject *>::iterator it = _battle_effects.begin();
             it != _battle_effects.end();) {
         if((*it)->CanBeRemoved()) {
             delete (*it);
             it = _battle_effects.erase(it);
         } else {
-            (*it)->Update();
+            ParticleEffect *particle_effect = (*it)->GetParticleEffect();
+            if(particle_effect != NULL)
+                particle_effects.push_back(particle_effect);
+            else
+                (*it)->Update();
             _battle_objects.push_back(*it);
             ++it;
         }
     }
 
+    // Stacked spell effects are updated in parallel.
+    ModeManager->GetParticleWorkers().UpdateEffects(particle_effects,
+            static_cast<float>(SystemManager->GetUpdateTime()) / 1000.0f);
+
     std::sort(_battle_objects.begin(), _battle_objects.end(), CompareObjectsYCoord);
 
     // If the battle is in scene mode, we only update animation
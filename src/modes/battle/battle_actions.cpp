@@ -112,6 +112,7 @@ SkillAction::SkillAction(BattleActor *actor, BattleTarget target, GlobalSkill *s
 void SkillAction::_InitAnimationScript()
 {
     try {
+        ScriptCallScope call(_init_function);
         ScriptCallFunction<void>(_init_function, _actor, _target, _skill);
     } catch(const luabind::error &err) {
         ScriptManager->HandleLuaError(err);
@@ -158,6 +159,7 @@ bool SkillAction::Update()
         return true;
 
     try {
+        ScriptCallScope call(_update_function);
         return ScriptCallFunction<bool>(_update_function);
     } catch(const luabind::error &err) {
         ScriptManager->HandleLuaError(err);
@@ -266,6 +268,7 @@ bool ItemAction::Execute()
 
     bool ret = false;
     try {
+        ScriptCallScope call(script_function);
         ret = ScriptCallFunction<bool>(script_function, _actor, _target);
     } catch(const luabind::error &err) {
         ScriptManager->HandleLuaError(err);
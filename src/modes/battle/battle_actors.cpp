@@ -1313,6 +1313,7 @@ void BattleEnemy::ChangeState(ACTOR_STATE new_state)
     case ACTOR_STATE_COMMAND: {
         if (_ai_script.is_valid()) {
             try {
+                ScriptCallScope call(_ai_script);
                 ScriptCallFunction<void>(_ai_script, BattleMode::CurrentInstance(), this);
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while triggering DecideAction() function of enemy id: " << _global_actor->GetID() << std::endl;
@@ -1340,6 +1341,7 @@ void BattleEnemy::ChangeState(ACTOR_STATE new_state)
         // Trigger the death sequence if it is valid
         if (_death_init.is_valid()) {
             try {
+                ScriptCallScope call(_death_init);
                 ScriptCallFunction<void>(_death_init, BattleMode::CurrentInstance(), this);
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while triggering Initialize() function of enemy id: " << _global_actor->GetID() << std::endl;
@@ -1400,6 +1402,7 @@ void BattleEnemy::Update()
             if (_death_update.is_valid()) {
                 // Change the state when the animation has finished.
                 try {
+                    ScriptCallScope call(_death_update);
                     if (ScriptCallFunction<bool>(_death_update))
                         ChangeState(ACTOR_STATE_DEAD);
                 } catch(const luabind::error &e) {
@@ -1462,6 +1465,7 @@ void BattleEnemy::DrawSprite()
         _sprite_animations->at(GLOBAL_ENEMY_HURT_HEAVILY).Draw(Color(1.0f, 1.0f, 1.0f, _sprite_alpha));
 
         try {
+            ScriptCallScope call(_death_draw_on_sprite);
             if (_death_draw_on_sprite.is_valid())
                 ScriptCallFunction<void>(_death_draw_on_sprite);
         } catch(const luabind::error &e) {
@@ -99,6 +99,12 @@ public:
     virtual void Update()
     {}
 
+    //! \brief Gives the particle effect of the object, or NULL when it has none.
+    //! \note The battle mode updates the particle effects on its own, all at once.
+    virtual vt_mode_manager::ParticleEffect *GetParticleEffect() {
+        return NULL;
+    }
+
 protected:
     //! \brief The "home" coordinates for the actor's default location on the battle field
     float _x_origin, _y_origin;
@@ -131,6 +137,10 @@ public:
         _effect.Update();
     }
 
+    vt_mode_manager::ParticleEffect *GetParticleEffect() {
+        return &_effect;
+    }
+
 protected:
     //! The particle effect class used internally
     vt_mode_manager::ParticleEffect _effect;
@@ -267,6 +267,7 @@ void EffectsSupervisor::_UpdatePassive()
 
             // Call the update passive function
             try {
+                ScriptCallScope call(effect.GetUpdatePassiveFunction());
                 ScriptCallFunction<void>(effect.GetUpdatePassiveFunction(), _actor, effect.GetIntensity());
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while loading status effect BattleUpdatePassive() function" << std::endl;
@@ -338,6 +339,7 @@ void EffectsSupervisor::Update()
             if (_status_effects[i]->GetUpdateFunction().is_valid()) {
 
                 try {
+                    ScriptCallScope call(_status_effects[i]->GetUpdateFunction());
                     ScriptCallFunction<void>(_status_effects[i]->GetUpdateFunction(), _status_effects[i]);
                 } catch(const luabind::error &e) {
                     PRINT_ERROR << "Error while loading status effect Update function" << std::endl;
@@ -517,6 +519,7 @@ void EffectsSupervisor::_CreateNewStatus(GLOBAL_STATUS status, GLOBAL_INTENSITY
 
     // Call the apply script function now that this new status is active on the actor
     try {
+        ScriptCallScope call(new_effect->GetApplyFunction());
         ScriptCallFunction<void>(new_effect->GetApplyFunction(), new_effect);
     } catch(const luabind::error &e) {
         PRINT_ERROR << "Error while loading status effect Apply function" << std::endl;
@@ -540,6 +543,7 @@ void EffectsSupervisor::_RemoveStatus(ActiveBattleStatusEffect *status_effect)
 
         if (status_effect->GetRemoveFunction().is_valid()) {
             try {
+                ScriptCallScope call(status_effect->GetRemoveFunction());
                 ScriptCallFunction<void>(status_effect->GetRemoveFunction(), status_effect);
             } catch(const luabind::error &e) {
                 PRINT_ERROR << "Error while loading status effect Remove function" << std::endl;
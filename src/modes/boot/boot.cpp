@@ -419,13 +419,8 @@ bool BootMode::_SavesAvailable(int32 maxId)
 {
     assert(maxId > 0);
     int32 savesAvailable = 0;
-    std::string data_path = GetUserDataPath();
     for(int id = 0; id < maxId; ++id) {
-        std::ostringstream f;
-        f << data_path + "saved_game_" << id << ".lua";
-        const std::string filename = f.str();
-
-        if(DoesFileExist(filename)) {
+        if(!vt_global::GameGlobal::FindSaveSlotFilename(id).empty()) {
             ++savesAvailable;
         }
     }
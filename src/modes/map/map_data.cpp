@@ -0,0 +1,554 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_data.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map data file loading and caching.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "modes/map/map_data.h"
+
+#include "engine/script/script_read.h"
+
+#include "utils/utils_files.h"
+
+using namespace vt_utils;
+using namespace vt_script;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief The binary map cache file identifier.
+const char MAP_CACHE_MAGIC[8] = { 'V', 'T', 'M', 'A', 'P', 'B', 'I', 'N' };
+
+//! \brief The binary map cache format version. Increase it whenever the format changes.
+const uint32 MAP_CACHE_VERSION = 1;
+
+//! \brief Written as is in the cache, used to reject caches created on a platform with another byte order.
+const uint32 MAP_CACHE_BYTE_ORDER = 0x01020304;
+
+//! \brief The binary map cache file extension, replacing the map data file ".lua" one.
+const std::string MAP_CACHE_EXTENSION = ".mapcache";
+
+//! \brief The texture atlas manifest file extension, replacing the map data file ".lua" one.
+const std::string MAP_ATLAS_EXTENSION = ".atlas";
+
+/** ****************************************************************************
+*** \brief Reads the values of a binary map cache in order, checking the bounds.
+***
+*** Every value starts on a 4 bytes boundary, so that the arrays are aligned.
+*** ***************************************************************************/
+class MapCacheReader
+{
+public:
+    MapCacheReader(const uint8 *data, size_t size) :
+        _data(data),
+        _size(size),
+        _position(0)
+    {}
+
+    //! \brief Returns a pointer to the next bytes, or NULL when the data is too short.
+    const void *ReadData(size_t size) {
+        if(size > _size - _position)
+            return NULL;
+
+        const void *data = _data + _position;
+        _position += (size + 3) & ~static_cast<size_t>(3);
+        if(_position > _size)
+            _position = _size;
+        return data;
+    }
+
+    bool ReadUInt(uint32 &value) {
+        const void *data = ReadData(sizeof(uint32));
+        if(!data)
+            return false;
+        memcpy(&value, data, sizeof(uint32));
+        return true;
+    }
+
+    /** \brief Tells whether there are enough bytes left for the given number of values.
+    *** The counts read from the cache are checked before allocating anything,
+    *** so that a corrupted count doesn't allocate a huge container.
+    **/
+    bool HasRoomFor(uint32 count, size_t value_size) const {
+        return value_size == 0 || count <= (_size - _position) / value_size;
+    }
+
+    //! \brief Reads a count, checking there is room left for at least that many values.
+    bool ReadSize(uint32 &size, size_t min_value_size) {
+        return ReadUInt(size) && HasRoomFor(size, min_value_size);
+    }
+
+    bool ReadString(std::string &value) {
+        uint32 length = 0;
+        if(!ReadUInt(length))
+            return false;
+        const void *data = ReadData(length);
+        if(!data)
+            return false;
+        value.assign(static_cast<const char *>(data), length);
+        return true;
+    }
+
+private:
+    const uint8 *_data;
+
+    size_t _size;
+
+    size_t _position;
+};
+
+//! \brief Appends data to a binary map cache buffer, padded to 4 bytes.
+static void WriteCacheData(std::vector<uint8> &buffer, const void *data, size_t size)
+{
+    const uint8 *bytes = static_cast<const uint8 *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+    buffer.resize((buffer.size() + 3) & ~static_cast<size_t>(3), 0);
+}
+
+static void WriteCacheUInt(std::vector<uint8> &buffer, uint32 value)
+{
+    WriteCacheData(buffer, &value, sizeof(uint32));
+}
+
+static void WriteCacheString(std::vector<uint8> &buffer, const std::string &value)
+{
+    WriteCacheUInt(buffer, value.size());
+    WriteCacheData(buffer, value.data(), value.size());
+}
+
+static LAYER_TYPE getLayerType(const std::string &type)
+{
+    if(type == "ground")
+        return GROUND_LAYER;
+    else if(type == "sky")
+        return SKY_LAYER;
+    return INVALID_LAYER;
+}
+
+// ----------------------------------------------------------------------------
+// ---------- MapData Class Functions
+// ----------------------------------------------------------------------------
+
+MapData::MapData() :
+    num_tile_cols(0),
+    num_tile_rows(0)
+{}
+
+void MapData::Clear()
+{
+    num_tile_cols = 0;
+    num_tile_rows = 0;
+    tilesets.clear();
+    layers.clear();
+    collision_grid.Clear();
+}
+
+std::string MapData::GetCacheFilename(const std::string &map_filename)
+{
+    std::string cache_filename = map_filename;
+    size_t extension = cache_filename.rfind(".lua");
+    if(extension != std::string::npos && extension == cache_filename.size() - 4)
+        cache_filename.erase(extension);
+    return cache_filename + MAP_CACHE_EXTENSION;
+}
+
+std::string MapData::GetAtlasFilename(const std::string &map_filename)
+{
+    std::string atlas_filename = map_filename;
+    size_t extension = atlas_filename.rfind(".lua");
+    if(extension != std::string::npos && extension == atlas_filename.size() - 4)
+        atlas_filename.erase(extension);
+    return atlas_filename + MAP_ATLAS_EXTENSION;
+}
+
+bool MapData::IsCacheUpToDate(const std::string &map_filename)
+{
+    // The cache must have been generated after the last map file modification.
+    time_t cache_time = GetFileModificationTime(GetCacheFilename(map_filename));
+    return cache_time > 0 && cache_time >= GetFileModificationTime(map_filename);
+}
+
+bool MapData::Load(const std::string &map_filename)
+{
+    std::string cache_filename = GetCacheFilename(map_filename);
+    if(IsCacheUpToDate(map_filename)) {
+        if(LoadCache(cache_filename))
+            return true;
+
+        PRINT_WARNING << "Invalid map cache file: " << cache_filename
+                      << ", loading the map data from: " << map_filename << std::endl;
+    }
+
+    return LoadScript(map_filename);
+}
+
+bool MapData::LoadScript(const std::string &map_filename)
+{
+    Clear();
+
+    // Clear out all old map data if existing.
+    ScriptManager->DropGlobalTable("map_data");
+
+    ReadScriptDescriptor map_file;
+    if(!map_file.OpenFile(map_filename)) {
+        PRINT_ERROR << "Couldn't open map data file: " << map_filename << std::endl;
+        return false;
+    }
+
+    if(!map_file.OpenTable("map_data")) {
+        PRINT_ERROR << "Couldn't open table 'map_data' in: " << map_filename << std::endl;
+        map_file.CloseFile();
+        return false;
+    }
+
+    // Construct the collision grid
+    if(!map_file.DoesTableExist("map_grid")) {
+        PRINT_ERROR << "No map grid found in map file: " << map_filename << std::endl;
+        map_file.CloseFile();
+        return false;
+    }
+
+    map_file.OpenTable("map_grid");
+    uint32 num_grid_rows = map_file.GetTableSize();
+    uint32 num_grid_cols = 0;
+    std::vector<uint32> collision_row;
+    for(uint32 y = 0; y < num_grid_rows; ++y) {
+        collision_row.clear();
+        map_file.ReadUIntVector(y, collision_row);
+
+        // The first row gives the grid width
+        if(y == 0) {
+            num_grid_cols = collision_row.size();
+            collision_grid.Resize(num_grid_cols, num_grid_rows);
+        }
+        else if(collision_row.size() != num_grid_cols) {
+            PRINT_WARNING << "The map_grid[" << y << "] row size is not equal to the first row size in map file: "
+                          << map_filename << std::endl;
+        }
+
+        uint32 row_size = std::min(static_cast<uint32>(collision_row.size()), num_grid_cols);
+        for(uint32 x = 0; x < row_size; ++x) {
+            if(collision_row[x] > 0)
+                collision_grid.Set(x, y, true);
+        }
+    }
+    map_file.CloseTable(); // map_grid
+
+    // Load the map dimensions
+    num_tile_rows = map_file.ReadInt("num_tile_rows");
+    num_tile_cols = map_file.ReadInt("num_tile_cols");
+
+    // Load the tileset definitions used by this map
+    std::vector<std::string> tileset_filenames;
+    map_file.ReadStringVector("tileset_filenames", tileset_filenames);
+
+    tilesets.resize(tileset_filenames.size());
+    for(uint32 i = 0; i < tileset_filenames.size(); ++i) {
+        MapTilesetData &tileset = tilesets[i];
+        tileset.filename = tileset_filenames[i];
+
+        ReadScriptDescriptor tileset_script;
+        if(!tileset_script.OpenFile(tileset.filename)) {
+            PRINT_ERROR << "Couldn't open the tileset definition file: " << tileset.filename << std::endl;
+            map_file.CloseFile();
+            return false;
+        }
+
+        if(!tileset_script.OpenTable("tileset")) {
+            PRINT_ERROR << "Couldn't open the 'tileset' table from file: " << tileset.filename << std::endl;
+            tileset_script.CloseFile();
+            map_file.CloseFile();
+            return false;
+        }
+
+        tileset.image_filename = tileset_script.ReadString("image");
+
+        if(tileset_script.DoesTableExist("animated_tiles")) {
+            tileset_script.OpenTable("animated_tiles");
+            for(uint32 j = 1; j <= tileset_script.GetTableSize(); ++j) {
+                tileset.animations.push_back(std::vector<uint32>());
+                tileset_script.ReadUIntVector(j, tileset.animations.back());
+            }
+            tileset_script.CloseTable(); // animated_tiles
+        }
+
+        tileset_script.CloseTable(); // tileset
+        tileset_script.CloseFile();
+    }
+
+    if(!map_file.DoesTableExist("layers")) {
+        PRINT_ERROR << "No 'layers' table in the map file: " << map_filename << std::endl;
+        map_file.CloseFile();
+        return false;
+    }
+
+    // Read in the map tile indeces from all tile layers.
+    std::vector<int32> table_x_indeces; // Used to temporarily store a row of table indeces
+
+    map_file.OpenTable("layers");
+
+    uint32 layers_number = map_file.GetTableSize();
+
+    // layers[0]-[n]
+    for(uint32 layer_id = 0; layer_id < layers_number; ++layer_id) {
+        // Opens the sub-table: layers[layer_id]
+        if(!map_file.DoesTableExist(layer_id))
+            continue;
+
+        map_file.OpenTable(layer_id);
+
+        LAYER_TYPE layer_type = getLayerType(map_file.ReadString("type"));
+
+        if(layer_type == INVALID_LAYER) {
+            PRINT_WARNING << "Ignoring unexisting layer type: " << layer_type
+                          << " in file: " << map_filename << std::endl;
+            map_file.CloseTable(); // layers[layer_id]
+            continue;
+        }
+
+        layers.push_back(MapLayerData());
+        MapLayerData &layer = layers.back();
+        layer.layer_type = layer_type;
+        layer.tiles.Resize(num_tile_cols, num_tile_rows, -1);
+
+        // Read the tile data
+        for(uint32 y = 0; y < num_tile_rows; ++y) {
+            table_x_indeces.clear();
+
+            // Check to make sure tables are of the proper size
+            if(!map_file.DoesTableExist(y)) {
+                PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
+                            " first missing row: " << y << std::endl;
+                map_file.CloseFile();
+                return false;
+            }
+
+            map_file.ReadIntVector(y, table_x_indeces);
+
+            // Check the number of columns
+            if(table_x_indeces.size() != num_tile_cols) {
+                PRINT_ERROR << "the layers[" << layer_id << "][" << y << "] table size was not equal to the number of tile columns specified by the map, "
+                            "should have " << num_tile_cols << " values." << std::endl;
+                map_file.CloseFile();
+                return false;
+            }
+
+            int16 *tile_row = layer.tiles[y];
+            for(uint32 x = 0; x < num_tile_cols; ++x)
+                tile_row[x] = table_x_indeces[x];
+        }
+        map_file.CloseTable(); // layers[layer_id]
+    }
+
+    map_file.CloseTable(); // layers
+
+    bool success = !map_file.IsErrorDetected();
+    if(!success) {
+        PRINT_ERROR << "Errors were detected while reading the map data file: " << map_filename << std::endl
+                    << map_file.GetErrorMessages() << std::endl;
+    }
+
+    map_file.CloseAllTables();
+    map_file.CloseFile();
+    return success;
+} // bool MapData::LoadScript(const std::string &map_filename)
+
+bool MapData::LoadCache(const std::string &cache_filename)
+{
+    Clear();
+
+    // The cache is small enough to be read at once.
+    std::ifstream file(cache_filename.c_str(), std::ios::in | std::ios::binary);
+    if(!file)
+        return false;
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    if(size <= 0)
+        return false;
+
+    std::vector<uint8> buffer(static_cast<size_t>(size));
+    file.seekg(0, std::ios::beg);
+    if(!file.read(reinterpret_cast<char *>(&buffer[0]), buffer.size()))
+        return false;
+    file.close();
+
+    MapCacheReader reader(&buffer[0], buffer.size());
+
+    const void *magic = reader.ReadData(sizeof(MAP_CACHE_MAGIC));
+    uint32 version = 0;
+    uint32 byte_order = 0;
+    if(!magic || memcmp(magic, MAP_CACHE_MAGIC, sizeof(MAP_CACHE_MAGIC)) != 0
+            || !reader.ReadUInt(version) || version != MAP_CACHE_VERSION
+            || !reader.ReadUInt(byte_order) || byte_order != MAP_CACHE_BYTE_ORDER) {
+        return false;
+    }
+
+    uint32 tile_cols = 0;
+    uint32 tile_rows = 0;
+    uint32 grid_cols = 0;
+    uint32 grid_rows = 0;
+    uint32 num_tilesets = 0;
+    uint32 num_layers = 0;
+    if(!reader.ReadUInt(tile_cols) || !reader.ReadUInt(tile_rows)
+            || !reader.ReadUInt(grid_cols) || !reader.ReadUInt(grid_rows)
+            || !reader.ReadUInt(num_tilesets) || !reader.ReadUInt(num_layers)) {
+        return false;
+    }
+
+    // Each tileset holds at least two string lengths and an animation count,
+    // and each layer at least its type, before any tile.
+    uint32 grid_words_per_row = (grid_cols >> 5) + ((grid_cols & 31) != 0 ? 1 : 0);
+    if(!reader.HasRoomFor(num_tilesets, 3 * sizeof(uint32)) || !reader.HasRoomFor(num_layers, sizeof(uint32))
+            || !reader.HasRoomFor(grid_words_per_row, sizeof(uint32))
+            || !reader.HasRoomFor(grid_rows, grid_words_per_row * sizeof(uint32))
+            || !reader.HasRoomFor(tile_cols, sizeof(int16))
+            || (num_layers > 0 && !reader.HasRoomFor(tile_rows, tile_cols * sizeof(int16)))) {
+        return false;
+    }
+    num_tile_cols = tile_cols;
+    num_tile_rows = tile_rows;
+
+    // Tilesets
+    tilesets.resize(num_tilesets);
+    for(uint32 i = 0; i < num_tilesets; ++i) {
+        MapTilesetData &tileset = tilesets[i];
+        uint32 num_animations = 0;
+        if(!reader.ReadString(tileset.filename) || !reader.ReadString(tileset.image_filename)
+                || !reader.ReadSize(num_animations, sizeof(uint32))) {
+            Clear();
+            return false;
+        }
+
+        tileset.animations.resize(num_animations);
+        for(uint32 j = 0; j < num_animations; ++j) {
+            uint32 num_values = 0;
+            if(!reader.ReadSize(num_values, sizeof(uint32))) {
+                Clear();
+                return false;
+            }
+            const uint32 *values = static_cast<const uint32 *>(reader.ReadData(num_values * sizeof(uint32)));
+            if(!values) {
+                Clear();
+                return false;
+            }
+            tileset.animations[j].assign(values, values + num_values);
+        }
+    }
+
+    // Collision grid
+    collision_grid.Resize(grid_cols, grid_rows);
+    const void *words = reader.ReadData(collision_grid.GetWords().size() * sizeof(uint32));
+    if(!words) {
+        Clear();
+        return false;
+    }
+    collision_grid.SetWords(static_cast<const uint32 *>(words));
+
+    // Tile layers
+    layers.resize(num_layers);
+    for(uint32 i = 0; i < num_layers; ++i) {
+        MapLayerData &layer = layers[i];
+        uint32 layer_type = INVALID_LAYER;
+        if(!reader.ReadUInt(layer_type) || layer_type >= INVALID_LAYER) {
+            Clear();
+            return false;
+        }
+        layer.layer_type = static_cast<LAYER_TYPE>(layer_type);
+
+        if(!reader.HasRoomFor(num_tile_rows, num_tile_cols * sizeof(int16))) {
+            Clear();
+            return false;
+        }
+        layer.tiles.Resize(num_tile_cols, num_tile_rows);
+        const void *tiles = reader.ReadData(num_tile_cols * num_tile_rows * sizeof(int16));
+        if(!tiles) {
+            Clear();
+            return false;
+        }
+        if(num_tile_cols > 0 && num_tile_rows > 0)
+            memcpy(layer.tiles[0], tiles, num_tile_cols * num_tile_rows * sizeof(int16));
+    }
+
+    return true;
+} // bool MapData::LoadCache(const std::string &cache_filename)
+
+bool MapData::SaveCache(const std::string &cache_filename) const
+{
+    std::vector<uint8> buffer;
+
+    WriteCacheData(buffer, MAP_CACHE_MAGIC, sizeof(MAP_CACHE_MAGIC));
+    WriteCacheUInt(buffer, MAP_CACHE_VERSION);
+    WriteCacheUInt(buffer, MAP_CACHE_BYTE_ORDER);
+
+    WriteCacheUInt(buffer, num_tile_cols);
+    WriteCacheUInt(buffer, num_tile_rows);
+    WriteCacheUInt(buffer, collision_grid.GetWidth());
+    WriteCacheUInt(buffer, collision_grid.GetHeight());
+    WriteCacheUInt(buffer, tilesets.size());
+    WriteCacheUInt(buffer, layers.size());
+
+    for(uint32 i = 0; i < tilesets.size(); ++i) {
+        const MapTilesetData &tileset = tilesets[i];
+        WriteCacheString(buffer, tileset.filename);
+        WriteCacheString(buffer, tileset.image_filename);
+        WriteCacheUInt(buffer, tileset.animations.size());
+        for(uint32 j = 0; j < tileset.animations.size(); ++j) {
+            const std::vector<uint32> &animation = tileset.animations[j];
+            WriteCacheUInt(buffer, animation.size());
+            if(!animation.empty())
+                WriteCacheData(buffer, &animation[0], animation.size() * sizeof(uint32));
+        }
+    }
+
+    const std::vector<uint32> &words = collision_grid.GetWords();
+    if(!words.empty())
+        WriteCacheData(buffer, &words[0], words.size() * sizeof(uint32));
+
+    for(uint32 i = 0; i < layers.size(); ++i) {
+        const MapLayerData &layer = layers[i];
+        WriteCacheUInt(buffer, layer.layer_type);
+        if(!layer.tiles.IsEmpty())
+            WriteCacheData(buffer, layer.tiles[0], layer.tiles.GetWidth() * layer.tiles.GetHeight() * sizeof(int16));
+    }
+
+    // Write to a temporary file first, so that a partially written cache is never used.
+    std::string temp_filename = cache_filename + ".tmp";
+    std::ofstream file(temp_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file) {
+        PRINT_ERROR << "Couldn't open the map cache file for writing: " << temp_filename << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size());
+    file.close();
+    if(file.fail()) {
+        PRINT_ERROR << "Couldn't write the map cache file: " << temp_filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+
+    if(!MoveFile(temp_filename, cache_filename)) {
+        PRINT_ERROR << "Couldn't create the map cache file: " << cache_filename << std::endl;
+        DeleteFile(temp_filename);
+        return false;
+    }
+    return true;
+} // bool MapData::SaveCache(const std::string &cache_filename) const
+
+} // namespace private_map
+
+} // namespace vt_map
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_data.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map data file loading and caching.
+***
+*** The map data files (*_map.lua) hold the map tile layers and collision grid
+*** as large Lua tables, which are slow to parse. This code reads them, along
+*** with the tilesets they reference, into plain containers and can store
+*** those into a binary map cache file which is loaded without any Lua parsing.
+***
+*** \note This file is also compiled in the editor, so it must not depend on
+*** the video engine or on map mode.
+*** ***************************************************************************/
+
+#ifndef __MAP_DATA_HEADER__
+#define __MAP_DATA_HEADER__
+
+#include "utils/utils_grid.h"
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief Layer types: Drawn before, along, or after the map objects according to their types.
+enum LAYER_TYPE {
+    GROUND_LAYER = 0,
+    SKY_LAYER = 1,
+    INVALID_LAYER = 2
+};
+
+//! \brief The data read from a tileset definition file.
+class MapTilesetData
+{
+public:
+    //! \brief The tileset definition filename.
+    std::string filename;
+
+    //! \brief The tileset image filename.
+    std::string image_filename;
+
+    /** \brief The tileset animations.
+    *** Every two elements correspond to a pair of tile frame index and display time.
+    **/
+    std::vector<std::vector<uint32> > animations;
+};
+
+//! \brief The data of a single tile layer.
+class MapLayerData
+{
+public:
+    LAYER_TYPE layer_type;
+
+    /** \brief The tile indeces: i.e: tiles[y][x] = tile index at (x,y)
+    *** 0-255 correspond to the first tileset, 256-511 the second, etc. and -1 means no tile.
+    **/
+    vt_utils::FlatGrid<int16> tiles;
+
+    MapLayerData():
+        layer_type(GROUND_LAYER)
+    {}
+};
+
+/** ****************************************************************************
+*** \brief The content of a map data file, needed to build the map tiles and collision grid.
+***
+*** The data can be loaded either from the map data Lua file, or from its binary
+*** cache. The cache is only used when it is more recent than the Lua file.
+*** ***************************************************************************/
+class MapData
+{
+public:
+    MapData();
+
+    /** \brief Loads the map data, from its binary cache when up to date, or from the Lua file otherwise.
+    *** \param map_filename The map data Lua filename.
+    **/
+    bool Load(const std::string &map_filename);
+
+    /** \brief Loads the map data from the map data Lua file and the tilesets it references.
+    *** \param map_filename The map data Lua filename.
+    **/
+    bool LoadScript(const std::string &map_filename);
+
+    /** \brief Loads the map data from a binary map cache file.
+    *** \note This doesn't use the script engine, so it can be called from any thread.
+    **/
+    bool LoadCache(const std::string &cache_filename);
+
+    //! \brief Writes the map data to a binary map cache file.
+    bool SaveCache(const std::string &cache_filename) const;
+
+    //! \brief Resets the data.
+    void Clear();
+
+    //! \brief Returns the binary cache filename of the given map data Lua file.
+    static std::string GetCacheFilename(const std::string &map_filename);
+
+    //! \brief Tells whether the binary cache of the given map data Lua file exists and is more recent than it.
+    static bool IsCacheUpToDate(const std::string &map_filename);
+
+    //! \brief Returns the texture atlas manifest filename of the given map data Lua file.
+    static std::string GetAtlasFilename(const std::string &map_filename);
+
+    //! \brief The number of tile columns and rows of the map.
+    uint16 num_tile_cols;
+    uint16 num_tile_rows;
+
+    //! \brief The tilesets used by the map, in the order of their tile indeces.
+    std::vector<MapTilesetData> tilesets;
+
+    //! \brief The map tile layers.
+    std::vector<MapLayerData> layers;
+
+    //! \brief The map collision grid, where each set bit is an unwalkable grid element.
+    vt_utils::BitGrid collision_grid;
+};
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_DATA_HEADER__
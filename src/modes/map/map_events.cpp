@@ -19,13 +19,17 @@
 #include "modes/map/map_events.h"
 
 #include "modes/map/map_mode.h"
+#include "modes/map/map_preloader.h"
 
 #include "modes/map/map_sprites.h"
 
 #include "modes/shop/shop.h"
 #include "modes/battle/battle.h"
 
+#include "engine/input.h"
+
 using namespace vt_audio;
+using namespace vt_input;
 using namespace vt_mode_manager;
 using namespace vt_script;
 using namespace vt_system;
@@ -153,34 +157,63 @@ MapTransitionEvent::MapTransitionEvent(const std::string &event_id,
     _transition_map_data_filename(data_filename),
     _transition_map_script_filename(script_filename),
     _transition_origin(coming_from),
-    _done(false)
+    _done(false),
+    _preloader(NULL)
 {}
 
 
 
+MapTransitionEvent::~MapTransitionEvent()
+{
+    delete _preloader;
+}
+
+
+
 void MapTransitionEvent::_Start()
 {
     MapMode::CurrentInstance()->PushState(STATE_SCENE);
 
     VideoManager->_StartTransitionFadeOut(Color::black, MAP_FADE_OUT_TIME);
     _done = false;
+
+    // Read the new map data and decode its tilesets while the screen fades out.
+    delete _preloader;
+    _preloader = new MapPreloader();
+    _preloader->Start(_transition_map_data_filename);
 }
 
 
 
 bool MapTransitionEvent::_Update()
 {
+    // The tilesets are uploaded to texture memory a bit at each frame during the fade.
+    // When recording or replaying the input, the map must be created at the same update step
+    // whatever the background jobs progress, so the preloading is finished once the fade is done.
+    bool deterministic = (InputManager->IsRecording() || InputManager->IsReplaying());
+    bool preloaded = (_preloader == NULL || _preloader->Update());
     if(VideoManager->IsFading())
         return false;
 
-    // Only load the map once the fade out is done, since the load time can
+    if(!preloaded) {
+        if(!deterministic)
+            return false;
+        _preloader->Finish();
+    }
+
+    // Only create the map once the fade out is done, since the remaining load time can
     // break the fade smoothness and visible duration.
     if(!_done) {
         vt_global::GlobalManager->SetPreviousLocation(_transition_origin);
-        MapMode *MM = new MapMode(_transition_map_data_filename, _transition_map_script_filename);
+        MapMode *MM = new MapMode(_transition_map_data_filename, _transition_map_script_filename,
+                                  _preloader ? _preloader->GetMapData() : NULL);
         ModeManager->Pop();
         ModeManager->Push(MM, false, true);
         _done = true;
+
+        // The new map now holds its own references to the preloaded tileset textures.
+        delete _preloader;
+        _preloader = NULL;
     }
     return true;
 }
@@ -296,6 +329,7 @@ void IfEvent::_Start()
     EventSupervisor* events = MapMode::CurrentInstance()->GetEventSupervisor();
 
     try {
+        ScriptCallScope call(_check_function);
         // We had a timer of 100ms her to avoid launching an event within an event
         // for the sake of the engine loop. That time is unnoticeable, anyway.
         if (ScriptCallFunction<bool>(_check_function)
@@ -346,6 +380,7 @@ void ScriptedEvent::_Start()
         return;
 
     try {
+        ScriptCallScope call(_start_function);
         ScriptCallFunction<void>(_start_function);
     } catch(const luabind::error &e) {
         PRINT_ERROR << "Error while loading ScriptedEvent start function" << std::endl;
@@ -363,6 +398,7 @@ bool ScriptedEvent::_Update()
         return true;
 
     try {
+        ScriptCallScope call(_update_function);
         return ScriptCallFunction<bool>(_update_function);
     } catch(const luabind::error &e) {
         PRINT_ERROR << "Error while loading ScriptedEvent update function" << std::endl;
@@ -463,8 +499,10 @@ ScriptedSpriteEvent::ScriptedSpriteEvent(const std::string &event_id, VirtualSpr
 void ScriptedSpriteEvent::_Start()
 {
     SpriteEvent::_Start();
-    if(_start_function.is_valid())
+    if(_start_function.is_valid()) {
+        ScriptCallScope call(_start_function);
         ScriptCallFunction<void>(_start_function, _sprite);
+    }
 }
 
 
@@ -472,6 +510,7 @@ bool ScriptedSpriteEvent::_Update()
 {
     bool finished = false;
     if(_update_function.is_valid()) {
+        ScriptCallScope call(_update_function);
         finished = ScriptCallFunction<bool>(_update_function, _sprite);
     } else {
         finished = true;
@@ -1397,6 +1436,8 @@ void EventSupervisor::TerminateAllEvents(VirtualSprite *sprite)
 
 void EventSupervisor::Update()
 {
+    ProfilerScope marker("EventSupervisor::Update");
+
     // Store the events that became active in the delayed event loop.
     std::vector<MapEvent *> events_to_start;
 
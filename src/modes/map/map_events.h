@@ -38,6 +38,7 @@ namespace private_map
 {
 
 class ContextZone;
+class MapPreloader;
 class MapSprite;
 class SpriteDialogue;
 class VirtualSprite;
@@ -367,13 +368,13 @@ public:
                        const std::string &script_filename,
                        const std::string &coming_from);
 
-    ~MapTransitionEvent() {};
+    ~MapTransitionEvent();
 
 protected:
-    //! \brief Begins the transition process by fading out the screen and music
+    //! \brief Begins the transition process by fading out the screen and music, and starts preloading the new map
     void _Start();
 
-    //! \brief Once the fading process completes, creates the new map mode to transition to
+    //! \brief Once the fading process and the preloading complete, creates the new map mode to transition to
     bool _Update();
 
     //! \brief The data and script filenames of the map to transition to
@@ -387,6 +388,9 @@ protected:
 
     //! \brief tells the update function to trigger the new map.
     bool _done;
+
+    //! \brief Loads the new map data and tilesets while the screen fades out.
+    MapPreloader *_preloader;
 }; // class MapTransitionEvent : public MapEvent
 
 
@@ -157,12 +157,16 @@ vt_video::StillImage Minimap::_CreateProcedurally()
         return vt_video::StillImage();
     }
 
-    for(uint32 row = 0; row < _grid_width; ++row)
+    // Walk the collision grid row by row, following its memory layout.
+    const vt_utils::BitGrid &collision_grid = map_object_supervisor->GetCollisionGrid();
+    for(uint32 col = 0; col < _grid_height; ++col)
     {
-        r.y = 0;
-        for(uint32 col = 0; col < _grid_height; ++col)
+        vt_utils::BitGrid::ConstRow collision_row = collision_grid[col];
+        r.x = 0;
+        for(uint32 row = 0; row < _grid_width; ++row)
         {
-            if(!map_object_supervisor->IsStaticCollision(row, col))
+            // The map collision is checked first, as it is far cheaper than the static objects one.
+            if(!collision_row[row] && !map_object_supervisor->IsStaticCollision(row, col))
             {
 
                 if(SDL_FillRect(temp_surface, &r, SDL_MapRGBA(temp_surface->format, 0x00, 0x00, 0x00, 0x00)))
@@ -173,9 +177,9 @@ vt_video::StillImage Minimap::_CreateProcedurally()
                 }
 
             }
-            r.y += _box_y_length;
+            r.x += _box_x_length;
         }
-        r.x += _box_x_length;
+        r.y += _box_y_length;
     }
 
     //flush the SDL surface. This forces any pending writes onto the surface to complete
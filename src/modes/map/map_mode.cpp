@@ -58,7 +58,8 @@ MapMode *MapMode::_current_instance = NULL;
 // ********** MapMode Public Class Methods
 // ****************************************************************************
 
-MapMode::MapMode(const std::string &data_filename, const std::string& script_filename) :
+MapMode::MapMode(const std::string &data_filename, const std::string& script_filename,
+                 const MapData *map_data) :
     GameMode(),
     _activated(false),
     _map_data_filename(data_filename),
@@ -127,7 +128,7 @@ MapMode::MapMode(const std::string &data_filename, const std::string& script_fil
 
     _camera_timer.Initialize(0, 1);
 
-    if(!_Load()) {
+    if(!_Load(map_data)) {
         BootMode *BM = new BootMode();
         ModeManager->PopAll();
         ModeManager->Push(BM);
@@ -262,8 +263,10 @@ void MapMode::Update()
     _dialogue_icon.Update();
 
     // Call the map script's update function
-    if(_update_function.is_valid())
+    if(_update_function.is_valid()) {
+        ScriptCallScope call(_update_function);
         ScriptCallFunction<void>(_update_function);
+    }
 
     // Update all animated tile images
     _tile_supervisor->Update();
@@ -330,7 +333,9 @@ void MapMode::Update()
     float x_pos = cam->GetXPosition();
     float y_pos = cam->GetYPosition();
     std::ostringstream coord_txt;
-    coord_txt << "Camera position: " << x_pos << ", " << y_pos;
+    coord_txt << "Camera position: " << x_pos << ", " << y_pos << std::endl
+              << "Tile draw calls: " << _tile_supervisor->GetNumDrawCalls()
+              << " (unbatched: " << _tile_supervisor->GetNumUnbatchedDrawCalls() << ")";
     _debug_camera_position.SetText(coord_txt.str());
 } // void MapMode::Update()
 
@@ -431,6 +436,7 @@ void MapMode::AddGroundObject(MapObject *obj)
         return;
     }
     _object_supervisor->_ground_objects.push_back(obj);
+    _object_supervisor->_ground_object_grid.AddObject(obj);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
 }
 
@@ -453,6 +459,7 @@ void MapMode::AddSkyObject(MapObject *obj)
         return;
     }
     _object_supervisor->_sky_objects.push_back(obj);
+    _object_supervisor->_sky_object_grid.AddObject(obj);
     _object_supervisor->_all_objects.insert(std::make_pair(obj->object_id, obj));
 }
 
@@ -574,45 +581,33 @@ float MapMode::GetScreenYCoordinate(float tile_position_y) const
 // ********** MapMode Private Class Methods
 // ****************************************************************************
 
-bool MapMode::_Load()
+bool MapMode::_Load(const MapData *map_data)
 {
-    // Map data
-    // Clear out all old map data if existing.
-    ScriptManager->DropGlobalTable("map_data");
-
-    // Open map script file and read in the basic map properties and tile definitions
-    if(!_map_script.OpenFile(_map_data_filename)) {
-        PRINT_ERROR << "Couldn't open map data file: "
-                    << _map_data_filename << std::endl;
-        return false;
-    }
-
-    if(!_map_script.OpenTable("map_data")) {
-        PRINT_ERROR << "Couldn't open table 'map_data' in: "
-                    << _map_data_filename << std::endl;
-        _map_script.CloseFile();
-        return false;
+    // Map data, read from its binary cache when up to date
+    MapData loaded_map_data;
+    if(map_data == NULL) {
+        if(!loaded_map_data.Load(_map_data_filename)) {
+            PRINT_ERROR << "Couldn't load map data file: "
+                        << _map_data_filename << std::endl;
+            return false;
+        }
+        map_data = &loaded_map_data;
     }
 
     // Loads the collision grid
-    if(!_object_supervisor->Load(_map_script)) {
+    if(!_object_supervisor->Load(*map_data)) {
         PRINT_ERROR << "Failed to load the collision grid from: "
             << _map_data_filename << std::endl;
-        _map_script.CloseFile();
         return false;
     }
 
     // Instruct the supervisor classes to perform their portion of the load operation
-    if(!_tile_supervisor->Load(_map_script)) {
+    if(!_tile_supervisor->Load(*map_data, MapData::GetAtlasFilename(_map_data_filename))) {
         PRINT_ERROR << "Failed to load the tile data from: "
             << _map_data_filename << std::endl;
-        _map_script.CloseFile();
         return false;
     }
 
-    _map_script.CloseAllTables();
-    _map_script.CloseFile(); // Free the map data file once everyhting is loaded
-
     // Map script
 
     _map_script_tablespace = ScriptEngine::GetTableSpace(_map_script_filename);
@@ -662,6 +657,13 @@ bool MapMode::_Load()
     else if (!_music_filename.empty())
         _audio_state = AUDIO_STATE_PLAYING; // Set the default music state to "playing".
 
+    // Start decoding the sounds declared by the map before its objects and events load them
+    if(_map_script.DoesTableExist("preload_sounds")) {
+        std::vector<std::string> preload_sounds;
+        _map_script.ReadStringVector("preload_sounds", preload_sounds);
+        AudioManager->PreloadSounds(preload_sounds);
+    }
+
     // Call the map script's custom load function and get a reference to all other script function pointers
     ScriptObject map_table(luabind::from_stack(_map_script.GetLuaState(), vt_script::private_script::STACK_TOP));
     ScriptObject function = map_table["Load"];
@@ -669,6 +671,7 @@ bool MapMode::_Load()
     bool loading_succeeded = true;
     if(function.is_valid()) {
         try {
+            ScriptCallScope call(function);
             ScriptCallFunction<void>(function, this);
         } catch(const luabind::error &e) {
             ScriptManager->HandleLuaError(e);
@@ -711,6 +714,8 @@ void MapMode::_CreateMinimap()
 
 void MapMode::_UpdateExplore()
 {
+    ProfilerScope marker("MapMode::_UpdateExplore");
+
     // First go to menu mode if the user requested it
     if(InputManager->MenuPress()) {
         MenuMode *MM = new MenuMode();
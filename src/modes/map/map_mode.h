@@ -56,6 +56,7 @@ namespace private_map
 class DialogueSupervisor;
 class EventSupervisor;
 class Light;
+class MapData;
 class MapObject;
 class MapZone;
 class Minimap;
@@ -108,7 +109,9 @@ class MapMode : public vt_mode_manager::GameMode
 public:
     //! \param data_filename The name of the Lua file that retains all data about the map to create
     //! \param script_filename The name of the Lua file that retains all data about script to load
-    MapMode(const std::string &data_filename, const std::string& script_filename);
+    //! \param map_data The map data when already loaded, or NULL to load it from data_filename
+    MapMode(const std::string &data_filename, const std::string& script_filename,
+            const private_map::MapData *map_data = NULL);
 
     ~MapMode();
 
@@ -505,8 +508,10 @@ private:
 
     // ----- Methods -----
 
-    //! \brief Loads all map data contained in the Lua file that defines the map
-    bool _Load();
+    /** \brief Loads all map data contained in the Lua file that defines the map
+    *** \param map_data The map data when already loaded, or NULL to load it from the map data file
+    **/
+    bool _Load(const private_map::MapData *map_data);
 
     /** Triggers the minimap creation either by trying to load the minimap file given.
     *** Or by creating a minimap procedurally.
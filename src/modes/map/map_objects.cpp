@@ -64,6 +64,18 @@ MapObject::MapObject() :
     _emote_time(0)
 {}
 
+MapObject::~MapObject()
+{
+    if(_grid_cells.grid)
+        _grid_cells.grid->RemoveObject(this);
+}
+
+void MapObject::_UpdateGridCells()
+{
+    if(_grid_cells.grid)
+        _grid_cells.grid->UpdateObject(this);
+}
+
 bool MapObject::ShouldDraw()
 {
     if(!visible)
@@ -188,6 +200,154 @@ bool MapObject::IsCollidingWith(MapObject* other_object)
     return collision_mask & other_object->collision_mask;
 }
 
+// ----------------------------------------------------------------------------
+// ---------- MapObjectGrid Class Functions
+// ----------------------------------------------------------------------------
+
+MapObjectGrid::MapObjectGrid() :
+    _num_cells_x(0),
+    _num_cells_y(0),
+    _query_id(0)
+{}
+
+MapObjectGrid::~MapObjectGrid()
+{
+    // Detach the objects still registered so they don't reference the grid anymore.
+    for(uint32 i = 0; i < _cells.size(); ++i) {
+        for(uint32 j = 0; j < _cells[i].size(); ++j)
+            _cells[i][j]->_grid_cells.grid = NULL;
+    }
+}
+
+void MapObjectGrid::Resize(uint16 num_grid_x_axis, uint16 num_grid_y_axis)
+{
+    for(uint32 i = 0; i < _cells.size(); ++i) {
+        for(uint32 j = 0; j < _cells[i].size(); ++j)
+            _cells[i][j]->_grid_cells.grid = NULL;
+    }
+    _cells.clear();
+
+    _num_cells_x = (num_grid_x_axis + OBJECT_GRID_CELL_LENGTH - 1) / OBJECT_GRID_CELL_LENGTH;
+    _num_cells_y = (num_grid_y_axis + OBJECT_GRID_CELL_LENGTH - 1) / OBJECT_GRID_CELL_LENGTH;
+    _cells.resize(_num_cells_x * _num_cells_y);
+}
+
+void MapObjectGrid::AddObject(MapObject *object)
+{
+    if(!object)
+        return;
+
+    if(_cells.empty()) {
+        IF_PRINT_WARNING(MAP_DEBUG) << "Object added before the map object grid was sized, id: "
+                                    << object->object_id << std::endl;
+        return;
+    }
+
+    if(object->_grid_cells.grid == this)
+        return;
+    // An object can only be registered in one grid.
+    if(object->_grid_cells.grid)
+        object->_grid_cells.grid->RemoveObject(object);
+
+    object->_grid_cells.grid = this;
+    _GetCells(object->GetCollisionRectangle(), object->_grid_cells.left, object->_grid_cells.right,
+              object->_grid_cells.top, object->_grid_cells.bottom);
+    _InsertInCells(object);
+}
+
+void MapObjectGrid::RemoveObject(MapObject *object)
+{
+    if(!object || object->_grid_cells.grid != this)
+        return;
+
+    _RemoveFromCells(object);
+    object->_grid_cells.grid = NULL;
+}
+
+void MapObjectGrid::UpdateObject(MapObject *object)
+{
+    if(!object || object->_grid_cells.grid != this)
+        return;
+
+    uint16 left, right, top, bottom;
+    _GetCells(object->GetCollisionRectangle(), left, right, top, bottom);
+
+    MapObjectGridCells &cells = object->_grid_cells;
+    // Most moves stay within the same buckets.
+    if(left == cells.left && right == cells.right && top == cells.top && bottom == cells.bottom)
+        return;
+
+    _RemoveFromCells(object);
+    cells.left = left;
+    cells.right = right;
+    cells.top = top;
+    cells.bottom = bottom;
+    _InsertInCells(object);
+}
+
+void MapObjectGrid::GetObjects(const MapRectangle &rect, std::vector<MapObject *> &objects)
+{
+    objects.clear();
+    if(_cells.empty())
+        return;
+
+    uint16 left, right, top, bottom;
+    _GetCells(rect, left, right, top, bottom);
+
+    ++_query_id;
+    for(uint32 y = top; y <= bottom; ++y) {
+        for(uint32 x = left; x <= right; ++x) {
+            std::vector<MapObject *> &cell = _cells[y * _num_cells_x + x];
+            for(uint32 i = 0; i < cell.size(); ++i) {
+                MapObject *object = cell[i];
+                if(object->_grid_cells.query_id == _query_id)
+                    continue;
+                object->_grid_cells.query_id = _query_id;
+                objects.push_back(object);
+            }
+        }
+    }
+}
+
+void MapObjectGrid::_GetCells(const MapRectangle &rect, uint16 &left, uint16 &right, uint16 &top, uint16 &bottom) const
+{
+    const float cell_length = static_cast<float>(OBJECT_GRID_CELL_LENGTH);
+    const float max_x = static_cast<float>(_num_cells_x - 1);
+    const float max_y = static_cast<float>(_num_cells_y - 1);
+
+    left = static_cast<uint16>(std::max(0.0f, std::min(max_x, rect.left / cell_length)));
+    right = static_cast<uint16>(std::max(0.0f, std::min(max_x, rect.right / cell_length)));
+    top = static_cast<uint16>(std::max(0.0f, std::min(max_y, rect.top / cell_length)));
+    bottom = static_cast<uint16>(std::max(0.0f, std::min(max_y, rect.bottom / cell_length)));
+}
+
+void MapObjectGrid::_InsertInCells(MapObject *object)
+{
+    const MapObjectGridCells &cells = object->_grid_cells;
+    for(uint32 y = cells.top; y <= cells.bottom; ++y) {
+        for(uint32 x = cells.left; x <= cells.right; ++x)
+            _cells[y * _num_cells_x + x].push_back(object);
+    }
+}
+
+void MapObjectGrid::_RemoveFromCells(MapObject *object)
+{
+    const MapObjectGridCells &cells = object->_grid_cells;
+    for(uint32 y = cells.top; y <= cells.bottom; ++y) {
+        for(uint32 x = cells.left; x <= cells.right; ++x) {
+            std::vector<MapObject *> &cell = _cells[y * _num_cells_x + x];
+            // The order within a bucket doesn't matter, so swap with the last entry.
+            for(uint32 i = 0; i < cell.size(); ++i) {
+                if(cell[i] == object) {
+                    cell[i] = cell.back();
+                    cell.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+
 // ----------------------------------------------------------------------------
 // ---------- PhysicalObject Class Functions
 // ----------------------------------------------------------------------------
@@ -1023,22 +1183,20 @@ void ObjectSupervisor::SortObjects()
 
 
 
-bool ObjectSupervisor::Load(ReadScriptDescriptor &map_file)
+bool ObjectSupervisor::Load(const MapData &map_data)
 {
-    if(!map_file.DoesTableExist("map_grid")) {
-        PRINT_ERROR << "No map grid found in map file: " << map_file.GetFilename() << std::endl;
+    if(map_data.collision_grid.IsEmpty()) {
+        PRINT_ERROR << "No map grid found in the map data." << std::endl;
         return false;
     }
 
-    // Construct the collision grid
-    map_file.OpenTable("map_grid");
-    _num_grid_y_axis = map_file.GetTableSize();
-    for(uint16 y = 0; y < _num_grid_y_axis; ++y) {
-        _collision_grid.push_back(std::vector<uint32>());
-        map_file.ReadUIntVector(y, _collision_grid.back());
-    }
-    map_file.CloseTable();
-    _num_grid_x_axis = _collision_grid[0].size();
+    _collision_grid = map_data.collision_grid;
+    _num_grid_x_axis = _collision_grid.GetWidth();
+    _num_grid_y_axis = _collision_grid.GetHeight();
+
+    // The object grids must be ready before any map object is added.
+    _ground_object_grid.Resize(_num_grid_x_axis, _num_grid_y_axis);
+    _sky_object_grid.Resize(_num_grid_x_axis, _num_grid_y_axis);
     return true;
 }
 
@@ -1046,6 +1204,8 @@ bool ObjectSupervisor::Load(ReadScriptDescriptor &map_file)
 
 void ObjectSupervisor::Update()
 {
+    ProfilerScope marker("ObjectSupervisor::Update");
+
     for(uint32 i = 0; i < _flat_ground_objects.size(); ++i)
         _flat_ground_objects[i]->Update();
     for(uint32 i = 0; i < _ground_objects.size(); ++i)
@@ -1192,21 +1352,16 @@ MapObject *ObjectSupervisor::FindNearestInteractionObject(const VirtualSprite *s
         return NULL;
     }
 
-    // Go through all objects and determine which (if any) lie within the search area
+    // Go through the objects near the search area and determine which (if any) lie within it
 
     // A vector to hold objects which are inside the search area (either partially or fully)
     std::vector<MapObject *> valid_objects;
-    // A pointer to the vector of objects to search
-    std::vector<MapObject *>* search_vector = NULL;
 
     // Only search the object layer that the sprite resides on.
     // Note that we do not consider searching the pass layer.
-    if(sprite->sky_object)
-        search_vector = &_sky_objects;
-    else
-        search_vector = &_ground_objects;
+    GetObjectsNear(search_area, sprite->sky_object, _nearby_objects);
 
-    for(std::vector<MapObject *>::iterator it = (*search_vector).begin(); it != (*search_vector).end(); ++it) {
+    for(std::vector<MapObject *>::iterator it = _nearby_objects.begin(); it != _nearby_objects.end(); ++it) {
         if(*it == sprite)  // Don't allow the sprite itself to be considered in the search
             continue;
 
@@ -1238,7 +1393,7 @@ MapObject *ObjectSupervisor::FindNearestInteractionObject(const VirtualSprite *s
         MapRectangle object_rect = (*it)->GetCollisionRectangle();
         if(MapRectangle::CheckIntersection(object_rect, search_area) == true)
             valid_objects.push_back(*it);
-    } // for (std::map<MapObject*>::iterator i = _all_objects.begin(); i != _all_objects.end(); i++)
+    } // for (std::vector<MapObject*>::iterator it = _nearby_objects.begin(); it != _nearby_objects.end(); ++it)
 
     if(valid_objects.empty()) {
         // If no sprite was here, try searching a save point.
@@ -1327,6 +1482,8 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
                                                  float x_pos, float y_pos,
                                                  MapObject **collision_object_ptr)
 {
+    ScopedTiming timing(SYSTEM_TIMING_COLLISION);
+
     // If the sprite has this property set it can not collide
     if(!object)
         return NO_COLLISION;
@@ -1351,20 +1508,20 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
         // Determine if the object's collision rectangle overlaps any unwalkable tiles
         // Note that because the sprite's collision rectangle was previously determined to be within the map bounds,
         // the map grid tile indeces referenced in this loop are all valid entries and do not need to be checked for out-of-bounds conditions
+        uint32 x_first = static_cast<uint32>(sprite_rect.left);
+        uint32 x_last = static_cast<uint32>(sprite_rect.right);
         for(uint32 y = static_cast<uint32>(sprite_rect.top); y <= static_cast<uint32>(sprite_rect.bottom); ++y) {
-            for(uint32 x = static_cast<uint32>(sprite_rect.left); x <= static_cast<uint32>(sprite_rect.right); ++x) {
-                // Checks the collision grid at the row-column at the object's current context
-                if(_collision_grid[y][x] > 0)
-                    return WALL_COLLISION;
-            }
+            // Checks the whole collision grid row span covered by the object at once
+            if(_collision_grid.IsAnySet(y, x_first, x_last))
+                return WALL_COLLISION;
         }
     }
 
-    std::vector<MapObject *>* objects = object->sky_object ?
-                                        &_sky_objects : &_ground_objects;
+    // Only check the objects registered near the collision rectangle
+    GetObjectsNear(sprite_rect, object->sky_object, _nearby_objects);
 
     std::vector<vt_map::private_map::MapObject *>::const_iterator it, it_end;
-    for(it = objects->begin(), it_end = objects->end(); it != it_end; ++it) {
+    for(it = _nearby_objects.begin(), it_end = _nearby_objects.end(); it != it_end; ++it) {
         MapObject *collision_object = *it;
         // Check if the object exists and has the no_collision property enabled
         if(!collision_object || collision_object->collision_mask == NO_COLLISION)
@@ -1395,17 +1552,107 @@ COLLISION_TYPE ObjectSupervisor::DetectCollision(MapObject* object,
 } // bool ObjectSupervisor::DetectCollision(VirtualSprite* sprite, float x, float y, MapObject** collision_object_ptr)
 
 
+void ObjectSupervisor::_ResetPathFindingPool()
+{
+    uint32 num_nodes = static_cast<uint32>(_num_grid_x_axis) * static_cast<uint32>(_num_grid_y_axis);
+
+    if(_path_nodes.size() != num_nodes) {
+        _path_nodes.resize(num_nodes);
+        _path_heap_positions.resize(num_nodes);
+        _path_open_heap.reserve(num_nodes);
+    }
+
+    // Only the bitsets need to be cleared, the node data is overwritten when a node is opened.
+    _path_open_nodes.assign(num_nodes, false);
+    _path_closed_nodes.assign(num_nodes, false);
+    _path_open_heap.clear();
+}
+
+void ObjectSupervisor::_PushOpenPathNode(uint32 node_index)
+{
+    _path_open_nodes[node_index] = true;
+    _path_open_heap.push_back(node_index);
+    _path_heap_positions[node_index] = _path_open_heap.size() - 1;
+    _SiftUpOpenPathNode(_path_open_heap.size() - 1);
+}
+
+uint32 ObjectSupervisor::_PopOpenPathNode()
+{
+    uint32 best_index = _path_open_heap.front();
+    _path_open_nodes[best_index] = false;
+
+    // Move the last heap entry at the top and restore the heap order
+    _path_open_heap.front() = _path_open_heap.back();
+    _path_heap_positions[_path_open_heap.front()] = 0;
+    _path_open_heap.pop_back();
+    if(!_path_open_heap.empty())
+        _SiftDownOpenPathNode(0);
+
+    return best_index;
+}
+
+void ObjectSupervisor::_SiftUpOpenPathNode(uint32 heap_position)
+{
+    uint32 node_index = _path_open_heap[heap_position];
+    const PathNode &node = _path_nodes[node_index];
+
+    while(heap_position > 0) {
+        uint32 parent_position = (heap_position - 1) / 2;
+        uint32 parent_index = _path_open_heap[parent_position];
+        if(!node.IsBetterThan(_path_nodes[parent_index]))
+            break;
+
+        _path_open_heap[heap_position] = parent_index;
+        _path_heap_positions[parent_index] = heap_position;
+        heap_position = parent_position;
+    }
+
+    _path_open_heap[heap_position] = node_index;
+    _path_heap_positions[node_index] = heap_position;
+}
+
+void ObjectSupervisor::_SiftDownOpenPathNode(uint32 heap_position)
+{
+    uint32 heap_size = _path_open_heap.size();
+    uint32 node_index = _path_open_heap[heap_position];
+    const PathNode &node = _path_nodes[node_index];
+
+    while(true) {
+        uint32 child_position = heap_position * 2 + 1;
+        if(child_position >= heap_size)
+            break;
+
+        // Pick the best of the two children
+        if(child_position + 1 < heap_size
+                && _path_nodes[_path_open_heap[child_position + 1]].IsBetterThan(_path_nodes[_path_open_heap[child_position]]))
+            ++child_position;
+
+        uint32 child_index = _path_open_heap[child_position];
+        if(!_path_nodes[child_index].IsBetterThan(node))
+            break;
+
+        _path_open_heap[heap_position] = child_index;
+        _path_heap_positions[child_index] = heap_position;
+        heap_position = child_position;
+    }
+
+    _path_open_heap[heap_position] = node_index;
+    _path_heap_positions[node_index] = heap_position;
+}
+
 Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destination, uint32 max_cost)
 {
+    ScopedTiming timing(SYSTEM_TIMING_PATH_FINDING);
+
     // NOTE: Refer to the implementation of the A* algorithm to understand
     // what all these lists and score values are for.
-    static const uint32 basic_gcost = 10;
+    static const int32 basic_gcost = 10;
 
     // NOTE(bis): On the outer scope, we'll use float based positions,
     // but we still use integer positions for path finding.
     Path path;
 
-    if(!MapMode::CurrentInstance()->GetObjectSupervisor()->IsWithinMapBounds(sprite)) {
+    if(!IsWithinMapBounds(sprite)) {
         IF_PRINT_WARNING(MAP_DEBUG) << "Sprite position is invalid" << std::endl;
         return path;
     }
@@ -1414,7 +1661,7 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
     if(DetectCollision(sprite, destination.x, destination.y) == WALL_COLLISION)
         return path;
 
-    if(!MapMode::CurrentInstance()->GetObjectSupervisor()->IsWithinMapBounds(destination.x, destination.y)) {
+    if(!IsWithinMapBounds(destination.x, destination.y)) {
         IF_PRINT_WARNING(MAP_DEBUG) << "Invalid destination coordinates" << std::endl;
         return path;
     }
@@ -1431,66 +1678,62 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
         return path;
     }
 
-    std::vector<PathNode> open_list;
-    std::vector<PathNode> closed_list;
+    _ResetPathFindingPool();
 
-    // The current "best node"
-    PathNode best_node;
-    // Used to hold the eight adjacent nodes
-    PathNode nodes[8];
+    const uint32 source_index = source_node.tile_y * _num_grid_x_axis + source_node.tile_x;
+    const uint32 dest_index = dest.tile_y * _num_grid_x_axis + dest.tile_x;
+
+    // The 8 adjacent node offsets: lateral ones first, then diagonal ones
+    static const int16 neighbour_x[8] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+    static const int16 neighbour_y[8] = { 0, 0, -1, 1, -1, 1, -1, 1 };
 
     // Temporary delta variables used in calculation of a node's heuristic (h score)
-    uint32 x_delta, y_delta;
+    int32 x_delta, y_delta;
     // The number to add to a node's g_score, depending on whether it is a lateral or diagonal movement
-    int16 g_add;
+    int32 g_add;
 
-    open_list.push_back(source_node);
+    _path_nodes[source_index] = source_node;
+    _PushOpenPathNode(source_index);
 
     // We will try to keep the original offset all along.
     float offset_x = GetFloatFraction(destination.x);
     float offset_y = GetFloatFraction(destination.y);
 
-    while(open_list.empty() == false) {
-        sort(open_list.begin(), open_list.end());
-        best_node = open_list.back();
-        open_list.pop_back();
-        closed_list.push_back(best_node);
+    bool destination_reached = false;
+
+    while(!_path_open_heap.empty()) {
+        uint32 best_index = _PopOpenPathNode();
+        _path_closed_nodes[best_index] = true;
 
         // Check if destination has been reached, and break out of the loop if so
-        if(best_node == dest)
+        if(best_index == dest_index) {
+            destination_reached = true;
             break;
+        }
 
-        // Setup the coordinates of the 8 adjacent nodes to the best node
-        nodes[0].tile_x = best_node.tile_x - 1;
-        nodes[0].tile_y = best_node.tile_y;
-        nodes[1].tile_x = best_node.tile_x + 1;
-        nodes[1].tile_y = best_node.tile_y;
-        nodes[2].tile_x = best_node.tile_x;
-        nodes[2].tile_y = best_node.tile_y - 1;
-        nodes[3].tile_x = best_node.tile_x;
-        nodes[3].tile_y = best_node.tile_y + 1;
-        nodes[4].tile_x = best_node.tile_x - 1;
-        nodes[4].tile_y = best_node.tile_y - 1;
-        nodes[5].tile_x = best_node.tile_x - 1;
-        nodes[5].tile_y = best_node.tile_y + 1;
-        nodes[6].tile_x = best_node.tile_x + 1;
-        nodes[6].tile_y = best_node.tile_y - 1;
-        nodes[7].tile_x = best_node.tile_x + 1;
-        nodes[7].tile_y = best_node.tile_y + 1;
+        // Copy the node, as the node pool entries may be updated below.
+        const PathNode best_node = _path_nodes[best_index];
 
         // Check the eight adjacent nodes
         for(uint8 i = 0; i < 8; ++i) {
+            int16 tile_x = best_node.tile_x + neighbour_x[i];
+            int16 tile_y = best_node.tile_y + neighbour_y[i];
+
             // ---------- (A): Check if all tiles are walkable
             // Don't use 0.0f here for both since errors at the border between
             // two positions may occure, especially when running.
             COLLISION_TYPE collision_type = DetectCollision(sprite,
-                                            ((float)nodes[i].tile_x) + offset_x,
-                                            ((float)nodes[i].tile_y) + offset_y);
+                                            ((float)tile_x) + offset_x,
+                                            ((float)tile_y) + offset_y);
 
             // Can't go through walls.
             if(collision_type == WALL_COLLISION)
                 continue;
 
+            // Sprites without wall collision may still end up on the map border.
+            if(tile_x < 0 || tile_y < 0 || tile_x >= _num_grid_x_axis || tile_y >= _num_grid_y_axis)
+                continue;
+
             // ---------- (B): If this point has been reached, the node is valid for the sprite to move to
             // If this is a lateral adjacent node, g_score is +10, otherwise diagonal adjacent node is +14
             if(i < 4)
@@ -1510,42 +1753,48 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
                 return path;
 
             // ---------- (C): Check if the node is already in the closed list
-            if(find(closed_list.begin(), closed_list.end(), nodes[i]) != closed_list.end())
+            uint32 node_index = tile_y * _num_grid_x_axis + tile_x;
+            if(_path_closed_nodes[node_index])
                 continue;
 
-            // Set the node's parent and calculate its g_score
-            nodes[i].parent_x = best_node.tile_x;
-            nodes[i].parent_y = best_node.tile_y;
-            nodes[i].g_score = best_node.g_score + g_add;
+            int32 g_score = best_node.g_score + g_add;
 
             // ---------- (D): Check to see if the node is already on the open list and update it if necessary
-            std::vector<PathNode>::iterator iter = std::find(open_list.begin(), open_list.end(), nodes[i]);
-            if(iter != open_list.end()) {
+            if(_path_open_nodes[node_index]) {
+                PathNode &open_node = _path_nodes[node_index];
                 // If its G is higher, it means that the path we are on is better, so switch the parent
-                if(iter->g_score > nodes[i].g_score) {
-                    iter->g_score = nodes[i].g_score;
-                    iter->f_score = nodes[i].g_score + iter->h_score;
-                    iter->parent_x = nodes[i].parent_x;
-                    iter->parent_y = nodes[i].parent_y;
+                if(open_node.g_score > g_score) {
+                    open_node.g_score = g_score;
+                    open_node.f_score = g_score + open_node.h_score;
+                    open_node.parent_x = best_node.tile_x;
+                    open_node.parent_y = best_node.tile_y;
+                    _SiftUpOpenPathNode(_path_heap_positions[node_index]);
                 }
             }
             // ---------- (E): Add the new node to the open list
             else {
+                PathNode &new_node = _path_nodes[node_index];
+                new_node.tile_x = tile_x;
+                new_node.tile_y = tile_y;
+                new_node.parent_x = best_node.tile_x;
+                new_node.parent_y = best_node.tile_y;
+                new_node.g_score = g_score;
+
                 // Calculate the H and F score of the new node (the heuristic used is diagonal)
-                x_delta = abs(dest.tile_x - nodes[i].tile_x);
-                y_delta = abs(dest.tile_y - nodes[i].tile_y);
+                x_delta = abs(dest.tile_x - tile_x);
+                y_delta = abs(dest.tile_y - tile_y);
                 if(x_delta > y_delta)
-                    nodes[i].h_score = 14 * y_delta + 10 * (x_delta - y_delta);
+                    new_node.h_score = 14 * y_delta + 10 * (x_delta - y_delta);
                 else
-                    nodes[i].h_score = 14 * x_delta + 10 * (y_delta - x_delta);
+                    new_node.h_score = 14 * x_delta + 10 * (y_delta - x_delta);
 
-                nodes[i].f_score = nodes[i].g_score + nodes[i].h_score;
-                open_list.push_back(nodes[i]);
+                new_node.f_score = new_node.g_score + new_node.h_score;
+                _PushOpenPathNode(node_index);
             }
         } // for (uint8 i = 0; i < 8; ++i)
-    } // while (open_list.empty() == false)
+    } // while (!_path_open_heap.empty())
 
-    if(open_list.empty() == true) {
+    if(!destination_reached) {
         IF_PRINT_WARNING(MAP_DEBUG) << "could not find path to destination" << std::endl;
         return path;
     }
@@ -1553,20 +1802,15 @@ Path ObjectSupervisor::FindPath(VirtualSprite *sprite, const MapPosition &destin
     // Add the destination node to the vector.
     path.push_back(destination);
 
-    // Retain the last node parent, and remove it from the closed list
-    int16 parent_x = best_node.parent_x;
-    int16 parent_y = best_node.parent_y;
-    closed_list.pop_back();
+    // Go backwards following the parent nodes to construct the path, without the source node.
+    const PathNode *node = &_path_nodes[dest_index];
+    uint32 parent_index = node->parent_y * _num_grid_x_axis + node->parent_x;
+    while(parent_index != source_index) {
+        node = &_path_nodes[parent_index];
+        MapPosition next_pos(((float)node->tile_x) + offset_x, ((float)node->tile_y) + offset_y);
+        path.push_back(next_pos);
 
-    // Go backwards through the closed list following the parent nodes to construct the path
-    for(std::vector<PathNode>::iterator iter = closed_list.end() - 1; iter != closed_list.begin(); --iter) {
-        if(iter->tile_y == parent_y && iter->tile_x == parent_x) {
-            MapPosition next_pos(((float)iter->tile_x) + offset_x, ((float)iter->tile_y) + offset_y);
-            path.push_back(next_pos);
-
-            parent_x = iter->parent_x;
-            parent_y = iter->parent_y;
-        }
+        parent_index = node->parent_y * _num_grid_x_axis + node->parent_x;
     }
     std::reverse(path.begin(), path.end());
 
@@ -1615,11 +1859,12 @@ void ObjectSupervisor::DrawCollisionArea(const MapFrame *frame)
 
     for(uint32 y = static_cast<uint32>(frame->tile_y_start * 2);
             y < static_cast<uint32>((frame->tile_y_start + frame->num_draw_y_axis) * 2); ++y) {
+        BitGrid::ConstRow collision_row = _collision_grid[y];
         for(uint32 x = static_cast<uint32>(frame->tile_x_start * 2);
                 x < static_cast<uint32>((frame->tile_x_start + frame->num_draw_x_axis) * 2); ++x) {
 
             // Draw the collision rectangle
-            if(_collision_grid[y][x] > 0)
+            if(collision_row[x])
                 VideoManager->DrawRectangle(1.0f, 1.0f, Color(1.0f, 0.0f, 0.0f, 0.6f));
 
             VideoManager->MoveRelative(1.0f, 0.0f);
@@ -1637,8 +1882,10 @@ bool ObjectSupervisor::IsStaticCollision(float x, float y)
     if (IsMapCollision(static_cast<uint32>(x), static_cast<uint32>(y)))
         return true;
 
+    GetObjectsNear(MapRectangle(x, x, y, y), false, _nearby_objects);
+
     std::vector<vt_map::private_map::MapObject *>::const_iterator it, it_end;
-    for(it = _ground_objects.begin(), it_end = _ground_objects.end(); it != it_end; ++it) {
+    for(it = _nearby_objects.begin(), it_end = _nearby_objects.end(); it != it_end; ++it) {
         MapObject *collision_object = *it;
         // Check if the object exists and has the no_collision property enabled
         if(!collision_object || collision_object->collision_mask == NO_COLLISION)
@@ -19,6 +19,9 @@
 #define __MAP_OBJECTS_HEADER__
 
 #include "modes/map/map_treasure.h"
+#include "modes/map/map_data.h"
+
+#include "utils/utils_grid.h"
 
 namespace vt_script {
 class ReadScriptDescriptor;
@@ -41,10 +44,43 @@ namespace private_map
 {
 
 class ContextZone;
+class MapObjectGrid;
 class MapSprite;
 class MapZone;
 class VirtualSprite;
 
+/** ****************************************************************************
+*** \brief Keeps track of where a map object is registered in a map object grid.
+***
+*** The cells are given in object grid coordinates, not in collision grid ones.
+*** \note Copying a map object never copies its registration, as the copy
+*** has to be added to the map on its own.
+*** ***************************************************************************/
+class MapObjectGridCells
+{
+public:
+    MapObjectGridCells() :
+        grid(NULL), left(0), right(0), top(0), bottom(0), query_id(0)
+    {}
+
+    MapObjectGridCells(const MapObjectGridCells &) :
+        grid(NULL), left(0), right(0), top(0), bottom(0), query_id(0)
+    {}
+
+    MapObjectGridCells &operator=(const MapObjectGridCells &) {
+        return *this;
+    }
+
+    //! \brief The grid the object is registered in, or NULL if none.
+    MapObjectGrid *grid;
+
+    //! \brief The range of grid cells the object is registered in.
+    uint16 left, right, top, bottom;
+
+    //! \brief The last grid query that returned the object, used to avoid returning it twice.
+    uint32 query_id;
+};
+
 /** ****************************************************************************
 *** \brief Abstract class that represents objects on a map
 ***
@@ -80,8 +116,7 @@ class MapObject
 public:
     MapObject();
 
-    virtual ~MapObject()
-    {}
+    virtual ~MapObject();
 
     /** \brief An identification number for the object as it is represented in the map file.
     *** Player sprites are assigned object IDs from 5000 and above. Technically this means that
@@ -234,14 +269,17 @@ public:
     void SetPosition(float x, float y) {
         position.x = x;
         position.y = y;
+        _UpdateGridCells();
     }
 
     void SetXPosition(float x) {
         position.x = x;
+        _UpdateGridCells();
     }
 
     void SetYPosition(float y) {
         position.y = y;
+        _UpdateGridCells();
     }
 
     void SetImgHalfWidth(float width) {
@@ -254,10 +292,12 @@ public:
 
     void SetCollHalfWidth(float collision) {
         coll_half_width = collision;
+        _UpdateGridCells();
     }
 
     void SetCollHeight(float collision) {
         coll_height = collision;
+        _UpdateGridCells();
     }
 
     void SetUpdatable(bool update) {
@@ -341,9 +381,14 @@ public:
     //@}
 
 protected:
+    friend class MapObjectGrid;
+
     //! \brief This is used to identify the type of map object for inheriting classes.
     MAP_OBJECT_TYPE _object_type;
 
+    //! \brief The object grid cells the object is registered in, used for fast collision queries.
+    MapObjectGridCells _grid_cells;
+
     //! \brief the emote animation to play
     vt_video::AnimatedImage *_emote_animation;
 
@@ -359,9 +404,70 @@ protected:
 
     //! \brief Takes care of drawing the emote animation.
     void _DrawEmote();
+
+    //! \brief Moves the object within its object grid, if any, after a position or size change.
+    void _UpdateGridCells();
 }; // class MapObject
 
 
+/** ****************************************************************************
+*** \brief A uniform spatial grid of map object buckets used for collision queries.
+***
+*** Each bucket covers a square of OBJECT_GRID_CELL_LENGTH collision grid elements,
+*** and references every object whose collision rectangle overlaps it.
+*** Objects are moved between buckets only when their collision rectangle
+*** starts overlapping a different set of buckets, so that queries only have to
+*** consider the objects near a given area instead of every object of the layer.
+*** ***************************************************************************/
+class MapObjectGrid
+{
+public:
+    MapObjectGrid();
+
+    ~MapObjectGrid();
+
+    /** \brief Sets the grid size, dropping every registered object.
+    *** \param num_grid_x_axis The number of collision grid columns of the map.
+    *** \param num_grid_y_axis The number of collision grid rows of the map.
+    **/
+    void Resize(uint16 num_grid_x_axis, uint16 num_grid_y_axis);
+
+    //! \brief Registers an object in the buckets overlapped by its collision rectangle.
+    void AddObject(MapObject *object);
+
+    //! \brief Unregisters an object from the grid.
+    void RemoveObject(MapObject *object);
+
+    //! \brief Moves the object into other buckets if its collision rectangle changed of buckets.
+    void UpdateObject(MapObject *object);
+
+    /** \brief Gets every object registered in the buckets overlapped by the given rectangle.
+    *** \param rect The map area to query.
+    *** \param objects The vector to fill. It is cleared first, and each object is only added once.
+    *** \note The objects returned are only potential candidates, their collision rectangle
+    *** still has to be checked against the area.
+    **/
+    void GetObjects(const MapRectangle &rect, std::vector<MapObject *> &objects);
+
+private:
+    //! \brief Computes the buckets overlapped by the rectangle, clamped to the grid bounds.
+    void _GetCells(const MapRectangle &rect, uint16 &left, uint16 &right, uint16 &top, uint16 &bottom) const;
+
+    //! \brief Adds or removes the object in the given range of buckets.
+    void _InsertInCells(MapObject *object);
+    void _RemoveFromCells(MapObject *object);
+
+    //! \brief The number of buckets on each axis.
+    uint16 _num_cells_x, _num_cells_y;
+
+    //! \brief The buckets, stored row by row.
+    std::vector<std::vector<MapObject *> > _cells;
+
+    //! \brief Incremented at each query, see MapObjectGridCells::query_id.
+    uint32 _query_id;
+}; // class MapObjectGrid
+
+
 /** \brief This is a predicate used to sort MapObjects in correct draw order
 *** \return True if the MapObject pointed by a should be drawn behind MapObject pointed by b
 *** \note A simple '<' operator cannot be used with the sorting algorithm because it is sorting pointers.
@@ -887,15 +993,11 @@ public:
     //! \brief Sorts objects on all three layers according to their draw order
     void SortObjects();
 
-    /** \brief Loads the collision grid data and saved state of all map objects
-    *** \param map_file A reference to the open map script file
+    /** \brief Loads the collision grid data
+    *** \param map_data The map data, already loaded from the map data file or its cache
     *** \return Whether the collision data loading was successful.
-    ***
-    *** The file must be open prior to making this call and additionally must
-    *** be at the highest level scope (i.e., there are no actively open tables
-    *** in the script descriptor object).
     **/
-    bool Load(vt_script::ReadScriptDescriptor &map_file);
+    bool Load(const MapData &map_data);
 
     //! \brief Updates the state of all map zones and objects
     void Update();
@@ -980,8 +1082,9 @@ public:
     *** If this param is equal to 0, there is no limitation.
     ***
     *** This algorithm uses the A* algorithm to find a path from a source to a destination.
-    *** This function ignores the position of all other objects and only concerns itself with
-    *** which map grid elements are walkable.
+    *** The open list is an indexed binary heap and the open/closed states are kept
+    *** in per-grid-element bitsets, so that each node expansion is O(log n).
+    *** Other sprites are not blocking, but add some cost to the nodes they occupy.
     ***
     *** \note If an error is detected or a path could not be found, the function will empty the path vector before returning
     **/
@@ -1044,12 +1147,28 @@ public:
     //! \brief checks if the location on the grid has a simple map collision. This is different from
     //! IsStaticCollision, in that it DOES NOT check static objects, but only the collision value for the map
     bool IsMapCollision(uint32 x, uint32 y)
-    { return (_collision_grid[y][x] > 0); }
+    { return _collision_grid.Get(x, y); }
+
+    //! \brief Returns the map collision grid, where each set bit is an unwalkable grid element.
+    const vt_utils::BitGrid &GetCollisionGrid() const
+    { return _collision_grid; }
 
     //! returns a const reference to the ground objects in
     const std::vector<MapObject *>& GetGroundObjects() const
     { return _ground_objects; }
 
+    /** \brief Gets the ground or sky objects whose collision rectangle may intersect the given area.
+    *** \param rect The map area to query.
+    *** \param sky_objects Whether to query the sky object layer instead of the ground one.
+    *** \param objects The vector to fill, cleared first.
+    **/
+    void GetObjectsNear(const MapRectangle &rect, bool sky_objects, std::vector<MapObject *> &objects) {
+        if(sky_objects)
+            _sky_object_grid.GetObjects(rect, objects);
+        else
+            _ground_object_grid.GetObjects(rect, objects);
+    }
+
 private:
     //! \brief Returns the nearest save point. Used by FindNearestObject.
     private_map::MapObject *_FindNearestSavePoint(const VirtualSprite *sprite);
@@ -1063,6 +1182,23 @@ private:
     //! \brief Debug: Draws the map zones in orange
     void _DrawMapZones();
 
+    /** \brief Resizes and resets the path finding node pool for a new search.
+    *** The pool memory is only reallocated when the collision grid size changes.
+    **/
+    void _ResetPathFindingPool();
+
+    //! \brief Adds the given grid element index to the open list heap.
+    void _PushOpenPathNode(uint32 node_index);
+
+    //! \brief Removes and returns the grid element index of the best node in the open list heap.
+    uint32 _PopOpenPathNode();
+
+    //! \brief Moves an open list heap entry up until the heap order is restored.
+    void _SiftUpOpenPathNode(uint32 heap_position);
+
+    //! \brief Moves an open list heap entry down until the heap order is restored.
+    void _SiftDownOpenPathNode(uint32 heap_position);
+
     /** \brief The number of rows and columns in the collision gride
     *** The number of collision grid rows and columns is always equal to twice
     *** that of the number of rows and columns of tiles (stored in the TileManager).
@@ -1087,13 +1223,40 @@ private:
     **/
     private_map::MapSprite *_visible_party_member;
 
-    /** \brief A 2D vector indicating which grid element on the map sprites may be occupied by objects.
-    *** Each bit of each element in this grid corresponds to a context. So all together this entire grid
-    *** stores the collision information for all 32 possible map contexts.
+    /** \brief A 2D bit grid indicating which grid element on the map sprites may not be occupied by objects.
     *** \Note A position in this member is stored like this:
     *** _collision_grid[y][x]
     **/
-    std::vector<std::vector<uint32> > _collision_grid;
+    vt_utils::BitGrid _collision_grid;
+
+    //! \brief Spatial indices of the ground and sky objects, used by the collision queries.
+    MapObjectGrid _ground_object_grid;
+    MapObjectGrid _sky_object_grid;
+
+    //! \brief Reused by the object grid queries to avoid allocations.
+    std::vector<MapObject *> _nearby_objects;
+
+    /** \name Path finding node pool
+    *** Those containers are indexed by grid element (y * _num_grid_x_axis + x)
+    *** and kept alive between FindPath() calls so that no memory allocation
+    *** happens when several sprites are requesting paths in the same frame.
+    **/
+    //@{
+    //! \brief The A* node data of each grid element. Only valid when the element is open or closed.
+    std::vector<PathNode> _path_nodes;
+
+    //! \brief The open list, as a binary heap of grid element indices ordered by f_score.
+    std::vector<uint32> _path_open_heap;
+
+    //! \brief The position of each open grid element in the open list heap.
+    std::vector<uint32> _path_heap_positions;
+
+    //! \brief Tells whether a grid element is currently in the open list.
+    std::vector<bool> _path_open_nodes;
+
+    //! \brief Tells whether a grid element has already been expanded.
+    std::vector<bool> _path_closed_nodes;
+    //@}
 
     /** \brief A map containing pointers to all of the sprites on a map.
     *** This map does not include a pointer to the _virtual_focus object. The
@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_preloader.cpp
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Source file for the map data preloading done during map transitions.
+*** ***************************************************************************/
+
+#include "utils/utils_pch.h"
+#include "modes/map/map_preloader.h"
+
+#include "modes/map/map_utils.h"
+
+#include "engine/system.h"
+
+using namespace vt_system;
+using namespace vt_video;
+using namespace vt_video::private_video;
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+//! \brief Decodes a tileset image.
+class TilesetDecodeJob : public Job
+{
+public:
+    TilesetDecodeJob(ImageMemory *image, const std::string &filename) :
+        Job(JOB_TYPE_IMAGE_DECODING),
+        _image(image),
+        _filename(filename)
+    {}
+
+    void Run() {
+        if(!_image->LoadImage(_filename))
+            PRINT_WARNING << "Failed to decode the tileset image: " << _filename << std::endl;
+    }
+
+private:
+    //! \brief The decoded image, owned by the preloader.
+    ImageMemory *_image;
+
+    std::string _filename;
+};
+
+MapPreloader::MapPreloader() :
+    _load_map_data_cache(false),
+    _num_uploaded_atlas_pages(0),
+    _load_job(JOB_HANDLE_NONE),
+    _decode_jobs_submitted(false),
+    _failed(false)
+{}
+
+MapPreloader::~MapPreloader()
+{
+    _WaitForJobs();
+    _ClearDecodedImages();
+    _tileset_images.clear();
+}
+
+void MapPreloader::Start(const std::string &map_data_filename)
+{
+    _map_data_filename = map_data_filename;
+
+    // The script engine can only be used from the main thread,
+    // so the Lua file is parsed right away when it has no up to date cache.
+    _load_map_data_cache = MapData::IsCacheUpToDate(_map_data_filename);
+    if(!_load_map_data_cache && !_map_data.LoadScript(_map_data_filename)) {
+        _failed = true;
+        _decode_jobs_submitted = true;
+        return;
+    }
+
+    _load_job = SystemManager->GetJobSystem().Submit(new MethodJob<MapPreloader>(JOB_TYPE_IMAGE_DECODING, this,
+                &MapPreloader::_LoadMapData, &MapPreloader::_SubmitDecodeJobs));
+}
+
+bool MapPreloader::Update()
+{
+    if(!_AreJobsDone())
+        return false;
+
+    if(_failed)
+        return true;
+
+    // Upload a single atlas page or tileset per call, to keep the frame time bounded.
+    if(_num_uploaded_atlas_pages < _atlas.GetNumberPages()) {
+        if(!_atlas.UploadPage(_num_uploaded_atlas_pages))
+            PRINT_WARNING << "Failed to preload a texture atlas page of: " << _map_data_filename << std::endl;
+        ++_num_uploaded_atlas_pages;
+        return false;
+    }
+
+    uint32 tileset_id = _tileset_images.size();
+    if(tileset_id >= _decoded_images.size())
+        return true;
+
+    _tileset_images.push_back(std::vector<StillImage>(TILES_PER_TILESET));
+
+    // When the image is in the atlas, its tiles are already uploaded with the atlas pages.
+    // When it couldn't be decoded, the map mode will report the error while loading it again.
+    ImageMemory &decoded_image = _decoded_images[tileset_id];
+    if(decoded_image.pixels != NULL) {
+        const std::string &image_filename = _map_data.tilesets[tileset_id].image_filename;
+        // Each tileset image is 512x512 pixels, yielding 16 * 16 (== 256) 32x32 pixel tiles each
+        if(!ImageDescriptor::LoadMultiImageFromElementGrid(_tileset_images.back(), image_filename, decoded_image, 16, 16))
+            PRINT_WARNING << "Failed to preload the tileset image: " << image_filename << std::endl;
+
+        free(decoded_image.pixels);
+        decoded_image.pixels = NULL;
+    }
+
+    return _tileset_images.size() >= _decoded_images.size();
+}
+
+void MapPreloader::Finish()
+{
+    _WaitForJobs();
+    while(!Update()) {}
+}
+
+void MapPreloader::_LoadMapData()
+{
+    if(_load_map_data_cache && !_map_data.LoadCache(MapData::GetCacheFilename(_map_data_filename))) {
+        PRINT_WARNING << "Invalid map cache file for: " << _map_data_filename << std::endl;
+        _failed = true;
+        return;
+    }
+
+    // The tilesets baked in an up to date atlas don't have to be decoded.
+    if(_atlas.ReadManifest(MapData::GetAtlasFilename(_map_data_filename)) && !_atlas.IsUpToDate())
+        _atlas.Clear();
+
+    _decoded_images.resize(_map_data.tilesets.size());
+}
+
+void MapPreloader::_SubmitDecodeJobs()
+{
+    _decode_jobs_submitted = true;
+    if(_failed)
+        return;
+
+    JobSystem &job_system = SystemManager->GetJobSystem();
+
+    if(_atlas.GetNumberPages() > 0) {
+        _decode_jobs.push_back(job_system.Submit(new MethodJob<MapPreloader>(JOB_TYPE_IMAGE_DECODING, this,
+                               &MapPreloader::_DecodeAtlasPages)));
+    }
+
+    for(uint32 i = 0; i < _map_data.tilesets.size(); ++i) {
+        if(_atlas.HasSource(_map_data.tilesets[i].image_filename))
+            continue;
+
+        _decode_jobs.push_back(job_system.Submit(new TilesetDecodeJob(&_decoded_images[i],
+                               _map_data.tilesets[i].image_filename)));
+    }
+}
+
+void MapPreloader::_DecodeAtlasPages()
+{
+    _atlas.DecodePages();
+}
+
+bool MapPreloader::_AreJobsDone()
+{
+    if(!_decode_jobs_submitted)
+        return false;
+
+    JobSystem &job_system = SystemManager->GetJobSystem();
+    for(uint32 i = 0; i < _decode_jobs.size(); ++i) {
+        if(!job_system.IsDone(_decode_jobs[i]))
+            return false;
+    }
+    return true;
+}
+
+void MapPreloader::_WaitForJobs()
+{
+    // The loading job submits the decoding jobs once finished.
+    JobSystem &job_system = SystemManager->GetJobSystem();
+    job_system.Wait(_load_job);
+    for(uint32 i = 0; i < _decode_jobs.size(); ++i)
+        job_system.Wait(_decode_jobs[i]);
+}
+
+void MapPreloader::_ClearDecodedImages()
+{
+    for(uint32 i = 0; i < _decoded_images.size(); ++i) {
+        if(_decoded_images[i].pixels != NULL)
+            free(_decoded_images[i].pixels);
+        _decoded_images[i].pixels = NULL;
+    }
+    _decoded_images.clear();
+}
+
+} // namespace private_map
+
+} // namespace vt_map
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ****************************************************************************
+*** \file    map_preloader.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the map data preloading done during map transitions.
+***
+*** The next map data and tileset images are read and decoded by jobs while
+*** the screen fades out: once the map data is loaded, each tileset image is
+*** decoded by its own job. Only the texture upload, which requires the OpenGL
+*** context, is done from the main thread, one tileset per frame.
+*** When the map has an up to date texture atlas, its pages are decoded instead
+*** of the tileset images they contain.
+*** ***************************************************************************/
+
+#ifndef __MAP_PRELOADER_HEADER__
+#define __MAP_PRELOADER_HEADER__
+
+#include "modes/map/map_data.h"
+
+#include "engine/video/image.h"
+#include "engine/video/texture_atlas.h"
+
+#include "engine/job_system.h"
+
+namespace vt_map
+{
+
+namespace private_map
+{
+
+/** ****************************************************************************
+*** \brief Loads the data of the next map in the background
+***
+*** Once Update() has returned true, the map data can be given to the new
+*** MapMode instance, and its tileset images are already in texture memory.
+*** The preloader must be kept until the new map is created, so that the
+*** tileset textures are not freed in between.
+***
+*** \note The map data Lua file can only be parsed from the main thread, since
+*** the script engine isn't thread-safe. Thus, it is only read in the
+*** background when its binary cache is up to date.
+*** ***************************************************************************/
+class MapPreloader
+{
+public:
+    MapPreloader();
+
+    //! \brief Waits for the jobs, and releases the preloaded data.
+    ~MapPreloader();
+
+    /** \brief Starts preloading the given map data file.
+    *** \param map_data_filename The name of the map data Lua file.
+    **/
+    void Start(const std::string &map_data_filename);
+
+    /** \brief Uploads the decoded atlas pages and tileset images to texture memory, at most one per call.
+    *** \return Whether the preloading is complete.
+    **/
+    bool Update();
+
+    /** \brief Waits for the jobs, and uploads everything left to texture memory at once.
+    *** Unlike Update(), the time it takes to complete doesn't depend on the jobs progress.
+    **/
+    void Finish();
+
+    /** \brief Returns the preloaded map data, or NULL if the preloading failed.
+    *** \note Only valid once Update() has returned true.
+    **/
+    const MapData *GetMapData() const {
+        return _failed ? NULL : &_map_data;
+    }
+
+private:
+    //! \brief Loads the map data cache and reads the atlas manifest. Run by the loading job.
+    void _LoadMapData();
+
+    //! \brief Submits the jobs decoding the atlas pages and tileset images, once the map data is loaded.
+    void _SubmitDecodeJobs();
+
+    //! \brief Decodes the atlas pages. Run by a decoding job.
+    void _DecodeAtlasPages();
+
+    //! \brief Tells whether all the jobs are done.
+    bool _AreJobsDone();
+
+    //! \brief Waits for the loading job, and then for the decoding jobs it submitted.
+    void _WaitForJobs();
+
+    //! \brief Frees the decoded tileset images.
+    void _ClearDecodedImages();
+
+    //! \brief The map data file being preloaded.
+    std::string _map_data_filename;
+
+    //! \brief The map data, loaded by the loading job when the map data cache is up to date.
+    MapData _map_data;
+
+    //! \brief Whether the map data still has to be loaded from its cache by the loading job.
+    bool _load_map_data_cache;
+
+    //! \brief The map texture atlas, read and decoded by the jobs when up to date.
+    vt_video::TextureAtlas _atlas;
+
+    //! \brief The number of atlas pages already uploaded to texture memory.
+    uint32 _num_uploaded_atlas_pages;
+
+    /** \brief The tileset images decoded by the jobs, in the map data tilesets order.
+    *** The tilesets found in the texture atlas aren't decoded.
+    **/
+    std::vector<vt_video::private_video::ImageMemory> _decoded_images;
+
+    //! \brief The tileset images uploaded to texture memory, which keep the textures referenced.
+    std::vector<std::vector<vt_video::StillImage> > _tileset_images;
+
+    //! \brief The job loading the map data.
+    vt_system::JobHandle _load_job;
+
+    //! \brief The jobs decoding the atlas pages and tileset images.
+    std::vector<vt_system::JobHandle> _decode_jobs;
+
+    //! \brief Set once the decoding jobs are submitted, or once there won't be any.
+    bool _decode_jobs_submitted;
+
+    //! \brief Set whenever the map data couldn't be loaded.
+    bool _failed;
+}; // class MapPreloader
+
+} // namespace private_map
+
+} // namespace vt_map
+
+#endif // __MAP_PRELOADER_HEADER__
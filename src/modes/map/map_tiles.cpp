@@ -21,6 +21,7 @@
 #include "modes/map/map_mode.h"
 
 #include "engine/video/video.h"
+#include "engine/system.h"
 
 using namespace vt_utils;
 using namespace vt_script;
@@ -35,7 +36,12 @@ namespace private_map
 TileSupervisor::TileSupervisor() :
     _num_tile_on_x_axis(0),
     _num_tile_on_y_axis(0)
-{}
+{
+    for(uint32 i = 0; i < INVALID_LAYER; ++i) {
+        _num_draw_calls[i] = 0;
+        _num_unbatched_draw_calls[i] = 0;
+    }
+}
 
 TileSupervisor::~TileSupervisor()
 {
@@ -47,50 +53,27 @@ TileSupervisor::~TileSupervisor()
     _tile_grid.clear();
     _tile_images.clear();
     _animated_tile_images.clear();
+    _animated_tile_quads.clear();
+    _animated_tile_frames.clear();
 }
 
-static LAYER_TYPE getLayerType(const std::string &type)
+bool TileSupervisor::Load(const MapData &map_data, const std::string &atlas_filename)
 {
-    if(type == "ground")
-        return GROUND_LAYER;
-    else if(type == "sky")
-        return SKY_LAYER;
-    return INVALID_LAYER;
-}
+    _num_tile_on_y_axis = map_data.num_tile_rows;
+    _num_tile_on_x_axis = map_data.num_tile_cols;
 
-
-bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
-{
-    // Load the map dimensions and do some basic sanity checks
-    _num_tile_on_y_axis = map_file.ReadInt("num_tile_rows");
-    _num_tile_on_x_axis = map_file.ReadInt("num_tile_cols");
+    // Register the tiles baked in the map texture atlas, if any, so that
+    // the tileset images below don't have to be decoded.
+    _atlas.Load(atlas_filename);
 
     // Load all of the tileset images that are used by this map
 
-    // Contains all of the tileset filenames used (string does not contain path information or file extensions)
-    std::vector<std::string> tileset_filenames;
+    const std::vector<MapTilesetData> &tilesets = map_data.tilesets;
     // Temporarily retains all tile images loaded for each tileset. Each inner vector contains 256 StillImage objects
     std::vector<std::vector<StillImage> > tileset_images;
 
-    map_file.ReadStringVector("tileset_filenames", tileset_filenames);
-
-    for(uint32 i = 0; i < tileset_filenames.size(); i++) {
-        std::string tileset_file = tileset_filenames[i];
-
-        ReadScriptDescriptor tileset_script;
-        if (!tileset_script.OpenFile(tileset_file)) {
-            PRINT_ERROR << "Couldn't open the tileset definition file: " << tileset_file << std::endl;
-            return false;
-        }
-
-        if (!tileset_script.OpenTable("tileset")) {
-            PRINT_ERROR << "Couldn't open the 'tileset' table from file: " << tileset_file << std::endl;
-            tileset_script.CloseFile();
-            return false;
-        }
-
-        std::string image_filename = tileset_script.ReadString("image");
-        tileset_script.CloseFile();
+    for(uint32 i = 0; i < tilesets.size(); i++) {
+        const std::string &image_filename = tilesets[i].image_filename;
 
         tileset_images.push_back(std::vector<StillImage>(TILES_PER_TILESET));
 
@@ -107,96 +90,38 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
         }
     }
 
-    if(!map_file.DoesTableExist("layers")) {
-        PRINT_ERROR << "No 'layers' table in the map file." << std::endl;
-        return false;
-    }
-
-    // Read in the map tile indeces from all tile layers.
-    // The indeces stored for the map layers in this file directly correspond to a location within a tileset. Tilesets contain a total of 256 tiles
+    // The indeces stored for the map layers directly correspond to a location within a tileset. Tilesets contain a total of 256 tiles
     // each, so 0-255 correspond to the first tileset, 256-511 the second, etc. The tile location within the tileset is also determined by the index,
     // where the first 16 indeces in the tileset range are the tiles of the first row (left to right), and so on.
-
-    // Clears out the tiles grid
     _tile_grid.clear();
-
-    std::vector<int32> table_x_indeces; // Used to temporarily store a row of table indeces
-
-    map_file.OpenTable("layers");
-
-    uint32 layers_number = map_file.GetTableSize();
-
-    // layers[0]-[n]
-    for(uint32 layer_id = 0; layer_id < layers_number; ++layer_id) {
-        // Opens the sub-table: layers[layer_id]
-        if(!map_file.DoesTableExist(layer_id))
-            continue;
-
-        map_file.OpenTable(layer_id);
-
-        // Add a layer for the base context
-        _tile_grid.resize(layer_id + 1);
-
-        LAYER_TYPE layer_type = getLayerType(map_file.ReadString("type"));
-
-        if(layer_type == INVALID_LAYER) {
-            PRINT_WARNING << "Ignoring unexisting layer type: " << layer_type
-                          << " in file: " << map_file.GetFilename() << std::endl;
-            map_file.CloseTable(); // layers[i]
-            continue;
-        }
-
-        _tile_grid[layer_id].layer_type = layer_type;
-
-        // Add the new tile rows (y axis)
-        _tile_grid[layer_id].tiles.resize(_num_tile_on_y_axis);
-
-        // Read the tile data
-        for(uint32 y = 0; y < _num_tile_on_y_axis; ++y) {
-            table_x_indeces.clear();
-
-            // Check to make sure tables are of the proper size
-            if(!map_file.DoesTableExist(y)) {
-                PRINT_ERROR << "the layers[" << layer_id << "] table size was not equal to the number of tile rows specified by the map, "
-                            " first missing row: " << y << std::endl;
-                return false;
-            }
-
-            map_file.ReadIntVector(y, table_x_indeces);
-
-            // Check the number of columns
-            if(table_x_indeces.size() != _num_tile_on_x_axis) {
-                PRINT_ERROR << "the layers[" << layer_id << "][" << y << "] table size was not equal to the number of tile columns specified by the map, "
-                            "should have " << _num_tile_on_x_axis << " values." << std::endl;
-                return false;
-            }
-
-            // Prepare the columns (x axis)
-            _tile_grid[layer_id].tiles[y].resize(_num_tile_on_x_axis);
-
-            for(uint32 x = 0; x < _num_tile_on_x_axis; ++x) {
-                _tile_grid[layer_id].tiles[y][x] = table_x_indeces[x];
-            }
-        }
-        map_file.CloseTable(); // layers[layer_id]
+    _tile_grid.resize(map_data.layers.size());
+    for(uint32 layer_id = 0; layer_id < map_data.layers.size(); ++layer_id) {
+        _tile_grid[layer_id].layer_type = map_data.layers[layer_id].layer_type;
+        _tile_grid[layer_id].tiles = map_data.layers[layer_id].tiles;
     }
-
-    map_file.CloseTable(); // layers
+    uint32 layers_number = _tile_grid.size();
 
     // Determine which tiles in each tileset are referenced in this map
 
     // Used to determine whether each tile is used by the map or not. An entry of -1 indicates that particular tile is not used
     std::vector<int16> tile_references;
     // Set size to be equal to the total number of tiles and initialize all entries to -1 (unreferenced)
-    tile_references.assign(tileset_filenames.size() * TILES_PER_TILESET, -1);
+    tile_references.assign(tilesets.size() * TILES_PER_TILESET, -1);
 
     // For each layer
     for(uint32 layer_id = 0; layer_id < layers_number; ++layer_id) {
         // For each tile id
         for(uint32 y = 0; y < _num_tile_on_y_axis; ++y) {
+            const int16 *tile_row = _tile_grid[layer_id].tiles[y];
             for(uint32 x = 0; x < _num_tile_on_x_axis; ++x) {
-                if(_tile_grid[layer_id].tiles[y][x] >= 0)
-                    tile_references[_tile_grid[layer_id].tiles[y][x] ] = 0;
+                if(tile_row[x] < 0)
+                    continue;
+                if(static_cast<uint32>(tile_row[x]) >= tile_references.size()) {
+                    PRINT_ERROR << "Invalid tile index: " << tile_row[x] << " in layer: " << layer_id
+                                << " at (" << x << ", " << y << ")" << std::endl;
+                    return false;
+                }
+                tile_references[tile_row[x]] = 0;
             }
         }
     }
@@ -222,66 +147,45 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     for(uint32 layer_id = 0; layer_id < layers_number; ++layer_id) {
         // For each tile id
         for(uint32 y = 0; y < _num_tile_on_y_axis; ++y) {
+            int16 *tile_row = _tile_grid[layer_id].tiles[y];
             for(uint32 x = 0; x < _num_tile_on_x_axis; ++x) {
-                if(_tile_grid[layer_id].tiles[y][x] >= 0)
-                    _tile_grid[layer_id].tiles[y][x] = tile_references[_tile_grid[layer_id].tiles[y][x] ];
+                if(tile_row[x] >= 0)
+                    tile_row[x] = tile_references[tile_row[x]];
             }
         }
     }
 
-    // Parse all of the tileset definition files and create any animated tile images that will be used
+    // Create any animated tile images that will be used
 
-    // Used to access the tileset definition file
-    ReadScriptDescriptor tileset_script;
-    // Temporarily retains the animation data (every two elements corresponds to a pair of tile frame index and display time)
-    std::vector<uint32> animation_info;
     // Temporarily holds all animated tile images. The map key is the value of the tile index, before reference translation is done in the next step
     std::map<uint32, AnimatedImage *> tile_animations;
 
-    for(uint32 i = 0; i < tileset_filenames.size(); i++) {
-        if (!tileset_script.OpenFile(tileset_filenames[i])) {
-            PRINT_ERROR << "map failed to load because it could not open a tileset definition file: "
-                << tileset_filenames[i] << std::endl;
-            return false;
-        }
-
-        if (!tileset_script.OpenTable("tileset")) {
-            PRINT_ERROR << "map failed to load because it could not open the 'tileset' table from file: "
-                << tileset_filenames[i] << std::endl;
-            tileset_script.CloseFile();
-            return false;
-        }
+    for(uint32 i = 0; i < tilesets.size(); i++) {
+        for(uint32 j = 0; j < tilesets[i].animations.size(); j++) {
+            // Every two elements corresponds to a pair of tile frame index and display time
+            const std::vector<uint32> &animation_info = tilesets[i].animations[j];
+            if(animation_info.size() < 2)
+                continue;
 
-        if(tileset_script.DoesTableExist("animated_tiles")) {
-            tileset_script.OpenTable("animated_tiles");
-            for(uint32 j = 1; j <= tileset_script.GetTableSize(); j++) {
-                animation_info.clear();
-                tileset_script.ReadUIntVector(j, animation_info);
+            // The index of the first frame in the animation. (i * TILES_PER_TILESET) factors in which tileset the frame comes from
+            uint32 first_frame_index = animation_info[0] + (i * TILES_PER_TILESET);
 
-                // The index of the first frame in the animation. (i * TILES_PER_TILESET) factors in which tileset the frame comes from
-                uint32 first_frame_index = animation_info[0] + (i * TILES_PER_TILESET);
-
-                // If the first tile frame index of this animation was not referenced anywhere in the map, then the animation is unused and
-                // we can safely skip over it and move on to the next one. Otherwise if it is referenced, we have to construct the animated image
-                if(tile_references[first_frame_index] == -1) {
-                    continue;
-                }
+            // If the first tile frame index of this animation was not referenced anywhere in the map, then the animation is unused and
+            // we can safely skip over it and move on to the next one. Otherwise if it is referenced, we have to construct the animated image
+            if(first_frame_index >= tile_references.size() || tile_references[first_frame_index] == -1) {
+                continue;
+            }
 
-                AnimatedImage *new_animation = new AnimatedImage();
-                new_animation->SetDimensions(2.0f, 2.0f);
+            AnimatedImage *new_animation = new AnimatedImage();
+            new_animation->SetDimensions(2.0f, 2.0f);
 
-                // Each pair of entries in the animation info indicate the tile frame index (k) and the time (k+1)
-                for(uint32 k = 0; k < animation_info.size(); k += 2) {
-                    new_animation->AddFrame(tileset_images[i][animation_info[k]], animation_info[k + 1]);
-                }
-                tile_animations.insert(std::make_pair(first_frame_index, new_animation));
+            // Each pair of entries in the animation info indicate the tile frame index (k) and the time (k+1)
+            for(uint32 k = 0; k + 1 < animation_info.size(); k += 2) {
+                new_animation->AddFrame(tileset_images[i][animation_info[k]], animation_info[k + 1]);
             }
-            tileset_script.CloseTable();
+            tile_animations.insert(std::make_pair(first_frame_index, new_animation));
         }
-
-        tileset_script.CloseTable();
-        tileset_script.CloseFile();
-    } // for (uint32 i = 0; i < tileset_filenames.size(); i++)
+    }
 
     // Add all referenced tiles to the _tile_images vector, in the proper order
 
@@ -312,52 +216,284 @@ bool TileSupervisor::Load(ReadScriptDescriptor &map_file)
     // Remove all tileset images. Any tiles which were not added to _tile_images will no longer exist in memory
     tileset_images.clear();
 
+    _BuildTileBatches();
+
     return true;
-} // bool TileSupervisor::Load(ReadScriptDescriptor& map_file)
+} // bool TileSupervisor::Load(const MapData &map_data, const std::string &atlas_filename)
 
+//! \brief Writes the texture coordinates of a tile quad, in the same vertex order as ImageDescriptor::_DrawTexture().
+static void SetTileQuadTexCoords(float *tex_coords, const private_video::ImageTexture *texture)
+{
+    tex_coords[0] = texture->u1;
+    tex_coords[1] = texture->v2;
+    tex_coords[2] = texture->u2;
+    tex_coords[3] = texture->v2;
+    tex_coords[4] = texture->u2;
+    tex_coords[5] = texture->v1;
+    tex_coords[6] = texture->u1;
+    tex_coords[7] = texture->v1;
+}
 
+void TileSupervisor::_BuildTileBatches()
+{
+    // Find out which tile images are animated, and whether all their frames
+    // share the same texture sheet, as required to batch them.
+    std::vector<int32> animation_ids(_tile_images.size(), -1);
+    std::vector<bool> batchable_animations(_animated_tile_images.size(), true);
+    for(uint32 i = 0; i < _animated_tile_images.size(); ++i) {
+        for(uint32 j = 0; j < _tile_images.size(); ++j) {
+            if(_tile_images[j] == _animated_tile_images[i]) {
+                animation_ids[j] = i;
+                break;
+            }
+        }
+
+        const AnimatedImage *animation = _animated_tile_images[i];
+        if(animation->GetNumFrames() == 0) {
+            batchable_animations[i] = false;
+            continue;
+        }
+        const StillImage *first_frame = animation->GetFrame(0);
+        for(uint32 j = 0; j < animation->GetNumFrames(); ++j) {
+            const StillImage *frame = animation->GetFrame(j);
+            if(!frame->GetImageTexture() || !first_frame->GetImageTexture() ||
+                    frame->GetImageTexture()->texture_sheet != first_frame->GetImageTexture()->texture_sheet) {
+                batchable_animations[i] = false;
+                break;
+            }
+        }
+    }
+
+    _animated_tile_quads.assign(_animated_tile_images.size(), std::vector<AnimatedTileQuad>());
+    _animated_tile_frames.assign(_animated_tile_images.size(), 0);
+
+    for(uint32 layer_id = 0; layer_id < _tile_grid.size(); ++layer_id) {
+        Layer &layer = _tile_grid[layer_id];
+        layer.batches.clear();
+        layer.unbatched_tiles.clear();
+
+        if(layer.tiles.GetHeight() != _num_tile_on_y_axis)
+            continue;
+
+        for(uint32 y = 0; y < _num_tile_on_y_axis; ++y) {
+            // Open the row in every batch already created
+            for(uint32 i = 0; i < layer.batches.size(); ++i)
+                layer.batches[i].row_offsets.push_back(layer.batches[i].vertices.size() / 8);
+
+            const int16 *tile_row = layer.tiles[y];
+            for(uint32 x = 0; x < _num_tile_on_x_axis; ++x) {
+                int16 tile_id = tile_row[x];
+                if(tile_id < 0)
+                    continue;
+
+                // Get the texture used to draw the tile, or its first frame when animated
+                int32 animation_id = animation_ids[tile_id];
+                const private_video::ImageTexture *texture = NULL;
+                if(animation_id < 0)
+                    texture = static_cast<const StillImage *>(_tile_images[tile_id])->GetImageTexture();
+                else if(batchable_animations[animation_id])
+                    texture = _animated_tile_images[animation_id]->GetFrame(0)->GetImageTexture();
+
+                if(!texture) {
+                    layer.unbatched_tiles.push_back(UnbatchedTile(x, y, tile_id));
+                    continue;
+                }
+
+                uint32 batch_id = 0;
+                while(batch_id < layer.batches.size() && layer.batches[batch_id].texture_sheet != texture->texture_sheet)
+                    ++batch_id;
+
+                if(batch_id == layer.batches.size()) {
+                    layer.batches.push_back(TileBatch());
+                    layer.batches.back().texture_sheet = texture->texture_sheet;
+                    // The batch has no quads on the previous rows
+                    layer.batches.back().row_offsets.assign(y + 1, 0);
+                }
+                TileBatch &batch = layer.batches[batch_id];
+
+                if(animation_id >= 0)
+                    _animated_tile_quads[animation_id].push_back(AnimatedTileQuad(layer_id, batch_id, batch.vertices.size() / 8));
+
+                // Each tile is 2.0f large in map coordinates. The vertices are laid out as in ImageDescriptor::_DrawTexture()
+                // once oriented for the map coordinate system, where the y axis points downwards.
+                float left = static_cast<float>(x * 2);
+                float top = static_cast<float>(y * 2);
+                float vertices[] = {
+                    left, top + 2.0f,
+                    left + 2.0f, top + 2.0f,
+                    left + 2.0f, top,
+                    left, top
+                };
+                batch.vertices.insert(batch.vertices.end(), vertices, vertices + 8);
+                batch.columns.push_back(static_cast<uint16>(x));
+
+                batch.tex_coords.resize(batch.tex_coords.size() + 8);
+                SetTileQuadTexCoords(&batch.tex_coords[batch.tex_coords.size() - 8], texture);
+            } // x
+        } // y
+
+        // Close the last row of each batch
+        for(uint32 i = 0; i < layer.batches.size(); ++i)
+            layer.batches[i].row_offsets.push_back(layer.batches[i].vertices.size() / 8);
+    } // layer_id
+
+    // Start the animated tiles at their current frame
+    for(uint32 i = 0; i < _animated_tile_images.size(); ++i)
+        _UpdateAnimatedTileQuads(i);
+}
+
+void TileSupervisor::_UpdateAnimatedTileQuads(uint32 animation_id)
+{
+    const std::vector<AnimatedTileQuad> &quads = _animated_tile_quads[animation_id];
+    if(quads.empty())
+        return;
+
+    const AnimatedImage *animation = _animated_tile_images[animation_id];
+    _animated_tile_frames[animation_id] = animation->GetCurrentFrameIndex();
+    const private_video::ImageTexture *texture = animation->GetCurrentFrame()->GetImageTexture();
+
+    for(uint32 i = 0; i < quads.size(); ++i) {
+        TileBatch &batch = _tile_grid[quads[i].layer_id].batches[quads[i].batch_id];
+        SetTileQuadTexCoords(&batch.tex_coords[quads[i].quad_id * 8], texture);
+    }
+}
 
 void TileSupervisor::Update()
 {
     for(uint32 i = 0; i < _animated_tile_images.size(); i++) {
         _animated_tile_images[i]->Update();
+
+        // Only patch the batched quads when the animation frame changes
+        if(_animated_tile_images[i]->GetCurrentFrameIndex() != _animated_tile_frames[i])
+            _UpdateAnimatedTileQuads(i);
     }
 }
 
 
 void TileSupervisor::DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_type)
 {
-    // We'll use the top-left positions to render the tiles.
-    VideoManager->SetDrawFlags(VIDEO_BLEND, VIDEO_X_LEFT, VIDEO_Y_TOP, 0);
+    vt_system::ProfilerScope marker("TileSupervisor::DrawLayers");
 
     // Map frame ends
-    uint32 y_end = static_cast<uint32>(frame->tile_y_start + frame->num_draw_y_axis);
+    uint32 y_start = static_cast<uint32>(frame->tile_y_start);
+    uint32 x_start = static_cast<uint32>(frame->tile_x_start);
+    uint32 y_end = std::min(static_cast<uint32>(frame->tile_y_start + frame->num_draw_y_axis),
+                            static_cast<uint32>(_num_tile_on_y_axis));
     uint32 x_end = static_cast<uint32>(frame->tile_x_start + frame->num_draw_x_axis);
 
+    _num_draw_calls[layer_type] = 0;
+    _num_unbatched_draw_calls[layer_type] = 0;
+
+    // We substract 0.5 horizontally and 1.0 vertically here
+    // because the video engine will display the map tiles using their
+    // top left coordinates to avoid a position computation flaw when specifying the tile
+    // coordinates from the bottom center point, as the engine does for everything else.
+    float x_origin = frame->tile_x_offset - 1.0f;
+    float y_origin = frame->tile_y_offset - 2.0f;
+
+    // The batched tiles don't go through ImageDescriptor::_DrawOrientation(),
+    // so apply the screen shaking offsets the same way.
+    float x_shake = 0.0f;
+    float y_shake = 0.0f;
+    if(VideoManager->IsScreenShaking()) {
+        const CoordSys &coord_sys = VideoManager->GetCoordSys();
+        x_shake = VideoManager->GetXShake() * (coord_sys.GetRight() - coord_sys.GetLeft()) / VIDEO_STANDARD_RES_WIDTH
+                  * coord_sys.GetHorizontalDirection();
+        y_shake = VideoManager->GetYShake() * (coord_sys.GetTop() - coord_sys.GetBottom()) / VIDEO_STANDARD_RES_HEIGHT
+                  * coord_sys.GetVerticalDirection();
+    }
+
+    // The tiles are drawn directly, so draw the pending images first
+    VideoManager->FlushSpriteBatch();
+
+    // Set the render state once for all the batches: normal blending, white unichrome vertices.
+    VideoManager->EnableBlending();
+    VideoManager->EnableTexture2D();
+    VideoManager->EnableVertexArray();
+    VideoManager->EnableTextureCoordArray();
+    VideoManager->DisableColorArray();
+    if(!VIDEO_HEADLESS) {
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    // The batch vertices are relative to the map top-left corner.
+    VideoManager->PushMatrix();
+    VideoManager->Move(x_origin - static_cast<float>(x_start * 2) + x_shake,
+                       y_origin - static_cast<float>(y_start * 2) + y_shake);
+
+    bool smooth = VideoManager->ShouldSmoothPixelArt();
     uint32 layer_number = _tile_grid.size();
     for(uint32 layer_id = 0; layer_id < layer_number; ++layer_id) {
+        const Layer &layer = _tile_grid[layer_id];
+        if(layer.layer_type != layer_type)
+            continue;
+
+        // Draw the visible tiles sharing a texture sheet in a single call.
+        for(uint32 i = 0; i < layer.batches.size(); ++i) {
+            const TileBatch &batch = layer.batches[i];
+
+            // Only keep the quads of each visible row which are within the visible columns.
+            _visible_vertex_indices.clear();
+            for(uint32 y = y_start; y < y_end; ++y) {
+                std::vector<uint16>::const_iterator row_begin = batch.columns.begin() + batch.row_offsets[y];
+                std::vector<uint16>::const_iterator row_end = batch.columns.begin() + batch.row_offsets[y + 1];
+                std::vector<uint16>::const_iterator first = std::lower_bound(row_begin, row_end, x_start);
+                std::vector<uint16>::const_iterator last = std::lower_bound(first, row_end, x_end);
+                for(std::vector<uint16>::const_iterator it = first; it != last; ++it) {
+                    uint32 vertex_index = static_cast<uint32>(it - batch.columns.begin()) * 4;
+                    _visible_vertex_indices.push_back(vertex_index);
+                    _visible_vertex_indices.push_back(vertex_index + 1);
+                    _visible_vertex_indices.push_back(vertex_index + 2);
+                    _visible_vertex_indices.push_back(vertex_index + 3);
+                }
+            }
+            if(_visible_vertex_indices.empty())
+                continue;
+
+            batch.texture_sheet->Bind();
+            batch.texture_sheet->Smooth(smooth);
+            if(!VIDEO_HEADLESS) {
+                glVertexPointer(2, GL_FLOAT, 0, &batch.vertices[0]);
+                glTexCoordPointer(2, GL_FLOAT, 0, &batch.tex_coords[0]);
+                glDrawElements(GL_QUADS, _visible_vertex_indices.size(), GL_UNSIGNED_INT, &_visible_vertex_indices[0]);
+            }
+            ++_num_draw_calls[layer_type];
+        }
+    }
+    VideoManager->PopMatrix();
+
+    // We'll use the top-left positions to render the remaining tiles.
+    VideoManager->SetDrawFlags(VIDEO_BLEND, VIDEO_X_LEFT, VIDEO_Y_TOP, 0);
 
-        const Layer &layer = _tile_grid.at(layer_id);
+    for(uint32 layer_id = 0; layer_id < layer_number; ++layer_id) {
+        const Layer &layer = _tile_grid[layer_id];
         if(layer.layer_type != layer_type)
             continue;
 
-        // We substract 0.5 horizontally and 1.0 vertically here
-        // because the video engine will display the map tiles using their
-        // top left coordinates to avoid a position computation flaw when specifying the tile
-        // coordinates from the bottom center point, as the engine does for everything else.
-        VideoManager->Move(frame->tile_x_offset - 1.0f, frame->tile_y_offset - 2.0f);
+        for(uint32 i = 0; i < layer.unbatched_tiles.size(); ++i) {
+            const UnbatchedTile &tile = layer.unbatched_tiles[i];
+            if(tile.x < x_start || tile.x >= x_end || tile.y < y_start || tile.y >= y_end)
+                continue;
 
-        for(uint32 y = static_cast<uint32>(frame->tile_y_start); y < y_end; ++y) {
-            for(uint32 x = static_cast<uint32>(frame->tile_x_start); x < x_end; ++x) {
-                // Draw a tile image if it exists at this location
-                if(layer.tiles[y][x] >= 0)
-                    _tile_images[ layer.tiles[y][x] ]->Draw();
+            VideoManager->Move(x_origin + static_cast<float>((tile.x - x_start) * 2),
+                               y_origin + static_cast<float>((tile.y - y_start) * 2));
+            _tile_images[tile.tile_id]->Draw();
+            ++_num_draw_calls[layer_type];
+        }
 
-                VideoManager->MoveRelative(2.0f, 0.0f);
-            } // x
-            VideoManager->MoveRelative(-static_cast<float>(frame->num_draw_x_axis * 2), 2.0f);
-        } // y
+        // Count the draw calls a tile by tile rendering would have needed.
+        if(!VideoManager->DebugInfoOn() || layer.tiles.GetHeight() != _num_tile_on_y_axis)
+            continue;
+        for(uint32 y = y_start; y < y_end; ++y) {
+            const int16 *tile_row = layer.tiles[y];
+            for(uint32 x = x_start; x < x_end && x < _num_tile_on_x_axis; ++x) {
+                if(tile_row[x] >= 0)
+                    ++_num_unbatched_draw_calls[layer_type];
+            }
+        }
     } // layer_id
+
     // Restore the previous draw flags
     VideoManager->SetDrawFlags(VIDEO_X_CENTER, VIDEO_Y_BOTTOM, 0);
 }
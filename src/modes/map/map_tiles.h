@@ -22,12 +22,18 @@
 #define __MAP_TILES_HEADER__
 
 #include "modes/map/map_utils.h"
+#include "modes/map/map_data.h"
 
-#include "engine/script/script_read.h"
+#include "engine/video/texture_atlas.h"
+
+#include "utils/utils_grid.h"
 
 namespace vt_video {
 class ImageDescriptor;
 class AnimatedImage;
+namespace private_video {
+class TexSheet;
+}
 }
 
 namespace vt_map
@@ -38,11 +44,54 @@ class MapMode;
 namespace private_map
 {
 
-//! \brief Layer types: Drawn before, along, or after the map objects according to their types.
-enum LAYER_TYPE {
-    GROUND_LAYER = 0,
-    SKY_LAYER = 1,
-    INVALID_LAYER = 2
+/** ****************************************************************************
+*** \brief The cached vertex data of all the tiles of a layer sharing a texture sheet
+***
+*** The quads are stored row after row, so that any range of tile rows is a
+*** contiguous range of quads which can be drawn in a single call. The vertices
+*** are expressed in map coordinates relative to the top-left map corner, and
+*** are only computed once when the map is loaded. Only the texture coordinates
+*** of the animated tiles are modified afterwards.
+*** ***************************************************************************/
+class TileBatch
+{
+public:
+    //! \brief The texture sheet all the tiles of the batch are stored in.
+    vt_video::private_video::TexSheet *texture_sheet;
+
+    //! \brief The quads vertex coordinates: 4 (x, y) pairs per tile.
+    std::vector<float> vertices;
+
+    //! \brief The quads texture coordinates: 4 (s, t) pairs per tile.
+    std::vector<float> tex_coords;
+
+    /** \brief The index of the first quad of each tile row.
+    *** It contains one more entry than there are rows, holding the total number of quads.
+    **/
+    std::vector<uint32> row_offsets;
+
+    //! \brief The column of each quad, increasing within each row, used to find the visible quads of a row.
+    std::vector<uint16> columns;
+
+    TileBatch():
+        texture_sheet(NULL)
+    {}
+};
+
+//! \brief A tile which couldn't be batched and is drawn on its own.
+class UnbatchedTile
+{
+public:
+    uint16 x;
+    uint16 y;
+    //! \brief The tile image index.
+    int16 tile_id;
+
+    UnbatchedTile(uint16 x_, uint16 y_, int16 tile_id_):
+        x(x_),
+        y(y_),
+        tile_id(tile_id_)
+    {}
 };
 
 class Layer
@@ -50,13 +99,34 @@ class Layer
 public:
     LAYER_TYPE layer_type;
     // Represents the tile indeces: i.e: tiles[y][x] = tile_id at (x,y)
-    std::vector< std::vector<int16> > tiles;
+    vt_utils::FlatGrid<int16> tiles;
+
+    //! \brief The layer tiles vertex data, one batch per texture sheet.
+    std::vector<TileBatch> batches;
+
+    //! \brief The tiles which are drawn one by one, e.g. animations spread on several texture sheets.
+    std::vector<UnbatchedTile> unbatched_tiles;
 
     Layer():
         layer_type(GROUND_LAYER)
     {}
 };
 
+//! \brief The location of an animated tile quad, used to update its texture coordinates.
+class AnimatedTileQuad
+{
+public:
+    uint32 layer_id;
+    uint32 batch_id;
+    uint32 quad_id;
+
+    AnimatedTileQuad(uint32 layer_id_, uint32 batch_id_, uint32 quad_id_):
+        layer_id(layer_id_),
+        batch_id(batch_id_),
+        quad_id(quad_id_)
+    {}
+};
+
 /** ****************************************************************************
 *** \brief A helper class to MapMode responsible for all tile data and operations
 ***
@@ -76,11 +146,12 @@ public:
 
     ~TileSupervisor();
 
-    /** \brief Handles all operations on loading tilesets and tile images from the map data file
-    *** \param map_file A reference to the Lua file containing the map data
-    *** \note The map file should already be opened with no Lua tables open
+    /** \brief Handles all operations on loading tilesets and tile images from the map data
+    *** \param map_data The map data, already loaded from the map data file or its cache
+    *** \param atlas_filename The texture atlas manifest baked for the map. When up to date,
+    *** the tiles are taken from it instead of being cut from the tileset images.
     **/
-    bool Load(vt_script::ReadScriptDescriptor &map_file);
+    bool Load(const MapData &map_data, const std::string &atlas_filename);
 
     //! \brief Updates all animated tile images
     void Update();
@@ -99,6 +170,18 @@ public:
     void DrawLayers(const MapFrame *frame, const LAYER_TYPE &layer_type);
     //@}
 
+    //! \brief Returns the number of draw calls used to draw the tile layers during the last frame.
+    uint32 GetNumDrawCalls() const {
+        return _num_draw_calls[GROUND_LAYER] + _num_draw_calls[SKY_LAYER];
+    }
+
+    /** \brief Returns the number of draw calls that drawing the tiles one by one would have needed
+    *** during the last frame. Only computed when the debug info is displayed.
+    **/
+    uint32 GetNumUnbatchedDrawCalls() const {
+        return _num_unbatched_draw_calls[GROUND_LAYER] + _num_unbatched_draw_calls[SKY_LAYER];
+    }
+
 private:
     /** \brief The number of columns of tiles in the map.
     *** This number must be greater than or equal to 32 for the map to be valid.
@@ -113,6 +196,9 @@ private:
     //! \brief The map tile layers
     std::vector<Layer> _tile_grid;
 
+    //! \brief The texture atlas baked for the map, keeping its tiles in texture memory.
+    vt_video::TextureAtlas _atlas;
+
     //! \brief Contains the image objects for all map tiles, both still and animated.
     std::vector<vt_video::ImageDescriptor *> _tile_images;
 
@@ -121,6 +207,29 @@ private:
     *** _tile_images vector, which contains both still and animated images.
     **/
     std::vector<vt_video::AnimatedImage *> _animated_tile_images;
+
+    //! \brief The batched quads using each animated tile image, indexed like _animated_tile_images.
+    std::vector<std::vector<AnimatedTileQuad> > _animated_tile_quads;
+
+    //! \brief The animation frame index last copied into the batches, indexed like _animated_tile_images.
+    std::vector<uint32> _animated_tile_frames;
+
+    //! \brief The number of draw calls used during the last frame, per layer type.
+    uint32 _num_draw_calls[INVALID_LAYER];
+
+    //! \brief The number of tiles drawn during the last frame, per layer type.
+    uint32 _num_unbatched_draw_calls[INVALID_LAYER];
+
+    //! \brief The vertex indices of the visible quads of a batch, kept to avoid reallocating it every frame.
+    std::vector<uint32> _visible_vertex_indices;
+
+    /** \brief Builds the vertex data of every layer, grouping the tiles by texture sheet.
+    *** Called once all the tile images are loaded.
+    **/
+    void _BuildTileBatches();
+
+    //! \brief Copies the texture coordinates of the current frame of the given animation in the batches.
+    void _UpdateAnimatedTileQuads(uint32 animation_id);
 }; // class TileSupervisor
 
 } // namespace private_map
@@ -53,6 +53,9 @@ const uint16 HALF_TILES_ON_Y_AXIS = TILES_ON_Y_AXIS / 2;
 
 const uint16 GRID_LENGTH = 32; // Length of a grid element in pixels
 const uint16 TILE_LENGTH = GRID_LENGTH * 2; // Length of a tile in pixels
+
+//! \brief The side length of a map object grid bucket, in collision grid elements.
+const uint16 OBJECT_GRID_CELL_LENGTH = 4;
 //@}
 
 
@@ -303,10 +306,13 @@ public:
 /** ****************************************************************************
 *** \brief A container class for node information in pathfinding.
 ***
-*** This class is used in the MapMode#_FindPath function to find an optimal
+*** This class is used in the ObjectSupervisor#FindPath function to find an optimal
 *** path from a given source to a destination. The path finding algorithm
 *** employed is A* and thus many members of this class are particular to the
 *** implementation of that algorithm.
+***
+*** \note The scores are stored on 32 bits since a long path on a big map
+*** could overflow a 16-bit g_score once sprite avoidance costs are added.
 *** ***************************************************************************/
 class PathNode
 {
@@ -320,13 +326,13 @@ public:
     //! \name Path Scoring Members
     //@{
     //! \brief The total score for this node (f = g + h).
-    int16 f_score;
+    int32 f_score;
 
     //! \brief The score for this node relative to the source.
-    int16 g_score;
+    int32 g_score;
 
-    //! \brief The Manhattan distance from this node to the destination.
-    int16 h_score;
+    //! \brief The diagonal distance from this node to the destination.
+    int32 h_score;
     //@}
 
     //! \brief The grid coordinates for the parent of this node
@@ -350,9 +356,14 @@ public:
         return ((this->tile_x != that.tile_x) || (this->tile_y != that.tile_y));
     }
 
-    //! \brief Overloaded comparison operator only used for path finding, compares the two f_scores
-    bool operator<(const PathNode &that) const {
-        return this->f_score > that.f_score;
+    /** \brief Tells whether this node should be expanded before the other one.
+    *** Nodes with the lowest f_score come first. On ties, the node the furthest
+    *** from the source is preferred, as it is likely closer to the destination.
+    **/
+    bool IsBetterThan(const PathNode &that) const {
+        if(this->f_score != that.f_score)
+            return this->f_score < that.f_score;
+        return this->g_score > that.g_score;
     }
 }; // class PathNode
 
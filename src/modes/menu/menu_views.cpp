@@ -454,8 +454,14 @@ void InventoryWindow::Update()
                             if(IsTargetParty(item->GetTargetType())) {
                                 GlobalParty *ch_party = GlobalManager->GetActiveParty();
 
+                                bool item_used;
+                                {
+                                    vt_script::ScriptCallScope call(script_function);
+                                    item_used = ScriptCallFunction<bool>(script_function, ch_party);
+                                }
+
                                 // If the item use failed, we readd it to inventory.
-                                if(!ScriptCallFunction<bool>(script_function, ch_party))
+                                if(!item_used)
                                     GlobalManager->AddToInventory(item);
                                 else // delete the item instance when succeeded. Also, return back a level to the item selection list
                                 {
@@ -470,8 +476,14 @@ void InventoryWindow::Update()
                                 }
                             } // if GLOBAL_TARGET_PARTY
                             else { // Use on a single character only
+                                bool item_used;
+                                {
+                                    vt_script::ScriptCallScope call(script_function);
+                                    item_used = ScriptCallFunction<bool>(script_function, _character);
+                                }
+
                                 // If the item use failed, we readd it to inventory.
-                                if(!ScriptCallFunction<bool>(script_function, _character))
+                                if(!item_used)
                                     GlobalManager->AddToInventory(item);
                                 else // delete the item instance when succeeded. Also, return back a level to the item selection list
                                 {
@@ -1310,7 +1322,10 @@ void SkillsWindow::Update()
                 IF_PRINT_WARNING(MENU_DEBUG) << "did not have enough skill points to execute skill " << std::endl;
                 break;
             }
-            ScriptCallFunction<void>(script_function, target, instigator);
+            {
+                vt_script::ScriptCallScope call(script_function);
+                ScriptCallFunction<void>(script_function, target, instigator);
+            }
             instigator->SubtractSkillPoints(skill->GetSPRequired());
             media.PlaySound("confirm");
         } else if(event == VIDEO_OPTION_CANCEL) {
@@ -58,6 +58,15 @@ const uint8 SAVE_MODE_SAVE_COMPLETE   = 3;
 const uint8 SAVE_MODE_SAVE_FAILED     = 4;
 const uint8 SAVE_MODE_FADING_OUT      = 5;
 const uint8 SAVE_MODE_NO_VALID_SAVES  = 6;
+const uint8 SAVE_MODE_WRITING_SAVE    = 7;
+//@}
+
+//! \name Save Slot Preview States
+//@{
+const uint8 SAVE_SLOT_UNREAD  = 0;
+const uint8 SAVE_SLOT_EMPTY   = 1;
+const uint8 SAVE_SLOT_INVALID = 2;
+const uint8 SAVE_SLOT_VALID   = 3;
 //@}
 
 SaveMode::SaveMode(bool save_mode, uint32 x_position, uint32 y_position) :
@@ -119,6 +128,9 @@ SaveMode::SaveMode(bool save_mode, uint32 x_position, uint32 y_position) :
     _file_list.AddOption(UTranslate("Slot 5"));
     _file_list.AddOption(UTranslate("Slot 6"));
 
+    _slot_previews.resize(_file_list.GetNumberOptions());
+    _slot_states.resize(_file_list.GetNumberOptions(), SAVE_SLOT_UNREAD);
+
     // Restore the cursor position to the last load/save position.
     uint32 slot_id = GlobalManager->GetGameSlotId();
 
@@ -245,6 +257,27 @@ void SaveMode::Update()
         return;
     }
 
+    // The saved game file is being written in the background
+    if(_current_state == SAVE_MODE_WRITING_SAVE) {
+        if(GlobalManager->IsSavingGame())
+            return;
+
+        // The slot preview is read again from the new saved game.
+        uint32 id = (uint32)_file_list.GetSelection();
+        if(id < _slot_states.size())
+            _slot_states[id] = SAVE_SLOT_UNREAD;
+
+        // Tell the user whether the save failed.
+        if(GlobalManager->WaitForSaveGame()) {
+            _current_state = SAVE_MODE_SAVE_COMPLETE;
+            AudioManager->PlaySound("snd/save_successful_nick_bowler_oga.wav");
+        } else {
+            _current_state = SAVE_MODE_SAVE_FAILED;
+            AudioManager->PlaySound("snd/cancel.wav");
+        }
+        return;
+    }
+
     _file_list.Update();
     _confirm_save_optionbox.Update();
 
@@ -262,13 +295,10 @@ void SaveMode::Update()
                 // note: using int here, because uint8 will NOT work
                 // do not change unless you understand this and can test it properly!
                 uint32 id = (uint32)_file_list.GetSelection();
-                std::ostringstream f;
-                f << GetUserDataPath() + "saved_game_" << id << ".lua";
-                std::string filename = f.str();
+                std::string filename = GameGlobal::GetSaveSlotFilename(id);
                 // now, attempt to save the game.  If failure, we need to tell the user that!
                 if(GlobalManager->SaveGame(filename, id, _x_position, _y_position)) {
-                    _current_state = SAVE_MODE_SAVE_COMPLETE;
-                    AudioManager->PlaySound("snd/save_successful_nick_bowler_oga.wav");
+                    _current_state = SAVE_MODE_WRITING_SAVE;
                 } else {
                     _current_state = SAVE_MODE_SAVE_FAILED;
                     AudioManager->PlaySound("snd/cancel.wav");
@@ -404,6 +434,7 @@ void SaveMode::DrawPostEffects()
         _drunes_textbox.Draw();
         break;
     case SAVE_MODE_CONFIRMING_SAVE:
+    case SAVE_MODE_WRITING_SAVE:
         _confirm_save_optionbox.Draw();
         break;
     case SAVE_MODE_SAVE_COMPLETE:
@@ -423,11 +454,9 @@ void SaveMode::DrawPostEffects()
 
 bool SaveMode::_LoadGame(uint32 id)
 {
-    std::ostringstream f;
-    f << GetUserDataPath() + "saved_game_" << id << ".lua";
-    std::string filename = f.str();
+    std::string filename = GameGlobal::FindSaveSlotFilename(id);
 
-    if(DoesFileExist(filename)) {
+    if(!filename.empty()) {
         _current_state = SAVE_MODE_FADING_OUT;
         AudioManager->StopAllMusic();
 
@@ -472,166 +501,57 @@ void SaveMode::_ClearSaveData(bool selected_file_exists)
 
 bool SaveMode::_PreviewGame(uint32 id)
 {
-    std::ostringstream f;
-    f << GetUserDataPath() + "saved_game_" << id << ".lua";
-    std::string filename = f.str();
-
-    // Check for the file existence, prevents a useless warning
-    if(!vt_utils::DoesFileExist(filename)) {
-        _ClearSaveData(false);
-        return false;
-    }
-
-    ReadScriptDescriptor file;
-
-    // Clear out the save data namespace to avoid loading false information
-    // when dealing with a save game that has an invalid namespace
-    ScriptManager->DropGlobalTable("save_game1");
-
-    if(!file.OpenFile(filename)) {
-        _ClearSaveData(true);
+    _ReadSlotPreview(id);
+    if(id >= _slot_states.size() || _slot_states[id] != SAVE_SLOT_VALID) {
+        _ClearSaveData(id < _slot_states.size() && _slot_states[id] == SAVE_SLOT_INVALID);
         return false;
     }
 
-    if(!file.DoesTableExist("save_game1")) {
-        file.CloseFile();
-        _ClearSaveData(true);
-        return false;
-    }
-
-    // open the namespace that the save game is encapsulated in.
-    file.OpenTable("save_game1");
-
-    // The map file, tested after the save game is closed.
-    // DEPRECATED: Old way, will be removed in one release.
-    std::string map_script_filename;
-    std::string map_data_filename;
-    if (file.DoesStringExist("map_filename")) {
-        map_script_filename = file.ReadString("map_filename");
-        map_data_filename = file.ReadString("map_filename");
-    }
-    else {
-        map_script_filename = file.ReadString("map_script_filename");
-        map_data_filename = file.ReadString("map_data_filename");
-    }
-
-    // DEPRECATED: Remove in one release
-    // Hack to permit the split of last map data and scripts.
-    if (!map_script_filename.empty() && map_data_filename == map_script_filename) {
-        std::string map_common_name = map_data_filename.substr(0, map_data_filename.length() - 4);
-        map_data_filename = map_common_name + "_map.lua";
-        map_script_filename = map_common_name + "_script.lua";
-    }
-
-    // Check whether the map data file is available
-    if (map_data_filename.empty() || !vt_utils::DoesFileExist(map_data_filename)) {
-        file.CloseTable(); // save_game1
-        file.CloseFile();
-        _ClearSaveData(true);
-        return false;
-    }
-
-    // Used to store temp data to populate text boxes
-    int32 hours = file.ReadInt("play_hours");
-    int32 minutes = file.ReadInt("play_minutes");
-    int32 seconds = file.ReadInt("play_seconds");
-    int32 drunes = file.ReadInt("drunes");
-
-    if(!file.DoesTableExist("characters")) {
-        file.CloseTable(); // save_game1
-        file.CloseFile();
-        _ClearSaveData(true);
-        return false;
-    }
-
-    file.OpenTable("characters");
-    std::vector<uint32> char_ids;
-    file.ReadUIntVector("order", char_ids);
-    GlobalCharacter *character[4];
+    const vt_global::private_global::SavePreviewData &preview = _slot_previews[id];
 
     // Loads only up to the first four slots (Visible battle characters)
-    for(uint32 i = 0; i < 4 && i < char_ids.size(); ++i) {
-        // Create a new GlobalCharacter object using the provided id
-        // This loads all of the character's "static" data, such as their name, etc.
-        character[i] = new GlobalCharacter(char_ids[i], false);
-
-        if(!file.DoesTableExist(char_ids[i]))
-            continue;
-
-        file.OpenTable(char_ids[i]);
-
-        // Read in all of the character's stats data
-        character[i]->SetExperienceLevel(file.ReadUInt("experience_level"));
-        character[i]->SetExperiencePoints(file.ReadUInt("experience_points"));
-
-        character[i]->SetMaxHitPoints(file.ReadUInt("max_hit_points"));
-        character[i]->SetHitPoints(file.ReadUInt("hit_points"));
-        character[i]->SetMaxSkillPoints(file.ReadUInt("max_skill_points"));
-        character[i]->SetSkillPoints(file.ReadUInt("skill_points"));
-
-        file.CloseTable(); // character id
-    }
-    file.CloseTable(); // characters
-
-    // Report any errors detected from the previous read operations
-    if(file.IsErrorDetected()) {
-        PRINT_WARNING << "One or more errors occurred while reading the save game file - they are listed below:"
-            << std::endl << file.GetErrorMessages() << std::endl;
-            file.ClearErrors();
-    }
-
-    file.CloseTable(); // save_game1
-    file.CloseFile();
-
-    for(uint32 i = 0; i < 4 && i < char_ids.size(); ++i) {
-        _character_window[i].SetCharacter(character[i]);
-    }
+    for(uint32 i = 0; i < 4; ++i)
+        _character_window[i].SetCharacter(i < preview.characters.size() ? &preview.characters[i] : NULL);
 
     std::ostringstream time_text;
-    time_text << (hours < 10 ? "0" : "") << static_cast<uint32>(hours) << ":";
-    time_text << (minutes < 10 ? "0" : "") << static_cast<uint32>(minutes) << ":";
-    time_text << (seconds < 10 ? "0" : "") << static_cast<uint32>(seconds);
+    time_text << (preview.play_hours < 10 ? "0" : "") << preview.play_hours << ":";
+    time_text << (preview.play_minutes < 10 ? "0" : "") << preview.play_minutes << ":";
+    time_text << (preview.play_seconds < 10 ? "0" : "") << preview.play_seconds;
     _time_textbox.SetDisplayText(MakeUnicodeString(time_text.str()));
 
     std::ostringstream drunes_amount;
-    drunes_amount << drunes;
+    drunes_amount << preview.drunes;
     _drunes_textbox.SetDisplayText(MakeUnicodeString(drunes_amount.str()));
 
-    // Test the map file
-
-    // Tests the map file and gets the untranslated map hud name from it.
-    ReadScriptDescriptor map_file;
-    if(!map_file.OpenFile(map_script_filename)) {
-        _ClearSaveData(true);
-        return false;
-    }
-
-    if (map_file.OpenTablespace().empty()) {
-        _ClearSaveData(true);
-        map_file.CloseFile();
-        return false;
-    }
-
-    // Read the in-game location of the save
-    std::string map_hud_name = map_file.ReadString("map_name");
-    _map_name_textbox.SetDisplayText(UTranslate(map_hud_name));
+    // The in-game location of the save
+    _map_name_textbox.SetDisplayText(preview.map_hud_name);
 
     // Loads the potential location image
-    std::string map_image_filename = map_file.ReadString("map_image_filename");
-    if (map_image_filename.empty()) {
+    if (preview.map_image_filename.empty()) {
         _location_image.Clear();
     }
     else {
-        if (_location_image.Load(map_image_filename))
+        if (_location_image.Load(preview.map_image_filename))
             _location_image.SetWidthKeepRatio(340.0f);
     }
 
-    map_file.CloseTable(); // Tablespace
-    map_file.CloseFile();
-
     return true;
 } // bool SaveMode::_PreviewGame(string& filename)
 
+void SaveMode::_ReadSlotPreview(uint32 id)
+{
+    if(id >= _slot_states.size() || _slot_states[id] != SAVE_SLOT_UNREAD)
+        return;
+
+    // Check for the file existence, prevents a useless warning
+    if(GameGlobal::FindSaveSlotFilename(id).empty())
+        _slot_states[id] = SAVE_SLOT_EMPTY;
+    else if(GlobalManager->ReadSaveSlotPreview(id, _slot_previews[id]))
+        _slot_states[id] = SAVE_SLOT_VALID;
+    else
+        _slot_states[id] = SAVE_SLOT_INVALID;
+}
+
 bool SaveMode::_CheckSavesValidity() {
     // check all available slots
     bool available_saves = false;
@@ -655,40 +575,32 @@ bool SaveMode::_CheckSavesValidity() {
 // SmallCharacterWindow Class
 ////////////////////////////////////////////////////////////////////////////////
 
-SmallCharacterWindow::~SmallCharacterWindow()
-{
-    delete _character;
-}
-
-void SmallCharacterWindow::SetCharacter(GlobalCharacter *character)
+void SmallCharacterWindow::SetCharacter(const vt_global::private_global::SavePreviewCharacterData *character)
 {
-    delete _character;
-    _character = character;
+    _portrait = StillImage();
 
-    if(!_character || _character->GetID() == vt_global::GLOBAL_CHARACTER_INVALID) {
+    if(!character || character->id == vt_global::GLOBAL_CHARACTER_INVALID) {
         _character_name.Clear();
         _character_data.Clear();
-        _portrait = StillImage();
         return;
     }
 
-    _portrait = character->GetPortrait();
     // Only size up valid portraits
-    if(!_portrait.GetFilename().empty())
+    if(!character->portrait_filename.empty() && _portrait.Load(character->portrait_filename))
         _portrait.SetDimensions(100.0f, 100.0f);
 
     // the characters' name is already translated.
-    _character_name.SetText(_character->GetName(), TextStyle("title22"));
+    _character_name.SetText(character->name, TextStyle("title22"));
 
     // And the rest of the data
-    ustring char_data = UTranslate("Lv: ") + MakeUnicodeString(NumberToString(_character->GetExperienceLevel()) + "\n");
-    char_data += UTranslate("HP: ") + MakeUnicodeString(NumberToString(_character->GetHitPoints()) +
-                               " / " + NumberToString(_character->GetMaxHitPoints()) + "\n");
-    char_data += UTranslate("SP: ") + MakeUnicodeString(NumberToString(_character->GetSkillPoints()) +
-                               " / " + NumberToString(_character->GetMaxSkillPoints()));
+    ustring char_data = UTranslate("Lv: ") + MakeUnicodeString(NumberToString(character->experience_level) + "\n");
+    char_data += UTranslate("HP: ") + MakeUnicodeString(NumberToString(character->hit_points) +
+                               " / " + NumberToString(character->max_hit_points) + "\n");
+    char_data += UTranslate("SP: ") + MakeUnicodeString(NumberToString(character->skill_points) +
+                               " / " + NumberToString(character->max_skill_points));
 
     _character_data.SetText(char_data, TextStyle("text20"));
-} // void SmallCharacterWindow::SetCharacter(GlobalCharacter *character)
+} // void SmallCharacterWindow::SetCharacter(const SavePreviewCharacterData *character)
 
 
 
@@ -26,9 +26,7 @@
 #include "common/gui/textbox.h"
 #include "common/gui/option.h"
 
-namespace vt_global {
-class GlobalCharacter;
-}
+#include "common/global/global_save.h"
 
 //! \brief All calls to save mode are wrapped in this namespace.
 namespace vt_save
@@ -47,16 +45,10 @@ extern bool SAVE_DEBUG;
 class SmallCharacterWindow : public vt_gui::MenuWindow
 {
 public:
-    SmallCharacterWindow():
-        _character(NULL)
-    {}
-
-    ~SmallCharacterWindow();
-
     /** \brief Set the character for this window
-    *** \param character the character to associate with this window
+    *** \param character the preview of the character to associate with this window, or NULL
     **/
-    void SetCharacter(vt_global::GlobalCharacter *character);
+    void SetCharacter(const vt_global::private_global::SavePreviewCharacterData *character);
 
     /** \brief render this window to the screen
     *** \return success/failure
@@ -64,9 +56,6 @@ public:
     void Draw();
 
 private:
-    //! The name of the character that this window corresponds) to
-    vt_global::GlobalCharacter *_character;
-
     //! The image of the character
     vt_video::StillImage _portrait;
 
@@ -115,6 +104,9 @@ private:
     //! \param selected_file_exists Tells whether the selected file exists.
     void _ClearSaveData(bool selected_file_exists);
 
+    //! \brief Reads the preview of a save slot, unless already done.
+    void _ReadSlotPreview(uint32 id);
+
     //! \brief Check the save validity of the save slots and disable those invalid.
     //! \returns whether at least one save is valid.
     bool _CheckSavesValidity();
@@ -132,6 +124,14 @@ private:
     //! \brief Windows to display character previews
     vt_save::SmallCharacterWindow _character_window[4];
 
+    /** \brief The previews of the save slots, read once when first shown
+    *** so that browsing the slots doesn't read any file.
+    **/
+    std::vector<vt_global::private_global::SavePreviewData> _slot_previews;
+
+    //! \brief The state of each slot preview, see the SAVE_SLOT_* constants.
+    std::vector<uint8> _slot_states;
+
     //! \brief Current state of SaveMode
     uint8 _current_state;
 
@@ -37,6 +37,14 @@ bool DoesFileExist(const std::string &file_name)
 #endif
 }
 
+time_t GetFileModificationTime(const std::string &file_name)
+{
+    struct stat buf;
+    if(stat(file_name.c_str(), &buf) != 0)
+        return 0;
+    return buf.st_mtime;
+}
+
 bool MoveFile(const std::string &source_name, const std::string &destination_name)
 {
     if(DoesFileExist(destination_name))
@@ -0,0 +1,277 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ***************************************************************************
+*** \file    utils_grid.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the 2D grid containers.
+***
+*** Both containers store their cells in a single contiguous row-major array,
+*** so that walking a row never leaves the cache line and a cell lookup costs
+*** a single multiplication instead of two pointer dereferences.
+*** ***************************************************************************/
+
+#ifndef __UTILS_GRID_HEADER__
+#define __UTILS_GRID_HEADER__
+
+#include <algorithm>
+#include <vector>
+
+namespace vt_utils
+{
+
+/** ***************************************************************************
+*** \brief A 2D grid of values stored row after row in a single array
+***
+*** A cell is accessed using grid[y][x]: operator[] returns a pointer to the
+*** first cell of the row, which can be used as a span of GetWidth() elements.
+*** \note For performance reasons, no bounds checking is done by the accessors.
+*** ***************************************************************************/
+template <typename T>
+class FlatGrid
+{
+public:
+    FlatGrid() :
+        _width(0),
+        _height(0)
+    {}
+
+    FlatGrid(uint32 width, uint32 height, const T &value = T()) :
+        _width(width),
+        _height(height),
+        _cells(width * height, value)
+    {}
+
+    //! \brief Returns the first cell of the given row.
+    T *operator[](uint32 y) {
+        return &_cells[y * _width];
+    }
+
+    const T *operator[](uint32 y) const {
+        return &_cells[y * _width];
+    }
+
+    uint32 GetWidth() const {
+        return _width;
+    }
+
+    uint32 GetHeight() const {
+        return _height;
+    }
+
+    bool IsEmpty() const {
+        return _cells.empty();
+    }
+
+    //! \brief Sets every cell to the given value.
+    void Fill(const T &value) {
+        _cells.assign(_cells.size(), value);
+    }
+
+    void Clear() {
+        _width = 0;
+        _height = 0;
+        _cells.clear();
+    }
+
+    /** \brief Changes the grid size, keeping the cells which are still within it.
+    *** \param value The value given to the new cells.
+    **/
+    void Resize(uint32 width, uint32 height, const T &value = T()) {
+        if(width == _width) {
+            _cells.resize(width * height, value);
+            _height = height;
+            return;
+        }
+
+        std::vector<T> cells(width * height, value);
+        uint32 copy_width = std::min(width, _width);
+        uint32 copy_height = std::min(height, _height);
+        for(uint32 y = 0; y < copy_height; ++y)
+            std::copy(&_cells[y * _width], &_cells[y * _width] + copy_width, cells.begin() + y * width);
+
+        _cells.swap(cells);
+        _width = width;
+        _height = height;
+    }
+
+    //! \brief Inserts a row before the given one, filled with the given value.
+    void InsertRow(uint32 y, const T &value) {
+        _cells.insert(_cells.begin() + y * _width, _width, value);
+        ++_height;
+    }
+
+    void EraseRow(uint32 y) {
+        _cells.erase(_cells.begin() + y * _width, _cells.begin() + (y + 1) * _width);
+        --_height;
+    }
+
+    //! \brief Inserts a column before the given one, filled with the given value.
+    void InsertColumn(uint32 x, const T &value) {
+        std::vector<T> cells;
+        cells.reserve((_width + 1) * _height);
+        for(uint32 y = 0; y < _height; ++y) {
+            typename std::vector<T>::const_iterator row = _cells.begin() + y * _width;
+            cells.insert(cells.end(), row, row + x);
+            cells.push_back(value);
+            cells.insert(cells.end(), row + x, row + _width);
+        }
+        _cells.swap(cells);
+        ++_width;
+    }
+
+    void EraseColumn(uint32 x) {
+        std::vector<T> cells;
+        cells.reserve((_width - 1) * _height);
+        for(uint32 y = 0; y < _height; ++y) {
+            typename std::vector<T>::const_iterator row = _cells.begin() + y * _width;
+            cells.insert(cells.end(), row, row + x);
+            cells.insert(cells.end(), row + x + 1, row + _width);
+        }
+        _cells.swap(cells);
+        --_width;
+    }
+
+private:
+    uint32 _width;
+
+    uint32 _height;
+
+    //! \brief The grid cells, stored row after row.
+    std::vector<T> _cells;
+}; // class FlatGrid
+
+/** ***************************************************************************
+*** \brief A 2D grid of booleans packed as one bit per cell
+***
+*** Each row starts on its own 32-bit word, so that a row can be read as a span
+*** using grid[y][x] and a range of cells within a row can be tested a word
+*** at a time.
+*** \note For performance reasons, no bounds checking is done by the accessors.
+*** ***************************************************************************/
+class BitGrid
+{
+public:
+    //! \brief A read-only view on a grid row.
+    class ConstRow
+    {
+    public:
+        explicit ConstRow(const uint32 *words) :
+            _words(words)
+        {}
+
+        bool operator[](uint32 x) const {
+            return (_words[x >> 5] >> (x & 31)) & 1;
+        }
+
+    private:
+        const uint32 *_words;
+    };
+
+    BitGrid() :
+        _width(0),
+        _height(0),
+        _words_per_row(0)
+    {}
+
+    ConstRow operator[](uint32 y) const {
+        return ConstRow(&_words[y * _words_per_row]);
+    }
+
+    uint32 GetWidth() const {
+        return _width;
+    }
+
+    uint32 GetHeight() const {
+        return _height;
+    }
+
+    bool IsEmpty() const {
+        return _words.empty();
+    }
+
+    bool Get(uint32 x, uint32 y) const {
+        return (_words[y * _words_per_row + (x >> 5)] >> (x & 31)) & 1;
+    }
+
+    void Set(uint32 x, uint32 y, bool value) {
+        uint32 &word = _words[y * _words_per_row + (x >> 5)];
+        if(value)
+            word |= (1u << (x & 31));
+        else
+            word &= ~(1u << (x & 31));
+    }
+
+    //! \brief Returns whether any cell of the given row between x_first and x_last (included) is set.
+    bool IsAnySet(uint32 y, uint32 x_first, uint32 x_last) const {
+        const uint32 *row = &_words[y * _words_per_row];
+        uint32 first_word = x_first >> 5;
+        uint32 last_word = x_last >> 5;
+        uint32 first_mask = ~0u << (x_first & 31);
+        uint32 last_mask = ~0u >> (31 - (x_last & 31));
+
+        if(first_word == last_word)
+            return (row[first_word] & first_mask & last_mask) != 0;
+
+        if(row[first_word] & first_mask)
+            return true;
+        for(uint32 i = first_word + 1; i < last_word; ++i) {
+            if(row[i])
+                return true;
+        }
+        return (row[last_word] & last_mask) != 0;
+    }
+
+    //! \brief Returns the number of 32-bit words used by each row.
+    uint32 GetWordsPerRow() const {
+        return _words_per_row;
+    }
+
+    //! \brief Returns the grid bits, stored row after row, GetWordsPerRow() words per row.
+    const std::vector<uint32> &GetWords() const {
+        return _words;
+    }
+
+    /** \brief Copies the grid bits from raw words, stored as returned by GetWords().
+    *** \note The grid must already have the right size.
+    **/
+    void SetWords(const uint32 *words) {
+        std::copy(words, words + _words.size(), _words.begin());
+    }
+
+    //! \brief Resizes the grid, and unsets every cell.
+    void Resize(uint32 width, uint32 height) {
+        _width = width;
+        _height = height;
+        _words_per_row = (width + 31) >> 5;
+        _words.assign(_words_per_row * height, 0);
+    }
+
+    void Clear() {
+        _width = 0;
+        _height = 0;
+        _words_per_row = 0;
+        _words.clear();
+    }
+
+private:
+    uint32 _width;
+
+    uint32 _height;
+
+    //! \brief The number of 32-bit words used by each row.
+    uint32 _words_per_row;
+
+    //! \brief The grid bits, stored row after row.
+    std::vector<uint32> _words;
+}; // class BitGrid
+
+} // namespace vt_utils
+
+#endif // __UTILS_GRID_HEADER__
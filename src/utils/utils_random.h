@@ -70,6 +70,52 @@ int32 GaussianRandomValue(int32 mean, float std_dev = 10.0f, bool positive_value
 bool Probability(uint32 chance);
 //@}
 
+/** ****************************************************************************
+*** \brief A random number generator owning its state
+***
+*** The functions above share the C library generator, which isn't meant to be
+*** used by several threads at once. Each instance of this class draws its own
+*** sequence of numbers (xorshift), so that objects updated by different threads
+*** don't share any state, and draw the same numbers for a given seed whatever
+*** the threads scheduling is.
+*** ***************************************************************************/
+class RandomGenerator
+{
+public:
+    RandomGenerator()
+    {
+        Seed(1);
+    }
+
+    //! \brief Restarts the sequence of numbers from the given seed.
+    void Seed(uint32 seed) {
+        // The xorshift state must never be null
+        _state = (seed != 0) ? seed : 0x9E3779B9;
+    }
+
+    //! \brief Returns a uniformly distributed random 32 bits integer.
+    uint32 Next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    //! \brief Returns a uniformly distributed random floating point number between [0.0f, 1.0f].
+    float Float() {
+        // Keep the 24 bits a float mantissa holds
+        return static_cast<float>(Next() >> 8) / 16777215.0f;
+    }
+
+    //! \brief Returns a random float value between a and b, like RandomFloat(a, b) does.
+    float Float(float a, float b) {
+        return (a < b) ? a + (b - a) * Float() : b + (a - b) * Float();
+    }
+
+private:
+    uint32 _state;
+}; // class RandomGenerator
+
 } // namespace vt_utils
 
 #endif // __UTILS_RANDOM_HEADER__
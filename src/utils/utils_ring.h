@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////////
+//            Copyright (C) 2012-2014 by Bertram (Valyria Tear)
+//                         All Rights Reserved
+//
+// This code is licensed under the GNU GPL version 2. It is free software
+// and you may modify it and/or redistribute it under the terms of this license.
+// See http://www.gnu.org/copyleft/gpl.html for details.
+///////////////////////////////////////////////////////////////////////////////
+
+/** ***************************************************************************
+*** \file    utils_ring.h
+*** \author  Yohann Ferreira, yohann ferreira orange fr
+*** \brief   Header file for the lock-free queue used between two threads.
+***
+*** The queue is meant for a single thread pushing values and a single other
+*** thread popping them. Each index is only ever written by one of the two
+*** threads, so no lock is needed: a memory barrier is enough to make sure a
+*** value is written before the index telling it is available.
+*** ***************************************************************************/
+
+#ifndef __UTILS_RING_HEADER__
+#define __UTILS_RING_HEADER__
+
+namespace vt_utils
+{
+
+//! \brief Makes sure the memory accesses written before it are done before the ones written after it.
+inline void FullMemoryBarrier()
+{
+#if defined _MSC_VER
+    MemoryBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+/** ***************************************************************************
+*** \brief A fixed size queue with one producer thread and one consumer thread
+***
+*** The queue can hold up to N - 1 values. Push() fails instead of blocking
+*** when the queue is full, so that the producer can decide what to do.
+*** \note Only one thread may call Push(), and only one other thread may call Pop().
+*** ***************************************************************************/
+template <typename T, uint32 N>
+class RingQueue
+{
+public:
+    RingQueue() :
+        _read_index(0),
+        _write_index(0)
+    {}
+
+    /** \brief Adds a value at the end of the queue. Producer thread only.
+    *** \return false if the queue is full.
+    **/
+    bool Push(const T &value) {
+        uint32 write_index = _write_index;
+        uint32 next_index = (write_index + 1) % N;
+        if(next_index == _read_index)
+            return false;
+
+        _values[write_index] = value;
+        // The value must be written before the consumer can see it.
+        FullMemoryBarrier();
+        _write_index = next_index;
+        return true;
+    }
+
+    /** \brief Removes the value at the front of the queue. Consumer thread only.
+    *** \return false if the queue is empty.
+    **/
+    bool Pop(T &value) {
+        uint32 read_index = _read_index;
+        if(read_index == _write_index)
+            return false;
+
+        FullMemoryBarrier();
+        value = _values[read_index];
+        // The value must be read before the producer can overwrite it.
+        FullMemoryBarrier();
+        _read_index = (read_index + 1) % N;
+        return true;
+    }
+
+private:
+    //! \brief The queue values.
+    T _values[N];
+
+    //! \brief The index of the next value to pop, only written by the consumer thread.
+    volatile uint32 _read_index;
+
+    //! \brief The index of the next value to push, only written by the producer thread.
+    volatile uint32 _write_index;
+}; // class RingQueue
+
+} // namespace vt_utils
+
+#endif // __UTILS_RING_HEADER__